@@ -0,0 +1,208 @@
+## @file
+#  Measure the DNS queries saved by the DNS cache of DnsDxe and the lookup
+#  time saved by querying the DNS servers of HttpDxe in parallel, against
+#  local DNS server stand-ins.
+#
+#  Two servers answer the A and AAAA queries of any name with a configurable
+#  TTL, the first one after a configurable delay, or not at all with a delay
+#  of -1, like a dead primary server. A client resolves a list of host names
+#  many times, like the HTTP children of a HTTP boot or a Redfish session:
+#  once with neither a cache nor parallel queries, once with a cache that
+#  honors the TTL of the answers, and once also querying the next server
+#  HTTP_DNS_ATTEMPT_DELAY after the previous one, taking the first answer.
+#  The queries sent, the cache hits and misses, and the lookup time are
+#  reported.
+#
+#  With --serve, only the servers are started, so that the firmware can be
+#  pointed at them: every query is logged, so a lookup answered from the
+#  cache of DnsDxe sends none.
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+
+TYPE_A = 1
+TYPE_AAAA = 28
+CLASS_IN = 1
+
+## Parse the question of a DNS message, and return the ID, name and type
+def ParseQuery(Packet):
+    Id, Flags, QdCount = struct.unpack('!HHH', Packet[:6])
+    Offset = 12
+    Labels = []
+    while Packet[Offset] != 0:
+        Length = Packet[Offset]
+        Labels.append(Packet[Offset + 1:Offset + 1 + Length].decode())
+        Offset += 1 + Length
+    QType, QClass = struct.unpack('!HH', Packet[Offset + 1:Offset + 5])
+    return Id, '.'.join(Labels), QType, Packet[12:Offset + 5]
+
+def BuildQuery(Id, Name, QType):
+    Question = b''.join(bytes([len(Label)]) + Label.encode() for Label in Name.split('.')) + b'\0'
+    return struct.pack('!HHHHHH', Id, 0x0100, 1, 0, 0, 0) + Question + struct.pack('!HH', QType, CLASS_IN)
+
+## Return the TTL of the answer of a response, None if there is none
+def ParseResponse(Packet):
+    AnCount = struct.unpack('!H', Packet[6:8])[0]
+    if AnCount == 0:
+        return None
+    Offset = 12
+    while Packet[Offset] != 0:
+        Offset += 1 + Packet[Offset]
+    Offset += 5
+    # the answer name is a pointer to the question
+    return struct.unpack('!I', Packet[Offset + 6:Offset + 10])[0]
+
+class DnsServer(threading.Thread):
+    def __init__(self, Args, Index, Delay):
+        threading.Thread.__init__(self, daemon=True)
+        self.Args = Args
+        self.Index = Index
+        self.Delay = Delay
+        self.Queries = 0
+        self.Sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.Sock.bind((Args.address, Args.port + Index))
+
+    def run(self):
+        while True:
+            Packet, Client = self.Sock.recvfrom(512)
+            try:
+                Id, Name, QType, Question = ParseQuery(Packet)
+            except (IndexError, struct.error):
+                continue
+            self.Queries += 1
+            if self.Args.serve:
+                sys.stderr.write('[%s] server %d: %s %s from %s\n' %
+                                 (time.strftime('%H:%M:%S'), self.Index, 'AAAA' if QType == TYPE_AAAA else 'A',
+                                  Name, Client[0]))
+            if self.Delay < 0:
+                continue
+            threading.Timer(self.Delay / 1000.0, self.Answer, (Client, Id, Name, QType, Question)).start()
+
+    ## Answer a made-up address of the name
+    def Answer(self, Client, Id, Name, QType, Question):
+        Host = sum(Name.encode()) & 0xff
+        if QType == TYPE_AAAA:
+            Data = bytes([0xfd] + [0] * 14 + [Host])
+        elif QType == TYPE_A:
+            Data = bytes([10, 0, 0, Host])
+        else:
+            self.Sock.sendto(struct.pack('!HHHHHH', Id, 0x8184, 1, 0, 0, 0) + Question, Client)
+            return
+        Answer = struct.pack('!HHHIH', 0xc00c, QType, CLASS_IN, self.Args.ttl, len(Data)) + Data
+        self.Sock.sendto(struct.pack('!HHHHHH', Id, 0x8180, 1, 1, 0, 0) + Question + Answer, Client)
+
+class DnsClient:
+    def __init__(self, Args):
+        self.Args = Args
+        self.Cache = {}
+        self.Hits = 0
+        self.Misses = 0
+        self.Sent = 0
+        self.NextId = 1
+
+    ## Query the servers, each one Delay seconds after the previous one, and
+    #  return the TTL of the first answer
+    def Query(self, Name, QType, Servers, Delay):
+        Sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        try:
+            Ids = {}
+            Started = 0
+            Deadline = time.perf_counter() + self.Args.timeout
+            NextStart = 0
+            while time.perf_counter() < Deadline:
+                if Started < len(Servers) and time.perf_counter() >= NextStart:
+                    Ids[self.NextId] = Started
+                    Sock.sendto(BuildQuery(self.NextId, Name, QType), Servers[Started])
+                    self.NextId = (self.NextId + 1) & 0xffff
+                    self.Sent += 1
+                    Started += 1
+                    NextStart = time.perf_counter() + Delay if Delay is not None else float('inf')
+                Sock.settimeout(max(min(NextStart, Deadline) - time.perf_counter(), 0.001))
+                try:
+                    Packet, Address = Sock.recvfrom(512)
+                except socket.timeout:
+                    continue
+                if struct.unpack('!H', Packet[:2])[0] in Ids:
+                    return ParseResponse(Packet)
+            return None
+        finally:
+            Sock.close()
+
+    ## Resolve a name like HttpDns4/HttpDns6 over DnsDxe
+    def Resolve(self, Name, QType, Servers, UseCache, Delay):
+        Key = (Name.lower(), QType)
+        Now = time.monotonic()
+        if UseCache:
+            Expiry = self.Cache.get(Key)
+            if Expiry is not None and Expiry > Now:
+                self.Hits += 1
+                return True
+            self.Misses += 1
+        Ttl = self.Query(Name, QType, Servers, Delay)
+        if Ttl is None:
+            return False
+        if UseCache and Ttl != 0:
+            self.Cache[Key] = Now + Ttl
+        return True
+
+    def Run(self, Label, Servers, UseCache, Delay):
+        self.Cache = {}
+        self.Hits = self.Misses = self.Sent = 0
+        Failed = 0
+        Start = time.perf_counter()
+        for Round in range(self.Args.rounds):
+            for Index in range(self.Args.hosts):
+                Name = 'host%d.boot.example' % Index
+                # HTTP children over IPv4 and IPv6 resolve the same hosts
+                for QType in (TYPE_A, TYPE_AAAA):
+                    if not self.Resolve(Name, QType, Servers, UseCache, Delay):
+                        Failed += 1
+        Elapsed = time.perf_counter() - Start
+        print('%-24s %9.1f ms  %5d queries  %5d hits  %5d misses  %3d failed' %
+              (Label, Elapsed * 1000, self.Sent, self.Hits, self.Misses, Failed))
+
+def Main():
+    Parser = argparse.ArgumentParser(description='DNS cache and parallel query benchmark against local DNS server stand-ins')
+    Parser.add_argument('-a', '--address', default='127.0.0.1', help='address of the servers')
+    Parser.add_argument('-p', '--port', type=int, default=5353, help='port of the first server, the second one uses the next')
+    Parser.add_argument('-t', '--ttl', type=int, default=300, help='TTL of the answers in seconds')
+    Parser.add_argument('-d', '--delay', type=int, default=1000, help='answer delay of the first server in ms, -1 for none')
+    Parser.add_argument('-n', '--hosts', type=int, default=2, help='number of host names')
+    Parser.add_argument('-r', '--rounds', type=int, default=5, help='lookups of every host name')
+    Parser.add_argument('--attempt-delay', type=int, default=250, help='delay before querying the next server in ms')
+    Parser.add_argument('--timeout', type=float, default=2.0, help='timeout of a lookup in seconds')
+    Parser.add_argument('--serve', action='store_true', help='only run the servers, for a firmware client')
+    Args = Parser.parse_args()
+
+    Servers = [DnsServer(Args, 0, Args.delay), DnsServer(Args, 1, 0)]
+    for Server in Servers:
+        Server.start()
+    if Args.serve:
+        sys.stderr.write('Serving on %s:%d (delay %d ms) and %s:%d, TTL %d s\n' %
+                         (Args.address, Args.port, Args.delay, Args.address, Args.port + 1, Args.ttl))
+        try:
+            while True:
+                time.sleep(1)
+        except KeyboardInterrupt:
+            pass
+        return 0
+
+    Addresses = [(Args.address, Args.port), (Args.address, Args.port + 1)]
+    Client = DnsClient(Args)
+    print('%d host names, %d rounds, A and AAAA, TTL %d s, first server delay %d ms' %
+          (Args.hosts, Args.rounds, Args.ttl, Args.delay))
+    # DnsDxe only queries the first server of its list
+    Client.Run('no cache, first server', Addresses[:1], False, None)
+    Client.Run('cache, first server', Addresses[:1], True, None)
+    Client.Run('cache, parallel servers', Addresses, True, Args.attempt_delay / 1000.0)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(Main())
@@ -0,0 +1,176 @@
+## @file
+#  A small HTTP server to try HTTP boot downloads against, without setting up
+#  a real web server.
+#
+#  It serves the files of a directory with HTTP/1.1 persistent connections and
+#  single range requests, and can emulate a high-latency link and a server
+#  without range support. The bytes sent on every connection are logged, so the
+#  parallel range download of HttpBootDxe (PcdHttpBootRangeConnections) can be
+#  checked as well as the fallback to a single connection.
+#
+#  The number of requests served on every connection shows whether the keep-alive
+#  connections of HttpDxe (PcdHttpKeepAliveConnections) are reused. The idle
+#  timeout and a server closing every connection can be emulated too.
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import argparse
+import os
+import re
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+BLOCK_SIZE = 64 * 1024
+
+class HttpBootHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    server_version = 'HttpBootServer/1.0'
+
+    def setup(self):
+        # idle connections are closed after the keep-alive timeout
+        self.timeout = self.server.Args.keep_alive or None
+        BaseHTTPRequestHandler.setup(self)
+        self.BytesSent = 0
+        self.Ranges = 0
+        self.Requests = 0
+
+    def finish(self):
+        BaseHTTPRequestHandler.finish(self)
+        self.server.Log('%s:%d closed, %d request(s), %d bytes in %d range(s)' %
+                        (self.client_address[0], self.client_address[1], self.Requests, self.BytesSent, self.Ranges))
+        self.server.Count(self.Requests)
+
+    def log_message(self, Format, *Args):
+        if self.server.Args.verbose:
+            self.server.Log('%s:%d %s' % (self.client_address[0], self.client_address[1], Format % Args))
+
+    def _GetPath(self):
+        Path = os.path.normpath(self.path.split('?', 1)[0].lstrip('/'))
+        if Path.startswith('..') or os.path.isabs(Path):
+            return None
+        Path = os.path.join(self.server.Args.root, Path)
+        return Path if os.path.isfile(Path) else None
+
+    def _GetRange(self, Size):
+        Value = self.headers.get('Range')
+        if Value is None or self.server.Args.no_range:
+            return None
+        Match = re.match(r'^bytes=(\d*)-(\d*)$', Value.strip())
+        if Match is None or (Match.group(1) == '' and Match.group(2) == ''):
+            return None
+        if Match.group(1) == '':
+            First = max(Size - int(Match.group(2)), 0)
+            Last = Size - 1
+        else:
+            First = int(Match.group(1))
+            Last = min(int(Match.group(2)), Size - 1) if Match.group(2) else Size - 1
+        if First > Last:
+            return (Size, Size)
+        return (First, Last)
+
+    def end_headers(self):
+        if self.server.Args.close:
+            self.send_header('Connection', 'close')
+        BaseHTTPRequestHandler.end_headers(self)
+
+    def _Send(self, SendBody):
+        self.Requests += 1
+        time.sleep(self.server.Args.delay / 1000.0)
+        Path = self._GetPath()
+        if Path is None:
+            self.send_error(404)
+            return
+        Size = os.path.getsize(Path)
+        Range = self._GetRange(Size)
+        if Range is not None and Range[0] >= Size:
+            self.send_response(416)
+            self.send_header('Content-Range', 'bytes */%d' % Size)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+        if Range is None:
+            First, Last = 0, Size - 1
+            self.send_response(200)
+        else:
+            First, Last = Range
+            self.send_response(206)
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (First, Last, Size))
+            self.Ranges += 1
+        if not self.server.Args.no_range:
+            self.send_header('Accept-Ranges', 'bytes')
+        self.send_header('Content-Type', self.server.Args.content_type)
+        self.send_header('Content-Length', str(Last - First + 1))
+        self.end_headers()
+        if not SendBody:
+            return
+        with open(Path, 'rb') as File:
+            File.seek(First)
+            Remaining = Last - First + 1
+            while Remaining > 0:
+                Data = File.read(min(BLOCK_SIZE, Remaining))
+                if not Data:
+                    break
+                self.wfile.write(Data)
+                self.BytesSent += len(Data)
+                Remaining -= len(Data)
+                if self.server.Args.rate:
+                    time.sleep(len(Data) / (self.server.Args.rate * 1024.0))
+
+    def do_HEAD(self):
+        self._Send(False)
+
+    def do_GET(self):
+        self._Send(True)
+
+class HttpBootServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, Args):
+        ThreadingHTTPServer.__init__(self, (Args.address, Args.port), HttpBootHandler)
+        self.Args = Args
+        self.Lock = threading.Lock()
+        self.Connections = 0
+        self.Requests = 0
+
+    def Log(self, Message):
+        with self.Lock:
+            sys.stderr.write('[%s] %s\n' % (time.strftime('%H:%M:%S'), Message))
+
+    ## Count the requests of a closed connection, and report the reuse so far
+    def Count(self, Requests):
+        if not Requests:
+            return
+        with self.Lock:
+            self.Connections += 1
+            self.Requests += Requests
+            Connections, Requests = self.Connections, self.Requests
+        self.Log('%d request(s) on %d connection(s), %d served on a reused connection' %
+                 (Requests, Connections, Requests - Connections))
+
+def Main():
+    Parser = argparse.ArgumentParser(description='HTTP server stand-in for HTTP boot downloads')
+    Parser.add_argument('root', help='directory of the files to serve')
+    Parser.add_argument('-a', '--address', default='0.0.0.0', help='address to listen on')
+    Parser.add_argument('-p', '--port', type=int, default=8080, help='port to listen on')
+    Parser.add_argument('-d', '--delay', type=int, default=0, help='delay of every response in milliseconds')
+    Parser.add_argument('-r', '--rate', type=int, default=0, help='limit of every connection in KiB/s, 0 for none')
+    Parser.add_argument('-n', '--no-range', action='store_true', help='ignore range requests like an old server')
+    Parser.add_argument('-k', '--keep-alive', type=int, default=15, help='idle timeout of connections in seconds, 0 for none')
+    Parser.add_argument('-c', '--close', action='store_true', help='close the connection after every response')
+    Parser.add_argument('-t', '--content-type', default='application/vnd.efi-iso', help='Content-Type of the files')
+    Parser.add_argument('-v', '--verbose', action='store_true', help='log every request')
+    Args = Parser.parse_args()
+
+    Server = HttpBootServer(Args)
+    Server.Log('Serving %s on %s:%d' % (os.path.abspath(Args.root), Args.address, Args.port))
+    try:
+        Server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(Main())
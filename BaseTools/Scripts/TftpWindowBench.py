@@ -0,0 +1,306 @@
+## @file
+#  Measure the TFTP download throughput of the windowsize option (RFC 7440),
+#  against a local TFTP server stand-in with an emulated lossy link.
+#
+#  The server serves the files of a directory with the blksize, tsize and
+#  windowsize options. It sends a window of blocks after every ACK, restarting
+#  at the block after the ACKed one, and drops and delays the blocks as
+#  configured. The client downloads a test file like the PXE driver: it ACKs
+#  every window, ACKs the gap after a lost block once (or, like the previous
+#  Mtftp4Dxe/Mtftp6Dxe, on every block following it), and adapts the window of
+#  the next download to the timeouts of the last one (PcdPxeTftpWindowSize).
+#
+#  With --serve, only the server is started, so that a PXE boot can download
+#  from it. The blocks sent and retransmitted for every transfer are logged.
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import argparse
+import os
+import random
+import shutil
+import socket
+import struct
+import sys
+import tempfile
+import threading
+import time
+
+OPCODE_RRQ = 1
+OPCODE_DATA = 3
+OPCODE_ACK = 4
+OPCODE_ERROR = 5
+OPCODE_OACK = 6
+
+DEFAULT_BLOCK_SIZE = 512
+MAX_RETRIES = 6
+
+def ParseOptions(Fields):
+    Options = {}
+    for Index in range(0, len(Fields) - 1, 2):
+        Options[Fields[Index].decode().lower()] = Fields[Index + 1].decode()
+    return Options
+
+def PackOptions(Options):
+    return b''.join(b'%s\0%s\0' % (Name.encode(), str(Value).encode()) for Name, Value in Options.items())
+
+class TftpServer(threading.Thread):
+    def __init__(self, Args):
+        threading.Thread.__init__(self, daemon=True)
+        self.Args = Args
+        self.Random = random.Random(Args.seed)
+        self.Lock = threading.Lock()
+        self.Sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.Sock.bind((Args.address, Args.port))
+
+    def Log(self, Message):
+        with self.Lock:
+            sys.stderr.write('[%s] %s\n' % (time.strftime('%H:%M:%S'), Message))
+
+    def Drop(self):
+        with self.Lock:
+            return self.Random.random() * 10000 < self.Args.loss
+
+    def run(self):
+        while True:
+            Packet, Client = self.Sock.recvfrom(65536)
+            if len(Packet) < 4 or struct.unpack('!H', Packet[:2])[0] != OPCODE_RRQ:
+                continue
+            threading.Thread(target=self.Transfer, args=(Packet, Client), daemon=True).start()
+
+    ## Send the blocks of a file from a new port, as the TID of the transfer
+    def Transfer(self, Request, Client):
+        Fields = Request[2:].split(b'\0')
+        Name = Fields[0].decode()
+        Options = ParseOptions(Fields[2:-1])
+        Sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        Sock.bind((self.Args.address, 0))
+        Sock.settimeout(self.Args.timeout)
+        try:
+            Path = os.path.normpath(os.path.join(self.Args.root, Name.lstrip('/')))
+            if not Path.startswith(os.path.abspath(self.Args.root)) or not os.path.isfile(Path):
+                Sock.sendto(struct.pack('!HH', OPCODE_ERROR, 1) + b'File not found\0', Client)
+                return
+            with open(Path, 'rb') as File:
+                Data = File.read()
+
+            Reply = {}
+            BlockSize = DEFAULT_BLOCK_SIZE
+            Window = 1
+            if 'blksize' in Options:
+                BlockSize = max(8, min(int(Options['blksize']), 65464))
+                Reply['blksize'] = BlockSize
+            if 'tsize' in Options:
+                Reply['tsize'] = len(Data)
+            if 'windowsize' in Options:
+                Window = max(1, min(int(Options['windowsize']), self.Args.max_window))
+                Reply['windowsize'] = Window
+            Blocks = len(Data) // BlockSize + 1
+
+            if Reply and not self.Exchange(Sock, Client, struct.pack('!H', OPCODE_OACK) + PackOptions(Reply), 0):
+                return
+
+            Acked = 0
+            Sent = 0
+            Dropped = 0
+            Timeouts = 0
+            Restarts = 0
+            Start = time.time()
+            while Acked < Blocks:
+                if self.Args.delay:
+                    time.sleep(self.Args.delay / 1000.0)
+                for Block in range(Acked + 1, min(Acked + Window, Blocks) + 1):
+                    Sent += 1
+                    if self.Drop():
+                        Dropped += 1
+                        continue
+                    Sock.sendto(struct.pack('!HH', OPCODE_DATA, Block & 0xffff) +
+                                Data[(Block - 1) * BlockSize:Block * BlockSize], Client)
+                NewAcked = self.WaitAck(Sock, Client, Acked, Window)
+                if NewAcked is None:
+                    Timeouts += 1
+                    if Timeouts > MAX_RETRIES * Blocks:
+                        return
+                    continue
+                if NewAcked < min(Acked + Window, Blocks):
+                    Restarts += 1
+                Acked = NewAcked
+            self.Log('%s: %d bytes, blksize %d, windowsize %d, %d blocks sent for %d, %d dropped, '
+                     '%d window restarts, %d timeouts, %.2f s' %
+                     (Name, len(Data), BlockSize, Window, Sent, Blocks, Dropped, Restarts, Timeouts,
+                      time.time() - Start))
+        finally:
+            Sock.close()
+
+    ## Wait for the ACK of a block of the window, and return the ACKed block
+    def WaitAck(self, Sock, Client, Acked, Window):
+        try:
+            while True:
+                Packet, Address = Sock.recvfrom(65536)
+                if Address != Client or len(Packet) < 4:
+                    continue
+                Opcode, Block = struct.unpack('!HH', Packet[:4])
+                if Opcode == OPCODE_ERROR:
+                    return None
+                Delta = (Block - Acked) & 0xffff
+                if Opcode == OPCODE_ACK and Delta <= Window:
+                    return Acked + Delta
+        except socket.timeout:
+            return None
+
+    ## Send the OACK until it is ACKed
+    def Exchange(self, Sock, Client, Packet, Block):
+        for Retry in range(MAX_RETRIES):
+            Sock.sendto(Packet, Client)
+            if self.WaitAck(Sock, Client, Block, 0) == Block:
+                return True
+        return False
+
+class TftpClient:
+    def __init__(self, Args):
+        self.Args = Args
+
+    ## Download a file, and return the time and the counters of the transfer
+    def Download(self, Name, Window, GapAck):
+        Sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        Sock.settimeout(self.Args.timeout)
+        Options = {'blksize': self.Args.block_size, 'tsize': 0}
+        if Window > 1:
+            Options['windowsize'] = Window
+        Request = struct.pack('!H', OPCODE_RRQ) + Name.encode() + b'\0octet\0' + PackOptions(Options)
+        Server = ('127.0.0.1', self.Args.port)
+        LastPacket = Request
+        BlockSize = DEFAULT_BLOCK_SIZE
+        Window = 1
+        Expected = 1
+        SinceAck = 0
+        GapAcked = False
+        Received = 0
+        Timeouts = 0
+        OutOfOrder = 0
+        Retries = 0
+
+        Start = time.perf_counter()
+        Sock.sendto(Request, Server)
+        try:
+            while True:
+                try:
+                    Packet, Address = Sock.recvfrom(65536)
+                except socket.timeout:
+                    Timeouts += 1
+                    Retries += 1
+                    if Retries > MAX_RETRIES:
+                        raise RuntimeError('%s: transfer timed out' % Name)
+                    Sock.sendto(LastPacket, Server)
+                    continue
+                Retries = 0
+                Opcode, Block = struct.unpack('!HH', Packet[:4])
+                if Opcode == OPCODE_ERROR:
+                    raise RuntimeError('%s: %s' % (Name, Packet[4:-1].decode()))
+                if Opcode == OPCODE_OACK:
+                    Server = Address
+                    Reply = ParseOptions(Packet[2:].split(b'\0')[:-1])
+                    BlockSize = int(Reply.get('blksize', DEFAULT_BLOCK_SIZE))
+                    Window = int(Reply.get('windowsize', 1))
+                    LastPacket = struct.pack('!HH', OPCODE_ACK, 0)
+                    Sock.sendto(LastPacket, Server)
+                    continue
+                if Opcode != OPCODE_DATA:
+                    continue
+                Server = Address
+                if Block != Expected & 0xffff:
+                    OutOfOrder += 1
+                    if GapAck and Window > 1 and GapAcked:
+                        continue
+                    GapAcked = True
+                    LastPacket = struct.pack('!HH', OPCODE_ACK, (Expected - 1) & 0xffff)
+                    Sock.sendto(LastPacket, Server)
+                    SinceAck = 0
+                    continue
+                GapAcked = False
+                Received += len(Packet) - 4
+                Expected += 1
+                SinceAck += 1
+                Last = len(Packet) - 4 < BlockSize
+                if Last or SinceAck == Window:
+                    LastPacket = struct.pack('!HH', OPCODE_ACK, Block)
+                    Sock.sendto(LastPacket, Server)
+                    SinceAck = 0
+                if Last:
+                    break
+        finally:
+            Sock.close()
+        return time.perf_counter() - Start, Received, Timeouts, OutOfOrder
+
+    ## Download the file a number of times, adapting the window if Adaptive is True
+    def Run(self, Label, Name, Window, GapAck, Adaptive):
+        Elapsed = 0
+        Bytes = 0
+        Timeouts = 0
+        OutOfOrder = 0
+        Current = Window
+        for Index in range(self.Args.count):
+            Time, Received, Lost, Unexpected = self.Download(Name, Current, GapAck)
+            Elapsed += Time
+            Bytes += Received
+            Timeouts += Lost
+            OutOfOrder += Unexpected
+            if Adaptive:
+                Current = max(Current // 2, 1) if Lost else min(Current * 2, Window)
+        print('%-28s %8.2f MiB/s  %5d timeouts  %6d out-of-order blocks%s' %
+              (Label, Bytes / Elapsed / (1024 * 1024), Timeouts, OutOfOrder,
+               '  final windowsize %d' % Current if Adaptive else ''))
+
+def Main():
+    Parser = argparse.ArgumentParser(description='TFTP windowsize benchmark against a local TFTP server stand-in')
+    Parser.add_argument('-a', '--address', default='127.0.0.1', help='address of the server')
+    Parser.add_argument('-p', '--port', type=int, default=6969, help='port of the server')
+    Parser.add_argument('-s', '--size', type=int, default=8, help='size of the test file in MiB')
+    Parser.add_argument('-c', '--count', type=int, default=4, help='number of downloads of every run')
+    Parser.add_argument('-b', '--block-size', type=int, default=1468, help='blksize requested by the client')
+    Parser.add_argument('-w', '--window', type=int, default=16, help='largest windowsize requested by the client')
+    Parser.add_argument('-l', '--loss', type=int, default=0, help='blocks dropped by the server per 10000')
+    Parser.add_argument('-d', '--delay', type=int, default=0, help='delay of every window in milliseconds')
+    Parser.add_argument('-t', '--timeout', type=float, default=0.2, help='timeout in seconds')
+    Parser.add_argument('-r', '--seed', type=int, default=1, help='seed of the random loss')
+    Parser.add_argument('--max-window', type=int, default=64, help='largest windowsize accepted by the server')
+    Parser.add_argument('--serve', metavar='ROOT', help='only serve the files of ROOT, for a PXE client')
+    Args = Parser.parse_args()
+
+    if Args.serve:
+        Args.root = os.path.abspath(Args.serve)
+        Server = TftpServer(Args)
+        Server.Log('Serving %s on %s:%d, loss %d/10000, delay %d ms' %
+                   (Args.root, Args.address, Args.port, Args.loss, Args.delay))
+        Server.start()
+        try:
+            while Server.is_alive():
+                Server.join(1)
+        except KeyboardInterrupt:
+            pass
+        return 0
+
+    Args.root = tempfile.mkdtemp(prefix='TftpWindowBench')
+    try:
+        with open(os.path.join(Args.root, 'bootfile'), 'wb') as File:
+            File.write(os.urandom(Args.size * 1024 * 1024))
+        Server = TftpServer(Args)
+        # the transfers are only logged with --serve
+        Server.Log = lambda Message: None
+        Server.start()
+
+        Client = TftpClient(Args)
+        print('%d downloads of %d MiB, blksize %d, loss %d/10000, delay %d ms' %
+              (Args.count, Args.size, Args.block_size, Args.loss, Args.delay))
+        Client.Run('windowsize 1', 'bootfile', 1, False, False)
+        Client.Run('windowsize 4, ACK per block', 'bootfile', 4, False, False)
+        Client.Run('windowsize %d, ACK per block' % Args.window, 'bootfile', Args.window, False, False)
+        Client.Run('windowsize %d, ACK per gap' % Args.window, 'bootfile', Args.window, True, False)
+        Client.Run('adaptive %d, ACK per gap' % Args.window, 'bootfile', Args.window, True, True)
+    finally:
+        shutil.rmtree(Args.root, ignore_errors=True)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(Main())
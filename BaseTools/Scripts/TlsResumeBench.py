@@ -0,0 +1,143 @@
+## @file
+#  Measure the TLS handshakes saved by session resumption, against a local
+#  OpenSSL s_server standing in for the HTTPS server of HTTP boot.
+#
+#  A self-signed certificate is generated, "openssl s_server" is started on it,
+#  and a number of TLS 1.2 connections are made, like the HttpDxe children of
+#  a HTTPS boot: once with a full handshake every time, and once resuming the
+#  session of the previous connection, by session ticket or, with --no-ticket,
+#  by session ID. The number of full and abbreviated handshakes and their
+#  latency are reported.
+#
+#  With --serve, only the server is started, so that the session cache of
+#  TlsDxe (PcdTlsSessionCacheLifetime) can be checked from the firmware: the
+#  server logs every connection, and "Reused session-id" tells a resumption.
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import argparse
+import os
+import shutil
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+import time
+
+## Generate a self-signed certificate for the server
+def GenerateCertificate(Directory, HostName):
+    Cert = os.path.join(Directory, 'server.crt')
+    Key = os.path.join(Directory, 'server.key')
+    subprocess.check_call(['openssl', 'req', '-x509', '-newkey', 'rsa:2048', '-nodes', '-days', '1',
+                           '-subj', '/CN=%s' % HostName, '-keyout', Key, '-out', Cert],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return Cert, Key
+
+## Start openssl s_server and wait until it accepts connections
+def StartServer(Args, Cert, Key, Quiet):
+    Command = ['openssl', 's_server', '-accept', str(Args.port), '-cert', Cert, '-key', Key,
+               '-tls1_2', '-www']
+    if Args.no_ticket:
+        Command.append('-no_ticket')
+    Server = subprocess.Popen(Command, stdin=subprocess.DEVNULL,
+                              stdout=subprocess.DEVNULL if Quiet else None,
+                              stderr=subprocess.DEVNULL if Quiet else None)
+    Deadline = time.time() + 10
+    while time.time() < Deadline:
+        try:
+            socket.create_connection(('127.0.0.1', Args.port), timeout=1).close()
+            return Server
+        except OSError:
+            if Server.poll() is not None:
+                break
+            time.sleep(0.1)
+    Server.kill()
+    raise RuntimeError('openssl s_server failed to start on port %d' % Args.port)
+
+## Connect the server once, and return the handshake time and the session
+def Connect(Args, Context, Session):
+    Sock = socket.create_connection(('127.0.0.1', Args.port))
+    Start = time.perf_counter()
+    Tls = Context.wrap_socket(Sock, server_hostname=Args.host, session=Session)
+    Elapsed = time.perf_counter() - Start
+    # a request like HTTP boot, before the session is saved
+    Tls.sendall(b'GET / HTTP/1.0\r\n\r\n')
+    while Tls.recv(4096):
+        pass
+    Reused = Tls.session_reused
+    Session = Tls.session
+    Tls.close()
+    return Elapsed, Reused, Session
+
+## Make the connections, resuming the previous session if Resume is True
+def Run(Args, Context, Resume):
+    Full = []
+    Abbreviated = []
+    Session = None
+    for Index in range(Args.connections):
+        Elapsed, Reused, NewSession = Connect(Args, Context, Session if Resume else None)
+        (Abbreviated if Reused else Full).append(Elapsed)
+        Session = NewSession
+    return Full, Abbreviated
+
+def Report(Name, Full, Abbreviated):
+    Total = sum(Full) + sum(Abbreviated)
+    print('%-10s %4d full %4d abbreviated  total %8.1f ms' % (Name, len(Full), len(Abbreviated), Total * 1000))
+    for Kind, Times in (('full', Full), ('abbreviated', Abbreviated)):
+        if Times:
+            Times = sorted(Times)
+            print('%10s %-12s avg %7.2f ms  min %7.2f ms  median %7.2f ms' %
+                  ('', Kind, sum(Times) * 1000 / len(Times), Times[0] * 1000, Times[len(Times) // 2] * 1000))
+    return Total
+
+def Main():
+    Parser = argparse.ArgumentParser(description='TLS session resumption benchmark against openssl s_server')
+    Parser.add_argument('-p', '--port', type=int, default=4433, help='port of the server')
+    Parser.add_argument('-n', '--connections', type=int, default=50, help='number of connections of each run')
+    Parser.add_argument('--host', default='localhost', help='server name of the certificate')
+    Parser.add_argument('--no-ticket', action='store_true', help='resume by session ID rather than session ticket')
+    Parser.add_argument('--serve', action='store_true', help='only run the server, for a firmware client')
+    Args = Parser.parse_args()
+
+    if shutil.which('openssl') is None:
+        sys.stderr.write('openssl is not found\n')
+        return 1
+
+    Directory = tempfile.mkdtemp(prefix='TlsResumeBench')
+    try:
+        Cert, Key = GenerateCertificate(Directory, Args.host)
+        if Args.serve:
+            sys.stderr.write('Serving %s on port %d, CA certificate %s\n' % (Args.host, Args.port, Cert))
+            Server = StartServer(Args, Cert, Key, False)
+            try:
+                Server.wait()
+            except KeyboardInterrupt:
+                Server.terminate()
+            return 0
+
+        Server = StartServer(Args, Cert, Key, True)
+        try:
+            Context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+            Context.minimum_version = ssl.TLSVersion.TLSv1_2
+            Context.maximum_version = ssl.TLSVersion.TLSv1_2
+            Context.load_verify_locations(Cert)
+            if Args.no_ticket:
+                Context.options |= ssl.OP_NO_TICKET
+
+            print('%d connections to %s:%d, resumption by %s' %
+                  (Args.connections, Args.host, Args.port, 'session ID' if Args.no_ticket else 'session ticket'))
+            Baseline = Report('no cache', *Run(Args, Context, False))
+            Resumed = Report('cache', *Run(Args, Context, True))
+            if Resumed > 0:
+                print('handshake time reduced %.1fx' % (Baseline / Resumed))
+        finally:
+            Server.terminate()
+            Server.wait()
+    finally:
+        shutil.rmtree(Directory, ignore_errors=True)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(Main())
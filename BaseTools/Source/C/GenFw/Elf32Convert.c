@@ -126,6 +126,7 @@ InitializeElf32 (
   // Initialize data pointer and structures.
   //
   mEhdr = (Elf_Ehdr*) FileBuffer;
+  mCoffAlignment = 0x20;
 
   //
   // Check the ELF32 specific header information.
@@ -1094,6 +1095,11 @@ WriteRelocations32 (
     }
   }
 
+  //
+  // Emit the queued fixups sorted by page.
+  //
+  CoffEmitFixups ();
+
   //
   // Pad by adding empty entries.
   //
@@ -1172,6 +1178,7 @@ CleanUp32 (
 {
   if (mCoffSectionsOffset != NULL) {
     free (mCoffSectionsOffset);
+    mCoffSectionsOffset = NULL;
   }
 }
 
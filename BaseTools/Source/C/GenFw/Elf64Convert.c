@@ -68,6 +68,12 @@ CleanUp64 (
   VOID
   );
 
+STATIC
+VOID
+ReleaseCoffGOTEntries (
+  VOID
+  );
+
 //
 // Rename ELF32 structures to common names to help when porting to ELF64.
 //
@@ -173,6 +179,18 @@ InitializeElf64 (
   //
   // Update section header pointers
   //
+  //
+  // Reset per-image state, as several images may be converted by a single
+  // GenFw invocation in batch mode.
+  //
+  mCoffAlignment         = 0x20;
+  mGOTShdr               = NULL;
+  mGOTShindex            = 0;
+  mRiscVPass1Targ        = NULL;
+  mRiscVPass1Sym         = NULL;
+  mRiscVPass1SymSecIndex = 0;
+  ReleaseCoffGOTEntries ();
+
   VerboseMsg ("Update Header Pointers");
   mShdrBase  = (Elf_Shdr *)((UINT8 *)mEhdr + mEhdr->e_shoff);
   mPhdrBase = (Elf_Phdr *)((UINT8 *)mEhdr + mEhdr->e_phoff);
@@ -410,56 +428,24 @@ AccumulateCoffGOTEntries (
 }
 
 //
-// 32-bit Unsigned integer comparator for qsort.
-//
-STATIC
-int
-UINT32Comparator (
-  const void* lhs,
-  const void* rhs
-  )
-{
-  if (*(const UINT32*)lhs < *(const UINT32*)rhs) {
-    return -1;
-  }
-  return *(const UINT32*)lhs > *(const UINT32*)rhs;
-}
-
-//
-// Emit accumulated Coff GOT entry relocations into
-//   Coff image.  This function performs its job
-//   once and then releases the entry list, so
-//   it can safely be called multiple times.
+// Release the GOT entry list.  The fixups for the GOT entries themselves
+//   are queued as they are first encountered and ordered together with
+//   all other fixups by CoffEmitFixups ().
 //
 STATIC
 VOID
-EmitGOTRelocations (
+ReleaseCoffGOTEntries (
   VOID
   )
 {
-  UINT32 i;
-  if (mGOTCoffEntries == NULL) {
-    return;
-  }
-  //
-  // Emit Coff relocations with Rvas ordered.
-  //
-  qsort(
-    mGOTCoffEntries,
-    mGOTNumCoffEntries,
-    sizeof *mGOTCoffEntries,
-    UINT32Comparator);
-  for (i = 0; i < mGOTNumCoffEntries; i++) {
-    VerboseMsg ("EFI_IMAGE_REL_BASED_DIR64 Offset: 0x%08X", mGOTCoffEntries[i]);
-    CoffAddFixup(
-      mGOTCoffEntries[i],
-      EFI_IMAGE_REL_BASED_DIR64);
+  if (mGOTCoffEntries != NULL) {
+    free(mGOTCoffEntries);
   }
-  free(mGOTCoffEntries);
   mGOTCoffEntries = NULL;
   mGOTMaxCoffEntries = 0;
   mGOTNumCoffEntries = 0;
 }
+
 //
 // RISC-V 64 specific Elf WriteSection function.
 //
@@ -617,6 +603,7 @@ ScanSections64 (
   EFI_IMAGE_OPTIONAL_HEADER_UNION *NtHdr;
   UINT32                          CoffEntry;
   UINT32                          SectionCount;
+  UINT32                          RelocCount;
   BOOLEAN                         FoundSection;
 
   CoffEntry = 0;
@@ -810,6 +797,23 @@ ScanSections64 (
 
   mRelocOffset = mCoffOffset;
 
+  //
+  // Size the fixup table once for all relocations that may need one, so
+  // that queuing fixups while relocating sections never reallocates.
+  //
+  RelocCount = 0;
+  for (i = 0; i < mEhdr->e_shnum; i++) {
+    Elf_Shdr *RelShdr = GetShdrByIndex(i);
+    if ((RelShdr->sh_type == SHT_REL || RelShdr->sh_type == SHT_RELA) &&
+        RelShdr->sh_info != 0 && RelShdr->sh_entsize != 0) {
+      Elf_Shdr *SecShdr = GetShdrByIndex(RelShdr->sh_info);
+      if (IsTextShdr(SecShdr) || IsDataShdr(SecShdr)) {
+        RelocCount += (UINT32) (RelShdr->sh_size / RelShdr->sh_entsize);
+      }
+    }
+  }
+  CoffReserveFixups (RelocCount);
+
   //
   // Allocate base Coff file.  Will be expanded later for relocations.
   //
@@ -914,6 +918,232 @@ ScanSections64 (
 
 }
 
+//
+// Queue the COFF fixup (if any) required by a single ELF relocation entry.
+// This is called from WriteSections64 () right after a SHT_RELA relocation
+// has been applied, so those relocation tables are only walked once per
+// conversion, and from WriteRelocations64 () for SHT_REL relocations.
+// WriteSections64 () already reports unsupported relocation types, so they
+// are only reported here when ReportUnsupported is TRUE.
+//
+STATIC
+VOID
+RecordFixup64 (
+  Elf_Rela  *Rel,
+  Elf_Shdr  *SecShdr,
+  UINT32    SecOffset,
+  BOOLEAN   ReportUnsupported
+  )
+{
+  UINT32 RiscVRelType;
+
+  if (mEhdr->e_machine == EM_X86_64) {
+    switch (ELF_R_TYPE(Rel->r_info)) {
+    case R_X86_64_NONE:
+    case R_X86_64_PC32:
+    case R_X86_64_PLT32:
+    case R_X86_64_GOTPCREL:
+    case R_X86_64_GOTPCRELX:
+    case R_X86_64_REX_GOTPCRELX:
+      break;
+    case R_X86_64_64:
+      VerboseMsg ("EFI_IMAGE_REL_BASED_DIR64 Offset: 0x%08X",
+        SecOffset + (Rel->r_offset - SecShdr->sh_addr));
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_DIR64);
+      break;
+    //
+    // R_X86_64_32 and R_X86_64_32S are ELF64 relocations emitted when using
+    //   the SYSV X64 ABI small non-position-independent code model.
+    //   R_X86_64_32 is used for unsigned 32-bit immediates with a 32-bit operand
+    //   size.  The value is either not extended, or zero-extended to 64 bits.
+    //   R_X86_64_32S is used for either signed 32-bit non-rip-relative displacements
+    //   or signed 32-bit immediates with a 64-bit operand size.  The value is
+    //   sign-extended to 64 bits.
+    //   EFI_IMAGE_REL_BASED_HIGHLOW is a PE relocation that uses 32-bit arithmetic
+    //   for rebasing an image.
+    //   EFI PE binaries declare themselves EFI_IMAGE_FILE_LARGE_ADDRESS_AWARE and
+    //   may load above 2GB.  If an EFI PE binary with a converted R_X86_64_32S
+    //   relocation is loaded above 2GB, the value will get sign-extended to the
+    //   negative part of the 64-bit address space.  The negative part of the 64-bit
+    //   address space is unmapped, so accessing such an address page-faults.
+    //   In order to support R_X86_64_32S, it is necessary to unset
+    //   EFI_IMAGE_FILE_LARGE_ADDRESS_AWARE, and the EFI PE loader must implement
+    //   this flag and abstain from loading such a PE binary above 2GB.
+    //   Since this feature is not supported, support for R_X86_64_32S (and hence
+    //   the small non-position-independent code model) is disabled.
+    //
+    // case R_X86_64_32S:
+    case R_X86_64_32:
+      VerboseMsg ("EFI_IMAGE_REL_BASED_HIGHLOW Offset: 0x%08X",
+        SecOffset + (Rel->r_offset - SecShdr->sh_addr));
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_HIGHLOW);
+      break;
+    default:
+      if (ReportUnsupported) {
+        Error (NULL, 0, 3000, "Invalid", "%s unsupported ELF EM_X86_64 relocation 0x%x.", mInImageName, (unsigned) ELF_R_TYPE(Rel->r_info));
+      }
+    }
+  } else if (mEhdr->e_machine == EM_AARCH64) {
+
+    switch (ELF_R_TYPE(Rel->r_info)) {
+    case R_AARCH64_ADR_PREL_LO21:
+    case R_AARCH64_CONDBR19:
+    case R_AARCH64_LD_PREL_LO19:
+    case R_AARCH64_CALL26:
+    case R_AARCH64_JUMP26:
+    case R_AARCH64_PREL64:
+    case R_AARCH64_PREL32:
+    case R_AARCH64_PREL16:
+    case R_AARCH64_ADR_PREL_PG_HI21:
+    case R_AARCH64_ADD_ABS_LO12_NC:
+    case R_AARCH64_LDST8_ABS_LO12_NC:
+    case R_AARCH64_LDST16_ABS_LO12_NC:
+    case R_AARCH64_LDST32_ABS_LO12_NC:
+    case R_AARCH64_LDST64_ABS_LO12_NC:
+    case R_AARCH64_LDST128_ABS_LO12_NC:
+    case R_AARCH64_ADR_GOT_PAGE:
+    case R_AARCH64_LD64_GOT_LO12_NC:
+      //
+      // No fixups are required for relative relocations, provided that
+      // the relative offsets between sections have been preserved in
+      // the ELF to PE/COFF conversion. We have already asserted that
+      // this is the case in WriteSections64 ().
+      //
+      break;
+
+    case R_AARCH64_ABS64:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_DIR64);
+      break;
+
+    case R_AARCH64_ABS32:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_HIGHLOW);
+     break;
+
+    default:
+      if (ReportUnsupported) {
+        Error (NULL, 0, 3000, "Invalid", "RecordFixup64(): %s unsupported ELF EM_AARCH64 relocation 0x%x.", mInImageName, (unsigned) ELF_R_TYPE(Rel->r_info));
+      }
+    }
+  } else if (mEhdr->e_machine == EM_RISCV64) {
+    RiscVRelType = ELF_R_TYPE(Rel->r_info);
+    switch (RiscVRelType) {
+    case R_RISCV_NONE:
+      break;
+
+    case R_RISCV_32:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_HIGHLOW);
+      break;
+
+    case R_RISCV_64:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_DIR64);
+      break;
+
+    case R_RISCV_HI20:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_RISCV_HI20);
+      break;
+
+    case R_RISCV_LO12_I:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_RISCV_LOW12I);
+      break;
+
+    case R_RISCV_LO12_S:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_RISCV_LOW12S);
+      break;
+
+    case R_RISCV_ADD64:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_ABSOLUTE);
+      break;
+
+    case R_RISCV_SUB64:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_ABSOLUTE);
+      break;
+
+    case R_RISCV_ADD32:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_ABSOLUTE);
+      break;
+
+    case R_RISCV_SUB32:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_ABSOLUTE);
+      break;
+
+    case R_RISCV_BRANCH:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_ABSOLUTE);
+      break;
+
+    case R_RISCV_JAL:
+      CoffAddFixup(
+        (UINT32) ((UINT64) SecOffset
+        + (Rel->r_offset - SecShdr->sh_addr)),
+        EFI_IMAGE_REL_BASED_ABSOLUTE);
+      break;
+
+    case R_RISCV_GPREL_I:
+    case R_RISCV_GPREL_S:
+    case R_RISCV_CALL:
+    case R_RISCV_RVC_BRANCH:
+    case R_RISCV_RVC_JUMP:
+    case R_RISCV_RELAX:
+    case R_RISCV_SUB6:
+    case R_RISCV_SET6:
+    case R_RISCV_SET8:
+    case R_RISCV_SET16:
+    case R_RISCV_SET32:
+    case R_RISCV_PCREL_HI20:
+    case R_RISCV_PCREL_LO12_I:
+      break;
+
+    default:
+      if (ReportUnsupported) {
+        Error (NULL, 0, 3000, "Invalid", "RecordFixup64(): %s unsupported ELF EM_RISCV64 relocation 0x%x.", mInImageName, (unsigned) ELF_R_TYPE(Rel->r_info));
+      }
+    }
+  } else if (ReportUnsupported) {
+    Error (NULL, 0, 3000, "Not Supported", "This tool does not support relocations for ELF with e_machine %u (processor type).", (unsigned) mEhdr->e_machine);
+  }
+}
+
 STATIC
 BOOLEAN
 WriteSections64 (
@@ -1170,6 +1400,8 @@ WriteSections64 (
                 *(UINT64 *)Targ);
               *(UINT64 *)Targ = *(UINT64 *)Targ - SymShdr->sh_addr + mCoffSectionsOffset[Sym->st_shndx];
               VerboseMsg ("Relocation:  0x%016LX", *(UINT64*)Targ);
+              VerboseMsg ("EFI_IMAGE_REL_BASED_DIR64 Offset: 0x%08X", (UINT32)GOTEntryRva);
+              CoffAddFixup((UINT32)GOTEntryRva, EFI_IMAGE_REL_BASED_DIR64);
             }
             break;
           default:
@@ -1320,6 +1552,14 @@ WriteSections64 (
         } else {
           Error (NULL, 0, 3000, "Invalid", "Not a supported machine type");
         }
+
+        //
+        // Queue the matching COFF fixup while this entry is at hand, rather
+        // than walking the relocation tables again in WriteRelocations64 ().
+        //
+        if (FilterType != SECTION_HII) {
+          RecordFixup64 (Rel, SecShdr, SecOffset, FALSE);
+        }
       }
     }
   }
@@ -1334,246 +1574,33 @@ WriteRelocations64 (
   )
 {
   UINT32                           Index;
+  UINT64                           RelIdx;
   EFI_IMAGE_OPTIONAL_HEADER_UNION  *NtHdr;
   EFI_IMAGE_DATA_DIRECTORY         *Dir;
-  UINT32 RiscVRelType;
 
+  //
+  // WriteSections64 () only applies SHT_RELA relocations, so the fixups of
+  // SHT_REL sections are queued here.
+  //
   for (Index = 0; Index < mEhdr->e_shnum; Index++) {
     Elf_Shdr *RelShdr = GetShdrByIndex(Index);
-    if ((RelShdr->sh_type == SHT_REL) || (RelShdr->sh_type == SHT_RELA)) {
+    if (RelShdr->sh_type == SHT_REL && RelShdr->sh_entsize != 0) {
       Elf_Shdr *SecShdr = GetShdrByIndex (RelShdr->sh_info);
       if (IsTextShdr(SecShdr) || IsDataShdr(SecShdr)) {
-        UINT64 RelIdx;
-
         for (RelIdx = 0; RelIdx < RelShdr->sh_size; RelIdx += RelShdr->sh_entsize) {
           Elf_Rela *Rel = (Elf_Rela *)((UINT8*)mEhdr + RelShdr->sh_offset + RelIdx);
-
-          if (mEhdr->e_machine == EM_X86_64) {
-            switch (ELF_R_TYPE(Rel->r_info)) {
-            case R_X86_64_NONE:
-            case R_X86_64_PC32:
-            case R_X86_64_PLT32:
-            case R_X86_64_GOTPCREL:
-            case R_X86_64_GOTPCRELX:
-            case R_X86_64_REX_GOTPCRELX:
-              break;
-            case R_X86_64_64:
-              VerboseMsg ("EFI_IMAGE_REL_BASED_DIR64 Offset: 0x%08X",
-                mCoffSectionsOffset[RelShdr->sh_info] + (Rel->r_offset - SecShdr->sh_addr));
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_DIR64);
-              break;
-            //
-            // R_X86_64_32 and R_X86_64_32S are ELF64 relocations emitted when using
-            //   the SYSV X64 ABI small non-position-independent code model.
-            //   R_X86_64_32 is used for unsigned 32-bit immediates with a 32-bit operand
-            //   size.  The value is either not extended, or zero-extended to 64 bits.
-            //   R_X86_64_32S is used for either signed 32-bit non-rip-relative displacements
-            //   or signed 32-bit immediates with a 64-bit operand size.  The value is
-            //   sign-extended to 64 bits.
-            //   EFI_IMAGE_REL_BASED_HIGHLOW is a PE relocation that uses 32-bit arithmetic
-            //   for rebasing an image.
-            //   EFI PE binaries declare themselves EFI_IMAGE_FILE_LARGE_ADDRESS_AWARE and
-            //   may load above 2GB.  If an EFI PE binary with a converted R_X86_64_32S
-            //   relocation is loaded above 2GB, the value will get sign-extended to the
-            //   negative part of the 64-bit address space.  The negative part of the 64-bit
-            //   address space is unmapped, so accessing such an address page-faults.
-            //   In order to support R_X86_64_32S, it is necessary to unset
-            //   EFI_IMAGE_FILE_LARGE_ADDRESS_AWARE, and the EFI PE loader must implement
-            //   this flag and abstain from loading such a PE binary above 2GB.
-            //   Since this feature is not supported, support for R_X86_64_32S (and hence
-            //   the small non-position-independent code model) is disabled.
-            //
-            // case R_X86_64_32S:
-            case R_X86_64_32:
-              VerboseMsg ("EFI_IMAGE_REL_BASED_HIGHLOW Offset: 0x%08X",
-                mCoffSectionsOffset[RelShdr->sh_info] + (Rel->r_offset - SecShdr->sh_addr));
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_HIGHLOW);
-              break;
-            default:
-              Error (NULL, 0, 3000, "Invalid", "%s unsupported ELF EM_X86_64 relocation 0x%x.", mInImageName, (unsigned) ELF_R_TYPE(Rel->r_info));
-            }
-          } else if (mEhdr->e_machine == EM_AARCH64) {
-
-            switch (ELF_R_TYPE(Rel->r_info)) {
-            case R_AARCH64_ADR_PREL_LO21:
-            case R_AARCH64_CONDBR19:
-            case R_AARCH64_LD_PREL_LO19:
-            case R_AARCH64_CALL26:
-            case R_AARCH64_JUMP26:
-            case R_AARCH64_PREL64:
-            case R_AARCH64_PREL32:
-            case R_AARCH64_PREL16:
-            case R_AARCH64_ADR_PREL_PG_HI21:
-            case R_AARCH64_ADD_ABS_LO12_NC:
-            case R_AARCH64_LDST8_ABS_LO12_NC:
-            case R_AARCH64_LDST16_ABS_LO12_NC:
-            case R_AARCH64_LDST32_ABS_LO12_NC:
-            case R_AARCH64_LDST64_ABS_LO12_NC:
-            case R_AARCH64_LDST128_ABS_LO12_NC:
-            case R_AARCH64_ADR_GOT_PAGE:
-            case R_AARCH64_LD64_GOT_LO12_NC:
-              //
-              // No fixups are required for relative relocations, provided that
-              // the relative offsets between sections have been preserved in
-              // the ELF to PE/COFF conversion. We have already asserted that
-              // this is the case in WriteSections64 ().
-              //
-              break;
-
-            case R_AARCH64_ABS64:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_DIR64);
-              break;
-
-            case R_AARCH64_ABS32:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_HIGHLOW);
-             break;
-
-            default:
-                Error (NULL, 0, 3000, "Invalid", "WriteRelocations64(): %s unsupported ELF EM_AARCH64 relocation 0x%x.", mInImageName, (unsigned) ELF_R_TYPE(Rel->r_info));
-            }
-          } else if (mEhdr->e_machine == EM_RISCV64) {
-            RiscVRelType = ELF_R_TYPE(Rel->r_info);
-            switch (RiscVRelType) {
-            case R_RISCV_NONE:
-              break;
-
-            case R_RISCV_32:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_HIGHLOW);
-              break;
-
-            case R_RISCV_64:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_DIR64);
-              break;
-
-            case R_RISCV_HI20:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_RISCV_HI20);
-              break;
-
-            case R_RISCV_LO12_I:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_RISCV_LOW12I);
-              break;
-
-            case R_RISCV_LO12_S:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_RISCV_LOW12S);
-              break;
-
-            case R_RISCV_ADD64:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_ABSOLUTE);
-              break;
-
-            case R_RISCV_SUB64:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_ABSOLUTE);
-              break;
-
-            case R_RISCV_ADD32:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_ABSOLUTE);
-              break;
-
-            case R_RISCV_SUB32:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_ABSOLUTE);
-              break;
-
-            case R_RISCV_BRANCH:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_ABSOLUTE);
-              break;
-
-            case R_RISCV_JAL:
-              CoffAddFixup(
-                (UINT32) ((UINT64) mCoffSectionsOffset[RelShdr->sh_info]
-                + (Rel->r_offset - SecShdr->sh_addr)),
-                EFI_IMAGE_REL_BASED_ABSOLUTE);
-              break;
-
-            case R_RISCV_GPREL_I:
-            case R_RISCV_GPREL_S:
-            case R_RISCV_CALL:
-            case R_RISCV_RVC_BRANCH:
-            case R_RISCV_RVC_JUMP:
-            case R_RISCV_RELAX:
-            case R_RISCV_SUB6:
-            case R_RISCV_SET6:
-            case R_RISCV_SET8:
-            case R_RISCV_SET16:
-            case R_RISCV_SET32:
-            case R_RISCV_PCREL_HI20:
-            case R_RISCV_PCREL_LO12_I:
-              break;
-
-            default:
-              Error (NULL, 0, 3000, "Invalid", "WriteRelocations64(): %s unsupported ELF EM_RISCV64 relocation 0x%x.", mInImageName, (unsigned) ELF_R_TYPE(Rel->r_info));
-            }
-          } else {
-            Error (NULL, 0, 3000, "Not Supported", "This tool does not support relocations for ELF with e_machine %u (processor type).", (unsigned) mEhdr->e_machine);
-          }
-        }
-        if (mEhdr->e_machine == EM_X86_64 && RelShdr->sh_info == mGOTShindex) {
-          //
-          // Tack relocations for GOT entries after other relocations for
-          //   the section the GOT is in, as it's usually found at the end
-          //   of the section.  This is done in order to maintain Rva order
-          //   of Coff relocations.
-          //
-          EmitGOTRelocations();
+          RecordFixup64 (Rel, SecShdr, mCoffSectionsOffset[RelShdr->sh_info], TRUE);
         }
       }
     }
   }
 
-  if (mEhdr->e_machine == EM_X86_64) {
-    //
-    // This is a safety net just in case the GOT is in a section
-    //   with no other relocations and the first invocation of
-    //   EmitGOTRelocations() above was skipped.  This invocation
-    //   does not maintain Rva order of Coff relocations.
-    //   At present, with a single text section, all references to
-    //   the GOT and the GOT itself reside in section .text, so
-    //   if there's a GOT at all, the first invocation above
-    //   is executed.
-    //
-    EmitGOTRelocations();
-  }
+  //
+  // All fixups, including those for GOT entries, have been queued while the
+  // sections were relocated.  Emit them sorted by page.
+  //
+  CoffEmitFixups ();
+
   //
   // Pad by adding empty entries.
   //
@@ -1651,7 +1678,9 @@ CleanUp64 (
 {
   if (mCoffSectionsOffset != NULL) {
     free (mCoffSectionsOffset);
+    mCoffSectionsOffset = NULL;
   }
+  ReleaseCoffGOTEntries ();
 }
 
 
@@ -38,8 +38,8 @@ UINT8 *mCoffFile = NULL;
 //
 // COFF relocation data
 //
-EFI_IMAGE_BASE_RELOCATION *mCoffBaseRel;
-UINT16                    *mCoffEntryRel;
+EFI_IMAGE_BASE_RELOCATION *mCoffBaseRel = NULL;
+UINT16                    *mCoffEntryRel = NULL;
 
 //
 // Current offset in coff file.
@@ -62,6 +62,22 @@ UINT32 mFileBufferSize;
 //*****************************************************************************
 //
 
+//
+// Pending COFF fixups.  Relocation processing queues fixups here in whatever
+// order the ELF relocation sections yield them; CoffEmitFixups () then sorts
+// them by page and writes the .reloc blocks in one go, so the COFF buffer is
+// grown once instead of once per page transition.
+//
+typedef struct {
+  UINT32  Offset;
+  UINT32  Sequence;
+  UINT8   Type;
+} COFF_FIXUP;
+
+STATIC COFF_FIXUP *mCoffFixups = NULL;
+STATIC UINT32     mCoffFixupCount = 0;
+STATIC UINT32     mCoffFixupMax = 0;
+
 VOID
 CoffAddFixupEntry(
   UINT16 Val
@@ -73,52 +89,162 @@ CoffAddFixupEntry(
   mCoffOffset += 2;
 }
 
+VOID
+CoffReserveFixups (
+  UINT32 Count
+  )
+{
+  COFF_FIXUP *NewFixups;
+
+  if (mCoffFixupCount + Count <= mCoffFixupMax) {
+    return;
+  }
+
+  NewFixups = realloc (mCoffFixups, (mCoffFixupCount + Count) * sizeof (COFF_FIXUP));
+  if (NewFixups == NULL) {
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+    exit (EXIT_FAILURE);
+  }
+  mCoffFixups   = NewFixups;
+  mCoffFixupMax = mCoffFixupCount + Count;
+}
+
 VOID
 CoffAddFixup(
   UINT32 Offset,
   UINT8  Type
   )
 {
-  if (mCoffBaseRel == NULL
-      || mCoffBaseRel->VirtualAddress != (Offset & ~0xfff)) {
-    if (mCoffBaseRel != NULL) {
-      //
-      // Add a null entry (is it required ?)
-      //
-      CoffAddFixupEntry (0);
-
-      //
-      // Pad for alignment.
-      //
-      if (mCoffOffset % 4 != 0)
-        CoffAddFixupEntry (0);
-    }
+  if (mCoffFixupCount == mCoffFixupMax) {
+    //
+    // The caller under-estimated the number of fixups; grow geometrically.
+    //
+    CoffReserveFixups (mCoffFixupMax < 64 ? 64 : mCoffFixupMax);
+  }
 
-    mCoffFile = realloc (
-      mCoffFile,
-      mCoffOffset + sizeof(EFI_IMAGE_BASE_RELOCATION) + 2 * MAX_COFF_ALIGNMENT
-      );
-    if (mCoffFile == NULL) {
-      Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
-    }
-    assert (mCoffFile != NULL);
-    memset (
-      mCoffFile + mCoffOffset, 0,
-      sizeof(EFI_IMAGE_BASE_RELOCATION) + 2 * MAX_COFF_ALIGNMENT
-      );
-
-    mCoffBaseRel = (EFI_IMAGE_BASE_RELOCATION*)(mCoffFile + mCoffOffset);
-    mCoffBaseRel->VirtualAddress = Offset & ~0xfff;
-    mCoffBaseRel->SizeOfBlock = sizeof(EFI_IMAGE_BASE_RELOCATION);
-
-    mCoffEntryRel = (UINT16 *)(mCoffBaseRel + 1);
-    mCoffOffset += sizeof(EFI_IMAGE_BASE_RELOCATION);
+  mCoffFixups[mCoffFixupCount].Offset   = Offset;
+  mCoffFixups[mCoffFixupCount].Sequence = mCoffFixupCount;
+  mCoffFixups[mCoffFixupCount].Type     = Type;
+  mCoffFixupCount++;
+}
+
+//
+// Order fixups by RVA; fixups on the same RVA keep their queued order, as
+// some relocation types (e.g. RISC-V ADD/SUB pairs) emit more than one.
+//
+STATIC
+int
+CoffFixupComparator (
+  const void *Lhs,
+  const void *Rhs
+  )
+{
+  const COFF_FIXUP *Left  = (const COFF_FIXUP *)Lhs;
+  const COFF_FIXUP *Right = (const COFF_FIXUP *)Rhs;
+
+  if (Left->Offset != Right->Offset) {
+    return (Left->Offset < Right->Offset) ? -1 : 1;
+  }
+  if (Left->Sequence != Right->Sequence) {
+    return (Left->Sequence < Right->Sequence) ? -1 : 1;
   }
+  return 0;
+}
+
+VOID
+CoffEmitFixups (
+  VOID
+  )
+{
+  UINT32  Index;
+  UINT32  Page;
+  UINT32  Size;
+  BOOLEAN FirstBlock;
+
+  if (mCoffFixupCount == 0) {
+    return;
+  }
+
+  qsort (mCoffFixups, mCoffFixupCount, sizeof (COFF_FIXUP), CoffFixupComparator);
 
   //
-  // Fill the entry.
+  // Compute the exact size of the base relocation blocks, including the null
+  // terminator and alignment entry of every block but the last, so that the
+  // COFF buffer is only reallocated once.  The last block is padded up to the
+  // section alignment by the caller.
   //
-  CoffAddFixupEntry((UINT16) ((Type << 12) | (Offset & 0xfff)));
+  Size       = 0;
+  FirstBlock = TRUE;
+  Page       = 0;
+  for (Index = 0; Index < mCoffFixupCount; Index++) {
+    if (FirstBlock || Page != (mCoffFixups[Index].Offset & ~0xfff)) {
+      if (!FirstBlock) {
+        Size += 2;
+        if ((mCoffOffset + Size) % 4 != 0) {
+          Size += 2;
+        }
+      }
+      Page       = mCoffFixups[Index].Offset & ~0xfff;
+      Size      += sizeof (EFI_IMAGE_BASE_RELOCATION);
+      FirstBlock = FALSE;
+    }
+    Size += 2;
+  }
+
+  mCoffFile = realloc (mCoffFile, mCoffOffset + Size + 2 * MAX_COFF_ALIGNMENT);
+  if (mCoffFile == NULL) {
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+  }
+  assert (mCoffFile != NULL);
+  memset (mCoffFile + mCoffOffset, 0, Size + 2 * MAX_COFF_ALIGNMENT);
+
+  for (Index = 0; Index < mCoffFixupCount; Index++) {
+    if (mCoffBaseRel == NULL
+        || mCoffBaseRel->VirtualAddress != (mCoffFixups[Index].Offset & ~0xfff)) {
+      if (mCoffBaseRel != NULL) {
+        //
+        // Add a null entry (is it required ?)
+        //
+        CoffAddFixupEntry (0);
+
+        //
+        // Pad for alignment.
+        //
+        if (mCoffOffset % 4 != 0)
+          CoffAddFixupEntry (0);
+      }
+
+      mCoffBaseRel = (EFI_IMAGE_BASE_RELOCATION*)(mCoffFile + mCoffOffset);
+      mCoffBaseRel->VirtualAddress = mCoffFixups[Index].Offset & ~0xfff;
+      mCoffBaseRel->SizeOfBlock = sizeof(EFI_IMAGE_BASE_RELOCATION);
+
+      mCoffEntryRel = (UINT16 *)(mCoffBaseRel + 1);
+      mCoffOffset += sizeof(EFI_IMAGE_BASE_RELOCATION);
+    }
+
+    //
+    // Fill the entry.
+    //
+    CoffAddFixupEntry((UINT16) ((mCoffFixups[Index].Type << 12) | (mCoffFixups[Index].Offset & 0xfff)));
+  }
+
+  mCoffFixupCount = 0;
+}
+
+STATIC
+VOID
+CoffResetFixups (
+  VOID
+  )
+{
+  if (mCoffFixups != NULL) {
+    free (mCoffFixups);
+  }
+  mCoffFixups     = NULL;
+  mCoffFixupCount = 0;
+  mCoffFixupMax   = 0;
+  mCoffBaseRel    = NULL;
+  mCoffEntryRel   = NULL;
 }
 
 VOID
@@ -173,6 +299,16 @@ ConvertElf (
   UINT8                           EiClass;
 
   mFileBufferSize = *FileLength;
+
+  //
+  // Start from a clean relocation state; GenFw may convert several images
+  // in one process when running in batch mode.
+  //
+  mCoffFile = NULL;
+  mCoffOffset = 0;
+  mTableOffset = 0;
+  CoffResetFixups ();
+
   //
   // Determine ELF type and set function table pointer correctly.
   //
@@ -240,6 +376,7 @@ ConvertElf (
   // Free resources used by ELF functions.
   //
   ElfFunctions.CleanUp ();
+  CoffResetFixups ();
 
   return TRUE;
 }
@@ -69,6 +69,16 @@ CoffAddFixupEntry (
   UINT16 Val
   );
 
+VOID
+CoffReserveFixups (
+  UINT32 Count
+  );
+
+VOID
+CoffEmitFixups (
+  VOID
+  );
+
 
 VOID
 CreateSectionHeader (
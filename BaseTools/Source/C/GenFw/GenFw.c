@@ -54,6 +54,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define DEFAULT_MC_ALIGNMENT       16
 
 #define STATUS_IGNORE 0xA
+
+//
+// Maximum number of arguments on one line of a --batch list file.
+//
+#define MAXIMUM_BATCH_ARGUMENTS  64
 //
 // Structure definition for a microcode header
 //
@@ -110,6 +115,13 @@ MicrocodeReadData (
   UINT32        *Data
   );
 
+STATIC
+int
+GenFwMain (
+  int  argc,
+  char *argv[]
+  );
+
 STATIC
 VOID
 Version (
@@ -158,7 +170,8 @@ Returns:
   //
   // Summary usage
   //
-  fprintf (stdout, "\nUsage: %s [options] <input_file>\n\n", UTILITY_NAME);
+  fprintf (stdout, "\nUsage: %s [options] <input_file>\n", UTILITY_NAME);
+  fprintf (stdout, "       %s --batch ListFile\n\n", UTILITY_NAME);
 
   //
   // Copyright declaration
@@ -282,6 +295,11 @@ Returns:
   fprintf (stdout, "  -v, --verbose         Turn on verbose output with informational messages.\n");
   fprintf (stdout, "  -q, --quiet           Disable all messages except key message and fatal error\n");
   fprintf (stdout, "  -d, --debug level     Enable debug messages, at input debug level.\n");
+  fprintf (stdout, "  --batch ListFile      Run one conversion per line of ListFile. Each line\n\
+                        holds the options and input file of one %s\n\
+                        command line; empty lines and lines starting with\n\
+                        '#' are ignored. Processing stops at the first\n\
+                        failing line. This option must be used alone.\n", UTILITY_NAME);
   fprintf (stdout, "  --version             Show program's version number and exit\n");
   fprintf (stdout, "  -h, --help            Show this help message and exit\n");
 }
@@ -1032,6 +1050,163 @@ Returns:
   return Status;
 }
 
+STATIC
+VOID
+ResetImageState (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Reset the module image information kept across the conversion helpers, so
+  that several command lines can be processed by one process.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  mInImageName    = NULL;
+  mImageTimeStamp = 0;
+  mImageSize      = 0;
+  mOutImageType   = FW_DUMMY_IMAGE;
+  mIsConvertXip   = FALSE;
+
+  //
+  // -v, -q and -d only apply to the line they are given on.
+  //
+  SetPrintLevel (INFO_LOG_LEVEL);
+}
+
+STATIC
+int
+ProcessBatchFile (
+  CHAR8  *ListFileName
+  )
+/*++
+
+Routine Description:
+
+  Run every command line listed in a batch file in this process. This avoids
+  one process start-up (and one load of the tool) per module when a build
+  converts many images with the same tool.
+
+Arguments:
+
+  ListFileName - Name of the file holding one GenFw command line per line.
+
+Returns:
+  STATUS_SUCCESS - All listed command lines were processed successfully.
+  STATUS_ERROR   - The list file is invalid or one command line failed.
+
+--*/
+{
+  FILE    *ListFile;
+  CHAR8   *ListBuffer;
+  UINT32  ListLength;
+  CHAR8   *Line;
+  CHAR8   *NextLine;
+  CHAR8   *Cursor;
+  char    *Argv[MAXIMUM_BATCH_ARGUMENTS + 1];
+  int     Argc;
+  UINT32  LineNumber;
+  int     Status;
+
+  ListFile = fopen (LongFilePath (ListFileName), "rb");
+  if (ListFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening file", ListFileName);
+    return STATUS_ERROR;
+  }
+
+  ListLength = _filelength (fileno (ListFile));
+  ListBuffer = malloc (ListLength + 1);
+  if (ListBuffer == NULL) {
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+    fclose (ListFile);
+    return STATUS_ERROR;
+  }
+  if (fread (ListBuffer, 1, ListLength, ListFile) != ListLength) {
+    Error (NULL, 0, 0004, "Error reading file", ListFileName);
+    free (ListBuffer);
+    fclose (ListFile);
+    return STATUS_ERROR;
+  }
+  ListBuffer[ListLength] = '\0';
+  fclose (ListFile);
+
+  Status     = STATUS_SUCCESS;
+  LineNumber = 0;
+  for (Line = ListBuffer; Line != NULL && *Line != '\0'; Line = NextLine) {
+    LineNumber++;
+    NextLine = strchr (Line, '\n');
+    if (NextLine != NULL) {
+      *NextLine = '\0';
+      NextLine++;
+    }
+
+    //
+    // Split the line into arguments. Arguments containing white space may be
+    // enclosed in double quotes.
+    //
+    Argv[0] = UTILITY_NAME;
+    Argc    = 1;
+    Cursor  = Line;
+    while (*Cursor != '\0') {
+      while (isspace ((int) *Cursor)) {
+        Cursor++;
+      }
+      if (*Cursor == '\0' || (Argc == 1 && *Cursor == '#')) {
+        break;
+      }
+      if (Argc == MAXIMUM_BATCH_ARGUMENTS) {
+        Error (ListFileName, LineNumber, 1003, "Invalid option value", "too many arguments");
+        Status = STATUS_ERROR;
+        break;
+      }
+      if (*Cursor == '"') {
+        Cursor++;
+        Argv[Argc++] = Cursor;
+        while (*Cursor != '\0' && *Cursor != '"') {
+          Cursor++;
+        }
+      } else {
+        Argv[Argc++] = Cursor;
+        while (*Cursor != '\0' && !isspace ((int) *Cursor)) {
+          Cursor++;
+        }
+      }
+      if (*Cursor != '\0') {
+        *Cursor = '\0';
+        Cursor++;
+      }
+    }
+    Argv[Argc] = NULL;
+
+    if (Status != STATUS_SUCCESS) {
+      break;
+    }
+    if (Argc == 1) {
+      continue;
+    }
+
+    ResetImageState ();
+    Status = GenFwMain (Argc, Argv);
+    if (Status != STATUS_SUCCESS) {
+      Error (ListFileName, LineNumber, 0, "Batch line failed", NULL);
+      break;
+    }
+  }
+
+  free (ListBuffer);
+  return Status;
+}
+
 int
 main (
   int  argc,
@@ -1052,6 +1227,41 @@ Returns:
   STATUS_SUCCESS - Utility exits successfully.
   STATUS_ERROR   - Some error occurred during execution.
 
+--*/
+{
+  if (argc > 1 && stricmp (argv[1], "--batch") == 0) {
+    SetUtilityName (UTILITY_NAME);
+    if (argc != 3) {
+      Error (NULL, 0, 1001, "Missing options", "--batch takes exactly one list file and no other option.");
+      return STATUS_ERROR;
+    }
+    return ProcessBatchFile (argv[2]);
+  }
+
+  return GenFwMain (argc, argv);
+}
+
+STATIC
+int
+GenFwMain (
+  int  argc,
+  char *argv[]
+  )
+/*++
+
+Routine Description:
+
+  Process a single GenFw command line.
+
+Arguments:
+
+  argc - Number of command line parameters.
+  argv - Array of pointers to command line parameter strings.
+
+Returns:
+  STATUS_SUCCESS - Utility exits successfully.
+  STATUS_ERROR   - Some error occurred during execution.
+
 --*/
 {
   UINT32                           Type;
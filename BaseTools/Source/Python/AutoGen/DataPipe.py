@@ -156,6 +156,8 @@ class MemoryDataPipe(DataPipe):
 
         self.DataContainer = {"DatabasePath":GlobalData.gDatabasePath}
 
+        self.DataContainer = {"MetaFileCache":GlobalData.gMetaFileCache}
+
         self.DataContainer = {"FdfParser": True if GlobalData.gFdfParser else False}
 
         self.DataContainer = {"LogLevel": EdkLogger.GetLevel()}
@@ -167,3 +169,5 @@ class MemoryDataPipe(DataPipe):
         self.DataContainer = {"BinCacheDest":GlobalData.gBinCacheDest}
 
         self.DataContainer = {"EnableGenfdsMultiThread":GlobalData.gEnableGenfdsMultiThread}
+
+        self.DataContainer = {"EnablePch":GlobalData.gEnablePch}
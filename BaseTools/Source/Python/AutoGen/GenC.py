@@ -1956,6 +1956,24 @@ def BmpImageDecoder(File, Buffer, PaletteIndex, TransParent):
         PaletteBuffer = PaletteTemp[1:]
     return ImageBuffer, PaletteBuffer
 
+## Get the header files included at the beginning of AutoGen.h
+#
+#   @param      Info        The ModuleAutoGen object
+#
+#   @retval     list        The header files in the order of inclusion
+#
+def GetAutoGenHeaderIncludeList(Info):
+    IncludeList = []
+    if Info.ModuleType in gModuleTypeHeaderFile:
+        IncludeList.append(gModuleTypeHeaderFile[Info.ModuleType][0])
+    #
+    # if either PcdLib in [LibraryClasses] sections or there exist Pcd section, add PcdLib.h
+    # As if modules only uses FixedPcd, then PcdLib is not needed in [LibraryClasses] section.
+    #
+    if 'PcdLib' in Info.Module.LibraryClasses or Info.Module.Pcds:
+        IncludeList.append("Library/PcdLib.h")
+    return IncludeList
+
 ## Create common code
 #
 #   @param      Info        The ModuleAutoGen object
@@ -1970,14 +1988,8 @@ def CreateHeaderCode(Info, AutoGenC, AutoGenH):
     AutoGenH.Append(gAutoGenHCppPrologueString)
 
     # header files includes
-    if Info.ModuleType in gModuleTypeHeaderFile:
-        AutoGenH.Append("#include <%s>\n" % gModuleTypeHeaderFile[Info.ModuleType][0])
-    #
-    # if either PcdLib in [LibraryClasses] sections or there exist Pcd section, add PcdLib.h
-    # As if modules only uses FixedPcd, then PcdLib is not needed in [LibraryClasses] section.
-    #
-    if 'PcdLib' in Info.Module.LibraryClasses or Info.Module.Pcds:
-        AutoGenH.Append("#include <Library/PcdLib.h>\n")
+    for Inc in GetAutoGenHeaderIncludeList(Info):
+        AutoGenH.Append("#include <%s>\n" % Inc)
 
     AutoGenH.Append('\nextern GUID  gEfiCallerIdGuid;')
     AutoGenH.Append('\nextern GUID  gEdkiiDscPlatformGuid;')
@@ -20,8 +20,10 @@ from Common.BuildToolError import *
 from Common.Misc import *
 from Common.StringUtils import *
 from .BuildEngine import *
+from .GenC import GetAutoGenHeaderIncludeList
 import Common.GlobalData as GlobalData
 from collections import OrderedDict
+from hashlib import md5
 from Common.DataType import TAB_COMPILER_MSFT
 
 ## Regular expression for finding header file inclusions
@@ -30,6 +32,12 @@ gIncludePattern = re.compile(r"^[ \t]*[#%]?[ \t]*include(?:[ \t]*(?:\\(?:\r\n|\r
 ## Regular expression for matching macro used in header file inclusion
 gMacroPattern = re.compile("([_A-Z][_A-Z0-9]*)[ \t]*\((.+)\)", re.UNICODE)
 
+## Regular expression for splitting compiler flags, keeping quoted ones together
+gFlagPattern = re.compile(r'(?:"[^"]*"|[^\s"])+')
+
+## Whether the warning about a build rule without PCH_FLAGS has been shown
+gPchRuleWarningShown = False
+
 gIsFileMap = {}
 
 ## pattern for include style in Edk.x code
@@ -331,7 +339,7 @@ ${END}
 #
 FORCE_REBUILD = force_build
 INIT_TARGET = init
-PCH_TARGET =
+PCH_TARGET = ${BEGIN}${pch_target}${END}
 BC_TARGET = ${BEGIN}${backward_compatible_target} ${END}
 CODA_TARGET = ${BEGIN}${remaining_build_target} \\
               ${END}
@@ -578,6 +586,7 @@ cleanlib:
 
         self.ProcessBuildTargetList(MyAgo.OutputDir, ToolsDef)
         self.ParserGenerateFfsCmd()
+        PchTargetList = self.ProcessPrecompiledHeader(ToolsDef)
 
         # Generate macros used to represent input files
         FileMacroList = [] # macro name = file list
@@ -701,6 +710,7 @@ cleanlib:
             "image_entry_point"         : ImageEntryPoint,
             "arch_entry_point"          : ArchEntryPoint,
             "remaining_build_target"    : self.ResultFileList,
+            "pch_target"                : PchTargetList,
             "common_dependency_file"    : self.CommonFileDependency,
             "create_directory_command"  : self.GetCreateDirectoryCommand(self.IntermediateDirectoryList),
             "clean_command"             : self.GetRemoveDirectoryCommand(["$(OUTPUT_DIR)"]),
@@ -1129,6 +1139,137 @@ cleanlib:
                         T.Commands.pop(Index)
         return T, CmdSumDict, CmdTargetDict, CmdCppDict
 
+    ## Create the target of precompiled header for C files
+    #
+    #   The precompiled header contains the same base headers as the beginning
+    # of AutoGen.h. Modules of the same arch, using the same headers, package
+    # include paths and compiler flags, share one precompiled header in
+    # $(BIN_DIR)/Pch. It's force-included in front of AutoGen.h by PCH_FLAGS.
+    #
+    #   Only GCC and Clang with GNU make are supported. The compilers ignore
+    # the precompiled header silently if it doesn't match the flags of the
+    # source file, so it doesn't affect the generated code.
+    #
+    #   @param      ToolsDef    The list of tool definitions in makefile
+    #
+    #   @retval     list        The target of precompiled header, or empty list
+    #
+    def ProcessPrecompiledHeader(self, ToolsDef):
+        MyAgo = self._AutoGenObject
+        if not GlobalData.gEnablePch or self._FileType != GMAKE_FILETYPE:
+            return []
+        if MyAgo.ToolChainFamily != "GCC" or MyAgo.BuildRuleFamily != "GCC" or MyAgo.Arch == TAB_ARCH_EBC:
+            return []
+        if TAB_C_CODE_FILE not in MyAgo.Targets:
+            return []
+
+        # A build_rule.txt copied from an older template doesn't pass PCH_FLAGS
+        # to the compiler, so the precompiled header would never be used.
+        if not any('$(PCH_FLAGS)' in Cmd for T in MyAgo.Targets[TAB_C_CODE_FILE] for Cmd in T.Commands):
+            global gPchRuleWarningShown
+            if not gPchRuleWarningShown:
+                gPchRuleWarningShown = True
+                EdkLogger.warn("build", "--pch is ignored, as the C-Code-File build rule doesn't use $(PCH_FLAGS).",
+                               ExtraData="Update Conf/build_rule.txt from BaseTools/Conf/build_rule.template")
+            return []
+
+        CcOption = MyAgo.BuildOption.get('CC', {})
+        if 'PATH' not in CcOption or 'FLAGS' not in CcOption:
+            return []
+        HeaderList = GetAutoGenHeaderIncludeList(MyAgo)
+        if not HeaderList:
+            return []
+
+        # The first two include paths are module source and debug directory.
+        # The headers found there cannot be shared with other modules.
+        ModuleIncludeList = MyAgo.IncludePathList[:2]
+        PackageIncludeList = MyAgo.IncludePathList[2:]
+        for Inc in ModuleIncludeList:
+            for Header in HeaderList:
+                if os.path.exists(os.path.join(Inc, Header)):
+                    return []
+
+        # Only keep the include paths providing the headers, so that modules
+        # depending on different packages can still share the same one.
+        DependencyList = []
+        for Header in HeaderList:
+            for Inc in PackageIncludeList:
+                HeaderPath = os.path.join(Inc, Header)
+                if os.path.isfile(HeaderPath):
+                    HeaderPath = PathClass(HeaderPath)
+                    DependencyList.append(HeaderPath)
+                    DependencyList.extend(GetDependencyList(MyAgo, self.FileCache, HeaderPath, [], PackageIncludeList))
+                    break
+            else:
+                return []
+        if len(DependencyList) > len(HeaderList):
+            PackageIncludeList = [Inc for Inc in PackageIncludeList
+                                  if any(File.Path.startswith(os.path.join(Inc, '')) for File in DependencyList)]
+
+        # AutoGen.h is module specific. Macros in the flags are expanded, so the
+        # hash below tells apart modules using different values. A macro that
+        # can't be expanded here would make the precompiled header mismatch
+        # the objects, so the module doesn't use one.
+        FlagList = []
+        TokenList = gFlagPattern.findall(CcOption['FLAGS'])
+        Index = 0
+        while Index < len(TokenList):
+            Token = TokenList[Index]
+            Index += 1
+            if Token == '-include' and Index < len(TokenList) and TokenList[Index] == 'AutoGen.h':
+                Index += 1
+                continue
+            if '$(' in Token:
+                Token = ReplaceMacro(Token, MyAgo.Macros)
+                if '$(' in Token:
+                    EdkLogger.warn("build", "--pch is ignored for this module, as compiler flag %s cannot be expanded." % Token,
+                                   File=str(MyAgo.MetaFile))
+                    return []
+            FlagList.append(Token)
+
+        Content = "/**\n  DO NOT EDIT\n  FILE auto-generated\n  Precompiled base headers of AutoGen.h\n**/\n\n"
+        Content += ''.join("#include <%s>\n" % Header for Header in HeaderList)
+        Hash = md5()
+        for Item in [MyAgo.Arch, MyAgo.ToolChain, MyAgo.BuildTarget, CcOption['PATH'], ' '.join(FlagList), Content] + PackageIncludeList:
+            Hash.update(Item.encode('utf-8'))
+            Hash.update(b'\n')
+        PchDir = os.path.join(self.PlatformInfo.BuildDir, MyAgo.Arch, 'Pch', Hash.hexdigest()[:16])
+        CreateDirectory(PchDir)
+        PchHeader = os.path.join(PchDir, 'AutoGenPch.h')
+        SaveFileOnChange(PchHeader, Content, False)
+
+        # Clang looks for <header>.pch, while GCC looks for <header>.gch
+        if 'clang' in os.path.basename(CcOption['PATH']).lower():
+            PchFile = PchHeader + '.pch'
+        else:
+            PchFile = PchHeader + '.gch'
+
+        IncPrefix = self._INC_FLAG_[MyAgo.ToolChainFamily]
+        PchHeader = self.PlaceMacro(PchHeader, self.Macros)
+        PchFile = self.PlaceMacro(PchFile, self.Macros)
+        ToolsDef.append("PCH_FLAGS = -include %s" % PchHeader)
+        ToolsDef.append("")
+
+        # Modules sharing the precompiled header may be built at the same time,
+        # so the output is created with a module specific name then renamed.
+        TempFile = "$@.$(MODULE_NAME_GUID)"
+        CommandList = [
+            '"$(CC)" -MMD -MP -MT $@ -MF %s.d %s -x c-header -c -o %s.tmp %s %s' % (
+                TempFile, ' '.join(FlagList), TempFile,
+                ' '.join(IncPrefix + self.PlaceMacro(Inc, self.Macros) for Inc in PackageIncludeList),
+                PchHeader),
+            '$(MV) %s.d $@.d' % TempFile,
+            '$(MV) %s.tmp $@' % TempFile
+            ]
+        self.BuildTargetList.append(self._BUILD_TARGET_TEMPLATE.Replace({"target": PchFile, "cmd": "\n\t".join(CommandList), "deps": [PchHeader]}))
+        self.BuildTargetList.append("-include %s.d\n" % PchFile)
+
+        # The dependency files of objects don't list the headers inside the
+        # precompiled header, so objects depend on the precompiled header.
+        for T in MyAgo.Targets[TAB_C_CODE_FILE]:
+            self.BuildTargetList.append("%s : %s\n" % (self.PlaceMacro(T.Target.Path, self.Macros), PchFile))
+        return [PchFile]
+
     def CheckCCCmd(self, CommandList):
         for cmd in CommandList:
             if '$(CC)' in cmd:
@@ -20,7 +20,14 @@ from Common import GlobalData
 from Common import EdkLogger
 import Common.LongFilePathOs as os
 
-DATABASE_VERSION = 7
+DATABASE_VERSION = 8
+
+## Parameters of the hash used by ExMapHashTable, see PcdDataBaseSignatureGuid.h
+PCD_EX_MAP_HASH_BASIS = 0x811C9DC5
+PCD_EX_MAP_HASH_PRIME = 0x01000193
+PCD_EX_MAP_HASH_SEED_PRIME = 0x9E3779B9
+# Average number of keys per seed bucket
+PCD_EX_MAP_HASH_BUCKET_LOAD = 4
 
 gPcdDatabaseAutoGenC = TemplateString("""
 //
@@ -188,7 +195,8 @@ typedef struct {
   //UINT16                LocalTokenCount;  // LOCAL_TOKEN_NUMBER for all
   //UINT16                ExTokenCount;     // EX_TOKEN_NUMBER for DynamicEx
   //UINT16                GuidTableCount;   // The Number of Guid in GuidTable
-  //UINT8                 Pad[6];
+  //UINT16                ExMapHashSeedCount; // The Number of seeds in ExMapHashTable
+  //TABLE_OFFSET          ExMapHashTableOffset;
   ${PHASE}_PCD_DATABASE_INIT    Init;
   ${PHASE}_PCD_DATABASE_UNINIT  Uninit;
 } ${PHASE}_PCD_DATABASE;
@@ -305,6 +313,71 @@ class DbItemList:
 
         return Buffer
 
+## Calculate the hash of a dynamic-ex PCD {Guid, ExTokenNumber} for ExMapHashTable
+#
+#   It must match PcdExMapHash() of PCD drivers.
+#
+#   @param      Seed          The seed of hash
+#   @param      GuidBuffer    The GUID packed in memory layout
+#   @param      ExTokenNumber The token number of dynamic-ex PCD
+#
+#   @retval     The 32-bit hash value
+#
+def PcdExMapHash(Seed, GuidBuffer, ExTokenNumber):
+    Hash = (PCD_EX_MAP_HASH_BASIS ^ (Seed * PCD_EX_MAP_HASH_SEED_PRIME)) & 0xFFFFFFFF
+    for Byte in bytearray(GuidBuffer) + bytearray(pack('=L', ExTokenNumber)):
+        Hash = ((Hash ^ Byte) * PCD_EX_MAP_HASH_PRIME) & 0xFFFFFFFF
+    Hash ^= Hash >> 16
+    Hash = (Hash * 0x85EBCA6B) & 0xFFFFFFFF
+    Hash ^= Hash >> 13
+    Hash = (Hash * 0xC2B2AE35) & 0xFFFFFFFF
+    Hash ^= Hash >> 16
+    return Hash
+
+## Build the minimal perfect hash of ExMapTable
+#
+#   The keys are put into buckets by the hash of seed 0, then beginning with the
+# biggest bucket, a seed is searched for each bucket which sends all its keys to
+# free slots of the index table. The layout is described by DYNAMICEX_MAPPING in
+# PcdDataBaseSignatureGuid.h.
+#
+#   @param      ExMapTable    The list of (ExTokenNumber, TokenNumber, GuidIndex)
+#   @param      GuidTable     The list of GUID in C structure format
+#
+#   @retval     (SeedCount, HashTable), (0, []) if no table is generated
+#
+def BuildExMapHashTable(ExMapTable, GuidTable):
+    KeyList = []
+    for ExToken, _, GuidIndex in ExMapTable:
+        GuidBuffer = PackGUID(GuidStructureStringToGuidString(GuidTable[GetIntegerValue(GuidIndex)]).split('-'))
+        KeyList.append((GuidBuffer, GetIntegerValue(ExToken)))
+    KeyCount = len(KeyList)
+    if KeyCount == 0 or len(set(KeyList)) != KeyCount:
+        return 0, []
+
+    SeedCount = (KeyCount + PCD_EX_MAP_HASH_BUCKET_LOAD - 1) // PCD_EX_MAP_HASH_BUCKET_LOAD
+    BucketList = [[] for _ in range(SeedCount)]
+    for Index, (GuidBuffer, ExToken) in enumerate(KeyList):
+        BucketList[PcdExMapHash(0, GuidBuffer, ExToken) % SeedCount].append(Index)
+
+    SeedTable = [0] * SeedCount
+    IndexTable = [None] * KeyCount
+    for Bucket in sorted(range(SeedCount), key=lambda Bucket: -len(BucketList[Bucket])):
+        if not BucketList[Bucket]:
+            break
+        for Seed in range(1, 0x10000):
+            SlotList = [PcdExMapHash(Seed, KeyList[Index][0], KeyList[Index][1]) % KeyCount for Index in BucketList[Bucket]]
+            if len(set(SlotList)) == len(SlotList) and all(IndexTable[Slot] is None for Slot in SlotList):
+                break
+        else:
+            EdkLogger.verbose("Failed to build ExMapHashTable, GuidTable and ExMapTable will be scanned")
+            return 0, []
+        SeedTable[Bucket] = Seed
+        for Slot, Index in zip(SlotList, BucketList[Bucket]):
+            IndexTable[Slot] = Index
+
+    return SeedCount, SeedTable + IndexTable
+
 ## DbExMapTblItemList
 #
 #  The class holds the ExMap table
@@ -611,6 +684,8 @@ def BuildExDataBase(Dict):
     DbVpdHeadValue = DbComItemList(4, RawDataList = VpdHeadValue)
     ExMapTable = list(zip(Dict['EXMAPPING_TABLE_EXTOKEN'], Dict['EXMAPPING_TABLE_LOCAL_TOKEN'], Dict['EXMAPPING_TABLE_GUID_INDEX']))
     DbExMapTable = DbExMapTblItemList(8, RawDataList = ExMapTable)
+    ExMapHashSeedCount, ExMapHashTable = BuildExMapHashTable(ExMapTable[:GetIntegerValue(Dict['EX_TOKEN_NUMBER'])], Dict['GUID_STRUCTURE'])
+    DbExMapHashTable = DbItemList(2, RawDataList = ExMapHashTable)
     LocalTokenNumberTable = Dict['LOCAL_TOKEN_NUMBER_DB_VALUE']
     DbLocalTokenNumberTable = DbItemList(4, RawDataList = LocalTokenNumberTable)
     GuidTable = Dict['GUID_STRUCTURE']
@@ -677,21 +752,21 @@ def BuildExDataBase(Dict):
 
     DbNameTotle = ["SkuidValue",  "InitValueUint64", "VardefValueUint64", "InitValueUint32", "VardefValueUint32", "VpdHeadValue", "ExMapTable",
                "LocalTokenNumberTable", "GuidTable", "StringHeadValue",  "PcdNameOffsetTable", "VariableTable", "StringTableLen", "PcdTokenTable", "PcdCNameTable",
-               "SizeTableValue", "InitValueUint16", "VardefValueUint16", "InitValueUint8", "VardefValueUint8", "InitValueBoolean",
+               "SizeTableValue", "ExMapHashTable", "InitValueUint16", "VardefValueUint16", "InitValueUint8", "VardefValueUint8", "InitValueBoolean",
                "VardefValueBoolean", "UnInitValueUint64", "UnInitValueUint32", "UnInitValueUint16", "UnInitValueUint8", "UnInitValueBoolean"]
 
     DbTotal = [SkuidValue,  InitValueUint64, VardefValueUint64, InitValueUint32, VardefValueUint32, VpdHeadValue, ExMapTable,
                LocalTokenNumberTable, GuidTable, StringHeadValue,  PcdNameOffsetTable, VariableTable, StringTableLen, PcdTokenTable, PcdCNameTable,
-               SizeTableValue, InitValueUint16, VardefValueUint16, InitValueUint8, VardefValueUint8, InitValueBoolean,
+               SizeTableValue, ExMapHashTable, InitValueUint16, VardefValueUint16, InitValueUint8, VardefValueUint8, InitValueBoolean,
                VardefValueBoolean, UnInitValueUint64, UnInitValueUint32, UnInitValueUint16, UnInitValueUint8, UnInitValueBoolean]
     DbItemTotal = [DbSkuidValue,  DbInitValueUint64, DbVardefValueUint64, DbInitValueUint32, DbVardefValueUint32, DbVpdHeadValue, DbExMapTable,
                DbLocalTokenNumberTable, DbGuidTable, DbStringHeadValue,  DbPcdNameOffsetTable, DbVariableTable, DbStringTableLen, DbPcdTokenTable, DbPcdCNameTable,
-               DbSizeTableValue, DbInitValueUint16, DbVardefValueUint16, DbInitValueUint8, DbVardefValueUint8, DbInitValueBoolean,
+               DbSizeTableValue, DbExMapHashTable, DbInitValueUint16, DbVardefValueUint16, DbInitValueUint8, DbVardefValueUint8, DbInitValueBoolean,
                DbVardefValueBoolean, DbUnInitValueUint64, DbUnInitValueUint32, DbUnInitValueUint16, DbUnInitValueUint8, DbUnInitValueBoolean]
 
     # VardefValueBoolean is the last table in the init table items
     InitTableNum = DbNameTotle.index("VardefValueBoolean") + 1
-    # The FixedHeader length of the PCD_DATABASE_INIT, from Signature to Pad
+    # The FixedHeader length of the PCD_DATABASE_INIT, from Signature to ExMapHashTableOffset
     FixedHeaderLen = 80
 
     # Get offset of SkuId table in the database
@@ -765,6 +840,8 @@ def BuildExDataBase(Dict):
             StringTableOffset = DbTotalLength
         elif DbItemTotal[DbIndex] is DbSizeTableValue:
             SizeTableOffset = DbTotalLength
+        elif DbItemTotal[DbIndex] is DbExMapHashTable:
+            ExMapHashTableOffset = DbTotalLength
         elif DbItemTotal[DbIndex] is DbSkuidValue:
             SkuIdTableOffset = DbTotalLength
         elif DbItemTotal[DbIndex] is DbPcdNameOffsetTable:
@@ -774,6 +851,8 @@ def BuildExDataBase(Dict):
         DbTotalLength += DbItemTotal[DbIndex].GetListSize()
     if not Dict['PCD_INFO_FLAG']:
         DbPcdNameOffset  = 0
+    if ExMapHashSeedCount == 0:
+        ExMapHashTableOffset = 0
     LocalTokenCount = GetIntegerValue(Dict['LOCAL_TOKEN_NUMBER'])
     ExTokenCount = GetIntegerValue(Dict['EX_TOKEN_NUMBER'])
     GuidTableCount = GetIntegerValue(Dict['GUID_TABLE_SIZE'])
@@ -836,12 +915,11 @@ def BuildExDataBase(Dict):
     b = pack('=H', GuidTableCount)
 
     Buffer += b
-    b = pack('=B', Pad)
-    Buffer += b
-    Buffer += b
-    Buffer += b
-    Buffer += b
+    b = pack('=H', ExMapHashSeedCount)
+
     Buffer += b
+    b = pack('=L', ExMapHashTableOffset)
+
     Buffer += b
 
     Index = 0
@@ -899,6 +899,7 @@ class WorkspaceAutoGen(AutoGen):
             FdsCommandDict["quiet"] = True
 
         FdsCommandDict["GenfdsMultiThread"] = GlobalData.gEnableGenfdsMultiThread
+        FdsCommandDict["GenFdsJobs"] = GlobalData.gGenFdsJobs
         if GlobalData.gIgnoreSource:
             FdsCommandDict["IgnoreSources"] = True
 
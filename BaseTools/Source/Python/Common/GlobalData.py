@@ -117,7 +117,12 @@ gFileHashDict = None
 gModuleAllCacheStatus = None
 gModuleCacheHit = None
 
+# (CacheDir, Renew, Check) of the on-disk meta-file parse cache, None if disabled
+gMetaFileCache = None
+
 gEnableGenfdsMultiThread = True
+gGenFdsJobs = 1
+gEnablePch = False
 gSikpAutoGenCache = set()
 # Common lock for the file access in multiple process AutoGens
 file_lock = None
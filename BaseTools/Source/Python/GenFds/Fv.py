@@ -12,6 +12,7 @@
 from __future__ import absolute_import
 import Common.LongFilePathOs as os
 import subprocess
+import time
 from io import BytesIO
 from struct import *
 from . import FfsFileStatement
@@ -76,6 +77,7 @@ class FV (object):
             return GenFdsGlobalVariable.ImageBinDict[self.UiFvName.upper() + 'fv']
         if MacroDict is None:
             MacroDict = {}
+        StartTime = time.time()
 
         #
         # Check whether FV in Capsule is in FD flash region.
@@ -205,7 +207,8 @@ class FV (object):
                 FvHeaderBuffer = FvFileObj.read(0x48)
                 Signature = FvHeaderBuffer[0x28:0x32]
                 if Signature and Signature.startswith(b'_FVH'):
-                    GenFdsGlobalVariable.VerboseLogger("\nGenerate %s FV Successfully" % self.UiFvName)
+                    GenFdsGlobalVariable.FvTimeDict[self.UiFvName] = time.time() - StartTime
+                    GenFdsGlobalVariable.VerboseLogger("\nGenerate %s FV Successfully in %.2f seconds" % (self.UiFvName, GenFdsGlobalVariable.FvTimeDict[self.UiFvName]))
                     GenFdsGlobalVariable.SharpCounter = 0
 
                     FvFileObj.seek(0)
@@ -13,11 +13,13 @@ from __future__ import print_function
 from __future__ import absolute_import
 
 import Common.LongFilePathOs as os
+from os import getpid, replace
 import sys
 from sys import stdout
 from subprocess import PIPE,Popen
 from struct import Struct
 from array import array
+from hashlib import md5
 
 from Common.BuildToolError import COMMAND_FAILURE,GENFDS_ERROR
 from Common import EdkLogger
@@ -29,6 +31,7 @@ from AutoGen.BuildEngine import ToolBuildRule
 import Common.DataType as DataType
 from Common.Misc import PathClass,CreateDirectory
 from Common.LongFilePathSupport import OpenLongFilePath as open
+from Common.LongFilePathSupport import CopyLongFilePath
 from Common.MultipleWorkspace import MultipleWorkspace as mws
 import Common.GlobalData as GlobalData
 from Common.BuildToolError import *
@@ -91,6 +94,13 @@ class GenFdsGlobalVariable:
     # FvName, FdName, CapName in FDF, Image file name
     ImageBinDict = {}
 
+    # Number of processes used to generate independent FVs and capsules
+    GenFdsJobs = 1
+    # Directory caching GenSec/GenFfs output, shared by all GenFds processes
+    ToolOutputCacheDir = None
+    # FvName in FDF, seconds spent to generate the FV
+    FvTimeDict = {}
+
     ## LoadBuildRule
     #
     @staticmethod
@@ -515,7 +525,10 @@ class GenFdsGlobalVariable:
                     GenFdsGlobalVariable.SecCmdList.append(' '.join(Cmd).strip())
             elif GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s needs update because of newer %s" % (Output, Input))
-                GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
+                if DummyFile:
+                    GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
+                else:
+                    GenFdsGlobalVariable.CallCachedExternalTool(Cmd, Output, Input, "Failed to generate section")
                 if (os.path.getsize(Output) >= GenFdsGlobalVariable.LARGE_FILE_SIZE and
                     GenFdsGlobalVariable.LargeFileInFvFlags):
                     GenFdsGlobalVariable.LargeFileInFvFlags[-1] = True
@@ -571,7 +584,7 @@ class GenFdsGlobalVariable:
         else:
             if not GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 return
-            GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate FFS")
+            GenFdsGlobalVariable.CallCachedExternalTool(Cmd, Output, Input, "Failed to generate FFS")
 
     @staticmethod
     def GenerateFirmwareVolume(Output, Input, BaseAddress=None, ForceRebase=None, Capsule=False, Dump=False,
@@ -741,6 +754,52 @@ class GenFdsGlobalVariable:
                 print("###", cmd)
                 EdkLogger.error("GenFds", COMMAND_FAILURE, errorMess)
 
+    ## Call GenSec or GenFfs, reusing the output of an identical call
+    #
+    #   The output of these tools only depends on the options and the content
+    # of the input files, so an FFS or section which appears in more than one FV
+    # or capsule is generated only once per GenFds run.
+    #
+    #   @param  cmd             Tool command, including "-o Output"
+    #   @param  Output          Path of output file
+    #   @param  Input           Path list of input files
+    #   @param  errorMess       Error message if the tool fails
+    #
+    @staticmethod
+    def CallCachedExternalTool (cmd, Output, Input, errorMess):
+        CacheDir = GenFdsGlobalVariable.ToolOutputCacheDir
+        if not CacheDir:
+            GenFdsGlobalVariable.CallExternalTool(cmd, errorMess)
+            return
+
+        Hash = md5()
+        for Arg in cmd:
+            if Arg == Output:
+                Arg = '$(OUTPUT)'
+            elif Arg in Input:
+                try:
+                    with open(Arg, 'rb') as File:
+                        Arg = md5(File.read()).hexdigest()
+                except IOError:
+                    GenFdsGlobalVariable.CallExternalTool(cmd, errorMess)
+                    return
+            Hash.update((Arg + ' ').encode('utf-8'))
+        CacheFile = os.path.join(CacheDir, Hash.hexdigest())
+
+        if os.path.isfile(CacheFile):
+            GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s is copied from %s" % (Output, CacheFile))
+            CopyLongFilePath(CacheFile, Output)
+            return
+
+        GenFdsGlobalVariable.CallExternalTool(cmd, errorMess)
+        # other GenFds processes may write the same entry at the same time
+        TempFile = "%s.%d.tmp" % (CacheFile, getpid())
+        try:
+            CopyLongFilePath(Output, TempFile)
+            replace(TempFile, CacheFile)
+        except (IOError, OSError):
+            GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "Failed to cache %s" % Output)
+
     @staticmethod
     def VerboseLogger (msg):
         EdkLogger.verbose(msg)
@@ -0,0 +1,250 @@
+## @file
+# Generate independent FVs and capsules concurrently
+#
+# FVs which are not placed in an FD region are generated without base address,
+# and capsules only read the images generated before them, so both can be built
+# by a pool of processes before the sequential flow of GenFds reaches them. The
+# generated images are recorded in ImageBinDict of the main process, where the
+# sequential flow simply picks them up.
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import absolute_import
+import multiprocessing
+import shutil
+import time
+import uuid
+from io import BytesIO
+from concurrent.futures import ProcessPoolExecutor
+
+import Common.LongFilePathOs as os
+from Common.DataType import BINARY_FILE_TYPE_FV
+from .GenFdsGlobalVariable import GenFdsGlobalVariable
+from .FfsFileStatement import FileStatement
+from .CapsuleData import CapsuleFv, CapsuleFd, CapsuleAnyFile, CapsuleAfile
+
+# GUID of FMP capsule, which is generated by Capsule.GenFmpCapsule()
+FMP_CAPSULE_GUID = uuid.UUID('6DCBD5ED-E82D-4C44-BDA1-7194199AD92A')
+
+## Restore the state of main process and run a job in pool process
+#
+#   Pool processes are forked only once, so the images generated by previous
+# jobs are passed in explicitly.
+#
+#   @param  IsCapsule       True for a capsule job, False for a FV job
+#   @param  NameList        Names of FVs or capsules to generate, in FDF order
+#   @param  ImageBinDict    ImageBinDict of main process
+#   @param  FvState         FvAlignment of generated FVs
+#
+#   @retval tuple           (new images, FV state, FV time)
+#
+def _RunJob(IsCapsule, NameList, ImageBinDict, FvState):
+    Profile = GenFdsGlobalVariable.FdfParser.Profile
+    GenFdsGlobalVariable.ImageBinDict.update(ImageBinDict)
+    for FvName, Alignment in FvState.items():
+        Profile.FvDict[FvName].FvAlignment = Alignment
+    GenFdsGlobalVariable.FvTimeDict = {}
+
+    for Name in NameList:
+        if IsCapsule:
+            Profile.CapsuleDict[Name].GenCapsule()
+        else:
+            Buffer = BytesIO()
+            Profile.FvDict[Name].AddToBuffer(Buffer)
+            Buffer.close()
+
+    NewImages = {}
+    for Key, Image in GenFdsGlobalVariable.ImageBinDict.items():
+        if ImageBinDict.get(Key) != Image:
+            NewImages[Key] = Image
+    NewFvState = {}
+    for FvName in Profile.FvDict:
+        if FvName.upper() + 'fv' in NewImages:
+            FvObj = Profile.FvDict[FvName]
+            NewFvState[FvName] = (FvObj.FvAlignment,
+                                  [Ffs.NameGuid for Ffs in FvObj.FfsList if isinstance(Ffs, FileStatement)])
+    return NewImages, NewFvState, GenFdsGlobalVariable.FvTimeDict
+
+## Schedule FV and capsule generation on a process pool
+#
+#
+class GenFdsScheduler(object):
+    # FvName, FvAlignment of the FVs generated by pool processes
+    _FvState = {}
+
+    ## Check if FVs and capsules can be generated concurrently
+    @staticmethod
+    def Enabled():
+        return GenFdsGlobalVariable.GenFdsJobs > 1 and 'fork' in multiprocessing.get_all_start_methods()
+
+    ## Prepare the tool output cache shared by pool processes
+    @staticmethod
+    def Setup():
+        GenFdsScheduler._FvState = {}
+        GenFdsGlobalVariable.ToolOutputCacheDir = None
+        if not GenFdsScheduler.Enabled():
+            return
+        CacheDir = os.path.join(GenFdsGlobalVariable.FvDir, 'ToolOutputCache')
+        if os.path.exists(CacheDir):
+            shutil.rmtree(CacheDir)
+        os.makedirs(CacheDir)
+        GenFdsGlobalVariable.ToolOutputCacheDir = CacheDir
+
+    ## Walk the sections of a FILE statement and collect the FVs they refer to
+    @staticmethod
+    def _GetSectionFvRef(SectionList, FvRefList):
+        Safe = True
+        for Sect in SectionList:
+            if getattr(Sect, 'FvName', None):
+                FvRefList.append(Sect.FvName.upper())
+                # FV image section given an address is always rebased
+                if getattr(Sect, 'FvAddr', None):
+                    Safe = False
+            Safe = GenFdsScheduler._GetSectionFvRef(getattr(Sect, 'SectionList', []), FvRefList) and Safe
+        return Safe
+
+    ## Find FVs which can be generated independently and group them
+    #
+    #   A FV can be generated ahead of time if it's generated without base
+    # address and macros by the sequential flow too: it's not placed in FD
+    # region, it doesn't refer to any FD, and all the FVs it refers to can be
+    # generated ahead of time. FVs referring to each other or sharing a module
+    # must be generated by the same job, because the intermediate files of a
+    # module are not per FV.
+    #
+    #   @retval list            Name list of each job
+    #
+    @staticmethod
+    def _GetFvJobList():
+        Profile = GenFdsGlobalVariable.FdfParser.Profile
+        Excluded = set()
+        for FdObj in Profile.FdDict.values():
+            for RegionObj in FdObj.RegionList:
+                if RegionObj.RegionType == BINARY_FILE_TYPE_FV:
+                    for RegionData in RegionObj.RegionDataList:
+                        Excluded.add(RegionData.upper())
+
+        FvRefDict = {}
+        InfDict = {}
+        for FvName, FvObj in Profile.FvDict.items():
+            if FvObj.BaseAddress:
+                Excluded.add(FvName)
+            FvRefList = []
+            for FfsObj in FvObj.FfsList:
+                if isinstance(FfsObj, FileStatement):
+                    if FfsObj.FdName:
+                        Excluded.add(FvName)
+                    RefCount = len(FvRefList)
+                    if FfsObj.FvName:
+                        FvRefList.append(FfsObj.FvName.upper())
+                    if not GenFdsScheduler._GetSectionFvRef(FfsObj.SectionList, FvRefList):
+                        Excluded.update(FvRefList[RefCount:])
+                    # macros of FV and FILE statement are passed down to nested FV
+                    if FvObj.DefineVarDict or FfsObj.DefineVarDict:
+                        Excluded.update(FvRefList[RefCount:])
+                else:
+                    InfDict.setdefault(os.path.normpath(FfsObj.InfFileName), []).append(FvName)
+            FvRefDict[FvName] = FvRefList
+
+        Changed = True
+        while Changed:
+            Changed = False
+            for FvName, FvRefList in FvRefDict.items():
+                if FvName not in Excluded and [Ref for Ref in FvRefList if Ref in Excluded or Ref not in FvRefDict]:
+                    Excluded.add(FvName)
+                    Changed = True
+
+        Group = dict((FvName, FvName) for FvName in FvRefDict if FvName not in Excluded)
+        def Find(FvName):
+            while Group[FvName] != FvName:
+                FvName = Group[FvName]
+            return FvName
+        def Union(FvNameList):
+            for FvName in FvNameList[1:]:
+                Group[Find(FvName)] = Find(FvNameList[0])
+        for FvName in Group:
+            Union([FvName] + FvRefDict[FvName])
+        for FvNameList in InfDict.values():
+            FvNameList = [FvName for FvName in FvNameList if FvName in Group]
+            if FvNameList:
+                Union(FvNameList)
+
+        JobDict = {}
+        for FvName in Profile.FvDict:
+            if FvName in Group:
+                JobDict.setdefault(Find(FvName), []).append(FvName)
+        # start the biggest jobs first
+        return sorted(JobDict.values(), key=lambda Job: -sum(len(Profile.FvDict[FvName].FfsList) for FvName in Job))
+
+    ## Find capsules which only consist of generated images and files
+    @staticmethod
+    def _GetCapsuleJobList():
+        JobList = []
+        for CapsuleName, CapsuleObj in GenFdsGlobalVariable.FdfParser.Profile.CapsuleDict.items():
+            if 'CAPSULE_GUID' in CapsuleObj.TokensDict and uuid.UUID(CapsuleObj.TokensDict['CAPSULE_GUID']) == FMP_CAPSULE_GUID:
+                continue
+            Ready = True
+            for CapsuleDataObj in CapsuleObj.CapsuleDataList:
+                if isinstance(CapsuleDataObj, CapsuleFv):
+                    Name = CapsuleDataObj.FvName
+                    Ready = Name.find('.fv') != -1 or Name.upper() + 'fv' in GenFdsGlobalVariable.ImageBinDict
+                elif isinstance(CapsuleDataObj, CapsuleFd):
+                    Name = CapsuleDataObj.FdName
+                    Ready = Name.find('.fd') != -1 or Name.upper() + 'fd' in GenFdsGlobalVariable.ImageBinDict
+                elif not isinstance(CapsuleDataObj, (CapsuleAnyFile, CapsuleAfile)):
+                    Ready = False
+                if not Ready:
+                    break
+            if Ready:
+                JobList.append([CapsuleName])
+        return JobList
+
+    @staticmethod
+    def _Run(IsCapsule, JobList):
+        Profile = GenFdsGlobalVariable.FdfParser.Profile
+        if len(JobList) < 2:
+            return
+        Jobs = min(GenFdsGlobalVariable.GenFdsJobs, len(JobList))
+        GenFdsGlobalVariable.InfLogger("\nGenerating %d %s in %d processes" % (len(JobList), "capsule(s)" if IsCapsule else "FV job(s)", Jobs))
+        StartTime = time.time()
+        with ProcessPoolExecutor(Jobs, multiprocessing.get_context('fork')) as Pool:
+            FutureList = [Pool.submit(_RunJob, IsCapsule, NameList, GenFdsGlobalVariable.ImageBinDict, GenFdsScheduler._FvState)
+                          for NameList in JobList]
+            for NameList, Future in zip(JobList, FutureList):
+                NewImages, NewFvState, FvTime = Future.result()
+                GenFdsGlobalVariable.ImageBinDict.update(NewImages)
+                GenFdsGlobalVariable.FvTimeDict.update(FvTime)
+                for FvName, (Alignment, NameGuidList) in NewFvState.items():
+                    FvObj = Profile.FvDict[FvName]
+                    FvObj.FvAlignment = Alignment
+                    # resolve PCD(...) names of FILE statements as the pool process did
+                    for FfsObj, NameGuid in zip([Ffs for Ffs in FvObj.FfsList if isinstance(Ffs, FileStatement)], NameGuidList):
+                        FfsObj.NameGuid = NameGuid
+                    GenFdsScheduler._FvState[FvName] = Alignment
+        GenFdsGlobalVariable.VerboseLogger("Concurrent generation done in %.2f seconds" % (time.time() - StartTime))
+
+    ## Generate the FVs not placed in FD region ahead of time
+    @staticmethod
+    def GenFvs():
+        if GenFdsScheduler.Enabled():
+            GenFdsScheduler._Run(False, GenFdsScheduler._GetFvJobList())
+
+    ## Generate the capsules whose images are all available
+    @staticmethod
+    def GenCapsules():
+        if GenFdsScheduler.Enabled():
+            GenFdsScheduler._Run(True, GenFdsScheduler._GetCapsuleJobList())
+
+    ## Display the time spent to generate each FV
+    @staticmethod
+    def DisplayFvTime():
+        if not GenFdsScheduler.Enabled() or not GenFdsGlobalVariable.FvTimeDict:
+            return
+        MaxFvNameLength = max(len(FvName) for FvName in GenFdsGlobalVariable.FvTimeDict)
+        GenFdsGlobalVariable.InfLogger('\nGENERATE TIME OF FV')
+        for FvName, Time in GenFdsGlobalVariable.FvTimeDict.items():
+            GenFdsGlobalVariable.InfLogger(FvName + (' ' * (MaxFvNameLength - len(FvName))) + ' %8.2f seconds' % Time)
@@ -0,0 +1,242 @@
+## @file
+# This file is used to keep the raw parse result of meta files on disk
+#
+# The raw table produced by InfParser and DecParser only depends on the content
+# of the file and on a small amount of global state, so it can be reused by the
+# next build as long as none of those change. DSC files are not cached because
+# their parse result depends on !include, conditional directives and macros
+# coming from the whole platform.
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import absolute_import
+import os
+import pickle
+import time
+from hashlib import md5
+
+import Common.EdkLogger as EdkLogger
+import Common.GlobalData as GlobalData
+from Common.LongFilePathSupport import OpenLongFilePath as open
+
+## Meta-file parse cache
+#
+#   Every entry is stored in its own file, named by the key of the parsed file.
+# The key covers the cache format version, the parser source code, the parser
+# class, the path and content of the meta file and the global state the raw
+# parse looks at. Any change of them simply results in a different key, so an
+# entry never needs to be invalidated explicitly.
+#
+class MetaFileCache(object):
+    # bump it if the layout of cache entry changes
+    _VERSION_ = 1
+
+    # column holding the ID of the item a record belongs to
+    _BELONGS_TO_ITEM_ = 7
+
+    # digest of parser source code, calculated once per process
+    _ToolDigest = None
+
+    ## Constructor
+    def __init__(self):
+        self.CacheDir = None
+        self.Renew = False
+        self.Check = False
+        self.Hits = 0
+        self.Misses = 0
+        self.Mismatches = 0
+        self.LoadTime = 0.0
+        self.ParseTime = 0.0
+
+    ## Enable the cache
+    #
+    #   @param  CacheDir    Directory to store cache entries; None disables the cache
+    #   @param  Renew       Ignore existing entries and write them again
+    #   @param  Check       Parse the file even on cache hit and compare the result
+    #
+    def Enable(self, CacheDir, Renew=False, Check=False):
+        self.CacheDir = CacheDir
+        self.Renew = Renew
+        self.Check = Check
+        if not CacheDir:
+            return
+        try:
+            if not os.path.exists(CacheDir):
+                os.makedirs(CacheDir)
+        except OSError as Exc:
+            EdkLogger.verbose("Meta-file cache disabled: %s" % str(Exc))
+            self.CacheDir = None
+
+    @property
+    def Enabled(self):
+        return self.CacheDir is not None
+
+    ## Summary line for build log
+    def Statistics(self):
+        Message = "Meta-file cache: %d hit(s), %d miss(es), load %.3fs, parse %.3fs" % \
+                  (self.Hits, self.Misses, self.LoadTime, self.ParseTime)
+        if self.Check:
+            Message += ", %d mismatch(es)" % self.Mismatches
+        return Message
+
+    @classmethod
+    def _GetToolDigest(Class):
+        if Class._ToolDigest is None:
+            Hash = md5()
+            Dir = os.path.dirname(os.path.abspath(__file__))
+            for Name in ('MetaFileParser.py', 'MetaFileTable.py', 'MetaFileCache.py'):
+                try:
+                    with open(os.path.join(Dir, Name), 'rb') as File:
+                        Hash.update(File.read())
+                except IOError:
+                    Hash.update(Name.encode('utf-8'))
+            Class._ToolDigest = Hash.hexdigest()
+        return Class._ToolDigest
+
+    ## Calculate the key of parser
+    #
+    #   The INF/DEC parser only checks the names of global macros (they cannot be
+    # redefined) and the CheckUsage option (comment checking), so the values of
+    # macros from command line or environment are deliberately not part of key.
+    #
+    def _GetKey(self, Parser):
+        try:
+            with open(str(Parser.MetaFile), 'rb') as File:
+                Content = File.read()
+        except IOError:
+            return None
+        Hash = md5()
+        Hash.update(('%d|%s|%s|%s|' % (self._VERSION_, self._GetToolDigest(),
+                                       type(Parser).__name__, Parser.MetaFile.Path)).encode('utf-8'))
+        Hash.update(Content)
+        Hash.update(('|' + ' '.join(sorted(GlobalData.gGlobalDefines))).encode('utf-8'))
+        CheckUsage = bool(GlobalData.gOptions and getattr(GlobalData.gOptions, 'CheckUsage', False))
+        Hash.update(('|%s' % CheckUsage).encode('utf-8'))
+        return Hash.hexdigest()
+
+    def _GetEntryPath(self, Key):
+        return os.path.join(self.CacheDir, Key + '.pkl')
+
+    ## Convert the raw table and parser state to an entry
+    def _Pack(self, Parser):
+        Table = Parser._RawTable
+        State = {}
+        for Name in Parser._CACHED_ATTRIBUTES_:
+            State[Name] = getattr(Parser, Name)
+        return {
+            'Version'   : self._VERSION_,
+            'Base'      : Table.FileId * 10**8,
+            'Id'        : Table.ID,
+            'Rows'      : [list(Row) for Row in Table.CurrentContent if Row[0] >= 0],
+            'State'     : State
+            }
+
+    ## Move the record IDs of an entry to the ID range of given table
+    #
+    #   Only IDs derived from the file ID of the table are moved. The IDs which
+    # have wrapped around in MetaFileTable.Insert() don't depend on the file ID.
+    #
+    def _Relocate(self, Entry, Table):
+        OldBase = Entry['Base']
+        Delta = Table.FileId * 10**8 - OldBase
+        if Delta == 0:
+            return Entry['Rows'], Entry['Id']
+        Rows = []
+        for Row in Entry['Rows']:
+            Row = list(Row)
+            if Row[0] >= OldBase:
+                Row[0] += Delta
+            if Row[self._BELONGS_TO_ITEM_] >= OldBase:
+                Row[self._BELONGS_TO_ITEM_] += Delta
+            Rows.append(Row)
+        Id = Entry['Id']
+        if Id >= OldBase:
+            Id += Delta
+        return Rows, Id
+
+    ## Fill the raw table and parser state from an entry
+    def _Unpack(self, Parser, Entry):
+        Table = Parser._RawTable
+        Table.CurrentContent, Table.ID = self._Relocate(Entry, Table)
+        for Name, Value in Entry['State'].items():
+            setattr(Parser, Name, Value)
+        Parser._Done()
+
+    ## Check if an entry gives the same result as the parser
+    def _Match(self, Parser, Entry):
+        Table = Parser._RawTable
+        Rows, Id = self._Relocate(Entry, Table)
+        if Id != Table.ID or Rows != [list(Row) for Row in Table.CurrentContent if Row[0] >= 0]:
+            return False
+        for Name in Parser._CACHED_ATTRIBUTES_:
+            if Entry['State'].get(Name) != getattr(Parser, Name):
+                return False
+        return True
+
+    def _Read(self, Key):
+        try:
+            with open(self._GetEntryPath(Key), 'rb') as File:
+                Entry = pickle.load(File)
+        except Exception:
+            return None
+        if not isinstance(Entry, dict) or Entry.get('Version') != self._VERSION_:
+            return None
+        return Entry
+
+    ## Write entry atomically, so that parallel builds never see partial files
+    def _Write(self, Key, Entry):
+        Path = self._GetEntryPath(Key)
+        TempPath = "%s.%d.tmp" % (Path, os.getpid())
+        try:
+            with open(TempPath, 'wb') as File:
+                pickle.dump(Entry, File, pickle.HIGHEST_PROTOCOL)
+            os.replace(TempPath, Path)
+        except Exception as Exc:
+            EdkLogger.debug(EdkLogger.DEBUG_5, "Failed to write meta-file cache %s: %s" % (Path, str(Exc)))
+            try:
+                os.remove(TempPath)
+            except OSError:
+                pass
+
+    ## Parse the meta file, using cached result if possible
+    #
+    #   @param  Parser      InfParser or DecParser object whose table is empty
+    #
+    def Parse(self, Parser):
+        if not self.Enabled or not hasattr(Parser, '_CACHED_ATTRIBUTES_'):
+            Parser.Start()
+            return
+
+        Key = self._GetKey(Parser)
+        if Key is None:
+            Parser.Start()
+            return
+
+        Entry = None
+        if not self.Renew:
+            StartTime = time.time()
+            Entry = self._Read(Key)
+            self.LoadTime += time.time() - StartTime
+
+        if Entry is not None and not self.Check:
+            self._Unpack(Parser, Entry)
+            self.Hits += 1
+            return
+
+        StartTime = time.time()
+        Parser.Start()
+        self.ParseTime += time.time() - StartTime
+        if Entry is None:
+            self.Misses += 1
+        else:
+            self.Hits += 1
+            if self._Match(Parser, Entry):
+                return
+            self.Mismatches += 1
+            EdkLogger.warn("build", "Cached parse result of %s does not match the file content" % Parser.MetaFile,
+                           ExtraData="cache entry %s is replaced" % self._GetEntryPath(Key))
+        self._Write(Key, self._Pack(Parser))
@@ -190,6 +190,8 @@ class MetaFileParser(object):
         self._PcdCodeValue = ""
         self._PcdDataTypeCODE = False
         self._CurrentPcdName = ""
+        # on-disk cache of raw parse result, set by the build object factory
+        self.Cache = None
 
     ## Store the parsed data in table
     def _Store(self, *Args):
@@ -258,7 +260,10 @@ class MetaFileParser(object):
             else:
                 self._Table = self._RawTable
                 self._PostProcessed = False
-                self.Start()
+                if self.Cache:
+                    self.Cache.Parse(self)
+                else:
+                    self.Start()
     ## Data parser for the common format in different type of file
     #
     #   The common format in the meatfile is like
@@ -533,6 +538,9 @@ class MetaFileParser(object):
 #   @param      Macros          Macros used for replacement in file
 #
 class InfParser(MetaFileParser):
+    # parser states which are used after parsing and kept in meta-file cache
+    _CACHED_ATTRIBUTES_ = ('_Defines', '_Version', '_FileLocalMacros', '_SectionsMacroDict', '_GuidDict', 'PcdsDict')
+
     # INF file supported data types (one type per section)
     DataType = {
         TAB_UNKNOWN.upper() : MODEL_UNKNOWN,
@@ -1749,6 +1757,9 @@ class DscParser(MetaFileParser):
 #   @param      Macros          Macros used for replacement in file
 #
 class DecParser(MetaFileParser):
+    # parser states which are used after parsing and kept in meta-file cache
+    _CACHED_ATTRIBUTES_ = ('_Defines', '_Version', '_FileLocalMacros', '_SectionsMacroDict', '_GuidDict')
+
     # DEC file supported data types (one type per section)
     DataType = {
         TAB_DEC_DEFINES.upper()                     :   MODEL_META_DATA_HEADER,
@@ -18,6 +18,7 @@ from types import *
 from .MetaDataTable import *
 from .MetaFileTable import *
 from .MetaFileParser import *
+from .MetaFileCache import MetaFileCache
 
 from Workspace.DecBuildData import DecBuildData
 from Workspace.DscBuildData import DscBuildData
@@ -119,6 +120,7 @@ class WorkspaceDatabase(object):
                                 Arch,
                                 MetaFileStorage(self.WorkspaceDb, FilePath, FileType)
                                 )
+            MetaFile.Cache = self.WorkspaceDb.MetaFileCache
             # always do post-process, in case of macros change
             MetaFile.DoPostProcess()
             # object the build is based on
@@ -153,6 +155,7 @@ class WorkspaceDatabase(object):
         self.TblDataModel = DataClass.MODEL_LIST
         self.TblFile = []
         self.Platform = None
+        self.MetaFileCache = MetaFileCache()
 
         # conversion object for build or file format conversion purpose
         self.BuildObject = WorkspaceDatabase.BuildObjectFactory(self)
@@ -750,6 +750,8 @@ class Build():
         GlobalData.gBinCacheDest   = BuildOptions.BinCacheDest
         GlobalData.gBinCacheSource = BuildOptions.BinCacheSource
         GlobalData.gEnableGenfdsMultiThread = not BuildOptions.NoGenfdsMultiThread
+        GlobalData.gGenFdsJobs = BuildOptions.GenFdsJobs
+        GlobalData.gEnablePch = BuildOptions.EnablePch
         GlobalData.gDisableIncludePathCheck = BuildOptions.DisableIncludePathCheck
 
         if GlobalData.gBinCacheDest and not GlobalData.gUseHashCache:
@@ -782,6 +784,10 @@ class Build():
         GlobalData.gDatabasePath = os.path.normpath(os.path.join(GlobalData.gConfDirectory, GlobalData.gDatabasePath))
         if not os.path.exists(os.path.join(GlobalData.gConfDirectory, '.cache')):
             os.makedirs(os.path.join(GlobalData.gConfDirectory, '.cache'))
+        if not BuildOptions.DisableCache:
+            GlobalData.gMetaFileCache = (os.path.join(GlobalData.gConfDirectory, '.cache', 'MetaFile'),
+                                         bool(BuildOptions.Reparse), BuildOptions.CheckMetaFileCache)
+            BuildDB.MetaFileCache.Enable(*GlobalData.gMetaFileCache)
         self.Db = BuildDB
         self.BuildDatabase = self.Db.BuildObject
         self.Platform = None
@@ -2709,6 +2715,8 @@ def Main():
         if not BuildError:
             MyBuild.BuildReport.GenerateReport(BuildDurationStr, LogBuildTime(MyBuild.AutoGenTime), LogBuildTime(MyBuild.MakeTime), LogBuildTime(MyBuild.GenFdsTime))
 
+    if BuildDB.MetaFileCache.Enabled:
+        EdkLogger.verbose(BuildDB.MetaFileCache.Statistics())
     EdkLogger.SetLevel(EdkLogger.QUIET)
     EdkLogger.quiet("\n- %s -" % Conclusion)
     EdkLogger.quiet(time.strftime("Build end time: %H:%M:%S, %b.%d %Y", time.localtime()))
@@ -4041,6 +4041,36 @@ CryptoServiceTlsSetSessionId (
   return CALL_BASECRYPTLIB (TlsSet.Services.SessionId, TlsSetSessionId, (Tls, SessionId, SessionIdLen), EFI_UNSUPPORTED);
 }
 
+/**
+  Sets a TLS/SSL session to be resumed during TLS/SSL connect.
+
+  This function sets a session saved by TlsGetSession() from a previous
+  connection to the same server, so that the TLS/SSL connection to be
+  established resumes it with an abbreviated handshake, by session ID or by
+  session ticket. The server may still decline it, in which case a full
+  handshake takes place.
+
+  @param[in]  Tls               Pointer to the TLS object.
+  @param[in]  SessionData       Session data returned by TlsGetSession().
+  @param[in]  SessionDataSize   Size of session data in bytes.
+
+  @retval  EFI_SUCCESS           Session was set successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_UNSUPPORTED       The handshake has already started.
+  @retval  EFI_ABORTED           Invalid session data.
+
+**/
+EFI_STATUS
+EFIAPI
+CryptoServiceTlsSetSession (
+  IN     VOID                     *Tls,
+  IN     CONST UINT8              *SessionData,
+  IN     UINTN                    SessionDataSize
+  )
+{
+  return CALL_BASECRYPTLIB (TlsSet.Services.Session, TlsSetSession, (Tls, SessionData, SessionDataSize), EFI_UNSUPPORTED);
+}
+
 /**
   Adds the CA to the cert store when requesting Server or Client authentication.
 
@@ -4290,6 +4320,55 @@ CryptoServiceTlsGetSessionId (
   return CALL_BASECRYPTLIB (TlsGet.Services.SessionId, TlsGetSessionId, (Tls, SessionId, SessionIdLen), EFI_UNSUPPORTED);
 }
 
+/**
+  Gets the session of the specified TLS connection, for resumption.
+
+  This function returns the TLS/SSL session established by the specified TLS
+  connection, including the master secret and the session ticket if any, so
+  that it can be set by TlsSetSession() on a later connection to the same
+  server.
+
+  @param[in]      Tls               Pointer to the TLS object.
+  @param[out]     SessionData       Buffer to contain the returned session data.
+  @param[in,out]  SessionDataSize   The size of SessionData buffer in bytes. On
+                                    output, the size of session data.
+
+  @retval  EFI_SUCCESS           The session was returned successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_UNSUPPORTED       No resumable session is established.
+  @retval  EFI_BUFFER_TOO_SMALL  The SessionData is too small to hold the session.
+
+**/
+EFI_STATUS
+EFIAPI
+CryptoServiceTlsGetSession (
+  IN     VOID                     *Tls,
+  OUT    UINT8                    *SessionData,  OPTIONAL
+  IN OUT UINTN                    *SessionDataSize
+  )
+{
+  return CALL_BASECRYPTLIB (TlsGet.Services.Session, TlsGetSession, (Tls, SessionData, SessionDataSize), EFI_UNSUPPORTED);
+}
+
+/**
+  Checks if the handshake of the specified TLS connection resumed a session
+  set by TlsSetSession().
+
+  @param[in]  Tls    Pointer to the TLS object.
+
+  @retval  TRUE     The session was resumed.
+  @retval  FALSE    A full handshake took place, or hasn't completed yet.
+
+**/
+BOOLEAN
+EFIAPI
+CryptoServiceTlsIsSessionReused (
+  IN     VOID                     *Tls
+  )
+{
+  return CALL_BASECRYPTLIB (TlsGet.Services.SessionReused, TlsIsSessionReused, (Tls), FALSE);
+}
+
 /**
   Gets the client random data used in the specified TLS connection.
 
@@ -4663,5 +4742,9 @@ const EDKII_CRYPTO_PROTOCOL mEdkiiCrypto = {
   CryptoServiceTlsGetCaCertificate,
   CryptoServiceTlsGetHostPublicCert,
   CryptoServiceTlsGetHostPrivateKey,
-  CryptoServiceTlsGetCertRevocationList
+  CryptoServiceTlsGetCertRevocationList,
+  /// TLS Session
+  CryptoServiceTlsSetSession,
+  CryptoServiceTlsGetSession,
+  CryptoServiceTlsIsSessionReused
 };
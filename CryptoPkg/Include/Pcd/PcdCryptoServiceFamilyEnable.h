@@ -267,6 +267,7 @@ typedef struct {
       UINT8  HostPublicCert:1;
       UINT8  HostPrivateKey:1;
       UINT8  CertRevocationList:1;
+      UINT8  Session:1;
     } Services;
     UINT32    Family;
   } TlsSet;
@@ -285,6 +286,8 @@ typedef struct {
       UINT8  HostPublicCert:1;
       UINT8  HostPrivateKey:1;
       UINT8  CertRevocationList:1;
+      UINT8  Session:1;
+      UINT8  SessionReused:1;
     } Services;
     UINT32    Family;
   } TlsGet;
@@ -596,6 +596,64 @@ TlsSetSessionId (
   return EFI_SUCCESS;
 }
 
+/**
+  Sets a TLS/SSL session to be resumed during TLS/SSL connect.
+
+  This function sets a session saved by TlsGetSession() from a previous
+  connection to the same server, so that the TLS/SSL connection to be
+  established resumes it with an abbreviated handshake, by session ID or by
+  session ticket. The server may still decline it, in which case a full
+  handshake takes place.
+
+  @param[in]  Tls               Pointer to the TLS object.
+  @param[in]  SessionData       Session data returned by TlsGetSession().
+  @param[in]  SessionDataSize   Size of session data in bytes.
+
+  @retval  EFI_SUCCESS           Session was set successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_UNSUPPORTED       The handshake has already started.
+  @retval  EFI_ABORTED           Invalid session data.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsSetSession (
+  IN     VOID                     *Tls,
+  IN     CONST UINT8              *SessionData,
+  IN     UINTN                    SessionDataSize
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  SSL_SESSION     *Session;
+  CONST UINT8     *Pointer;
+  INTN            Ret;
+
+  TlsConn = (TLS_CONNECTION *) Tls;
+
+  if (TlsConn == NULL || TlsConn->Ssl == NULL || SessionData == NULL ||
+      SessionDataSize == 0 || SessionDataSize > MAX_INT32) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!SSL_in_before (TlsConn->Ssl)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Pointer = SessionData;
+  Session = d2i_SSL_SESSION (NULL, &Pointer, (long) SessionDataSize);
+  if (Session == NULL) {
+    return EFI_ABORTED;
+  }
+
+  //
+  // SSL_set_session() takes its own reference of the session.
+  //
+  Ret = SSL_set_session (TlsConn->Ssl, Session);
+  SSL_SESSION_free (Session);
+
+  return (Ret == 1) ? EFI_SUCCESS : EFI_ABORTED;
+}
+
 /**
   Adds the CA to the cert store when requesting Server or Client authentication.
 
@@ -1033,6 +1091,92 @@ TlsGetSessionId (
   return EFI_SUCCESS;
 }
 
+/**
+  Gets the session of the specified TLS connection, for resumption.
+
+  This function returns the TLS/SSL session established by the specified TLS
+  connection, including the master secret and the session ticket if any, so
+  that it can be set by TlsSetSession() on a later connection to the same
+  server.
+
+  @param[in]      Tls               Pointer to the TLS object.
+  @param[out]     SessionData       Buffer to contain the returned session data.
+  @param[in,out]  SessionDataSize   The size of SessionData buffer in bytes. On
+                                    output, the size of session data.
+
+  @retval  EFI_SUCCESS           The session was returned successfully.
+  @retval  EFI_INVALID_PARAMETER The parameter is invalid.
+  @retval  EFI_UNSUPPORTED       No resumable session is established.
+  @retval  EFI_BUFFER_TOO_SMALL  The SessionData is too small to hold the session.
+
+**/
+EFI_STATUS
+EFIAPI
+TlsGetSession (
+  IN     VOID                     *Tls,
+  OUT    UINT8                    *SessionData,  OPTIONAL
+  IN OUT UINTN                    *SessionDataSize
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+  SSL_SESSION     *Session;
+  UINT8           *Pointer;
+  INTN            Length;
+
+  TlsConn = (TLS_CONNECTION *) Tls;
+
+  if (TlsConn == NULL || TlsConn->Ssl == NULL || SessionDataSize == NULL ||
+      (SessionData == NULL && *SessionDataSize != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Session = SSL_get_session (TlsConn->Ssl);
+  if (Session == NULL || !SSL_SESSION_is_resumable (Session)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Length = i2d_SSL_SESSION (Session, NULL);
+  if (Length <= 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (*SessionDataSize < (UINTN) Length) {
+    *SessionDataSize = (UINTN) Length;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Pointer = SessionData;
+  *SessionDataSize = (UINTN) i2d_SSL_SESSION (Session, &Pointer);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Checks if the handshake of the specified TLS connection resumed a session
+  set by TlsSetSession().
+
+  @param[in]  Tls    Pointer to the TLS object.
+
+  @retval  TRUE     The session was resumed.
+  @retval  FALSE    A full handshake took place, or hasn't completed yet.
+
+**/
+BOOLEAN
+EFIAPI
+TlsIsSessionReused (
+  IN     VOID                     *Tls
+  )
+{
+  TLS_CONNECTION  *TlsConn;
+
+  TlsConn = (TLS_CONNECTION *) Tls;
+  if (TlsConn == NULL || TlsConn->Ssl == NULL) {
+    return FALSE;
+  }
+
+  return (BOOLEAN) (SSL_session_reused (TlsConn->Ssl) == 1);
+}
+
 /**
   Gets the client random data used in the specified TLS connection.
 
@@ -620,6 +620,85 @@ DumpMemoryProfileMemoryRange (
   return (VOID *) Descriptor;
 }
 
+/**
+  Dump memory profile pool statistics information.
+
+  @param[in] PoolStatisticsIndex  Memory profile pool statistics index.
+  @param[in] PoolStatistics       Pointer to memory profile pool statistics.
+
+  @return Pointer to next memory profile pool statistics.
+
+**/
+MEMORY_PROFILE_POOL_STATISTICS *
+DumpMemoryProfilePoolStatistics (
+  IN UINTN                          PoolStatisticsIndex,
+  IN MEMORY_PROFILE_POOL_STATISTICS *PoolStatistics
+  )
+{
+  if (PoolStatistics->Header.Signature != MEMORY_PROFILE_POOL_STATISTICS_SIGNATURE) {
+    return NULL;
+  }
+  Print (L"  MEMORY_PROFILE_POOL_STATISTICS (0x%x)\n", PoolStatisticsIndex);
+  Print (L"    Signature               - 0x%08x\n", PoolStatistics->Header.Signature);
+  Print (L"    Length                  - 0x%04x\n", PoolStatistics->Header.Length);
+  Print (L"    Revision                - 0x%04x\n", PoolStatistics->Header.Revision);
+  if (PoolStatistics->ApicId == MEMORY_PROFILE_POOL_NO_CACHE_APIC_ID) {
+    Print (L"    ApicId                  - (NoPoolCache)\n");
+  } else {
+    Print (L"    ApicId                  - 0x%08x\n", PoolStatistics->ApicId);
+    Print (L"    CachedSize              - 0x%016lx\n", PoolStatistics->CachedSize);
+    Print (L"    PeakCachedSize          - 0x%016lx\n", PoolStatistics->PeakCachedSize);
+  }
+  Print (L"    AllocateCount           - 0x%016lx\n", PoolStatistics->AllocateCount);
+  Print (L"    CacheHitCount           - 0x%016lx\n", PoolStatistics->CacheHitCount);
+  Print (L"    FreeCount               - 0x%016lx\n", PoolStatistics->FreeCount);
+  Print (L"    RemoteFreeCount         - 0x%016lx\n", PoolStatistics->RemoteFreeCount);
+  Print (L"    AllocateTicks           - 0x%016lx\n", PoolStatistics->AllocateTicks);
+  Print (L"    MaxAllocateTicks        - 0x%016lx\n", PoolStatistics->MaxAllocateTicks);
+  Print (L"    FreeTicks               - 0x%016lx\n", PoolStatistics->FreeTicks);
+  Print (L"    MaxFreeTicks            - 0x%016lx\n", PoolStatistics->MaxFreeTicks);
+
+  return (MEMORY_PROFILE_POOL_STATISTICS *) ((UINTN) PoolStatistics + PoolStatistics->Header.Length);
+}
+
+/**
+  Dump memory profile pool usage information.
+
+  @param[in] PoolUsage          Pointer to memory profile pool usage.
+
+  @return Pointer to the end of memory profile pool usage buffer.
+
+**/
+VOID *
+DumpMemoryProfilePoolUsage (
+  IN MEMORY_PROFILE_POOL_USAGE      *PoolUsage
+  )
+{
+  MEMORY_PROFILE_POOL_STATISTICS  *PoolStatistics;
+  UINTN                           PoolStatisticsIndex;
+
+  if (PoolUsage->Header.Signature != MEMORY_PROFILE_POOL_USAGE_SIGNATURE) {
+    return NULL;
+  }
+  Print (L"MEMORY_PROFILE_POOL_USAGE\n");
+  Print (L"  Signature                     - 0x%08x\n", PoolUsage->Header.Signature);
+  Print (L"  Length                        - 0x%04x\n", PoolUsage->Header.Length);
+  Print (L"  Revision                      - 0x%04x\n", PoolUsage->Header.Revision);
+  Print (L"  CurrentSize                   - 0x%016lx\n", PoolUsage->CurrentSize);
+  Print (L"  PeakSize                      - 0x%016lx\n", PoolUsage->PeakSize);
+  Print (L"  PoolStatisticsCount           - 0x%08x\n", PoolUsage->PoolStatisticsCount);
+
+  PoolStatistics = (MEMORY_PROFILE_POOL_STATISTICS *) ((UINTN) PoolUsage + PoolUsage->Header.Length);
+  for (PoolStatisticsIndex = 0; PoolStatisticsIndex < PoolUsage->PoolStatisticsCount; PoolStatisticsIndex++) {
+    PoolStatistics = DumpMemoryProfilePoolStatistics (PoolStatisticsIndex, PoolStatistics);
+    if (PoolStatistics == NULL) {
+      return NULL;
+    }
+  }
+
+  return (VOID *) PoolStatistics;
+}
+
 /**
   Scan memory profile by Signature.
 
@@ -678,6 +757,7 @@ DumpMemoryProfile (
   MEMORY_PROFILE_CONTEXT        *Context;
   MEMORY_PROFILE_FREE_MEMORY    *FreeMemory;
   MEMORY_PROFILE_MEMORY_RANGE   *MemoryRange;
+  MEMORY_PROFILE_POOL_USAGE     *PoolUsage;
 
   Context = (MEMORY_PROFILE_CONTEXT *) ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_CONTEXT_SIGNATURE);
   if (Context != NULL) {
@@ -693,6 +773,11 @@ DumpMemoryProfile (
   if (MemoryRange != NULL) {
     DumpMemoryProfileMemoryRange (MemoryRange);
   }
+
+  PoolUsage = (MEMORY_PROFILE_POOL_USAGE *) ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_POOL_USAGE_SIGNATURE);
+  if (PoolUsage != NULL) {
+    DumpMemoryProfilePoolUsage (PoolUsage);
+  }
 }
 
 /**
@@ -0,0 +1,163 @@
+/** @file
+  A shell application to measure the cost of getting dynamic-ex PCDs.
+
+  Every dynamic-ex PCD in the PCD database is read through LibPcdGetExSize()
+  and the LibPcdGetEx*() function matching its type many times. Both go
+  through the {token space guid:token number} to token number translation of
+  the PCD driver, which dominates the cost for small PCDs.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <PiDxe.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include <Protocol/PiPcd.h>
+#include <Protocol/PiPcdInfo.h>
+
+#define PCD_EX_BENCHMARK_ITERATIONS  10000
+
+static EFI_PCD_PROTOCOL                *mPiPcd             = NULL;
+static EFI_GET_PCD_INFO_PROTOCOL       *mPiPcdInfo         = NULL;
+
+/**
+  Get a dynamic-ex PCD through the LibPcdGetEx*() function of its type.
+
+  @param[in]    TokenSpace      PCD Token Space.
+  @param[in]    TokenNumber     PCD Token Number.
+  @param[in]    PcdType         PCD type.
+**/
+static
+VOID
+GetExPcd (
+  IN CONST EFI_GUID     *TokenSpace,
+  IN UINTN              TokenNumber,
+  IN EFI_PCD_TYPE       PcdType
+  )
+{
+  switch (PcdType) {
+    case EFI_PCD_TYPE_8:
+      LibPcdGetEx8 (TokenSpace, TokenNumber);
+      break;
+    case EFI_PCD_TYPE_16:
+      LibPcdGetEx16 (TokenSpace, TokenNumber);
+      break;
+    case EFI_PCD_TYPE_32:
+      LibPcdGetEx32 (TokenSpace, TokenNumber);
+      break;
+    case EFI_PCD_TYPE_64:
+      LibPcdGetEx64 (TokenSpace, TokenNumber);
+      break;
+    case EFI_PCD_TYPE_BOOL:
+      LibPcdGetExBool (TokenSpace, TokenNumber);
+      break;
+    default:
+      LibPcdGetExPtr (TokenSpace, TokenNumber);
+      break;
+  }
+}
+
+/**
+  Measure the time to get every dynamic-ex PCD.
+
+  @param[in]    TokenSpace      PCD Token Space.
+  @param[in]    TokenNumber     PCD Token Number.
+**/
+static
+VOID
+BenchmarkExPcd (
+  IN CONST EFI_GUID     *TokenSpace,
+  IN UINTN              TokenNumber
+  )
+{
+  EFI_PCD_INFO          PcdInfo;
+  UINTN                 Index;
+  UINT64                Start;
+  UINT64                SizeTime;
+  UINT64                GetTime;
+
+  mPiPcdInfo->GetInfo (TokenSpace, TokenNumber, &PcdInfo);
+
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < PCD_EX_BENCHMARK_ITERATIONS; Index++) {
+    LibPcdGetExSize (TokenSpace, TokenNumber);
+  }
+  SizeTime = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < PCD_EX_BENCHMARK_ITERATIONS; Index++) {
+    GetExPcd (TokenSpace, TokenNumber, PcdInfo.PcdType);
+  }
+  GetTime = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+
+  Print (
+    L"%g 0x%08x %6ld %6ld  %a\n",
+    TokenSpace,
+    TokenNumber,
+    DivU64x32 (SizeTime, PCD_EX_BENCHMARK_ITERATIONS),
+    DivU64x32 (GetTime, PCD_EX_BENCHMARK_ITERATIONS),
+    PcdInfo.PcdName == NULL ? "" : PcdInfo.PcdName
+    );
+}
+
+/**
+  Main entrypoint for PcdExBenchmark shell application.
+
+  @param[in]  ImageHandle     The image handle.
+  @param[in]  SystemTable     The system table.
+
+  @retval EFI_SUCCESS            Command completed successfully.
+  @retval Others                 Error status returned from gBS->LocateProtocol.
+**/
+EFI_STATUS
+EFIAPI
+PcdExBenchmarkMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS            Status;
+  EFI_GUID              *TokenSpace;
+  UINTN                 TokenNumber;
+
+  Status = gBS->LocateProtocol (&gEfiPcdProtocolGuid, NULL, (VOID **) &mPiPcd);
+  if (EFI_ERROR (Status)) {
+    Print (L"PcdExBenchmark: %EError. %NPI PCD protocol is not present.\n");
+    return Status;
+  }
+
+  Status = gBS->LocateProtocol (&gEfiGetPcdInfoProtocolGuid, NULL, (VOID **) &mPiPcdInfo);
+  if (EFI_ERROR (Status)) {
+    Print (L"PcdExBenchmark: %EError. %NPI PCD info protocol is not present.\n");
+    return Status;
+  }
+
+  Print (L"Average time of %d calls in nanoseconds\n", PCD_EX_BENCHMARK_ITERATIONS);
+  Print (L"%-36s %-10s %6s %6s  %s\n", L"TokenSpace", L"Token", L"Size", L"Get", L"Name");
+
+  //
+  // The default token space (NULL) only holds dynamic PCDs, start from the
+  // first dynamic-ex token space.
+  //
+  TokenSpace = NULL;
+  Status = mPiPcd->GetNextTokenSpace ((CONST EFI_GUID **) &TokenSpace);
+  while (!EFI_ERROR (Status) && TokenSpace != NULL) {
+    TokenNumber = 0;
+    Status = mPiPcd->GetNextToken (TokenSpace, &TokenNumber);
+    while (!EFI_ERROR (Status) && TokenNumber != 0) {
+      BenchmarkExPcd (TokenSpace, TokenNumber);
+      Status = mPiPcd->GetNextToken (TokenSpace, &TokenNumber);
+    }
+
+    Status = mPiPcd->GetNextTokenSpace ((CONST EFI_GUID **) &TokenSpace);
+  }
+
+  return EFI_SUCCESS;
+}
@@ -28,6 +28,9 @@ CHAR8 mNameString[PROFILE_NAME_STRING_LENGTH + 1];
 VOID   *mSmiHandlerProfileDatabase;
 UINTN  mSmiHandlerProfileDatabaseSize;
 
+VOID   *mSmiHandlerLatencyDatabase;
+UINTN  mSmiHandlerLatencyDatabaseSize;
+
 /**
   This function dump raw data.
 
@@ -50,11 +53,22 @@ InternalDumpData (
 }
 
 /**
-  Get SMI handler profile database.
+  Get SMI handler profile data.
+
+  @param[in]  GetInfoCommand  The command to get the data size.
+  @param[in]  GetDataCommand  The command to get the data by offset.
+  @param[in]  Optional        TRUE if the SMM Core may not support the data, so the
+                              failure to get the data size is not printed.
+  @param[out] DataSize        The size of the data.
+
+  @return The data allocated from pool, or NULL if the data cannot be got.
 **/
-VOID
-GetSmiHandlerProfileDatabase(
-  VOID
+VOID *
+GetSmiHandlerProfileData (
+  IN  UINT32  GetInfoCommand,
+  IN  UINT32  GetDataCommand,
+  IN  BOOLEAN Optional,
+  OUT UINTN   *DataSize
   )
 {
   EFI_STATUS                                          Status;
@@ -71,11 +85,14 @@ GetSmiHandlerProfileDatabase(
   VOID                                                *Buffer;
   UINTN                                               Size;
   UINTN                                               Offset;
+  VOID                                                *Data;
+
+  *DataSize = 0;
 
   Status = gBS->LocateProtocol(&gEfiSmmCommunicationProtocolGuid, NULL, (VOID **)&SmmCommunication);
   if (EFI_ERROR(Status)) {
     Print(L"SmiHandlerProfile: Locate SmmCommunication protocol - %r\n", Status);
-    return ;
+    return NULL;
   }
 
   MinimalSizeNeeded = EFI_PAGE_SIZE;
@@ -86,7 +103,7 @@ GetSmiHandlerProfileDatabase(
              );
   if (EFI_ERROR(Status)) {
     Print(L"SmiHandlerProfile: Get PiSmmCommunicationRegionTable - %r\n", Status);
-    return ;
+    return NULL;
   }
   ASSERT(PiSmmCommunicationRegionTable != NULL);
   Entry = (EFI_MEMORY_DESCRIPTOR *)(PiSmmCommunicationRegionTable + 1);
@@ -111,7 +128,7 @@ GetSmiHandlerProfileDatabase(
   CommHeader->MessageLength = sizeof(SMI_HANDLER_PROFILE_PARAMETER_GET_INFO);
 
   CommGetInfo = (SMI_HANDLER_PROFILE_PARAMETER_GET_INFO *)&CommBuffer[OFFSET_OF(EFI_SMM_COMMUNICATE_HEADER, Data)];
-  CommGetInfo->Header.Command = SMI_HANDLER_PROFILE_COMMAND_GET_INFO;
+  CommGetInfo->Header.Command = GetInfoCommand;
   CommGetInfo->Header.DataLength = sizeof(*CommGetInfo);
   CommGetInfo->Header.ReturnStatus = (UINT64)-1;
   CommGetInfo->DataSize = 0;
@@ -120,24 +137,27 @@ GetSmiHandlerProfileDatabase(
   Status = SmmCommunication->Communicate(SmmCommunication, CommBuffer, &CommSize);
   if (EFI_ERROR(Status)) {
     Print(L"SmiHandlerProfile: SmmCommunication - %r\n", Status);
-    return ;
+    return NULL;
   }
 
   if (CommGetInfo->Header.ReturnStatus != 0) {
-    Print(L"SmiHandlerProfile: GetInfo - 0x%0x\n", CommGetInfo->Header.ReturnStatus);
-    return ;
+    if (!Optional) {
+      Print(L"SmiHandlerProfile: GetInfo - 0x%0x\n", CommGetInfo->Header.ReturnStatus);
+    }
+    return NULL;
   }
 
-  mSmiHandlerProfileDatabaseSize = (UINTN)CommGetInfo->DataSize;
+  *DataSize = (UINTN)CommGetInfo->DataSize;
 
   //
   // Get Data
   //
-  mSmiHandlerProfileDatabase = AllocateZeroPool(mSmiHandlerProfileDatabaseSize);
-  if (mSmiHandlerProfileDatabase == NULL) {
+  Data = AllocateZeroPool(*DataSize);
+  if (Data == NULL) {
     Status = EFI_OUT_OF_RESOURCES;
-    Print(L"SmiHandlerProfile: AllocateZeroPool (0x%x) for dump buffer - %r\n", mSmiHandlerProfileDatabaseSize, Status);
-    return ;
+    Print(L"SmiHandlerProfile: AllocateZeroPool (0x%x) for dump buffer - %r\n", *DataSize, Status);
+    *DataSize = 0;
+    return NULL;
   }
 
   CommHeader = (EFI_SMM_COMMUNICATE_HEADER *)&CommBuffer[0];
@@ -145,7 +165,7 @@ GetSmiHandlerProfileDatabase(
   CommHeader->MessageLength = sizeof(SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET);
 
   CommGetData = (SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET *)&CommBuffer[OFFSET_OF(EFI_SMM_COMMUNICATE_HEADER, Data)];
-  CommGetData->Header.Command = SMI_HANDLER_PROFILE_COMMAND_GET_DATA_BY_OFFSET;
+  CommGetData->Header.Command = GetDataCommand;
   CommGetData->Header.DataLength = sizeof(*CommGetData);
   CommGetData->Header.ReturnStatus = (UINT64)-1;
 
@@ -155,27 +175,60 @@ GetSmiHandlerProfileDatabase(
 
   CommGetData->DataBuffer = (PHYSICAL_ADDRESS)(UINTN)Buffer;
   CommGetData->DataOffset = 0;
-  while (CommGetData->DataOffset < mSmiHandlerProfileDatabaseSize) {
+  while (CommGetData->DataOffset < *DataSize) {
     Offset = (UINTN)CommGetData->DataOffset;
-    if (Size <= (mSmiHandlerProfileDatabaseSize - CommGetData->DataOffset)) {
+    if (Size <= (*DataSize - CommGetData->DataOffset)) {
       CommGetData->DataSize = (UINT64)Size;
     } else {
-      CommGetData->DataSize = (UINT64)(mSmiHandlerProfileDatabaseSize - CommGetData->DataOffset);
+      CommGetData->DataSize = (UINT64)(*DataSize - CommGetData->DataOffset);
     }
     Status = SmmCommunication->Communicate(SmmCommunication, CommBuffer, &CommSize);
     ASSERT_EFI_ERROR(Status);
 
     if (CommGetData->Header.ReturnStatus != 0) {
-      FreePool(mSmiHandlerProfileDatabase);
-      mSmiHandlerProfileDatabase = NULL;
+      FreePool(Data);
+      *DataSize = 0;
       Print(L"SmiHandlerProfile: GetData - 0x%x\n", CommGetData->Header.ReturnStatus);
-      return ;
+      return NULL;
     }
-    CopyMem((UINT8 *)mSmiHandlerProfileDatabase + Offset, (VOID *)(UINTN)CommGetData->DataBuffer, (UINTN)CommGetData->DataSize);
+    CopyMem((UINT8 *)Data + Offset, (VOID *)(UINTN)CommGetData->DataBuffer, (UINTN)CommGetData->DataSize);
+  }
+
+  return Data;
+}
+
+/**
+  Get SMI handler profile database.
+**/
+VOID
+GetSmiHandlerProfileDatabase(
+  VOID
+  )
+{
+  mSmiHandlerProfileDatabase = GetSmiHandlerProfileData (
+                                 SMI_HANDLER_PROFILE_COMMAND_GET_INFO,
+                                 SMI_HANDLER_PROFILE_COMMAND_GET_DATA_BY_OFFSET,
+                                 FALSE,
+                                 &mSmiHandlerProfileDatabaseSize
+                                 );
+  if (mSmiHandlerProfileDatabase == NULL) {
+    return ;
   }
 
   DEBUG ((DEBUG_INFO, "SmiHandlerProfileSize - 0x%x\n", mSmiHandlerProfileDatabaseSize));
 
+  //
+  // The latency database is optional.
+  //
+  mSmiHandlerLatencyDatabase = GetSmiHandlerProfileData (
+                                 SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_INFO,
+                                 SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_DATA_BY_OFFSET,
+                                 TRUE,
+                                 &mSmiHandlerLatencyDatabaseSize
+                                 );
+
+  DEBUG ((DEBUG_INFO, "SmiHandlerLatencySize - 0x%x\n", mSmiHandlerLatencyDatabaseSize));
+
   return ;
 }
 
@@ -564,6 +617,50 @@ DumpSmiChildContext (
   }
 }
 
+/**
+  Dump the latency of an SMI handler.
+
+  @param HandlerCategory   SMI handler category
+  @param HandlerType       SMI handler type
+  @param SmiHandlerStruct  SMI handler
+**/
+VOID
+DumpSmiHandlerLatency (
+  IN UINT32                          HandlerCategory,
+  IN EFI_GUID                        *HandlerType,
+  IN SMM_CORE_SMI_HANDLER_STRUCTURE  *SmiHandlerStruct
+  )
+{
+  SMM_CORE_SMI_LATENCY_DATABASE_STRUCTURE  *LatencyStruct;
+  UINTN                                    Index;
+
+  LatencyStruct = (VOID *)mSmiHandlerLatencyDatabase;
+  while ((UINTN)LatencyStruct < (UINTN)mSmiHandlerLatencyDatabase + mSmiHandlerLatencyDatabaseSize) {
+    if ((LatencyStruct->Header.Signature == SMM_CORE_SMI_LATENCY_DATABASE_SIGNATURE) &&
+        (LatencyStruct->HandlerCategory == HandlerCategory) &&
+        (LatencyStruct->Handler == SmiHandlerStruct->Handler) &&
+        (LatencyStruct->CallerAddr == SmiHandlerStruct->CallerAddr) &&
+        CompareGuid (&LatencyStruct->HandlerType, HandlerType)) {
+      Print(L"      <Latency DispatchCount=\"0x%lx\"", LatencyStruct->DispatchCount);
+      if (LatencyStruct->DispatchCount != 0) {
+        Print(L" MinTicks=\"0x%lx\"", LatencyStruct->MinTicks);
+        Print(L" AvgTicks=\"0x%lx\"", DivU64x64Remainder (LatencyStruct->TotalTicks, LatencyStruct->DispatchCount, NULL));
+        Print(L" P99Ticks=\"0x%lx\"", LatencyStruct->P99Ticks);
+        Print(L" MaxTicks=\"0x%lx\"", LatencyStruct->MaxTicks);
+      }
+      Print(L">\n");
+      for (Index = 0; Index < SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT; Index++) {
+        if (LatencyStruct->Histogram[Index] != 0) {
+          Print(L"         <Histogram Ticks=\"0x%lx\" Count=\"0x%lx\" />\n", LShiftU64 (1, Index), LatencyStruct->Histogram[Index]);
+        }
+      }
+      Print(L"      </Latency>\n");
+      return;
+    }
+    LatencyStruct = (VOID *)((UINTN)LatencyStruct + LatencyStruct->Header.Length);
+  }
+}
+
 /**
   Dump SMI handler in HandlerCategory.
 
@@ -612,6 +709,7 @@ DumpSmiHandler(
           Print(L"         <RVA>0x%x</RVA>\n", (UINTN) (SmiHandlerStruct->CallerAddr - ImageStruct->ImageBase));
         }
         Print(L"      </Caller>\n", SmiHandlerStruct->Handler);
+        DumpSmiHandlerLatency (HandlerCategory, &SmiStruct->HandlerType, SmiHandlerStruct);
         SmiHandlerStruct = (VOID *)((UINTN)SmiHandlerStruct + SmiHandlerStruct->Length);
         Print(L"    </SmiHandler>\n");
       }
@@ -681,6 +779,9 @@ SmiHandlerProfileInfoEntrypoint (
   if (mSmiHandlerProfileDatabase != NULL) {
     FreePool(mSmiHandlerProfileDatabase);
   }
+  if (mSmiHandlerLatencyDatabase != NULL) {
+    FreePool(mSmiHandlerLatencyDatabase);
+  }
 
   return EFI_SUCCESS;
 }
@@ -1,7 +1,10 @@
 /** @file
   If the Variable services have PcdVariableCollectStatistics set to TRUE then
   this utility will print out the statistics information. You can use console
-  redirection to capture the data.
+  redirection to capture the data. With the SMM variable driver and the -b
+  switch, it also prints the number of SMIs taken to enumerate all the variables,
+  one variable per SMI and in batches. That reads every variable, so it adds to
+  the read counts of the statistics.
 
   Copyright (c) 2006 - 2019, Intel Corporation. All rights reserved.<BR>
   SPDX-License-Identifier: BSD-2-Clause-Patent
@@ -16,14 +19,17 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/TimerLib.h>
 
 #include <Guid/VariableFormat.h>
 #include <Guid/SmmVariableCommon.h>
 #include <Guid/PiSmmCommunicationRegionTable.h>
 #include <Protocol/MmCommunication2.h>
 #include <Protocol/SmmVariable.h>
+#include <Protocol/ShellParameters.h>
 
 EFI_MM_COMMUNICATION2_PROTOCOL  *mMmCommunication2 = NULL;
+BOOLEAN                         mEnumerationBenchmark = FALSE;
 
 /**
   This function get the variable statistics data from SMM variable driver.
@@ -64,6 +70,176 @@ GetVariableStatisticsData (
   return Status;
 }
 
+/**
+  This function sends the SMM variable function in the communicate buffer to SMM variable driver.
+
+  @param[in, out] SmmCommunicateHeader The communicate buffer, with the payload of the function.
+  @param[in]      SmmCommunicateSize   The size of the SmmCommunicateHeader.
+  @param[in]      Function             The SMM variable function.
+
+  @return The status returned by the SMM variable function.
+
+**/
+EFI_STATUS
+SendSmmVariableFunction (
+  IN OUT  EFI_MM_COMMUNICATE_HEADER   *SmmCommunicateHeader,
+  IN      UINTN                       SmmCommunicateSize,
+  IN      UINTN                       Function
+  )
+{
+  EFI_STATUS                          Status;
+  SMM_VARIABLE_COMMUNICATE_HEADER     *SmmVariableFunctionHeader;
+
+  CopyGuid (&SmmCommunicateHeader->HeaderGuid, &gEfiSmmVariableProtocolGuid);
+  SmmCommunicateHeader->MessageLength = SmmCommunicateSize - OFFSET_OF (EFI_MM_COMMUNICATE_HEADER, Data);
+
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) &SmmCommunicateHeader->Data[0];
+  SmmVariableFunctionHeader->Function     = Function;
+  SmmVariableFunctionHeader->ReturnStatus = EFI_UNSUPPORTED;
+
+  Status = mMmCommunication2->Communicate (mMmCommunication2,
+                                           SmmCommunicateHeader,
+                                           SmmCommunicateHeader,
+                                           &SmmCommunicateSize);
+  ASSERT_EFI_ERROR (Status);
+
+  return SmmVariableFunctionHeader->ReturnStatus;
+}
+
+/**
+  This function enumerates all the variables with SMM variable driver, first getting the name
+  and the data of one variable per SMI, then getting the variables in batches. It prints the
+  number of SMIs and the time taken by both ways.
+
+  @param[in] CommBuffer             The communicate buffer.
+  @param[in] CommBufferSize         The size of the communicate buffer.
+
+**/
+VOID
+PrintVariableEnumerationFromSmm (
+  IN EFI_MM_COMMUNICATE_HEADER      *CommBuffer,
+  IN UINTN                          CommBufferSize
+  )
+{
+  EFI_STATUS                                        Status;
+  SMM_VARIABLE_COMMUNICATE_HEADER                   *FunctionHeader;
+  SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE         *GetPayloadSize;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME   *GetNextVariableName;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE          *AccessVariable;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH  *GetNextVariableBatch;
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY     *BatchEntry;
+  UINTN                                             PayloadSize;
+  UINTN                                             CommSize;
+  CHAR16                                            *VariableName;
+  UINTN                                             VariableNameSize;
+  EFI_GUID                                          VendorGuid;
+  UINTN                                             Index;
+  UINTN                                             VariableCount;
+  UINTN                                             SmiCount;
+  UINT64                                            StartTicks;
+  UINT64                                            Time;
+
+  FunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) CommBuffer->Data;
+
+  //
+  // The payload of the functions except GetNextVariableBatch is limited by SMM variable driver.
+  //
+  ZeroMem (CommBuffer, CommBufferSize);
+  CommSize = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + sizeof (SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE);
+  Status = SendSmmVariableFunction (CommBuffer, CommSize, SMM_VARIABLE_FUNCTION_GET_PAYLOAD_SIZE);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+  GetPayloadSize = (SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE *) FunctionHeader->Data;
+  PayloadSize    = MIN (GetPayloadSize->VariablePayloadSize, CommBufferSize - SMM_COMMUNICATE_HEADER_SIZE - SMM_VARIABLE_COMMUNICATE_HEADER_SIZE);
+  CommSize       = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize;
+
+  VariableName = AllocateZeroPool (CommBufferSize);
+  if (VariableName == NULL) {
+    return;
+  }
+
+  Print (L"SMM Driver Variable Enumeration:\n");
+
+  //
+  // Get the name and the data of one variable per SMI.
+  //
+  VariableCount = 0;
+  SmiCount      = 0;
+  ZeroMem (&VendorGuid, sizeof (VendorGuid));
+  StartTicks = GetPerformanceCounter ();
+  do {
+    ZeroMem (FunctionHeader->Data, PayloadSize);
+    GetNextVariableName = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME *) FunctionHeader->Data;
+    CopyGuid (&GetNextVariableName->Guid, &VendorGuid);
+    GetNextVariableName->NameSize = PayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME, Name);
+    StrCpyS (GetNextVariableName->Name, GetNextVariableName->NameSize / sizeof (CHAR16), VariableName);
+    Status = SendSmmVariableFunction (CommBuffer, CommSize, SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME);
+    SmiCount++;
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    CopyGuid (&VendorGuid, &GetNextVariableName->Guid);
+    CopyMem (VariableName, GetNextVariableName->Name, GetNextVariableName->NameSize);
+    VariableNameSize = StrSize (VariableName);
+
+    AccessVariable = (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE *) FunctionHeader->Data;
+    CopyGuid (&AccessVariable->Guid, &VendorGuid);
+    AccessVariable->NameSize   = VariableNameSize;
+    AccessVariable->DataSize   = PayloadSize - OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name) - VariableNameSize;
+    AccessVariable->Attributes = 0;
+    CopyMem (AccessVariable->Name, VariableName, VariableNameSize);
+    SendSmmVariableFunction (CommBuffer, CommSize, SMM_VARIABLE_FUNCTION_GET_VARIABLE);
+    SmiCount++;
+    VariableCount++;
+  } while (TRUE);
+  Time = GetTimeInNanoSecond (GetPerformanceCounter () - StartTicks);
+  Print (L"  Per variable: %d variables, %d SMIs, %ld us\n", VariableCount, SmiCount, DivU64x32 (Time, 1000));
+
+  //
+  // Get the variables in batches, as many as fit in the communicate buffer per SMI.
+  //
+  VariableCount = 0;
+  SmiCount      = 0;
+  ZeroMem (VariableName, CommBufferSize);
+  ZeroMem (&VendorGuid, sizeof (VendorGuid));
+  PayloadSize = CommBufferSize - SMM_COMMUNICATE_HEADER_SIZE - SMM_VARIABLE_COMMUNICATE_HEADER_SIZE;
+  StartTicks  = GetPerformanceCounter ();
+  do {
+    GetNextVariableBatch = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH *) FunctionHeader->Data;
+    CopyGuid (&GetNextVariableBatch->Guid, &VendorGuid);
+    GetNextVariableBatch->NameSize = StrSize (VariableName);
+    CopyMem (GetNextVariableBatch->Name, VariableName, GetNextVariableBatch->NameSize);
+    Status = SendSmmVariableFunction (CommBuffer, CommBufferSize, SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_BATCH);
+    SmiCount++;
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    BatchEntry = (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY *) ((UINT8 *) GetNextVariableBatch +
+                   SMM_VARIABLE_BATCH_ENTRY_OFFSET (GetNextVariableBatch->NameSize));
+    for (Index = 1; Index < GetNextVariableBatch->VariableCount; Index++) {
+      BatchEntry = (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY *) ((UINT8 *) BatchEntry + BatchEntry->EntrySize);
+    }
+    VariableCount += GetNextVariableBatch->VariableCount;
+
+    //
+    // The last variable of the batch is the cursor of the next batch.
+    //
+    CopyGuid (&VendorGuid, &BatchEntry->Guid);
+    CopyMem (VariableName, BatchEntry + 1, BatchEntry->NameSize);
+  } while (TRUE);
+  Time = GetTimeInNanoSecond (GetPerformanceCounter () - StartTicks);
+
+  if (Status == EFI_NOT_FOUND) {
+    Print (L"  Batched:      %d variables, %d SMIs, %ld us\n", VariableCount, SmiCount, DivU64x32 (Time, 1000));
+  } else {
+    Print (L"  Batched:      %r after %d variables\n", Status, VariableCount);
+  }
+
+  FreePool (VariableName);
+}
+
 /**
 
   This function get and print the variable statistics data from SMM variable driver.
@@ -188,6 +364,10 @@ PrintInfoFromSmm (
     }
   } while (TRUE);
 
+  if (mEnumerationBenchmark) {
+    PrintVariableEnumerationFromSmm (CommBuffer, RealCommSize);
+  }
+
   return Status;
 }
 
@@ -210,10 +390,28 @@ UefiMain (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  EFI_STATUS            RuntimeDxeStatus;
-  EFI_STATUS            SmmStatus;
-  VARIABLE_INFO_ENTRY   *VariableInfo;
-  VARIABLE_INFO_ENTRY   *Entry;
+  EFI_STATUS                     RuntimeDxeStatus;
+  EFI_STATUS                     SmmStatus;
+  VARIABLE_INFO_ENTRY            *VariableInfo;
+  VARIABLE_INFO_ENTRY            *Entry;
+  EFI_SHELL_PARAMETERS_PROTOCOL  *ShellParameters;
+  UINTN                          Index;
+
+  //
+  // -b also benchmarks the variable enumeration through the SMM variable driver.
+  //
+  if (!EFI_ERROR (gBS->HandleProtocol (ImageHandle, &gEfiShellParametersProtocolGuid, (VOID **) &ShellParameters))) {
+    for (Index = 1; Index < ShellParameters->Argc; Index++) {
+      if ((StrCmp (ShellParameters->Argv[Index], L"-b") == 0) || (StrCmp (ShellParameters->Argv[Index], L"-B") == 0)) {
+        mEnumerationBenchmark = TRUE;
+      } else {
+        Print (L"VariableInfo: The argument '%s' is invalid.\n", ShellParameters->Argv[Index]);
+        Print (L"Usage: VariableInfo [-b]\n");
+        Print (L"  -b  Also time enumerating all variables through the SMM variable driver.\n");
+        return EFI_INVALID_PARAMETER;
+      }
+    }
+  }
 
   RuntimeDxeStatus = EfiGetSystemConfigurationTable (&gEfiVariableGuid, (VOID **) &Entry);
   if (EFI_ERROR (RuntimeDxeStatus) || (Entry == NULL)) {
@@ -54,6 +54,7 @@
 #include <Library/PerformanceLib.h>
 #include <Library/HobLib.h>
 #include <Library/SmmMemLib.h>
+#include <Library/SynchronizationLib.h>
 
 #include "PiSmmCorePrivateData.h"
 #include "HeapGuard.h"
@@ -80,8 +81,22 @@ typedef struct {
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  SmiHandlers; // All handlers
+  LIST_ENTRY  HashLink;    // Link on the hash bucket of HandlerType
 } SMI_ENTRY;
 
+//
+// Number of hash buckets to look up the SMI entry of a handler type, must be a power of 2.
+//
+#define SMI_ENTRY_HASH_BUCKET_COUNT  32
+
+typedef struct {
+  UINT64  DispatchCount;
+  UINT64  MinTicks;
+  UINT64  MaxTicks;
+  UINT64  TotalTicks;
+  UINT64  Histogram[SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT];
+} SMI_HANDLER_LATENCY;
+
 #define SMI_HANDLER_SIGNATURE  SIGNATURE_32('s','m','i','h')
 
  typedef struct {
@@ -92,6 +107,7 @@ typedef struct {
   SMI_ENTRY                     *SmiEntry;
   VOID                          *Context;    // for profile
   UINTN                         ContextSize; // for profile
+  SMI_HANDLER_LATENCY           Latency;     // for profile
 } SMI_HANDLER;
 
 //
@@ -1148,6 +1164,23 @@ SmmCoreInitializeSmiHandlerProfile (
   VOID
   );
 
+//
+// TRUE if the latency of the root and GUID SMI handlers is recorded.
+//
+extern BOOLEAN  mSmiHandlerProfileLatencyEnabled;
+
+/**
+  Record the latency of one dispatch of an SMI handler.
+
+  @param SmiHandler  The SMI handler dispatched.
+  @param Ticks       The timer ticks taken by the dispatch.
+**/
+VOID
+SmiHandlerProfileRecordLatency (
+  IN SMI_HANDLER  *SmiHandler,
+  IN UINT64       Ticks
+  );
+
 /**
   This function is called by SmmChildDispatcher module to report
   a new SMI handler is registered, to SmmCore.
@@ -1250,6 +1283,7 @@ extern LIST_ENTRY  mSmmMemoryMap;
 typedef struct {
   UINT32            Signature;
   BOOLEAN           Available;
+  UINT8             CacheIndex;   // Pool cache of the allocating processor
   EFI_MEMORY_TYPE   Type;
   UINTN             Size;
 } POOL_HEADER;
@@ -1280,6 +1314,74 @@ typedef enum {
 
 extern LIST_ENTRY  mSmmPoolLists[SmmPoolTypeMax][MAX_POOL_INDEX];
 
+//
+// Per-processor pool caches, enabled by PcdSmmPoolCpuCacheEnable.
+// A processor claims a cache by its APIC ID when it first allocates or frees pool.
+// The processors that find no unclaimed cache use the global free lists.
+//
+#define SMM_POOL_CACHE_COUNT          64
+#define SMM_POOL_CACHE_DEPTH          8
+#define SMM_POOL_CACHE_NONE           0xFF
+#define SMM_POOL_CACHE_UNUSED_APIC_ID MAX_UINT32
+
+typedef struct {
+  UINT64            AllocateCount;
+  UINT64            CacheHitCount;
+  UINT64            FreeCount;
+  UINT64            RemoteFreeCount;
+  //
+  // Allocation and free latency in TSC ticks, only measured when PcdSmmPoolLatencyEnable is TRUE.
+  //
+  UINT64            AllocateTicks;
+  UINT64            MaxAllocateTicks;
+  UINT64            FreeTicks;
+  UINT64            MaxFreeTicks;
+} SMM_POOL_STATISTICS;
+
+typedef struct {
+  volatile UINT32   ApicId;
+  //
+  // Free blocks of each pool type and size, linked by Link.ForwardLink.
+  // Only accessed by the processor owning the cache.
+  //
+  FREE_POOL_HEADER  *FreeList[SmmPoolTypeMax][MAX_POOL_INDEX];
+  UINT8             FreeCount[SmmPoolTypeMax][MAX_POOL_INDEX];
+  //
+  // Blocks allocated by the processor owning the cache and freed by other processors,
+  // linked by Link.ForwardLink. Pushed with compare-exchange, taken as a whole by the owner.
+  //
+  FREE_POOL_HEADER  * volatile RemoteFreeList;
+  UINTN             CachedSize;
+  UINTN             PeakCachedSize;
+  SMM_POOL_STATISTICS  Statistics;
+} SMM_POOL_CPU_CACHE;
+
+typedef struct {
+  //
+  // SMRAM taken by pool, including the free blocks held in the pool caches.
+  //
+  UINTN                CurrentSize;
+  UINTN                PeakSize;
+  //
+  // Statistics of the processors without a pool cache.
+  //
+  SMM_POOL_STATISTICS  Statistics;
+} SMM_POOL_USAGE;
+
+extern SMM_POOL_CPU_CACHE  mSmmPoolCpuCache[SMM_POOL_CACHE_COUNT];
+extern SMM_POOL_USAGE      mSmmPoolUsage;
+
+/**
+  Return all the free blocks held in the pool caches to the global free lists.
+
+  The caller must make sure no other processor is allocating or freeing pool.
+
+**/
+VOID
+SmmPoolCacheFlush (
+  VOID
+  );
+
 /**
   Internal Function. Allocate n pages from given free page node.
 
@@ -8,8 +8,21 @@
 
 #include "PiSmmCore.h"
 
+#include <Register/Intel/Cpuid.h>
+
 LIST_ENTRY  mSmmPoolLists[SmmPoolTypeMax][MAX_POOL_INDEX];
 //
+// Serializes the global free lists and the SMRAM pages taken by pool, so pool can be
+// allocated and freed on APs running procedures from SmmStartupThisAp().
+//
+SPIN_LOCK           mSmmPoolLock;
+SMM_POOL_CPU_CACHE  mSmmPoolCpuCache[SMM_POOL_CACHE_COUNT];
+SMM_POOL_USAGE      mSmmPoolUsage;
+//
+// CPUID leaf to read the APIC ID of the calling processor from.
+//
+UINT32              mSmmPoolApicIdLeaf = CPUID_VERSION_INFO;
+//
 // To cache the SMRAM base since when Loading modules At fixed address feature is enabled,
 // all module is assigned an offset relative the SMRAM base in build time.
 //
@@ -55,6 +68,8 @@ SmmInitializeMemoryServices (
   UINTN                  Index;
   EFI_STATUS             Status;
   UINTN                  SmmPoolTypeIndex;
+  UINT32                 MaxLeaf;
+  CPUID_EXTENDED_TOPOLOGY_EBX  ExtendedTopologyEbx;
   EFI_LOAD_FIXED_ADDRESS_CONFIGURATION_TABLE *LMFAConfigurationTable;
 
   //
@@ -65,6 +80,27 @@ SmmInitializeMemoryServices (
       InitializeListHead (&mSmmPoolLists[SmmPoolTypeIndex][Index]);
     }
   }
+  InitializeSpinLock (&mSmmPoolLock);
+
+  //
+  // Initialize the pool caches
+  //
+  if (FeaturePcdGet (PcdSmmPoolCpuCacheEnable)) {
+    for (Index = 0; Index < SMM_POOL_CACHE_COUNT; Index++) {
+      mSmmPoolCpuCache[Index].ApicId = SMM_POOL_CACHE_UNUSED_APIC_ID;
+    }
+
+    //
+    // Use the x2APIC ID if the processor reports the extended topology.
+    //
+    AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+    if (MaxLeaf >= CPUID_EXTENDED_TOPOLOGY) {
+      AsmCpuidEx (CPUID_EXTENDED_TOPOLOGY, 0, NULL, &ExtendedTopologyEbx.Uint32, NULL, NULL);
+      if (ExtendedTopologyEbx.Bits.LogicalProcessors != 0) {
+        mSmmPoolApicIdLeaf = CPUID_EXTENDED_TOPOLOGY;
+      }
+    }
+  }
 
   Status = EfiGetSystemConfigurationTable (
             &gLoadFixedAddressConfigurationTableGuid,
@@ -212,6 +248,372 @@ InternalFreePoolByIndex (
   return EFI_SUCCESS;
 }
 
+/**
+  Internal Function. Update the SMRAM taken by pool.
+
+  The caller must hold mSmmPoolLock.
+
+  @param  Size                  The size of the pool memory.
+  @param  Allocate              TRUE if the memory is taken by pool, FALSE if returned.
+
+**/
+VOID
+SmmPoolUpdateUsage (
+  IN UINTN    Size,
+  IN BOOLEAN  Allocate
+  )
+{
+  if (Allocate) {
+    mSmmPoolUsage.CurrentSize += Size;
+    if (mSmmPoolUsage.CurrentSize > mSmmPoolUsage.PeakSize) {
+      mSmmPoolUsage.PeakSize = mSmmPoolUsage.CurrentSize;
+    }
+  } else {
+    ASSERT (mSmmPoolUsage.CurrentSize >= Size);
+    mSmmPoolUsage.CurrentSize -= Size;
+  }
+}
+
+/**
+  Internal Function. Record one pool allocation or free in the statistics.
+
+  The statistics are either owned by the calling processor, or the caller holds
+  mSmmPoolLock.
+
+  @param  Statistics            The statistics to update.
+  @param  Allocate              TRUE for an allocation, FALSE for a free.
+  @param  Cached                TRUE if the allocation is served by the pool cache,
+                                or the block is freed to the cache of another processor.
+  @param  StartTicks            The time stamp when the allocation or free started.
+
+**/
+VOID
+SmmPoolRecordStatistics (
+  IN OUT SMM_POOL_STATISTICS  *Statistics,
+  IN     BOOLEAN              Allocate,
+  IN     BOOLEAN              Cached,
+  IN     UINT64               StartTicks
+  )
+{
+  UINT64  Ticks;
+
+  Ticks = 0;
+  if (FeaturePcdGet (PcdSmmPoolLatencyEnable)) {
+    Ticks = AsmReadTsc () - StartTicks;
+  }
+
+  if (Allocate) {
+    Statistics->AllocateCount++;
+    if (Cached) {
+      Statistics->CacheHitCount++;
+    }
+    Statistics->AllocateTicks += Ticks;
+    if (Ticks > Statistics->MaxAllocateTicks) {
+      Statistics->MaxAllocateTicks = Ticks;
+    }
+  } else {
+    Statistics->FreeCount++;
+    if (Cached) {
+      Statistics->RemoteFreeCount++;
+    }
+    Statistics->FreeTicks += Ticks;
+    if (Ticks > Statistics->MaxFreeTicks) {
+      Statistics->MaxFreeTicks = Ticks;
+    }
+  }
+}
+
+/**
+  Internal Function. Get the pool cache of the calling processor.
+
+  The processor claims an unused cache on its first call. The caches are looked up
+  by APIC ID with linear probing, and are never released.
+
+  @return The pool cache of the calling processor, or NULL if the pool caches are
+          disabled or all of them are claimed by other processors.
+
+**/
+SMM_POOL_CPU_CACHE *
+SmmPoolGetCpuCache (
+  VOID
+  )
+{
+  SMM_POOL_CPU_CACHE  *Cache;
+  UINT32              ApicId;
+  UINTN               Slot;
+  UINTN               Index;
+
+  if (!FeaturePcdGet (PcdSmmPoolCpuCacheEnable)) {
+    return NULL;
+  }
+
+  if (mSmmPoolApicIdLeaf == CPUID_EXTENDED_TOPOLOGY) {
+    AsmCpuidEx (CPUID_EXTENDED_TOPOLOGY, 0, NULL, NULL, NULL, &ApicId);
+  } else {
+    AsmCpuid (CPUID_VERSION_INFO, NULL, &ApicId, NULL, NULL);
+    ApicId >>= 24;
+  }
+
+  Slot = ApicId % SMM_POOL_CACHE_COUNT;
+  for (Index = 0; Index < SMM_POOL_CACHE_COUNT; Index++) {
+    Cache = &mSmmPoolCpuCache[Slot];
+    if (Cache->ApicId == ApicId) {
+      return Cache;
+    }
+    if ((Cache->ApicId == SMM_POOL_CACHE_UNUSED_APIC_ID) &&
+        (InterlockedCompareExchange32 (
+           (UINT32 *)&Cache->ApicId,
+           SMM_POOL_CACHE_UNUSED_APIC_ID,
+           ApicId
+           ) == SMM_POOL_CACHE_UNUSED_APIC_ID)) {
+      return Cache;
+    }
+    Slot = (Slot + 1) % SMM_POOL_CACHE_COUNT;
+  }
+
+  return NULL;
+}
+
+/**
+  Internal Function. Mark a pool block free before it is put in a pool cache.
+
+  The type and size of the block are kept, so the block can be returned to the
+  global free lists by InternalFreePoolByIndex() later.
+
+  @param  FreePoolHdr           The pool to free.
+
+**/
+VOID
+SmmPoolCacheMarkFree (
+  IN FREE_POOL_HEADER  *FreePoolHdr
+  )
+{
+  POOL_TAIL  *Tail;
+
+  FreePoolHdr->Header.Signature = 0;
+  FreePoolHdr->Header.Available = TRUE;
+  Tail = HEAD_TO_TAIL (&FreePoolHdr->Header);
+  Tail->Signature = 0;
+  Tail->Size = 0;
+}
+
+/**
+  Internal Function. Put a free pool block in the pool cache of the calling processor.
+
+  @param  Cache                 The pool cache of the calling processor.
+  @param  FreePoolHdr           The pool to free.
+
+  @retval TRUE                  The pool is put in the cache.
+  @retval FALSE                 The cache of this pool size is full.
+
+**/
+BOOLEAN
+SmmPoolCacheInsert (
+  IN SMM_POOL_CPU_CACHE  *Cache,
+  IN FREE_POOL_HEADER    *FreePoolHdr
+  )
+{
+  SMM_POOL_TYPE  SmmPoolType;
+  UINTN          PoolIndex;
+
+  SmmPoolType = UefiMemoryTypeToSmmPoolType (FreePoolHdr->Header.Type);
+  PoolIndex   = (UINTN) (HighBitSet32 ((UINT32)FreePoolHdr->Header.Size) - MIN_POOL_SHIFT);
+  ASSERT (PoolIndex < MAX_POOL_INDEX);
+  if (Cache->FreeCount[SmmPoolType][PoolIndex] >= SMM_POOL_CACHE_DEPTH) {
+    return FALSE;
+  }
+
+  SmmPoolCacheMarkFree (FreePoolHdr);
+  FreePoolHdr->Link.ForwardLink = (LIST_ENTRY *)Cache->FreeList[SmmPoolType][PoolIndex];
+  Cache->FreeList[SmmPoolType][PoolIndex] = FreePoolHdr;
+  Cache->FreeCount[SmmPoolType][PoolIndex]++;
+
+  Cache->CachedSize += FreePoolHdr->Header.Size;
+  if (Cache->CachedSize > Cache->PeakCachedSize) {
+    Cache->PeakCachedSize = Cache->CachedSize;
+  }
+  return TRUE;
+}
+
+/**
+  Internal Function. Free a pool block allocated by another processor to the
+  remote free list of that processor's pool cache.
+
+  @param  Cache                 The pool cache of the processor allocating the pool.
+  @param  FreePoolHdr           The pool to free.
+
+**/
+VOID
+SmmPoolCacheRemoteFree (
+  IN SMM_POOL_CPU_CACHE  *Cache,
+  IN FREE_POOL_HEADER    *FreePoolHdr
+  )
+{
+  FREE_POOL_HEADER  *Head;
+
+  SmmPoolCacheMarkFree (FreePoolHdr);
+  do {
+    Head = Cache->RemoteFreeList;
+    FreePoolHdr->Link.ForwardLink = (LIST_ENTRY *)Head;
+  } while (InterlockedCompareExchangePointer (
+             (VOID **)&Cache->RemoteFreeList,
+             Head,
+             FreePoolHdr
+             ) != Head);
+}
+
+/**
+  Internal Function. Take the remote free list of the pool cache of the calling
+  processor, and put the blocks in the cache or back to the global free lists.
+
+  @param  Cache                 The pool cache of the calling processor.
+
+**/
+VOID
+SmmPoolCacheDrainRemoteFree (
+  IN SMM_POOL_CPU_CACHE  *Cache
+  )
+{
+  FREE_POOL_HEADER  *List;
+  FREE_POOL_HEADER  *FreePoolHdr;
+  FREE_POOL_HEADER  *Overflow;
+  POOL_TAIL         *PoolTail;
+
+  do {
+    List = Cache->RemoteFreeList;
+  } while ((List != NULL) &&
+           (InterlockedCompareExchangePointer ((VOID **)&Cache->RemoteFreeList, List, NULL) != List));
+
+  Overflow = NULL;
+  while (List != NULL) {
+    FreePoolHdr = List;
+    List = (FREE_POOL_HEADER *)FreePoolHdr->Link.ForwardLink;
+    if (!SmmPoolCacheInsert (Cache, FreePoolHdr)) {
+      FreePoolHdr->Link.ForwardLink = (LIST_ENTRY *)Overflow;
+      Overflow = FreePoolHdr;
+    }
+  }
+
+  if (Overflow != NULL) {
+    AcquireSpinLock (&mSmmPoolLock);
+    while (Overflow != NULL) {
+      FreePoolHdr = Overflow;
+      Overflow = (FREE_POOL_HEADER *)FreePoolHdr->Link.ForwardLink;
+      SmmPoolUpdateUsage (FreePoolHdr->Header.Size, FALSE);
+      PoolTail = HEAD_TO_TAIL (&FreePoolHdr->Header);
+      InternalFreePoolByIndex (FreePoolHdr, PoolTail);
+    }
+    ReleaseSpinLock (&mSmmPoolLock);
+  }
+}
+
+/**
+  Internal Function. Allocate a pool from the pool cache of the calling processor.
+
+  @param  Cache                 The pool cache of the calling processor.
+  @param  PoolType              Type of pool to allocate.
+  @param  PoolIndex             Index which indicate the Pool size.
+
+  @return The allocated pool, or NULL if the cache has no free block of this size.
+
+**/
+FREE_POOL_HEADER *
+SmmPoolCacheAllocate (
+  IN SMM_POOL_CPU_CACHE  *Cache,
+  IN EFI_MEMORY_TYPE     PoolType,
+  IN UINTN               PoolIndex
+  )
+{
+  FREE_POOL_HEADER  *Hdr;
+  POOL_TAIL         *Tail;
+  SMM_POOL_TYPE     SmmPoolType;
+
+  SmmPoolType = UefiMemoryTypeToSmmPoolType (PoolType);
+  ASSERT (PoolIndex < MAX_POOL_INDEX);
+
+  if (Cache->RemoteFreeList != NULL) {
+    SmmPoolCacheDrainRemoteFree (Cache);
+  }
+
+  Hdr = Cache->FreeList[SmmPoolType][PoolIndex];
+  if (Hdr == NULL) {
+    return NULL;
+  }
+
+  Cache->FreeList[SmmPoolType][PoolIndex] = (FREE_POOL_HEADER *)Hdr->Link.ForwardLink;
+  Cache->FreeCount[SmmPoolType][PoolIndex]--;
+  Cache->CachedSize -= Hdr->Header.Size;
+
+  ASSERT (Hdr->Header.Size == (MIN_POOL_SIZE << PoolIndex));
+  Hdr->Header.Signature = POOL_HEAD_SIGNATURE;
+  Hdr->Header.Available = FALSE;
+  Hdr->Header.Type = PoolType;
+  Tail = HEAD_TO_TAIL(&Hdr->Header);
+  Tail->Signature = POOL_TAIL_SIGNATURE;
+  Tail->Size = Hdr->Header.Size;
+  return Hdr;
+}
+
+/**
+  Return all the free blocks held in the pool caches to the global free lists.
+
+  The caller must make sure no other processor is allocating or freeing pool.
+
+**/
+VOID
+SmmPoolCacheFlush (
+  VOID
+  )
+{
+  SMM_POOL_CPU_CACHE  *Cache;
+  FREE_POOL_HEADER    *List;
+  FREE_POOL_HEADER    *FreePoolHdr;
+  UINTN               Index;
+  UINTN               SmmPoolType;
+  UINTN               PoolIndex;
+  POOL_TAIL           *PoolTail;
+
+  if (!FeaturePcdGet (PcdSmmPoolCpuCacheEnable)) {
+    return;
+  }
+
+  for (Index = 0; Index < SMM_POOL_CACHE_COUNT; Index++) {
+    Cache = &mSmmPoolCpuCache[Index];
+    if (Cache->ApicId == SMM_POOL_CACHE_UNUSED_APIC_ID) {
+      continue;
+    }
+
+    do {
+      List = Cache->RemoteFreeList;
+    } while ((List != NULL) &&
+             (InterlockedCompareExchangePointer ((VOID **)&Cache->RemoteFreeList, List, NULL) != List));
+
+    AcquireSpinLock (&mSmmPoolLock);
+    while (List != NULL) {
+      FreePoolHdr = List;
+      List = (FREE_POOL_HEADER *)FreePoolHdr->Link.ForwardLink;
+      SmmPoolUpdateUsage (FreePoolHdr->Header.Size, FALSE);
+      PoolTail = HEAD_TO_TAIL (&FreePoolHdr->Header);
+      InternalFreePoolByIndex (FreePoolHdr, PoolTail);
+    }
+
+    for (SmmPoolType = 0; SmmPoolType < SmmPoolTypeMax; SmmPoolType++) {
+      for (PoolIndex = 0; PoolIndex < MAX_POOL_INDEX; PoolIndex++) {
+        while (Cache->FreeList[SmmPoolType][PoolIndex] != NULL) {
+          FreePoolHdr = Cache->FreeList[SmmPoolType][PoolIndex];
+          Cache->FreeList[SmmPoolType][PoolIndex] = (FREE_POOL_HEADER *)FreePoolHdr->Link.ForwardLink;
+          Cache->CachedSize -= FreePoolHdr->Header.Size;
+          SmmPoolUpdateUsage (FreePoolHdr->Header.Size, FALSE);
+          PoolTail = HEAD_TO_TAIL (&FreePoolHdr->Header);
+          InternalFreePoolByIndex (FreePoolHdr, PoolTail);
+        }
+        Cache->FreeCount[SmmPoolType][PoolIndex] = 0;
+      }
+    }
+    ReleaseSpinLock (&mSmmPoolLock);
+  }
+}
+
 /**
   Allocate pool of a particular type.
 
@@ -242,8 +644,15 @@ SmmInternalAllocatePool (
   BOOLEAN               HasPoolTail;
   BOOLEAN               NeedGuard;
   UINTN                 NoPages;
+  SMM_POOL_CPU_CACHE    *Cache;
+  BOOLEAN               CacheHit;
+  UINT64                StartTicks;
 
   Address = 0;
+  StartTicks = 0;
+  if (FeaturePcdGet (PcdSmmPoolLatencyEnable)) {
+    StartTicks = AsmReadTsc ();
+  }
 
   if (PoolType != EfiRuntimeServicesCode &&
       PoolType != EfiRuntimeServicesData) {
@@ -264,8 +673,14 @@ SmmInternalAllocatePool (
     }
 
     NoPages = EFI_SIZE_TO_PAGES (Size);
+    AcquireSpinLock (&mSmmPoolLock);
     Status = SmmInternalAllocatePages (AllocateAnyPages, PoolType, NoPages,
                                        &Address, NeedGuard);
+    if (!EFI_ERROR (Status)) {
+      SmmPoolUpdateUsage (EFI_PAGES_TO_SIZE (NoPages), TRUE);
+    }
+    SmmPoolRecordStatistics (&mSmmPoolUsage.Statistics, TRUE, FALSE, StartTicks);
+    ReleaseSpinLock (&mSmmPoolLock);
     if (EFI_ERROR (Status)) {
       return Status;
     }
@@ -283,6 +698,7 @@ SmmInternalAllocatePool (
     PoolHdr->Signature = POOL_HEAD_SIGNATURE;
     PoolHdr->Size = EFI_PAGES_TO_SIZE (NoPages);
     PoolHdr->Available = FALSE;
+    PoolHdr->CacheIndex = SMM_POOL_CACHE_NONE;
     PoolHdr->Type = PoolType;
 
     if (HasPoolTail) {
@@ -301,10 +717,42 @@ SmmInternalAllocatePool (
     PoolIndex++;
   }
 
-  Status = InternalAllocPoolByIndex (PoolType, PoolIndex, &FreePoolHdr);
+  //
+  // Try the pool cache of this processor first.
+  //
+  FreePoolHdr = NULL;
+  Cache = SmmPoolGetCpuCache ();
+  if (Cache != NULL) {
+    FreePoolHdr = SmmPoolCacheAllocate (Cache, PoolType, PoolIndex);
+  }
+
+  CacheHit = (BOOLEAN) (FreePoolHdr != NULL);
+  if (CacheHit) {
+    Status = EFI_SUCCESS;
+  } else {
+    AcquireSpinLock (&mSmmPoolLock);
+    Status = InternalAllocPoolByIndex (PoolType, PoolIndex, &FreePoolHdr);
+    if (!EFI_ERROR (Status)) {
+      SmmPoolUpdateUsage (FreePoolHdr->Header.Size, TRUE);
+    }
+    if (Cache == NULL) {
+      SmmPoolRecordStatistics (&mSmmPoolUsage.Statistics, TRUE, FALSE, StartTicks);
+    }
+    ReleaseSpinLock (&mSmmPoolLock);
+  }
+
   if (!EFI_ERROR(Status)) {
+    if (Cache != NULL) {
+      FreePoolHdr->Header.CacheIndex = (UINT8) (Cache - mSmmPoolCpuCache);
+    } else {
+      FreePoolHdr->Header.CacheIndex = SMM_POOL_CACHE_NONE;
+    }
     *Buffer = &FreePoolHdr->Header + 1;
   }
+
+  if (Cache != NULL) {
+    SmmPoolRecordStatistics (&Cache->Statistics, TRUE, CacheHit, StartTicks);
+  }
   return Status;
 }
 
@@ -360,15 +808,27 @@ SmmInternalFreePool (
   IN VOID  *Buffer
   )
 {
-  FREE_POOL_HEADER  *FreePoolHdr;
-  POOL_TAIL         *PoolTail;
-  BOOLEAN           HasPoolTail;
-  BOOLEAN           MemoryGuarded;
+  FREE_POOL_HEADER    *FreePoolHdr;
+  POOL_TAIL           *PoolTail;
+  BOOLEAN             HasPoolTail;
+  BOOLEAN             MemoryGuarded;
+  SMM_POOL_CPU_CACHE  *Cache;
+  BOOLEAN             Cached;
+  BOOLEAN             RemoteFree;
+  UINTN               CacheIndex;
+  UINTN               Size;
+  EFI_STATUS          Status;
+  UINT64              StartTicks;
 
   if (Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
+  StartTicks = 0;
+  if (FeaturePcdGet (PcdSmmPoolLatencyEnable)) {
+    StartTicks = AsmReadTsc ();
+  }
+
   MemoryGuarded = IsHeapGuardEnabled () &&
                   IsMemoryGuarded ((EFI_PHYSICAL_ADDRESS)(UINTN)Buffer);
   HasPoolTail   = !(MemoryGuarded &&
@@ -396,25 +856,81 @@ SmmInternalFreePool (
     PoolTail = NULL;
   }
 
+  Size = FreePoolHdr->Header.Size;
   if (MemoryGuarded) {
     Buffer = AdjustPoolHeadF ((EFI_PHYSICAL_ADDRESS)(UINTN)FreePoolHdr);
-    return SmmInternalFreePages (
-             (EFI_PHYSICAL_ADDRESS)(UINTN)Buffer,
-             EFI_SIZE_TO_PAGES (FreePoolHdr->Header.Size),
-             TRUE
-             );
+    AcquireSpinLock (&mSmmPoolLock);
+    Status = SmmInternalFreePages (
+               (EFI_PHYSICAL_ADDRESS)(UINTN)Buffer,
+               EFI_SIZE_TO_PAGES (Size),
+               TRUE
+               );
+    if (!EFI_ERROR (Status)) {
+      SmmPoolUpdateUsage (Size, FALSE);
+    }
+    SmmPoolRecordStatistics (&mSmmPoolUsage.Statistics, FALSE, FALSE, StartTicks);
+    ReleaseSpinLock (&mSmmPoolLock);
+    return Status;
   }
 
-  if (FreePoolHdr->Header.Size > MAX_POOL_SIZE) {
+  if (Size > MAX_POOL_SIZE) {
     ASSERT (((UINTN)FreePoolHdr & EFI_PAGE_MASK) == 0);
-    ASSERT ((FreePoolHdr->Header.Size & EFI_PAGE_MASK) == 0);
-    return SmmInternalFreePages (
-             (EFI_PHYSICAL_ADDRESS)(UINTN)FreePoolHdr,
-             EFI_SIZE_TO_PAGES (FreePoolHdr->Header.Size),
-             FALSE
-             );
-  }
-  return InternalFreePoolByIndex (FreePoolHdr, PoolTail);
+    ASSERT ((Size & EFI_PAGE_MASK) == 0);
+    AcquireSpinLock (&mSmmPoolLock);
+    Status = SmmInternalFreePages (
+               (EFI_PHYSICAL_ADDRESS)(UINTN)FreePoolHdr,
+               EFI_SIZE_TO_PAGES (Size),
+               FALSE
+               );
+    if (!EFI_ERROR (Status)) {
+      SmmPoolUpdateUsage (Size, FALSE);
+    }
+    SmmPoolRecordStatistics (&mSmmPoolUsage.Statistics, FALSE, FALSE, StartTicks);
+    ReleaseSpinLock (&mSmmPoolLock);
+    return Status;
+  }
+
+  //
+  // Free the pool to the cache of the processor which allocated it, or to the cache
+  // of this processor if it has no owner.
+  //
+  Cached     = FALSE;
+  RemoteFree = FALSE;
+  Cache      = SmmPoolGetCpuCache ();
+  if (Cache != NULL) {
+    //
+    // Take back the blocks other processors freed to this cache, so they don't stay
+    // out of use until this processor misses in its cache.
+    //
+    if (Cache->RemoteFreeList != NULL) {
+      SmmPoolCacheDrainRemoteFree (Cache);
+    }
+
+    CacheIndex = FreePoolHdr->Header.CacheIndex;
+    if ((CacheIndex < SMM_POOL_CACHE_COUNT) && (&mSmmPoolCpuCache[CacheIndex] != Cache)) {
+      SmmPoolCacheRemoteFree (&mSmmPoolCpuCache[CacheIndex], FreePoolHdr);
+      Cached     = TRUE;
+      RemoteFree = TRUE;
+    } else {
+      Cached = SmmPoolCacheInsert (Cache, FreePoolHdr);
+    }
+  }
+
+  Status = EFI_SUCCESS;
+  if (!Cached) {
+    AcquireSpinLock (&mSmmPoolLock);
+    SmmPoolUpdateUsage (Size, FALSE);
+    Status = InternalFreePoolByIndex (FreePoolHdr, PoolTail);
+    if (Cache == NULL) {
+      SmmPoolRecordStatistics (&mSmmPoolUsage.Statistics, FALSE, FALSE, StartTicks);
+    }
+    ReleaseSpinLock (&mSmmPoolLock);
+  }
+
+  if (Cache != NULL) {
+    SmmPoolRecordStatistics (&Cache->Statistics, FALSE, RemoteFree, StartTicks);
+  }
+  return Status;
 }
 
 /**
@@ -15,8 +15,52 @@ SMI_ENTRY   mRootSmiEntry = {
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.AllEntries),
   {0},
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.SmiHandlers),
+  INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.HashLink),
 };
 
+//
+// The SMI entries on mSmiEntryList, hashed by handler type.
+//
+LIST_ENTRY  mSmiEntryHashTable[SMI_ENTRY_HASH_BUCKET_COUNT];
+BOOLEAN     mSmiEntryHashTableInitialized = FALSE;
+
+//
+// The SMI handler being dispatched by SmiManage(), or NULL if it is unregistered
+// by itself during the dispatch.
+//
+SMI_HANDLER  *mSmiDispatchingHandler = NULL;
+
+/**
+  Get the hash bucket of the SMI entries for the requested handler type.
+
+  @param  HandlerType            The type of the interrupt
+
+  @return The list head of the hash bucket.
+
+**/
+LIST_ENTRY *
+SmmCoreGetSmiEntryHashBucket (
+  IN CONST EFI_GUID  *HandlerType
+  )
+{
+  CONST UINT32  *Data;
+  UINT32        Hash;
+  UINTN         Index;
+
+  if (!mSmiEntryHashTableInitialized) {
+    for (Index = 0; Index < SMI_ENTRY_HASH_BUCKET_COUNT; Index++) {
+      InitializeListHead (&mSmiEntryHashTable[Index]);
+    }
+    mSmiEntryHashTableInitialized = TRUE;
+  }
+
+  Data = (CONST UINT32 *) HandlerType;
+  Hash = Data[0] ^ Data[1] ^ Data[2] ^ Data[3];
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return &mSmiEntryHashTable[Hash & (SMI_ENTRY_HASH_BUCKET_COUNT - 1)];
+}
+
 /**
   Finds the SMI entry for the requested handler type.
 
@@ -33,19 +77,21 @@ SmmCoreFindSmiEntry (
   IN BOOLEAN   Create
   )
 {
+  LIST_ENTRY  *Bucket;
   LIST_ENTRY  *Link;
   SMI_ENTRY   *Item;
   SMI_ENTRY   *SmiEntry;
 
   //
-  // Search the SMI entry list for the matching GUID
+  // Search the hash bucket of the handler type for the matching GUID
   //
   SmiEntry = NULL;
-  for (Link = mSmiEntryList.ForwardLink;
-       Link != &mSmiEntryList;
+  Bucket = SmmCoreGetSmiEntryHashBucket (HandlerType);
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR (Link, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+    Item = CR (Link, SMI_ENTRY, HashLink, SMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the SMI entry
@@ -70,9 +116,10 @@ SmmCoreFindSmiEntry (
       InitializeListHead (&SmiEntry->SmiHandlers);
 
       //
-      // Add it to SMI entry list
+      // Add it to SMI entry list and its hash bucket
       //
       InsertTailList (&mSmiEntryList, &SmiEntry->AllEntries);
+      InsertTailList (Bucket, &SmiEntry->HashLink);
     }
   }
   return SmiEntry;
@@ -105,11 +152,15 @@ SmiManage (
   LIST_ENTRY   *Head;
   SMI_ENTRY    *SmiEntry;
   SMI_HANDLER  *SmiHandler;
+  SMI_HANDLER  *PreviousDispatchingHandler;
   BOOLEAN      SuccessReturn;
   EFI_STATUS   Status;
+  UINT64       StartTicks;
 
   Status = EFI_NOT_FOUND;
   SuccessReturn = FALSE;
+  PreviousDispatchingHandler = NULL;
+  StartTicks = 0;
   if (HandlerType == NULL) {
     //
     // Root SMI handler
@@ -132,6 +183,12 @@ SmiManage (
   for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
     SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
 
+    if (mSmiHandlerProfileLatencyEnabled) {
+      PreviousDispatchingHandler = mSmiDispatchingHandler;
+      mSmiDispatchingHandler = SmiHandler;
+      StartTicks = AsmReadTsc ();
+    }
+
     Status = SmiHandler->Handler (
                (EFI_HANDLE) SmiHandler,
                Context,
@@ -139,6 +196,13 @@ SmiManage (
                CommBufferSize
                );
 
+    if (mSmiHandlerProfileLatencyEnabled) {
+      if (mSmiDispatchingHandler == SmiHandler) {
+        SmiHandlerProfileRecordLatency (SmiHandler, AsmReadTsc () - StartTicks);
+      }
+      mSmiDispatchingHandler = PreviousDispatchingHandler;
+    }
+
     switch (Status) {
     case EFI_INTERRUPT_PENDING:
       //
@@ -310,10 +374,14 @@ SmiHandlerUnRegister (
 
   SmiEntry = SmiHandler->SmiEntry;
 
+  if (mSmiDispatchingHandler == SmiHandler) {
+    mSmiDispatchingHandler = NULL;
+  }
+
   RemoveEntryList (&SmiHandler->Link);
   FreePool (SmiHandler);
 
-  if (SmiEntry == NULL) {
+  if ((SmiEntry == NULL) || (SmiEntry == &mRootSmiEntry)) {
     //
     // This is root SMI handler
     //
@@ -325,6 +393,7 @@ SmiHandlerUnRegister (
     // No handler registered for this interrupt now, remove the SMI_ENTRY
     //
     RemoveEntryList (&SmiEntry->AllEntries);
+    RemoveEntryList (&SmiEntry->HashLink);
 
     FreePool (SmiEntry);
   }
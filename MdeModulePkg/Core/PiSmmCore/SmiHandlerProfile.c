@@ -98,6 +98,11 @@ GLOBAL_REMOVE_IF_UNREFERENCED UINTN  mSmmHardwareSmiDatabaseSize;
 
 GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN  mSmiHandlerProfileRecordingStatus;
 
+GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN  mSmiHandlerProfileLatencyEnabled;
+
+GLOBAL_REMOVE_IF_UNREFERENCED VOID   *mSmiHandlerLatencyDatabase;
+GLOBAL_REMOVE_IF_UNREFERENCED UINTN  mSmiHandlerLatencyDatabaseSize;
+
 GLOBAL_REMOVE_IF_UNREFERENCED SMI_HANDLER_PROFILE_PROTOCOL  mSmiHandlerProfile = {
   SmiHandlerProfileRegisterHandler,
   SmiHandlerProfileUnregisterHandler,
@@ -842,34 +847,218 @@ BuildSmiHandlerProfileDatabase(
   }
 }
 
+/**
+  Record the latency of one dispatch of an SMI handler.
+
+  @param SmiHandler  The SMI handler dispatched.
+  @param Ticks       The timer ticks taken by the dispatch.
+**/
+VOID
+SmiHandlerProfileRecordLatency (
+  IN SMI_HANDLER  *SmiHandler,
+  IN UINT64       Ticks
+  )
+{
+  SMI_HANDLER_LATENCY  *Latency;
+  UINTN                Index;
+
+  Latency = &SmiHandler->Latency;
+  if ((Latency->DispatchCount == 0) || (Ticks < Latency->MinTicks)) {
+    Latency->MinTicks = Ticks;
+  }
+  if (Ticks > Latency->MaxTicks) {
+    Latency->MaxTicks = Ticks;
+  }
+  Latency->DispatchCount++;
+  Latency->TotalTicks += Ticks;
+
+  Index = 0;
+  if (Ticks != 0) {
+    Index = (UINTN)HighBitSet64 (Ticks);
+  }
+  if (Index >= SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT) {
+    Index = SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT - 1;
+  }
+  Latency->Histogram[Index]++;
+}
+
+/**
+  Return the upper bound of the histogram bucket holding the 99th percentile dispatch.
+
+  @param Latency  The latency of an SMI handler.
+
+  @return The 99th percentile latency in timer ticks, or 0 if the handler is never dispatched.
+**/
+UINT64
+GetSmiHandlerLatencyP99 (
+  IN SMI_HANDLER_LATENCY  *Latency
+  )
+{
+  UINT64  Threshold;
+  UINT64  Count;
+  UINT64  UpperBound;
+  UINTN   Index;
+
+  if (Latency->DispatchCount == 0) {
+    return 0;
+  }
+
+  //
+  // The 99th percentile dispatch is the ceil (DispatchCount * 99 / 100)th fastest one.
+  //
+  Threshold = Latency->DispatchCount - DivU64x32 (Latency->DispatchCount, 100);
+  Count = 0;
+  for (Index = 0; Index < SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT - 1; Index++) {
+    Count += Latency->Histogram[Index];
+    if (Count >= Threshold) {
+      UpperBound = LShiftU64 (1, Index + 1) - 1;
+      return MIN (UpperBound, Latency->MaxTicks);
+    }
+  }
+  return Latency->MaxTicks;
+}
+
+/**
+  return the SMI handler latency database size on the SMI entry list.
+
+  @param SmiEntryList a list of SMI entry.
+
+  @return the SMI handler latency database size on the SMI entry list.
+**/
+UINTN
+GetSmmSmiLatencyDatabaseSize (
+  IN LIST_ENTRY      *SmiEntryList
+  )
+{
+  LIST_ENTRY      *ListEntry;
+  LIST_ENTRY      *HandlerEntry;
+  SMI_ENTRY       *SmiEntry;
+  UINTN           Size;
+
+  Size = 0;
+  for (ListEntry = SmiEntryList->ForwardLink;
+       ListEntry != SmiEntryList;
+       ListEntry = ListEntry->ForwardLink) {
+    SmiEntry = CR(ListEntry, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+    for (HandlerEntry = SmiEntry->SmiHandlers.ForwardLink;
+         HandlerEntry != &SmiEntry->SmiHandlers;
+         HandlerEntry = HandlerEntry->ForwardLink) {
+      Size += sizeof (SMM_CORE_SMI_LATENCY_DATABASE_STRUCTURE);
+    }
+  }
+  return Size;
+}
+
+/**
+  get the SMI handler latency database on the SMI entry list.
+
+  @param SmiEntryList     a list of SMI entry.
+  @param HandlerCategory  The handler category
+  @param Data             The buffer to hold the SMI handler latency database
+
+  @return the SMI handler latency database size on the SMI entry list.
+**/
+UINTN
+GetSmmSmiLatencyDatabaseData (
+  IN     LIST_ENTRY      *SmiEntryList,
+  IN     UINT32          HandlerCategory,
+  IN OUT VOID            *Data
+  )
+{
+  SMM_CORE_SMI_LATENCY_DATABASE_STRUCTURE   *LatencyStruct;
+  LIST_ENTRY                                *ListEntry;
+  LIST_ENTRY                                *HandlerEntry;
+  SMI_ENTRY                                 *SmiEntry;
+  SMI_HANDLER                               *SmiHandler;
+
+  LatencyStruct = Data;
+  for (ListEntry = SmiEntryList->ForwardLink;
+       ListEntry != SmiEntryList;
+       ListEntry = ListEntry->ForwardLink) {
+    SmiEntry = CR(ListEntry, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+    for (HandlerEntry = SmiEntry->SmiHandlers.ForwardLink;
+         HandlerEntry != &SmiEntry->SmiHandlers;
+         HandlerEntry = HandlerEntry->ForwardLink) {
+      SmiHandler = CR(HandlerEntry, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+      ZeroMem (LatencyStruct, sizeof (*LatencyStruct));
+      LatencyStruct->Header.Signature = SMM_CORE_SMI_LATENCY_DATABASE_SIGNATURE;
+      LatencyStruct->Header.Length = sizeof (*LatencyStruct);
+      LatencyStruct->Header.Revision = SMM_CORE_SMI_LATENCY_DATABASE_REVISION;
+      CopyGuid (&LatencyStruct->HandlerType, &SmiEntry->HandlerType);
+      LatencyStruct->HandlerCategory = HandlerCategory;
+      LatencyStruct->CallerAddr = (UINTN)SmiHandler->CallerAddr;
+      LatencyStruct->Handler = (UINTN)SmiHandler->Handler;
+      LatencyStruct->DispatchCount = SmiHandler->Latency.DispatchCount;
+      LatencyStruct->MinTicks = SmiHandler->Latency.MinTicks;
+      LatencyStruct->MaxTicks = SmiHandler->Latency.MaxTicks;
+      LatencyStruct->TotalTicks = SmiHandler->Latency.TotalTicks;
+      LatencyStruct->P99Ticks = GetSmiHandlerLatencyP99 (&SmiHandler->Latency);
+      CopyMem (LatencyStruct->Histogram, SmiHandler->Latency.Histogram, sizeof (LatencyStruct->Histogram));
+      LatencyStruct++;
+    }
+  }
+  return (UINTN)LatencyStruct - (UINTN)Data;
+}
+
+/**
+  build a snapshot of the SMI handler latency database.
+**/
+VOID
+BuildSmiHandlerLatencyDatabase (
+  VOID
+  )
+{
+  UINTN  RootSmiDatabaseSize;
+
+  if (mSmiHandlerLatencyDatabase != NULL) {
+    FreePool (mSmiHandlerLatencyDatabase);
+    mSmiHandlerLatencyDatabase = NULL;
+  }
+
+  RootSmiDatabaseSize = GetSmmSmiLatencyDatabaseSize (mSmmCoreRootSmiEntryList);
+  mSmiHandlerLatencyDatabaseSize = RootSmiDatabaseSize + GetSmmSmiLatencyDatabaseSize (mSmmCoreSmiEntryList);
+  mSmiHandlerLatencyDatabase = AllocatePool (mSmiHandlerLatencyDatabaseSize);
+  if (mSmiHandlerLatencyDatabase == NULL) {
+    mSmiHandlerLatencyDatabaseSize = 0;
+    return;
+  }
+
+  GetSmmSmiLatencyDatabaseData (mSmmCoreRootSmiEntryList, SmmCoreSmiHandlerCategoryRootHandler, mSmiHandlerLatencyDatabase);
+  GetSmmSmiLatencyDatabaseData (mSmmCoreSmiEntryList, SmmCoreSmiHandlerCategoryGuidHandler, (UINT8 *)mSmiHandlerLatencyDatabase + RootSmiDatabaseSize);
+}
+
 /**
   Copy SMI handler profile data.
 
-  @param DataBuffer  The buffer to hold SMI handler profile data.
-  @param DataSize    On input, data buffer size.
-                     On output, actual data buffer size copied.
-  @param DataOffset  On input, data buffer offset to copy.
-                     On output, next time data buffer offset to copy.
+  @param Database      The SMI handler profile data to copy from.
+  @param DatabaseSize  The size of the SMI handler profile data.
+  @param DataBuffer    The buffer to hold SMI handler profile data.
+  @param DataSize      On input, data buffer size.
+                       On output, actual data buffer size copied.
+  @param DataOffset    On input, data buffer offset to copy.
+                       On output, next time data buffer offset to copy.
 
 **/
 VOID
 SmiHandlerProfileCopyData(
+  IN     VOID   *Database,
+  IN     UINTN  DatabaseSize,
   OUT VOID      *DataBuffer,
   IN OUT UINT64 *DataSize,
   IN OUT UINT64 *DataOffset
   )
 {
-  if (*DataOffset >= mSmiHandlerProfileDatabaseSize) {
-    *DataOffset = mSmiHandlerProfileDatabaseSize;
+  if (*DataOffset >= DatabaseSize) {
+    *DataOffset = DatabaseSize;
     return;
   }
-  if (mSmiHandlerProfileDatabaseSize - *DataOffset < *DataSize) {
-    *DataSize = mSmiHandlerProfileDatabaseSize - *DataOffset;
+  if (DatabaseSize - *DataOffset < *DataSize) {
+    *DataSize = DatabaseSize - *DataOffset;
   }
 
   CopyMem(
     DataBuffer,
-    (UINT8 *)mSmiHandlerProfileDatabase + *DataOffset,
+    (UINT8 *)Database + *DataOffset,
     (UINTN)*DataSize
     );
   *DataOffset = *DataOffset + *DataSize;
@@ -897,14 +1086,55 @@ SmiHandlerProfileHandlerGetInfo(
   mSmiHandlerProfileRecordingStatus = SmiHandlerProfileRecordingStatus;
 }
 
+/**
+  SMI handler profile handler to get latency info.
+
+  A new snapshot of the SMI handler latency database is taken, to be got by
+  SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_DATA_BY_OFFSET.
+
+  @param SmiHandlerProfileParameterGetInfo The parameter of SMI handler profile get info.
+
+**/
+VOID
+SmiHandlerProfileHandlerGetLatencyInfo(
+  IN SMI_HANDLER_PROFILE_PARAMETER_GET_INFO   *SmiHandlerProfileParameterGetInfo
+  )
+{
+  BOOLEAN                       SmiHandlerProfileRecordingStatus;
+
+  SmiHandlerProfileRecordingStatus = mSmiHandlerProfileRecordingStatus;
+  mSmiHandlerProfileRecordingStatus = FALSE;
+
+  if (!mSmiHandlerProfileLatencyEnabled) {
+    SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = (UINT64)(INT64)(INTN)EFI_UNSUPPORTED;
+    goto Done;
+  }
+
+  BuildSmiHandlerLatencyDatabase ();
+  if (mSmiHandlerLatencyDatabase == NULL) {
+    SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = (UINT64)(INT64)(INTN)EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  SmiHandlerProfileParameterGetInfo->DataSize = mSmiHandlerLatencyDatabaseSize;
+  SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = 0;
+
+Done:
+  mSmiHandlerProfileRecordingStatus = SmiHandlerProfileRecordingStatus;
+}
+
 /**
   SMI handler profile handler to get data by offset.
 
+  @param Database                                    The SMI handler profile data to get.
+  @param DatabaseSize                                The size of the SMI handler profile data.
   @param SmiHandlerProfileParameterGetDataByOffset   The parameter of SMI handler profile get data by offset.
 
 **/
 VOID
 SmiHandlerProfileHandlerGetDataByOffset(
+  IN VOID                                                 *Database,
+  IN UINTN                                                DatabaseSize,
   IN SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET     *SmiHandlerProfileParameterGetDataByOffset
   )
 {
@@ -925,7 +1155,7 @@ SmiHandlerProfileHandlerGetDataByOffset(
     goto Done;
   }
 
-  SmiHandlerProfileCopyData((VOID *)(UINTN)SmiHandlerProfileGetDataByOffset.DataBuffer, &SmiHandlerProfileGetDataByOffset.DataSize, &SmiHandlerProfileGetDataByOffset.DataOffset);
+  SmiHandlerProfileCopyData(Database, DatabaseSize, (VOID *)(UINTN)SmiHandlerProfileGetDataByOffset.DataBuffer, &SmiHandlerProfileGetDataByOffset.DataSize, &SmiHandlerProfileGetDataByOffset.DataOffset);
   CopyMem(SmiHandlerProfileParameterGetDataByOffset, &SmiHandlerProfileGetDataByOffset, sizeof(SmiHandlerProfileGetDataByOffset));
   SmiHandlerProfileParameterGetDataByOffset->Header.ReturnStatus = 0;
 
@@ -1003,7 +1233,23 @@ SmiHandlerProfileHandler(
       DEBUG((DEBUG_ERROR, "SmiHandlerProfileHandler: SMM communication buffer size invalid!\n"));
       return EFI_SUCCESS;
     }
-    SmiHandlerProfileHandlerGetDataByOffset((SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET *)(UINTN)CommBuffer);
+    SmiHandlerProfileHandlerGetDataByOffset(mSmiHandlerProfileDatabase, mSmiHandlerProfileDatabaseSize, (SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET *)(UINTN)CommBuffer);
+    break;
+  case SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_INFO:
+    DEBUG((DEBUG_ERROR, "SmiHandlerProfileHandlerGetLatencyInfo\n"));
+    if (TempCommBufferSize != sizeof(SMI_HANDLER_PROFILE_PARAMETER_GET_INFO)) {
+      DEBUG((DEBUG_ERROR, "SmiHandlerProfileHandler: SMM communication buffer size invalid!\n"));
+      return EFI_SUCCESS;
+    }
+    SmiHandlerProfileHandlerGetLatencyInfo((SMI_HANDLER_PROFILE_PARAMETER_GET_INFO *)(UINTN)CommBuffer);
+    break;
+  case SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_DATA_BY_OFFSET:
+    DEBUG((DEBUG_ERROR, "SmiHandlerProfileHandlerGetLatencyDataByOffset\n"));
+    if (TempCommBufferSize != sizeof(SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET)) {
+      DEBUG((DEBUG_ERROR, "SmiHandlerProfileHandler: SMM communication buffer size invalid!\n"));
+      return EFI_SUCCESS;
+    }
+    SmiHandlerProfileHandlerGetDataByOffset(mSmiHandlerLatencyDatabase, mSmiHandlerLatencyDatabaseSize, (SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET *)(UINTN)CommBuffer);
     break;
   default:
     break;
@@ -1347,6 +1593,8 @@ SmmCoreInitializeSmiHandlerProfile (
   if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x1) != 0) {
     InsertTailList (&mRootSmiEntryList, &mRootSmiEntry.AllEntries);
 
+    mSmiHandlerProfileLatencyEnabled = (BOOLEAN)((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x2) != 0);
+
     Status = gSmst->SmmRegisterProtocolNotify (
                       &gEfiSmmReadyToLockProtocolGuid,
                       SmmReadyToLockInSmiHandlerProfile,
@@ -1536,6 +1536,70 @@ SmramProfileReadyToLock (
 
 ////////////////////
 
+/**
+  Get the number of pool statistics records, one for the processors without a
+  pool cache and one for each pool cache claimed by a processor.
+
+  @return The number of pool statistics records.
+
+**/
+UINTN
+SmramProfileGetPoolStatisticsCount (
+  VOID
+  )
+{
+  UINTN   Count;
+  UINTN   Index;
+
+  Count = 1;
+  if (FeaturePcdGet (PcdSmmPoolCpuCacheEnable)) {
+    for (Index = 0; Index < SMM_POOL_CACHE_COUNT; Index++) {
+      if (mSmmPoolCpuCache[Index].ApicId != SMM_POOL_CACHE_UNUSED_APIC_ID) {
+        Count++;
+      }
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Fill a pool statistics record.
+
+  @param PoolStatistics   The record to fill.
+  @param ApicId           APIC ID of the processor owning the pool cache,
+                          MEMORY_PROFILE_POOL_NO_CACHE_APIC_ID for the processors without one.
+  @param CachedSize       Size of the free blocks held in the pool cache.
+  @param PeakCachedSize   Peak size of the free blocks held in the pool cache.
+  @param Statistics       The pool statistics.
+
+**/
+VOID
+SmramProfileFillPoolStatistics (
+  OUT MEMORY_PROFILE_POOL_STATISTICS  *PoolStatistics,
+  IN  UINT32                          ApicId,
+  IN  UINTN                           CachedSize,
+  IN  UINTN                           PeakCachedSize,
+  IN  SMM_POOL_STATISTICS             *Statistics
+  )
+{
+  ZeroMem (PoolStatistics, sizeof (MEMORY_PROFILE_POOL_STATISTICS));
+  PoolStatistics->Header.Signature = MEMORY_PROFILE_POOL_STATISTICS_SIGNATURE;
+  PoolStatistics->Header.Length = sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+  PoolStatistics->Header.Revision = MEMORY_PROFILE_POOL_STATISTICS_REVISION;
+  PoolStatistics->ApicId = ApicId;
+  PoolStatistics->CachedSize = CachedSize;
+  PoolStatistics->PeakCachedSize = PeakCachedSize;
+  PoolStatistics->AllocateCount = Statistics->AllocateCount;
+  PoolStatistics->CacheHitCount = Statistics->CacheHitCount;
+  PoolStatistics->FreeCount = Statistics->FreeCount;
+  PoolStatistics->RemoteFreeCount = Statistics->RemoteFreeCount;
+  PoolStatistics->AllocateTicks = Statistics->AllocateTicks;
+  PoolStatistics->MaxAllocateTicks = Statistics->MaxAllocateTicks;
+  PoolStatistics->FreeTicks = Statistics->FreeTicks;
+  PoolStatistics->MaxFreeTicks = Statistics->MaxFreeTicks;
+}
+
 /**
   Get SMRAM profile data size.
 
@@ -1568,6 +1632,11 @@ SmramProfileGetDataSize (
     return 0;
   }
 
+  //
+  // The free blocks held in the pool caches are reported in the free pool lists.
+  //
+  SmmPoolCacheFlush ();
+
   TotalSize = sizeof (MEMORY_PROFILE_CONTEXT);
 
   DriverInfoList = ContextData->DriverInfoList;
@@ -1620,6 +1689,7 @@ SmramProfileGetDataSize (
 
   TotalSize += (sizeof (MEMORY_PROFILE_FREE_MEMORY) + Index * sizeof (MEMORY_PROFILE_DESCRIPTOR));
   TotalSize += (sizeof (MEMORY_PROFILE_MEMORY_RANGE) + mFullSmramRangeCount * sizeof (MEMORY_PROFILE_DESCRIPTOR));
+  TotalSize += (sizeof (MEMORY_PROFILE_POOL_USAGE) + SmramProfileGetPoolStatisticsCount () * sizeof (MEMORY_PROFILE_POOL_STATISTICS));
 
   return TotalSize;
 }
@@ -1661,6 +1731,8 @@ SmramProfileCopyData (
   MEMORY_PROFILE_FREE_MEMORY      *FreeMemory;
   MEMORY_PROFILE_MEMORY_RANGE     *MemoryRange;
   MEMORY_PROFILE_DESCRIPTOR       *MemoryProfileDescriptor;
+  MEMORY_PROFILE_POOL_USAGE       *PoolUsage;
+  SMM_POOL_CPU_CACHE              *Cache;
   UINT64                          Offset;
   UINT64                          RemainingSize;
   UINTN                           PdbSize;
@@ -1672,6 +1744,11 @@ SmramProfileCopyData (
     return ;
   }
 
+  //
+  // The free blocks held in the pool caches are reported in the free pool lists.
+  //
+  SmmPoolCacheFlush ();
+
   RemainingSize = *ProfileSize;
   Offset = 0;
 
@@ -1860,6 +1937,55 @@ SmramProfileCopyData (
     Offset += sizeof (MEMORY_PROFILE_DESCRIPTOR);
   }
 
+  if (*ProfileOffset < (Offset + sizeof (MEMORY_PROFILE_POOL_USAGE))) {
+    if (RemainingSize >= sizeof (MEMORY_PROFILE_POOL_USAGE)) {
+      PoolUsage = ProfileBuffer;
+      ZeroMem (PoolUsage, sizeof (MEMORY_PROFILE_POOL_USAGE));
+      PoolUsage->Header.Signature = MEMORY_PROFILE_POOL_USAGE_SIGNATURE;
+      PoolUsage->Header.Length = sizeof (MEMORY_PROFILE_POOL_USAGE);
+      PoolUsage->Header.Revision = MEMORY_PROFILE_POOL_USAGE_REVISION;
+      PoolUsage->CurrentSize = mSmmPoolUsage.CurrentSize;
+      PoolUsage->PeakSize = mSmmPoolUsage.PeakSize;
+      PoolUsage->PoolStatisticsCount = (UINT32) SmramProfileGetPoolStatisticsCount ();
+
+      RemainingSize -= sizeof (MEMORY_PROFILE_POOL_USAGE);
+      ProfileBuffer = (UINT8 *) ProfileBuffer + sizeof (MEMORY_PROFILE_POOL_USAGE);
+    } else {
+      goto Done;
+    }
+  }
+  Offset += sizeof (MEMORY_PROFILE_POOL_USAGE);
+  if (*ProfileOffset < (Offset + sizeof (MEMORY_PROFILE_POOL_STATISTICS))) {
+    if (RemainingSize >= sizeof (MEMORY_PROFILE_POOL_STATISTICS)) {
+      SmramProfileFillPoolStatistics (ProfileBuffer, MEMORY_PROFILE_POOL_NO_CACHE_APIC_ID, 0, 0, &mSmmPoolUsage.Statistics);
+
+      RemainingSize -= sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+      ProfileBuffer = (UINT8 *) ProfileBuffer + sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+    } else {
+      goto Done;
+    }
+  }
+  Offset += sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+  if (FeaturePcdGet (PcdSmmPoolCpuCacheEnable)) {
+    for (Index = 0; Index < SMM_POOL_CACHE_COUNT; Index++) {
+      Cache = &mSmmPoolCpuCache[Index];
+      if (Cache->ApicId == SMM_POOL_CACHE_UNUSED_APIC_ID) {
+        continue;
+      }
+      if (*ProfileOffset < (Offset + sizeof (MEMORY_PROFILE_POOL_STATISTICS))) {
+        if (RemainingSize >= sizeof (MEMORY_PROFILE_POOL_STATISTICS)) {
+          SmramProfileFillPoolStatistics (ProfileBuffer, Cache->ApicId, Cache->CachedSize, Cache->PeakCachedSize, &Cache->Statistics);
+
+          RemainingSize -= sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+          ProfileBuffer = (UINT8 *) ProfileBuffer + sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+        } else {
+          goto Done;
+        }
+      }
+      Offset += sizeof (MEMORY_PROFILE_POOL_STATISTICS);
+    }
+  }
+
 Done:
   //
   // On output, actual profile data size copied.
@@ -2796,6 +2922,76 @@ DumpSmramProfile (
   mSmramProfileGettingStatus = SmramProfileGettingStatus;
 }
 
+/**
+  Dump SMRAM pool allocation and free statistics.
+
+  @param[in] Statistics  The statistics to dump.
+
+**/
+VOID
+DumpSmmPoolStatisticsData (
+  IN SMM_POOL_STATISTICS  *Statistics
+  )
+{
+  DEBUG ((DEBUG_INFO, "    AllocateCount    - 0x%016lx\n", Statistics->AllocateCount));
+  DEBUG ((DEBUG_INFO, "    CacheHitCount    - 0x%016lx\n", Statistics->CacheHitCount));
+  DEBUG ((DEBUG_INFO, "    FreeCount        - 0x%016lx\n", Statistics->FreeCount));
+  DEBUG ((DEBUG_INFO, "    RemoteFreeCount  - 0x%016lx\n", Statistics->RemoteFreeCount));
+  if (Statistics->AllocateCount != 0) {
+    DEBUG ((DEBUG_INFO, "    AllocateTicks    - 0x%016lx (Avg 0x%lx, Max 0x%lx)\n", Statistics->AllocateTicks, DivU64x64Remainder (Statistics->AllocateTicks, Statistics->AllocateCount, NULL), Statistics->MaxAllocateTicks));
+  }
+  if (Statistics->FreeCount != 0) {
+    DEBUG ((DEBUG_INFO, "    FreeTicks        - 0x%016lx (Avg 0x%lx, Max 0x%lx)\n", Statistics->FreeTicks, DivU64x64Remainder (Statistics->FreeTicks, Statistics->FreeCount, NULL), Statistics->MaxFreeTicks));
+  }
+}
+
+/**
+  Dump SMRAM pool usage and the pool caches.
+
+**/
+VOID
+DumpSmmPoolStatistics (
+  VOID
+  )
+{
+  SMM_POOL_CPU_CACHE            *Cache;
+  UINTN                         Index;
+  MEMORY_PROFILE_CONTEXT_DATA   *ContextData;
+  BOOLEAN                       SmramProfileGettingStatus;
+
+  ContextData = GetSmramProfileContext ();
+  if (ContextData == NULL) {
+    return ;
+  }
+
+  SmramProfileGettingStatus = mSmramProfileGettingStatus;
+  mSmramProfileGettingStatus = TRUE;
+
+  DEBUG ((DEBUG_INFO, "======= SmmPoolStatistics begin =======\n"));
+  DEBUG ((DEBUG_INFO, "SmmPool:\n"));
+  DEBUG ((DEBUG_INFO, "  CurrentSize        - 0x%016lx\n", (UINT64) mSmmPoolUsage.CurrentSize));
+  DEBUG ((DEBUG_INFO, "  PeakSize           - 0x%016lx\n", (UINT64) mSmmPoolUsage.PeakSize));
+  DEBUG ((DEBUG_INFO, "  NoPoolCache:\n"));
+  DumpSmmPoolStatisticsData (&mSmmPoolUsage.Statistics);
+
+  if (FeaturePcdGet (PcdSmmPoolCpuCacheEnable)) {
+    for (Index = 0; Index < SMM_POOL_CACHE_COUNT; Index++) {
+      Cache = &mSmmPoolCpuCache[Index];
+      if (Cache->ApicId == SMM_POOL_CACHE_UNUSED_APIC_ID) {
+        continue;
+      }
+      DEBUG ((DEBUG_INFO, "  PoolCache(0x%x) - ApicId 0x%08x:\n", Index, Cache->ApicId));
+      DEBUG ((DEBUG_INFO, "    CachedSize       - 0x%016lx\n", (UINT64) Cache->CachedSize));
+      DEBUG ((DEBUG_INFO, "    PeakCachedSize   - 0x%016lx\n", (UINT64) Cache->PeakCachedSize));
+      DumpSmmPoolStatisticsData (&Cache->Statistics);
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "======= SmmPoolStatistics end =======\n"));
+
+  mSmramProfileGettingStatus = SmramProfileGettingStatus;
+}
+
 /**
   Dump SMRAM information.
 
@@ -2810,6 +3006,7 @@ DumpSmramInfo (
       DumpSmramProfile ();
       DumpFreePagesList ();
       DumpFreePoolList ();
+      DumpSmmPoolStatistics ();
       DumpSmramRange ();
     }
   );
@@ -179,6 +179,45 @@ typedef struct {
   //MEMORY_PROFILE_DESCRIPTOR     MemoryDescriptor[MemoryRangeCount];
 } MEMORY_PROFILE_MEMORY_RANGE;
 
+#define MEMORY_PROFILE_POOL_USAGE_SIGNATURE SIGNATURE_32 ('M','P','P','U')
+#define MEMORY_PROFILE_POOL_USAGE_REVISION 0x0001
+
+typedef struct {
+  MEMORY_PROFILE_COMMON_HEADER  Header;
+  UINT64                        CurrentSize;
+  UINT64                        PeakSize;
+  UINT32                        PoolStatisticsCount;
+  UINT8                         Reserved[4];
+  //MEMORY_PROFILE_POOL_STATISTICS  PoolStatistics[PoolStatisticsCount];
+} MEMORY_PROFILE_POOL_USAGE;
+
+#define MEMORY_PROFILE_POOL_STATISTICS_SIGNATURE SIGNATURE_32 ('M','P','P','S')
+#define MEMORY_PROFILE_POOL_STATISTICS_REVISION 0x0001
+
+//
+// ApicId of the statistics of the processors without a pool cache.
+//
+#define MEMORY_PROFILE_POOL_NO_CACHE_APIC_ID 0xFFFFFFFF
+
+typedef struct {
+  MEMORY_PROFILE_COMMON_HEADER  Header;
+  UINT32                        ApicId;
+  UINT8                         Reserved[4];
+  UINT64                        CachedSize;
+  UINT64                        PeakCachedSize;
+  UINT64                        AllocateCount;
+  UINT64                        CacheHitCount;
+  UINT64                        FreeCount;
+  UINT64                        RemoteFreeCount;
+  //
+  // Latency in TSC ticks, zero unless the latency is measured.
+  //
+  UINT64                        AllocateTicks;
+  UINT64                        MaxAllocateTicks;
+  UINT64                        FreeTicks;
+  UINT64                        MaxFreeTicks;
+} MEMORY_PROFILE_POOL_STATISTICS;
+
 //
 // UEFI memory profile layout:
 // +--------------------------------+
@@ -381,6 +420,12 @@ struct _EDKII_MEMORY_PROFILE_PROTOCOL {
 // +--------------------------------+
 // | MEMORY RANGE DESCRIPTOR(q)     |
 // +--------------------------------+
+// | POOL_USAGE                     |
+// +--------------------------------+
+// | POOL STATISTICS(1)             |
+// +--------------------------------+
+// | POOL STATISTICS(r)             |
+// +--------------------------------+
 //
 
 //
@@ -54,6 +54,23 @@ typedef struct  {
   UINT16  ExGuidIndex;          // Index of GuidTable in units of GUID.
 } DYNAMICEX_MAPPING;
 
+//
+// ExMapHashTable is a minimal perfect hash of the {Guid, ExTokenNumber} pairs
+// in ExMapTable, generated by the build tool. It holds ExMapHashSeedCount seeds
+// followed by ExTokenCount indexes of ExMapTable:
+//
+//   Seed  = ExMapHashTable[Hash (0, Guid, ExTokenNumber) % ExMapHashSeedCount]
+//   Index = ExMapHashTable[ExMapHashSeedCount + Hash (Seed, Guid, ExTokenNumber) % ExTokenCount]
+//
+// Hash is 32-bit FNV-1a over the GUID and the little-endian ExTokenNumber, with
+// PCD_EX_MAP_HASH_BASIS ^ (Seed * PCD_EX_MAP_HASH_SEED_PRIME) as offset basis,
+// followed by the MurmurHash3 finalizer. A pair not in ExMapTable still maps to
+// some index, so the entry must be compared after the lookup.
+//
+#define PCD_EX_MAP_HASH_BASIS       0x811C9DC5
+#define PCD_EX_MAP_HASH_PRIME       0x01000193
+#define PCD_EX_MAP_HASH_SEED_PRIME  0x9E3779B9
+
 typedef struct {
   UINT32  StringIndex;          // Offset in String Table in units of UINT8.
   UINT32  DefaultValueOffset;   // Offset of the Default Value.
@@ -96,7 +113,8 @@ typedef struct {
     UINT16                LocalTokenCount;      // LOCAL_TOKEN_NUMBER for all.
     UINT16                ExTokenCount;         // EX_TOKEN_NUMBER for DynamicEx.
     UINT16                GuidTableCount;       // The Number of Guid in GuidTable.
-    UINT8                 Pad[6];               // Pad bytes to satisfy the alignment.
+    UINT16                ExMapHashSeedCount;   // The Number of seeds in ExMapHashTable, 0 if there is no ExMapHashTable.
+    TABLE_OFFSET          ExMapHashTableOffset;
 
     //
     // Default initialized external PCD database binary structure
@@ -115,6 +133,7 @@ typedef struct {
     //VARIABLE_HEAD                  VariableHead[];          // HII PCD
     //UINT8                          StringTable[];           // String for String PCD value and HII PCD Variable Name. It can be accessed by StringTableOffset.
     //SIZE_INFO                      SizeTable[];             // MaxSize and CurSize for String PCD. It can be accessed by SizeTableOffset.
+    //UINT16                         ExMapHashTable[];        // Minimal perfect hash of DynamicEx PCD {Guid, ExTokenNumber}. It can be accessed by ExMapHashTableOffset.
     //UINT16                         ValueUint16[];
     //UINT8                          ValueUint8[];
     //BOOLEAN                        ValueBoolean[];
@@ -105,6 +105,40 @@ typedef struct {
 // +-------------------------------------+
 //
 
+#define SMM_CORE_SMI_LATENCY_DATABASE_SIGNATURE SIGNATURE_32 ('S','C','S','L')
+#define SMM_CORE_SMI_LATENCY_DATABASE_REVISION  0x0001
+
+//
+// Histogram[Index] counts the dispatches which take [2^Index, 2^(Index+1)) ticks,
+// except the last one, which counts all the dispatches which take 2^Index ticks or more.
+// The dispatches which take 0 tick are counted in Histogram[0].
+//
+#define SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT    32
+
+typedef struct {
+  SMM_CORE_DATABASE_COMMON_HEADER     Header;
+  EFI_GUID                            HandlerType;
+  UINT32                              HandlerCategory;
+  UINT8                               Reserved[4];
+  PHYSICAL_ADDRESS                    CallerAddr;
+  PHYSICAL_ADDRESS                    Handler;
+  UINT64                              DispatchCount;
+  UINT64                              MinTicks;
+  UINT64                              MaxTicks;
+  UINT64                              TotalTicks;
+  //
+  // The upper bound of the histogram bucket holding the 99th percentile dispatch.
+  //
+  UINT64                              P99Ticks;
+  UINT64                              Histogram[SMM_CORE_SMI_LATENCY_HISTOGRAM_COUNT];
+} SMM_CORE_SMI_LATENCY_DATABASE_STRUCTURE;
+
+//
+// The latency database holds one SMM_CORE_SMI_LATENCY_DATABASE_STRUCTURE for each root
+// and GUID SMI handler, in timer ticks of the CPU timestamp counter. It is a snapshot
+// taken by SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_INFO.
+//
+
 
 
 //
@@ -112,6 +146,12 @@ typedef struct {
 //
 #define SMI_HANDLER_PROFILE_COMMAND_GET_INFO           0x1
 #define SMI_HANDLER_PROFILE_COMMAND_GET_DATA_BY_OFFSET 0x2
+//
+// Use SMI_HANDLER_PROFILE_PARAMETER_GET_INFO and SMI_HANDLER_PROFILE_PARAMETER_GET_DATA_BY_OFFSET
+// to get the SMI handler latency database.
+//
+#define SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_INFO           0x3
+#define SMI_HANDLER_PROFILE_COMMAND_GET_LATENCY_DATA_BY_OFFSET 0x4
 
 typedef struct {
   UINT32                            Command;
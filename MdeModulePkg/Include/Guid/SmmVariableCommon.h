@@ -77,6 +77,15 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO                14
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH followed by
+// SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY structures.
+//
+#define SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_BATCH               15
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT
+//
+#define SMM_VARIABLE_FUNCTION_INIT_VARIABLE_BATCH_CONTEXT           16
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -138,6 +147,7 @@ typedef struct {
   VARIABLE_STORE_HEADER   *RuntimeHobCache;
   VARIABLE_STORE_HEADER   *RuntimeNvCache;
   VARIABLE_STORE_HEADER   *RuntimeVolatileCache;
+  UINT32                  *Sequence;  // Optional, odd while SMM is updating the runtime caches
 } SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT;
 
 typedef struct {
@@ -147,4 +157,53 @@ typedef struct {
   BOOLEAN                 AuthenticatedVariableUsage;
 } SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO;
 
+///
+/// This structure is used to communicate with SMI handler by GetNextVariableBatch.
+///
+/// Guid, NameSize and Name are the cursor: the variables following it are returned, and an empty
+/// Name starts the enumeration. The variables are returned as SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY
+/// structures, starting at SMM_VARIABLE_BATCH_ENTRY_OFFSET (NameSize) and filling the rest of the payload.
+///
+typedef struct {
+  EFI_GUID    Guid;
+  UINTN       NameSize;       // Cursor name size
+  UINTN       VariableCount;  // Return number of variables
+  UINTN       EntriesSize;    // Return size of the entries, or size needed for the next variable
+  CHAR16      Name[1];
+} SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH;
+
+///
+/// This structure describes one variable returned by GetNextVariableBatch. It is followed by the
+/// variable name and the variable data. EntrySize is aligned to 8 bytes.
+///
+typedef struct {
+  UINT32      EntrySize;
+  UINT32      Attributes;
+  UINT32      NameSize;
+  UINT32      DataSize;
+  EFI_GUID    Guid;
+} SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY;
+
+///
+/// This structure is used to communicate with SMI handler by InitVariableBatchContext.
+///
+/// StoreGeneration is incremented by SMM every time it updates the variable store, so the
+/// variables returned by GetNextVariableBatch are current as long as it does not change.
+///
+typedef struct {
+  UINT32      *StoreGeneration;
+} SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT;
+
+///
+/// Offset of the first SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY in the GetNextVariableBatch payload.
+///
+#define SMM_VARIABLE_BATCH_ENTRY_OFFSET(NameSize) \
+  ALIGN_VALUE (OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH, Name) + (NameSize), sizeof (UINT64))
+
+///
+/// Size of the SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY for a variable.
+///
+#define SMM_VARIABLE_BATCH_ENTRY_SIZE(NameSize, DataSize) \
+  ALIGN_VALUE (sizeof (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY) + (NameSize) + (DataSize), sizeof (UINT64))
+
 #endif // _SMM_VARIABLE_COMMON_H_
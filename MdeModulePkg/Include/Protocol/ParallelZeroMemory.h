@@ -0,0 +1,63 @@
+/** @file
+  EDK II Parallel Zero Memory Protocol.
+
+  The protocol zeroes large ranges of memory with all the enabled processors,
+  so that consumers clearing multi-gigabyte buffers do not serialize on the
+  BSP.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL_H__
+#define __EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL_H__
+
+///
+/// EDK II Parallel Zero Memory Protocol GUID value
+///
+#define EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL_GUID \
+  { \
+    0x987fab6d, 0xb1fc, 0x4762, { 0x85, 0x7e, 0x06, 0xb7, 0xd8, 0xd2, 0x10, 0x08 } \
+  }
+
+typedef struct _EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL;
+
+/**
+  Fill a range of memory with zeros, using all the enabled processors.
+
+  The range is split in chunks taken by the processors closest to the memory
+  of each chunk when the platform describes its proximity domains. The
+  function returns when the whole range is zeroed. It zeroes the range on the
+  calling processor only when the APs cannot be used, for instance at or above
+  TPL_NOTIFY.
+
+  @param[in] This     The protocol instance pointer.
+  @param[in] Buffer   The start of the range to zero.
+  @param[in] Length   The length in bytes of the range to zero.
+
+  @retval EFI_SUCCESS             The range is zeroed.
+  @retval EFI_INVALID_PARAMETER   Buffer is NULL and Length is not 0, or the
+                                  range wraps around the address space.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_PARALLEL_ZERO_MEMORY)(
+  IN EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL  *This,
+  IN VOID                                 *Buffer,
+  IN UINTN                                Length
+  );
+
+///
+/// EDK II Parallel Zero Memory Protocol structure
+///
+struct _EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL {
+  EDKII_PARALLEL_ZERO_MEMORY  ZeroMemory;
+};
+
+///
+/// EDK II Parallel Zero Memory Protocol GUID variable.
+///
+extern EFI_GUID gEdkiiParallelZeroMemoryProtocolGuid;
+
+#endif
@@ -19,6 +19,13 @@ NONTESTED_MEMORY_RANGE  *mCurrentRange;
 UINT64                  mTestedSystemMemory;
 UINT64                  mNonTestedSystemMemory;
 
+//
+// Time spent in the R/W/V memory test and the extended memory it covered,
+// for the time-to-test metric.
+//
+UINT64                  mMemoryTestTicks;
+UINT64                  mMemoryTestBytes;
+
 UINT32                  GenericMemoryTestMonoPattern[GENERIC_CACHELINE_SIZE / 4] = {
   0x5a5a5a5a,
   0xa5a5a5a5,
@@ -309,24 +316,68 @@ ConstructNonTestedMemoryRange (
 }
 
 /**
-  Write the memory test pattern into a range of physical memory.
+  Check if the memory test covers every byte of the range with a pattern
+  repeating every 8 bytes.
+
+  Such a range is written with SetMem64(), which BaseMemoryLib instances
+  implement with non-temporal stores where the CPU has them, instead of
+  going through the data cache one pattern at a time.
+
+  @param[in]  Private   Point to generic memory test driver's private data.
+  @param[in]  Size      The memory range's size.
+  @param[out] Pattern   The 8-byte pattern.
+
+  @retval TRUE    The range is covered by Pattern.
+  @retval FALSE   The range must be tested one pattern at a time.
+
+**/
+BOOLEAN
+IsDenseMemoryPattern (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  UINT64                       Size,
+  OUT UINT64                       *Pattern
+  )
+{
+  UINT64  *MonoPattern;
+  UINTN   Index;
+
+  if ((Private->CoverageSpan != Private->MonoTestSize) ||
+      ((Private->MonoTestSize % sizeof (UINT64)) != 0) ||
+      ((Size % Private->MonoTestSize) != 0)) {
+    return FALSE;
+  }
+
+  MonoPattern = Private->MonoPattern;
+  for (Index = 1; Index < Private->MonoTestSize / sizeof (UINT64); Index++) {
+    if (ReadUnaligned64 (&MonoPattern[Index]) != ReadUnaligned64 (&MonoPattern[0])) {
+      return FALSE;
+    }
+  }
+
+  *Pattern = ReadUnaligned64 (&MonoPattern[0]);
+  return TRUE;
+}
+
+/**
+  Write the memory test pattern into a range of physical memory, without
+  flushing the data cache.
+
+  This function may run on the APs.
 
   @param[in] Private  Point to generic memory test driver's private data.
   @param[in] Start    The memory range's start address.
   @param[in] Size     The memory range's size.
 
-  @retval EFI_SUCCESS Successful write the test pattern into the non-tested memory.
-  @retval Others      The test pattern may not really write into the physical memory.
-
 **/
-EFI_STATUS
-WriteMemory (
+VOID
+WriteMemoryPattern (
   IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
   IN  EFI_PHYSICAL_ADDRESS         Start,
   IN  UINT64                       Size
   )
 {
   EFI_PHYSICAL_ADDRESS  Address;
+  UINT64                Pattern;
 
   Address = Start;
 
@@ -335,13 +386,48 @@ WriteMemory (
   // NOTE: Without page table, there is no way to use memory above 4G.
   //
   if (Start + Size > MAX_ADDRESS) {
-    return EFI_SUCCESS;
+    return;
+  }
+
+  if (IsDenseMemoryPattern (Private, Size, &Pattern)) {
+    SetMem64 ((VOID *) (UINTN) Start, (UINTN) Size, Pattern);
+    return;
   }
 
   while (Address < (Start + Size)) {
     CopyMem ((VOID *) (UINTN) Address, Private->MonoPattern, Private->MonoTestSize);
     Address += Private->CoverageSpan;
   }
+}
+
+/**
+  Write the memory test pattern into a range of physical memory.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS Successful write the test pattern into the non-tested memory.
+  @retval Others      The test pattern may not really write into the physical memory.
+
+**/
+EFI_STATUS
+WriteMemory (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  )
+{
+  //
+  // Add 4G memory address check for IA32 platform
+  // NOTE: Without page table, there is no way to use memory above 4G.
+  //
+  if (Start + Size > MAX_ADDRESS) {
+    return EFI_SUCCESS;
+  }
+
+  WriteMemoryPattern (Private, Start, Size);
+
   //
   // bug bug: we may need GCD service to make the code cache and data uncache,
   // if GCD do not support it or return fail, then just flush the whole cache.
@@ -354,32 +440,35 @@ WriteMemory (
 }
 
 /**
-  Verify the range of physical memory which covered by memory test pattern.
+  Check that a range of physical memory holds the memory test pattern.
 
-  This function will also do not return any informatin just cause system reset,
-  because the handle error encount fatal error and disable the bad DIMMs.
+  This function may run on the APs, the caller reports the error.
 
-  @param[in] Private  Point to generic memory test driver's private data.
-  @param[in] Start    The memory range's start address.
-  @param[in] Size     The memory range's size.
+  @param[in]  Private       Point to generic memory test driver's private data.
+  @param[in]  Start         The memory range's start address.
+  @param[in]  Size          The memory range's size.
+  @param[out] ErrorAddress  The address of the first mis-compare.
 
-  @retval EFI_SUCCESS Successful verify the range of memory, no errors' location found.
-  @retval Others      The range of memory have errors contained.
+  @retval EFI_SUCCESS       The range of memory holds the pattern.
+  @retval EFI_DEVICE_ERROR  The range of memory has a mis-compare at ErrorAddress.
 
 **/
 EFI_STATUS
-VerifyMemory (
+CheckMemoryPattern (
   IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
   IN  EFI_PHYSICAL_ADDRESS         Start,
-  IN  UINT64                       Size
+  IN  UINT64                       Size,
+  OUT EFI_PHYSICAL_ADDRESS         *ErrorAddress
   )
 {
-  EFI_PHYSICAL_ADDRESS            Address;
-  INTN                            ErrorFound;
-  EFI_MEMORY_EXTENDED_ERROR_DATA  *ExtendedErrorData;
+  EFI_PHYSICAL_ADDRESS  Address;
+  INTN                  ErrorFound;
+  UINT64                Pattern;
+  volatile UINT64       *Word;
+  UINTN                 Index;
+  UINTN                 Count;
 
-  Address           = Start;
-  ExtendedErrorData = NULL;
+  Address = Start;
 
   //
   // Add 4G memory address check for IA32 platform
@@ -389,11 +478,23 @@ VerifyMemory (
     return EFI_SUCCESS;
   }
 
-  //
-  // Use the software memory test to check whether have detected miscompare
-  // error here. If there is miscompare error here then check if generic
-  // memory test driver can disable the bad DIMM.
-  //
+  if (IsDenseMemoryPattern (Private, Size, &Pattern)) {
+    //
+    // Compare 8 bytes at a time, the mis-compare is reported at the start of
+    // its pattern as in the byte compare.
+    //
+    Word  = (volatile UINT64 *) (UINTN) Start;
+    Count = (UINTN) DivU64x32 (Size, sizeof (UINT64));
+    for (Index = 0; Index < Count; Index++) {
+      if (Word[Index] != Pattern) {
+        *ErrorAddress = Start + (Index * sizeof (UINT64)) - ((Index * sizeof (UINT64)) % Private->MonoTestSize);
+        return EFI_DEVICE_ERROR;
+      }
+    }
+
+    return EFI_SUCCESS;
+  }
+
   while (Address < (Start + Size)) {
     ErrorFound = CompareMemWithoutCheckArgument (
                   (VOID *) (UINTN) (Address),
@@ -401,32 +502,7 @@ VerifyMemory (
                   Private->MonoTestSize
                   );
     if (ErrorFound != 0) {
-      //
-      // Report uncorrectable errors
-      //
-      ExtendedErrorData = AllocateZeroPool (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA));
-      if (ExtendedErrorData == NULL) {
-        return EFI_OUT_OF_RESOURCES;
-      }
-
-      ExtendedErrorData->DataHeader.HeaderSize  = (UINT16) sizeof (EFI_STATUS_CODE_DATA);
-      ExtendedErrorData->DataHeader.Size        = (UINT16) (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA) - sizeof (EFI_STATUS_CODE_DATA));
-      ExtendedErrorData->Granularity            = EFI_MEMORY_ERROR_DEVICE;
-      ExtendedErrorData->Operation              = EFI_MEMORY_OPERATION_READ;
-      ExtendedErrorData->Syndrome               = 0x0;
-      ExtendedErrorData->Address                = Address;
-      ExtendedErrorData->Resolution             = 0x40;
-
-      REPORT_STATUS_CODE_EX (
-          EFI_ERROR_CODE,
-          EFI_COMPUTING_UNIT_MEMORY | EFI_CU_MEMORY_EC_UNCORRECTABLE,
-          0,
-          &gEfiGenericMemTestProtocolGuid,
-          NULL,
-          (UINT8 *) ExtendedErrorData + sizeof (EFI_STATUS_CODE_DATA),
-          ExtendedErrorData->DataHeader.Size
-          );
-
+      *ErrorAddress = Address;
       return EFI_DEVICE_ERROR;
     }
 
@@ -436,6 +512,121 @@ VerifyMemory (
   return EFI_SUCCESS;
 }
 
+/**
+  Report an uncorrectable memory error found by the memory test.
+
+  @param[in] Address  The address of the mis-compare.
+
+  @retval EFI_DEVICE_ERROR      The error is reported.
+  @retval EFI_OUT_OF_RESOURCES  The error data could not be allocated.
+
+**/
+EFI_STATUS
+ReportMemoryError (
+  IN  EFI_PHYSICAL_ADDRESS         Address
+  )
+{
+  EFI_MEMORY_EXTENDED_ERROR_DATA  *ExtendedErrorData;
+
+  //
+  // Report uncorrectable errors
+  //
+  ExtendedErrorData = AllocateZeroPool (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA));
+  if (ExtendedErrorData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ExtendedErrorData->DataHeader.HeaderSize  = (UINT16) sizeof (EFI_STATUS_CODE_DATA);
+  ExtendedErrorData->DataHeader.Size        = (UINT16) (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA) - sizeof (EFI_STATUS_CODE_DATA));
+  ExtendedErrorData->Granularity            = EFI_MEMORY_ERROR_DEVICE;
+  ExtendedErrorData->Operation              = EFI_MEMORY_OPERATION_READ;
+  ExtendedErrorData->Syndrome               = 0x0;
+  ExtendedErrorData->Address                = Address;
+  ExtendedErrorData->Resolution             = 0x40;
+
+  REPORT_STATUS_CODE_EX (
+      EFI_ERROR_CODE,
+      EFI_COMPUTING_UNIT_MEMORY | EFI_CU_MEMORY_EC_UNCORRECTABLE,
+      0,
+      &gEfiGenericMemTestProtocolGuid,
+      NULL,
+      (UINT8 *) ExtendedErrorData + sizeof (EFI_STATUS_CODE_DATA),
+      ExtendedErrorData->DataHeader.Size
+      );
+
+  return EFI_DEVICE_ERROR;
+}
+
+/**
+  Verify the range of physical memory which covered by memory test pattern.
+
+  This function will also do not return any informatin just cause system reset,
+  because the handle error encount fatal error and disable the bad DIMMs.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS Successful verify the range of memory, no errors' location found.
+  @retval Others      The range of memory have errors contained.
+
+**/
+EFI_STATUS
+VerifyMemory (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  ErrorAddress;
+
+  //
+  // Use the software memory test to check whether have detected miscompare
+  // error here. If there is miscompare error here then check if generic
+  // memory test driver can disable the bad DIMM.
+  //
+  Status = CheckMemoryPattern (Private, Start, Size, &ErrorAddress);
+  if (EFI_ERROR (Status)) {
+    return ReportMemoryError (ErrorAddress);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the number of performance counter ticks between two values of the
+  counter.
+
+  @param[in] StartTicks  The counter at the start of the interval.
+  @param[in] EndTicks    The counter at the end of the interval.
+
+  @return The number of ticks elapsed.
+
+**/
+UINT64
+GetElapsedTicks (
+  IN UINT64  StartTicks,
+  IN UINT64  EndTicks
+  )
+{
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart < CounterEnd) {
+    if (EndTicks >= StartTicks) {
+      return EndTicks - StartTicks;
+    }
+    return (CounterEnd - StartTicks) + (EndTicks - CounterStart);
+  }
+
+  if (StartTicks >= EndTicks) {
+    return StartTicks - EndTicks;
+  }
+  return (StartTicks - CounterEnd) + (CounterStart - EndTicks);
+}
+
 /**
   Initialize the generic memory test.
 
@@ -492,6 +683,17 @@ InitializeMemoryTest (
   if (!EFI_ERROR (Status)) {
     Private->Cpu = Cpu;
   }
+
+  //
+  // Test one block per enabled processor at a time when the APs take part in
+  // the memory test, so that each of them has a block's worth of work per
+  // call while the progress is still reported to BDS.
+  //
+  InitializeParallelMemoryTest (Private);
+  if (Private->MpServices != NULL) {
+    Private->BdsBlockSize = MultU64x32 (TEST_BLOCK_SIZE, (UINT32) Private->NumberOfEnabledProcessors);
+  }
+
   //
   // Create the CoverageSpan of the memory test base on the coverage level
   //
@@ -528,6 +730,10 @@ InitializeMemoryTest (
   mCurrentLink        = Private->NonTestedMemRanList.ForwardLink;
   mCurrentRange       = NONTESTED_MEMORY_RANGE_FROM_LINK (mCurrentLink);
   mCurrentAddress     = mCurrentRange->StartAddress;
+  mMemoryTestTicks    = 0;
+  mMemoryTestBytes    = 0;
+
+  PERF_INMODULE_BEGIN ("MemoryTest");
 
   return EFI_SUCCESS;
 }
@@ -561,6 +767,7 @@ GenPerformMemoryTest (
   GENERIC_MEMORY_TEST_PRIVATE     *Private;
   EFI_MEMORY_RANGE_EXTENDED_DATA  *RangeData;
   UINT64                          BlockBoundary;
+  UINT64                          StartTicks;
 
   Private       = GENERIC_MEMORY_TEST_PRIVATE_FROM_THIS (This);
   *ErrorOut     = FALSE;
@@ -608,9 +815,16 @@ GenPerformMemoryTest (
       // The software memory test (R/W/V) perform here. It will detect the
       // memory mis-compare error.
       //
-      WriteMemory (Private, mCurrentAddress, BlockBoundary);
+      StartTicks = GetPerformanceCounter ();
+      if (Private->MpServices != NULL) {
+        Status = ParallelRangeTest (Private, mCurrentAddress, BlockBoundary);
+      } else {
+        WriteMemory (Private, mCurrentAddress, BlockBoundary);
 
-      Status = VerifyMemory (Private, mCurrentAddress, BlockBoundary);
+        Status = VerifyMemory (Private, mCurrentAddress, BlockBoundary);
+      }
+      mMemoryTestTicks += GetElapsedTicks (StartTicks, GetPerformanceCounter ());
+      mMemoryTestBytes += BlockBoundary;
       if (EFI_ERROR (Status)) {
         //
         // If perform here, means there is mis-compare error, and no agent can
@@ -676,6 +890,21 @@ GenMemoryTestFinished (
 
   Private = GENERIC_MEMORY_TEST_PRIVATE_FROM_THIS (This);
 
+  PERF_INMODULE_END ("MemoryTest");
+
+  //
+  // Report the time-to-test metric of the R/W/V memory test
+  //
+  if (mMemoryTestBytes != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "GenericMemoryTest: %ld MB tested in %ld ms on %d processor(s)\n",
+      RShiftU64 (mMemoryTestBytes, 20),
+      DivU64x32 (GetTimeInNanoSecond (mMemoryTestTicks), 1000000),
+      (Private->MpServices != NULL) ? Private->NumberOfEnabledProcessors : 1
+      ));
+  }
+
   //
   // Perform Data and Address line test only if not ignore memory test
   //
@@ -848,7 +1077,17 @@ GENERIC_MEMORY_TEST_PRIVATE mGenericMemoryTestPrivate = {
   {
     NULL,
     NULL
-  }
+  },
+  {
+    ParallelZeroMemory
+  },
+  FALSE,
+  NULL,
+  0,
+  0,
+  NULL,
+  NULL,
+  0
 };
 
 /**
@@ -913,13 +1152,15 @@ GenericMemoryTestEntryPoint (
     break;
   }
   //
-  // Install the protocol
+  // Install the protocols
   //
-  Status = gBS->InstallProtocolInterface (
+  Status = gBS->InstallMultipleProtocolInterfaces (
                   &mGenericMemoryTestPrivate.Handle,
                   &gEfiGenericMemTestProtocolGuid,
-                  EFI_NATIVE_INTERFACE,
-                  &mGenericMemoryTestPrivate.GenericMemoryTest
+                  &mGenericMemoryTestPrivate.GenericMemoryTest,
+                  &gEdkiiParallelZeroMemoryProtocolGuid,
+                  &mGenericMemoryTestPrivate.ParallelZeroMemory,
+                  NULL
                   );
 
   return Status;
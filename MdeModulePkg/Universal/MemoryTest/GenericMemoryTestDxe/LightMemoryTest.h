@@ -11,8 +11,11 @@
 #define _GENERIC_MEMORY_TEST_H_
 
 #include <Guid/StatusCodeDataTypeId.h>
+#include <IndustryStandard/Acpi.h>
 #include <Protocol/GenericMemoryTest.h>
+#include <Protocol/ParallelZeroMemory.h>
 #include <Protocol/Cpu.h>
+#include <Protocol/MpService.h>
 
 #include <Library/DebugLib.h>
 #include <Library/UefiDriverEntryPoint.h>
@@ -21,8 +24,13 @@
 #include <Library/ReportStatusCodeLib.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
+#include <Library/PerformanceLib.h>
 
 //
 // Some global define
@@ -43,6 +51,26 @@
 #define QUICK_SPAN_SIZE   (TEST_BLOCK_SIZE >> 2)
 #define SPARSE_SPAN_SIZE  (TEST_BLOCK_SIZE >> 4)
 
+//
+// When the APs take part in the memory test or in zeroing memory, the range
+// is split in about PARALLEL_CHUNKS_PER_PROCESSOR chunks per processor, none
+// smaller than PARALLEL_MIN_CHUNK_SIZE. Ranges smaller than
+// PARALLEL_ZERO_MIN_LENGTH are zeroed on the calling processor.
+//
+#define PARALLEL_CHUNKS_PER_PROCESSOR  4
+#define PARALLEL_MIN_CHUNK_SIZE        SIZE_1MB
+#define PARALLEL_ZERO_MIN_LENGTH       SIZE_16MB
+
+//
+// This structure records a memory range of a proximity domain, from the
+// Memory Affinity structures of the ACPI SRAT.
+//
+typedef struct {
+  EFI_PHYSICAL_ADDRESS  StartAddress;
+  UINT64                Length;
+  UINT32                Domain;
+} MEMORY_AFFINITY_RANGE;
+
 //
 // This structure records every nontested memory range parsed through GCD
 // service.
@@ -110,6 +138,28 @@ typedef struct {
   //
   LIST_ENTRY                    NonTestedMemRanList;
 
+  //
+  // parallel zero memory protocol produced with the memory test protocol
+  //
+  EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL  ParallelZeroMemory;
+
+  //
+  // MP services used to run the memory test and the zeroing on the APs, NULL
+  // when the memory test runs on the BSP only
+  //
+  BOOLEAN                           ParallelProbed;
+  EFI_MP_SERVICES_PROTOCOL          *MpServices;
+  UINTN                             NumberOfProcessors;
+  UINTN                             NumberOfEnabledProcessors;
+
+  //
+  // proximity domain of every processor and of the memory ranges, NULL when
+  // the platform has no SRAT
+  //
+  UINT32                            *ProcessorDomain;
+  MEMORY_AFFINITY_RANGE             *MemoryAffinity;
+  UINTN                             MemoryAffinityCount;
+
 } GENERIC_MEMORY_TEST_PRIVATE;
 
 #define GENERIC_MEMORY_TEST_PRIVATE_FROM_THIS(a) \
@@ -120,6 +170,14 @@ typedef struct {
   EFI_GENERIC_MEMORY_TEST_PRIVATE_SIGNATURE \
   )
 
+#define GENERIC_MEMORY_TEST_PRIVATE_FROM_ZERO_MEMORY(a) \
+  CR ( \
+  a, \
+  GENERIC_MEMORY_TEST_PRIVATE, \
+  ParallelZeroMemory, \
+  EFI_GENERIC_MEMORY_TEST_PRIVATE_SIGNATURE \
+  )
+
 //
 // Function Prototypes
 //
@@ -213,6 +271,60 @@ WriteMemory (
   IN  UINT64                       Size
   );
 
+/**
+  Write the memory test pattern into a range of physical memory, without
+  flushing the data cache.
+
+  This function may run on the APs.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+**/
+VOID
+WriteMemoryPattern (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  );
+
+/**
+  Check that a range of physical memory holds the memory test pattern.
+
+  This function may run on the APs, the caller reports the error.
+
+  @param[in]  Private       Point to generic memory test driver's private data.
+  @param[in]  Start         The memory range's start address.
+  @param[in]  Size          The memory range's size.
+  @param[out] ErrorAddress  The address of the first mis-compare.
+
+  @retval EFI_SUCCESS       The range of memory holds the pattern.
+  @retval EFI_DEVICE_ERROR  The range of memory has a mis-compare at ErrorAddress.
+
+**/
+EFI_STATUS
+CheckMemoryPattern (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size,
+  OUT EFI_PHYSICAL_ADDRESS         *ErrorAddress
+  );
+
+/**
+  Report an uncorrectable memory error found by the memory test.
+
+  @param[in] Address  The address of the mis-compare.
+
+  @retval EFI_DEVICE_ERROR      The error is reported.
+  @retval EFI_OUT_OF_RESOURCES  The error data could not be allocated.
+
+**/
+EFI_STATUS
+ReportMemoryError (
+  IN  EFI_PHYSICAL_ADDRESS         Address
+  );
+
 /**
   Verify the range of physical memory which covered by memory test pattern.
 
@@ -332,4 +444,56 @@ GenCompatibleRangeTest (
   IN  UINT64                                   Length
   );
 
+/**
+  Look for the MP services and the proximity domains of the processors and
+  of the memory, once.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+InitializeParallelMemoryTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  );
+
+/**
+  Perform the R/W/V memory test of a range of physical memory with all the
+  enabled processors.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS       The range of memory passed the test.
+  @retval EFI_DEVICE_ERROR  The range of memory has errors, they are reported.
+  @retval Others            The error could not be reported.
+
+**/
+EFI_STATUS
+ParallelRangeTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  );
+
+/**
+  Fill a range of memory with zeros, using all the enabled processors.
+
+  @param[in] This     The protocol instance pointer.
+  @param[in] Buffer   The start of the range to zero.
+  @param[in] Length   The length in bytes of the range to zero.
+
+  @retval EFI_SUCCESS             The range is zeroed.
+  @retval EFI_INVALID_PARAMETER   Buffer is NULL and Length is not 0, or the
+                                  range wraps around the address space.
+
+**/
+EFI_STATUS
+EFIAPI
+ParallelZeroMemory (
+  IN EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL  *This,
+  IN VOID                                 *Buffer,
+  IN UINTN                                Length
+  );
+
 #endif
@@ -0,0 +1,579 @@
+/** @file
+  Run the memory test and the zeroing of memory on all the enabled processors.
+
+  A range is split in chunks which the processors take one at a time. When
+  the platform publishes an ACPI SRAT, every processor first takes the chunks
+  in its own proximity domain and only then helps with the other ones, so
+  that most of the memory is written and read by the processors closest to
+  it.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LightMemoryTest.h"
+
+typedef enum {
+  ParallelWritePattern,
+  ParallelCheckPattern,
+  ParallelZero
+} PARALLEL_MEMORY_OPERATION;
+
+typedef struct {
+  GENERIC_MEMORY_TEST_PRIVATE  *Private;
+  PARALLEL_MEMORY_OPERATION    Operation;
+  EFI_PHYSICAL_ADDRESS         Start;
+  UINT64                       Length;
+  UINT64                       ChunkSize;
+  UINTN                        ChunkCount;
+  //
+  // Proximity domain of every chunk, and whether a processor took it
+  //
+  UINT32                       *ChunkDomain;
+  volatile UINT32              *ChunkTaken;
+  //
+  // First mis-compare found by ParallelCheckPattern, MAX_UINT64 if none
+  //
+  volatile UINT64              ErrorAddress;
+} PARALLEL_MEMORY_JOB;
+
+/**
+  Get the proximity domain of a memory address.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Address  The memory address.
+
+  @return The proximity domain of Address, 0 when it is unknown.
+
+**/
+UINT32
+GetMemoryDomain (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Address
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Private->MemoryAffinityCount; Index++) {
+    if ((Address >= Private->MemoryAffinity[Index].StartAddress) &&
+        (Address - Private->MemoryAffinity[Index].StartAddress < Private->MemoryAffinity[Index].Length)) {
+      return Private->MemoryAffinity[Index].Domain;
+    }
+  }
+
+  return 0;
+}
+
+/**
+  Record the proximity domain of a processor found in the SRAT.
+
+  @param[in] Private    Point to generic memory test driver's private data.
+  @param[in] ApicIds    The APIC ID of every processor.
+  @param[in] ApicId     The APIC ID of the SRAT structure.
+  @param[in] Domain     The proximity domain of the SRAT structure.
+
+**/
+VOID
+SetProcessorDomain (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  UINT64                       *ApicIds,
+  IN  UINT64                       ApicId,
+  IN  UINT32                       Domain
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Private->NumberOfProcessors; Index++) {
+    if (ApicIds[Index] == ApicId) {
+      Private->ProcessorDomain[Index] = Domain;
+      return;
+    }
+  }
+}
+
+/**
+  Get the proximity domains of the processors and of the memory from the
+  ACPI SRAT, if the platform has one.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+ParseSystemResourceAffinityTable (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  )
+{
+  EFI_STATUS                                                   Status;
+  EFI_ACPI_DESCRIPTION_HEADER                                  *Srat;
+  UINT8                                                        *Entry;
+  UINT8                                                        *End;
+  EFI_ACPI_3_0_PROCESSOR_LOCAL_APIC_SAPIC_AFFINITY_STRUCTURE   *ApicAffinity;
+  EFI_ACPI_3_0_MEMORY_AFFINITY_STRUCTURE                       *MemoryAffinity;
+  EFI_ACPI_4_0_PROCESSOR_LOCAL_X2APIC_AFFINITY_STRUCTURE       *X2ApicAffinity;
+  EFI_PROCESSOR_INFORMATION                                    ProcessorInfo;
+  UINT64                                                       *ApicIds;
+  UINTN                                                        Count;
+  UINTN                                                        Index;
+
+  Srat = (EFI_ACPI_DESCRIPTION_HEADER *) EfiLocateFirstAcpiTable (
+                                           EFI_ACPI_4_0_SYSTEM_RESOURCE_AFFINITY_TABLE_SIGNATURE
+                                           );
+  if ((Srat == NULL) || (Srat->Length <= sizeof (EFI_ACPI_3_0_SYSTEM_RESOURCE_AFFINITY_TABLE_HEADER))) {
+    return;
+  }
+  End = (UINT8 *) Srat + Srat->Length;
+
+  //
+  // Count the enabled memory ranges.
+  //
+  Count = 0;
+  for (Entry = (UINT8 *) Srat + sizeof (EFI_ACPI_3_0_SYSTEM_RESOURCE_AFFINITY_TABLE_HEADER);
+       (Entry + 2 <= End) && (Entry[1] != 0) && (Entry + Entry[1] <= End);
+       Entry += Entry[1]) {
+    MemoryAffinity = (EFI_ACPI_3_0_MEMORY_AFFINITY_STRUCTURE *) Entry;
+    if ((MemoryAffinity->Type == EFI_ACPI_3_0_MEMORY_AFFINITY) &&
+        (MemoryAffinity->Length >= sizeof (EFI_ACPI_3_0_MEMORY_AFFINITY_STRUCTURE)) &&
+        ((MemoryAffinity->Flags & EFI_ACPI_3_0_MEMORY_ENABLED) != 0)) {
+      Count++;
+    }
+  }
+  if (Count == 0) {
+    return;
+  }
+
+  ApicIds                  = AllocateZeroPool (Private->NumberOfProcessors * sizeof (UINT64));
+  Private->ProcessorDomain = AllocateZeroPool (Private->NumberOfProcessors * sizeof (UINT32));
+  Private->MemoryAffinity  = AllocateZeroPool (Count * sizeof (MEMORY_AFFINITY_RANGE));
+  if ((ApicIds == NULL) || (Private->ProcessorDomain == NULL) || (Private->MemoryAffinity == NULL)) {
+    goto ON_ERROR;
+  }
+
+  for (Index = 0; Index < Private->NumberOfProcessors; Index++) {
+    Status = Private->MpServices->GetProcessorInfo (Private->MpServices, Index, &ProcessorInfo);
+    ApicIds[Index] = EFI_ERROR (Status) ? MAX_UINT64 : ProcessorInfo.ProcessorId;
+  }
+
+  for (Entry = (UINT8 *) Srat + sizeof (EFI_ACPI_3_0_SYSTEM_RESOURCE_AFFINITY_TABLE_HEADER);
+       (Entry + 2 <= End) && (Entry[1] != 0) && (Entry + Entry[1] <= End);
+       Entry += Entry[1]) {
+    switch (Entry[0]) {
+    case EFI_ACPI_3_0_PROCESSOR_LOCAL_APIC_SAPIC_AFFINITY:
+      ApicAffinity = (EFI_ACPI_3_0_PROCESSOR_LOCAL_APIC_SAPIC_AFFINITY_STRUCTURE *) Entry;
+      if ((ApicAffinity->Length >= sizeof (EFI_ACPI_3_0_PROCESSOR_LOCAL_APIC_SAPIC_AFFINITY_STRUCTURE)) &&
+          ((ApicAffinity->Flags & EFI_ACPI_3_0_PROCESSOR_LOCAL_APIC_SAPIC_ENABLED) != 0)) {
+        SetProcessorDomain (
+          Private,
+          ApicIds,
+          ApicAffinity->ApicId,
+          ApicAffinity->ProximityDomain7To0 |
+          (ApicAffinity->ProximityDomain31To8[0] << 8) |
+          (ApicAffinity->ProximityDomain31To8[1] << 16) |
+          ((UINT32) ApicAffinity->ProximityDomain31To8[2] << 24)
+          );
+      }
+      break;
+
+    case EFI_ACPI_4_0_PROCESSOR_LOCAL_X2APIC_AFFINITY:
+      X2ApicAffinity = (EFI_ACPI_4_0_PROCESSOR_LOCAL_X2APIC_AFFINITY_STRUCTURE *) Entry;
+      if ((X2ApicAffinity->Length >= sizeof (EFI_ACPI_4_0_PROCESSOR_LOCAL_X2APIC_AFFINITY_STRUCTURE)) &&
+          ((X2ApicAffinity->Flags & EFI_ACPI_4_0_PROCESSOR_LOCAL_APIC_SAPIC_ENABLED) != 0)) {
+        SetProcessorDomain (Private, ApicIds, X2ApicAffinity->X2ApicId, X2ApicAffinity->ProximityDomain);
+      }
+      break;
+
+    case EFI_ACPI_3_0_MEMORY_AFFINITY:
+      MemoryAffinity = (EFI_ACPI_3_0_MEMORY_AFFINITY_STRUCTURE *) Entry;
+      if ((MemoryAffinity->Length >= sizeof (EFI_ACPI_3_0_MEMORY_AFFINITY_STRUCTURE)) &&
+          ((MemoryAffinity->Flags & EFI_ACPI_3_0_MEMORY_ENABLED) != 0)) {
+        Private->MemoryAffinity[Private->MemoryAffinityCount].StartAddress =
+          LShiftU64 (MemoryAffinity->AddressBaseHigh, 32) | MemoryAffinity->AddressBaseLow;
+        Private->MemoryAffinity[Private->MemoryAffinityCount].Length =
+          LShiftU64 (MemoryAffinity->LengthHigh, 32) | MemoryAffinity->LengthLow;
+        Private->MemoryAffinity[Private->MemoryAffinityCount].Domain = MemoryAffinity->ProximityDomain;
+        Private->MemoryAffinityCount++;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  FreePool (ApicIds);
+  return;
+
+ON_ERROR:
+  if (ApicIds != NULL) {
+    FreePool (ApicIds);
+  }
+  if (Private->ProcessorDomain != NULL) {
+    FreePool (Private->ProcessorDomain);
+    Private->ProcessorDomain = NULL;
+  }
+  if (Private->MemoryAffinity != NULL) {
+    FreePool (Private->MemoryAffinity);
+    Private->MemoryAffinity = NULL;
+  }
+}
+
+/**
+  Look for the MP services and the proximity domains of the processors and
+  of the memory, once.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+InitializeParallelMemoryTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  )
+{
+  EFI_STATUS                Status;
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+
+  if (Private->ParallelProbed) {
+    return;
+  }
+  Private->ParallelProbed = TRUE;
+
+  Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **) &MpServices);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (
+                         MpServices,
+                         &Private->NumberOfProcessors,
+                         &Private->NumberOfEnabledProcessors
+                         );
+  if (EFI_ERROR (Status) || (Private->NumberOfEnabledProcessors < 2)) {
+    return;
+  }
+
+  Private->MpServices = MpServices;
+  ParseSystemResourceAffinityTable (Private);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "GenericMemoryTest: %d processors, %d memory affinity ranges\n",
+    Private->NumberOfEnabledProcessors,
+    Private->MemoryAffinityCount
+    ));
+}
+
+/**
+  Perform an operation on a range of memory on the calling processor.
+
+  @param[in]  Private       Point to generic memory test driver's private data.
+  @param[in]  Operation     The operation.
+  @param[in]  Start         The memory range's start address.
+  @param[in]  Length        The memory range's size.
+  @param[out] ErrorAddress  The address of the first mis-compare of
+                            ParallelCheckPattern.
+
+  @retval EFI_SUCCESS       The operation is performed.
+  @retval EFI_DEVICE_ERROR  ParallelCheckPattern found a mis-compare.
+
+**/
+EFI_STATUS
+RunMemoryOperation (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  PARALLEL_MEMORY_OPERATION    Operation,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Length,
+  OUT EFI_PHYSICAL_ADDRESS         *ErrorAddress
+  )
+{
+  switch (Operation) {
+  case ParallelWritePattern:
+    WriteMemoryPattern (Private, Start, Length);
+    return EFI_SUCCESS;
+
+  case ParallelCheckPattern:
+    return CheckMemoryPattern (Private, Start, Length, ErrorAddress);
+
+  default:
+    ZeroMem ((VOID *) (UINTN) Start, (UINTN) Length);
+    return EFI_SUCCESS;
+  }
+}
+
+/**
+  Take the chunks of a job until there is none left.
+
+  The processor takes the chunks of its proximity domain first, starting at
+  a position depending on its number so that the processors of a domain do
+  not contend for the same chunks. A processor which wrote the pattern into
+  a chunk writes back and invalidates its data cache before it returns.
+
+  @param[in] Buffer   The job.
+
+**/
+VOID
+EFIAPI
+ParallelMemoryProcedure (
+  IN OUT VOID  *Buffer
+  )
+{
+  EFI_STATUS                   Status;
+  PARALLEL_MEMORY_JOB          *Job;
+  GENERIC_MEMORY_TEST_PRIVATE  *Private;
+  UINTN                        ProcessorNumber;
+  UINT32                       Domain;
+  UINTN                        First;
+  UINTN                        Pass;
+  UINTN                        Index;
+  UINTN                        Chunk;
+  EFI_PHYSICAL_ADDRESS         ChunkStart;
+  UINT64                       ChunkLength;
+  EFI_PHYSICAL_ADDRESS         ErrorAddress;
+  BOOLEAN                      Written;
+
+  Job     = (PARALLEL_MEMORY_JOB *) Buffer;
+  Private = Job->Private;
+  Written = FALSE;
+
+  Status = Private->MpServices->WhoAmI (Private->MpServices, &ProcessorNumber);
+  if (EFI_ERROR (Status) || (ProcessorNumber >= Private->NumberOfProcessors)) {
+    ProcessorNumber = 0;
+  }
+  Domain = (Private->ProcessorDomain != NULL) ? Private->ProcessorDomain[ProcessorNumber] : 0;
+  First  = (UINTN) DivU64x64Remainder (
+                     MultU64x64 (ProcessorNumber, Job->ChunkCount),
+                     Private->NumberOfProcessors,
+                     NULL
+                     );
+
+  for (Pass = 0; Pass < 2; Pass++) {
+    for (Index = 0; Index < Job->ChunkCount; Index++) {
+      Chunk = (First + Index) % Job->ChunkCount;
+      if ((Pass == 0) && (Job->ChunkDomain[Chunk] != Domain)) {
+        continue;
+      }
+      if ((Job->ChunkTaken[Chunk] != 0) ||
+          (InterlockedCompareExchange32 (&Job->ChunkTaken[Chunk], 0, 1) != 0)) {
+        continue;
+      }
+      if (Job->ErrorAddress != MAX_UINT64) {
+        return;
+      }
+
+      ChunkStart  = Job->Start + MultU64x64 (Chunk, Job->ChunkSize);
+      ChunkLength = MIN (Job->ChunkSize, Job->Start + Job->Length - ChunkStart);
+      Status = RunMemoryOperation (Private, Job->Operation, ChunkStart, ChunkLength, &ErrorAddress);
+      if (EFI_ERROR (Status)) {
+        InterlockedCompareExchange64 (&Job->ErrorAddress, MAX_UINT64, ErrorAddress);
+        return;
+      }
+      if (Job->Operation == ParallelWritePattern) {
+        Written = TRUE;
+      }
+    }
+  }
+
+  //
+  // The pattern written by this processor may still sit in its own caches,
+  // where the flush of the BSP does not reach, and the check would then read
+  // it back without touching the memory.
+  //
+  if (Written) {
+    WriteBackInvalidateDataCache ();
+  }
+}
+
+/**
+  Perform an operation on a range of memory with all the enabled processors.
+
+  The range is done on the calling processor alone when the APs cannot be
+  used: without MP services, when the APs are busy, or at TPL_NOTIFY and
+  above where the completion of the APs is never signaled.
+
+  @param[in]  Private       Point to generic memory test driver's private data.
+  @param[in]  Operation     The operation.
+  @param[in]  Start         The memory range's start address.
+  @param[in]  Length        The memory range's size.
+  @param[in]  Granularity   The power of two the chunk size is a multiple of.
+  @param[out] ErrorAddress  The address of the first mis-compare of
+                            ParallelCheckPattern.
+
+  @retval EFI_SUCCESS       The operation is performed.
+  @retval EFI_DEVICE_ERROR  ParallelCheckPattern found a mis-compare.
+
+**/
+EFI_STATUS
+RunParallelMemoryJob (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  PARALLEL_MEMORY_OPERATION    Operation,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Length,
+  IN  UINT64                       Granularity,
+  OUT EFI_PHYSICAL_ADDRESS         *ErrorAddress
+  )
+{
+  EFI_STATUS           Status;
+  EFI_TPL              OldTpl;
+  EFI_EVENT            Event;
+  PARALLEL_MEMORY_JOB  Job;
+  UINTN                Index;
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (OldTpl);
+  if ((Private->MpServices == NULL) || (OldTpl >= TPL_NOTIFY)) {
+    return RunMemoryOperation (Private, Operation, Start, Length, ErrorAddress);
+  }
+
+  ZeroMem (&Job, sizeof (Job));
+  Job.Private      = Private;
+  Job.Operation    = Operation;
+  Job.Start        = Start;
+  Job.Length       = Length;
+  Job.ErrorAddress = MAX_UINT64;
+  Job.ChunkSize    = DivU64x64Remainder (
+                       Length,
+                       MultU64x32 (PARALLEL_CHUNKS_PER_PROCESSOR, (UINT32) Private->NumberOfEnabledProcessors),
+                       NULL
+                       );
+  Job.ChunkSize    = MAX (Job.ChunkSize, PARALLEL_MIN_CHUNK_SIZE);
+  Job.ChunkSize    = (Job.ChunkSize + Granularity - 1) & ~(Granularity - 1);
+  Job.ChunkCount   = (UINTN) DivU64x64Remainder (Length + Job.ChunkSize - 1, Job.ChunkSize, NULL);
+
+  Job.ChunkDomain  = AllocateZeroPool (Job.ChunkCount * sizeof (UINT32));
+  Job.ChunkTaken   = AllocateZeroPool (Job.ChunkCount * sizeof (UINT32));
+  if ((Job.ChunkDomain == NULL) || (Job.ChunkTaken == NULL)) {
+    Status = RunMemoryOperation (Private, Operation, Start, Length, ErrorAddress);
+    goto Done;
+  }
+  for (Index = 0; Index < Job.ChunkCount; Index++) {
+    Job.ChunkDomain[Index] = GetMemoryDomain (Private, Start + MultU64x64 (Index, Job.ChunkSize));
+  }
+
+  //
+  // The protocol only starts procedures on the APs, so they are started in
+  // non-blocking mode while the BSP takes chunks too, and the BSP then waits
+  // for the completion event.
+  //
+  Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Event);
+  if (EFI_ERROR (Status)) {
+    Status = RunMemoryOperation (Private, Operation, Start, Length, ErrorAddress);
+    goto Done;
+  }
+
+  Status = Private->MpServices->StartupAllAPs (
+                                  Private->MpServices,
+                                  ParallelMemoryProcedure,
+                                  FALSE,
+                                  Event,
+                                  0,
+                                  &Job,
+                                  NULL
+                                  );
+  ParallelMemoryProcedure (&Job);
+  if (!EFI_ERROR (Status)) {
+    while (gBS->CheckEvent (Event) == EFI_NOT_READY) {
+      CpuPause ();
+    }
+  }
+  gBS->CloseEvent (Event);
+
+  Status = EFI_SUCCESS;
+  if (Job.ErrorAddress != MAX_UINT64) {
+    *ErrorAddress = Job.ErrorAddress;
+    Status        = EFI_DEVICE_ERROR;
+  }
+
+Done:
+  if (Job.ChunkDomain != NULL) {
+    FreePool (Job.ChunkDomain);
+  }
+  if (Job.ChunkTaken != NULL) {
+    FreePool ((VOID *) Job.ChunkTaken);
+  }
+  return Status;
+}
+
+/**
+  Perform the R/W/V memory test of a range of physical memory with all the
+  enabled processors.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS       The range of memory passed the test.
+  @retval EFI_DEVICE_ERROR  The range of memory has errors, they are reported.
+  @retval Others            The error could not be reported.
+
+**/
+EFI_STATUS
+ParallelRangeTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  ErrorAddress;
+
+  //
+  // The chunks are multiples of the coverage span, so that the patterns are
+  // at the same addresses as when the BSP tests the range alone.
+  //
+  RunParallelMemoryJob (Private, ParallelWritePattern, Start, Size, Private->CoverageSpan, &ErrorAddress);
+
+  //
+  // Every processor which wrote a chunk has flushed its caches already. This
+  // covers the range when RunParallelMemoryJob() wrote it on the BSP alone.
+  //
+  if (Private->Cpu != NULL) {
+    Private->Cpu->FlushDataCache (Private->Cpu, Start, Size, EfiCpuFlushTypeWriteBackInvalidate);
+  }
+
+  Status = RunParallelMemoryJob (Private, ParallelCheckPattern, Start, Size, Private->CoverageSpan, &ErrorAddress);
+  if (EFI_ERROR (Status)) {
+    return ReportMemoryError (ErrorAddress);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Fill a range of memory with zeros, using all the enabled processors.
+
+  @param[in] This     The protocol instance pointer.
+  @param[in] Buffer   The start of the range to zero.
+  @param[in] Length   The length in bytes of the range to zero.
+
+  @retval EFI_SUCCESS             The range is zeroed.
+  @retval EFI_INVALID_PARAMETER   Buffer is NULL and Length is not 0, or the
+                                  range wraps around the address space.
+
+**/
+EFI_STATUS
+EFIAPI
+ParallelZeroMemory (
+  IN EDKII_PARALLEL_ZERO_MEMORY_PROTOCOL  *This,
+  IN VOID                                 *Buffer,
+  IN UINTN                                Length
+  )
+{
+  GENERIC_MEMORY_TEST_PRIVATE  *Private;
+  EFI_PHYSICAL_ADDRESS         ErrorAddress;
+
+  if (Length == 0) {
+    return EFI_SUCCESS;
+  }
+  if ((Buffer == NULL) || (Length - 1 > MAX_ADDRESS - (UINTN) Buffer)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Private = GENERIC_MEMORY_TEST_PRIVATE_FROM_ZERO_MEMORY (This);
+  InitializeParallelMemoryTest (Private);
+
+  if ((Private->MpServices == NULL) || (Length < PARALLEL_ZERO_MIN_LENGTH)) {
+    ZeroMem (Buffer, Length);
+    return EFI_SUCCESS;
+  }
+
+  RunParallelMemoryJob (Private, ParallelZero, (UINTN) Buffer, Length, SIZE_4KB, &ErrorAddress);
+  return EFI_SUCCESS;
+}
@@ -1565,53 +1565,88 @@ GetExPcdTokenNumber (
   IN CONST EFI_GUID             *Guid,
   IN UINT32                     ExTokenNumber
   )
+{
+  UINTN               TokenNumber;
+
+  if (!mPeiDatabaseEmpty) {
+    TokenNumber = GetExPcdTokenNumberFromDatabase (mPcdDatabase.PeiDb, mPeiGuidTableSize, Guid, ExTokenNumber);
+    if (TokenNumber != 0) {
+      return TokenNumber;
+    }
+  }
+
+  TokenNumber = GetExPcdTokenNumberFromDatabase (mPcdDatabase.DxeDb, mDxeGuidTableSize, Guid, ExTokenNumber);
+  //
+  // We need to ASSERT here. If {Guid, ExTokenNumber} can't be found in
+  // ExMapTable, this is a error in the BUILD system.
+  //
+  ASSERT (TokenNumber != 0);
+
+  return TokenNumber;
+}
+
+/**
+  Get Token Number of dynamic-ex PCD from the given PCD database.
+
+  The perfect hash in ExMapHashTable is used if the database has one,
+  otherwise GuidTable and ExMapTable are scanned.
+
+  @param Database        PEI or DXE PCD database.
+  @param GuidTableSize   Size of GuidTable in bytes.
+  @param Guid            Token space guid for dynamic-ex PCD entry.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Token Number for dynamic-ex PCD, 0 if it is not in the database.
+
+**/
+UINTN
+GetExPcdTokenNumberFromDatabase (
+  IN PCD_DATABASE_INIT          *Database,
+  IN UINTN                      GuidTableSize,
+  IN CONST EFI_GUID             *Guid,
+  IN UINT32                     ExTokenNumber
+  )
 {
   UINT32              Index;
   DYNAMICEX_MAPPING   *ExMap;
   EFI_GUID            *GuidTable;
   EFI_GUID            *MatchGuid;
   UINTN               MatchGuidIdx;
+  UINT16              *HashTable;
+  UINT16              Seed;
 
-  if (!mPeiDatabaseEmpty) {
-    ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)mPcdDatabase.PeiDb + mPcdDatabase.PeiDb->ExMapTableOffset);
-    GuidTable   = (EFI_GUID *)((UINT8 *)mPcdDatabase.PeiDb + mPcdDatabase.PeiDb->GuidTableOffset);
-
-    MatchGuid   = ScanGuid (GuidTable, mPeiGuidTableSize, Guid);
-
-    if (MatchGuid != NULL) {
+  if (Database->ExTokenCount == 0) {
+    return 0;
+  }
 
-      MatchGuidIdx = MatchGuid - GuidTable;
+  ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+  GuidTable   = (EFI_GUID *)((UINT8 *)Database + Database->GuidTableOffset);
 
-      for (Index = 0; Index < mPcdDatabase.PeiDb->ExTokenCount; Index++) {
-        if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-            (MatchGuidIdx == ExMap[Index].ExGuidIndex)) {
-            return ExMap[Index].TokenNumber;
-        }
-      }
+  if (Database->ExMapHashSeedCount != 0) {
+    HashTable = (UINT16 *)((UINT8 *)Database + Database->ExMapHashTableOffset);
+    Seed      = HashTable[PcdExMapHash (0, Guid, ExTokenNumber) % Database->ExMapHashSeedCount];
+    Index     = HashTable[Database->ExMapHashSeedCount + PcdExMapHash (Seed, Guid, ExTokenNumber) % Database->ExTokenCount];
+    if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
+        CompareGuid (Guid, &GuidTable[ExMap[Index].ExGuidIndex])) {
+      return ExMap[Index].TokenNumber;
     }
+    return 0;
   }
 
-  ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)mPcdDatabase.DxeDb + mPcdDatabase.DxeDb->ExMapTableOffset);
-  GuidTable   = (EFI_GUID *)((UINT8 *)mPcdDatabase.DxeDb + mPcdDatabase.DxeDb->GuidTableOffset);
-
-  MatchGuid   = ScanGuid (GuidTable, mDxeGuidTableSize, Guid);
-  //
-  // We need to ASSERT here. If GUID can't be found in GuidTable, this is a
-  // error in the BUILD system.
-  //
-  ASSERT (MatchGuid != NULL);
+  MatchGuid   = ScanGuid (GuidTable, GuidTableSize, Guid);
+  if (MatchGuid == NULL) {
+    return 0;
+  }
 
   MatchGuidIdx = MatchGuid - GuidTable;
 
-  for (Index = 0; Index < mPcdDatabase.DxeDb->ExTokenCount; Index++) {
+  for (Index = 0; Index < Database->ExTokenCount; Index++) {
     if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-         (MatchGuidIdx == ExMap[Index].ExGuidIndex)) {
-        return ExMap[Index].TokenNumber;
+        (MatchGuidIdx == ExMap[Index].ExGuidIndex)) {
+      return ExMap[Index].TokenNumber;
     }
   }
 
-  ASSERT (FALSE);
-
   return 0;
 }
 
@@ -29,11 +29,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 
+#include "../PcdExMapHash.h"
+
 //
 // Please make sure the PCD Serivce DXE Version is consistent with
 // the version of the generated DXE PCD Database by build tool.
 //
-#define PCD_SERVICE_DXE_VERSION      7
+#define PCD_SERVICE_DXE_VERSION      8
 
 //
 // PCD_DXE_SERVICE_DRIVER_VERSION is defined in Autogen.h.
@@ -1074,6 +1076,28 @@ GetExPcdTokenNumber (
   IN UINT32                     ExTokenNumber
   );
 
+/**
+  Get Token Number of dynamic-ex PCD from the given PCD database.
+
+  The perfect hash in ExMapHashTable is used if the database has one,
+  otherwise GuidTable and ExMapTable are scanned.
+
+  @param Database        PEI or DXE PCD database.
+  @param GuidTableSize   Size of GuidTable in bytes.
+  @param Guid            Token space guid for dynamic-ex PCD entry.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Token Number for dynamic-ex PCD, 0 if it is not in the database.
+
+**/
+UINTN
+GetExPcdTokenNumberFromDatabase (
+  IN PCD_DATABASE_INIT          *Database,
+  IN UINTN                      GuidTableSize,
+  IN CONST EFI_GUID             *Guid,
+  IN UINT32                     ExTokenNumber
+  );
+
 /**
   Get next token number in given token space.
 
@@ -0,0 +1,53 @@
+/** @file
+  Hash of dynamic-ex PCD's {token space guid:token number} shared by the PEI
+  and DXE PCD drivers.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Guid/PcdDataBaseSignatureGuid.h>
+
+#include "PcdExMapHash.h"
+
+/**
+  Calculate the hash of dynamic-ex PCD's {token space guid:token number} which
+  is used by ExMapHashTable. It must match the hash calculated by build tool.
+
+  @param Seed            Seed of the hash.
+  @param Guid            Token space guid for dynamic-ex PCD entry.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return The hash value.
+
+**/
+UINT32
+PcdExMapHash (
+  IN UINT32                     Seed,
+  IN CONST EFI_GUID             *Guid,
+  IN UINT32                     ExTokenNumber
+  )
+{
+  UINT32              Hash;
+  CONST UINT8         *Data;
+  UINTN               Index;
+
+  Hash = PCD_EX_MAP_HASH_BASIS ^ (Seed * PCD_EX_MAP_HASH_SEED_PRIME);
+
+  Data = (CONST UINT8 *) Guid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Data[Index]) * PCD_EX_MAP_HASH_PRIME;
+  }
+  for (Index = 0; Index < sizeof (UINT32); Index++) {
+    Hash = (Hash ^ (UINT8) (ExTokenNumber >> (Index * 8))) * PCD_EX_MAP_HASH_PRIME;
+  }
+
+  Hash ^= Hash >> 16;
+  Hash *= 0x85EBCA6B;
+  Hash ^= Hash >> 13;
+  Hash *= 0xC2B2AE35;
+  Hash ^= Hash >> 16;
+
+  return Hash;
+}
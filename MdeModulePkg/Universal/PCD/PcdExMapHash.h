@@ -0,0 +1,33 @@
+/** @file
+  Hash of dynamic-ex PCD's {token space guid:token number} shared by the PEI
+  and DXE PCD drivers.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _PCD_EX_MAP_HASH_H_
+#define _PCD_EX_MAP_HASH_H_
+
+#include <Uefi/UefiBaseType.h>
+
+/**
+  Calculate the hash of dynamic-ex PCD's {token space guid:token number} which
+  is used by ExMapHashTable. It must match the hash calculated by build tool.
+
+  @param Seed            Seed of the hash.
+  @param Guid            Token space guid for dynamic-ex PCD entry.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return The hash value.
+
+**/
+UINT32
+PcdExMapHash (
+  IN UINT32                     Seed,
+  IN CONST EFI_GUID             *Guid,
+  IN UINT32                     ExTokenNumber
+  );
+
+#endif
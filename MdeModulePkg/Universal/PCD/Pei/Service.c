@@ -984,12 +984,29 @@ GetExPcdTokenNumber (
   EFI_GUID            *MatchGuid;
   UINTN               MatchGuidIdx;
   PEI_PCD_DATABASE    *PeiPcdDb;
+  UINT16              *HashTable;
+  UINT16              Seed;
 
   PeiPcdDb    = GetPcdDatabase();
 
   ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)PeiPcdDb + PeiPcdDb->ExMapTableOffset);
   GuidTable   = (EFI_GUID *)((UINT8 *)PeiPcdDb + PeiPcdDb->GuidTableOffset);
 
+  if (PeiPcdDb->ExMapHashSeedCount != 0) {
+    //
+    // The perfect hash gives the only candidate in ExMapTable, which must
+    // still be verified because the key may not be in the database at all.
+    //
+    HashTable = (UINT16 *)((UINT8 *)PeiPcdDb + PeiPcdDb->ExMapHashTableOffset);
+    Seed      = HashTable[PcdExMapHash (0, Guid, (UINT32) ExTokenNumber) % PeiPcdDb->ExMapHashSeedCount];
+    Index     = HashTable[PeiPcdDb->ExMapHashSeedCount + PcdExMapHash (Seed, Guid, (UINT32) ExTokenNumber) % PeiPcdDb->ExTokenCount];
+    if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
+        CompareGuid (Guid, &GuidTable[ExMap[Index].ExGuidIndex])) {
+      return ExMap[Index].TokenNumber;
+    }
+    return PCD_INVALID_TOKEN_NUMBER;
+  }
+
   MatchGuid = ScanGuid (GuidTable, PeiPcdDb->GuidTableCount * sizeof(EFI_GUID), Guid);
   //
   // We need to ASSERT here. If GUID can't be found in GuidTable, this is a
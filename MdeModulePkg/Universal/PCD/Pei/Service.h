@@ -27,11 +27,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+#include "../PcdExMapHash.h"
+
 //
 // Please make sure the PCD Serivce PEIM Version is consistent with
 // the version of the generated PEIM PCD Database by build tool.
 //
-#define PCD_SERVICE_PEIM_VERSION      7
+#define PCD_SERVICE_PEIM_VERSION      8
 
 //
 // PCD_PEI_SERVICE_DRIVER_VERSION is defined in Autogen.h.
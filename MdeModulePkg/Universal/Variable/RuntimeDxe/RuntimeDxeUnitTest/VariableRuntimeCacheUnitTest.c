@@ -0,0 +1,1348 @@
+/** @file
+  This is a host-based unit test for the runtime variable cache updates and the runtime cache
+  readers of the SMM variable wrapper driver.
+
+  An SMI stops the reader at an arbitrary point of its read. The interleaving tests place that
+  point deterministically: they run the writer between every two chunks a reader copies, and run
+  readers while the writer is stopped inside an update. The real readers are interrupted from
+  AtRuntime(), which the variable parsing functions call for every variable they visit. The stress
+  test then runs writer and reader threads concurrently on POSIX threads, and the readers yield
+  from AtRuntime() so that the writers run in the middle of their reads even on a single CPU.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <Uefi.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../VariableParsing.h"
+#include "../VariableRuntimeCache.h"
+#include "../VariableRuntimeCacheReader.h"
+
+#define UNIT_TEST_NAME        "Variable Runtime Cache Unit Test"
+#define UNIT_TEST_VERSION     "1.0"
+
+#define TEST_STORE_SIZE       SIZE_4KB
+
+///
+/// The size of the chunks a simulated reader copies between two points the writer may run at.
+///
+#define TEST_READ_CHUNK_SIZE  256
+
+///
+/// The size of the communication buffer of the SMM variable wrapper driver in the reader tests.
+///
+#define TEST_VARIABLE_BUFFER_SIZE  0x80
+
+///
+/// The value the buffers a reader must not write are filled with.
+///
+#define TEST_SENTINEL         0x5A
+
+///
+/// The threads of the stress test, the updates each writer commits, and the reads each reader
+/// does at least.
+///
+#define TEST_STRESS_WRITER_COUNT  2
+#define TEST_STRESS_READER_COUNT  2
+#define TEST_STRESS_UPDATE_COUNT  20000
+#define TEST_STRESS_READ_MIN      1000
+
+typedef
+VOID
+(*TEST_WRITER) (
+  VOID
+  );
+
+///=== TEST DATA ==================================================================================
+
+VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
+VARIABLE_STORE_HEADER   *mNvVariableCache;
+
+VARIABLE_MODULE_GLOBAL  mTestModuleGlobal;
+BOOLEAN                 mVariableRuntimeCacheReadLock;
+BOOLEAN                 mVariableRuntimeCachePendingUpdate;
+BOOLEAN                 mHobFlushComplete;
+UINT32                  mVariableRuntimeCacheSequence;
+
+//
+// The state of the SMM variable wrapper driver the runtime cache readers use.
+//
+UINT8                   *mVariableBuffer;
+UINTN                   mVariableBufferSize;
+VARIABLE_INFO_ENTRY     *mVariableInfo;
+VARIABLE_STORE_HEADER   *mVariableRuntimeHobCacheBuffer;
+VARIABLE_STORE_HEADER   *mVariableRuntimeNvCacheBuffer;
+VARIABLE_STORE_HEADER   *mVariableRuntimeVolatileCacheBuffer;
+BOOLEAN                 mVariableAuthFormat;
+
+//
+// The variable stores owned by SMM and the runtime caches the runtime readers search.
+//
+UINT8                   mTestVolatileStore[TEST_STORE_SIZE];
+UINT8                   mTestNvStore[TEST_STORE_SIZE];
+UINT8                   mTestRuntimeVolatileCache[TEST_STORE_SIZE];
+UINT8                   mTestRuntimeNvCache[TEST_STORE_SIZE];
+
+//
+// The content of the volatile store before and after the update under test.
+//
+UINT8                   mTestOldSnapshot[TEST_STORE_SIZE];
+UINT8                   mTestNewSnapshot[TEST_STORE_SIZE];
+UINT8                   mTestReaderCopy[TEST_STORE_SIZE];
+
+//
+// The buffers the runtime cache readers return the variables in, each followed by a guard.
+//
+UINT8                   mTestVariableBuffer[TEST_VARIABLE_BUFFER_SIZE + TEST_STORE_SIZE];
+UINT8                   mTestReaderData[2 * TEST_STORE_SIZE];
+
+//
+// The variables of the reader tests.
+//
+CHAR16                  *mTestFirstName  = L"First";
+CHAR16                  *mTestSecondName = L"SecondVariable";
+EFI_GUID                mTestVendorGuid  = { 0x3a3c4d5e, 0x1f20, 0x4b3c, { 0x9d, 0x8e, 0x7f, 0x60, 0x51, 0x42, 0x33, 0x24 } };
+VARIABLE_HEADER         *mTestFirstVariable;
+VARIABLE_HEADER         *mTestSecondVariable;
+
+//
+// The SMM writer run from AtRuntime() when mTestWriterDelay reaches 0.
+//
+TEST_WRITER             mTestWriter;
+UINTN                   mTestWriterDelay;
+
+//
+// The names the stress test writers give the second variable. They have the same size and differ
+// in most characters, so a torn name matches none.
+//
+CHAR16                  *mTestStressNames[] = {
+  L"SecondVariable",
+  L"AlternateNames",
+  L"ThirdNameValue",
+  L"FourthVarNames"
+};
+
+//
+// The state of the stress test. SMM runs one SMI handler at a time and the OS does not call the
+// variable services concurrently, so the writers and the readers each take a lock of their own,
+// while writers and readers run in parallel.
+//
+pthread_mutex_t         mTestStressWriterLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t         mTestStressReaderLock = PTHREAD_MUTEX_INITIALIZER;
+BOOLEAN                 mTestStressPendingUpdate;
+volatile BOOLEAN        mTestStressRunning;
+UINTN                   mTestStressUpdate;
+volatile BOOLEAN        mTestStressDone;
+UINTN                   mTestStressDataReads;
+UINTN                   mTestStressNameReads;
+UINTN                   mTestStressMismatches;
+
+///=== HELPER FUNCTIONS ===========================================================================
+
+/**
+  Stub of the runtime check the variable parsing functions use. It is called for every variable
+  a reader visits, so the SMM writer scheduled by the test is run from here, and the stress test
+  readers yield to the writer threads from here.
+
+  @retval FALSE  The tests always run before ExitBootServices.
+
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  TEST_WRITER  Writer;
+
+  if ((mTestWriter != NULL) && (--mTestWriterDelay == 0)) {
+    Writer      = mTestWriter;
+    mTestWriter = NULL;
+    Writer ();
+  }
+
+  if (mTestStressRunning) {
+    sched_yield ();
+  }
+
+  return FALSE;
+}
+
+/**
+  Stub of the check for pending runtime cache updates of the SMM variable wrapper driver. The
+  tests never leave an update pending.
+
+**/
+VOID
+CheckForRuntimeCacheSync (
+  VOID
+  )
+{
+}
+
+/**
+  Checks that a buffer a reader must not write still holds TEST_SENTINEL.
+
+  @param[in]  Buffer  The buffer.
+  @param[in]  Length  The length of the buffer.
+
+  @retval TRUE   The buffer was not written.
+  @retval FALSE  The buffer was written.
+
+**/
+BOOLEAN
+IsSentinelIntact (
+  IN  UINT8   *Buffer,
+  IN  UINTN   Length
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Length; Index++) {
+    if (Buffer[Index] != TEST_SENTINEL) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Writes a variable-sized pattern to a range of a variable store, the way SMM writes a variable.
+
+  @param[in]  Store   The variable store.
+  @param[in]  Offset  The offset of the range.
+  @param[in]  Length  The length of the range.
+  @param[in]  Seed    The first byte of the pattern.
+
+**/
+VOID
+WriteTestPattern (
+  IN  UINT8   *Store,
+  IN  UINTN   Offset,
+  IN  UINTN   Length,
+  IN  UINT8   Seed
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Length; Index++) {
+    Store[Offset + Index] = (UINT8) (Seed + Index);
+  }
+}
+
+/**
+  Appends a variable to a variable store.
+
+  @param[in]  Variable  Where the variable is added.
+  @param[in]  Name      The name of the variable.
+  @param[in]  DataSize  The size of the data of the variable.
+  @param[in]  Seed      The first byte of the data pattern.
+
+  @return The end of the variable.
+
+**/
+VARIABLE_HEADER *
+AddTestVariable (
+  IN  VARIABLE_HEADER   *Variable,
+  IN  CHAR16            *Name,
+  IN  UINTN             DataSize,
+  IN  UINT8             Seed
+  )
+{
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = VAR_ADDED;
+  Variable->Attributes = EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
+  Variable->NameSize   = (UINT32) StrSize (Name);
+  Variable->DataSize   = (UINT32) DataSize;
+  CopyGuid (&Variable->VendorGuid, &mTestVendorGuid);
+  CopyMem (GetVariableNamePtr (Variable, FALSE), Name, Variable->NameSize);
+  WriteTestPattern (GetVariableDataPtr (Variable, FALSE), 0, DataSize, Seed);
+
+  return GetNextVariablePtr (Variable, FALSE);
+}
+
+/**
+  Tears the data size of the second variable in the runtime cache the way an update stopped in
+  the middle of its header does, so the data claims to extend beyond the end of the store.
+
+**/
+VOID
+TearSecondVariableDataSize (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Variable;
+
+  BeginRuntimeVariableCacheUpdate (&mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext);
+
+  Variable = (VARIABLE_HEADER *) (mTestRuntimeVolatileCache + ((UINT8 *) mTestSecondVariable - mTestVolatileStore));
+  Variable->DataSize = (UINT32) (mTestRuntimeVolatileCache + TEST_STORE_SIZE - GetVariableDataPtr (Variable, FALSE)) + 0x100;
+}
+
+/**
+  Tears the data of the second variable in the runtime cache the way an update stopped in the
+  middle of the data does. The sizes are intact, so only the sequence number shows the tear.
+
+**/
+VOID
+TearSecondVariableData (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Variable;
+
+  BeginRuntimeVariableCacheUpdate (&mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext);
+
+  Variable = (VARIABLE_HEADER *) (mTestRuntimeVolatileCache + ((UINT8 *) mTestSecondVariable - mTestVolatileStore));
+  WriteTestPattern (GetVariableDataPtr (Variable, FALSE), 0, Variable->DataSize / 2, 0xE0);
+}
+
+/**
+  Tears the name size of the first variable in the runtime cache the way an update stopped in
+  the middle of its header does, so the name does not fit in the communication buffer.
+
+**/
+VOID
+TearFirstVariableNameSize (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Variable;
+
+  BeginRuntimeVariableCacheUpdate (&mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext);
+
+  Variable = (VARIABLE_HEADER *) (mTestRuntimeVolatileCache + ((UINT8 *) mTestFirstVariable - mTestVolatileStore));
+  Variable->NameSize = TEST_VARIABLE_BUFFER_SIZE + 0x40;
+}
+
+/**
+  Changes the data of the second variable and flushes it to the runtime cache.
+
+**/
+VOID
+UpdateSecondVariableData (
+  VOID
+  )
+{
+  WriteTestPattern (GetVariableDataPtr (mTestSecondVariable, FALSE), 0, mTestSecondVariable->DataSize, 0xE0);
+  SynchronizeRuntimeVariableCache (
+    &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache,
+    0,
+    TEST_STORE_SIZE
+    );
+}
+
+/**
+  Completes the update stopped by a tear, flushing the variable store to the runtime cache.
+
+**/
+VOID
+CompleteTornUpdate (
+  VOID
+  )
+{
+  CopyMem (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE);
+  EndRuntimeVariableCacheUpdate (&mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext);
+}
+
+/**
+  Copies the runtime volatile cache the way a runtime reader does, running the SMM writer before
+  the chunk at WriterChunk.
+
+  @param[in]  WriterChunk  The chunk before which the writer runs, the number of chunks for the
+                           writer to run after the last chunk, or MAX_UINTN for no writer.
+  @param[in]  Offset       The offset of the update the writer flushes.
+  @param[in]  Length       The length of the update the writer flushes.
+
+  @retval TRUE   The reader must retry the copy.
+  @retval FALSE  The copy is consistent.
+
+**/
+BOOLEAN
+ReadRuntimeCacheInterleaved (
+  IN  UINTN   WriterChunk,
+  IN  UINTN   Offset,
+  IN  UINTN   Length
+  )
+{
+  UINT32  Start;
+  UINTN   Chunk;
+
+  Start = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  for (Chunk = 0; Chunk <= TEST_STORE_SIZE / TEST_READ_CHUNK_SIZE; Chunk++) {
+    if (Chunk == WriterChunk) {
+      SynchronizeRuntimeVariableCache (
+        &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache,
+        Offset,
+        Length
+        );
+    }
+
+    if (Chunk == TEST_STORE_SIZE / TEST_READ_CHUNK_SIZE) {
+      break;
+    }
+
+    CopyMem (
+      mTestReaderCopy + Chunk * TEST_READ_CHUNK_SIZE,
+      mTestRuntimeVolatileCache + Chunk * TEST_READ_CHUNK_SIZE,
+      TEST_READ_CHUNK_SIZE
+      );
+  }
+
+  return VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Start);
+}
+
+/**
+  Returns the size of the data the stress test writers give the first variable for a seed. It
+  depends on the second bit of the seed, so the variables also move when both writers committed
+  since a reader started. The sizes differ by the size of the second variable, so where one
+  layout has the second variable the other has the third, and a reader that follows a stale
+  pointer gets a name the second variable never had.
+
+  @param[in]  Seed  The first byte of the data pattern.
+
+  @return The size of the data.
+
+**/
+UINTN
+StressDataSize (
+  IN  UINT8   Seed
+  )
+{
+  return ((Seed & BIT1) == 0) ? 0x10 : 0x70;
+}
+
+/**
+  Commits an update of the volatile store and flushes it to the runtime cache, the way an SMI
+  handler does. The first variable gets new data of a new size, and the second one a new name.
+  The third variable follows them.
+
+**/
+VOID
+CommitStressUpdate (
+  VOID
+  )
+{
+  VARIABLE_RUNTIME_CACHE  *Cache;
+  VARIABLE_HEADER         *Variable;
+  UINT8                   Seed;
+
+  pthread_mutex_lock (&mTestStressWriterLock);
+
+  Seed                = (UINT8) mTestStressUpdate++;
+  mTestSecondVariable = AddTestVariable (mTestFirstVariable, mTestFirstName, StressDataSize (Seed), Seed);
+  Variable            = AddTestVariable (mTestSecondVariable, mTestStressNames[Seed % ARRAY_SIZE (mTestStressNames)], 0x20, 0xB0);
+  Variable            = AddTestVariable (Variable, L"ThirdVariable", 0x20, 0xC0);
+  SetMem (Variable, (UINTN) (mTestVolatileStore + TEST_STORE_SIZE - (UINT8 *) Variable), 0xFF);
+
+  Cache = &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache;
+  Cache->PendingUpdateOffset = 0;
+  Cache->PendingUpdateLength = TEST_STORE_SIZE;
+  mTestStressPendingUpdate   = TRUE;
+  FlushPendingRuntimeVariableCacheUpdates ();
+
+  pthread_mutex_unlock (&mTestStressWriterLock);
+}
+
+/**
+  A stress test writer. It yields after every update, the way SMIs leave the OS running between
+  them.
+
+  @param[in]  Argument  Unused.
+
+  @return NULL.
+
+**/
+VOID *
+StressWriterThread (
+  IN VOID   *Argument
+  )
+{
+  UINTN  Update;
+
+  for (Update = 0; Update < TEST_STRESS_UPDATE_COUNT; Update++) {
+    CommitStressUpdate ();
+    sched_yield ();
+  }
+
+  return NULL;
+}
+
+/**
+  Checks that the data of the first variable read by a reader is one the writers committed.
+
+  @param[in]  Data      The data read.
+  @param[in]  DataSize  The size of the data read.
+
+  @retval TRUE   The data is a committed value.
+  @retval FALSE  The data is torn.
+
+**/
+BOOLEAN
+IsCommittedStressData (
+  IN  UINT8   *Data,
+  IN  UINTN   DataSize
+  )
+{
+  UINTN  Index;
+
+  if ((DataSize == 0) || (DataSize != StressDataSize (Data[0]))) {
+    return FALSE;
+  }
+
+  for (Index = 1; Index < DataSize; Index++) {
+    if (Data[Index] != (UINT8) (Data[0] + Index)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks that the name of the second variable read by a reader is one the writers committed.
+
+  @param[in]  Name      The name read.
+  @param[in]  NameSize  The size of the name read.
+
+  @retval TRUE   The name is a committed value.
+  @retval FALSE  The name is torn.
+
+**/
+BOOLEAN
+IsCommittedStressName (
+  IN  CHAR16  *Name,
+  IN  UINTN   NameSize
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mTestStressNames); Index++) {
+    if ((NameSize == StrSize (mTestStressNames[Index])) &&
+        (CompareMem (Name, mTestStressNames[Index], NameSize) == 0)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  A stress test reader. It reads the data of the first variable and the name of the second one
+  through the real runtime cache readers until the writers are done. A read may fail with
+  EFI_NOT_READY when every attempt overlaps with an update, but a successful read must return a
+  committed value.
+
+  @param[in]  Argument  Unused.
+
+  @return NULL.
+
+**/
+VOID *
+StressReaderThread (
+  IN VOID   *Argument
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Read;
+  UINT8       Data[TEST_VARIABLE_BUFFER_SIZE];
+  UINTN       DataSize;
+  UINT32      Attributes;
+  CHAR16      VariableName[TEST_VARIABLE_BUFFER_SIZE];
+  UINTN       VariableNameSize;
+  EFI_GUID    VendorGuid;
+
+  for (Read = 0; !mTestStressDone || Read < TEST_STRESS_READ_MIN; Read++) {
+    pthread_mutex_lock (&mTestStressReaderLock);
+
+    DataSize = sizeof (Data);
+    Status   = FindVariableInRuntimeCache (mTestFirstName, &mTestVendorGuid, &Attributes, &DataSize, Data);
+    if (Status == EFI_SUCCESS) {
+      mTestStressDataReads++;
+      if (!IsCommittedStressData (Data, DataSize) || (Attributes != (EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS))) {
+        mTestStressMismatches++;
+      }
+    } else if (Status != EFI_NOT_READY) {
+      mTestStressMismatches++;
+    }
+
+    CopyMem (VariableName, mTestFirstName, StrSize (mTestFirstName));
+    CopyGuid (&VendorGuid, &mTestVendorGuid);
+    VariableNameSize = sizeof (VariableName);
+    Status = GetNextVariableNameInRuntimeCache (&VariableNameSize, VariableName, &VendorGuid);
+    if (Status == EFI_SUCCESS) {
+      mTestStressNameReads++;
+      if (!IsCommittedStressName (VariableName, VariableNameSize) || !CompareGuid (&VendorGuid, &mTestVendorGuid)) {
+        mTestStressMismatches++;
+      }
+    } else if (Status != EFI_NOT_READY) {
+      mTestStressMismatches++;
+    }
+
+    pthread_mutex_unlock (&mTestStressReaderLock);
+  }
+
+  return NULL;
+}
+
+/**
+  Sets up variable stores and runtime caches that are in sync.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The setup succeeded.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RuntimeCacheInit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+
+  WriteTestPattern (mTestVolatileStore, 0, TEST_STORE_SIZE, 0x10);
+  WriteTestPattern (mTestNvStore, 0, TEST_STORE_SIZE, 0x80);
+  CopyMem (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE);
+  CopyMem (mTestRuntimeNvCache, mTestNvStore, TEST_STORE_SIZE);
+
+  ZeroMem (&mTestModuleGlobal, sizeof (mTestModuleGlobal));
+  mTestModuleGlobal.VariableGlobal.VolatileVariableBase = (EFI_PHYSICAL_ADDRESS) (UINTN) mTestVolatileStore;
+  mVariableModuleGlobal = &mTestModuleGlobal;
+  mNvVariableCache      = (VARIABLE_STORE_HEADER *) mTestNvStore;
+
+  mVariableRuntimeCacheReadLock         = FALSE;
+  mVariableRuntimeCachePendingUpdate    = FALSE;
+  mHobFlushComplete = FALSE;
+  mVariableRuntimeCacheSequence         = 0;
+
+  CacheContext                   = &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext;
+  CacheContext->ReadLock         = &mVariableRuntimeCacheReadLock;
+  CacheContext->PendingUpdate    = &mVariableRuntimeCachePendingUpdate;
+  CacheContext->HobFlushComplete = &mHobFlushComplete;
+  CacheContext->Sequence         = &mVariableRuntimeCacheSequence;
+  CacheContext->VariableRuntimeVolatileCache.Store = (VARIABLE_STORE_HEADER *) mTestRuntimeVolatileCache;
+  CacheContext->VariableRuntimeNvCache.Store       = (VARIABLE_STORE_HEADER *) mTestRuntimeNvCache;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Sets up a volatile variable store with two variables, a runtime cache in sync with it, and the
+  state of the SMM variable wrapper driver the runtime cache readers use.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The setup succeeded.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RuntimeCacheReaderInit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_STORE_HEADER  *Store;
+  VARIABLE_HEADER        *Variable;
+
+  RuntimeCacheInit (Context);
+
+  SetMem (mTestVolatileStore, TEST_STORE_SIZE, 0xFF);
+  Store = (VARIABLE_STORE_HEADER *) mTestVolatileStore;
+  CopyGuid (&Store->Signature, &gEfiVariableGuid);
+  Store->Size   = TEST_STORE_SIZE;
+  Store->Format = VARIABLE_STORE_FORMATTED;
+  Store->State  = VARIABLE_STORE_HEALTHY;
+
+  mTestFirstVariable  = GetStartPointer (Store);
+  mTestSecondVariable = AddTestVariable (mTestFirstVariable, mTestFirstName, 0x10, 0xA0);
+  Variable            = AddTestVariable (mTestSecondVariable, mTestSecondName, 0x20, 0xB0);
+  UT_ASSERT_TRUE ((UINT8 *) Variable < mTestVolatileStore + TEST_STORE_SIZE / 2);
+
+  CopyMem (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE);
+
+  SetMem (mTestVariableBuffer, sizeof (mTestVariableBuffer), TEST_SENTINEL);
+  SetMem (mTestReaderData, sizeof (mTestReaderData), TEST_SENTINEL);
+  mVariableBuffer                     = mTestVariableBuffer;
+  mVariableBufferSize                 = TEST_VARIABLE_BUFFER_SIZE;
+  mVariableInfo                       = NULL;
+  mVariableRuntimeHobCacheBuffer      = NULL;
+  mVariableRuntimeNvCacheBuffer       = NULL;
+  mVariableRuntimeVolatileCacheBuffer = (VARIABLE_STORE_HEADER *) mTestRuntimeVolatileCache;
+  mVariableAuthFormat                 = FALSE;
+
+  mTestWriter      = NULL;
+  mTestWriterDelay = 0;
+
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST CASES =================================================================================
+
+///===== DELTA LOG SUITE ==================================================
+
+/**
+  Only the chunks that differ from the variable store should be logged and copied.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DeltaLogShouldOnlyHoldChangedRanges (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE        *Cache;
+  VARIABLE_RUNTIME_CACHE_DELTA  DeltaLog[VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE];
+  UINTN                         DeltaCount;
+
+  Cache = &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache;
+
+  //
+  // One changed byte, and two adjacent changed chunks that must be merged.
+  //
+  mTestVolatileStore[0x105] ^= 0xFF;
+  WriteTestPattern (mTestVolatileStore, 0x400, 0x80, 0xC0);
+  Cache->PendingUpdateOffset = 0;
+  Cache->PendingUpdateLength = TEST_STORE_SIZE;
+
+  DeltaCount = LogRuntimeVariableCacheDeltas (
+                 Cache,
+                 (VARIABLE_STORE_HEADER *) mTestVolatileStore,
+                 DeltaLog,
+                 VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE
+                 );
+  UT_ASSERT_EQUAL (DeltaCount, 2);
+  UT_ASSERT_EQUAL (DeltaLog[0].Offset, 0x100);
+  UT_ASSERT_EQUAL (DeltaLog[0].Length, VARIABLE_RUNTIME_CACHE_DELTA_GRANULARITY);
+  UT_ASSERT_EQUAL (DeltaLog[1].Offset, 0x400);
+  UT_ASSERT_EQUAL (DeltaLog[1].Length, 0x80);
+
+  ApplyRuntimeVariableCacheDeltas (Cache, (VARIABLE_STORE_HEADER *) mTestVolatileStore, DeltaLog, DeltaCount);
+  UT_ASSERT_MEM_EQUAL (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Changes outside the pending update should not be logged, and a full log should be extended
+  to the end of the pending update.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DeltaLogShouldCoverPendingUpdateWhenFull (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE        *Cache;
+  VARIABLE_RUNTIME_CACHE_DELTA  DeltaLog[2];
+  UINTN                         DeltaCount;
+
+  Cache = &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache;
+
+  mTestVolatileStore[0x010] ^= 0xFF;
+  mTestVolatileStore[0x200] ^= 0xFF;
+  mTestVolatileStore[0x300] ^= 0xFF;
+  mTestVolatileStore[0x500] ^= 0xFF;
+  mTestVolatileStore[0x900] ^= 0xFF;
+  Cache->PendingUpdateOffset = 0x200;
+  Cache->PendingUpdateLength = 0x600;
+
+  DeltaCount = LogRuntimeVariableCacheDeltas (
+                 Cache,
+                 (VARIABLE_STORE_HEADER *) mTestVolatileStore,
+                 DeltaLog,
+                 ARRAY_SIZE (DeltaLog)
+                 );
+  UT_ASSERT_EQUAL (DeltaCount, 2);
+  UT_ASSERT_EQUAL (DeltaLog[0].Offset, 0x200);
+  UT_ASSERT_EQUAL (DeltaLog[0].Length, VARIABLE_RUNTIME_CACHE_DELTA_GRANULARITY);
+  UT_ASSERT_EQUAL (DeltaLog[1].Offset, 0x300);
+  UT_ASSERT_EQUAL (DeltaLog[1].Length, 0x500 + VARIABLE_RUNTIME_CACHE_DELTA_GRANULARITY - 0x300);
+
+  ApplyRuntimeVariableCacheDeltas (Cache, (VARIABLE_STORE_HEADER *) mTestVolatileStore, DeltaLog, DeltaCount);
+  UT_ASSERT_EQUAL (mTestRuntimeVolatileCache[0x500], mTestVolatileStore[0x500]);
+  UT_ASSERT_NOT_EQUAL (mTestRuntimeVolatileCache[0x010], mTestVolatileStore[0x010]);
+  UT_ASSERT_NOT_EQUAL (mTestRuntimeVolatileCache[0x900], mTestVolatileStore[0x900]);
+
+  return UNIT_TEST_PASSED;
+}
+
+///===== SEQUENCE SUITE ===================================================
+
+/**
+  Every flush should advance the sequence number by two and be detected by a reader.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FlushShouldAdvanceSequence (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Start;
+
+  Start = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  UT_ASSERT_FALSE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Start));
+
+  //
+  // The read lock held by a reader must not delay the update.
+  //
+  mVariableRuntimeCacheReadLock = TRUE;
+  WriteTestPattern (mTestNvStore, 0x800, 0x40, 0x33);
+  UT_ASSERT_NOT_EFI_ERROR (
+    SynchronizeRuntimeVariableCache (
+      &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
+      0x800,
+      0x40
+      )
+    );
+  UT_ASSERT_FALSE (mVariableRuntimeCachePendingUpdate);
+  UT_ASSERT_EQUAL (mVariableRuntimeCacheSequence, Start + 2);
+  UT_ASSERT_TRUE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Start));
+  UT_ASSERT_MEM_EQUAL (mTestRuntimeNvCache, mTestNvStore, TEST_STORE_SIZE);
+
+  Start = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  UT_ASSERT_FALSE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Start));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Without a sequence number, an update should wait for the read lock as before.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UpdateWithoutSequenceShouldWaitForReadLock (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.Sequence = NULL;
+
+  mVariableRuntimeCacheReadLock = TRUE;
+  WriteTestPattern (mTestVolatileStore, 0x100, 0x20, 0x44);
+  UT_ASSERT_NOT_EFI_ERROR (
+    SynchronizeRuntimeVariableCache (
+      &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache,
+      0x100,
+      0x20
+      )
+    );
+  UT_ASSERT_TRUE (mVariableRuntimeCachePendingUpdate);
+  UT_ASSERT_NOT_EQUAL (CompareMem (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE), 0);
+
+  mVariableRuntimeCacheReadLock = FALSE;
+  UT_ASSERT_NOT_EFI_ERROR (FlushPendingRuntimeVariableCacheUpdates ());
+  UT_ASSERT_FALSE (mVariableRuntimeCachePendingUpdate);
+  UT_ASSERT_MEM_EQUAL (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE);
+  UT_ASSERT_EQUAL (mVariableRuntimeCacheSequence, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+///===== CONCURRENCY SUITE ================================================
+
+/**
+  A reader that starts or ends while the writer is stopped inside an update should retry.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadDuringUpdateShouldRetry (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  UINT32                          Before;
+  UINT32                          During;
+
+  CacheContext = &mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext;
+
+  Before = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  BeginRuntimeVariableCacheUpdate (CacheContext);
+  During = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  UT_ASSERT_TRUE ((During & BIT0) != 0);
+  UT_ASSERT_TRUE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Before));
+  UT_ASSERT_TRUE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, During));
+
+  EndRuntimeVariableCacheUpdate (CacheContext);
+  UT_ASSERT_TRUE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Before));
+  UT_ASSERT_TRUE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, During));
+
+  Before = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  UT_ASSERT_FALSE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Before));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Readers interleaved with a series of writes should retry, and then see the whole new snapshot
+  of the variable store.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+InterleavedReadsShouldSeeWholeSnapshots (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN    Write;
+  UINTN    WriterChunk;
+  UINTN    Offset;
+  UINTN    Length;
+
+  UT_ASSERT_FALSE (ReadRuntimeCacheInterleaved (MAX_UINTN, 0, 0));
+  UT_ASSERT_MEM_EQUAL (mTestReaderCopy, mTestVolatileStore, TEST_STORE_SIZE);
+
+  for (Write = 0; Write < 8; Write++) {
+    //
+    // A variable is appended at the end and the variable it replaces is marked deleted.
+    //
+    Offset = (Write * 0x1F0) % (TEST_STORE_SIZE / 2);
+    Length = TEST_STORE_SIZE / 2 + 0x90 - Offset;
+
+    for (WriterChunk = 0; WriterChunk <= TEST_STORE_SIZE / TEST_READ_CHUNK_SIZE; WriterChunk++) {
+      CopyMem (mTestOldSnapshot, mTestVolatileStore, TEST_STORE_SIZE);
+      UT_ASSERT_MEM_EQUAL (mTestRuntimeVolatileCache, mTestOldSnapshot, TEST_STORE_SIZE);
+      mTestVolatileStore[Offset] ^= 0xFF;
+      WriteTestPattern (mTestVolatileStore, TEST_STORE_SIZE / 2, 0x90, (UINT8) (Write * 0x11 + WriterChunk));
+      CopyMem (mTestNewSnapshot, mTestVolatileStore, TEST_STORE_SIZE);
+
+      UT_ASSERT_TRUE (ReadRuntimeCacheInterleaved (WriterChunk, Offset, Length));
+      UT_ASSERT_MEM_EQUAL (mTestRuntimeVolatileCache, mTestNewSnapshot, TEST_STORE_SIZE);
+
+      UT_ASSERT_FALSE (ReadRuntimeCacheInterleaved (MAX_UINTN, 0, 0));
+      UT_ASSERT_MEM_EQUAL (mTestReaderCopy, mTestNewSnapshot, TEST_STORE_SIZE);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Readers running concurrently with writers should only ever return committed variables.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ConcurrentReadsShouldSeeCommittedValues (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  pthread_t  Writers[TEST_STRESS_WRITER_COUNT];
+  pthread_t  Readers[TEST_STRESS_READER_COUNT];
+  UINTN      Index;
+
+  //
+  // An SMI stops the OS while SMM runs, so the readers never see the pending update flag that a
+  // flush sets and clears. The writers get a flag of their own to model that.
+  //
+  mTestModuleGlobal.VariableGlobal.VariableRuntimeCacheContext.PendingUpdate = &mTestStressPendingUpdate;
+  mTestStressPendingUpdate = FALSE;
+  mTestStressUpdate        = 0;
+  mTestStressDone          = FALSE;
+  mTestStressDataReads     = 0;
+  mTestStressNameReads     = 0;
+  mTestStressMismatches    = 0;
+  mTestStressRunning       = TRUE;
+
+  for (Index = 0; Index < TEST_STRESS_READER_COUNT; Index++) {
+    UT_ASSERT_EQUAL (pthread_create (&Readers[Index], NULL, StressReaderThread, NULL), 0);
+  }
+  for (Index = 0; Index < TEST_STRESS_WRITER_COUNT; Index++) {
+    UT_ASSERT_EQUAL (pthread_create (&Writers[Index], NULL, StressWriterThread, NULL), 0);
+  }
+
+  for (Index = 0; Index < TEST_STRESS_WRITER_COUNT; Index++) {
+    pthread_join (Writers[Index], NULL);
+  }
+  mTestStressDone = TRUE;
+  for (Index = 0; Index < TEST_STRESS_READER_COUNT; Index++) {
+    pthread_join (Readers[Index], NULL);
+  }
+  mTestStressRunning = FALSE;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%Lu updates, %Lu data reads, %Lu name reads\n",
+    (UINT64) mTestStressUpdate,
+    (UINT64) mTestStressDataReads,
+    (UINT64) mTestStressNameReads
+    ));
+  UT_ASSERT_EQUAL (mTestStressMismatches, 0);
+  UT_ASSERT_EQUAL (mTestStressUpdate, TEST_STRESS_WRITER_COUNT * TEST_STRESS_UPDATE_COUNT);
+  UT_ASSERT_TRUE (mTestStressDataReads > 0);
+  UT_ASSERT_TRUE (mTestStressNameReads > 0);
+  UT_ASSERT_MEM_EQUAL (mTestRuntimeVolatileCache, mTestVolatileStore, TEST_STORE_SIZE);
+
+  return UNIT_TEST_PASSED;
+}
+
+///===== READER SUITE =====================================================
+
+/**
+  GetVariable() from the runtime cache should not copy the data of a variable torn by the writer
+  to claim data beyond the end of the store, and should find it once the update is done.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindVariableShouldRejectTornDataSize (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       DataSize;
+  UINT32      Attributes;
+
+  //
+  // The writer stops inside an update while the reader walks the store.
+  //
+  mTestWriter      = TearSecondVariableDataSize;
+  mTestWriterDelay = 1;
+  DataSize         = sizeof (mTestReaderData);
+  Attributes       = 0;
+  Status = FindVariableInRuntimeCache (mTestSecondName, &mTestVendorGuid, &Attributes, &DataSize, mTestReaderData);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+  UT_ASSERT_TRUE (mTestWriter == NULL);
+  UT_ASSERT_EQUAL (DataSize, sizeof (mTestReaderData));
+  UT_ASSERT_EQUAL (Attributes, 0);
+  UT_ASSERT_TRUE (IsSentinelIntact (mTestReaderData, sizeof (mTestReaderData)));
+  UT_ASSERT_FALSE (mVariableRuntimeCacheReadLock);
+
+  CompleteTornUpdate ();
+  Status = FindVariableInRuntimeCache (mTestSecondName, &mTestVendorGuid, &Attributes, &DataSize, mTestReaderData);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (DataSize, mTestSecondVariable->DataSize);
+  UT_ASSERT_EQUAL (Attributes, mTestSecondVariable->Attributes);
+  UT_ASSERT_MEM_EQUAL (mTestReaderData, GetVariableDataPtr (mTestSecondVariable, FALSE), DataSize);
+  UT_ASSERT_TRUE (IsSentinelIntact (mTestReaderData + DataSize, sizeof (mTestReaderData) - DataSize));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  GetVariable() from the runtime cache should not write the caller's buffer when every read of a
+  variable overlaps with an update, even though the torn variable looks valid.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindVariableShouldNotWriteTornData (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       DataSize;
+  UINT32      Attributes;
+
+  mTestWriter      = TearSecondVariableData;
+  mTestWriterDelay = 2;
+  DataSize         = sizeof (mTestReaderData);
+  Attributes       = 0;
+  Status = FindVariableInRuntimeCache (mTestSecondName, &mTestVendorGuid, &Attributes, &DataSize, mTestReaderData);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+  UT_ASSERT_TRUE (mTestWriter == NULL);
+  UT_ASSERT_EQUAL (DataSize, sizeof (mTestReaderData));
+  UT_ASSERT_EQUAL (Attributes, 0);
+  UT_ASSERT_TRUE (IsSentinelIntact (mTestReaderData, sizeof (mTestReaderData)));
+  UT_ASSERT_FALSE (mVariableRuntimeCacheReadLock);
+
+  CompleteTornUpdate ();
+  Status = FindVariableInRuntimeCache (mTestSecondName, &mTestVendorGuid, &Attributes, &DataSize, mTestReaderData);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (DataSize, mTestSecondVariable->DataSize);
+  UT_ASSERT_MEM_EQUAL (mTestReaderData, GetVariableDataPtr (mTestSecondVariable, FALSE), DataSize);
+  UT_ASSERT_TRUE (IsSentinelIntact (mTestReaderData + DataSize, sizeof (mTestReaderData) - DataSize));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  GetVariable() from the runtime cache should retry a read the writer completed an update during,
+  and return the new data.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindVariableShouldRetryInterleavedUpdate (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       DataSize;
+  UINT32      Start;
+
+  Start            = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+  mTestWriter      = UpdateSecondVariableData;
+  mTestWriterDelay = 2;
+  DataSize         = sizeof (mTestReaderData);
+  Status = FindVariableInRuntimeCache (mTestSecondName, &mTestVendorGuid, NULL, &DataSize, mTestReaderData);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mTestWriter == NULL);
+  UT_ASSERT_TRUE (VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Start));
+  UT_ASSERT_EQUAL (DataSize, mTestSecondVariable->DataSize);
+  UT_ASSERT_MEM_EQUAL (mTestReaderData, GetVariableDataPtr (mTestSecondVariable, FALSE), DataSize);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  GetNextVariableName() from the runtime cache should not copy the name of a variable torn by the
+  writer beyond the communication buffer, and should return it once the update is done.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GetNextVariableNameShouldRejectTornNameSize (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      VariableName[TEST_VARIABLE_BUFFER_SIZE];
+  UINTN       VariableNameSize;
+  EFI_GUID    VendorGuid;
+
+  mTestWriter      = TearFirstVariableNameSize;
+  mTestWriterDelay = 1;
+  ZeroMem (VariableName, sizeof (VariableName));
+  ZeroMem (&VendorGuid, sizeof (VendorGuid));
+  VariableNameSize = sizeof (VariableName);
+  Status = GetNextVariableNameInRuntimeCache (&VariableNameSize, VariableName, &VendorGuid);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+  UT_ASSERT_TRUE (mTestWriter == NULL);
+  UT_ASSERT_EQUAL (VariableNameSize, sizeof (VariableName));
+  UT_ASSERT_EQUAL (VariableName[0], 0);
+  UT_ASSERT_TRUE (IsZeroGuid (&VendorGuid));
+  UT_ASSERT_TRUE (IsSentinelIntact (mTestVariableBuffer + TEST_VARIABLE_BUFFER_SIZE, sizeof (mTestVariableBuffer) - TEST_VARIABLE_BUFFER_SIZE));
+  UT_ASSERT_FALSE (mVariableRuntimeCacheReadLock);
+
+  CompleteTornUpdate ();
+  Status = GetNextVariableNameInRuntimeCache (&VariableNameSize, VariableName, &VendorGuid);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (VariableNameSize, StrSize (mTestFirstName));
+  UT_ASSERT_MEM_EQUAL (VariableName, mTestFirstName, VariableNameSize);
+  UT_ASSERT_TRUE (CompareGuid (&VendorGuid, &mTestVendorGuid));
+
+  VariableNameSize = sizeof (VariableName);
+  Status = GetNextVariableNameInRuntimeCache (&VariableNameSize, VariableName, &VendorGuid);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (VariableName, mTestSecondName, VariableNameSize);
+
+  return UNIT_TEST_PASSED;
+}
+
+///=== TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  runtime variable cache updates and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      DeltaLogTests;
+  UNIT_TEST_SUITE_HANDLE      SequenceTests;
+  UNIT_TEST_SUITE_HANDLE      ConcurrencyTests;
+  UNIT_TEST_SUITE_HANDLE      ReaderTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Add all test suites and tests.
+  //
+  Status = CreateUnitTestSuite (&DeltaLogTests, Framework, "Delta Log Tests", "VarRtCache.DeltaLog", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DeltaLogTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (
+    DeltaLogTests,
+    "Only the changed ranges should be logged and copied", "ChangedRanges",
+    DeltaLogShouldOnlyHoldChangedRanges, RuntimeCacheInit, NULL, NULL
+    );
+  AddTestCase (
+    DeltaLogTests,
+    "A full delta log should still cover the pending update", "FullLog",
+    DeltaLogShouldCoverPendingUpdateWhenFull, RuntimeCacheInit, NULL, NULL
+    );
+
+  Status = CreateUnitTestSuite (&SequenceTests, Framework, "Sequence Tests", "VarRtCache.Sequence", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SequenceTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (
+    SequenceTests,
+    "A flush should advance the sequence without waiting for the read lock", "FlushAdvancesSequence",
+    FlushShouldAdvanceSequence, RuntimeCacheInit, NULL, NULL
+    );
+  AddTestCase (
+    SequenceTests,
+    "An update without a sequence should wait for the read lock", "NoSequenceWaitsForReadLock",
+    UpdateWithoutSequenceShouldWaitForReadLock, RuntimeCacheInit, NULL, NULL
+    );
+
+  Status = CreateUnitTestSuite (&ConcurrencyTests, Framework, "Concurrency Tests", "VarRtCache.Concurrency", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ConcurrencyTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (
+    ConcurrencyTests,
+    "A read that overlaps with an update should retry", "ReadDuringUpdate",
+    ReadDuringUpdateShouldRetry, RuntimeCacheInit, NULL, NULL
+    );
+  AddTestCase (
+    ConcurrencyTests,
+    "Interleaved reads should retry or see a whole snapshot", "InterleavedReads",
+    InterleavedReadsShouldSeeWholeSnapshots, RuntimeCacheInit, NULL, NULL
+    );
+  AddTestCase (
+    ConcurrencyTests,
+    "Concurrent readers should only see committed values", "ConcurrentReads",
+    ConcurrentReadsShouldSeeCommittedValues, RuntimeCacheReaderInit, NULL, NULL
+    );
+
+  Status = CreateUnitTestSuite (&ReaderTests, Framework, "Reader Tests", "VarRtCache.Reader", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ReaderTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  AddTestCase (
+    ReaderTests,
+    "GetVariable should not copy the data of a torn variable", "TornDataSize",
+    FindVariableShouldRejectTornDataSize, RuntimeCacheReaderInit, NULL, NULL
+    );
+  AddTestCase (
+    ReaderTests,
+    "GetVariable should not write the data of a torn read", "TornData",
+    FindVariableShouldNotWriteTornData, RuntimeCacheReaderInit, NULL, NULL
+    );
+  AddTestCase (
+    ReaderTests,
+    "GetVariable should retry a read an update completed during", "InterleavedUpdate",
+    FindVariableShouldRetryInterleavedUpdate, RuntimeCacheReaderInit, NULL, NULL
+    );
+  AddTestCase (
+    ReaderTests,
+    "GetNextVariableName should not copy the name of a torn variable", "TornNameSize",
+    GetNextVariableNameShouldRejectTornNameSize, RuntimeCacheReaderInit, NULL, NULL
+    );
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
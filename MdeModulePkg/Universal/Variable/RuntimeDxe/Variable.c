@@ -256,6 +256,24 @@ UpdateVariableStore (
   return EFI_SUCCESS;
 }
 
+/**
+  Increment the variable store generation, if the SMM variable wrapper driver registered one,
+  so that it stops using the variables it read from the store before the update.
+
+**/
+VOID
+UpdateVariableStoreGeneration (
+  VOID
+  )
+{
+  UINT32                    *StoreGeneration;
+
+  StoreGeneration = mVariableModuleGlobal->VariableGlobal.StoreGeneration;
+  if (StoreGeneration != NULL) {
+    *(volatile UINT32 *) StoreGeneration = *StoreGeneration + 1;
+  }
+}
+
 /**
   Record variable error flag.
 
@@ -335,6 +353,7 @@ RecordVarErrorFlag (
       // Update the data in NV cache.
       //
       *VarErrFlag = TempFlag;
+      UpdateVariableStoreGeneration ();
       Status =  SynchronizeRuntimeVariableCache (
                   &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
                   0,
@@ -2303,6 +2322,11 @@ UpdateVariable (
   }
 
 Done:
+  //
+  // A failed update may still have changed the state of the variable in the store.
+  //
+  UpdateVariableStoreGeneration ();
+
   if (!EFI_ERROR (Status)) {
     if ((Variable->CurrPtr != NULL && !Variable->Volatile) || (Attributes & EFI_VARIABLE_NON_VOLATILE) != 0) {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache);
@@ -74,6 +74,7 @@ typedef struct {
   BOOLEAN                 *ReadLock;
   BOOLEAN                 *PendingUpdate;
   BOOLEAN                 *HobFlushComplete;
+  UINT32                  *Sequence;
   VARIABLE_RUNTIME_CACHE  VariableRuntimeHobCache;
   VARIABLE_RUNTIME_CACHE  VariableRuntimeNvCache;
   VARIABLE_RUNTIME_CACHE  VariableRuntimeVolatileCache;
@@ -98,6 +99,7 @@ typedef struct {
   EFI_PHYSICAL_ADDRESS            VolatileVariableBase;
   EFI_PHYSICAL_ADDRESS            NonVolatileVariableBase;
   VARIABLE_RUNTIME_CACHE_CONTEXT  VariableRuntimeCacheContext;
+  UINT32                          *StoreGeneration;  // Optional, incremented on every variable store update
   EFI_LOCK                        VariableServicesLock;
   UINT32                          ReentrantState;
   BOOLEAN                         AuthFormat;
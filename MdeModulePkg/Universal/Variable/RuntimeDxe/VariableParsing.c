@@ -786,3 +786,48 @@ UpdateVariableInfo (
     }
   }
 }
+
+/**
+  Starts a read of the runtime variable caches.
+
+  The runtime variable caches are updated in SMM while the sequence number is odd. A read that
+  overlaps with an update must be retried, which VariableRuntimeCacheReadRetry() checks.
+
+  @param[in]  Sequence          Pointer to the runtime variable cache sequence number.
+
+  @return The sequence number at the start of the read.
+
+**/
+UINT32
+VariableRuntimeCacheReadBegin (
+  IN  UINT32                *Sequence
+  )
+{
+  UINT32                    Start;
+
+  Start = *(volatile UINT32 *) Sequence;
+  MemoryFence ();
+
+  return Start;
+}
+
+/**
+  Checks whether a read of the runtime variable caches must be retried.
+
+  @param[in]  Sequence          Pointer to the runtime variable cache sequence number.
+  @param[in]  Start             The sequence number returned by VariableRuntimeCacheReadBegin().
+
+  @retval TRUE              The runtime variable caches were updated during the read, the data read may
+                            be inconsistent.
+  @retval FALSE             The data read is consistent.
+
+**/
+BOOLEAN
+VariableRuntimeCacheReadRetry (
+  IN  UINT32                *Sequence,
+  IN  UINT32                Start
+  )
+{
+  MemoryFence ();
+  return (BOOLEAN) (((Start & BIT0) != 0) || (*(volatile UINT32 *) Sequence != Start));
+}
@@ -18,9 +18,135 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 extern VARIABLE_MODULE_GLOBAL   *mVariableModuleGlobal;
 extern VARIABLE_STORE_HEADER    *mNvVariableCache;
 
+VARIABLE_RUNTIME_CACHE_DELTA    mVariableRuntimeCacheDeltaLog[VariableStoreTypeMax][VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE];
+
+/**
+  Logs the ranges of the pending update of a runtime variable cache that differ from the variable store.
+
+  Adjacent differing ranges are merged into one delta. If there are more deltas than MaxDeltaCount,
+  the last delta is extended to the end of the pending update.
+
+  @param[in]  VariableRuntimeCache  Variable runtime cache structure for the runtime cache.
+  @param[in]  VariableStore         The variable store the runtime cache is a copy of.
+  @param[out] DeltaLog              Returns the deltas.
+  @param[in]  MaxDeltaCount         The maximum number of deltas DeltaLog can hold.
+
+  @return The number of deltas logged.
+
+**/
+UINTN
+LogRuntimeVariableCacheDeltas (
+  IN  VARIABLE_RUNTIME_CACHE          *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER           *VariableStore,
+  OUT VARIABLE_RUNTIME_CACHE_DELTA    *DeltaLog,
+  IN  UINTN                           MaxDeltaCount
+  )
+{
+  UINTN                             DeltaCount;
+  UINTN                             Offset;
+  UINTN                             EndOffset;
+  UINTN                             Length;
+
+  ASSERT (MaxDeltaCount > 0);
+
+  DeltaCount = 0;
+  EndOffset  = (UINTN) VariableRuntimeCache->PendingUpdateOffset + VariableRuntimeCache->PendingUpdateLength;
+  for (Offset = VariableRuntimeCache->PendingUpdateOffset; Offset < EndOffset; Offset += Length) {
+    Length = MIN (VARIABLE_RUNTIME_CACHE_DELTA_GRANULARITY, EndOffset - Offset);
+    if (CompareMem (
+          (UINT8 *) VariableRuntimeCache->Store + Offset,
+          (UINT8 *) VariableStore + Offset,
+          Length
+          ) == 0) {
+      continue;
+    }
+
+    if ((DeltaCount > 0) &&
+        ((DeltaLog[DeltaCount - 1].Offset + DeltaLog[DeltaCount - 1].Length == Offset) || (DeltaCount == MaxDeltaCount))) {
+      DeltaLog[DeltaCount - 1].Length = (UINT32) (Offset + Length - DeltaLog[DeltaCount - 1].Offset);
+    } else {
+      DeltaLog[DeltaCount].Offset = (UINT32) Offset;
+      DeltaLog[DeltaCount].Length = (UINT32) Length;
+      DeltaCount++;
+    }
+  }
+
+  return DeltaCount;
+}
+
+/**
+  Copies the logged deltas from the variable store to a runtime variable cache.
+
+  The deltas are applied from the highest offset down, so a variable appended to the end of the store
+  is complete before the state of the variable it replaces is changed.
+
+  @param[in]  VariableRuntimeCache  Variable runtime cache structure for the runtime cache.
+  @param[in]  VariableStore         The variable store the runtime cache is a copy of.
+  @param[in]  DeltaLog              The deltas to apply.
+  @param[in]  DeltaCount            The number of deltas.
+
+**/
+VOID
+ApplyRuntimeVariableCacheDeltas (
+  IN  VARIABLE_RUNTIME_CACHE          *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER           *VariableStore,
+  IN  VARIABLE_RUNTIME_CACHE_DELTA    *DeltaLog,
+  IN  UINTN                           DeltaCount
+  )
+{
+  while (DeltaCount > 0) {
+    DeltaCount--;
+    CopyMem (
+      (UINT8 *) VariableRuntimeCache->Store + DeltaLog[DeltaCount].Offset,
+      (UINT8 *) VariableStore + DeltaLog[DeltaCount].Offset,
+      DeltaLog[DeltaCount].Length
+      );
+  }
+}
+
+/**
+  Starts an update of the runtime variable caches.
+
+  The sequence number shared with the runtime readers becomes odd, so any read that overlaps with the
+  update is retried by the reader.
+
+  @param[in]  VariableRuntimeCacheContext  The runtime variable cache context.
+
+**/
+VOID
+BeginRuntimeVariableCacheUpdate (
+  IN  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext
+  )
+{
+  if (VariableRuntimeCacheContext->Sequence != NULL) {
+    *(volatile UINT32 *) VariableRuntimeCacheContext->Sequence = *(VariableRuntimeCacheContext->Sequence) + 1;
+    MemoryFence ();
+  }
+}
+
+/**
+  Ends an update of the runtime variable caches.
+
+  @param[in]  VariableRuntimeCacheContext  The runtime variable cache context.
+
+**/
+VOID
+EndRuntimeVariableCacheUpdate (
+  IN  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext
+  )
+{
+  if (VariableRuntimeCacheContext->Sequence != NULL) {
+    MemoryFence ();
+    *(volatile UINT32 *) VariableRuntimeCacheContext->Sequence = *(VariableRuntimeCacheContext->Sequence) + 1;
+  }
+}
+
 /**
   Copies any pending updates to runtime variable caches.
 
+  Only the ranges of the pending updates that differ from the variable stores are copied, and they are
+  all copied within one update of the sequence number.
+
   @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
   @retval EFI_SUCCESS             The volatile store was updated successfully.
 
@@ -31,6 +157,8 @@ FlushPendingRuntimeVariableCacheUpdates (
   )
 {
   VARIABLE_RUNTIME_CACHE_CONTEXT    *VariableRuntimeCacheContext;
+  VARIABLE_STORE_HEADER             *HobVariableStore;
+  UINTN                             DeltaCount[VariableStoreTypeMax];
 
   VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
 
@@ -41,51 +169,65 @@ FlushPendingRuntimeVariableCacheUpdates (
   }
 
   if (*(VariableRuntimeCacheContext->PendingUpdate)) {
+    //
+    // Log the deltas before the update starts, so the runtime readers only retry while they are copied.
+    //
+    HobVariableStore = NULL;
+    DeltaCount[VariableStoreTypeHob] = 0;
     if (VariableRuntimeCacheContext->VariableRuntimeHobCache.Store != NULL &&
         mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0) {
-      CopyMem (
-        (VOID *) (
-          ((UINT8 *) (UINTN) VariableRuntimeCacheContext->VariableRuntimeHobCache.Store) +
-          VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-          ),
-        (VOID *) (
-          ((UINT8 *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase) +
-          VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-          ),
-        VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength
+      HobVariableStore = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+      DeltaCount[VariableStoreTypeHob] = LogRuntimeVariableCacheDeltas (
+                                           &VariableRuntimeCacheContext->VariableRuntimeHobCache,
+                                           HobVariableStore,
+                                           mVariableRuntimeCacheDeltaLog[VariableStoreTypeHob],
+                                           VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE
+                                           );
+    }
+    DeltaCount[VariableStoreTypeNv] = LogRuntimeVariableCacheDeltas (
+                                        &VariableRuntimeCacheContext->VariableRuntimeNvCache,
+                                        mNvVariableCache,
+                                        mVariableRuntimeCacheDeltaLog[VariableStoreTypeNv],
+                                        VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE
+                                        );
+    DeltaCount[VariableStoreTypeVolatile] = LogRuntimeVariableCacheDeltas (
+                                              &VariableRuntimeCacheContext->VariableRuntimeVolatileCache,
+                                              (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase,
+                                              mVariableRuntimeCacheDeltaLog[VariableStoreTypeVolatile],
+                                              VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE
+                                              );
+
+    BeginRuntimeVariableCacheUpdate (VariableRuntimeCacheContext);
+    if (HobVariableStore != NULL) {
+      ApplyRuntimeVariableCacheDeltas (
+        &VariableRuntimeCacheContext->VariableRuntimeHobCache,
+        HobVariableStore,
+        mVariableRuntimeCacheDeltaLog[VariableStoreTypeHob],
+        DeltaCount[VariableStoreTypeHob]
         );
       VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
       VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
     }
 
-    CopyMem (
-      (VOID *) (
-        ((UINT8 *) (UINTN) VariableRuntimeCacheContext->VariableRuntimeNvCache.Store) +
-        VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-        ),
-      (VOID *) (
-        ((UINT8 *) (UINTN) mNvVariableCache) +
-        VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-        ),
-      VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength
+    ApplyRuntimeVariableCacheDeltas (
+      &VariableRuntimeCacheContext->VariableRuntimeNvCache,
+      mNvVariableCache,
+      mVariableRuntimeCacheDeltaLog[VariableStoreTypeNv],
+      DeltaCount[VariableStoreTypeNv]
       );
     VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength = 0;
     VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
 
-    CopyMem (
-      (VOID *) (
-        ((UINT8 *) (UINTN) VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store) +
-        VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-      ),
-      (VOID *) (
-        ((UINT8 *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase) +
-        VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-        ),
-      VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength
+    ApplyRuntimeVariableCacheDeltas (
+      &VariableRuntimeCacheContext->VariableRuntimeVolatileCache,
+      (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase,
+      mVariableRuntimeCacheDeltaLog[VariableStoreTypeVolatile],
+      DeltaCount[VariableStoreTypeVolatile]
       );
     VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = 0;
     VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
     *(VariableRuntimeCacheContext->PendingUpdate) = FALSE;
+    EndRuntimeVariableCacheUpdate (VariableRuntimeCacheContext);
   }
 
   return EFI_SUCCESS;
@@ -95,9 +237,9 @@ FlushPendingRuntimeVariableCacheUpdates (
   Synchronizes the runtime variable caches with all pending updates outside runtime.
 
   Ensures all conditions are met to maintain coherency for runtime cache updates. This function will attempt
-  to write the given update (and any other pending updates) if the ReadLock is available. Otherwise, the
-  update is added as a pending update for the given variable store and it will be flushed to the runtime cache
-  at the next opportunity the ReadLock is available.
+  to write the given update (and any other pending updates) if the runtime readers use the sequence number or
+  the ReadLock is available. Otherwise, the update is added as a pending update for the given variable store
+  and it will be flushed to the runtime cache at the next opportunity the ReadLock is available.
 
   @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
   @param[in] Offset               Offset in bytes to apply the update.
@@ -145,7 +287,12 @@ SynchronizeRuntimeVariableCache (
   }
   *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) = TRUE;
 
-  if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReadLock) == FALSE) {
+  //
+  // The runtime readers that use the sequence number retry the reads that overlap with the update, so
+  // the update does not need to wait for the ReadLock.
+  //
+  if (mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.Sequence != NULL ||
+      *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReadLock) == FALSE) {
     return FlushPendingRuntimeVariableCacheUpdates ();
   }
 
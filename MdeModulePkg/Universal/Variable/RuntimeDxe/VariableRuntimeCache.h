@@ -12,6 +12,88 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Variable.h"
 
+///
+/// The maximum number of deltas logged for one runtime variable cache in one flush.
+///
+#define VARIABLE_RUNTIME_CACHE_DELTA_LOG_SIZE     32
+
+///
+/// The granularity in bytes in which a runtime variable cache is compared with its variable store.
+///
+#define VARIABLE_RUNTIME_CACHE_DELTA_GRANULARITY  64
+
+typedef struct {
+  UINT32                  Offset;
+  UINT32                  Length;
+} VARIABLE_RUNTIME_CACHE_DELTA;
+
+/**
+  Logs the ranges of the pending update of a runtime variable cache that differ from the variable store.
+
+  Adjacent differing ranges are merged into one delta. If there are more deltas than MaxDeltaCount,
+  the last delta is extended to the end of the pending update.
+
+  @param[in]  VariableRuntimeCache  Variable runtime cache structure for the runtime cache.
+  @param[in]  VariableStore         The variable store the runtime cache is a copy of.
+  @param[out] DeltaLog              Returns the deltas.
+  @param[in]  MaxDeltaCount         The maximum number of deltas DeltaLog can hold.
+
+  @return The number of deltas logged.
+
+**/
+UINTN
+LogRuntimeVariableCacheDeltas (
+  IN  VARIABLE_RUNTIME_CACHE          *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER           *VariableStore,
+  OUT VARIABLE_RUNTIME_CACHE_DELTA    *DeltaLog,
+  IN  UINTN                           MaxDeltaCount
+  );
+
+/**
+  Copies the logged deltas from the variable store to a runtime variable cache.
+
+  The deltas are applied from the highest offset down, so a variable appended to the end of the store
+  is complete before the state of the variable it replaces is changed.
+
+  @param[in]  VariableRuntimeCache  Variable runtime cache structure for the runtime cache.
+  @param[in]  VariableStore         The variable store the runtime cache is a copy of.
+  @param[in]  DeltaLog              The deltas to apply.
+  @param[in]  DeltaCount            The number of deltas.
+
+**/
+VOID
+ApplyRuntimeVariableCacheDeltas (
+  IN  VARIABLE_RUNTIME_CACHE          *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER           *VariableStore,
+  IN  VARIABLE_RUNTIME_CACHE_DELTA    *DeltaLog,
+  IN  UINTN                           DeltaCount
+  );
+
+/**
+  Starts an update of the runtime variable caches.
+
+  The sequence number shared with the runtime readers becomes odd, so any read that overlaps with the
+  update is retried by the reader.
+
+  @param[in]  VariableRuntimeCacheContext  The runtime variable cache context.
+
+**/
+VOID
+BeginRuntimeVariableCacheUpdate (
+  IN  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext
+  );
+
+/**
+  Ends an update of the runtime variable caches.
+
+  @param[in]  VariableRuntimeCacheContext  The runtime variable cache context.
+
+**/
+VOID
+EndRuntimeVariableCacheUpdate (
+  IN  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext
+  );
+
 /**
   Copies any pending updates to runtime variable caches.
 
@@ -28,9 +110,9 @@ FlushPendingRuntimeVariableCacheUpdates (
   Synchronizes the runtime variable caches with all pending updates outside runtime.
 
   Ensures all conditions are met to maintain coherency for runtime cache updates. This function will attempt
-  to write the given update (and any other pending updates) if the ReadLock is available. Otherwise, the
-  update is added as a pending update for the given variable store and it will be flushed to the runtime cache
-  at the next opportunity the ReadLock is available.
+  to write the given update (and any other pending updates) if the runtime readers use the sequence number or
+  the ReadLock is available. Otherwise, the update is added as a pending update for the given variable store
+  and it will be flushed to the runtime cache at the next opportunity the ReadLock is available.
 
   @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
   @param[in] Offset               Offset in bytes to apply the update.
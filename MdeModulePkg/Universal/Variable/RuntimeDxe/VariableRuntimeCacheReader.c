@@ -0,0 +1,271 @@
+/** @file
+  Functions the SMM variable wrapper driver uses to read the UEFI variable
+  runtime caches. SMM updates the runtime caches without waiting for the
+  readers, so everything read from them is validated before it is used.
+
+  Caution: This module requires additional review when modified.
+  This driver will have external input - variable data.
+  This external input must be validated carefully to avoid security issue like
+  buffer overflow, integer overflow.
+
+Copyright (c) 2010 - 2019, Intel Corporation. All rights reserved.<BR>
+Copyright (c) Microsoft Corporation.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableRuntimeCacheReader.h"
+
+extern UINT8                    *mVariableBuffer;
+extern UINTN                    mVariableBufferSize;
+extern VARIABLE_INFO_ENTRY      *mVariableInfo;
+extern VARIABLE_STORE_HEADER    *mVariableRuntimeHobCacheBuffer;
+extern VARIABLE_STORE_HEADER    *mVariableRuntimeNvCacheBuffer;
+extern VARIABLE_STORE_HEADER    *mVariableRuntimeVolatileCacheBuffer;
+extern BOOLEAN                  mVariableRuntimeCachePendingUpdate;
+extern BOOLEAN                  mVariableRuntimeCacheReadLock;
+extern BOOLEAN                  mVariableAuthFormat;
+extern UINT32                   mVariableRuntimeCacheSequence;
+
+/**
+  Finds the given variable in a runtime cache variable store.
+
+  Caution: This function may receive untrusted input.
+  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
+
+  @param[in]      VariableName       Name of Variable to be found.
+  @param[in]      VendorGuid         Variable vendor GUID.
+  @param[out]     Attributes         Attribute value of the variable found.
+  @param[in, out] DataSize           Size of Data found. If size is less than the
+                                     data, this value contains the required size.
+  @param[out]     Data               Data pointer.
+
+  @retval EFI_SUCCESS                Found the specified variable.
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_NOT_FOUND              The specified variable could not be found.
+  @retval EFI_NOT_READY              The runtime cache was updated during every read attempt.
+
+**/
+EFI_STATUS
+FindVariableInRuntimeCache (
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid,
+  OUT     UINT32                            *Attributes OPTIONAL,
+  IN OUT  UINTN                             *DataSize,
+  OUT     VOID                              *Data OPTIONAL
+  )
+{
+  EFI_STATUS              Status;
+  UINTN                   TempDataSize;
+  UINT32                  TempAttributes;
+  UINT8                   *TempData;
+  UINT32                  Sequence;
+  UINTN                   Retry;
+  VARIABLE_POINTER_TRACK  RtPtrTrack;
+  VARIABLE_STORE_TYPE     StoreType;
+  VARIABLE_STORE_HEADER   *VariableStoreList[VariableStoreTypeMax];
+
+  Status = EFI_NOT_FOUND;
+
+  if (VariableName == NULL || VendorGuid == NULL || DataSize == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&RtPtrTrack, sizeof (RtPtrTrack));
+
+  //
+  // The UEFI specification restricts Runtime Services callers from invoking the same or certain other Runtime Service
+  // functions prior to completion and return from a previous Runtime Service call. These restrictions prevent
+  // a GetVariable () or GetNextVariable () call from being issued until a prior call has returned. The runtime
+  // cache read lock should always be free when entering this function.
+  //
+  ASSERT (!mVariableRuntimeCacheReadLock);
+
+  mVariableRuntimeCacheReadLock = TRUE;
+  CheckForRuntimeCacheSync ();
+
+  if (!mVariableRuntimeCachePendingUpdate) {
+    //
+    // SMM updates the runtime caches without waiting for the read lock. The data is staged in the
+    // communication buffer, which is idle while no Runtime Service is in progress, and only copied
+    // out together with the size and the attributes once the read is known to be consistent.
+    //
+    TempDataSize   = 0;
+    TempAttributes = 0;
+    TempData       = mVariableBuffer;
+    for (Retry = 0; Retry < VARIABLE_RUNTIME_CACHE_READ_RETRY_MAX; Retry++) {
+      Sequence = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+      Status   = EFI_NOT_FOUND;
+
+      //
+      // 0: Volatile, 1: HOB, 2: Non-Volatile.
+      // The index and attributes mapping must be kept in this order as FindVariable
+      // makes use of this mapping to implement search algorithm.
+      //
+      VariableStoreList[VariableStoreTypeVolatile] = mVariableRuntimeVolatileCacheBuffer;
+      VariableStoreList[VariableStoreTypeHob]      = mVariableRuntimeHobCacheBuffer;
+      VariableStoreList[VariableStoreTypeNv]       = mVariableRuntimeNvCacheBuffer;
+
+      for (StoreType = (VARIABLE_STORE_TYPE) 0; StoreType < VariableStoreTypeMax; StoreType++) {
+        if (VariableStoreList[StoreType] == NULL) {
+          continue;
+        }
+
+        RtPtrTrack.StartPtr = GetStartPointer (VariableStoreList[StoreType]);
+        RtPtrTrack.EndPtr   = GetEndPointer   (VariableStoreList[StoreType]);
+        RtPtrTrack.Volatile = (BOOLEAN) (StoreType == VariableStoreTypeVolatile);
+
+        Status = FindVariableEx (VariableName, VendorGuid, FALSE, &RtPtrTrack, mVariableAuthFormat);
+        if (!EFI_ERROR (Status)) {
+          break;
+        }
+      }
+
+      if (!EFI_ERROR (Status)) {
+        //
+        // Get data size. A variable torn by an overlapping update may claim data beyond the store.
+        //
+        TempDataSize   = DataSizeOfVariable (RtPtrTrack.CurrPtr, mVariableAuthFormat);
+        TempAttributes = RtPtrTrack.CurrPtr->Attributes;
+        if (TempDataSize == 0 || TempDataSize > mVariableBufferSize ||
+            TempDataSize > (UINTN) RtPtrTrack.EndPtr - (UINTN) GetVariableDataPtr (RtPtrTrack.CurrPtr, mVariableAuthFormat)) {
+          Status = EFI_NOT_READY;
+        } else if (*DataSize >= TempDataSize) {
+          if (Data == NULL) {
+            Status = EFI_INVALID_PARAMETER;
+          } else {
+            CopyMem (TempData, GetVariableDataPtr (RtPtrTrack.CurrPtr, mVariableAuthFormat), TempDataSize);
+            Status = EFI_SUCCESS;
+          }
+        } else {
+          Status = EFI_BUFFER_TOO_SMALL;
+        }
+      }
+
+      if (!VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Sequence)) {
+        break;
+      }
+      Status = EFI_NOT_READY;
+    }
+
+    if (Status == EFI_SUCCESS) {
+      CopyMem (Data, TempData, TempDataSize);
+    }
+    if (Status == EFI_SUCCESS || Status == EFI_BUFFER_TOO_SMALL) {
+      *DataSize = TempDataSize;
+      if (Attributes != NULL) {
+        *Attributes = TempAttributes;
+      }
+    }
+    if (Status == EFI_SUCCESS) {
+      UpdateVariableInfo (VariableName, VendorGuid, RtPtrTrack.Volatile, TRUE, FALSE, FALSE, TRUE, &mVariableInfo);
+    }
+  }
+  mVariableRuntimeCacheReadLock = FALSE;
+
+  return Status;
+}
+
+/**
+  Finds the next available variable in a runtime cache variable store.
+
+  @param[in, out] VariableNameSize   Size of the variable name.
+  @param[in, out] VariableName       Pointer to variable name.
+  @param[in, out] VendorGuid         Variable Vendor Guid.
+
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              Not found.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+  @retval EFI_NOT_READY              The runtime cache was updated during every read attempt.
+
+**/
+EFI_STATUS
+GetNextVariableNameInRuntimeCache (
+  IN OUT  UINTN                             *VariableNameSize,
+  IN OUT  CHAR16                            *VariableName,
+  IN OUT  EFI_GUID                          *VendorGuid
+  )
+{
+  EFI_STATUS              Status;
+  UINTN                   VarNameSize;
+  UINT32                  Sequence;
+  UINTN                   Retry;
+  EFI_GUID                NextVendorGuid;
+  CHAR16                  *NextVariableName;
+  VARIABLE_HEADER         *VariablePtr;
+  VARIABLE_STORE_HEADER   *VariableStoreHeader[VariableStoreTypeMax];
+
+  Status = EFI_NOT_FOUND;
+
+  //
+  // The UEFI specification restricts Runtime Services callers from invoking the same or certain other Runtime Service
+  // functions prior to completion and return from a previous Runtime Service call. These restrictions prevent
+  // a GetVariable () or GetNextVariable () call from being issued until a prior call has returned. The runtime
+  // cache read lock should always be free when entering this function.
+  //
+  ASSERT (!mVariableRuntimeCacheReadLock);
+
+  CheckForRuntimeCacheSync ();
+
+  mVariableRuntimeCacheReadLock = TRUE;
+  if (!mVariableRuntimeCachePendingUpdate) {
+    //
+    // SMM updates the runtime caches without waiting for the read lock. VariableName is also the input
+    // of the search, so the next name is staged in the communication buffer, which is idle while no
+    // Runtime Service is in progress, and only copied out once the read is known to be consistent.
+    //
+    VarNameSize      = 0;
+    NextVariableName = (CHAR16 *) mVariableBuffer;
+    ZeroMem (&NextVendorGuid, sizeof (NextVendorGuid));
+    for (Retry = 0; Retry < VARIABLE_RUNTIME_CACHE_READ_RETRY_MAX; Retry++) {
+      Sequence = VariableRuntimeCacheReadBegin (&mVariableRuntimeCacheSequence);
+
+      //
+      // 0: Volatile, 1: HOB, 2: Non-Volatile.
+      // The index and attributes mapping must be kept in this order as FindVariable
+      // makes use of this mapping to implement search algorithm.
+      //
+      VariableStoreHeader[VariableStoreTypeVolatile] = mVariableRuntimeVolatileCacheBuffer;
+      VariableStoreHeader[VariableStoreTypeHob]      = mVariableRuntimeHobCacheBuffer;
+      VariableStoreHeader[VariableStoreTypeNv]       = mVariableRuntimeNvCacheBuffer;
+
+      Status =  VariableServiceGetNextVariableInternal (
+                  VariableName,
+                  VendorGuid,
+                  VariableStoreHeader,
+                  &VariablePtr,
+                  mVariableAuthFormat
+                  );
+      if (!EFI_ERROR (Status)) {
+        VarNameSize = NameSizeOfVariable (VariablePtr, mVariableAuthFormat);
+        if (VarNameSize == 0 || VarNameSize > mVariableBufferSize) {
+          Status = EFI_NOT_READY;
+        } else {
+          CopyMem (NextVariableName, GetVariableNamePtr (VariablePtr, mVariableAuthFormat), VarNameSize);
+          CopyMem (&NextVendorGuid, GetVendorGuidPtr (VariablePtr, mVariableAuthFormat), sizeof (EFI_GUID));
+        }
+      }
+
+      if (!VariableRuntimeCacheReadRetry (&mVariableRuntimeCacheSequence, Sequence)) {
+        break;
+      }
+      Status = EFI_NOT_READY;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      if (VarNameSize <= *VariableNameSize) {
+        CopyMem (VariableName, NextVariableName, VarNameSize);
+        CopyGuid (VendorGuid, &NextVendorGuid);
+        Status = EFI_SUCCESS;
+      } else {
+        Status = EFI_BUFFER_TOO_SMALL;
+      }
+
+      *VariableNameSize = VarNameSize;
+    }
+  }
+  mVariableRuntimeCacheReadLock = FALSE;
+
+  return Status;
+}
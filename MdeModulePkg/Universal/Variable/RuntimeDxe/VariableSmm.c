@@ -426,6 +426,114 @@ SmmVariableGetStatistics (
 }
 
 
+/**
+  Get the variables following the cursor variable, as many as fit in the buffer.
+
+  The variables are returned as SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY structures, each
+  followed by the variable name and the variable data.
+
+  Caution: This function may receive untrusted input.
+  The cursor variable name has been copied into SMRAM and checked by the caller, the buffer is
+  the communicate buffer outside SMRAM.
+
+  @param[in]      VariableName    Name of the cursor variable. An empty name starts the enumeration.
+  @param[in]      VendorGuid      Vendor GUID of the cursor variable.
+  @param[out]     Buffer          Buffer to return the variables.
+  @param[in, out] BufferSize      On input, the size of Buffer. On output, the size of the returned
+                                  variables, or the size needed for the next variable if
+                                  EFI_BUFFER_TOO_SMALL is returned.
+  @param[out]     VariableCount   The number of returned variables.
+
+  @retval EFI_SUCCESS             At least one variable is returned.
+  @retval EFI_NOT_FOUND           No variable follows the cursor variable.
+  @retval EFI_BUFFER_TOO_SMALL    The buffer is too small for the next variable.
+  @retval EFI_INVALID_PARAMETER   The cursor variable is not found.
+
+**/
+EFI_STATUS
+SmmVariableGetNextVariableBatch (
+  IN     CHAR16                 *VariableName,
+  IN     EFI_GUID               *VendorGuid,
+  OUT    UINT8                  *Buffer,
+  IN OUT UINTN                  *BufferSize,
+  OUT    UINTN                  *VariableCount
+  )
+{
+  EFI_STATUS                                     Status;
+  BOOLEAN                                        AuthFormat;
+  VARIABLE_HEADER                                *VariablePtr;
+  VARIABLE_STORE_HEADER                          *VariableStoreHeader[VariableStoreTypeMax];
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY  *Entry;
+  UINTN                                          NameSize;
+  UINTN                                          DataSize;
+  UINTN                                          EntrySize;
+  UINTN                                          UsedSize;
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+
+  //
+  // 0: Volatile, 1: HOB, 2: Non-Volatile.
+  // The index and attributes mapping must be kept in this order as FindVariable
+  // makes use of this mapping to implement search algorithm.
+  //
+  VariableStoreHeader[VariableStoreTypeVolatile] = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  VariableStoreHeader[VariableStoreTypeHob]      = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+  VariableStoreHeader[VariableStoreTypeNv]       = mNvVariableCache;
+
+  UsedSize       = 0;
+  *VariableCount = 0;
+  do {
+    Status = VariableServiceGetNextVariableInternal (
+               VariableName,
+               VendorGuid,
+               VariableStoreHeader,
+               &VariablePtr,
+               AuthFormat
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    NameSize  = NameSizeOfVariable (VariablePtr, AuthFormat);
+    DataSize  = DataSizeOfVariable (VariablePtr, AuthFormat);
+    EntrySize = SMM_VARIABLE_BATCH_ENTRY_SIZE (NameSize, DataSize);
+    if (EntrySize > *BufferSize - UsedSize) {
+      if (*VariableCount == 0) {
+        UsedSize = EntrySize;
+        Status   = EFI_BUFFER_TOO_SMALL;
+      }
+      break;
+    }
+
+    Entry             = (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY *) (Buffer + UsedSize);
+    Entry->EntrySize  = (UINT32) EntrySize;
+    Entry->Attributes = VariablePtr->Attributes;
+    Entry->NameSize   = (UINT32) NameSize;
+    Entry->DataSize   = (UINT32) DataSize;
+    CopyGuid (&Entry->Guid, GetVendorGuidPtr (VariablePtr, AuthFormat));
+    CopyMem (Entry + 1, GetVariableNamePtr (VariablePtr, AuthFormat), NameSize);
+    CopyMem ((UINT8 *) (Entry + 1) + NameSize, GetVariableDataPtr (VariablePtr, AuthFormat), DataSize);
+
+    UsedSize += EntrySize;
+    (*VariableCount)++;
+
+    //
+    // The next variable follows the one just returned. The name and the GUID in the variable
+    // store are used as the cursor, rather than the copy in the communicate buffer.
+    //
+    VariableName = GetVariableNamePtr (VariablePtr, AuthFormat);
+    VendorGuid   = GetVendorGuidPtr (VariablePtr, AuthFormat);
+  } while (UsedSize < *BufferSize);
+
+  if ((*VariableCount != 0) && (Status == EFI_NOT_FOUND)) {
+    Status = EFI_SUCCESS;
+  }
+
+  *BufferSize = UsedSize;
+  return Status;
+}
+
+
 /**
   Communication service SMI Handler entry.
 
@@ -465,6 +573,8 @@ SmmVariableHandler (
   SMM_VARIABLE_COMMUNICATE_HEADER                         *SmmVariableFunctionHeader;
   SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE                *SmmVariableHeader;
   SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME         *GetNextVariableName;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH        *GetNextVariableBatch;
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT         *VariableBatchContext;
   SMM_VARIABLE_COMMUNICATE_QUERY_VARIABLE_INFO            *QueryVariableInfo;
   SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE               *GetPayloadSize;
   SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT *RuntimeVariableCacheContext;
@@ -478,6 +588,10 @@ SmmVariableHandler (
   UINTN                                                   NameBufferSize;
   UINTN                                                   CommBufferPayloadSize;
   UINTN                                                   TempCommBufferSize;
+  UINTN                                                   Function;
+  UINTN                                                   EntryOffset;
+  UINTN                                                   EntriesSize;
+  UINTN                                                   VariableCount;
 
   //
   // If input is invalid, stop processing this SMI
@@ -493,10 +607,6 @@ SmmVariableHandler (
     return EFI_SUCCESS;
   }
   CommBufferPayloadSize = TempCommBufferSize - SMM_VARIABLE_COMMUNICATE_HEADER_SIZE;
-  if (CommBufferPayloadSize > mVariableBufferPayloadSize) {
-    DEBUG ((EFI_D_ERROR, "SmmVariableHandler: SMM communication buffer payload size invalid!\n"));
-    return EFI_SUCCESS;
-  }
 
   if (!VariableSmmIsBufferOutsideSmmValid ((UINTN)CommBuffer, TempCommBufferSize)) {
     DEBUG ((EFI_D_ERROR, "SmmVariableHandler: SMM communication buffer in SMRAM or overflow!\n"));
@@ -504,7 +614,19 @@ SmmVariableHandler (
   }
 
   SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *)CommBuffer;
-  switch (SmmVariableFunctionHeader->Function) {
+  Function                  = SmmVariableFunctionHeader->Function;
+
+  //
+  // GetNextVariableBatch returns the variables in the communicate buffer directly, so its
+  // payload is not limited by the size of the pre-allocated SMM variable buffer payload.
+  //
+  if ((CommBufferPayloadSize > mVariableBufferPayloadSize) &&
+      (Function != SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_BATCH)) {
+    DEBUG ((EFI_D_ERROR, "SmmVariableHandler: SMM communication buffer payload size invalid!\n"));
+    return EFI_SUCCESS;
+  }
+
+  switch (Function) {
     case SMM_VARIABLE_FUNCTION_GET_VARIABLE:
       if (CommBufferPayloadSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name)) {
         DEBUG ((EFI_D_ERROR, "GetVariable: SMM communication buffer size invalid!\n"));
@@ -604,6 +726,63 @@ SmmVariableHandler (
       CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
       break;
 
+    case SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_BATCH:
+      if (CommBufferPayloadSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH, Name)) {
+        DEBUG ((EFI_D_ERROR, "GetNextVariableBatch: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      //
+      // Copy the cursor to pre-allocated SMM variable buffer payload. The variables are
+      // returned in the communicate buffer.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, MIN (CommBufferPayloadSize, mVariableBufferPayloadSize));
+      GetNextVariableBatch = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH *) mVariableBufferPayload;
+      if ((UINTN)(~0) - GetNextVariableBatch->NameSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH, Name) + sizeof (UINT64)) {
+        //
+        // Prevent InfoSize overflow happen
+        //
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+      InfoSize = OFFSET_OF(SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH, Name) + GetNextVariableBatch->NameSize;
+
+      //
+      // SMRAM range check already covered before
+      //
+      if (InfoSize > MIN (CommBufferPayloadSize, mVariableBufferPayloadSize)) {
+        DEBUG ((EFI_D_ERROR, "GetNextVariableBatch: Data size exceed communication buffer size limit!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      //
+      // The VariableSpeculationBarrier() call here is to ensure the previous
+      // range/content checks for the CommBuffer have been completed before the
+      // subsequent consumption of the CommBuffer content.
+      //
+      VariableSpeculationBarrier ();
+      if (GetNextVariableBatch->NameSize < sizeof (CHAR16) || GetNextVariableBatch->Name[GetNextVariableBatch->NameSize/sizeof (CHAR16) - 1] != L'\0') {
+        //
+        // Make sure the cursor VariableName is A Null-terminated string.
+        //
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      EntryOffset = SMM_VARIABLE_BATCH_ENTRY_OFFSET (GetNextVariableBatch->NameSize);
+      EntriesSize = (EntryOffset < CommBufferPayloadSize) ? CommBufferPayloadSize - EntryOffset : 0;
+      Status = SmmVariableGetNextVariableBatch (
+                 GetNextVariableBatch->Name,
+                 &GetNextVariableBatch->Guid,
+                 SmmVariableFunctionHeader->Data + EntryOffset,
+                 &EntriesSize,
+                 &VariableCount
+                 );
+      GetNextVariableBatch = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH *) SmmVariableFunctionHeader->Data;
+      GetNextVariableBatch->VariableCount = VariableCount;
+      GetNextVariableBatch->EntriesSize   = EntriesSize;
+      break;
+
     case SMM_VARIABLE_FUNCTION_SET_VARIABLE:
       if (CommBufferPayloadSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name)) {
         DEBUG ((EFI_D_ERROR, "SetVariable: SMM communication buffer size invalid!\n"));
@@ -888,6 +1067,14 @@ SmmVariableHandler (
         Status = EFI_ACCESS_DENIED;
         goto EXIT;
       }
+      if (RuntimeVariableCacheContext->Sequence != NULL &&
+          !VariableSmmIsBufferOutsideSmmValid (
+            (UINTN) RuntimeVariableCacheContext->Sequence,
+            sizeof (*(RuntimeVariableCacheContext->Sequence)))) {
+        DEBUG ((DEBUG_ERROR, "InitRuntimeVariableCacheContext: Runtime cache sequence buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
 
       VariableCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
       VariableCacheContext->VariableRuntimeHobCache.Store      = RuntimeVariableCacheContext->RuntimeHobCache;
@@ -896,6 +1083,7 @@ SmmVariableHandler (
       VariableCacheContext->PendingUpdate                      = RuntimeVariableCacheContext->PendingUpdate;
       VariableCacheContext->ReadLock                           = RuntimeVariableCacheContext->ReadLock;
       VariableCacheContext->HobFlushComplete                   = RuntimeVariableCacheContext->HobFlushComplete;
+      VariableCacheContext->Sequence                           = RuntimeVariableCacheContext->Sequence;
 
       // Set up the intial pending request since the RT cache needs to be in sync with SMM cache
       VariableCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
@@ -947,6 +1135,36 @@ SmmVariableHandler (
 
       Status = EFI_SUCCESS;
       break;
+    case SMM_VARIABLE_FUNCTION_INIT_VARIABLE_BATCH_CONTEXT:
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT)) {
+        DEBUG ((DEBUG_ERROR, "InitVariableBatchContext: SMM communication buffer size invalid!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+      if (mEndOfDxe) {
+        DEBUG ((DEBUG_ERROR, "InitVariableBatchContext: Cannot init context after end of DXE!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      //
+      // Copy the input communicate buffer payload to the pre-allocated SMM variable payload buffer.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, sizeof (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT));
+      VariableBatchContext = (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT *) mVariableBufferPayload;
+
+      if (VariableBatchContext->StoreGeneration == NULL ||
+          !VariableSmmIsBufferOutsideSmmValid (
+            (UINTN) VariableBatchContext->StoreGeneration,
+            sizeof (*(VariableBatchContext->StoreGeneration)))) {
+        DEBUG ((DEBUG_ERROR, "InitVariableBatchContext: Variable store generation buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      mVariableModuleGlobal->VariableGlobal.StoreGeneration = VariableBatchContext->StoreGeneration;
+      Status = EFI_SUCCESS;
+      break;
 
     default:
       Status = EFI_UNSUPPORTED;
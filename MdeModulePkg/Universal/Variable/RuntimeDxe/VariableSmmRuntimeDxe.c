@@ -41,6 +41,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "PrivilegePolymorphic.h"
 #include "VariableParsing.h"
+#include "VariableRuntimeCacheReader.h"
 
 EFI_HANDLE                       mHandle                    = NULL;
 EFI_SMM_VARIABLE_PROTOCOL       *mSmmVariable               = NULL;
@@ -61,10 +62,29 @@ BOOLEAN                          mVariableRuntimeCachePendingUpdate;
 BOOLEAN                          mVariableRuntimeCacheReadLock;
 BOOLEAN                          mVariableAuthFormat;
 BOOLEAN                          mHobFlushComplete;
+UINT32                           mVariableRuntimeCacheSequence;
 EFI_LOCK                         mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL     mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL         mVarCheck;
 
+///
+/// The cursor of the variables enumerated in batches. Entry is the variable last returned by
+/// GetNextVariableName(), or NULL if it is the cursor variable the batch was fetched with.
+/// Generation is the variable store generation the batch was fetched at.
+///
+typedef struct {
+  BOOLEAN                                        Valid;
+  UINT32                                         Generation;
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY  *Entry;
+} VARIABLE_BATCH_CURSOR;
+
+UINT8                           *mVariableBatchBuffer         = NULL;
+UINT8                           *mVariableBatchBufferPhysical = NULL;
+UINTN                            mVariableBatchBufferSize;
+VARIABLE_BATCH_CURSOR            mVariableBatchCursor;
+UINT32                           mVariableStoreGeneration;
+BOOLEAN                          mVariableStoreGenerationReady;
+
 /**
   The logic to initialize the VariablePolicy engine is in its own file.
 
@@ -566,122 +586,6 @@ CheckForRuntimeCacheSync (
   }
 }
 
-/**
-  Finds the given variable in a runtime cache variable store.
-
-  Caution: This function may receive untrusted input.
-  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
-
-  @param[in]      VariableName       Name of Variable to be found.
-  @param[in]      VendorGuid         Variable vendor GUID.
-  @param[out]     Attributes         Attribute value of the variable found.
-  @param[in, out] DataSize           Size of Data found. If size is less than the
-                                     data, this value contains the required size.
-  @param[out]     Data               Data pointer.
-
-  @retval EFI_SUCCESS                Found the specified variable.
-  @retval EFI_INVALID_PARAMETER      Invalid parameter.
-  @retval EFI_NOT_FOUND              The specified variable could not be found.
-
-**/
-EFI_STATUS
-FindVariableInRuntimeCache (
-  IN      CHAR16                            *VariableName,
-  IN      EFI_GUID                          *VendorGuid,
-  OUT     UINT32                            *Attributes OPTIONAL,
-  IN OUT  UINTN                             *DataSize,
-  OUT     VOID                              *Data OPTIONAL
-  )
-{
-  EFI_STATUS              Status;
-  UINTN                   TempDataSize;
-  VARIABLE_POINTER_TRACK  RtPtrTrack;
-  VARIABLE_STORE_TYPE     StoreType;
-  VARIABLE_STORE_HEADER   *VariableStoreList[VariableStoreTypeMax];
-
-  Status = EFI_NOT_FOUND;
-
-  if (VariableName == NULL || VendorGuid == NULL || DataSize == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  ZeroMem (&RtPtrTrack, sizeof (RtPtrTrack));
-
-  //
-  // The UEFI specification restricts Runtime Services callers from invoking the same or certain other Runtime Service
-  // functions prior to completion and return from a previous Runtime Service call. These restrictions prevent
-  // a GetVariable () or GetNextVariable () call from being issued until a prior call has returned. The runtime
-  // cache read lock should always be free when entering this function.
-  //
-  ASSERT (!mVariableRuntimeCacheReadLock);
-
-  mVariableRuntimeCacheReadLock = TRUE;
-  CheckForRuntimeCacheSync ();
-
-  if (!mVariableRuntimeCachePendingUpdate) {
-    //
-    // 0: Volatile, 1: HOB, 2: Non-Volatile.
-    // The index and attributes mapping must be kept in this order as FindVariable
-    // makes use of this mapping to implement search algorithm.
-    //
-    VariableStoreList[VariableStoreTypeVolatile] = mVariableRuntimeVolatileCacheBuffer;
-    VariableStoreList[VariableStoreTypeHob]      = mVariableRuntimeHobCacheBuffer;
-    VariableStoreList[VariableStoreTypeNv]       = mVariableRuntimeNvCacheBuffer;
-
-    for (StoreType = (VARIABLE_STORE_TYPE) 0; StoreType < VariableStoreTypeMax; StoreType++) {
-      if (VariableStoreList[StoreType] == NULL) {
-        continue;
-      }
-
-      RtPtrTrack.StartPtr = GetStartPointer (VariableStoreList[StoreType]);
-      RtPtrTrack.EndPtr   = GetEndPointer   (VariableStoreList[StoreType]);
-      RtPtrTrack.Volatile = (BOOLEAN) (StoreType == VariableStoreTypeVolatile);
-
-      Status = FindVariableEx (VariableName, VendorGuid, FALSE, &RtPtrTrack, mVariableAuthFormat);
-      if (!EFI_ERROR (Status)) {
-        break;
-      }
-    }
-
-    if (!EFI_ERROR (Status)) {
-      //
-      // Get data size
-      //
-      TempDataSize = DataSizeOfVariable (RtPtrTrack.CurrPtr, mVariableAuthFormat);
-      ASSERT (TempDataSize != 0);
-
-      if (*DataSize >= TempDataSize) {
-        if (Data == NULL) {
-          Status = EFI_INVALID_PARAMETER;
-          goto Done;
-        }
-
-        CopyMem (Data, GetVariableDataPtr (RtPtrTrack.CurrPtr, mVariableAuthFormat), TempDataSize);
-        *DataSize = TempDataSize;
-
-        UpdateVariableInfo (VariableName, VendorGuid, RtPtrTrack.Volatile, TRUE, FALSE, FALSE, TRUE, &mVariableInfo);
-
-        Status = EFI_SUCCESS;
-        goto Done;
-      } else {
-        *DataSize = TempDataSize;
-        Status = EFI_BUFFER_TOO_SMALL;
-        goto Done;
-      }
-    }
-  }
-
-Done:
-  if (Status == EFI_SUCCESS || Status == EFI_BUFFER_TOO_SMALL) {
-    if (Attributes != NULL && RtPtrTrack.CurrPtr != NULL) {
-      *Attributes = RtPtrTrack.CurrPtr->Attributes;
-    }
-  }
-  mVariableRuntimeCacheReadLock = FALSE;
-
-  return Status;
-}
-
 /**
   Finds the given variable in a variable store in SMM.
 
@@ -792,10 +696,206 @@ Done:
 }
 
 /**
-  This code finds variable in storage blocks (Volatile or Non-Volatile).
+  Get the payload of the variable batch communicate buffer.
 
-  Caution: This function may receive untrusted input.
-  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
+  @return The GetNextVariableBatch payload.
+
+**/
+SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH *
+GetVariableBatchPayload (
+  VOID
+  )
+{
+  EFI_MM_COMMUNICATE_HEADER                 *SmmCommunicateHeader;
+  SMM_VARIABLE_COMMUNICATE_HEADER           *SmmVariableFunctionHeader;
+
+  SmmCommunicateHeader      = (EFI_MM_COMMUNICATE_HEADER *) mVariableBatchBuffer;
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) SmmCommunicateHeader->Data;
+  return (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH *) SmmVariableFunctionHeader->Data;
+}
+
+/**
+  Fetch the variables following the specified variable from SMM into the batch buffer, and
+  position the cursor at the specified variable.
+
+  @param[in, out] Cursor             The variable batch cursor.
+  @param[in]      VariableName       Name of the variable to fetch the following variables of.
+                                     An empty name fetches the first variables.
+  @param[in]      VendorGuid         Vendor GUID of the variable.
+
+  @retval EFI_SUCCESS                At least one following variable is fetched.
+  @retval EFI_NOT_FOUND              No variable follows the specified variable.
+  @retval EFI_BUFFER_TOO_SMALL       The batch buffer is too small for the name of the specified
+                                     variable or for the following variable.
+  @retval EFI_INVALID_PARAMETER      The specified variable is not found.
+
+**/
+EFI_STATUS
+VariableBatchCursorSeek (
+  IN OUT  VARIABLE_BATCH_CURSOR             *Cursor,
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid
+  )
+{
+  EFI_STATUS                                        Status;
+  EFI_MM_COMMUNICATE_HEADER                         *SmmCommunicateHeader;
+  SMM_VARIABLE_COMMUNICATE_HEADER                   *SmmVariableFunctionHeader;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH  *GetNextVariableBatch;
+  UINTN                                             PayloadSize;
+  UINTN                                             VariableNameSize;
+  UINTN                                             CommSize;
+
+  Cursor->Valid = FALSE;
+  Cursor->Entry = NULL;
+
+  PayloadSize      = mVariableBatchBufferSize - SMM_COMMUNICATE_HEADER_SIZE - SMM_VARIABLE_COMMUNICATE_HEADER_SIZE;
+  VariableNameSize = StrSize (VariableName);
+  if (SMM_VARIABLE_BATCH_ENTRY_OFFSET (VariableNameSize) >= PayloadSize) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  SmmCommunicateHeader = (EFI_MM_COMMUNICATE_HEADER *) mVariableBatchBuffer;
+  CopyGuid (&SmmCommunicateHeader->HeaderGuid, &gEfiSmmVariableProtocolGuid);
+  SmmCommunicateHeader->MessageLength = SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize;
+
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) SmmCommunicateHeader->Data;
+  SmmVariableFunctionHeader->Function = SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_BATCH;
+
+  //
+  // The variable may be one in the previous batch, so the name is copied with CopyMem() which
+  // allows the buffers to overlap.
+  //
+  GetNextVariableBatch = GetVariableBatchPayload ();
+  CopyGuid (&GetNextVariableBatch->Guid, VendorGuid);
+  GetNextVariableBatch->NameSize      = VariableNameSize;
+  GetNextVariableBatch->VariableCount = 0;
+  GetNextVariableBatch->EntriesSize   = 0;
+  CopyMem (GetNextVariableBatch->Name, VariableName, VariableNameSize);
+
+  //
+  // The generation is read before the SMI, so an update of the variable store that races with
+  // the fetch makes the batch out of date rather than going unnoticed.
+  //
+  Cursor->Generation = *(volatile UINT32 *) &mVariableStoreGeneration;
+
+  //
+  // Send data to SMM.
+  //
+  CommSize = mVariableBatchBufferSize;
+  Status = mMmCommunication2->Communicate (mMmCommunication2,
+                                           mVariableBatchBufferPhysical,
+                                           mVariableBatchBuffer,
+                                           &CommSize);
+  ASSERT_EFI_ERROR (Status);
+
+  Status = SmmVariableFunctionHeader->ReturnStatus;
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((GetNextVariableBatch->VariableCount == 0) ||
+      (GetNextVariableBatch->EntriesSize > PayloadSize - SMM_VARIABLE_BATCH_ENTRY_OFFSET (VariableNameSize))) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Cursor->Valid = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the variable following the cursor. The following batch is fetched from SMM if the cursor
+  is at the last variable of the batch buffer. The cursor is not moved to the variable.
+
+  @param[in, out] Cursor             The variable batch cursor.
+  @param[out]     Entry              Return the variable following the cursor.
+
+  @retval EFI_SUCCESS                The variable following the cursor is returned.
+  @retval EFI_NOT_FOUND              No variable follows the cursor.
+  @retval Others                     The following batch could not be fetched from SMM.
+
+**/
+EFI_STATUS
+VariableBatchCursorNext (
+  IN OUT  VARIABLE_BATCH_CURSOR                          *Cursor,
+  OUT     SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY  **Entry
+  )
+{
+  EFI_STATUS                                        Status;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH  *GetNextVariableBatch;
+  UINT8                                             *EntriesStart;
+  UINT8                                             *NextEntry;
+
+  ASSERT (Cursor->Valid);
+
+  GetNextVariableBatch = GetVariableBatchPayload ();
+  EntriesStart = (UINT8 *) GetNextVariableBatch + SMM_VARIABLE_BATCH_ENTRY_OFFSET (GetNextVariableBatch->NameSize);
+  if (Cursor->Entry == NULL) {
+    NextEntry = EntriesStart;
+  } else {
+    NextEntry = (UINT8 *) Cursor->Entry + Cursor->Entry->EntrySize;
+  }
+
+  if (NextEntry >= EntriesStart + GetNextVariableBatch->EntriesSize) {
+    //
+    // The batch is used up, fetch the variables following the last one.
+    //
+    ASSERT (Cursor->Entry != NULL);
+    Status = VariableBatchCursorSeek (Cursor, (CHAR16 *) (Cursor->Entry + 1), &Cursor->Entry->Guid);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    NextEntry = (UINT8 *) GetNextVariableBatch + SMM_VARIABLE_BATCH_ENTRY_OFFSET (GetNextVariableBatch->NameSize);
+  }
+
+  *Entry = (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY *) NextEntry;
+  return EFI_SUCCESS;
+}
+
+/**
+  Check whether the cursor is at the specified variable.
+
+  @param[in]  Cursor                 The variable batch cursor.
+  @param[in]  VariableName           Name of the variable.
+  @param[in]  VendorGuid             Vendor GUID of the variable.
+
+  @retval TRUE                       The cursor is at the specified variable.
+  @retval FALSE                      The cursor is not at the specified variable, or SMM updated
+                                     the variable store since the batch was fetched.
+
+**/
+BOOLEAN
+VariableBatchCursorIsAt (
+  IN      VARIABLE_BATCH_CURSOR             *Cursor,
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_BATCH  *GetNextVariableBatch;
+
+  if (!Cursor->Valid) {
+    return FALSE;
+  }
+
+  if (mVariableStoreGenerationReady &&
+      (Cursor->Generation != *(volatile UINT32 *) &mVariableStoreGeneration)) {
+    return FALSE;
+  }
+
+  if (Cursor->Entry == NULL) {
+    GetNextVariableBatch = GetVariableBatchPayload ();
+    return (BOOLEAN) (CompareGuid (&GetNextVariableBatch->Guid, VendorGuid) &&
+                      (StrCmp (GetNextVariableBatch->Name, VariableName) == 0));
+  }
+
+  return (BOOLEAN) (CompareGuid (&Cursor->Entry->Guid, VendorGuid) &&
+                    (StrCmp ((CHAR16 *) (Cursor->Entry + 1), VariableName) == 0));
+}
+
+/**
+  Finds the variable in the batch buffer. Only the variable last returned by GetNextVariableName()
+  is found, which is the one that is read when all the variables are enumerated. It is served
+  from the batch buffer only while SMM has not updated the variable store since the batch was
+  fetched.
 
   @param[in]      VariableName       Name of Variable to be found.
   @param[in]      VendorGuid         Variable vendor GUID.
@@ -804,44 +904,53 @@ Done:
                                      data, this value contains the required size.
   @param[out]     Data               Data pointer.
 
+  @retval EFI_SUCCESS                Found the specified variable.
   @retval EFI_INVALID_PARAMETER      Invalid parameter.
-  @retval EFI_SUCCESS                Find the specified variable.
-  @retval EFI_NOT_FOUND              Not found.
-  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+  @retval EFI_BUFFER_TOO_SMALL       DataSize is too small for the result.
+  @retval EFI_NOT_READY              The variable must be read from SMM.
 
 **/
 EFI_STATUS
-EFIAPI
-RuntimeServiceGetVariable (
+FindVariableInBatch (
   IN      CHAR16                            *VariableName,
   IN      EFI_GUID                          *VendorGuid,
   OUT     UINT32                            *Attributes OPTIONAL,
   IN OUT  UINTN                             *DataSize,
-  OUT     VOID                              *Data
+  OUT     VOID                              *Data OPTIONAL
   )
 {
-  EFI_STATUS                                Status;
+  EFI_STATUS                                     Status;
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY  *Entry;
 
-  if (VariableName == NULL || VendorGuid == NULL || DataSize == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-  if (VariableName[0] == 0) {
-    return EFI_NOT_FOUND;
+  if ((mVariableBatchBuffer == NULL) || !mVariableStoreGenerationReady ||
+      (mVariableBatchCursor.Entry == NULL) ||
+      !VariableBatchCursorIsAt (&mVariableBatchCursor, VariableName, VendorGuid)) {
+    return EFI_NOT_READY;
   }
 
-  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
-  if (FeaturePcdGet (PcdEnableVariableRuntimeCache)) {
-    Status = FindVariableInRuntimeCache (VariableName, VendorGuid, Attributes, DataSize, Data);
+  Entry = mVariableBatchCursor.Entry;
+  if (*DataSize >= Entry->DataSize) {
+    if (Data == NULL) {
+      Status = EFI_INVALID_PARAMETER;
+    } else {
+      CopyMem (Data, (UINT8 *) (Entry + 1) + Entry->NameSize, Entry->DataSize);
+      Status = EFI_SUCCESS;
+    }
   } else {
-    Status = FindVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
+    Status = EFI_BUFFER_TOO_SMALL;
+  }
+
+  *DataSize = Entry->DataSize;
+  if (Attributes != NULL) {
+    *Attributes = Entry->Attributes;
   }
-  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
 
   return Status;
 }
 
 /**
-  Finds the next available variable in a runtime cache variable store.
+  Finds the next available variable in the batch buffer, fetching the variables from SMM in
+  batches.
 
   @param[in, out] VariableNameSize   Size of the variable name.
   @param[in, out] VariableName       Pointer to variable name.
@@ -851,65 +960,109 @@ RuntimeServiceGetVariable (
   @retval EFI_SUCCESS                Find the specified variable.
   @retval EFI_NOT_FOUND              Not found.
   @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+  @retval EFI_UNSUPPORTED            The variable can not be enumerated in batches.
 
 **/
 EFI_STATUS
-GetNextVariableNameInRuntimeCache (
+GetNextVariableNameInBatch (
   IN OUT  UINTN                             *VariableNameSize,
   IN OUT  CHAR16                            *VariableName,
   IN OUT  EFI_GUID                          *VendorGuid
   )
 {
-  EFI_STATUS              Status;
-  UINTN                   VarNameSize;
-  VARIABLE_HEADER         *VariablePtr;
-  VARIABLE_STORE_HEADER   *VariableStoreHeader[VariableStoreTypeMax];
+  EFI_STATUS                                     Status;
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_ENTRY  *Entry;
 
-  Status = EFI_NOT_FOUND;
+  if (mVariableBatchBuffer == NULL) {
+    return EFI_UNSUPPORTED;
+  }
 
   //
-  // The UEFI specification restricts Runtime Services callers from invoking the same or certain other Runtime Service
-  // functions prior to completion and return from a previous Runtime Service call. These restrictions prevent
-  // a GetVariable () or GetNextVariable () call from being issued until a prior call has returned. The runtime
-  // cache read lock should always be free when entering this function.
+  // The enumeration is continued from the batch buffer if the variable is the one at the cursor
+  // and the variable store has not been updated since. A new enumeration always fetches the
+  // variables from SMM again.
   //
-  ASSERT (!mVariableRuntimeCacheReadLock);
-
-  CheckForRuntimeCacheSync ();
-
-  mVariableRuntimeCacheReadLock = TRUE;
-  if (!mVariableRuntimeCachePendingUpdate) {
+  Status = EFI_SUCCESS;
+  if ((VariableName[0] == 0) || !VariableBatchCursorIsAt (&mVariableBatchCursor, VariableName, VendorGuid)) {
+    Status = VariableBatchCursorSeek (&mVariableBatchCursor, VariableName, VendorGuid);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = VariableBatchCursorNext (&mVariableBatchCursor, &Entry);
+  }
+  if (Status == EFI_BUFFER_TOO_SMALL) {
     //
-    // 0: Volatile, 1: HOB, 2: Non-Volatile.
-    // The index and attributes mapping must be kept in this order as FindVariable
-    // makes use of this mapping to implement search algorithm.
+    // The variable does not fit in the batch buffer.
     //
-    VariableStoreHeader[VariableStoreTypeVolatile] = mVariableRuntimeVolatileCacheBuffer;
-    VariableStoreHeader[VariableStoreTypeHob]      = mVariableRuntimeHobCacheBuffer;
-    VariableStoreHeader[VariableStoreTypeNv]       = mVariableRuntimeNvCacheBuffer;
-
-    Status =  VariableServiceGetNextVariableInternal (
-                VariableName,
-                VendorGuid,
-                VariableStoreHeader,
-                &VariablePtr,
-                mVariableAuthFormat
-                );
-    if (!EFI_ERROR (Status)) {
-      VarNameSize = NameSizeOfVariable (VariablePtr, mVariableAuthFormat);
-      ASSERT (VarNameSize != 0);
-      if (VarNameSize <= *VariableNameSize) {
-        CopyMem (VariableName, GetVariableNamePtr (VariablePtr, mVariableAuthFormat), VarNameSize);
-        CopyMem (VendorGuid, GetVendorGuidPtr (VariablePtr, mVariableAuthFormat), sizeof (EFI_GUID));
-        Status = EFI_SUCCESS;
-      } else {
-        Status = EFI_BUFFER_TOO_SMALL;
-      }
+    return EFI_UNSUPPORTED;
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Entry->NameSize > *VariableNameSize) {
+    *VariableNameSize = Entry->NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  CopyMem (VariableName, Entry + 1, Entry->NameSize);
+  CopyGuid (VendorGuid, &Entry->Guid);
+  *VariableNameSize = Entry->NameSize;
+  mVariableBatchCursor.Entry = Entry;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  This code finds variable in storage blocks (Volatile or Non-Volatile).
+
+  Caution: This function may receive untrusted input.
+  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
 
-      *VariableNameSize = VarNameSize;
+  @param[in]      VariableName       Name of Variable to be found.
+  @param[in]      VendorGuid         Variable vendor GUID.
+  @param[out]     Attributes         Attribute value of the variable found.
+  @param[in, out] DataSize           Size of Data found. If size is less than the
+                                     data, this value contains the required size.
+  @param[out]     Data               Data pointer.
+
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              Not found.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+
+**/
+EFI_STATUS
+EFIAPI
+RuntimeServiceGetVariable (
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid,
+  OUT     UINT32                            *Attributes OPTIONAL,
+  IN OUT  UINTN                             *DataSize,
+  OUT     VOID                              *Data
+  )
+{
+  EFI_STATUS                                Status;
+
+  if (VariableName == NULL || VendorGuid == NULL || DataSize == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (VariableName[0] == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+  if (FeaturePcdGet (PcdEnableVariableRuntimeCache)) {
+    Status = FindVariableInRuntimeCache (VariableName, VendorGuid, Attributes, DataSize, Data);
+    if (Status == EFI_NOT_READY) {
+      Status = FindVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
+    }
+  } else {
+    Status = FindVariableInBatch (VariableName, VendorGuid, Attributes, DataSize, Data);
+    if (Status == EFI_NOT_READY) {
+      Status = FindVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
     }
   }
-  mVariableRuntimeCacheReadLock = FALSE;
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
 
   return Status;
 }
@@ -1057,8 +1210,14 @@ RuntimeServiceGetNextVariableName (
   AcquireLockOnlyAtBootTime (&mVariableServicesLock);
   if (FeaturePcdGet (PcdEnableVariableRuntimeCache)) {
     Status = GetNextVariableNameInRuntimeCache (VariableNameSize, VariableName, VendorGuid);
+    if (Status == EFI_NOT_READY) {
+      Status = GetNextVariableNameInSmm (VariableNameSize, VariableName, VendorGuid);
+    }
   } else {
-    Status = GetNextVariableNameInSmm (VariableNameSize, VariableName, VendorGuid);
+    Status = GetNextVariableNameInBatch (VariableNameSize, VariableName, VendorGuid);
+    if (Status == EFI_UNSUPPORTED) {
+      Status = GetNextVariableNameInSmm (VariableNameSize, VariableName, VendorGuid);
+    }
   }
   ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
 
@@ -1124,6 +1283,11 @@ RuntimeServiceSetVariable (
 
   AcquireLockOnlyAtBootTime(&mVariableServicesLock);
 
+  //
+  // The variables in the batch buffer may be out of date after the variable is set.
+  //
+  mVariableBatchCursor.Valid = FALSE;
+
   //
   // Init the communicate buffer. The buffer data size is:
   // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize.
@@ -1250,6 +1414,11 @@ OnExitBootServices (
   IN      VOID                              *Context
   )
 {
+  //
+  // The variables without EFI_VARIABLE_RUNTIME_ACCESS in the batch buffer are no longer visible.
+  //
+  mVariableBatchCursor.Valid = FALSE;
+
   //
   // Init the communicate buffer. The buffer data size is:
   // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE.
@@ -1327,6 +1496,8 @@ VariableAddressChangeEvent (
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeHobCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeNvCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeVolatileCacheBuffer);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableBatchBuffer);
+  mVariableBatchCursor.Valid = FALSE;
 }
 
 /**
@@ -1534,6 +1705,7 @@ SendRuntimeVariableCacheContextToSmm (
   SmmRuntimeVarCacheContext->RuntimeNvCache = mVariableRuntimeNvCacheBuffer;
   SmmRuntimeVarCacheContext->PendingUpdate = &mVariableRuntimeCachePendingUpdate;
   SmmRuntimeVarCacheContext->ReadLock = &mVariableRuntimeCacheReadLock;
+  SmmRuntimeVarCacheContext->Sequence = &mVariableRuntimeCacheSequence;
   SmmRuntimeVarCacheContext->HobFlushComplete = &mHobFlushComplete;
 
   //
@@ -1556,6 +1728,68 @@ Done:
   return Status;
 }
 
+/**
+  Sends the variable store generation used by the batch enumeration to SMM.
+
+  @retval EFI_SUCCESS               SMM increments the generation on every variable store update.
+  @retval EFI_OUT_OF_RESOURCES      The memory resources needed for a CommBuffer are not available.
+  @retval Others                    SMM does not maintain the generation.
+
+**/
+EFI_STATUS
+SendVariableBatchContextToSmm (
+  VOID
+  )
+{
+  EFI_STATUS                                                Status;
+  SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT           *SmmVariableBatchContext;
+  EFI_MM_COMMUNICATE_HEADER                                 *SmmCommunicateHeader;
+  SMM_VARIABLE_COMMUNICATE_HEADER                           *SmmVariableFunctionHeader;
+  UINTN                                                     CommSize;
+  UINT8                                                     *CommBuffer;
+
+  CommBuffer = mVariableBuffer;
+
+  if (CommBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+
+  //
+  // Init the communicate buffer. The buffer data size is:
+  // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + sizeof (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT);
+  //
+  CommSize = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + sizeof (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT);
+  ZeroMem (CommBuffer, CommSize);
+
+  SmmCommunicateHeader = (EFI_MM_COMMUNICATE_HEADER *) CommBuffer;
+  CopyGuid (&SmmCommunicateHeader->HeaderGuid, &gEfiSmmVariableProtocolGuid);
+  SmmCommunicateHeader->MessageLength = SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + sizeof (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT);
+
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) SmmCommunicateHeader->Data;
+  SmmVariableFunctionHeader->Function = SMM_VARIABLE_FUNCTION_INIT_VARIABLE_BATCH_CONTEXT;
+  SmmVariableBatchContext = (SMM_VARIABLE_COMMUNICATE_VARIABLE_BATCH_CONTEXT *) SmmVariableFunctionHeader->Data;
+
+  SmmVariableBatchContext->StoreGeneration = &mVariableStoreGeneration;
+
+  //
+  // Send data to SMM.
+  //
+  Status = mMmCommunication2->Communicate (mMmCommunication2, CommBuffer, CommBuffer, &CommSize);
+  ASSERT_EFI_ERROR (Status);
+  if (CommSize <= SMM_VARIABLE_COMMUNICATE_HEADER_SIZE) {
+    Status = EFI_BAD_BUFFER_SIZE;
+    goto Done;
+  }
+
+  Status = SmmVariableFunctionHeader->ReturnStatus;
+
+Done:
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+  return Status;
+}
+
 /**
   Initialize variable service and install Variable Architectural protocol.
 
@@ -1628,6 +1862,22 @@ SmmVariableReady (
     ASSERT_EFI_ERROR (Status);
   } else {
     DEBUG ((DEBUG_INFO, "Variable driver runtime cache is disabled.\n"));
+    if (PcdGet32 (PcdVariableBatchBufferSize) != 0) {
+      //
+      // Allocate memory for variable batch communicate buffer.
+      //
+      mVariableBatchBufferSize     = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PcdGet32 (PcdVariableBatchBufferSize);
+      mVariableBatchBuffer         = AllocateRuntimePool (mVariableBatchBufferSize);
+      mVariableBatchBufferPhysical = mVariableBatchBuffer;
+      if (mVariableBatchBuffer != NULL) {
+        DEBUG ((DEBUG_INFO, "Variable driver batch enumeration is enabled.\n"));
+        //
+        // Without the generation from SMM, GetVariable() is not served from the batch buffer.
+        //
+        Status = SendVariableBatchContextToSmm ();
+        mVariableStoreGenerationReady = (BOOLEAN) !EFI_ERROR (Status);
+      }
+    }
   }
 
   gRT->GetVariable         = RuntimeServiceGetVariable;
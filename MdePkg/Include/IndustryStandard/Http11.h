@@ -76,6 +76,21 @@
 ///
 #define HTTP_HEADER_ACCEPT_RANGES      "Accept-Ranges"
 
+///
+/// Range Request Header
+/// The Range request-header field restricts the request to one
+/// or more sub-ranges of the entity, in the form "bytes=first-last".
+///
+#define HTTP_HEADER_RANGE              "Range"
+
+///
+/// Content-Range Header
+/// The Content-Range entity-header is sent with a partial entity-body
+/// to specify where in the full entity-body the partial body should be
+/// applied, in the form "bytes first-last/length".
+///
+#define HTTP_HEADER_CONTENT_RANGE      "Content-Range"
+
 
 ///
 /// Accept-Encoding Request Header
@@ -174,6 +189,16 @@
 ///
 #define HTTP_HEADER_HOST              "Host"
 
+///
+/// Connection General Header
+///
+/// The Connection general-header field allows the sender to specify options that are
+/// desired for that particular connection. The "close" option signals that the connection
+/// will be closed after completion of the response.
+///
+#define HTTP_HEADER_CONNECTION         "Connection"
+#define HTTP_HEADER_CONNECTION_CLOSE   "close"
+
 ///
 /// Location Response Header
 ///
@@ -0,0 +1,758 @@
+/** @file
+  A pair of virtual NICs connected back to back by an in-memory wire,
+  which drops and delays the frames as configured.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "TcpLoopbackTest.h"
+
+EFI_GUID  mLoopbackNicVendorGuid = {
+  0xcb59d6fc, 0xb399, 0x4b30, { 0xb6, 0x47, 0xfa, 0x2f, 0x0f, 0x58, 0x89, 0x2c }
+};
+
+/**
+  Get the current time of the wire.
+
+  @return The time in nanoseconds.
+
+**/
+UINT64
+LoopbackGetTime (
+  VOID
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Decide whether to drop a frame, with a linear congruential generator.
+
+  @param[in, out]  Wire     The wire the frame is sent on.
+
+  @retval TRUE     Drop the frame.
+  @retval FALSE    Deliver the frame.
+
+**/
+BOOLEAN
+LoopbackWireDrop (
+  IN OUT LOOPBACK_WIRE  *Wire
+  )
+{
+  if (Wire->LossRate == 0) {
+    return FALSE;
+  }
+
+  Wire->Seed = Wire->Seed * 1103515245 + 12345;
+  return (BOOLEAN) (((Wire->Seed >> 16) % 10000) < Wire->LossRate);
+}
+
+/**
+  Changes the state of a network interface from "stopped" to "started".
+
+  @param[in]  This      Protocol instance pointer.
+
+  @retval EFI_SUCCESS           The network interface was started.
+  @retval EFI_ALREADY_STARTED   The network interface is already in the started state.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicStart (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This
+  )
+{
+  if (This->Mode->State != EfiSimpleNetworkStopped) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  This->Mode->State = EfiSimpleNetworkStarted;
+  return EFI_SUCCESS;
+}
+
+/**
+  Changes the state of a network interface from "started" to "stopped".
+
+  @param[in]  This      Protocol instance pointer.
+
+  @retval EFI_SUCCESS           The network interface was stopped.
+  @retval EFI_NOT_STARTED       The network interface has not been started.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicStop (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This
+  )
+{
+  if (This->Mode->State == EfiSimpleNetworkStopped) {
+    return EFI_NOT_STARTED;
+  }
+
+  This->Mode->State = EfiSimpleNetworkStopped;
+  return EFI_SUCCESS;
+}
+
+/**
+  Initializes the network interface.
+
+  @param[in]  This              Protocol instance pointer.
+  @param[in]  ExtraRxBufferSize Ignored.
+  @param[in]  ExtraTxBufferSize Ignored.
+
+  @retval EFI_SUCCESS           The network interface was initialized.
+  @retval EFI_NOT_STARTED       The network interface has not been started.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicInitialize (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN UINTN                        ExtraRxBufferSize  OPTIONAL,
+  IN UINTN                        ExtraTxBufferSize  OPTIONAL
+  )
+{
+  if (This->Mode->State == EfiSimpleNetworkStopped) {
+    return EFI_NOT_STARTED;
+  }
+
+  This->Mode->State = EfiSimpleNetworkInitialized;
+  return EFI_SUCCESS;
+}
+
+/**
+  Resets the network interface.
+
+  @param[in]  This                  Protocol instance pointer.
+  @param[in]  ExtendedVerification  Ignored.
+
+  @retval EFI_SUCCESS           The network interface was reset.
+  @retval EFI_NOT_STARTED       The network interface has not been initialized.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicReset (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN BOOLEAN                      ExtendedVerification
+  )
+{
+  if (This->Mode->State != EfiSimpleNetworkInitialized) {
+    return EFI_NOT_STARTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Shuts down the network interface.
+
+  @param[in]  This      Protocol instance pointer.
+
+  @retval EFI_SUCCESS           The network interface was shut down.
+  @retval EFI_NOT_STARTED       The network interface has not been initialized.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicShutdown (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This
+  )
+{
+  if (This->Mode->State != EfiSimpleNetworkInitialized) {
+    return EFI_NOT_STARTED;
+  }
+
+  This->Mode->State = EfiSimpleNetworkStarted;
+  return EFI_SUCCESS;
+}
+
+/**
+  Manages the multicast receive filters of the network interface.
+
+  The wire carries only the frames of the two NICs, so the filters
+  are just recorded in the mode data for the consumers to read.
+
+  @param[in]  This              Protocol instance pointer.
+  @param[in]  Enable            A bit mask of receive filters to enable.
+  @param[in]  Disable           A bit mask of receive filters to disable.
+  @param[in]  ResetMCastFilter  Set to TRUE to reset the multicast filter list.
+  @param[in]  MCastFilterCnt    Number of multicast HW MAC addresses in MCastFilter.
+  @param[in]  MCastFilter       A pointer to a list of multicast HW MAC addresses.
+
+  @retval EFI_SUCCESS           The receive filters were updated.
+  @retval EFI_NOT_STARTED       The network interface has not been initialized.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters is invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicReceiveFilters (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN UINT32                       Enable,
+  IN UINT32                       Disable,
+  IN BOOLEAN                      ResetMCastFilter,
+  IN UINTN                        MCastFilterCnt     OPTIONAL,
+  IN EFI_MAC_ADDRESS              *MCastFilter       OPTIONAL
+  )
+{
+  EFI_SIMPLE_NETWORK_MODE  *Mode;
+
+  Mode = This->Mode;
+  if (Mode->State != EfiSimpleNetworkInitialized) {
+    return EFI_NOT_STARTED;
+  }
+
+  if (((Enable | Disable) & ~Mode->ReceiveFilterMask) != 0 ||
+      (!ResetMCastFilter && (MCastFilterCnt > Mode->MaxMCastFilterCount)) ||
+      (!ResetMCastFilter && (MCastFilterCnt != 0) && (MCastFilter == NULL))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Mode->ReceiveFilterSetting = (Mode->ReceiveFilterSetting | Enable) & ~Disable;
+
+  if (ResetMCastFilter) {
+    Mode->MCastFilterCount = 0;
+  } else if (MCastFilterCnt != 0) {
+    Mode->MCastFilterCount = (UINT32) MCastFilterCnt;
+    CopyMem (Mode->MCastFilter, MCastFilter, MCastFilterCnt * sizeof (EFI_MAC_ADDRESS));
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Modifies the current MAC address of the network interface, which
+  isn't supported.
+
+  @param[in]  This      Protocol instance pointer.
+  @param[in]  Reset     Flag used to reset the station address.
+  @param[in]  New       New station address.
+
+  @retval EFI_UNSUPPORTED       The MAC address of the NIC is fixed.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicStationAddress (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN BOOLEAN                      Reset,
+  IN EFI_MAC_ADDRESS              *New    OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Collects statistics on the network interface, which isn't supported.
+
+  @param[in]       This             Protocol instance pointer.
+  @param[in]       Reset            Set to TRUE to reset the statistics.
+  @param[in, out]  StatisticsSize   Size of the statistics table.
+  @param[out]      StatisticsTable  The statistics table.
+
+  @retval EFI_UNSUPPORTED       The statistics aren't collected.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicStatistics (
+  IN     EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN     BOOLEAN                      Reset,
+  IN OUT UINTN                        *StatisticsSize   OPTIONAL,
+  OUT    EFI_NETWORK_STATISTICS       *StatisticsTable  OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Converts a multicast IP address to a multicast HW MAC address.
+
+  @param[in]   This     Protocol instance pointer.
+  @param[in]   IPv6     Set to TRUE if the IP is an IPv6 address.
+  @param[in]   IP       The multicast IP address.
+  @param[out]  MAC      The multicast HW MAC address.
+
+  @retval EFI_SUCCESS           The multicast IP address was mapped.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters is invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicMCastIpToMac (
+  IN  EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN  BOOLEAN                      IPv6,
+  IN  EFI_IP_ADDRESS               *IP,
+  OUT EFI_MAC_ADDRESS              *MAC
+  )
+{
+  if ((IP == NULL) || (MAC == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (MAC, sizeof (EFI_MAC_ADDRESS));
+
+  if (IPv6) {
+    //
+    // RFC2464: 33-33 followed by the last 32 bits of the address
+    //
+    MAC->Addr[0] = 0x33;
+    MAC->Addr[1] = 0x33;
+    CopyMem (&MAC->Addr[2], &IP->v6.Addr[12], 4);
+  } else {
+    //
+    // RFC1112: 01-00-5E followed by the last 23 bits of the address
+    //
+    MAC->Addr[0] = 0x01;
+    MAC->Addr[1] = 0x00;
+    MAC->Addr[2] = 0x5E;
+    MAC->Addr[3] = (UINT8) (IP->v4.Addr[1] & 0x7F);
+    MAC->Addr[4] = IP->v4.Addr[2];
+    MAC->Addr[5] = IP->v4.Addr[3];
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Accesses the NVRAM of the network interface, which doesn't exist.
+
+  @param[in]       This         Protocol instance pointer.
+  @param[in]       ReadWrite    TRUE for read operations, FALSE for write operations.
+  @param[in]       Offset       Byte offset in the NVRAM.
+  @param[in]       BufferSize   The number of bytes to read or write.
+  @param[in, out]  Buffer       The data buffer.
+
+  @retval EFI_UNSUPPORTED       The NIC has no NVRAM.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicNvData (
+  IN     EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN     BOOLEAN                      ReadWrite,
+  IN     UINTN                        Offset,
+  IN     UINTN                        BufferSize,
+  IN OUT VOID                         *Buffer
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Reads the interrupt status and recycled transmit buffers.
+
+  @param[in]   This             Protocol instance pointer.
+  @param[out]  InterruptStatus  The interrupt status.
+  @param[out]  TxBuf            The recycled transmit buffer, or NULL.
+
+  @retval EFI_SUCCESS           The status was read.
+  @retval EFI_NOT_STARTED       The network interface has not been initialized.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicGetStatus (
+  IN  EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  OUT UINT32                       *InterruptStatus OPTIONAL,
+  OUT VOID                         **TxBuf          OPTIONAL
+  )
+{
+  LOOPBACK_NIC  *Nic;
+
+  Nic = LOOPBACK_NIC_FROM_SNP (This);
+
+  if (This->Mode->State != EfiSimpleNetworkInitialized) {
+    return EFI_NOT_STARTED;
+  }
+
+  if (InterruptStatus != NULL) {
+    *InterruptStatus = 0;
+    if (Nic->TxBufCount != 0) {
+      *InterruptStatus |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
+    }
+
+    if (Nic->RxCount != 0) {
+      *InterruptStatus |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
+    }
+  }
+
+  if (TxBuf != NULL) {
+    *TxBuf = NULL;
+    if (Nic->TxBufCount != 0) {
+      *TxBuf = Nic->TxBuf[--Nic->TxBufCount];
+    }
+  }
+
+  This->Mode->MediaPresent = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Places a packet on the wire, to be received by the peer NIC after the
+  latency of the wire, unless the wire drops it.
+
+  @param[in]  This        Protocol instance pointer.
+  @param[in]  HeaderSize  The size of the media header to fill in, or zero.
+  @param[in]  BufferSize  The size of the entire packet.
+  @param[in]  Buffer      The packet to transmit.
+  @param[in]  SrcAddr     The source HW MAC address.
+  @param[in]  DestAddr    The destination HW MAC address.
+  @param[in]  Protocol    The type of header to build.
+
+  @retval EFI_SUCCESS           The packet was placed on the wire, or dropped.
+  @retval EFI_NOT_STARTED       The network interface has not been initialized.
+  @retval EFI_NOT_READY         The transmit buffers must be recycled first.
+  @retval EFI_BUFFER_TOO_SMALL  BufferSize is too small or too large.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters is invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicTransmit (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN UINTN                        HeaderSize,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer,
+  IN EFI_MAC_ADDRESS              *SrcAddr   OPTIONAL,
+  IN EFI_MAC_ADDRESS              *DestAddr  OPTIONAL,
+  IN UINT16                       *Protocol  OPTIONAL
+  )
+{
+  LOOPBACK_NIC    *Nic;
+  LOOPBACK_NIC    *Peer;
+  LOOPBACK_FRAME  *Frame;
+  UINT8           *Header;
+  UINT16          Type;
+
+  Nic = LOOPBACK_NIC_FROM_SNP (This);
+
+  if (This->Mode->State != EfiSimpleNetworkInitialized) {
+    return EFI_NOT_STARTED;
+  }
+
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((BufferSize < LOOPBACK_MEDIA_HEADER_SIZE) || (BufferSize > LOOPBACK_FRAME_SIZE)) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  if (Nic->TxBufCount == LOOPBACK_TX_BUF_NUM) {
+    return EFI_NOT_READY;
+  }
+
+  Header = Buffer;
+  if (HeaderSize != 0) {
+    if ((HeaderSize != LOOPBACK_MEDIA_HEADER_SIZE) || (DestAddr == NULL) || (Protocol == NULL)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    CopyMem (Header, DestAddr, NET_ETHER_ADDR_LEN);
+    CopyMem (Header + NET_ETHER_ADDR_LEN, (SrcAddr != NULL) ? SrcAddr : &This->Mode->CurrentAddress, NET_ETHER_ADDR_LEN);
+    Header[2 * NET_ETHER_ADDR_LEN]     = (UINT8) (*Protocol >> 8);
+    Header[2 * NET_ETHER_ADDR_LEN + 1] = (UINT8) *Protocol;
+  }
+
+  Nic->TxBuf[Nic->TxBufCount++] = Buffer;
+  Nic->TxFrames++;
+
+  //
+  // Never drop ARP, so that the loss only hits the IP traffic.
+  //
+  Type = (UINT16) ((Header[2 * NET_ETHER_ADDR_LEN] << 8) | Header[2 * NET_ETHER_ADDR_LEN + 1]);
+  Peer = Nic->Peer;
+
+  if (((Type != 0x0806) && LoopbackWireDrop (Nic->Wire)) ||
+      (Peer->Mode.State != EfiSimpleNetworkInitialized) ||
+      (Peer->RxCount == LOOPBACK_QUEUE_SIZE)) {
+    Nic->DroppedFrames++;
+    return EFI_SUCCESS;
+  }
+
+  Frame              = &Peer->RxQueue[(Peer->RxHead + Peer->RxCount) % LOOPBACK_QUEUE_SIZE];
+  Frame->DeliverTime = LoopbackGetTime () + MultU64x32 (Nic->Wire->Latency, 1000);
+  Frame->Length      = BufferSize;
+  CopyMem (Frame->Data, Buffer, BufferSize);
+  Peer->RxCount++;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Receives a packet whose latency on the wire has elapsed.
+
+  @param[in]       This        Protocol instance pointer.
+  @param[out]      HeaderSize  The size of the media header.
+  @param[in, out]  BufferSize  The size of Buffer on input, of the packet on output.
+  @param[out]      Buffer      The buffer to receive the packet.
+  @param[out]      SrcAddr     The source HW MAC address.
+  @param[out]      DestAddr    The destination HW MAC address.
+  @param[out]      Protocol    The media header type.
+
+  @retval EFI_SUCCESS           A packet was received.
+  @retval EFI_NOT_STARTED       The network interface has not been initialized.
+  @retval EFI_NOT_READY         No packet has been received.
+  @retval EFI_BUFFER_TOO_SMALL  BufferSize is too small for the packet.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters is invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackNicReceive (
+  IN     EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  OUT    UINTN                        *HeaderSize OPTIONAL,
+  IN OUT UINTN                        *BufferSize,
+  OUT    VOID                         *Buffer,
+  OUT    EFI_MAC_ADDRESS              *SrcAddr    OPTIONAL,
+  OUT    EFI_MAC_ADDRESS              *DestAddr   OPTIONAL,
+  OUT    UINT16                       *Protocol   OPTIONAL
+  )
+{
+  LOOPBACK_NIC    *Nic;
+  LOOPBACK_FRAME  *Frame;
+
+  Nic = LOOPBACK_NIC_FROM_SNP (This);
+
+  if (This->Mode->State != EfiSimpleNetworkInitialized) {
+    return EFI_NOT_STARTED;
+  }
+
+  if ((BufferSize == NULL) || (Buffer == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Nic->ReceiveCalls++;
+
+  //
+  // The latency is the same for all the frames, so only
+  // the oldest one can be due.
+  //
+  Frame = &Nic->RxQueue[Nic->RxHead];
+  if ((Nic->RxCount == 0) || (Frame->DeliverTime > LoopbackGetTime ())) {
+    Nic->EmptyReceives++;
+    return EFI_NOT_READY;
+  }
+
+  if (*BufferSize < Frame->Length) {
+    *BufferSize = Frame->Length;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *BufferSize = Frame->Length;
+  CopyMem (Buffer, Frame->Data, Frame->Length);
+  Nic->RxBytes += Frame->Length;
+
+  if (HeaderSize != NULL) {
+    *HeaderSize = LOOPBACK_MEDIA_HEADER_SIZE;
+  }
+
+  if (DestAddr != NULL) {
+    ZeroMem (DestAddr, sizeof (EFI_MAC_ADDRESS));
+    CopyMem (DestAddr, Frame->Data, NET_ETHER_ADDR_LEN);
+  }
+
+  if (SrcAddr != NULL) {
+    ZeroMem (SrcAddr, sizeof (EFI_MAC_ADDRESS));
+    CopyMem (SrcAddr, Frame->Data + NET_ETHER_ADDR_LEN, NET_ETHER_ADDR_LEN);
+  }
+
+  if (Protocol != NULL) {
+    *Protocol = (UINT16) ((Frame->Data[2 * NET_ETHER_ADDR_LEN] << 8) | Frame->Data[2 * NET_ETHER_ADDR_LEN + 1]);
+  }
+
+  Nic->RxHead = (Nic->RxHead + 1) % LOOPBACK_QUEUE_SIZE;
+  Nic->RxCount--;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Signal the WaitForPacket event if a packet is due.
+
+  @param[in]  Event     The WaitForPacket event.
+  @param[in]  Context   The LOOPBACK_NIC.
+
+**/
+VOID
+EFIAPI
+LoopbackNicWaitForPacket (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  LOOPBACK_NIC  *Nic;
+
+  Nic = (LOOPBACK_NIC *) Context;
+  Nic->WaitChecks++;
+
+  if ((Nic->RxCount != 0) && (Nic->RxQueue[Nic->RxHead].DeliverTime <= LoopbackGetTime ())) {
+    gBS->SignalEvent (Event);
+  }
+}
+
+/**
+  Create a virtual NIC and install Simple Network Protocol and
+  Device Path Protocol on a new handle.
+
+  @param[in]   Index    Index of the NIC, used as the last byte of its MAC.
+  @param[in]   Wire     The wire the NIC is attached to.
+  @param[out]  Nic      The created NIC.
+
+  @retval EFI_SUCCESS            The NIC is created.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
+  @retval Others                 Failed to install the protocols.
+
+**/
+EFI_STATUS
+LoopbackNicCreate (
+  IN  UINT8           Index,
+  IN  LOOPBACK_WIRE   *Wire,
+  OUT LOOPBACK_NIC    **Nic
+  )
+{
+  LOOPBACK_NIC              *Instance;
+  EFI_SIMPLE_NETWORK_MODE   *Mode;
+  LOOPBACK_NIC_DEVICE_PATH  *DevicePath;
+  EFI_STATUS                Status;
+
+  Instance = AllocateZeroPool (sizeof (LOOPBACK_NIC));
+  if (Instance == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Instance->RxQueue = AllocatePool (LOOPBACK_QUEUE_SIZE * sizeof (LOOPBACK_FRAME));
+  if (Instance->RxQueue == NULL) {
+    FreePool (Instance);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Instance->Signature = LOOPBACK_NIC_SIGNATURE;
+  Instance->Wire      = Wire;
+
+  Mode                        = &Instance->Mode;
+  Mode->State                 = EfiSimpleNetworkStopped;
+  Mode->HwAddressSize         = NET_ETHER_ADDR_LEN;
+  Mode->MediaHeaderSize       = LOOPBACK_MEDIA_HEADER_SIZE;
+  Mode->MaxPacketSize         = LOOPBACK_MTU;
+  Mode->IfType                = NET_IFTYPE_ETHERNET;
+  Mode->MaxMCastFilterCount   = MAX_MCAST_FILTER_CNT;
+  Mode->MultipleTxSupported   = TRUE;
+  Mode->MediaPresentSupported = TRUE;
+  Mode->MediaPresent          = TRUE;
+  Mode->ReceiveFilterMask     = EFI_SIMPLE_NETWORK_RECEIVE_UNICAST |
+                                EFI_SIMPLE_NETWORK_RECEIVE_MULTICAST |
+                                EFI_SIMPLE_NETWORK_RECEIVE_BROADCAST |
+                                EFI_SIMPLE_NETWORK_RECEIVE_PROMISCUOUS |
+                                EFI_SIMPLE_NETWORK_RECEIVE_PROMISCUOUS_MULTICAST;
+
+  //
+  // Locally administered unicast address 02-00-00-00-00-<Index>
+  //
+  Mode->CurrentAddress.Addr[0] = 0x02;
+  Mode->CurrentAddress.Addr[5] = Index;
+  CopyMem (&Mode->PermanentAddress, &Mode->CurrentAddress, sizeof (EFI_MAC_ADDRESS));
+  SetMem (&Mode->BroadcastAddress, NET_ETHER_ADDR_LEN, 0xFF);
+
+  Instance->Snp.Revision       = EFI_SIMPLE_NETWORK_PROTOCOL_REVISION;
+  Instance->Snp.Start          = LoopbackNicStart;
+  Instance->Snp.Stop           = LoopbackNicStop;
+  Instance->Snp.Initialize     = LoopbackNicInitialize;
+  Instance->Snp.Reset          = LoopbackNicReset;
+  Instance->Snp.Shutdown       = LoopbackNicShutdown;
+  Instance->Snp.ReceiveFilters = LoopbackNicReceiveFilters;
+  Instance->Snp.StationAddress = LoopbackNicStationAddress;
+  Instance->Snp.Statistics     = LoopbackNicStatistics;
+  Instance->Snp.MCastIpToMac   = LoopbackNicMCastIpToMac;
+  Instance->Snp.NvData         = LoopbackNicNvData;
+  Instance->Snp.GetStatus      = LoopbackNicGetStatus;
+  Instance->Snp.Transmit       = LoopbackNicTransmit;
+  Instance->Snp.Receive        = LoopbackNicReceive;
+  Instance->Snp.Mode           = Mode;
+
+  DevicePath = &Instance->DevicePath;
+  DevicePath->Vendor.Header.Type    = HARDWARE_DEVICE_PATH;
+  DevicePath->Vendor.Header.SubType = HW_VENDOR_DP;
+  SetDevicePathNodeLength (&DevicePath->Vendor.Header, sizeof (VENDOR_DEVICE_PATH));
+  CopyGuid (&DevicePath->Vendor.Guid, &mLoopbackNicVendorGuid);
+
+  DevicePath->Mac.Header.Type       = MESSAGING_DEVICE_PATH;
+  DevicePath->Mac.Header.SubType    = MSG_MAC_ADDR_DP;
+  SetDevicePathNodeLength (&DevicePath->Mac.Header, sizeof (MAC_ADDR_DEVICE_PATH));
+  CopyMem (&DevicePath->Mac.MacAddress, &Mode->CurrentAddress, sizeof (EFI_MAC_ADDRESS));
+  DevicePath->Mac.IfType            = (UINT8) Mode->IfType;
+
+  SetDevicePathEndNode (&DevicePath->End);
+
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_WAIT,
+                  TPL_NOTIFY,
+                  LoopbackNicWaitForPacket,
+                  Instance,
+                  &Instance->Snp.WaitForPacket
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Instance->Handle,
+                  &gEfiSimpleNetworkProtocolGuid,
+                  &Instance->Snp,
+                  &gEfiDevicePathProtocolGuid,
+                  &Instance->DevicePath,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (Instance->Snp.WaitForPacket);
+    goto ON_ERROR;
+  }
+
+  *Nic = Instance;
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  FreePool (Instance->RxQueue);
+  FreePool (Instance);
+  return Status;
+}
+
+/**
+  Uninstall the protocols of the virtual NIC and free it.
+
+  @param[in]  Nic       The NIC to destroy.
+
+**/
+VOID
+LoopbackNicDestroy (
+  IN LOOPBACK_NIC     *Nic
+  )
+{
+  EFI_STATUS  Status;
+
+  gBS->DisconnectController (Nic->Handle, NULL, NULL);
+
+  Status = gBS->UninstallMultipleProtocolInterfaces (
+                  Nic->Handle,
+                  &gEfiSimpleNetworkProtocolGuid,
+                  &Nic->Snp,
+                  &gEfiDevicePathProtocolGuid,
+                  &Nic->DevicePath,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    //
+    // Some driver still holds the NIC, leak it rather than
+    // leaving a dangling protocol interface.
+    //
+    DEBUG ((DEBUG_ERROR, "LoopbackNicDestroy: failed to uninstall the NIC - %r\n", Status));
+    return;
+  }
+
+  gBS->CloseEvent (Nic->Snp.WaitForPacket);
+  FreePool (Nic->RxQueue);
+  FreePool (Nic);
+}
@@ -0,0 +1,1345 @@
+/** @file
+  A shell application to measure the goodput of TcpDxe on a lossy path.
+
+  Two virtual NICs are connected back to back by an in-memory wire which
+  drops and delays the frames as configured. The network stack binds to
+  both of them, so a TCP4 connection between the two stacks carries the
+  test data through MNP, ARP, IP4 and TCP exactly as a real download. The
+  received data is verified, and the goodput reported, so the loss recovery
+  and congestion control of TcpDxe can be compared on the same path.
+
+  The receive side reports how many bytes its NIC copied to the buffers of
+  MNP per byte delivered to the application, and how many bytes each receive
+  token carried. With -a another IP4 child accepting any protocol is opened
+  on the server, so the packets are shared by two IP4 children and take the
+  shared delivery path of IP4.
+
+  With -p the client and the server exchange small messages instead, and the
+  round trip time is reported. The TCP instances aren't polled then, so the
+  packets are received by the system poll of MNP only, and the number of
+  Receive() calls and WaitForPacket checks on the NICs tells the CPU time
+  the system poll costs, while the messages flow and while the network is
+  idle (PcdMnpBusyPollInterval).
+
+  With -c no connection is made: the Internet checksum of NetLib is checked
+  against a plain 16-bit sum at random alignments and lengths, and its
+  throughput reported for a range of buffer sizes.
+
+  A platform TimerLib is required to measure the time and delay the frames.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "TcpLoopbackTest.h"
+
+#define TCP_LOOPBACK_PORT          5001
+#define TCP_LOOPBACK_TOKEN_NUM     4
+
+//
+// The data at stream offset N is (N % TCP_LOOPBACK_PATTERN), and the
+// chunk is a multiple of it, so every chunk has the same content.
+//
+#define TCP_LOOPBACK_PATTERN       251
+#define TCP_LOOPBACK_CHUNK_SIZE    (TCP_LOOPBACK_PATTERN * 128)
+
+#define TCP_LOOPBACK_CONFIG_TIME   5     ///< Seconds to wait for IP configuration.
+#define TCP_LOOPBACK_CONNECT_TIME  30    ///< Seconds to wait for the connection.
+#define TCP_LOOPBACK_TRANSFER_TIME 600   ///< Seconds to wait for the transfer.
+#define TCP_LOOPBACK_ROUND_TIME    5     ///< Seconds to wait for a message.
+#define TCP_LOOPBACK_IDLE_TIME     1     ///< Seconds to measure the idle poll.
+
+#define TCP_LOOPBACK_MESSAGE_SIZE  64
+
+#define TCP_LOOPBACK_CHECKSUM_ROUNDS  20000
+#define TCP_LOOPBACK_CHECKSUM_BYTES   SIZE_256MB  ///< Bytes summed per size measured.
+
+SHELL_PARAM_ITEM  mTcpLoopbackParamList[] = {
+  { L"-s", TypeValue },
+  { L"-l", TypeValue },
+  { L"-d", TypeValue },
+  { L"-r", TypeValue },
+  { L"-n", TypeFlag  },
+  { L"-a", TypeFlag  },
+  { L"-p", TypeValue },
+  { L"-c", TypeFlag  },
+  { L"-?", TypeFlag  },
+  { NULL,  TypeMax   }
+};
+
+EFI_IPv4_ADDRESS  mTcpLoopbackAddress[2] = {
+  {{ 192, 168, 254, 1 }},
+  {{ 192, 168, 254, 2 }}
+};
+
+EFI_IPv4_ADDRESS  mTcpLoopbackSubnetMask = {{ 255, 255, 255, 0 }};
+
+///
+/// An IP4 child receiving all the packets of the server besides TCP.
+///
+typedef struct {
+  EFI_HANDLE                ChildHandle;
+  EFI_IP4_PROTOCOL          *Ip4;
+  EFI_IP4_COMPLETION_TOKEN  Token;
+  UINT64                    Packets;
+} TCP_LOOPBACK_SNIFFER;
+
+///
+/// The tokens of a TCP instance exchanging messages with its peer.
+///
+typedef struct {
+  EFI_TCP4_PROTOCOL         *Tcp;
+  EFI_TCP4_IO_TOKEN         TxToken;
+  EFI_TCP4_TRANSMIT_DATA    TxData;
+  volatile BOOLEAN          TxDone;
+  EFI_TCP4_IO_TOKEN         RxToken;
+  EFI_TCP4_RECEIVE_DATA     RxData;
+  volatile BOOLEAN          RxDone;
+  UINT8                     Message[TCP_LOOPBACK_MESSAGE_SIZE];
+} TCP_LOOPBACK_PEER;
+
+///
+/// The result of the message exchange.
+///
+typedef struct {
+  UINT64    Rounds;
+  UINT64    Total;          ///< In nanoseconds, as Min and Max.
+  UINT64    Min;
+  UINT64    Max;
+  UINT64    ReceiveCalls;   ///< Receive() calls on both NICs.
+  UINT64    WaitChecks;     ///< WaitForPacket checks on both NICs.
+} TCP_LOOPBACK_RTT;
+
+//
+// Number of receive tokens completed by the server.
+//
+UINT64  mTcpLoopbackRcvCount;
+
+//
+// Buffer sizes of the checksum measurement; 1460 is the MSS on Ethernet.
+//
+UINT32  mTcpLoopbackChecksumSize[] = { 64, 256, 1460, 4096, 16384, 65536 };
+
+/**
+  Set the BOOLEAN the context points to, on signal of a token event.
+
+  @param[in]  Event     The event signaled.
+  @param[in]  Context   Pointer to the BOOLEAN to set.
+
+**/
+VOID
+EFIAPI
+TcpLoopbackNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  *(BOOLEAN *) Context = TRUE;
+}
+
+/**
+  Poll the TCP instances until the flag is set or the time is out.
+
+  @param[in]  Tcp       The TCP instances to poll, NULL if none.
+  @param[in]  Peer      The other TCP instance to poll, NULL if none.
+  @param[in]  Done      The flag to wait for.
+  @param[in]  Timeout   The time to wait, in seconds.
+
+  @retval EFI_SUCCESS   The flag is set.
+  @retval EFI_TIMEOUT   The flag isn't set in time.
+
+**/
+EFI_STATUS
+TcpLoopbackWait (
+  IN EFI_TCP4_PROTOCOL  *Tcp   OPTIONAL,
+  IN EFI_TCP4_PROTOCOL  *Peer  OPTIONAL,
+  IN volatile BOOLEAN   *Done,
+  IN UINTN              Timeout
+  )
+{
+  UINT64  Deadline;
+
+  Deadline = LoopbackGetTime () + MultU64x32 (Timeout, 1000000000);
+
+  while (!*Done) {
+    if (Tcp != NULL) {
+      Tcp->Poll (Tcp);
+    }
+
+    if (Peer != NULL) {
+      Peer->Poll (Peer);
+    }
+
+    if (LoopbackGetTime () > Deadline) {
+      return EFI_TIMEOUT;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Assign a static address to the IP4 instance bound to the NIC.
+
+  @param[in]  Nic       The NIC to configure.
+  @param[in]  Address   The station address.
+
+  @retval EFI_SUCCESS   The address is assigned.
+  @retval Others        Failed to assign the address.
+
+**/
+EFI_STATUS
+TcpLoopbackConfigureIp (
+  IN LOOPBACK_NIC       *Nic,
+  IN EFI_IPv4_ADDRESS   *Address
+  )
+{
+  EFI_IP4_CONFIG2_PROTOCOL        *Ip4Config2;
+  EFI_IP4_CONFIG2_POLICY          Policy;
+  EFI_IP4_CONFIG2_MANUAL_ADDRESS  ManualAddress;
+  EFI_EVENT                       Event;
+  volatile BOOLEAN                Done;
+  EFI_STATUS                      Status;
+
+  Status = gBS->HandleProtocol (Nic->Handle, &gEfiIp4Config2ProtocolGuid, (VOID **) &Ip4Config2);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Policy = Ip4Config2PolicyStatic;
+  Status = Ip4Config2->SetData (Ip4Config2, Ip4Config2DataTypePolicy, sizeof (Policy), &Policy);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Done   = FALSE;
+  Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &Done, &Event);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Ip4Config2->RegisterDataNotify (Ip4Config2, Ip4Config2DataTypeManualAddress, Event);
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (Event);
+    return Status;
+  }
+
+  IP4_COPY_ADDRESS (&ManualAddress.Address, Address);
+  IP4_COPY_ADDRESS (&ManualAddress.SubnetMask, &mTcpLoopbackSubnetMask);
+
+  //
+  // The address is assigned after duplicate address detection,
+  // the notification tells the result.
+  //
+  Status = Ip4Config2->SetData (Ip4Config2, Ip4Config2DataTypeManualAddress, sizeof (ManualAddress), &ManualAddress);
+  if (Status == EFI_NOT_READY) {
+    Status = TcpLoopbackWait (NULL, NULL, &Done, TCP_LOOPBACK_CONFIG_TIME);
+  }
+
+  Ip4Config2->UnregisterDataNotify (Ip4Config2, Ip4Config2DataTypeManualAddress, Event);
+  gBS->CloseEvent (Event);
+
+  return Status;
+}
+
+/**
+  Recycle the packet received by the sniffer and receive the next one.
+
+  @param[in]  Event     The event signaled.
+  @param[in]  Context   Pointer to the TCP_LOOPBACK_SNIFFER.
+
+**/
+VOID
+EFIAPI
+TcpLoopbackSnifferNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  TCP_LOOPBACK_SNIFFER  *Sniffer;
+  EFI_IP4_RECEIVE_DATA  *RxData;
+
+  Sniffer = (TCP_LOOPBACK_SNIFFER *) Context;
+  RxData  = Sniffer->Token.Packet.RxData;
+
+  if (EFI_ERROR (Sniffer->Token.Status) && (Sniffer->Token.Status != EFI_ICMP_ERROR)) {
+    return;
+  }
+
+  if (RxData != NULL) {
+    Sniffer->Packets++;
+    gBS->SignalEvent (RxData->RecycleSignal);
+  }
+
+  Sniffer->Token.Packet.RxData = NULL;
+  Sniffer->Ip4->Receive (Sniffer->Ip4, &Sniffer->Token);
+}
+
+/**
+  Open an IP4 child accepting any protocol on the NIC, and keep receiving.
+
+  @param[in]   Nic          The NIC to create the child on.
+  @param[out]  Sniffer      The sniffer to start.
+
+  @retval EFI_SUCCESS   The sniffer is receiving.
+  @retval Others        Failed to create or configure the child.
+
+**/
+EFI_STATUS
+TcpLoopbackStartSniffer (
+  IN  LOOPBACK_NIC          *Nic,
+  OUT TCP_LOOPBACK_SNIFFER  *Sniffer
+  )
+{
+  EFI_IP4_CONFIG_DATA   ConfigData;
+  EFI_STATUS            Status;
+
+  ZeroMem (Sniffer, sizeof (TCP_LOOPBACK_SNIFFER));
+
+  Status = NetLibCreateServiceChild (
+             Nic->Handle,
+             gImageHandle,
+             &gEfiIp4ServiceBindingProtocolGuid,
+             &Sniffer->ChildHandle
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->HandleProtocol (Sniffer->ChildHandle, &gEfiIp4ProtocolGuid, (VOID **) &Sniffer->Ip4);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&ConfigData, sizeof (ConfigData));
+  ConfigData.AcceptAnyProtocol = TRUE;
+  ConfigData.UseDefaultAddress = TRUE;
+  ConfigData.TimeToLive        = 64;
+
+  Status = Sniffer->Ip4->Configure (Sniffer->Ip4, &ConfigData);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackSnifferNotify, Sniffer, &Sniffer->Token.Event);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return Sniffer->Ip4->Receive (Sniffer->Ip4, &Sniffer->Token);
+}
+
+/**
+  Stop the sniffer and destroy its IP4 child.
+
+  @param[in]  Nic           The NIC the child is created on.
+  @param[in]  Sniffer       The sniffer to stop.
+
+**/
+VOID
+TcpLoopbackStopSniffer (
+  IN LOOPBACK_NIC           *Nic,
+  IN TCP_LOOPBACK_SNIFFER   *Sniffer
+  )
+{
+  if (Sniffer->Ip4 != NULL) {
+    Sniffer->Ip4->Configure (Sniffer->Ip4, NULL);
+  }
+
+  if (Sniffer->ChildHandle != NULL) {
+    NetLibDestroyServiceChild (Nic->Handle, gImageHandle, &gEfiIp4ServiceBindingProtocolGuid, Sniffer->ChildHandle);
+  }
+
+  if (Sniffer->Token.Event != NULL) {
+    gBS->CloseEvent (Sniffer->Token.Event);
+  }
+}
+
+/**
+  Create a TCP4 child on the NIC and configure it.
+
+  @param[in]   Nic          The NIC to create the child on.
+  @param[in]   ActiveFlag   TRUE for the client, FALSE for the server.
+  @param[in]   Option       The control option of the TCP instance.
+  @param[out]  ChildHandle  The handle of the child.
+  @param[out]  Tcp          The TCP4 protocol of the child.
+
+  @retval EFI_SUCCESS   The child is created and configured.
+  @retval Others        Failed to create or configure the child.
+
+**/
+EFI_STATUS
+TcpLoopbackCreateTcp (
+  IN  LOOPBACK_NIC        *Nic,
+  IN  BOOLEAN             ActiveFlag,
+  IN  EFI_TCP4_OPTION     *Option,
+  OUT EFI_HANDLE          *ChildHandle,
+  OUT EFI_TCP4_PROTOCOL   **Tcp
+  )
+{
+  EFI_TCP4_CONFIG_DATA  ConfigData;
+  EFI_STATUS            Status;
+
+  *ChildHandle = NULL;
+  Status       = NetLibCreateServiceChild (
+                   Nic->Handle,
+                   gImageHandle,
+                   &gEfiTcp4ServiceBindingProtocolGuid,
+                   ChildHandle
+                   );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->HandleProtocol (*ChildHandle, &gEfiTcp4ProtocolGuid, (VOID **) Tcp);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&ConfigData, sizeof (ConfigData));
+  ConfigData.TimeToLive                    = 64;
+  ConfigData.AccessPoint.UseDefaultAddress = TRUE;
+  ConfigData.AccessPoint.ActiveFlag        = ActiveFlag;
+  ConfigData.ControlOption                 = Option;
+
+  if (ActiveFlag) {
+    IP4_COPY_ADDRESS (&ConfigData.AccessPoint.RemoteAddress, &mTcpLoopbackAddress[1]);
+    ConfigData.AccessPoint.RemotePort  = TCP_LOOPBACK_PORT;
+  } else {
+    ConfigData.AccessPoint.StationPort = TCP_LOOPBACK_PORT;
+  }
+
+  return (*Tcp)->Configure (*Tcp, &ConfigData);
+}
+
+/**
+  Transfer the data from the client to the server, and verify it.
+
+  @param[in]   Client       The TCP instance to send the data.
+  @param[in]   Server       The TCP instance to receive the data.
+  @param[in]   Size         The number of bytes to transfer.
+  @param[out]  Elapsed      The transfer time in nanoseconds.
+
+  @retval EFI_SUCCESS           The data is transferred.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory.
+  @retval EFI_CRC_ERROR         The received data is corrupted.
+  @retval Others                The transfer failed.
+
+**/
+EFI_STATUS
+TcpLoopbackTransfer (
+  IN  EFI_TCP4_PROTOCOL   *Client,
+  IN  EFI_TCP4_PROTOCOL   *Server,
+  IN  UINT64              Size,
+  OUT UINT64              *Elapsed
+  )
+{
+  EFI_TCP4_IO_TOKEN       TxToken[TCP_LOOPBACK_TOKEN_NUM];
+  EFI_TCP4_TRANSMIT_DATA  TxData[TCP_LOOPBACK_TOKEN_NUM];
+  volatile BOOLEAN        TxDone[TCP_LOOPBACK_TOKEN_NUM];
+  EFI_TCP4_IO_TOKEN       RxToken[TCP_LOOPBACK_TOKEN_NUM];
+  EFI_TCP4_RECEIVE_DATA   RxData[TCP_LOOPBACK_TOKEN_NUM];
+  volatile BOOLEAN        RxDone[TCP_LOOPBACK_TOKEN_NUM];
+  UINT8                   *TxBuffer;
+  UINT8                   *RxBuffer;
+  UINT8                   *Data;
+  UINT64                  Sent;
+  UINT64                  Received;
+  UINT64                  Start;
+  UINT64                  Deadline;
+  UINT32                  Length;
+  UINT32                  Offset;
+  UINTN                   Pattern;
+  UINTN                   Index;
+  EFI_STATUS              Status;
+
+  ZeroMem (TxToken, sizeof (TxToken));
+  ZeroMem (RxToken, sizeof (RxToken));
+
+  TxBuffer = AllocatePool (TCP_LOOPBACK_CHUNK_SIZE);
+  RxBuffer = AllocatePool (TCP_LOOPBACK_TOKEN_NUM * TCP_LOOPBACK_CHUNK_SIZE);
+  if ((TxBuffer == NULL) || (RxBuffer == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  for (Index = 0; Index < TCP_LOOPBACK_CHUNK_SIZE; Index++) {
+    TxBuffer[Index] = (UINT8) (Index % TCP_LOOPBACK_PATTERN);
+  }
+
+  for (Index = 0; Index < TCP_LOOPBACK_TOKEN_NUM; Index++) {
+    TxDone[Index] = TRUE;
+    RxDone[Index] = FALSE;
+    Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &TxDone[Index], &TxToken[Index].CompletionToken.Event);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &RxDone[Index], &RxToken[Index].CompletionToken.Event);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    TxToken[Index].Packet.TxData = &TxData[Index];
+    RxToken[Index].Packet.RxData = &RxData[Index];
+  }
+
+  Sent     = 0;
+  Received = 0;
+  Pattern  = 0;
+
+  mTcpLoopbackRcvCount = 0;
+  Start    = LoopbackGetTime ();
+  Deadline = Start + MultU64x32 (TCP_LOOPBACK_TRANSFER_TIME, 1000000000);
+
+  //
+  // Keep all the receive tokens queued on the server.
+  //
+  for (Index = 0; Index < TCP_LOOPBACK_TOKEN_NUM; Index++) {
+    RxData[Index].UrgentFlag                    = FALSE;
+    RxData[Index].DataLength                    = TCP_LOOPBACK_CHUNK_SIZE;
+    RxData[Index].FragmentCount                 = 1;
+    RxData[Index].FragmentTable[0].FragmentLength = TCP_LOOPBACK_CHUNK_SIZE;
+    RxData[Index].FragmentTable[0].FragmentBuffer = RxBuffer + Index * TCP_LOOPBACK_CHUNK_SIZE;
+
+    Status = Server->Receive (Server, &RxToken[Index]);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+  }
+
+  while (Received < Size) {
+    for (Index = 0; Index < TCP_LOOPBACK_TOKEN_NUM; Index++) {
+      if (TxDone[Index] && (Sent < Size)) {
+        if (EFI_ERROR (TxToken[Index].CompletionToken.Status)) {
+          Status = TxToken[Index].CompletionToken.Status;
+          goto ON_EXIT;
+        }
+
+        Length = (UINT32) MIN (Size - Sent, TCP_LOOPBACK_CHUNK_SIZE);
+
+        TxData[Index].Push                          = FALSE;
+        TxData[Index].Urgent                        = FALSE;
+        TxData[Index].DataLength                    = Length;
+        TxData[Index].FragmentCount                 = 1;
+        TxData[Index].FragmentTable[0].FragmentLength = Length;
+        TxData[Index].FragmentTable[0].FragmentBuffer = TxBuffer;
+
+        TxDone[Index] = FALSE;
+        Status        = Client->Transmit (Client, &TxToken[Index]);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+
+        Sent += Length;
+      }
+
+      if (RxDone[Index]) {
+        Status = RxToken[Index].CompletionToken.Status;
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+
+        Data   = RxData[Index].FragmentTable[0].FragmentBuffer;
+        Length = RxData[Index].DataLength;
+        for (Offset = 0; Offset < Length; Offset++) {
+          if (Data[Offset] != Pattern) {
+            Print (L"Data corrupted at offset %Ld\n", Received + Offset);
+            Status = EFI_CRC_ERROR;
+            goto ON_EXIT;
+          }
+
+          Pattern = (Pattern + 1 == TCP_LOOPBACK_PATTERN) ? 0 : Pattern + 1;
+        }
+
+        Received += Length;
+        mTcpLoopbackRcvCount++;
+
+        RxDone[Index]                                 = FALSE;
+        RxData[Index].DataLength                      = TCP_LOOPBACK_CHUNK_SIZE;
+        RxData[Index].FragmentTable[0].FragmentLength = TCP_LOOPBACK_CHUNK_SIZE;
+        RxData[Index].FragmentTable[0].FragmentBuffer = RxBuffer + Index * TCP_LOOPBACK_CHUNK_SIZE;
+
+        Status = Server->Receive (Server, &RxToken[Index]);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+      }
+    }
+
+    Client->Poll (Client);
+    Server->Poll (Server);
+
+    if (LoopbackGetTime () > Deadline) {
+      Status = EFI_TIMEOUT;
+      goto ON_EXIT;
+    }
+  }
+
+  *Elapsed = LoopbackGetTime () - Start;
+  Status   = EFI_SUCCESS;
+
+ON_EXIT:
+  //
+  // Abort the connection so that the pending tokens are flushed
+  // before their events are closed.
+  //
+  Client->Configure (Client, NULL);
+  Server->Configure (Server, NULL);
+
+  for (Index = 0; Index < TCP_LOOPBACK_TOKEN_NUM; Index++) {
+    if (TxToken[Index].CompletionToken.Event != NULL) {
+      gBS->CloseEvent (TxToken[Index].CompletionToken.Event);
+    }
+
+    if (RxToken[Index].CompletionToken.Event != NULL) {
+      gBS->CloseEvent (RxToken[Index].CompletionToken.Event);
+    }
+  }
+
+  if (TxBuffer != NULL) {
+    FreePool (TxBuffer);
+  }
+
+  if (RxBuffer != NULL) {
+    FreePool (RxBuffer);
+  }
+
+  return Status;
+}
+
+/**
+  Send the message of a TCP instance to its peer, and wait until the peer
+  receives all of it. The instances aren't polled.
+
+  @param[in, out]  From         The sending instance.
+  @param[in, out]  To           The receiving instance.
+
+  @retval EFI_SUCCESS   The message is received.
+  @retval EFI_TIMEOUT   The message isn't received in time.
+  @retval Others        The transmit or receive failed.
+
+**/
+EFI_STATUS
+TcpLoopbackSendMessage (
+  IN OUT TCP_LOOPBACK_PEER  *From,
+  IN OUT TCP_LOOPBACK_PEER  *To
+  )
+{
+  UINT32      Received;
+  EFI_STATUS  Status;
+
+  From->TxData.Push                          = TRUE;
+  From->TxData.Urgent                        = FALSE;
+  From->TxData.DataLength                    = TCP_LOOPBACK_MESSAGE_SIZE;
+  From->TxData.FragmentCount                 = 1;
+  From->TxData.FragmentTable[0].FragmentLength = TCP_LOOPBACK_MESSAGE_SIZE;
+  From->TxData.FragmentTable[0].FragmentBuffer = From->Message;
+
+  From->TxDone = FALSE;
+  Status       = From->Tcp->Transmit (From->Tcp, &From->TxToken);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Received = 0;
+  while (Received < TCP_LOOPBACK_MESSAGE_SIZE) {
+    To->RxData.UrgentFlag                    = FALSE;
+    To->RxData.DataLength                    = TCP_LOOPBACK_MESSAGE_SIZE - Received;
+    To->RxData.FragmentCount                 = 1;
+    To->RxData.FragmentTable[0].FragmentLength = TCP_LOOPBACK_MESSAGE_SIZE - Received;
+    To->RxData.FragmentTable[0].FragmentBuffer = To->Message + Received;
+
+    To->RxDone = FALSE;
+    Status     = To->Tcp->Receive (To->Tcp, &To->RxToken);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = TcpLoopbackWait (NULL, NULL, &To->RxDone, TCP_LOOPBACK_ROUND_TIME);
+    if (!EFI_ERROR (Status)) {
+      Status = To->RxToken.CompletionToken.Status;
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Received += To->RxData.DataLength;
+  }
+
+  Status = TcpLoopbackWait (NULL, NULL, &From->TxDone, TCP_LOOPBACK_ROUND_TIME);
+  if (!EFI_ERROR (Status)) {
+    Status = From->TxToken.CompletionToken.Status;
+  }
+
+  return Status;
+}
+
+/**
+  Send messages from the client to the server and back, and measure the
+  round trip time.
+
+  @param[in]   Nic          The NICs of the client and the server.
+  @param[in]   Client       The TCP instance to send the messages.
+  @param[in]   Server       The TCP instance to echo the messages.
+  @param[in]   Rounds       The number of round trips.
+  @param[out]  Rtt          The round trip time and the poll count.
+
+  @retval EFI_SUCCESS           The messages are echoed.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory.
+  @retval EFI_CRC_ERROR         The echoed message is corrupted.
+  @retval Others                The exchange failed.
+
+**/
+EFI_STATUS
+TcpLoopbackPingPong (
+  IN  LOOPBACK_NIC        **Nic,
+  IN  EFI_TCP4_PROTOCOL   *Client,
+  IN  EFI_TCP4_PROTOCOL   *Server,
+  IN  UINT64              Rounds,
+  OUT TCP_LOOPBACK_RTT    *Rtt
+  )
+{
+  TCP_LOOPBACK_PEER   *Peer;
+  UINT64              Start;
+  UINT64              Elapsed;
+  UINT64              Round;
+  UINTN               Index;
+  EFI_STATUS          Status;
+
+  ZeroMem (Rtt, sizeof (TCP_LOOPBACK_RTT));
+  Rtt->Min = MAX_UINT64;
+
+  Peer = AllocateZeroPool (2 * sizeof (TCP_LOOPBACK_PEER));
+  if (Peer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  Peer[0].Tcp = Client;
+  Peer[1].Tcp = Server;
+
+  for (Index = 0; Index < 2; Index++) {
+    Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &Peer[Index].TxDone, &Peer[Index].TxToken.CompletionToken.Event);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &Peer[Index].RxDone, &Peer[Index].RxToken.CompletionToken.Event);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    Peer[Index].TxToken.Packet.TxData = &Peer[Index].TxData;
+    Peer[Index].RxToken.Packet.RxData = &Peer[Index].RxData;
+  }
+
+  Rtt->ReceiveCalls = Nic[0]->ReceiveCalls + Nic[1]->ReceiveCalls;
+  Rtt->WaitChecks   = Nic[0]->WaitChecks + Nic[1]->WaitChecks;
+
+  for (Round = 0; Round < Rounds; Round++) {
+    SetMem (Peer[0].Message, TCP_LOOPBACK_MESSAGE_SIZE, (UINT8) Round);
+
+    Start  = LoopbackGetTime ();
+    Status = TcpLoopbackSendMessage (&Peer[0], &Peer[1]);
+    if (!EFI_ERROR (Status)) {
+      //
+      // Echo the message received by the server.
+      //
+      Status = TcpLoopbackSendMessage (&Peer[1], &Peer[0]);
+    }
+
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    Elapsed = LoopbackGetTime () - Start;
+
+    for (Index = 0; Index < TCP_LOOPBACK_MESSAGE_SIZE; Index++) {
+      if (Peer[0].Message[Index] != (UINT8) Round) {
+        Print (L"Message %Ld corrupted\n", Round);
+        Status = EFI_CRC_ERROR;
+        goto ON_EXIT;
+      }
+    }
+
+    Rtt->Rounds++;
+    Rtt->Total += Elapsed;
+    Rtt->Min    = MIN (Rtt->Min, Elapsed);
+    Rtt->Max    = MAX (Rtt->Max, Elapsed);
+  }
+
+  Rtt->ReceiveCalls = Nic[0]->ReceiveCalls + Nic[1]->ReceiveCalls - Rtt->ReceiveCalls;
+  Rtt->WaitChecks   = Nic[0]->WaitChecks + Nic[1]->WaitChecks - Rtt->WaitChecks;
+  Status            = EFI_SUCCESS;
+
+ON_EXIT:
+  //
+  // Abort the connection so that the pending tokens are flushed
+  // before their events are closed.
+  //
+  Client->Configure (Client, NULL);
+  Server->Configure (Server, NULL);
+
+  if (Peer != NULL) {
+    for (Index = 0; Index < 2; Index++) {
+      if (Peer[Index].TxToken.CompletionToken.Event != NULL) {
+        gBS->CloseEvent (Peer[Index].TxToken.CompletionToken.Event);
+      }
+
+      if (Peer[Index].RxToken.CompletionToken.Event != NULL) {
+        gBS->CloseEvent (Peer[Index].RxToken.CompletionToken.Event);
+      }
+    }
+
+    FreePool (Peer);
+  }
+
+  return Status;
+}
+
+/**
+  Connect the client to the server, and transfer the data.
+
+  @param[in]   Nic          The NICs of the client and the server.
+  @param[in]   Option       The control option of the TCP instances.
+  @param[in]   Size         The number of bytes to transfer.
+  @param[in]   Rounds       The number of messages to exchange instead, if not 0.
+  @param[out]  Elapsed      The transfer time in nanoseconds.
+  @param[out]  Rtt          The result of the message exchange.
+
+  @retval EFI_SUCCESS   The data is transferred.
+  @retval Others        The test failed.
+
+**/
+EFI_STATUS
+TcpLoopbackRun (
+  IN  LOOPBACK_NIC      **Nic,
+  IN  EFI_TCP4_OPTION   *Option,
+  IN  UINT64            Size,
+  IN  UINT64            Rounds,
+  OUT UINT64            *Elapsed,
+  OUT TCP_LOOPBACK_RTT  *Rtt
+  )
+{
+  EFI_HANDLE                ClientHandle;
+  EFI_HANDLE                ListenHandle;
+  EFI_TCP4_PROTOCOL         *Client;
+  EFI_TCP4_PROTOCOL         *Listen;
+  EFI_TCP4_PROTOCOL         *Server;
+  EFI_TCP4_CONNECTION_TOKEN ConnToken;
+  EFI_TCP4_LISTEN_TOKEN     ListenToken;
+  volatile BOOLEAN          Connected;
+  volatile BOOLEAN          Accepted;
+  EFI_STATUS                Status;
+
+  ClientHandle = NULL;
+  ListenHandle = NULL;
+  ZeroMem (&ConnToken, sizeof (ConnToken));
+  ZeroMem (&ListenToken, sizeof (ListenToken));
+
+  Status = TcpLoopbackCreateTcp (Nic[1], FALSE, Option, &ListenHandle, &Listen);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = TcpLoopbackCreateTcp (Nic[0], TRUE, Option, &ClientHandle, &Client);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Connected = FALSE;
+  Accepted  = FALSE;
+  Status    = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &Accepted, &ListenToken.CompletionToken.Event);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = gBS->CreateEvent (EVT_NOTIFY_SIGNAL, TPL_CALLBACK, TcpLoopbackNotify, (VOID *) &Connected, &ConnToken.CompletionToken.Event);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = Listen->Accept (Listen, &ListenToken);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = Client->Connect (Client, &ConnToken);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = TcpLoopbackWait (Client, Listen, &Connected, TCP_LOOPBACK_CONNECT_TIME);
+  if (!EFI_ERROR (Status)) {
+    Status = TcpLoopbackWait (Client, Listen, &Accepted, TCP_LOOPBACK_CONNECT_TIME);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = EFI_ERROR (ConnToken.CompletionToken.Status) ? ConnToken.CompletionToken.Status : ListenToken.CompletionToken.Status;
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"Failed to connect - %r\n", Status);
+    goto ON_EXIT;
+  }
+
+  Status = gBS->HandleProtocol (ListenToken.NewChildHandle, &gEfiTcp4ProtocolGuid, (VOID **) &Server);
+  if (!EFI_ERROR (Status)) {
+    if (Rounds != 0) {
+      Status = TcpLoopbackPingPong (Nic, Client, Server, Rounds, Rtt);
+    } else {
+      Status = TcpLoopbackTransfer (Client, Server, Size, Elapsed);
+    }
+  }
+
+ON_EXIT:
+  if (ListenToken.NewChildHandle != NULL) {
+    NetLibDestroyServiceChild (Nic[1]->Handle, gImageHandle, &gEfiTcp4ServiceBindingProtocolGuid, ListenToken.NewChildHandle);
+  }
+
+  if (ListenHandle != NULL) {
+    NetLibDestroyServiceChild (Nic[1]->Handle, gImageHandle, &gEfiTcp4ServiceBindingProtocolGuid, ListenHandle);
+  }
+
+  if (ClientHandle != NULL) {
+    NetLibDestroyServiceChild (Nic[0]->Handle, gImageHandle, &gEfiTcp4ServiceBindingProtocolGuid, ClientHandle);
+  }
+
+  if (ListenToken.CompletionToken.Event != NULL) {
+    gBS->CloseEvent (ListenToken.CompletionToken.Event);
+  }
+
+  if (ConnToken.CompletionToken.Event != NULL) {
+    gBS->CloseEvent (ConnToken.CompletionToken.Event);
+  }
+
+  return Status;
+}
+
+/**
+  Get the numeric value of a command line option.
+
+  @param[in]  Package   The parsed command line.
+  @param[in]  Name      The name of the option.
+  @param[in]  Default   The value if the option is absent.
+
+  @return The value of the option.
+
+**/
+UINT64
+TcpLoopbackGetValue (
+  IN LIST_ENTRY     *Package,
+  IN CHAR16         *Name,
+  IN UINT64         Default
+  )
+{
+  CONST CHAR16  *Value;
+
+  Value = ShellCommandLineGetValue (Package, Name);
+  if (Value == NULL) {
+    return Default;
+  }
+
+  return StrDecimalToUint64 (Value);
+}
+
+/**
+  Report the round trip time, and the polls on the NICs while the messages
+  flow and while the network is idle.
+
+  @param[in]  Nic       The NICs of the client and the server.
+  @param[in]  Rtt       The result of the message exchange.
+
+**/
+VOID
+TcpLoopbackReportRtt (
+  IN LOOPBACK_NIC       **Nic,
+  IN TCP_LOOPBACK_RTT   *Rtt
+  )
+{
+  UINT64  Average;
+  UINT64  ReceiveCalls;
+  UINT64  WaitChecks;
+
+  Average = DivU64x64Remainder (Rtt->Total, MAX (Rtt->Rounds, 1), NULL);
+  Print (
+    L"%Ld round trips of %d bytes, RTT avg %Ld us, min %Ld us, max %Ld us\n",
+    Rtt->Rounds,
+    TCP_LOOPBACK_MESSAGE_SIZE,
+    DivU64x32 (Average, 1000),
+    DivU64x32 (Rtt->Min, 1000),
+    DivU64x32 (Rtt->Max, 1000)
+    );
+  Print (
+    L"Per round trip: Receive() %Ld calls, WaitForPacket %Ld checks\n",
+    DivU64x64Remainder (Rtt->ReceiveCalls, MAX (Rtt->Rounds, 1), NULL),
+    DivU64x64Remainder (Rtt->WaitChecks, MAX (Rtt->Rounds, 1), NULL)
+    );
+
+  //
+  // Let the system poll of MNP back off, then count the polls on the
+  // idle network.
+  //
+  gBS->Stall (TCP_LOOPBACK_IDLE_TIME * 1000000);
+
+  ReceiveCalls = Nic[0]->ReceiveCalls + Nic[1]->ReceiveCalls;
+  WaitChecks   = Nic[0]->WaitChecks + Nic[1]->WaitChecks;
+
+  gBS->Stall (TCP_LOOPBACK_IDLE_TIME * 1000000);
+
+  Print (
+    L"Idle per second: Receive() %Ld calls, WaitForPacket %Ld checks\n",
+    DivU64x32 (Nic[0]->ReceiveCalls + Nic[1]->ReceiveCalls - ReceiveCalls, TCP_LOOPBACK_IDLE_TIME),
+    DivU64x32 (Nic[0]->WaitChecks + Nic[1]->WaitChecks - WaitChecks, TCP_LOOPBACK_IDLE_TIME)
+    );
+}
+
+/**
+  Compute the Internet checksum of a bulk of data 16 bits at a time, as the
+  reference for NetblockChecksum().
+
+  @param[in]  Bulk      Pointer to the data.
+  @param[in]  Len       Length of the data, in bytes.
+
+  @return The checksum, not complemented.
+
+**/
+UINT16
+TcpLoopbackReferenceChecksum (
+  IN UINT8          *Bulk,
+  IN UINT32         Len
+  )
+{
+  UINT32  Sum;
+  UINT32  Index;
+
+  Sum = 0;
+  for (Index = 0; Index + 1 < Len; Index += 2) {
+    Sum += ReadUnaligned16 ((UINT16 *) (Bulk + Index));
+  }
+
+  if (Index < Len) {
+    Sum += Bulk[Index];
+  }
+
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xffff) + (Sum >> 16);
+  }
+
+  return (UINT16) Sum;
+}
+
+/**
+  Check NetblockChecksum() and NetbufChecksum() against the reference at
+  random alignments and lengths, then measure the throughput of both.
+
+  @retval EFI_SUCCESS            The checksums match.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
+  @retval EFI_ABORTED            A checksum doesn't match.
+
+**/
+EFI_STATUS
+TcpLoopbackChecksumTest (
+  VOID
+  )
+{
+  UINT8         *Buffer;
+  UINT32        Seed;
+  UINT32        Round;
+  UINT32        Offset;
+  UINT32        Len;
+  UINT32        Split[2];
+  NET_FRAGMENT  Fragment[3];
+  NET_BUF       *Nbuf;
+  UINT16        Expected;
+  UINT16        Sum;
+  UINTN         Index;
+  UINT32        Size;
+  UINT64        Count;
+  UINT64        Loop;
+  UINT64        Start;
+  UINT64        Elapsed[2];
+  UINT64        Mbps[2];
+
+  Buffer = AllocatePool (SIZE_64KB + 8);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Seed = 1;
+  for (Index = 0; Index < SIZE_64KB + 8; Index++) {
+    Seed          = Seed * 1103515245 + 12345;
+    Buffer[Index] = (UINT8) (Seed >> 16);
+  }
+
+  //
+  // Mostly short buffers as the headers, every 16th up to 64 KiB. The buffers
+  // are also split in three blocks of a NET_BUF, which may start at odd
+  // offsets of the data.
+  //
+  for (Round = 0; Round < TCP_LOOPBACK_CHECKSUM_ROUNDS; Round++) {
+    Seed   = Seed * 1103515245 + 12345;
+    Offset = (Seed >> 16) % 8;
+    Seed   = Seed * 1103515245 + 12345;
+    Len    = (Seed >> 8) % (((Round % 16) == 0) ? (SIZE_64KB + 1) : 2048);
+
+    Expected = TcpLoopbackReferenceChecksum (Buffer + Offset, Len);
+    Sum      = NetblockChecksum (Buffer + Offset, Len);
+    if (Sum != Expected) {
+      Print (L"NetblockChecksum at offset %d of %d bytes: 0x%04x, expected 0x%04x\n", Offset, Len, Sum, Expected);
+      FreePool (Buffer);
+      return EFI_ABORTED;
+    }
+
+    Seed     = Seed * 1103515245 + 12345;
+    Split[0] = (Seed >> 8) % (Len + 1);
+    Seed     = Seed * 1103515245 + 12345;
+    Split[1] = Split[0] + (Seed >> 8) % (Len - Split[0] + 1);
+
+    Fragment[0].Bulk = Buffer + Offset;
+    Fragment[0].Len  = Split[0];
+    Fragment[1].Bulk = Buffer + Offset + Split[0];
+    Fragment[1].Len  = Split[1] - Split[0];
+    Fragment[2].Bulk = Buffer + Offset + Split[1];
+    Fragment[2].Len  = Len - Split[1];
+
+    Nbuf = NetbufFromExt (Fragment, 3, 0, 0, NULL, NULL);
+    if (Nbuf == NULL) {
+      FreePool (Buffer);
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Sum = NetbufChecksum (Nbuf);
+    NetbufFree (Nbuf);
+    if (Sum != Expected) {
+      Print (
+        L"NetbufChecksum at offset %d of %d+%d+%d bytes: 0x%04x, expected 0x%04x\n",
+        Offset,
+        Fragment[0].Len,
+        Fragment[1].Len,
+        Fragment[2].Len,
+        Sum,
+        Expected
+        );
+      FreePool (Buffer);
+      return EFI_ABORTED;
+    }
+  }
+
+  Print (L"%d random buffers checked\n", TCP_LOOPBACK_CHECKSUM_ROUNDS);
+
+  //
+  // The sums are accumulated so that the calls can't be optimized out.
+  //
+  Sum = 0;
+  for (Index = 0; Index < ARRAY_SIZE (mTcpLoopbackChecksumSize); Index++) {
+    Size  = mTcpLoopbackChecksumSize[Index];
+    Count = DivU64x32 (TCP_LOOPBACK_CHECKSUM_BYTES, Size);
+
+    Start = LoopbackGetTime ();
+    for (Loop = 0; Loop < Count; Loop++) {
+      Sum = (UINT16) (Sum + NetblockChecksum (Buffer, Size));
+    }
+    Elapsed[0] = LoopbackGetTime () - Start;
+
+    Start = LoopbackGetTime ();
+    for (Loop = 0; Loop < Count; Loop++) {
+      Sum = (UINT16) (Sum + TcpLoopbackReferenceChecksum (Buffer, Size));
+    }
+    Elapsed[1] = LoopbackGetTime () - Start;
+
+    Mbps[0] = DivU64x64Remainder (MultU64x32 (MultU64x32 (Count, Size), 8000), MAX (Elapsed[0], 1), NULL);
+    Mbps[1] = DivU64x64Remainder (MultU64x32 (MultU64x32 (Count, Size), 8000), MAX (Elapsed[1], 1), NULL);
+    Print (
+      L"%5d bytes: NetLib %Ld.%03Ld Gbit/s, 16-bit reference %Ld.%03Ld Gbit/s\n",
+      Size,
+      DivU64x32 (Mbps[0], 1000),
+      ModU64x32 (Mbps[0], 1000),
+      DivU64x32 (Mbps[1], 1000),
+      ModU64x32 (Mbps[1], 1000)
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "TcpLoopbackChecksumTest: sum 0x%04x\n", Sum));
+
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  The entry point of the application.
+
+  @param[in]  ImageHandle   The image handle of the application.
+  @param[in]  SystemTable   The system table.
+
+  @retval EFI_SUCCESS       The test passed.
+  @retval Others            The test failed.
+
+**/
+EFI_STATUS
+EFIAPI
+TcpLoopbackTestMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  LIST_ENTRY            *Package;
+  CHAR16                *ProblemParam;
+  LOOPBACK_WIRE         Wire;
+  LOOPBACK_NIC          *Nic[2];
+  EFI_TCP4_OPTION       Option;
+  BOOLEAN               Shared;
+  TCP_LOOPBACK_SNIFFER  Sniffer;
+  UINT64                Size;
+  UINT64                Rounds;
+  TCP_LOOPBACK_RTT      Rtt;
+  UINT64                Elapsed;
+  UINT64                Kbps;
+  UINT64                Ratio;
+  UINTN                 Index;
+  EFI_STATUS            Status;
+
+  Status = ShellCommandLineParse (mTcpLoopbackParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    Print (L"Invalid parameter %s\n", ProblemParam);
+    return Status;
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-?")) {
+    Print (L"TcpLoopbackTest [-s MiB] [-l Loss] [-d Delay] [-r Seed] [-n] [-a] [-p Rounds] [-c]\n");
+    Print (L"  -s  Size of the data to transfer in MiB, 16 by default.\n");
+    Print (L"  -l  Frames dropped on the wire per 10000, 0 by default.\n");
+    Print (L"  -d  One-way delay of the wire in milliseconds, 0 by default.\n");
+    Print (L"  -r  Seed of the random loss, 1 by default.\n");
+    Print (L"  -n  Disable TCP selective acknowledgment.\n");
+    Print (L"  -a  Share the received packets with another IP4 child.\n");
+    Print (L"  -p  Measure the round trip time of small messages instead.\n");
+    Print (L"  -c  Check and measure the Internet checksum of NetLib instead.\n");
+    ShellCommandLineFreeVarList (Package);
+    return EFI_SUCCESS;
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-c")) {
+    ShellCommandLineFreeVarList (Package);
+    return TcpLoopbackChecksumTest ();
+  }
+
+  Size          = MultU64x32 (TcpLoopbackGetValue (Package, L"-s", 16), SIZE_1MB);
+  Wire.LossRate = (UINT32) MIN (TcpLoopbackGetValue (Package, L"-l", 0), 10000);
+  Wire.Latency  = (UINT32) MIN (TcpLoopbackGetValue (Package, L"-d", 0), 10000);
+  Wire.Seed     = (UINT32) TcpLoopbackGetValue (Package, L"-r", 1);
+  Rounds        = TcpLoopbackGetValue (Package, L"-p", 0);
+
+  ZeroMem (&Option, sizeof (Option));
+  Option.ReceiveBufferSize   = SIZE_256KB;
+  Option.SendBufferSize      = SIZE_256KB;
+  Option.MaxSynBackLog       = 1;
+  Option.DataRetries         = 12;
+  Option.EnableNagle         = TRUE;
+  Option.EnableTimeStamp     = TRUE;
+  Option.EnableWindowScaling = TRUE;
+  Option.EnableSelectiveAck  = (BOOLEAN) !ShellCommandLineGetFlag (Package, L"-n");
+  Shared                     = ShellCommandLineGetFlag (Package, L"-a");
+
+  ShellCommandLineFreeVarList (Package);
+
+  //
+  // Convert the delay to microseconds, see LOOPBACK_WIRE.
+  //
+  Wire.Latency *= 1000;
+
+  Nic[0] = NULL;
+  Nic[1] = NULL;
+  ZeroMem (&Sniffer, sizeof (Sniffer));
+
+  for (Index = 0; Index < 2; Index++) {
+    Status = LoopbackNicCreate ((UINT8) (Index + 1), &Wire, &Nic[Index]);
+    if (EFI_ERROR (Status)) {
+      Print (L"Failed to create the virtual NIC - %r\n", Status);
+      goto ON_EXIT;
+    }
+  }
+
+  Nic[0]->Peer = Nic[1];
+  Nic[1]->Peer = Nic[0];
+
+  for (Index = 0; Index < 2; Index++) {
+    gBS->ConnectController (Nic[Index]->Handle, NULL, NULL, TRUE);
+
+    Status = TcpLoopbackConfigureIp (Nic[Index], &mTcpLoopbackAddress[Index]);
+    if (EFI_ERROR (Status)) {
+      Print (L"Failed to configure IP4 on the virtual NIC - %r\n", Status);
+      goto ON_EXIT;
+    }
+  }
+
+  if (Shared) {
+    Status = TcpLoopbackStartSniffer (Nic[1], &Sniffer);
+    if (EFI_ERROR (Status)) {
+      Print (L"Failed to open the IP4 child - %r\n", Status);
+      goto ON_EXIT;
+    }
+  }
+
+  Status = TcpLoopbackRun (Nic, &Option, Size, Rounds, &Elapsed, &Rtt);
+  if (EFI_ERROR (Status)) {
+    Print (L"Transfer failed - %r\n", Status);
+    goto ON_EXIT;
+  }
+
+  if (Rounds != 0) {
+    TcpLoopbackReportRtt (Nic, &Rtt);
+    goto ON_EXIT;
+  }
+
+  Elapsed = MAX (Elapsed, 1);
+  Kbps    = DivU64x64Remainder (MultU64x32 (Size, 8 * 1000000), Elapsed, NULL);
+
+  Print (
+    L"%Ld bytes in %Ld ms, loss %d/10000, delay %d ms, SACK %s\n",
+    Size,
+    DivU64x32 (Elapsed, 1000000),
+    Wire.LossRate,
+    Wire.Latency / 1000,
+    Option.EnableSelectiveAck ? L"on" : L"off"
+    );
+  Print (
+    L"Goodput %Ld.%03Ld Mbit/s, frames sent %Ld, dropped %Ld\n",
+    DivU64x32 (Kbps, 1000),
+    ModU64x32 (Kbps, 1000),
+    Nic[0]->TxFrames + Nic[1]->TxFrames,
+    Nic[0]->DroppedFrames + Nic[1]->DroppedFrames
+    );
+
+  //
+  // The copy to the buffers of MNP is the only one below TCP unless the
+  // packets are shared, then the rest is the copy to the receive tokens.
+  //
+  Ratio = DivU64x64Remainder (MultU64x32 (Nic[1]->RxBytes, 1000), MAX (Size, 1), NULL);
+  Print (
+    L"Receive tokens %Ld, %Ld bytes each, NIC copied %Ld.%03Ld bytes per byte delivered\n",
+    mTcpLoopbackRcvCount,
+    DivU64x64Remainder (Size, MAX (mTcpLoopbackRcvCount, 1), NULL),
+    DivU64x32 (Ratio, 1000),
+    ModU64x32 (Ratio, 1000)
+    );
+
+  if (Shared) {
+    Print (L"Packets shared with another IP4 child %Ld\n", Sniffer.Packets);
+  }
+
+ON_EXIT:
+  if (Nic[1] != NULL) {
+    TcpLoopbackStopSniffer (Nic[1], &Sniffer);
+  }
+
+  for (Index = 0; Index < 2; Index++) {
+    if (Nic[Index] != NULL) {
+      LoopbackNicDestroy (Nic[Index]);
+    }
+  }
+
+  return Status;
+}
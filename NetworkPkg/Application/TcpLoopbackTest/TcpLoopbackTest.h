@@ -0,0 +1,151 @@
+/** @file
+  The shared definitions of the TCP loopback test application.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _TCP_LOOPBACK_TEST_H_
+#define _TCP_LOOPBACK_TEST_H_
+
+#include <Uefi.h>
+
+#include <Protocol/SimpleNetwork.h>
+#include <Protocol/DevicePath.h>
+#include <Protocol/ServiceBinding.h>
+#include <Protocol/Ip4Config2.h>
+#include <Protocol/Ip4.h>
+#include <Protocol/Tcp4.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/NetLib.h>
+#include <Library/ShellLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#define LOOPBACK_NIC_SIGNATURE     SIGNATURE_32 ('T', 'L', 'B', 'N')
+
+#define LOOPBACK_MEDIA_HEADER_SIZE 14
+#define LOOPBACK_MTU               1500
+#define LOOPBACK_FRAME_SIZE        (LOOPBACK_MEDIA_HEADER_SIZE + LOOPBACK_MTU)
+
+//
+// Number of frames the wire can hold in one direction, the frames
+// beyond it are dropped like on a router with a full queue.
+//
+#define LOOPBACK_QUEUE_SIZE        512
+
+//
+// Number of transmitted buffers waiting to be recycled by GetStatus().
+//
+#define LOOPBACK_TX_BUF_NUM        64
+
+///
+/// The impairment of the wire between the two virtual NICs.
+///
+typedef struct {
+  UINT32    LossRate;     ///< Frames dropped per 10000, ARP is never dropped.
+  UINT32    Latency;      ///< One-way delay in microseconds.
+  UINT32    Seed;         ///< State of the pseudo random generator.
+} LOOPBACK_WIRE;
+
+///
+/// A frame on the wire, delivered to the peer when its time comes.
+///
+typedef struct {
+  UINT64    DeliverTime;  ///< In nanoseconds, see LoopbackGetTime().
+  UINTN     Length;
+  UINT8     Data[LOOPBACK_FRAME_SIZE];
+} LOOPBACK_FRAME;
+
+#pragma pack(1)
+typedef struct {
+  VENDOR_DEVICE_PATH          Vendor;
+  MAC_ADDR_DEVICE_PATH        Mac;
+  EFI_DEVICE_PATH_PROTOCOL    End;
+} LOOPBACK_NIC_DEVICE_PATH;
+#pragma pack()
+
+typedef struct _LOOPBACK_NIC LOOPBACK_NIC;
+
+///
+/// A virtual NIC, which produces Simple Network Protocol.
+///
+struct _LOOPBACK_NIC {
+  UINT32                        Signature;
+  EFI_HANDLE                    Handle;
+  EFI_SIMPLE_NETWORK_PROTOCOL   Snp;
+  EFI_SIMPLE_NETWORK_MODE       Mode;
+  LOOPBACK_NIC_DEVICE_PATH      DevicePath;
+
+  LOOPBACK_NIC                  *Peer;
+  LOOPBACK_WIRE                 *Wire;
+
+  //
+  // Frames on the way to this NIC, a ring of LOOPBACK_QUEUE_SIZE.
+  //
+  LOOPBACK_FRAME                *RxQueue;
+  UINTN                         RxHead;
+  UINTN                         RxCount;
+
+  VOID                          *TxBuf[LOOPBACK_TX_BUF_NUM];
+  UINTN                         TxBufCount;
+
+  UINT64                        TxFrames;
+  UINT64                        DroppedFrames;
+  UINT64                        RxBytes;        ///< Bytes copied to the buffers of MNP.
+  UINT64                        ReceiveCalls;   ///< Calls of Receive() while initialized.
+  UINT64                        EmptyReceives;  ///< Calls of Receive() with no frame due.
+  UINT64                        WaitChecks;     ///< Checks of the WaitForPacket event.
+};
+
+#define LOOPBACK_NIC_FROM_SNP(a)   CR (a, LOOPBACK_NIC, Snp, LOOPBACK_NIC_SIGNATURE)
+
+/**
+  Get the current time of the wire.
+
+  @return The time in nanoseconds.
+
+**/
+UINT64
+LoopbackGetTime (
+  VOID
+  );
+
+/**
+  Create a virtual NIC and install Simple Network Protocol and
+  Device Path Protocol on a new handle.
+
+  @param[in]   Index    Index of the NIC, used as the last byte of its MAC.
+  @param[in]   Wire     The wire the NIC is attached to.
+  @param[out]  Nic      The created NIC.
+
+  @retval EFI_SUCCESS            The NIC is created.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
+  @retval Others                 Failed to install the protocols.
+
+**/
+EFI_STATUS
+LoopbackNicCreate (
+  IN  UINT8           Index,
+  IN  LOOPBACK_WIRE   *Wire,
+  OUT LOOPBACK_NIC    **Nic
+  );
+
+/**
+  Uninstall the protocols of the virtual NIC and free it.
+
+  @param[in]  Nic       The NIC to destroy.
+
+**/
+VOID
+LoopbackNicDestroy (
+  IN LOOPBACK_NIC     *Nic
+  );
+
+#endif
@@ -39,6 +39,15 @@ struct _DNS_DRIVER_DATA {
 
   LIST_ENTRY                    Dns6CacheList;
   LIST_ENTRY                    Dns6ServerList;
+
+  //
+  // Statistics of the cache shared by all the instances, for DEBUG builds.
+  //
+  UINT32                        Dns4CacheHits;    /// Lookups answered from the cache.
+  UINT32                        Dns4CacheMisses;  /// Lookups sent to the DNS server.
+  UINT32                        Dns6CacheHits;
+  UINT32                        Dns6CacheMisses;
+  UINT32                        CacheExpired;     /// Entries removed at the end of their TTL.
 };
 
 struct _DNS_SERVICE {
@@ -740,6 +740,31 @@ Dns6ConfigUdp (
   return Status;
 }
 
+/**
+  Compare two host names of the DNS cache. Like DNS, the comparison
+  ignores the case of the ASCII letters (RFC 4343).
+
+  @param  HostName1          The first host name.
+  @param  HostName2          The second host name.
+
+  @retval TRUE               The host names are the same.
+  @retval FALSE              The host names are different.
+
+**/
+BOOLEAN
+DnsIsSameHostName (
+  IN CHAR16                 *HostName1,
+  IN CHAR16                 *HostName2
+  )
+{
+  while ((*HostName1 != L'\0') && (CharToUpper (*HostName1) == CharToUpper (*HostName2))) {
+    HostName1++;
+    HostName2++;
+  }
+
+  return (BOOLEAN) (CharToUpper (*HostName1) == CharToUpper (*HostName2));
+}
+
 /**
   Update Dns4 cache to shared list of caches of all DNSv4 instances.
 
@@ -776,7 +801,7 @@ UpdateDns4Cache (
   //
   NET_LIST_FOR_EACH_SAFE (Entry, Next, Dns4CacheList) {
     Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-    if (StrCmp (DnsCacheEntry.HostName, Item->DnsCache.HostName) == 0 && \
+    if (DnsIsSameHostName (DnsCacheEntry.HostName, Item->DnsCache.HostName) && \
         CompareMem (DnsCacheEntry.IpAddress, Item->DnsCache.IpAddress, sizeof (EFI_IPv4_ADDRESS)) == 0) {
       //
       // This is the Dns cache entry
@@ -874,7 +899,7 @@ UpdateDns6Cache (
   //
   NET_LIST_FOR_EACH_SAFE (Entry, Next, Dns6CacheList) {
     Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-    if (StrCmp (DnsCacheEntry.HostName, Item->DnsCache.HostName) == 0 && \
+    if (DnsIsSameHostName (DnsCacheEntry.HostName, Item->DnsCache.HostName) && \
         CompareMem (DnsCacheEntry.IpAddress, Item->DnsCache.IpAddress, sizeof (EFI_IPv6_ADDRESS)) == 0) {
       //
       // This is the Dns cache entry
@@ -1517,7 +1542,12 @@ ParseDnsResponse (
           Dns4CacheEntry->Timeout = MAX (CNameTtl, AnswerSection->Ttl);
         }
 
-        UpdateDns4Cache (&mDriverData->Dns4CacheList, FALSE, TRUE, *Dns4CacheEntry);
+        //
+        // A zero TTL means the answer is only good for this query (RFC 1035).
+        //
+        if (Dns4CacheEntry->Timeout != 0) {
+          UpdateDns4Cache (&mDriverData->Dns4CacheList, FALSE, TRUE, *Dns4CacheEntry);
+        }
 
         //
         // Free allocated CacheEntry pool.
@@ -1576,7 +1606,12 @@ ParseDnsResponse (
           Dns6CacheEntry->Timeout = MAX (CNameTtl, AnswerSection->Ttl);
         }
 
-        UpdateDns6Cache (&mDriverData->Dns6CacheList, FALSE, TRUE, *Dns6CacheEntry);
+        //
+        // A zero TTL means the answer is only good for this query (RFC 1035).
+        //
+        if (Dns6CacheEntry->Timeout != 0) {
+          UpdateDns6Cache (&mDriverData->Dns6CacheList, FALSE, TRUE, *Dns6CacheEntry);
+        }
 
         //
         // Free allocated CacheEntry pool.
@@ -2201,13 +2236,16 @@ DnsOnTimerUpdate (
   //
   NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns4CacheList) {
     Item4 = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-    Item4->DnsCache.Timeout--;
+    if (Item4->DnsCache.Timeout != 0) {
+      Item4->DnsCache.Timeout--;
+    }
   }
 
   Entry = mDriverData->Dns4CacheList.ForwardLink;
   while (Entry != &mDriverData->Dns4CacheList) {
     Item4 = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
     if (Item4->DnsCache.Timeout == 0) {
+      mDriverData->CacheExpired++;
       RemoveEntryList (&Item4->AllCacheLink);
       FreePool (Item4->DnsCache.HostName);
       FreePool (Item4->DnsCache.IpAddress);
@@ -2223,13 +2261,16 @@ DnsOnTimerUpdate (
   //
   NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns6CacheList) {
     Item6 = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-    Item6->DnsCache.Timeout--;
+    if (Item6->DnsCache.Timeout != 0) {
+      Item6->DnsCache.Timeout--;
+    }
   }
 
   Entry = mDriverData->Dns6CacheList.ForwardLink;
   while (Entry != &mDriverData->Dns6CacheList) {
     Item6 = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
     if (Item6->DnsCache.Timeout == 0) {
+      mDriverData->CacheExpired++;
       RemoveEntryList (&Item6->AllCacheLink);
       FreePool (Item6->DnsCache.HostName);
       FreePool (Item6->DnsCache.IpAddress);
@@ -471,6 +471,23 @@ Dns6ConfigUdp (
   IN UDP_IO                 *UdpIo
   );
 
+/**
+  Compare two host names of the DNS cache. Like DNS, the comparison
+  ignores the case of the ASCII letters (RFC 4343).
+
+  @param  HostName1          The first host name.
+  @param  HostName2          The second host name.
+
+  @retval TRUE               The host names are the same.
+  @retval FALSE              The host names are different.
+
+**/
+BOOLEAN
+DnsIsSameHostName (
+  IN CHAR16                 *HostName1,
+  IN CHAR16                 *HostName2
+  );
+
 /**
   Update Dns4 cache to shared list of caches of all DNSv4 instances.
 
@@ -404,7 +404,7 @@ Dns4HostNameToIp (
     Index = 0;
     NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns4CacheList) {
       Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-      if (StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+      if (DnsIsSameHostName (HostName, Item->DnsCache.HostName)) {
         Index++;
       }
     }
@@ -430,12 +430,22 @@ Dns4HostNameToIp (
       Index = 0;
       NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns4CacheList) {
         Item = NET_LIST_USER_STRUCT (Entry, DNS4_CACHE, AllCacheLink);
-        if ((UINT32)Index < Token->RspData.H2AData->IpCount && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+        if ((UINT32)Index < Token->RspData.H2AData->IpCount && DnsIsSameHostName (HostName, Item->DnsCache.HostName)) {
           CopyMem ((Token->RspData.H2AData->IpList) + Index, Item->DnsCache.IpAddress, sizeof (EFI_IPv4_ADDRESS));
           Index++;
         }
       }
 
+      mDriverData->Dns4CacheHits++;
+      DEBUG ((
+        DEBUG_INFO,
+        "Dns4HostNameToIp: %s from cache, %d hits, %d misses, %d expired\n",
+        HostName,
+        mDriverData->Dns4CacheHits,
+        mDriverData->Dns4CacheMisses,
+        mDriverData->CacheExpired
+        ));
+
       Token->Status = EFI_SUCCESS;
 
       if (Token->Event != NULL) {
@@ -446,6 +456,8 @@ Dns4HostNameToIp (
       Status = Token->Status;
       goto ON_EXIT;
     }
+
+    mDriverData->Dns4CacheMisses++;
   }
 
   //
@@ -1246,7 +1258,7 @@ Dns6HostNameToIp (
     Index = 0;
     NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns6CacheList) {
       Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-      if (StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+      if (DnsIsSameHostName (HostName, Item->DnsCache.HostName)) {
         Index++;
       }
     }
@@ -1272,12 +1284,22 @@ Dns6HostNameToIp (
       Index = 0;
       NET_LIST_FOR_EACH_SAFE (Entry, Next, &mDriverData->Dns6CacheList) {
         Item = NET_LIST_USER_STRUCT (Entry, DNS6_CACHE, AllCacheLink);
-        if ((UINT32)Index < Token->RspData.H2AData->IpCount && StrCmp (HostName, Item->DnsCache.HostName) == 0) {
+        if ((UINT32)Index < Token->RspData.H2AData->IpCount && DnsIsSameHostName (HostName, Item->DnsCache.HostName)) {
           CopyMem ((Token->RspData.H2AData->IpList) + Index, Item->DnsCache.IpAddress, sizeof (EFI_IPv6_ADDRESS));
           Index++;
         }
       }
 
+      mDriverData->Dns6CacheHits++;
+      DEBUG ((
+        DEBUG_INFO,
+        "Dns6HostNameToIp: %s from cache, %d hits, %d misses, %d expired\n",
+        HostName,
+        mDriverData->Dns6CacheHits,
+        mDriverData->Dns6CacheMisses,
+        mDriverData->CacheExpired
+        ));
+
       Token->Status = EFI_SUCCESS;
 
       if (Token->Event != NULL) {
@@ -1288,6 +1310,8 @@ Dns6HostNameToIp (
       Status = Token->Status;
       goto ON_EXIT;
     }
+
+    mDriverData->Dns6CacheMisses++;
   }
 
   //
@@ -76,6 +76,24 @@ HttpBootDiscoverBootInfo (
   IN OUT HTTP_BOOT_PRIVATE_DATA   *Private
   );
 
+/**
+  Create and configure a HttpIo instance with the address of the driver.
+
+  @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       Callback function of the HttpIo, or NULL.
+  @param[out]   HttpIo         The HttpIo instance to initialize.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootInitHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback,  OPTIONAL
+     OUT HTTP_IO                      *HttpIo
+  );
+
 /**
   Create a HttpIo instance for the file download.
 
@@ -90,6 +108,33 @@ HttpBootCreateHttpIo (
   IN     HTTP_BOOT_PRIVATE_DATA       *Private
   );
 
+/**
+  Get the file content from cached data.
+
+  @param[in]          Private         The pointer to the driver's private data.
+  @param[in]          Uri             Uri of the file to be retrieved from cache.
+  @param[in, out]     BufferSize      On input the size of Buffer in bytes. On output with a return
+                                      code of EFI_SUCCESS, the amount of data transferred to
+                                      Buffer. On output with a return code of EFI_BUFFER_TOO_SMALL,
+                                      the size of Buffer required to retrieve the requested file.
+  @param[out]         Buffer          The memory buffer to transfer the file to. IF Buffer is NULL,
+                                      then the size of the requested file is returned in
+                                      BufferSize.
+  @param[out]         ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootGetFileFromCache (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     CHAR16                   *Uri,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer,
+     OUT HTTP_BOOT_IMAGE_TYPE     *ImageType
+  );
+
 /**
   This function download the boot file by using UEFI HTTP protocol.
 
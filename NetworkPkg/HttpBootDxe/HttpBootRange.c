@@ -0,0 +1,479 @@
+/** @file
+  Download the boot file over several connections with HTTP range requests.
+
+  A single TCP connection rarely fills a path with a large bandwidth-delay
+  product, so the boot file is split into ranges which are requested over
+  several HTTP children at the same time. The ranges are handed out to the
+  connections on demand, and the entity body of each range is received into
+  its place in the caller's buffer directly.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "HttpBootDxe.h"
+
+/**
+  Invoke the HTTP Boot callback, if any.
+
+  @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    DataType       The type of the data.
+  @param[in]    DataLength     The length of the data in bytes.
+  @param[in]    Data           The data.
+
+  @retval EFI_SUCCESS          Continue the download.
+  @retval Others               Abort the download.
+
+**/
+EFI_STATUS
+HttpBootRangeNotify (
+  IN HTTP_BOOT_PRIVATE_DATA          *Private,
+  IN EFI_HTTP_BOOT_CALLBACK_DATA_TYPE DataType,
+  IN UINT32                          DataLength,
+  IN VOID                            *Data
+  )
+{
+  if (Private->HttpBootCallback == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  return Private->HttpBootCallback->Callback (
+                                      Private->HttpBootCallback,
+                                      DataType,
+                                      (BOOLEAN) (DataType != HttpBootHttpRequest),
+                                      DataLength,
+                                      Data
+                                      );
+}
+
+/**
+  Queue a response token on the connection, to receive the response header
+  or the entity body of the current range, depending on the connection state.
+
+  @param[in, out]  Conn          The connection.
+  @param[in]       Buffer        The buffer the file is downloaded to.
+
+  @retval EFI_SUCCESS            The token is queued.
+  @retval Others                 Failed to queue the token.
+
+**/
+EFI_STATUS
+HttpBootRangeRecv (
+  IN OUT HTTP_BOOT_RANGE_CONN     *Conn,
+  IN     UINT8                    *Buffer
+  )
+{
+  HTTP_IO                    *HttpIo;
+  EFI_STATUS                 Status;
+
+  HttpIo = &Conn->HttpIo;
+
+  HttpIo->RspToken.Status = EFI_NOT_READY;
+  HttpIo->RspToken.Message->HeaderCount = 0;
+  HttpIo->RspToken.Message->Headers     = NULL;
+  if (Conn->State == HttpBootRangeHeader) {
+    HttpIo->RspToken.Message->Data.Response = &Conn->Response;
+    HttpIo->RspToken.Message->BodyLength    = 0;
+    HttpIo->RspToken.Message->Body          = NULL;
+  } else {
+    HttpIo->RspToken.Message->Data.Response = NULL;
+    HttpIo->RspToken.Message->BodyLength    = Conn->End - Conn->Offset;
+    HttpIo->RspToken.Message->Body          = Buffer + Conn->Offset;
+  }
+
+  HttpIo->IsRxDone = FALSE;
+
+  Status = gBS->SetTimer (HttpIo->TimeoutEvent, TimerRelative, HttpIo->Timeout * TICKS_PER_MS);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpIo->Http->Response (HttpIo->Http, &HttpIo->RspToken);
+  if (EFI_ERROR (Status)) {
+    gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+  }
+
+  return Status;
+}
+
+/**
+  Request the next range of the file on an idle connection.
+
+  @param[in, out]  Conn          The connection.
+  @param[in]       RequestData   The request data of the boot file.
+  @param[in]       Start         The first byte of the range.
+  @param[in]       Length        The length of the range.
+  @param[in]       Buffer        The buffer the file is downloaded to.
+
+  @retval EFI_SUCCESS            The request is sent.
+  @retval Others                 Failed to send the request.
+
+**/
+EFI_STATUS
+HttpBootRangeRequest (
+  IN OUT HTTP_BOOT_RANGE_CONN     *Conn,
+  IN     EFI_HTTP_REQUEST_DATA    *RequestData,
+  IN     UINTN                    Start,
+  IN     UINTN                    Length,
+  IN     UINT8                    *Buffer
+  )
+{
+  CHAR8                      Range[48];
+  EFI_STATUS                 Status;
+
+  AsciiSPrint (Range, sizeof (Range), "bytes=%Lu-%Lu", (UINT64) Start, (UINT64) (Start + Length - 1));
+  Status = HttpIoSetHeader (Conn->Header, HTTP_HEADER_RANGE, Range);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpIoSendRequest (
+             &Conn->HttpIo,
+             RequestData,
+             Conn->Header->HeaderCount,
+             Conn->Header->Headers,
+             0,
+             NULL
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Conn->Start  = Start;
+  Conn->End    = Start + Length;
+  Conn->Offset = Start;
+  Conn->State  = HttpBootRangeHeader;
+
+  return HttpBootRangeRecv (Conn, Buffer);
+}
+
+/**
+  Check the response header received on a connection, and release it.
+
+  @param[in, out]  Conn          The connection.
+  @param[in]       Status        The status of the response token.
+
+  @retval EFI_SUCCESS            The server responds with the requested range.
+  @retval EFI_UNSUPPORTED        The server doesn't respond with the requested range.
+  @retval Others                 The request failed.
+
+**/
+EFI_STATUS
+HttpBootRangeCheckResponse (
+  IN OUT HTTP_BOOT_RANGE_CONN     *Conn,
+  IN     EFI_STATUS               Status
+  )
+{
+  EFI_HTTP_MESSAGE           *Message;
+  EFI_HTTP_HEADER            *Header;
+  CHAR8                      *Value;
+  UINTN                      First;
+  UINTN                      Last;
+
+  Message = Conn->HttpIo.RspToken.Message;
+
+  if (!EFI_ERROR (Status) || (Status == EFI_HTTP_ERROR)) {
+    if ((Conn->Response.StatusCode == HTTP_STATUS_200_OK) ||
+        (Conn->Response.StatusCode == HTTP_STATUS_416_REQUESTED_RANGE_NOT_SATISFIED)) {
+      //
+      // The server ignores or refuses the range request.
+      //
+      Status = EFI_UNSUPPORTED;
+    } else if (Conn->Response.StatusCode != HTTP_STATUS_206_PARTIAL_CONTENT) {
+      HttpBootPrintErrorMessage (Conn->Response.StatusCode);
+      if (!EFI_ERROR (Status)) {
+        Status = EFI_HTTP_ERROR;
+      }
+    } else {
+      //
+      // Make sure it's the range requested, in the form "bytes first-last/length".
+      //
+      Status = EFI_UNSUPPORTED;
+      Header = HttpFindHeader (Message->HeaderCount, Message->Headers, HTTP_HEADER_CONTENT_RANGE);
+      Value  = (Header != NULL) ? AsciiStrStr (Header->FieldValue, "bytes ") : NULL;
+      if (Value != NULL) {
+        First = AsciiStrDecimalToUintn (Value + AsciiStrLen ("bytes "));
+        Value = AsciiStrStr (Value, "-");
+        if (Value != NULL) {
+          Last = AsciiStrDecimalToUintn (Value + 1);
+          if ((First == Conn->Start) && (Last == Conn->End - 1)) {
+            Status = EFI_SUCCESS;
+          }
+        }
+      }
+    }
+  }
+
+  if (Message->Headers != NULL) {
+    HttpFreeHeaderFields (Message->Headers, Message->HeaderCount);
+    Message->Headers     = NULL;
+    Message->HeaderCount = 0;
+  }
+
+  return Status;
+}
+
+/**
+  Download the boot file into Buffer over several HTTP connections, each
+  requesting a different range of the file.
+
+  The download is only done this way if it's enabled by PcdHttpBootRangeConnections,
+  the file is large, and the server has announced the support of range requests.
+  If a server still responds to the range request with the whole file, the
+  download is given up, and the caller should download the file in one piece.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[out]      ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file can't be downloaded with range requests.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileRanges (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer,
+     OUT HTTP_BOOT_IMAGE_TYPE     *ImageType
+  )
+{
+  HTTP_BOOT_RANGE_CONN       *Conn;
+  HTTP_BOOT_RANGE_CONN       *Current;
+  UINTN                      ConnCount;
+  UINTN                      Index;
+  UINTN                      FileSize;
+  UINTN                      SegmentSize;
+  UINTN                      Next;
+  UINTN                      Length;
+  BOOLEAN                    Active;
+  BOOLEAN                    Notified;
+  UINTN                      UrlSize;
+  CHAR16                     *Url;
+  CHAR8                      *HostName;
+  CHAR8                      LengthValue[24];
+  EFI_HTTP_REQUEST_DATA      RequestData;
+  EFI_HTTP_MESSAGE           Message;
+  EFI_HTTP_HEADER            LengthHeader;
+  EFI_STATUS                 Status;
+
+  ConnCount = MIN (PcdGet8 (PcdHttpBootRangeConnections), HTTP_BOOT_RANGE_MAX_CONNECTIONS);
+  FileSize  = Private->BootFileSize;
+
+  if ((ConnCount < 2) || !Private->BootFileAcceptRanges || (FileSize < HTTP_BOOT_RANGE_MIN_FILE_SIZE) ||
+      (Buffer == NULL) || (*BufferSize < FileSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  UrlSize = AsciiStrSize (Private->BootFileUri);
+  Url = AllocatePool (UrlSize * sizeof (CHAR16));
+  if (Url == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  AsciiStrToUnicodeStrS (Private->BootFileUri, Url, UrlSize);
+
+  //
+  // The file may have been cached while its size was being retrieved.
+  //
+  Status = HttpBootGetFileFromCache (Private, Url, BufferSize, Buffer, ImageType);
+  if (Status != EFI_NOT_FOUND) {
+    FreePool (Url);
+    return Status;
+  }
+
+  HostName = NULL;
+  Status = HttpUrlGetHostName (Private->BootFileUri, Private->BootFileUriParser, &HostName);
+  if (EFI_ERROR (Status)) {
+    FreePool (Url);
+    return Status;
+  }
+
+  Conn = AllocateZeroPool (ConnCount * sizeof (HTTP_BOOT_RANGE_CONN));
+  if (Conn == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  //
+  // Create the HTTP children, at least two of them, otherwise downloading
+  // the file in one piece is as good.
+  //
+  for (Index = 0; Index < ConnCount; Index++) {
+    Current = &Conn[Index];
+    Status  = HttpBootInitHttpIo (Private, NULL, &Current->HttpIo);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Current->Created = TRUE;
+
+    Current->Header = HttpIoCreateHeader (4);
+    if (Current->Header == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto ON_EXIT;
+    }
+
+    Status = HttpIoSetHeader (Current->Header, HTTP_HEADER_HOST, HostName);
+    if (!EFI_ERROR (Status)) {
+      Status = HttpIoSetHeader (Current->Header, HTTP_HEADER_ACCEPT, "*/*");
+    }
+    if (!EFI_ERROR (Status)) {
+      Status = HttpIoSetHeader (Current->Header, HTTP_HEADER_USER_AGENT, HTTP_USER_AGENT_EFI_HTTP_BOOT);
+    }
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+  }
+
+  if (Index < 2) {
+    Status = EFI_UNSUPPORTED;
+    goto ON_EXIT;
+  }
+  ConnCount = Index;
+
+  RequestData.Method = HttpMethodGet;
+  RequestData.Url    = Url;
+
+  ZeroMem (&Message, sizeof (Message));
+  Message.Data.Request = &RequestData;
+  Status = HttpBootRangeNotify (Private, HttpBootHttpRequest, sizeof (EFI_HTTP_MESSAGE), &Message);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  //
+  // Each connection gets a few ranges, so that the faster connections can
+  // take over the remaining ranges of a slower one.
+  //
+  SegmentSize = MAX (FileSize / (ConnCount * HTTP_BOOT_RANGE_SEGMENTS_PER_CONN), HTTP_BOOT_RANGE_MIN_SEGMENT_SIZE);
+  Next        = 0;
+  Notified    = FALSE;
+
+  do {
+    Active = FALSE;
+
+    for (Index = 0; Index < ConnCount; Index++) {
+      Current = &Conn[Index];
+
+      if (Current->State == HttpBootRangeIdle) {
+        if (Next >= FileSize) {
+          continue;
+        }
+
+        Length = MIN (FileSize - Next, SegmentSize);
+        Status = HttpBootRangeRequest (Current, &RequestData, Next, Length, Buffer);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+        Next += Length;
+      }
+
+      Active = TRUE;
+      Current->HttpIo.Http->Poll (Current->HttpIo.Http);
+
+      if (!Current->HttpIo.IsRxDone) {
+        if (!EFI_ERROR (gBS->CheckEvent (Current->HttpIo.TimeoutEvent))) {
+          Status = EFI_TIMEOUT;
+          goto ON_EXIT;
+        }
+        continue;
+      }
+
+      gBS->SetTimer (Current->HttpIo.TimeoutEvent, TimerCancel, 0);
+      Current->HttpIo.IsRxDone = FALSE;
+      Status = Current->HttpIo.RspToken.Status;
+
+      if (Current->State == HttpBootRangeHeader) {
+        Status = HttpBootRangeCheckResponse (Current, Status);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+
+        if (!Notified) {
+          //
+          // Report the length of the whole file rather than the range.
+          //
+          AsciiSPrint (LengthValue, sizeof (LengthValue), "%Lu", (UINT64) FileSize);
+          LengthHeader.FieldName  = HTTP_HEADER_CONTENT_LENGTH;
+          LengthHeader.FieldValue = LengthValue;
+          Message.Data.Response   = &Current->Response;
+          Message.HeaderCount     = 1;
+          Message.Headers         = &LengthHeader;
+          Status = HttpBootRangeNotify (Private, HttpBootHttpResponse, sizeof (EFI_HTTP_MESSAGE), &Message);
+          if (EFI_ERROR (Status)) {
+            goto ON_EXIT;
+          }
+          Notified = TRUE;
+        }
+
+        Current->State = HttpBootRangeBody;
+      } else {
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+
+        Length = Current->HttpIo.RspToken.Message->BodyLength;
+        Status = HttpBootRangeNotify (Private, HttpBootHttpEntityBody, (UINT32) Length, Buffer + Current->Offset);
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+
+        Current->Offset   += Length;
+        Current->Received += Length;
+        if (Current->Offset == Current->End) {
+          Current->Ranges++;
+          Current->State = HttpBootRangeIdle;
+          continue;
+        }
+      }
+
+      Status = HttpBootRangeRecv (Current, Buffer);
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+    }
+  } while (Active);
+
+  *BufferSize = FileSize;
+  *ImageType  = Private->ImageType;
+  Status      = EFI_SUCCESS;
+
+ON_EXIT:
+  if (Conn != NULL) {
+    for (Index = 0; Index < ConnCount; Index++) {
+      Current = &Conn[Index];
+      if (Current->Created) {
+        DEBUG ((
+          DEBUG_INFO,
+          "HttpBootGetBootFileRanges: connection %d received %Lu bytes in %d ranges\n",
+          Index,
+          Current->Received,
+          Current->Ranges
+          ));
+
+        //
+        // Flush the pending tokens, and their DPCs which refer to the connection.
+        //
+        gBS->SetTimer (Current->HttpIo.TimeoutEvent, TimerCancel, 0);
+        if (Current->State != HttpBootRangeIdle) {
+          Current->HttpIo.Http->Cancel (Current->HttpIo.Http, NULL);
+          DispatchDpc ();
+        }
+        HttpIoDestroyIo (&Current->HttpIo);
+      }
+
+      if (Current->Header != NULL) {
+        HttpIoFreeHeader (Current->Header);
+      }
+    }
+    FreePool (Conn);
+  }
+
+  FreePool (HostName);
+  FreePool (Url);
+  return Status;
+}
@@ -0,0 +1,74 @@
+/** @file
+  Declaration of the boot file download over several connections with HTTP
+  range requests.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EFI_HTTP_BOOT_RANGE_H__
+#define __EFI_HTTP_BOOT_RANGE_H__
+
+#define HTTP_BOOT_RANGE_MAX_CONNECTIONS      8
+#define HTTP_BOOT_RANGE_MIN_FILE_SIZE        SIZE_8MB
+#define HTTP_BOOT_RANGE_MIN_SEGMENT_SIZE     SIZE_1MB
+
+//
+// Number of ranges each connection downloads if the file is large enough,
+// so that a slow connection doesn't delay the end of the download much.
+//
+#define HTTP_BOOT_RANGE_SEGMENTS_PER_CONN    4
+
+typedef enum {
+  HttpBootRangeIdle,
+  HttpBootRangeHeader,
+  HttpBootRangeBody
+} HTTP_BOOT_RANGE_STATE;
+
+//
+// A connection downloading one range of the boot file at a time.
+//
+typedef struct {
+  HTTP_IO                    HttpIo;
+  BOOLEAN                    Created;
+  HTTP_BOOT_RANGE_STATE      State;
+  HTTP_IO_HEADER             *Header;
+  EFI_HTTP_RESPONSE_DATA     Response;
+  UINTN                      Start;       // First byte of the current range.
+  UINTN                      End;         // The byte after the current range.
+  UINTN                      Offset;      // Next byte to receive.
+  UINT64                     Received;    // Bytes received on this connection.
+  UINTN                      Ranges;      // Ranges completed on this connection.
+} HTTP_BOOT_RANGE_CONN;
+
+/**
+  Download the boot file into Buffer over several HTTP connections, each
+  requesting a different range of the file.
+
+  The download is only done this way if it's enabled by PcdHttpBootRangeConnections,
+  the file is large, and the server has announced the support of range requests.
+  If a server still responds to the range request with the whole file, the
+  download is given up, and the caller should download the file in one piece.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[out]      ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file can't be downloaded with range requests.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileRanges (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer,
+     OUT HTTP_BOOT_IMAGE_TYPE     *ImageType
+  );
+
+#endif
@@ -8,9 +8,171 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "HttpDriver.h"
 
+/**
+  Start a host name query to one DNS server using the EFI_DNS4_PROTOCOL.
+
+  @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
+  @param[in]  HostName            Pointer to buffer containing hostname.
+  @param[in]  DnsServer           The DNS server to query, NULL to use the
+                                  default settings of the DNS driver.
+  @param[out] Query               The query, to clean up with HttpDns4Stop()
+                                  even on failure.
+
+  @retval EFI_SUCCESS             The query is started.
+  @retval Others                  Other errors as indicated.
+
+**/
+EFI_STATUS
+HttpDns4Start (
+  IN     HTTP_PROTOCOL            *HttpInstance,
+  IN     CHAR16                   *HostName,
+  IN     EFI_IPv4_ADDRESS         *DnsServer  OPTIONAL,
+     OUT HTTP_DNS4_QUERY          *Query
+  )
+{
+  EFI_STATUS                      Status;
+  EFI_DNS4_CONFIG_DATA            Dns4CfgData;
+  HTTP_SERVICE                    *Service;
+
+  Service = HttpInstance->Service;
+
+  //
+  // Create a DNS child instance and get the protocol.
+  //
+  Status = NetLibCreateServiceChild (
+             Service->ControllerHandle,
+             Service->Ip4DriverBindingHandle,
+             &gEfiDns4ServiceBindingProtocolGuid,
+             &Query->Handle
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->OpenProtocol (
+                  Query->Handle,
+                  &gEfiDns4ProtocolGuid,
+                  (VOID **) &Query->Dns4,
+                  Service->Ip4DriverBindingHandle,
+                  Service->ControllerHandle,
+                  EFI_OPEN_PROTOCOL_BY_DRIVER
+                  );
+  if (EFI_ERROR (Status)) {
+    Query->Dns4 = NULL;
+    return Status;
+  }
+
+  //
+  // Configure DNS4 instance for the DNS server address and protocol.
+  //
+  ZeroMem (&Dns4CfgData, sizeof (Dns4CfgData));
+  if (DnsServer != NULL) {
+    Dns4CfgData.DnsServerListCount = 1;
+    Dns4CfgData.DnsServerList      = DnsServer;
+  }
+  Dns4CfgData.UseDefaultSetting  = HttpInstance->IPv4Node.UseDefaultAddress;
+  if (!Dns4CfgData.UseDefaultSetting) {
+    IP4_COPY_ADDRESS (&Dns4CfgData.StationIp, &HttpInstance->IPv4Node.LocalAddress);
+    IP4_COPY_ADDRESS (&Dns4CfgData.SubnetMask, &HttpInstance->IPv4Node.LocalSubnet);
+  }
+  Dns4CfgData.EnableDnsCache     = TRUE;
+  Dns4CfgData.Protocol           = EFI_IP_PROTO_UDP;
+  Status = Query->Dns4->Configure (
+                          Query->Dns4,
+                          &Dns4CfgData
+                          );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Create event to set the is done flag when name resolution is finished.
+  //
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  HttpCommonNotify,
+                  &Query->IsDone,
+                  &Query->Token.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Start asynchronous name resolution.
+  //
+  Query->Token.Status = EFI_NOT_READY;
+  Query->IsDone       = FALSE;
+  Status = Query->Dns4->HostNameToIp (Query->Dns4, HostName, &Query->Token);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Query->Pending = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Cancel a host name query started by HttpDns4Start(), if it is still in
+  progress, and free its resources.
+
+  @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
+  @param[in]  Query               The query.
+
+**/
+VOID
+HttpDns4Stop (
+  IN     HTTP_PROTOCOL            *HttpInstance,
+  IN     HTTP_DNS4_QUERY          *Query
+  )
+{
+  HTTP_SERVICE                    *Service;
+
+  Service = HttpInstance->Service;
+
+  //
+  // Reset the instance first, it cancels the token and signals its event.
+  //
+  if (Query->Dns4 != NULL) {
+    Query->Dns4->Configure (Query->Dns4, NULL);
+
+    gBS->CloseProtocol (
+           Query->Handle,
+           &gEfiDns4ProtocolGuid,
+           Service->Ip4DriverBindingHandle,
+           Service->ControllerHandle
+           );
+  }
+
+  if (Query->Token.Event != NULL) {
+    gBS->CloseEvent (Query->Token.Event);
+  }
+  if (Query->Token.RspData.H2AData != NULL) {
+    if (Query->Token.RspData.H2AData->IpList != NULL) {
+      FreePool (Query->Token.RspData.H2AData->IpList);
+    }
+    FreePool (Query->Token.RspData.H2AData);
+  }
+
+  if (Query->Handle != NULL) {
+    NetLibDestroyServiceChild (
+      Service->ControllerHandle,
+      Service->Ip4DriverBindingHandle,
+      &gEfiDns4ServiceBindingProtocolGuid,
+      Query->Handle
+      );
+  }
+}
+
 /**
   Retrieve the host address using the EFI_DNS4_PROTOCOL.
 
+  Up to HTTP_DNS_MAX_SERVERS of the configured DNS servers are queried, each
+  one HTTP_DNS_ATTEMPT_DELAY after the previous one or as soon as the previous
+  ones failed, and the first answer is used. A host name in the DNS cache is
+  answered by the first query.
+
   @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
   @param[in]  HostName            Pointer to buffer containing hostname.
   @param[out] IpAddress           On output, pointer to buffer containing IPv4 address.
@@ -29,16 +191,19 @@ HttpDns4 (
   )
 {
   EFI_STATUS                      Status;
-  EFI_DNS4_PROTOCOL               *Dns4;
-  EFI_DNS4_CONFIG_DATA            Dns4CfgData;
-  EFI_DNS4_COMPLETION_TOKEN       Token;
-  BOOLEAN                         IsDone;
+  EFI_STATUS                      Result;
   HTTP_SERVICE                    *Service;
-  EFI_HANDLE                      Dns4Handle;
   EFI_IP4_CONFIG2_PROTOCOL        *Ip4Config2;
   UINTN                           DnsServerListCount;
   EFI_IPv4_ADDRESS                *DnsServerList;
   UINTN                           DataSize;
+  HTTP_DNS4_QUERY                 *Query;
+  HTTP_DNS4_QUERY                 *Winner;
+  UINTN                           QueryCount;
+  UINTN                           Started;
+  UINTN                           Pending;
+  UINTN                           Index;
+  EFI_EVENT                       DelayEvent;
 
 
   Service = HttpInstance->Service;
@@ -46,7 +211,8 @@ HttpDns4 (
 
   DnsServerList      = NULL;
   DnsServerListCount = 0;
-  ZeroMem (&Token, sizeof (EFI_DNS4_COMPLETION_TOKEN));
+  Query              = NULL;
+  DelayEvent         = NULL;
 
   //
   // Get DNS server list from EFI IPv4 Configuration II protocol.
@@ -74,146 +240,282 @@ HttpDns4 (
     }
   }
 
-  Dns4Handle = NULL;
-  Dns4       = NULL;
+  //
+  // Without a DNS server list, a single query takes the servers from DHCP.
+  //
+  QueryCount = MIN (MAX (DnsServerListCount, 1), HTTP_DNS_MAX_SERVERS);
+  Query      = AllocateZeroPool (QueryCount * sizeof (HTTP_DNS4_QUERY));
+  if (Query == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &DelayEvent);
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  Result  = EFI_DEVICE_ERROR;
+  Winner  = NULL;
+  Started = 0;
+  Pending = 0;
+  while (Winner == NULL) {
+    //
+    // Query the next server when the others haven't answered in time, or
+    // have all failed.
+    //
+    if ((Started < QueryCount) && ((Pending == 0) || !EFI_ERROR (gBS->CheckEvent (DelayEvent)))) {
+      Status = HttpDns4Start (
+                 HttpInstance,
+                 HostName,
+                 (DnsServerList == NULL) ? NULL : &DnsServerList[Started],
+                 &Query[Started]
+                 );
+      Started++;
+      if (EFI_ERROR (Status)) {
+        Result = Status;
+      } else {
+        Pending++;
+        gBS->SetTimer (DelayEvent, TimerRelative, HTTP_DNS_ATTEMPT_DELAY);
+      }
+    }
+
+    for (Index = 0; Index < Started; Index++) {
+      if (!Query[Index].Pending) {
+        continue;
+      }
+
+      if (!Query[Index].IsDone) {
+        Query[Index].Dns4->Poll (Query[Index].Dns4);
+        continue;
+      }
+
+      Query[Index].Pending = FALSE;
+      Pending--;
+
+      //
+      // Name resolution is done, check result.
+      //
+      Status = Query[Index].Token.Status;
+      if (!EFI_ERROR (Status)) {
+        if (Query[Index].Token.RspData.H2AData != NULL &&
+            Query[Index].Token.RspData.H2AData->IpCount != 0 &&
+            Query[Index].Token.RspData.H2AData->IpList != NULL) {
+          Winner = &Query[Index];
+          break;
+        }
+
+        Status = EFI_DEVICE_ERROR;
+      }
+
+      Result = Status;
+    }
+
+    if ((Pending == 0) && (Started == QueryCount)) {
+      break;
+    }
+  }
+
+  if (Winner != NULL) {
+    DEBUG ((
+      DEBUG_INFO,
+      "HttpDns4: %s resolved by DNS query %d of %d\n",
+      HostName,
+      Winner - Query + 1,
+      Started
+      ));
+
+    //
+    // We just return the first IP address from DNS protocol.
+    //
+    IP4_COPY_ADDRESS (IpAddress, Winner->Token.RspData.H2AData->IpList);
+    Status = EFI_SUCCESS;
+  } else {
+    Status = Result;
+  }
+
+Exit:
+
+  if (DelayEvent != NULL) {
+    gBS->CloseEvent (DelayEvent);
+  }
+
+  if (Query != NULL) {
+    for (Index = 0; Index < QueryCount; Index++) {
+      HttpDns4Stop (HttpInstance, &Query[Index]);
+    }
+
+    FreePool (Query);
+  }
+
+  if (DnsServerList != NULL) {
+    FreePool (DnsServerList);
+  }
+
+  return Status;
+}
+
+/**
+  Start a host name query to one DNS server using the EFI_DNS6_PROTOCOL.
+
+  @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
+  @param[in]  HostName            Pointer to buffer containing hostname.
+  @param[in]  DnsServer           The DNS server to query, NULL to use the
+                                  default settings of the DNS driver.
+  @param[out] Query               The query, to clean up with HttpDns6Stop()
+                                  even on failure.
+
+  @retval EFI_SUCCESS             The query is started.
+  @retval Others                  Other errors as indicated.
+
+**/
+EFI_STATUS
+HttpDns6Start (
+  IN     HTTP_PROTOCOL            *HttpInstance,
+  IN     CHAR16                   *HostName,
+  IN     EFI_IPv6_ADDRESS         *DnsServer  OPTIONAL,
+     OUT HTTP_DNS6_QUERY          *Query
+  )
+{
+  EFI_STATUS                      Status;
+  EFI_DNS6_CONFIG_DATA            Dns6CfgData;
+  HTTP_SERVICE                    *Service;
+
+  Service = HttpInstance->Service;
 
   //
   // Create a DNS child instance and get the protocol.
   //
   Status = NetLibCreateServiceChild (
              Service->ControllerHandle,
-             Service->Ip4DriverBindingHandle,
-             &gEfiDns4ServiceBindingProtocolGuid,
-             &Dns4Handle
+             Service->Ip6DriverBindingHandle,
+             &gEfiDns6ServiceBindingProtocolGuid,
+             &Query->Handle
              );
   if (EFI_ERROR (Status)) {
-    goto Exit;
+    return Status;
   }
 
   Status = gBS->OpenProtocol (
-                  Dns4Handle,
-                  &gEfiDns4ProtocolGuid,
-                  (VOID **) &Dns4,
-                  Service->Ip4DriverBindingHandle,
+                  Query->Handle,
+                  &gEfiDns6ProtocolGuid,
+                  (VOID **) &Query->Dns6,
+                  Service->Ip6DriverBindingHandle,
                   Service->ControllerHandle,
                   EFI_OPEN_PROTOCOL_BY_DRIVER
                   );
   if (EFI_ERROR (Status)) {
-    goto Exit;
+    Query->Dns6 = NULL;
+    return Status;
   }
 
   //
-  // Configure DNS4 instance for the DNS server address and protocol.
+  // Configure DNS6 instance for the DNS server address and protocol.
   //
-  ZeroMem (&Dns4CfgData, sizeof (Dns4CfgData));
-  Dns4CfgData.DnsServerListCount = DnsServerListCount;
-  Dns4CfgData.DnsServerList      = DnsServerList;
-  Dns4CfgData.UseDefaultSetting  = HttpInstance->IPv4Node.UseDefaultAddress;
-  if (!Dns4CfgData.UseDefaultSetting) {
-    IP4_COPY_ADDRESS (&Dns4CfgData.StationIp, &HttpInstance->IPv4Node.LocalAddress);
-    IP4_COPY_ADDRESS (&Dns4CfgData.SubnetMask, &HttpInstance->IPv4Node.LocalSubnet);
+  ZeroMem (&Dns6CfgData, sizeof (Dns6CfgData));
+  if (DnsServer != NULL) {
+    Dns6CfgData.DnsServerCount = 1;
+    Dns6CfgData.DnsServerList  = DnsServer;
   }
-  Dns4CfgData.EnableDnsCache     = TRUE;
-  Dns4CfgData.Protocol           = EFI_IP_PROTO_UDP;
-  Status = Dns4->Configure (
-                   Dns4,
-                   &Dns4CfgData
-                   );
+  Dns6CfgData.EnableDnsCache = TRUE;
+  Dns6CfgData.Protocol       = EFI_IP_PROTO_UDP;
+  IP6_COPY_ADDRESS (&Dns6CfgData.StationIp, &HttpInstance->Ipv6Node.LocalAddress);
+  Status = Query->Dns6->Configure (
+                          Query->Dns6,
+                          &Dns6CfgData
+                          );
   if (EFI_ERROR (Status)) {
-    goto Exit;
+    return Status;
   }
 
   //
   // Create event to set the is done flag when name resolution is finished.
   //
-  ZeroMem (&Token, sizeof (Token));
   Status = gBS->CreateEvent (
                   EVT_NOTIFY_SIGNAL,
                   TPL_NOTIFY,
                   HttpCommonNotify,
-                  &IsDone,
-                  &Token.Event
+                  &Query->IsDone,
+                  &Query->Token.Event
                   );
   if (EFI_ERROR (Status)) {
-    goto Exit;
+    return Status;
   }
 
   //
   // Start asynchronous name resolution.
   //
-  Token.Status = EFI_NOT_READY;
-  IsDone       = FALSE;
-  Status = Dns4->HostNameToIp (Dns4, HostName, &Token);
+  Query->Token.Status = EFI_NOT_READY;
+  Query->IsDone       = FALSE;
+  Status = Query->Dns6->HostNameToIp (Query->Dns6, HostName, &Query->Token);
   if (EFI_ERROR (Status)) {
-    goto Exit;
+    return Status;
   }
 
-  while (!IsDone) {
-    Dns4->Poll (Dns4);
-  }
+  Query->Pending = TRUE;
+  return EFI_SUCCESS;
+}
 
-  //
-  // Name resolution is done, check result.
-  //
-  Status = Token.Status;
-  if (!EFI_ERROR (Status)) {
-    if (Token.RspData.H2AData == NULL) {
-      Status = EFI_DEVICE_ERROR;
-      goto Exit;
-    }
-    if (Token.RspData.H2AData->IpCount == 0 || Token.RspData.H2AData->IpList == NULL) {
-      Status = EFI_DEVICE_ERROR;
-      goto Exit;
-    }
-    //
-    // We just return the first IP address from DNS protocol.
-    //
-    IP4_COPY_ADDRESS (IpAddress, Token.RspData.H2AData->IpList);
-    Status = EFI_SUCCESS;
-  }
+/**
+  Cancel a host name query started by HttpDns6Start(), if it is still in
+  progress, and free its resources.
 
-Exit:
+  @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
+  @param[in]  Query               The query.
 
-  if (Token.Event != NULL) {
-    gBS->CloseEvent (Token.Event);
-  }
-  if (Token.RspData.H2AData != NULL) {
-    if (Token.RspData.H2AData->IpList != NULL) {
-      FreePool (Token.RspData.H2AData->IpList);
-    }
-    FreePool (Token.RspData.H2AData);
-  }
+**/
+VOID
+HttpDns6Stop (
+  IN     HTTP_PROTOCOL            *HttpInstance,
+  IN     HTTP_DNS6_QUERY          *Query
+  )
+{
+  HTTP_SERVICE                    *Service;
+
+  Service = HttpInstance->Service;
 
-  if (Dns4 != NULL) {
-    Dns4->Configure (Dns4, NULL);
+  //
+  // Reset the instance first, it cancels the token and signals its event.
+  //
+  if (Query->Dns6 != NULL) {
+    Query->Dns6->Configure (Query->Dns6, NULL);
 
     gBS->CloseProtocol (
-           Dns4Handle,
-           &gEfiDns4ProtocolGuid,
-           Service->Ip4DriverBindingHandle,
+           Query->Handle,
+           &gEfiDns6ProtocolGuid,
+           Service->Ip6DriverBindingHandle,
            Service->ControllerHandle
            );
   }
 
-  if (Dns4Handle != NULL) {
+  if (Query->Token.Event != NULL) {
+    gBS->CloseEvent (Query->Token.Event);
+  }
+  if (Query->Token.RspData.H2AData != NULL) {
+    if (Query->Token.RspData.H2AData->IpList != NULL) {
+      FreePool (Query->Token.RspData.H2AData->IpList);
+    }
+    FreePool (Query->Token.RspData.H2AData);
+  }
+
+  if (Query->Handle != NULL) {
     NetLibDestroyServiceChild (
       Service->ControllerHandle,
-      Service->Ip4DriverBindingHandle,
-      &gEfiDns4ServiceBindingProtocolGuid,
-      Dns4Handle
+      Service->Ip6DriverBindingHandle,
+      &gEfiDns6ServiceBindingProtocolGuid,
+      Query->Handle
       );
   }
-
-  if (DnsServerList != NULL) {
-    FreePool (DnsServerList);
-  }
-
-  return Status;
 }
 
 /**
   Retrieve the host address using the EFI_DNS6_PROTOCOL.
 
+  Up to HTTP_DNS_MAX_SERVERS of the configured DNS servers are queried, each
+  one HTTP_DNS_ATTEMPT_DELAY after the previous one or as soon as the previous
+  ones failed, and the first answer is used. A host name in the DNS cache is
+  answered by the first query.
+
   @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
   @param[in]  HostName            Pointer to buffer containing hostname.
   @param[out] IpAddress           On output, pointer to buffer containing IPv6 address.
@@ -232,26 +534,28 @@ HttpDns6 (
   )
 {
   EFI_STATUS                      Status;
+  EFI_STATUS                      Result;
   HTTP_SERVICE                    *Service;
-  EFI_DNS6_PROTOCOL               *Dns6;
-  EFI_DNS6_CONFIG_DATA            Dns6ConfigData;
-  EFI_DNS6_COMPLETION_TOKEN       Token;
-  EFI_HANDLE                      Dns6Handle;
   EFI_IP6_CONFIG_PROTOCOL         *Ip6Config;
-  EFI_IPv6_ADDRESS                *DnsServerList;
   UINTN                           DnsServerListCount;
+  EFI_IPv6_ADDRESS                *DnsServerList;
   UINTN                           DataSize;
-  BOOLEAN                         IsDone;
+  HTTP_DNS6_QUERY                 *Query;
+  HTTP_DNS6_QUERY                 *Winner;
+  UINTN                           QueryCount;
+  UINTN                           Started;
+  UINTN                           Pending;
+  UINTN                           Index;
+  EFI_EVENT                       DelayEvent;
 
 
   Service = HttpInstance->Service;
   ASSERT (Service != NULL);
 
-  DnsServerList       = NULL;
-  DnsServerListCount  = 0;
-  Dns6                = NULL;
-  Dns6Handle          = NULL;
-  ZeroMem (&Token, sizeof (EFI_DNS6_COMPLETION_TOKEN));
+  DnsServerList      = NULL;
+  DnsServerListCount = 0;
+  Query              = NULL;
+  DelayEvent         = NULL;
 
   //
   // Get DNS server list from EFI IPv6 Configuration protocol.
@@ -280,125 +584,111 @@ HttpDns6 (
   }
 
   //
-  // Create a DNSv6 child instance and get the protocol.
+  // Without a DNS server list, a single query takes the servers from DHCP.
   //
-  Status = NetLibCreateServiceChild (
-             Service->ControllerHandle,
-             Service->Ip6DriverBindingHandle,
-             &gEfiDns6ServiceBindingProtocolGuid,
-             &Dns6Handle
-             );
-  if (EFI_ERROR (Status)) {
+  QueryCount = MIN (MAX (DnsServerListCount, 1), HTTP_DNS_MAX_SERVERS);
+  Query      = AllocateZeroPool (QueryCount * sizeof (HTTP_DNS6_QUERY));
+  if (Query == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
     goto Exit;
   }
 
-  Status = gBS->OpenProtocol (
-                  Dns6Handle,
-                  &gEfiDns6ProtocolGuid,
-                  (VOID **) &Dns6,
-                  Service->Ip6DriverBindingHandle,
-                  Service->ControllerHandle,
-                  EFI_OPEN_PROTOCOL_BY_DRIVER
-                  );
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &DelayEvent);
   if (EFI_ERROR (Status)) {
     goto Exit;
   }
 
-  //
-  // Configure DNS6 instance for the DNS server address and protocol.
-  //
-  ZeroMem (&Dns6ConfigData, sizeof (EFI_DNS6_CONFIG_DATA));
-  Dns6ConfigData.DnsServerCount = (UINT32)DnsServerListCount;
-  Dns6ConfigData.DnsServerList  = DnsServerList;
-  Dns6ConfigData.EnableDnsCache = TRUE;
-  Dns6ConfigData.Protocol       = EFI_IP_PROTO_UDP;
-  IP6_COPY_ADDRESS (&Dns6ConfigData.StationIp, &HttpInstance->Ipv6Node.LocalAddress);
-  Status = Dns6->Configure (
-                   Dns6,
-                   &Dns6ConfigData
-                   );
-  if (EFI_ERROR (Status)) {
-    goto Exit;
-  }
+  Result  = EFI_DEVICE_ERROR;
+  Winner  = NULL;
+  Started = 0;
+  Pending = 0;
+  while (Winner == NULL) {
+    //
+    // Query the next server when the others haven't answered in time, or
+    // have all failed.
+    //
+    if ((Started < QueryCount) && ((Pending == 0) || !EFI_ERROR (gBS->CheckEvent (DelayEvent)))) {
+      Status = HttpDns6Start (
+                 HttpInstance,
+                 HostName,
+                 (DnsServerList == NULL) ? NULL : &DnsServerList[Started],
+                 &Query[Started]
+                 );
+      Started++;
+      if (EFI_ERROR (Status)) {
+        Result = Status;
+      } else {
+        Pending++;
+        gBS->SetTimer (DelayEvent, TimerRelative, HTTP_DNS_ATTEMPT_DELAY);
+      }
+    }
 
-  Token.Status = EFI_NOT_READY;
-  IsDone       = FALSE;
-  //
-  // Create event to set the  IsDone flag when name resolution is finished.
-  //
-  Status = gBS->CreateEvent (
-                  EVT_NOTIFY_SIGNAL,
-                  TPL_NOTIFY,
-                  HttpCommonNotify,
-                  &IsDone,
-                  &Token.Event
-                  );
-  if (EFI_ERROR (Status)) {
-    goto Exit;
-  }
+    for (Index = 0; Index < Started; Index++) {
+      if (!Query[Index].Pending) {
+        continue;
+      }
 
-  //
-  // Start asynchronous name resolution.
-  //
-  Status = Dns6->HostNameToIp (Dns6, HostName, &Token);
-  if (EFI_ERROR (Status)) {
-    goto Exit;
-  }
+      if (!Query[Index].IsDone) {
+        Query[Index].Dns6->Poll (Query[Index].Dns6);
+        continue;
+      }
 
-  while (!IsDone) {
-    Dns6->Poll (Dns6);
-  }
+      Query[Index].Pending = FALSE;
+      Pending--;
+
+      //
+      // Name resolution is done, check result.
+      //
+      Status = Query[Index].Token.Status;
+      if (!EFI_ERROR (Status)) {
+        if (Query[Index].Token.RspData.H2AData != NULL &&
+            Query[Index].Token.RspData.H2AData->IpCount != 0 &&
+            Query[Index].Token.RspData.H2AData->IpList != NULL) {
+          Winner = &Query[Index];
+          break;
+        }
+
+        Status = EFI_DEVICE_ERROR;
+      }
 
-  //
-  // Name resolution is done, check result.
-  //
-  Status = Token.Status;
-  if (!EFI_ERROR (Status)) {
-    if (Token.RspData.H2AData == NULL) {
-      Status = EFI_DEVICE_ERROR;
-      goto Exit;
+      Result = Status;
     }
-    if (Token.RspData.H2AData->IpCount == 0 || Token.RspData.H2AData->IpList == NULL) {
-      Status = EFI_DEVICE_ERROR;
-      goto Exit;
+
+    if ((Pending == 0) && (Started == QueryCount)) {
+      break;
     }
+  }
+
+  if (Winner != NULL) {
+    DEBUG ((
+      DEBUG_INFO,
+      "HttpDns6: %s resolved by DNS query %d of %d\n",
+      HostName,
+      Winner - Query + 1,
+      Started
+      ));
+
     //
     // We just return the first IPv6 address from DNS protocol.
     //
-    IP6_COPY_ADDRESS (IpAddress, Token.RspData.H2AData->IpList);
+    IP6_COPY_ADDRESS (IpAddress, Winner->Token.RspData.H2AData->IpList);
     Status = EFI_SUCCESS;
+  } else {
+    Status = Result;
   }
 
 Exit:
 
-  if (Token.Event != NULL) {
-    gBS->CloseEvent (Token.Event);
-  }
-  if (Token.RspData.H2AData != NULL) {
-    if (Token.RspData.H2AData->IpList != NULL) {
-      FreePool (Token.RspData.H2AData->IpList);
-    }
-    FreePool (Token.RspData.H2AData);
+  if (DelayEvent != NULL) {
+    gBS->CloseEvent (DelayEvent);
   }
 
-  if (Dns6 != NULL) {
-    Dns6->Configure (Dns6, NULL);
-
-    gBS->CloseProtocol (
-           Dns6Handle,
-           &gEfiDns6ProtocolGuid,
-           Service->Ip6DriverBindingHandle,
-           Service->ControllerHandle
-           );
-  }
+  if (Query != NULL) {
+    for (Index = 0; Index < QueryCount; Index++) {
+      HttpDns6Stop (HttpInstance, &Query[Index]);
+    }
 
-  if (Dns6Handle != NULL) {
-    NetLibDestroyServiceChild (
-      Service->ControllerHandle,
-      Service->Ip6DriverBindingHandle,
-      &gEfiDns6ServiceBindingProtocolGuid,
-      Dns6Handle
-      );
+    FreePool (Query);
   }
 
   if (DnsServerList != NULL) {
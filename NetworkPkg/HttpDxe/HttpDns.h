@@ -9,9 +9,41 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef __EFI_HTTP_DNS_H__
 #define __EFI_HTTP_DNS_H__
 
+//
+// Most DNS servers queried for a host name, and the delay before the next
+// server is queried while the previous ones haven't answered (the
+// Connection Attempt Delay of RFC 8305), in 100ns units.
+//
+#define HTTP_DNS_MAX_SERVERS         4
+#define HTTP_DNS_ATTEMPT_DELAY       (250 * TICKS_PER_MS)
+
+//
+// A host name query to one DNS server.
+//
+typedef struct {
+  EFI_HANDLE                       Handle;
+  EFI_DNS4_PROTOCOL                *Dns4;
+  EFI_DNS4_COMPLETION_TOKEN        Token;
+  BOOLEAN                          IsDone;   // Set by Token.Event.
+  BOOLEAN                          Pending;  // Started and not checked yet.
+} HTTP_DNS4_QUERY;
+
+typedef struct {
+  EFI_HANDLE                       Handle;
+  EFI_DNS6_PROTOCOL                *Dns6;
+  EFI_DNS6_COMPLETION_TOKEN        Token;
+  BOOLEAN                          IsDone;
+  BOOLEAN                          Pending;
+} HTTP_DNS6_QUERY;
+
 /**
   Retrieve the host address using the EFI_DNS4_PROTOCOL.
 
+  Up to HTTP_DNS_MAX_SERVERS of the configured DNS servers are queried, each
+  one HTTP_DNS_ATTEMPT_DELAY after the previous one or as soon as the previous
+  ones failed, and the first answer is used. A host name in the DNS cache is
+  answered by the first query.
+
   @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
   @param[in]  HostName            Pointer to buffer containing hostname.
   @param[out] IpAddress           On output, pointer to buffer containing IPv4 address.
@@ -32,6 +64,11 @@ HttpDns4 (
 /**
   Retrieve the host address using the EFI_DNS6_PROTOCOL.
 
+  Up to HTTP_DNS_MAX_SERVERS of the configured DNS servers are queried, each
+  one HTTP_DNS_ATTEMPT_DELAY after the previous one or as soon as the previous
+  ones failed, and the first answer is used. A host name in the DNS cache is
+  answered by the first query.
+
   @param[in]  HttpInstance        Pointer to HTTP_PROTOCOL instance.
   @param[in]  HostName            Pointer to buffer containing hostname.
   @param[out] IpAddress           On output, pointer to buffer containing IPv6 address.
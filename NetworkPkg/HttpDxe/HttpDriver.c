@@ -67,6 +67,8 @@ HttpCreateService (
   HttpService->ControllerHandle = Controller;
   HttpService->ChildrenNumber = 0;
   InitializeListHead (&HttpService->ChildrenList);
+  InitializeListHead (&HttpService->KeepAliveList);
+  InitializeListHead (&HttpService->TlsSessionList);
 
   *ServiceData = HttpService;
   return EFI_SUCCESS;
@@ -559,6 +561,7 @@ HttpDxeStop (
                  );
     } else {
 
+      HttpKeepAliveFlush (HttpService, UsingIpv6);
       HttpCleanService (HttpService, UsingIpv6);
 
       if (HttpService->Tcp4ChildHandle == NULL && HttpService->Tcp6ChildHandle == NULL) {
@@ -567,6 +570,10 @@ HttpDxeStop (
                &gEfiHttpServiceBindingProtocolGuid,
                ServiceBinding
                );
+        if (HttpService->KeepAliveTimer != NULL) {
+          gBS->CloseEvent (HttpService->KeepAliveTimer);
+        }
+        TlsFlushSessions (HttpService);
         FreePool (HttpService);
       }
       Status = EFI_SUCCESS;
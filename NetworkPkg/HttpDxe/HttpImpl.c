@@ -367,32 +367,6 @@ EfiHttpRequest (
       return EFI_ACCESS_DENIED;
     }
 
-    //
-    // Check whether we need to create Tls child and open the TLS protocol.
-    //
-    if (HttpInstance->UseHttps && HttpInstance->TlsChildHandle == NULL) {
-      //
-      // Use TlsSb to create Tls child and open the TLS protocol.
-      //
-      if (HttpInstance->LocalAddressIsIPv6) {
-        ImageHandle = HttpInstance->Service->Ip6DriverBindingHandle;
-      } else {
-        ImageHandle = HttpInstance->Service->Ip4DriverBindingHandle;
-      }
-
-      HttpInstance->TlsChildHandle = TlsCreateChild (
-                                       ImageHandle,
-                                       &(HttpInstance->TlsSb),
-                                       &(HttpInstance->Tls),
-                                       &(HttpInstance->TlsConfiguration)
-                                       );
-      if (HttpInstance->TlsChildHandle == NULL) {
-        return EFI_DEVICE_ERROR;
-      }
-
-      TlsConfigure = TRUE;
-    }
-
     UrlParser = NULL;
     Status = HttpParseUrl (Url, (UINT32) AsciiStrLen (Url), FALSE, &UrlParser);
     if (EFI_ERROR (Status)) {
@@ -425,6 +399,39 @@ EfiHttpRequest (
         RemotePort = HTTP_DEFAULT_PORT;
       }
     }
+
+    //
+    // Take over an idle connection to the same host left by another HTTP child, if any.
+    //
+    HttpKeepAliveAdopt (HttpInstance, HostName, RemotePort);
+
+    //
+    // Check whether we need to create Tls child and open the TLS protocol.
+    //
+    if (HttpInstance->UseHttps && HttpInstance->TlsChildHandle == NULL) {
+      //
+      // Use TlsSb to create Tls child and open the TLS protocol.
+      //
+      if (HttpInstance->LocalAddressIsIPv6) {
+        ImageHandle = HttpInstance->Service->Ip6DriverBindingHandle;
+      } else {
+        ImageHandle = HttpInstance->Service->Ip4DriverBindingHandle;
+      }
+
+      HttpInstance->TlsChildHandle = TlsCreateChild (
+                                       ImageHandle,
+                                       &(HttpInstance->TlsSb),
+                                       &(HttpInstance->Tls),
+                                       &(HttpInstance->TlsConfiguration)
+                                       );
+      if (HttpInstance->TlsChildHandle == NULL) {
+        Status = EFI_DEVICE_ERROR;
+        goto Error1;
+      }
+
+      TlsConfigure = TRUE;
+    }
+
     //
     // If Configure is TRUE, it indicates the first time to call Request();
     // If ReConfigure is TRUE, it indicates the request URL is not same
@@ -983,6 +990,7 @@ HttpResponseWorker (
   HTTP_TOKEN_WRAP               *ValueInItem;
   UINTN                         HdrLen;
   NET_FRAGMENT                  Fragment;
+  EFI_HTTP_HEADER               *Header;
 
   if (Wrap == NULL || Wrap->HttpInstance == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -1100,6 +1108,11 @@ HttpResponseWorker (
 
     StatusCode = AsciiStrDecimalToUintn (StatusCodeStr);
 
+    //
+    // A HTTP/1.0 server closes the connection after the response by default.
+    //
+    HttpInstance->ConnectionClose = (BOOLEAN) (AsciiStrnCmp (HttpHeaders, "HTTP/1.0", AsciiStrLen ("HTTP/1.0")) == 0);
+
     //
     // Remove the first line of HTTP message, e.g. "HTTP/1.1 200 OK\r\n".
     //
@@ -1185,6 +1198,11 @@ HttpResponseWorker (
       FreePool (HttpHeaders);
       HttpHeaders = NULL;
 
+      Header = HttpFindHeader (HttpMsg->HeaderCount, HttpMsg->Headers, HTTP_HEADER_CONNECTION);
+      if ((Header != NULL) && (AsciiStrCaseStr (Header->FieldValue, HTTP_HEADER_CONNECTION_CLOSE) != NULL)) {
+        HttpInstance->ConnectionClose = TRUE;
+      }
+
 
       //
       // Init message-body parser by header information.
@@ -0,0 +1,580 @@
+/** @file
+  Keep-alive connection pool of HttpDxe driver.
+
+  HTTP children are often created for a few requests to the same host and
+  destroyed again, e.g. by HTTP boot and REST EX clients. Rather than closing
+  the connection of such a child, an idle connection is kept alive in the HTTP
+  service for a while, and a new child requesting the same host takes it over,
+  which saves the TCP three-way handshake and, for HTTPS, the TLS handshake.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "HttpDriver.h"
+
+/**
+  Check whether the TCP connection of an idle connection is still established.
+
+  @param[in]  Conn               The idle connection.
+
+  @retval TRUE                   The TCP connection is established.
+  @retval FALSE                  The TCP connection is closed, or being closed.
+
+**/
+BOOLEAN
+HttpKeepAliveIsEstablished (
+  IN HTTP_KEEP_ALIVE_CONN     *Conn
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_TCP4_CONNECTION_STATE   Tcp4State;
+  EFI_TCP6_CONNECTION_STATE   Tcp6State;
+
+  if (!Conn->LocalAddressIsIPv6) {
+    Status = Conn->Tcp4->GetModeData (Conn->Tcp4, &Tcp4State, NULL, NULL, NULL, NULL);
+    return (BOOLEAN) (!EFI_ERROR (Status) && (Tcp4State == Tcp4StateEstablished));
+  } else {
+    Status = Conn->Tcp6->GetModeData (Conn->Tcp6, &Tcp6State, NULL, NULL, NULL, NULL);
+    return (BOOLEAN) (!EFI_ERROR (Status) && (Tcp6State == Tcp6StateEstablished));
+  }
+}
+
+/**
+  Abort an idle connection, and release the TCP child and the TLS child.
+
+  The connection must have been removed from the KeepAliveList of the service.
+
+  @param[in]  HttpService        The HTTP service.
+  @param[in]  Conn               The idle connection.
+
+**/
+VOID
+HttpKeepAliveClose (
+  IN HTTP_SERVICE             *HttpService,
+  IN HTTP_KEEP_ALIVE_CONN     *Conn
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_EVENT                   Event;
+  BOOLEAN                     IsCloseDone;
+  EFI_TCP4_CLOSE_TOKEN        Tcp4CloseToken;
+  EFI_TCP6_CLOSE_TOKEN        Tcp6CloseToken;
+
+  //
+  // Abort the TCP connection like HttpCloseConnection() does.
+  //
+  IsCloseDone = FALSE;
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  HttpCommonNotify,
+                  &IsCloseDone,
+                  &Event
+                  );
+  if (!EFI_ERROR (Status)) {
+    if (!Conn->LocalAddressIsIPv6) {
+      Tcp4CloseToken.CompletionToken.Event = Event;
+      Tcp4CloseToken.AbortOnClose          = TRUE;
+      Status = Conn->Tcp4->Close (Conn->Tcp4, &Tcp4CloseToken);
+      while (!EFI_ERROR (Status) && !IsCloseDone) {
+        Conn->Tcp4->Poll (Conn->Tcp4);
+      }
+    } else {
+      Tcp6CloseToken.CompletionToken.Event = Event;
+      Tcp6CloseToken.AbortOnClose          = TRUE;
+      Status = Conn->Tcp6->Close (Conn->Tcp6, &Tcp6CloseToken);
+      while (!EFI_ERROR (Status) && !IsCloseDone) {
+        Conn->Tcp6->Poll (Conn->Tcp6);
+      }
+    }
+
+    gBS->CloseEvent (Event);
+  }
+
+  if (Conn->TlsChildHandle != NULL) {
+    Conn->TlsSb->DestroyChild (Conn->TlsSb, Conn->TlsChildHandle);
+  }
+
+  if (!Conn->LocalAddressIsIPv6) {
+    gBS->CloseProtocol (
+           Conn->TcpChildHandle,
+           &gEfiTcp4ProtocolGuid,
+           HttpService->Ip4DriverBindingHandle,
+           HttpService->ControllerHandle
+           );
+
+    NetLibDestroyServiceChild (
+      HttpService->ControllerHandle,
+      HttpService->Ip4DriverBindingHandle,
+      &gEfiTcp4ServiceBindingProtocolGuid,
+      Conn->TcpChildHandle
+      );
+  } else {
+    gBS->CloseProtocol (
+           Conn->TcpChildHandle,
+           &gEfiTcp6ProtocolGuid,
+           HttpService->Ip6DriverBindingHandle,
+           HttpService->ControllerHandle
+           );
+
+    NetLibDestroyServiceChild (
+      HttpService->ControllerHandle,
+      HttpService->Ip6DriverBindingHandle,
+      &gEfiTcp6ServiceBindingProtocolGuid,
+      Conn->TcpChildHandle
+      );
+  }
+
+  FreePool (Conn->RemoteHost);
+  FreePool (Conn);
+}
+
+/**
+  The timer notify function to close the idle connections which have timed
+  out, or have been closed by the server.
+
+  @param[in]  Event              The timer event.
+  @param[in]  Context            The HTTP service.
+
+**/
+VOID
+EFIAPI
+HttpKeepAliveTimerTicking (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  HTTP_SERVICE                *HttpService;
+  HTTP_KEEP_ALIVE_CONN        *Conn;
+  LIST_ENTRY                  *Entry;
+  LIST_ENTRY                  *Next;
+
+  HttpService = (HTTP_SERVICE *) Context;
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &HttpService->KeepAliveList) {
+    Conn = NET_LIST_USER_STRUCT (Entry, HTTP_KEEP_ALIVE_CONN, Link);
+    Conn->IdleTime++;
+
+    if ((Conn->IdleTime >= PcdGet32 (PcdHttpKeepAliveTimeout)) || !HttpKeepAliveIsEstablished (Conn)) {
+      RemoveEntryList (&Conn->Link);
+      HttpService->KeepAliveNumber--;
+      HttpKeepAliveClose (HttpService, Conn);
+    }
+  }
+
+  if (HttpService->KeepAliveNumber == 0) {
+    gBS->SetTimer (HttpService->KeepAliveTimer, TimerCancel, 0);
+  }
+}
+
+/**
+  Keep the connection of a HTTP child alive after the child is reset or
+  destroyed, if the connection is idle and can be used for another request.
+
+  On success, the TCP child, the TLS child and the remote host are taken over
+  from the HTTP child, and the HTTP child is left in HTTP_STATE_TCP_CLOSED
+  state, so that cleaning it up doesn't close the connection.
+
+  @param[in, out]  HttpInstance       The HTTP child to clean up.
+
+  @retval EFI_SUCCESS            The connection is kept alive.
+  @retval EFI_UNSUPPORTED        The connection can't be reused.
+  @retval Others                 Other error as indicated.
+
+**/
+EFI_STATUS
+HttpKeepAlivePark (
+  IN OUT HTTP_PROTOCOL        *HttpInstance
+  )
+{
+  HTTP_SERVICE                *HttpService;
+  HTTP_KEEP_ALIVE_CONN        *Conn;
+  HTTP_KEEP_ALIVE_CONN        *Oldest;
+  EFI_STATUS                  Status;
+  EFI_TPL                     OldTpl;
+
+  HttpService = HttpInstance->Service;
+
+  //
+  // Only a connection which has completed all the requests and responses,
+  // with nothing left in the cache, can be used by another HTTP child.
+  //
+  if ((PcdGet8 (PcdHttpKeepAliveConnections) == 0) ||
+      (HttpInstance->State != HTTP_STATE_TCP_CONNECTED) ||
+      (HttpInstance->RemoteHost == NULL) ||
+      HttpInstance->ConnectionClose ||
+      !NetMapIsEmpty (&HttpInstance->TxTokens) ||
+      !NetMapIsEmpty (&HttpInstance->RxTokens) ||
+      (HttpInstance->CacheBody != NULL) ||
+      (HttpInstance->MsgParser != NULL)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (HttpInstance->UseHttps &&
+      ((HttpInstance->TlsChildHandle == NULL) || (HttpInstance->TlsSessionState != EfiTlsSessionDataTransferring))) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Conn = AllocateZeroPool (sizeof (HTTP_KEEP_ALIVE_CONN));
+  if (Conn == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Conn->LocalAddressIsIPv6 = HttpInstance->LocalAddressIsIPv6;
+  Conn->UseHttps           = HttpInstance->UseHttps;
+  Conn->Tcp4               = HttpInstance->Tcp4;
+  Conn->Tcp6               = HttpInstance->Tcp6;
+  if (!HttpKeepAliveIsEstablished (Conn)) {
+    FreePool (Conn);
+    return EFI_UNSUPPORTED;
+  }
+
+  if (HttpService->KeepAliveTimer == NULL) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    HttpKeepAliveTimerTicking,
+                    HttpService,
+                    &HttpService->KeepAliveTimer
+                    );
+    if (EFI_ERROR (Status)) {
+      FreePool (Conn);
+      return Status;
+    }
+  }
+
+  CopyMem (&Conn->IPv4Node, &HttpInstance->IPv4Node, sizeof (Conn->IPv4Node));
+  CopyMem (&Conn->Ipv6Node, &HttpInstance->Ipv6Node, sizeof (Conn->Ipv6Node));
+  Conn->RemoteHost = HttpInstance->RemoteHost;
+  Conn->RemotePort = HttpInstance->RemotePort;
+  IP4_COPY_ADDRESS (&Conn->RemoteAddr, &HttpInstance->RemoteAddr);
+  IP6_COPY_ADDRESS (&Conn->RemoteIpv6Addr, &HttpInstance->RemoteIpv6Addr);
+
+  //
+  // The TCP child stays opened BY_DRIVER for the controller, only the child
+  // controller it's opened for goes away with the HTTP child.
+  //
+  if (!HttpInstance->LocalAddressIsIPv6) {
+    Conn->TcpChildHandle = HttpInstance->Tcp4ChildHandle;
+    gBS->CloseProtocol (
+           HttpInstance->Tcp4ChildHandle,
+           &gEfiTcp4ProtocolGuid,
+           HttpService->Ip4DriverBindingHandle,
+           HttpInstance->Handle
+           );
+    HttpInstance->Tcp4ChildHandle = NULL;
+    HttpInstance->Tcp4            = NULL;
+  } else {
+    Conn->TcpChildHandle = HttpInstance->Tcp6ChildHandle;
+    gBS->CloseProtocol (
+           HttpInstance->Tcp6ChildHandle,
+           &gEfiTcp6ProtocolGuid,
+           HttpService->Ip6DriverBindingHandle,
+           HttpInstance->Handle
+           );
+    HttpInstance->Tcp6ChildHandle = NULL;
+    HttpInstance->Tcp6            = NULL;
+  }
+
+  if (HttpInstance->UseHttps) {
+    Conn->TlsSb            = HttpInstance->TlsSb;
+    Conn->TlsChildHandle   = HttpInstance->TlsChildHandle;
+    Conn->Tls              = HttpInstance->Tls;
+    Conn->TlsConfiguration = HttpInstance->TlsConfiguration;
+    HttpInstance->TlsChildHandle   = NULL;
+    HttpInstance->Tls              = NULL;
+    HttpInstance->TlsConfiguration = NULL;
+    HttpInstance->TlsSessionState  = EfiTlsSessionNotStarted;
+  }
+
+  HttpInstance->RemoteHost = NULL;
+  HttpInstance->RemotePort = 0;
+  HttpInstance->State      = HTTP_STATE_TCP_CLOSED;
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  //
+  // Make room by closing the connection idle for the longest time.
+  //
+  if (HttpService->KeepAliveNumber >= PcdGet8 (PcdHttpKeepAliveConnections)) {
+    Oldest = NET_LIST_HEAD (&HttpService->KeepAliveList, HTTP_KEEP_ALIVE_CONN, Link);
+    RemoveEntryList (&Oldest->Link);
+    HttpService->KeepAliveNumber--;
+    HttpKeepAliveClose (HttpService, Oldest);
+  }
+
+  InsertTailList (&HttpService->KeepAliveList, &Conn->Link);
+  HttpService->KeepAliveNumber++;
+  gBS->SetTimer (HttpService->KeepAliveTimer, TimerPeriodic, HTTP_KEEP_ALIVE_TIMER_PERIOD);
+
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Take over an idle connection to the remote host, if any, for the first
+  request of a configured HTTP child.
+
+  On success, the HTTP child is in HTTP_STATE_TCP_CONNECTED state, with the
+  RemoteHost and RemotePort of the connection, so that Request() continues as
+  for the next request to the same host.
+
+  @param[in, out]  HttpInstance       The HTTP child.
+  @param[in]       HostName           The host name of the request URL.
+  @param[in]       RemotePort         The port number of the request URL.
+
+  @retval EFI_SUCCESS            An idle connection is taken over.
+  @retval EFI_NOT_FOUND          There is no idle connection to the remote host.
+  @retval Others                 Other error as indicated.
+
+**/
+EFI_STATUS
+HttpKeepAliveAdopt (
+  IN OUT HTTP_PROTOCOL        *HttpInstance,
+  IN     CHAR8                *HostName,
+  IN     UINT16               RemotePort
+  )
+{
+  HTTP_SERVICE                *HttpService;
+  HTTP_KEEP_ALIVE_CONN        *Conn;
+  HTTP_KEEP_ALIVE_CONN        *Found;
+  LIST_ENTRY                  *Entry;
+  EFI_STATUS                  Status;
+  EFI_TPL                     OldTpl;
+
+  HttpService = HttpInstance->Service;
+
+  if ((HttpInstance->State != HTTP_STATE_HTTP_CONFIGED) ||
+      (HttpInstance->RemoteHost != NULL) ||
+      (HttpInstance->TlsChildHandle != NULL)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Take the most recently used connection out of the list, so that the
+  // timer doesn't close it while it's being taken over.
+  //
+  Found  = NULL;
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  Entry = HttpService->KeepAliveList.BackLink;
+  while (Entry != &HttpService->KeepAliveList) {
+    Conn  = NET_LIST_USER_STRUCT (Entry, HTTP_KEEP_ALIVE_CONN, Link);
+    Entry = Entry->BackLink;
+    if ((Conn->LocalAddressIsIPv6 != HttpInstance->LocalAddressIsIPv6) ||
+        (Conn->UseHttps != HttpInstance->UseHttps) ||
+        (Conn->RemotePort != RemotePort) ||
+        (AsciiStrCmp (Conn->RemoteHost, HostName) != 0)) {
+      continue;
+    }
+
+    if (!Conn->LocalAddressIsIPv6) {
+      if (CompareMem (&Conn->IPv4Node, &HttpInstance->IPv4Node, sizeof (Conn->IPv4Node)) != 0) {
+        continue;
+      }
+    } else {
+      if (CompareMem (&Conn->Ipv6Node, &HttpInstance->Ipv6Node, sizeof (Conn->Ipv6Node)) != 0) {
+        continue;
+      }
+    }
+
+    RemoveEntryList (&Conn->Link);
+    HttpService->KeepAliveNumber--;
+
+    if (HttpKeepAliveIsEstablished (Conn)) {
+      Found = Conn;
+      break;
+    }
+
+    HttpKeepAliveClose (HttpService, Conn);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Found == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Conn = Found;
+
+  //
+  // Create the events of the HTTP child, which refer to the child itself.
+  //
+  Status = HttpCreateTcpConnCloseEvent (HttpInstance);
+  if (EFI_ERROR (Status)) {
+    HttpKeepAliveClose (HttpService, Conn);
+    return Status;
+  }
+
+  if (Conn->UseHttps) {
+    Status = TlsCreateTxRxEvent (HttpInstance);
+    if (EFI_ERROR (Status)) {
+      HttpCloseTcpConnCloseEvent (HttpInstance);
+      HttpKeepAliveClose (HttpService, Conn);
+      return Status;
+    }
+  }
+
+  //
+  // Replace the unconnected TCP child created by Configure() with the one of
+  // the connection.
+  //
+  if (!Conn->LocalAddressIsIPv6) {
+    Status = gBS->OpenProtocol (
+                    Conn->TcpChildHandle,
+                    &gEfiTcp4ProtocolGuid,
+                    (VOID **) &Conn->Tcp4,
+                    HttpService->Ip4DriverBindingHandle,
+                    HttpInstance->Handle,
+                    EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
+                    );
+  } else {
+    Status = gBS->OpenProtocol (
+                    Conn->TcpChildHandle,
+                    &gEfiTcp6ProtocolGuid,
+                    (VOID **) &Conn->Tcp6,
+                    HttpService->Ip6DriverBindingHandle,
+                    HttpInstance->Handle,
+                    EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
+                    );
+  }
+
+  if (EFI_ERROR (Status)) {
+    if (Conn->UseHttps) {
+      TlsCloseTxRxEvent (HttpInstance);
+    }
+    HttpCloseTcpConnCloseEvent (HttpInstance);
+    HttpKeepAliveClose (HttpService, Conn);
+    return Status;
+  }
+
+  if (!Conn->LocalAddressIsIPv6) {
+    if (HttpInstance->Tcp4ChildHandle != NULL) {
+      gBS->CloseProtocol (
+             HttpInstance->Tcp4ChildHandle,
+             &gEfiTcp4ProtocolGuid,
+             HttpService->Ip4DriverBindingHandle,
+             HttpService->ControllerHandle
+             );
+
+      gBS->CloseProtocol (
+             HttpInstance->Tcp4ChildHandle,
+             &gEfiTcp4ProtocolGuid,
+             HttpService->Ip4DriverBindingHandle,
+             HttpInstance->Handle
+             );
+
+      NetLibDestroyServiceChild (
+        HttpService->ControllerHandle,
+        HttpService->Ip4DriverBindingHandle,
+        &gEfiTcp4ServiceBindingProtocolGuid,
+        HttpInstance->Tcp4ChildHandle
+        );
+    }
+
+    HttpInstance->Tcp4ChildHandle = Conn->TcpChildHandle;
+    HttpInstance->Tcp4            = Conn->Tcp4;
+    IP4_COPY_ADDRESS (&HttpInstance->RemoteAddr, &Conn->RemoteAddr);
+  } else {
+    if (HttpInstance->Tcp6ChildHandle != NULL) {
+      gBS->CloseProtocol (
+             HttpInstance->Tcp6ChildHandle,
+             &gEfiTcp6ProtocolGuid,
+             HttpService->Ip6DriverBindingHandle,
+             HttpService->ControllerHandle
+             );
+
+      gBS->CloseProtocol (
+             HttpInstance->Tcp6ChildHandle,
+             &gEfiTcp6ProtocolGuid,
+             HttpService->Ip6DriverBindingHandle,
+             HttpInstance->Handle
+             );
+
+      NetLibDestroyServiceChild (
+        HttpService->ControllerHandle,
+        HttpService->Ip6DriverBindingHandle,
+        &gEfiTcp6ServiceBindingProtocolGuid,
+        HttpInstance->Tcp6ChildHandle
+        );
+    }
+
+    HttpInstance->Tcp6ChildHandle = Conn->TcpChildHandle;
+    HttpInstance->Tcp6            = Conn->Tcp6;
+    IP6_COPY_ADDRESS (&HttpInstance->RemoteIpv6Addr, &Conn->RemoteIpv6Addr);
+  }
+
+  if (Conn->UseHttps) {
+    HttpInstance->TlsSb            = Conn->TlsSb;
+    HttpInstance->TlsChildHandle   = Conn->TlsChildHandle;
+    HttpInstance->Tls              = Conn->Tls;
+    HttpInstance->TlsConfiguration = Conn->TlsConfiguration;
+    HttpInstance->TlsSessionState  = EfiTlsSessionDataTransferring;
+    HttpService->TlsHandshakesAvoided++;
+  }
+
+  HttpInstance->RemoteHost      = Conn->RemoteHost;
+  HttpInstance->RemotePort      = Conn->RemotePort;
+  HttpInstance->ConnectionClose = FALSE;
+  HttpInstance->State           = HTTP_STATE_TCP_CONNECTED;
+  HttpService->ConnectionsReused++;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "HttpKeepAliveAdopt: reuse connection to %a:%d idle for %ds, %d reused, %d TLS handshake(s) avoided\n",
+    Conn->RemoteHost,
+    Conn->RemotePort,
+    Conn->IdleTime,
+    HttpService->ConnectionsReused,
+    HttpService->TlsHandshakesAvoided
+    ));
+
+  FreePool (Conn);
+  return EFI_SUCCESS;
+}
+
+/**
+  Close the idle connections of the HTTP service over TCP4 or TCP6.
+
+  @param[in]  HttpService        The HTTP service.
+  @param[in]  UsingIpv6          Close the connections over TCP6 if TRUE,
+                                 over TCP4 otherwise.
+
+**/
+VOID
+HttpKeepAliveFlush (
+  IN HTTP_SERVICE             *HttpService,
+  IN BOOLEAN                  UsingIpv6
+  )
+{
+  HTTP_KEEP_ALIVE_CONN        *Conn;
+  LIST_ENTRY                  *Entry;
+  LIST_ENTRY                  *Next;
+  EFI_TPL                     OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &HttpService->KeepAliveList) {
+    Conn = NET_LIST_USER_STRUCT (Entry, HTTP_KEEP_ALIVE_CONN, Link);
+    if (Conn->LocalAddressIsIPv6 == UsingIpv6) {
+      RemoveEntryList (&Conn->Link);
+      HttpService->KeepAliveNumber--;
+      HttpKeepAliveClose (HttpService, Conn);
+    }
+  }
+
+  if ((HttpService->KeepAliveNumber == 0) && (HttpService->KeepAliveTimer != NULL)) {
+    gBS->SetTimer (HttpService->KeepAliveTimer, TimerCancel, 0);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "HttpKeepAliveFlush: %d connection(s) reused, %d TLS handshake(s) avoided\n",
+    HttpService->ConnectionsReused,
+    HttpService->TlsHandshakesAvoided
+    ));
+}
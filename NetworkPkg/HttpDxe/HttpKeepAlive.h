@@ -0,0 +1,102 @@
+/** @file
+  The header files of the keep-alive connection pool of HttpDxe driver.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EFI_HTTP_KEEP_ALIVE_H__
+#define __EFI_HTTP_KEEP_ALIVE_H__
+
+//
+// Period of the timer checking the idle connections.
+//
+#define HTTP_KEEP_ALIVE_TIMER_PERIOD  TICKS_PER_SECOND
+
+//
+// An idle connection, with the TCP child and the TLS child, if any, taken
+// over from a HTTP child.
+//
+typedef struct {
+  LIST_ENTRY                       Link;
+  BOOLEAN                          LocalAddressIsIPv6;
+  BOOLEAN                          UseHttps;
+  EFI_HTTPv4_ACCESS_POINT          IPv4Node;
+  EFI_HTTPv6_ACCESS_POINT          Ipv6Node;
+
+  CHAR8                            *RemoteHost;
+  UINT16                           RemotePort;
+  EFI_IPv4_ADDRESS                 RemoteAddr;
+  EFI_IPv6_ADDRESS                 RemoteIpv6Addr;
+
+  EFI_HANDLE                       TcpChildHandle;
+  EFI_TCP4_PROTOCOL                *Tcp4;
+  EFI_TCP6_PROTOCOL                *Tcp6;
+
+  EFI_SERVICE_BINDING_PROTOCOL     *TlsSb;
+  EFI_HANDLE                       TlsChildHandle;
+  EFI_TLS_PROTOCOL                 *Tls;
+  EFI_TLS_CONFIGURATION_PROTOCOL   *TlsConfiguration;
+
+  UINT32                           IdleTime;  // In seconds.
+} HTTP_KEEP_ALIVE_CONN;
+
+/**
+  Keep the connection of a HTTP child alive after the child is reset or
+  destroyed, if the connection is idle and can be used for another request.
+
+  On success, the TCP child, the TLS child and the remote host are taken over
+  from the HTTP child, and the HTTP child is left in HTTP_STATE_TCP_CLOSED
+  state, so that cleaning it up doesn't close the connection.
+
+  @param[in, out]  HttpInstance       The HTTP child to clean up.
+
+  @retval EFI_SUCCESS            The connection is kept alive.
+  @retval EFI_UNSUPPORTED        The connection can't be reused.
+  @retval Others                 Other error as indicated.
+
+**/
+EFI_STATUS
+HttpKeepAlivePark (
+  IN OUT HTTP_PROTOCOL        *HttpInstance
+  );
+
+/**
+  Take over an idle connection to the remote host, if any, for the first
+  request of a configured HTTP child.
+
+  On success, the HTTP child is in HTTP_STATE_TCP_CONNECTED state, with the
+  RemoteHost and RemotePort of the connection, so that Request() continues as
+  for the next request to the same host.
+
+  @param[in, out]  HttpInstance       The HTTP child.
+  @param[in]       HostName           The host name of the request URL.
+  @param[in]       RemotePort         The port number of the request URL.
+
+  @retval EFI_SUCCESS            An idle connection is taken over.
+  @retval EFI_NOT_FOUND          There is no idle connection to the remote host.
+  @retval Others                 Other error as indicated.
+
+**/
+EFI_STATUS
+HttpKeepAliveAdopt (
+  IN OUT HTTP_PROTOCOL        *HttpInstance,
+  IN     CHAR8                *HostName,
+  IN     UINT16               RemotePort
+  );
+
+/**
+  Close the idle connections of the HTTP service over TCP4 or TCP6.
+
+  @param[in]  HttpService        The HTTP service.
+  @param[in]  UsingIpv6          Close the connections over TCP6 if TRUE,
+                                 over TCP4 otherwise.
+
+**/
+VOID
+HttpKeepAliveFlush (
+  IN HTTP_SERVICE             *HttpService,
+  IN BOOLEAN                  UsingIpv6
+  );
+
+#endif
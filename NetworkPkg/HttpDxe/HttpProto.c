@@ -835,6 +835,11 @@ HttpCleanProtocol (
   IN  HTTP_PROTOCOL          *HttpInstance
   )
 {
+  //
+  // Keep an idle connection alive for the next HTTP child instead of closing it.
+  //
+  HttpKeepAlivePark (HttpInstance);
+
   HttpCloseConnection (HttpInstance);
 
   HttpCloseTcpConnCloseEvent (HttpInstance);
@@ -1103,9 +1108,18 @@ HttpConfigureTcp4 (
   Tcp4Option->KeepAliveTime          = HTTP_KEEP_ALIVE_TIME;
   Tcp4Option->KeepAliveInterval      = HTTP_KEEP_ALIVE_INTERVAL;
   Tcp4Option->EnableNagle            = TRUE;
+  Tcp4Option->EnableSelectiveAck     = TRUE;
   Tcp4CfgData->ControlOption         = Tcp4Option;
 
   Status = HttpInstance->Tcp4->Configure (HttpInstance->Tcp4, Tcp4CfgData);
+  if (Status == EFI_UNSUPPORTED) {
+    //
+    // TCP drivers that predate SACK reject EnableSelectiveAck, so fall back
+    // to a connection without it.
+    //
+    Tcp4Option->EnableSelectiveAck = FALSE;
+    Status = HttpInstance->Tcp4->Configure (HttpInstance->Tcp4, Tcp4CfgData);
+  }
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "HttpConfigureTcp4 - %r\n", Status));
     return Status;
@@ -1174,8 +1188,17 @@ HttpConfigureTcp6 (
   Tcp6Option->KeepAliveTime      = HTTP_KEEP_ALIVE_TIME;
   Tcp6Option->KeepAliveInterval  = HTTP_KEEP_ALIVE_INTERVAL;
   Tcp6Option->EnableNagle        = TRUE;
+  Tcp6Option->EnableSelectiveAck = TRUE;
 
   Status = HttpInstance->Tcp6->Configure (HttpInstance->Tcp6, Tcp6CfgData);
+  if (Status == EFI_UNSUPPORTED) {
+    //
+    // TCP drivers that predate SACK reject EnableSelectiveAck, so fall back
+    // to a connection without it.
+    //
+    Tcp6Option->EnableSelectiveAck = FALSE;
+    Status = HttpInstance->Tcp6->Configure (HttpInstance->Tcp6, Tcp6CfgData);
+  }
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "HttpConfigureTcp6 - %r\n", Status));
     return Status;
@@ -1719,6 +1742,7 @@ HttpTcpTransmit (
   EFI_STATUS                Status;
   CHAR8                     *RequestMsg;
   CHAR8                     *Url;
+  CHAR8                     *FileUrl;
   UINTN                     UrlSize;
   UINTN                     RequestMsgSize;
 
@@ -1740,12 +1764,27 @@ HttpTcpTransmit (
 
   UnicodeStrToAsciiStrS (ValueInItem->HttpToken->Message->Data.Request->Url, Url, UrlSize);
 
+  //
+  // Convert the absolute-URI to the absolute-path as Request() does, some
+  // servers don't accept the absolute-URI of the pipelined requests.
+  //
+  FileUrl = Url;
+  if (*FileUrl != '/') {
+    FileUrl = AsciiStrStr (Url, "://");
+    if (FileUrl != NULL) {
+      FileUrl = AsciiStrStr (FileUrl + AsciiStrLen ("://"), "/");
+    }
+    if (FileUrl == NULL) {
+      FileUrl = Url;
+    }
+  }
+
   //
   // Create request message.
   //
   Status = HttpGenRequestMessage (
                  ValueInItem->HttpToken->Message,
-                 Url,
+                 FileUrl,
                  &RequestMsg,
                  &RequestMsgSize
                  );
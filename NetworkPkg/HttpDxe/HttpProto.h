@@ -61,6 +61,21 @@ typedef struct _HTTP_SERVICE {
   LIST_ENTRY                    ChildrenList;
   UINTN                         ChildrenNumber;
   INTN                          State;
+
+  //
+  // Idle connections kept alive for the next HTTP child, see HttpKeepAlive.c.
+  //
+  LIST_ENTRY                    KeepAliveList;
+  UINTN                         KeepAliveNumber;
+  EFI_EVENT                     KeepAliveTimer;
+  UINTN                         ConnectionsReused;
+  UINTN                         TlsHandshakesAvoided;
+
+  //
+  // IDs of the TLS sessions to resume, see TlsOfferSession().
+  //
+  LIST_ENTRY                    TlsSessionList;
+  UINTN                         TlsSessionNumber;
 } HTTP_SERVICE;
 
 typedef struct {
@@ -106,6 +121,7 @@ typedef struct _HTTP_PROTOCOL {
   EFI_HTTP_METHOD               Method;
 
   UINTN                         StatusCode;
+  BOOLEAN                       ConnectionClose;  // The server closes the connection after the response.
 
   EFI_EVENT                     TimeoutEvent;
 
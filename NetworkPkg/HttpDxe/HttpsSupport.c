@@ -1107,6 +1107,188 @@ ON_EXIT:
   return Status;
 }
 
+/**
+  Find the TLS session ID remembered for a remote host.
+
+  @param[in]  HttpService        The HTTP service.
+  @param[in]  RemoteHost         The name of the remote host.
+  @param[in]  RemotePort         The port number of the remote host.
+
+  @return The remembered session ID, or NULL if not found.
+
+**/
+HTTP_TLS_SESSION *
+TlsFindSession (
+  IN  HTTP_SERVICE             *HttpService,
+  IN  CHAR8                    *RemoteHost,
+  IN  UINT16                   RemotePort
+  )
+{
+  HTTP_TLS_SESSION             *Session;
+  LIST_ENTRY                   *Entry;
+
+  NET_LIST_FOR_EACH (Entry, &HttpService->TlsSessionList) {
+    Session = NET_LIST_USER_STRUCT (Entry, HTTP_TLS_SESSION, Link);
+    if ((Session->RemotePort == RemotePort) && (AsciiStrCmp (Session->RemoteHost, RemoteHost) == 0)) {
+      return Session;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Forget one TLS session ID remembered by the HTTP service.
+
+  @param[in]  HttpService        The HTTP service.
+  @param[in]  Session            The session ID to forget.
+
+**/
+VOID
+TlsFlushSession (
+  IN  HTTP_SERVICE             *HttpService,
+  IN  HTTP_TLS_SESSION         *Session
+  )
+{
+  RemoveEntryList (&Session->Link);
+  HttpService->TlsSessionNumber--;
+  FreePool (Session->RemoteHost);
+  FreePool (Session);
+}
+
+/**
+  Offer the TLS session last established with the remote host of the HTTP
+  instance, if any, so that TlsDxe resumes it instead of a full handshake.
+
+  @param[in]  HttpInstance       The HTTP instance private data.
+
+**/
+VOID
+EFIAPI
+TlsOfferSession (
+  IN  HTTP_PROTOCOL            *HttpInstance
+  )
+{
+  HTTP_TLS_SESSION             *Session;
+  EFI_STATUS                   Status;
+
+  if (HttpInstance->RemoteHost == NULL) {
+    return;
+  }
+
+  Session = TlsFindSession (HttpInstance->Service, HttpInstance->RemoteHost, HttpInstance->RemotePort);
+  if (Session == NULL) {
+    return;
+  }
+
+  //
+  // TlsDxe does a full handshake if the session has expired meanwhile.
+  //
+  Status = HttpInstance->Tls->SetSessionData (
+                                HttpInstance->Tls,
+                                EfiTlsSessionID,
+                                &Session->SessionId,
+                                sizeof (EFI_TLS_SESSION_ID)
+                                );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "TlsOfferSession: %a:%d not resumed - %r\n", Session->RemoteHost, Session->RemotePort, Status));
+  }
+}
+
+/**
+  Remember the ID of the TLS session established by the handshake, for the
+  next connection to the same remote host to resume it.
+
+  @param[in]  HttpInstance       The HTTP instance private data.
+
+**/
+VOID
+EFIAPI
+TlsSaveSession (
+  IN  HTTP_PROTOCOL            *HttpInstance
+  )
+{
+  HTTP_SERVICE                 *HttpService;
+  HTTP_TLS_SESSION             *Session;
+  EFI_TLS_SESSION_ID           SessionId;
+  UINTN                        SessionIdSize;
+  EFI_STATUS                   Status;
+
+  HttpService = HttpInstance->Service;
+  if (HttpInstance->RemoteHost == NULL) {
+    return;
+  }
+
+  SessionIdSize = sizeof (EFI_TLS_SESSION_ID);
+  Status = HttpInstance->Tls->GetSessionData (
+                                HttpInstance->Tls,
+                                EfiTlsSessionID,
+                                &SessionId,
+                                &SessionIdSize
+                                );
+
+  Session = TlsFindSession (HttpService, HttpInstance->RemoteHost, HttpInstance->RemotePort);
+  if (EFI_ERROR (Status) || (SessionId.Length == 0) || (SessionId.Length > MAX_TLS_SESSION_ID_LENGTH)) {
+    //
+    // The session can't be resumed, forget the previous one too.
+    //
+    if (Session != NULL) {
+      TlsFlushSession (HttpService, Session);
+    }
+
+    return;
+  }
+
+  if (Session == NULL) {
+    Session = AllocateZeroPool (sizeof (HTTP_TLS_SESSION));
+    if (Session == NULL) {
+      return;
+    }
+
+    Session->RemoteHost = AllocateCopyPool (AsciiStrSize (HttpInstance->RemoteHost), HttpInstance->RemoteHost);
+    if (Session->RemoteHost == NULL) {
+      FreePool (Session);
+      return;
+    }
+
+    Session->RemotePort = HttpInstance->RemotePort;
+
+    //
+    // Forget the least recently established session if the list is full.
+    //
+    if (HttpService->TlsSessionNumber >= HTTP_TLS_SESSION_MAX) {
+      TlsFlushSession (HttpService, NET_LIST_HEAD (&HttpService->TlsSessionList, HTTP_TLS_SESSION, Link));
+    }
+
+    HttpService->TlsSessionNumber++;
+  } else {
+    RemoveEntryList (&Session->Link);
+  }
+
+  InsertTailList (&HttpService->TlsSessionList, &Session->Link);
+  CopyMem (&Session->SessionId, &SessionId, sizeof (EFI_TLS_SESSION_ID));
+}
+
+/**
+  Forget the TLS session IDs remembered by the HTTP service.
+
+  @param[in]  HttpService        The HTTP service.
+
+**/
+VOID
+EFIAPI
+TlsFlushSessions (
+  IN  HTTP_SERVICE             *HttpService
+  )
+{
+  LIST_ENTRY                   *Entry;
+  LIST_ENTRY                   *Next;
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &HttpService->TlsSessionList) {
+    TlsFlushSession (HttpService, NET_LIST_USER_STRUCT (Entry, HTTP_TLS_SESSION, Link));
+  }
+}
+
 /**
   Connect one TLS session by finishing the TLS handshake process.
 
@@ -1157,6 +1339,8 @@ TlsConnectSession (
     return Status;
   }
 
+  TlsOfferSession (HttpInstance);
+
   //
   // Create ClientHello
   //
@@ -1352,6 +1536,8 @@ TlsConnectSession (
 
   if (HttpInstance->TlsSessionState != EfiTlsSessionDataTransferring) {
     Status = EFI_ABORTED;
+  } else {
+    TlsSaveSession (HttpInstance);
   }
 
   return Status;
@@ -13,6 +13,48 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define HTTPS_FLAG               "https://"
 
+//
+// Maximum number of TLS session IDs remembered by a HTTP service.
+//
+#define HTTP_TLS_SESSION_MAX     8
+
+//
+// The ID of the TLS session last established with a remote host, for the
+// next connection to resume it.
+//
+typedef struct {
+  LIST_ENTRY                Link;
+  CHAR8                     *RemoteHost;
+  UINT16                    RemotePort;
+  EFI_TLS_SESSION_ID        SessionId;
+} HTTP_TLS_SESSION;
+
+/**
+  Returns the first occurrence of a Null-terminated ASCII sub-string in a Null-terminated
+  ASCII string and ignore case during the search process.
+
+  This function scans the contents of the ASCII string specified by String
+  and returns the first occurrence of SearchString and ignore case during the search process.
+  If SearchString is not found in String, then NULL is returned. If the length of SearchString
+  is zero, then String is returned.
+
+  If String is NULL, then ASSERT().
+  If SearchString is NULL, then ASSERT().
+
+  @param[in]  String          A pointer to a Null-terminated ASCII string.
+  @param[in]  SearchString    A pointer to a Null-terminated ASCII string to search for.
+
+  @retval NULL            If the SearchString does not appear in String.
+  @retval others          If there is a match return the first occurrence of SearchingString.
+                          If the length of SearchString is zero,return String.
+
+**/
+CHAR8 *
+AsciiStrCaseStr (
+  IN      CONST CHAR8               *String,
+  IN      CONST CHAR8               *SearchString
+  );
+
 /**
   Check whether the Url is from Https.
 
@@ -171,6 +213,44 @@ TlsReceiveOnePdu (
   IN     EFI_EVENT          Timeout
   );
 
+/**
+  Offer the TLS session last established with the remote host of the HTTP
+  instance, if any, so that TlsDxe resumes it instead of a full handshake.
+
+  @param[in]  HttpInstance       The HTTP instance private data.
+
+**/
+VOID
+EFIAPI
+TlsOfferSession (
+  IN  HTTP_PROTOCOL            *HttpInstance
+  );
+
+/**
+  Remember the ID of the TLS session established by the handshake, for the
+  next connection to the same remote host to resume it.
+
+  @param[in]  HttpInstance       The HTTP instance private data.
+
+**/
+VOID
+EFIAPI
+TlsSaveSession (
+  IN  HTTP_PROTOCOL            *HttpInstance
+  );
+
+/**
+  Forget the TLS session IDs remembered by the HTTP service.
+
+  @param[in]  HttpService        The HTTP service.
+
+**/
+VOID
+EFIAPI
+TlsFlushSessions (
+  IN  HTTP_SERVICE             *HttpService
+  );
+
 /**
   Connect one TLS session by finishing the TLS handshake process.
 
@@ -1253,8 +1253,9 @@ Ip4WrapRxData (
 /**
   Deliver the received packets to upper layer if there are both received
   requests and enqueued packets. If the enqueued packet is shared, it will
-  duplicate it to a non-shared packet, release the shared packet, then
-  deliver the non-shared packet up.
+  create a non-shared packet with its own copy of IP head, release the shared
+  packet, then deliver the non-shared packet up. The payload isn't copied, the
+  new packet references the same data blocks as the shared one.
 
   @param[in]  IpInstance         The IP child to deliver the packet up.
 
@@ -1298,7 +1299,10 @@ Ip4InstanceDeliverPacket (
 
     } else {
       //
-      // Create a duplicated packet if this packet is shared
+      // Create a new packet if this packet is shared. Only the head space
+      // is private, the payload is referenced, not copied: it's read only
+      // to the upper layers, and the blocks are released to MNP when the
+      // last packet referencing them is freed.
       //
       if (IpInstance->ConfigData.RawData) {
         HeadLen = 0;
@@ -1306,7 +1310,11 @@ Ip4InstanceDeliverPacket (
         HeadLen = IP4_MAX_HEADLEN;
       }
 
-      Dup = NetbufDuplicate (Packet, NULL, HeadLen);
+      if (Packet->TotalSize != 0) {
+        Dup = NetbufGetFragment (Packet, 0, Packet->TotalSize, HeadLen);
+      } else {
+        Dup = NetbufDuplicate (Packet, NULL, HeadLen);
+      }
 
       if (Dup == NULL) {
         return EFI_OUT_OF_RESOURCES;
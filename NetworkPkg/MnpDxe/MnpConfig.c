@@ -529,6 +529,18 @@ MnpInitializeDeviceData (
     goto ERROR;
   }
 
+  //
+  // PcdMnpBusyPollInterval is in microseconds, 0 disables the adaptive poll.
+  //
+  MnpDeviceData->BusyPollInterval = MultU64x32 (PcdGet32 (PcdMnpBusyPollInterval), 10);
+  if ((MnpDeviceData->BusyPollInterval == 0) ||
+      (MnpDeviceData->BusyPollInterval > MNP_SYS_POLL_INTERVAL)) {
+    MnpDeviceData->BusyPollInterval = MNP_SYS_POLL_INTERVAL;
+  }
+
+  MnpDeviceData->PollInterval = MNP_SYS_POLL_INTERVAL;
+  MnpDeviceData->IdlePolls    = 0;
+
   //
   // Create the timer for packet timeout check.
   //
@@ -1272,7 +1284,7 @@ MnpStart (
     //
     TimerOpType = EnableSystemPoll ? TimerPeriodic : TimerCancel;
 
-    Status      = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MNP_SYS_POLL_INTERVAL);
+    Status      = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MnpDeviceData->PollInterval);
     if (EFI_ERROR (Status)) {
       DEBUG ((EFI_D_ERROR, "MnpStart: gBS->SetTimer for PollTimer failed, %r.\n", Status));
 
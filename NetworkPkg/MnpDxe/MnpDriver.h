@@ -27,6 +27,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
 
 #include "ComponentName.h"
 
@@ -69,6 +70,14 @@ typedef struct {
 
   EFI_EVENT                     PollTimer;
   BOOLEAN                       EnableSystemPoll;
+  //
+  // Adaptive system poll: the poll interval drops to BusyPollInterval while
+  // packets flow, and is doubled after every MNP_SYS_POLL_IDLE_COUNT empty
+  // polls, up to MNP_SYS_POLL_INTERVAL. All intervals are in 100ns units.
+  //
+  UINT64                        PollInterval;
+  UINT64                        BusyPollInterval;
+  UINT32                        IdlePolls;
 
   EFI_EVENT                     TimeoutCheckTimer;
   EFI_EVENT                     MediaDetectTimer;
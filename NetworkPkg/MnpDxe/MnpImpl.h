@@ -14,6 +14,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define NET_ETHER_FCS_SIZE            4
 
 #define MNP_SYS_POLL_INTERVAL         (10 * TICKS_PER_MS)   // 10 milliseconds
+#define MNP_SYS_POLL_IDLE_COUNT       8     // Empty polls before the poll interval is doubled.
+#define MNP_SYS_POLL_BATCH            32    // Packets received by one system poll at most.
 #define MNP_TIMEOUT_CHECK_INTERVAL    (50 * TICKS_PER_MS)   // 50 milliseconds
 #define MNP_MEDIA_DETECT_INTERVAL     (500 * TICKS_PER_MS)  // 500 milliseconds
 #define MNP_TX_TIMEOUT_TIME           (500 * TICKS_PER_MS)  // 500 milliseconds
@@ -517,6 +519,33 @@ MnpCheckMediaStatus (
   IN VOID          *Context
   );
 
+/**
+  Set the period of the system poll timer.
+
+  The timer is only reprogrammed if the system poll is enabled, otherwise the
+  interval is used when it is enabled by MnpStart.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[in]       Interval             The poll interval in 100ns units.
+
+**/
+VOID
+MnpSetPollInterval (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINT64            Interval
+  );
+
+/**
+  Switch the system poll to the busy poll interval, as packets are flowing.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+**/
+VOID
+MnpPollBoost (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  );
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
@@ -280,6 +280,11 @@ MnpSyncSendPacket (
 
   if (EFI_ERROR (Status)) {
     Token->Status = EFI_DEVICE_ERROR;
+  } else {
+    //
+    // A reply is likely to follow, poll for it at the busy interval.
+    //
+    MnpPollBoost (MnpDeviceData);
   }
 
 SIGNAL_TOKEN:
@@ -1101,10 +1106,64 @@ MnpCheckMediaStatus (
   }
 }
 
+/**
+  Set the period of the system poll timer.
+
+  The timer is only reprogrammed if the system poll is enabled, otherwise the
+  interval is used when it is enabled by MnpStart.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[in]       Interval             The poll interval in 100ns units.
+
+**/
+VOID
+MnpSetPollInterval (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINT64            Interval
+  )
+{
+  EFI_STATUS  Status;
+
+  if (MnpDeviceData->PollInterval == Interval) {
+    return;
+  }
+
+  if (MnpDeviceData->EnableSystemPoll) {
+    Status = gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "MnpSetPollInterval: gBS->SetTimer for PollTimer failed, %r.\n", Status));
+      return;
+    }
+  }
+
+  MnpDeviceData->PollInterval = Interval;
+}
+
+/**
+  Switch the system poll to the busy poll interval, as packets are flowing.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+**/
+VOID
+MnpPollBoost (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  )
+{
+  MnpDeviceData->IdlePolls = 0;
+  MnpSetPollInterval (MnpDeviceData, MnpDeviceData->BusyPollInterval);
+}
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
 
+  Up to MNP_SYS_POLL_BATCH packets are received by one poll. While polling at
+  the busy poll interval, the WaitForPacket event of Snp, if any, is checked
+  first so that Snp->Receive() isn't called when there is nothing to receive.
+  At the idle interval Snp->Receive() is always called, for Snp drivers whose
+  WaitForPacket event isn't signaled reliably.
+
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
 
@@ -1116,18 +1175,49 @@ MnpSystemPoll (
   IN VOID          *Context
   )
 {
-  MNP_DEVICE_DATA  *MnpDeviceData;
+  MNP_DEVICE_DATA              *MnpDeviceData;
+  EFI_SIMPLE_NETWORK_PROTOCOL  *Snp;
+  UINTN                        Received;
+  UINT64                       Interval;
 
   MnpDeviceData = (MNP_DEVICE_DATA *) Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
-  //
-  // Try to receive packets from Snp.
-  //
-  MnpReceivePacket (MnpDeviceData);
+  Snp      = MnpDeviceData->Snp;
+  Received = 0;
 
-  //
-  // Dispatch the DPC queued by the NotifyFunction of rx token's events.
-  //
-  DispatchDpc ();
+  if ((MnpDeviceData->PollInterval >= MNP_SYS_POLL_INTERVAL) ||
+      (Snp->WaitForPacket == NULL) ||
+      (gBS->CheckEvent (Snp->WaitForPacket) != EFI_NOT_READY)) {
+    //
+    // Try to receive packets from Snp.
+    //
+    while (Received < MNP_SYS_POLL_BATCH) {
+      if (EFI_ERROR (MnpReceivePacket (MnpDeviceData))) {
+        break;
+      }
+
+      Received++;
+
+      //
+      // Dispatch the DPC queued by the NotifyFunction of rx token's events,
+      // so that the receivers recycle their tokens for the next packet.
+      //
+      DispatchDpc ();
+    }
+  }
+
+  if (Received != 0) {
+    MnpPollBoost (MnpDeviceData);
+  } else if (MnpDeviceData->PollInterval < MNP_SYS_POLL_INTERVAL) {
+    //
+    // Back off gradually when the network goes idle.
+    //
+    MnpDeviceData->IdlePolls++;
+    if (MnpDeviceData->IdlePolls >= MNP_SYS_POLL_IDLE_COUNT) {
+      MnpDeviceData->IdlePolls = 0;
+      Interval = MultU64x32 (MnpDeviceData->PollInterval, 2);
+      MnpSetPollInterval (MnpDeviceData, MIN (Interval, MNP_SYS_POLL_INTERVAL));
+    }
+  }
 }
@@ -129,6 +129,12 @@ struct _MTFTP4_PROTOCOL {
   //
   UINT64                        AckedBlock;
 
+  //
+  // Whether the gap after the last saved block has been ACKed, so that
+  // the following blocks of the window aren't ACKed one by one.
+  //
+  BOOLEAN                       GapAcked;
+
   //
   // The server's communication end point: IP and two ports. one for
   // initial request, one for its selected port.
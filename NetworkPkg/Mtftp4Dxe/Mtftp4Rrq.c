@@ -271,6 +271,18 @@ Mtftp4RrqHandleData (
   // expected one. If we are passive (Slave), save the block.
   //
   if (Instance->Master && (Expected != BlockNum)) {
+    //
+    // With a window of blocks, all the blocks following a lost one are
+    // unexpected. ACK the gap once rather than for every block, each ACK
+    // would make the server restart the window. The ACK is retransmitted
+    // on timeout if it is lost.
+    //
+    if ((Instance->WindowSize > 1) && Instance->GapAcked) {
+      return EFI_SUCCESS;
+    }
+
+    Instance->GapAcked = TRUE;
+
     //
     // If Expected is 0, (UINT16) (Expected - 1) is also the expected Ack number (65535).
     //
@@ -283,6 +295,8 @@ Mtftp4RrqHandleData (
     return Status;
   }
 
+  Instance->GapAcked = FALSE;
+
   //
   // Record the total received and saved block number.
   //
@@ -86,6 +86,12 @@ struct _MTFTP6_INSTANCE {
   //
   UINT64                        AckedBlock;
 
+  //
+  // Whether the gap after the last saved block has been ACKed, so that
+  // the following blocks of the window aren't ACKed one by one.
+  //
+  BOOLEAN                       GapAcked;
+
   EFI_IPv6_ADDRESS              ServerIp;
   UINT16                        ServerCmdPort;
   UINT16                        ServerDataPort;
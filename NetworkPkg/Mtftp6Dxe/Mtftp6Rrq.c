@@ -245,6 +245,18 @@ Mtftp6RrqHandleData (
     NetbufFree (*UdpPacket);
     *UdpPacket = NULL;
 
+    //
+    // With a window of blocks, all the blocks following a lost one are
+    // unexpected. ACK the gap once rather than for every block, each ACK
+    // would make the server restart the window. The ACK is retransmitted
+    // on timeout if it is lost.
+    //
+    if ((Instance->WindowSize > 1) && Instance->GapAcked) {
+      return EFI_SUCCESS;
+    }
+
+    Instance->GapAcked = TRUE;
+
     //
     // If Expected is 0, (UINT16) (Expected - 1) is also the expected Ack number (65535).
     //
@@ -257,6 +269,8 @@ Mtftp6RrqHandleData (
     return Status;
   }
 
+  Instance->GapAcked = FALSE;
+
   //
   // Record the total received and saved block number.
   //
@@ -340,9 +340,75 @@ SockProcessRcvToken (
   NetbufQueTrim (Sock->RcvBuffer.DataQueue, TokenRcvdBytes);
   SIGNAL_TOKEN (&(RcvToken->Token), EFI_SUCCESS);
 
+  Sock->RcvQueued += TokenRcvdBytes;
   return TokenRcvdBytes;
 }
 
+/**
+  Copy the in-order data of a TCP segment to the pending receive tokens directly,
+  bypassing the socket receive buffer.
+
+  The data is copied from the NET_BUF delivered by TCP, whose blocks are still
+  the receive buffers of MNP, so each byte is copied only once on its way to the
+  application. It's only used if the receive buffer is empty, otherwise the data
+  would be delivered out of order.
+
+  @param[in, out]  Sock       Pointer to the socket.
+  @param[in]       NetBuffer  Pointer to the buffer that contains the received data.
+
+  @return The length of data copied to the receive tokens.
+
+**/
+UINT32
+SockPlaceRcvData (
+  IN OUT SOCKET    *Sock,
+  IN     NET_BUF   *NetBuffer
+  )
+{
+  UINT32                  Placed;
+  UINT32                  CopyBytes;
+  UINT32                  Index;
+  SOCK_TOKEN              *SockToken;
+  EFI_TCP4_RECEIVE_DATA   *RxData;
+  EFI_TCP4_FRAGMENT_DATA  *Fragment;
+
+  ASSERT ((Sock->RcvBuffer.DataQueue)->BufSize == 0);
+
+  Placed = 0;
+
+  while ((Placed < NetBuffer->TotalSize) && !IsListEmpty (&Sock->RcvTokenList)) {
+
+    SockToken = NET_LIST_HEAD (
+                  &Sock->RcvTokenList,
+                  SOCK_TOKEN,
+                  TokenList
+                  );
+
+    RxData              = ((SOCK_IO_TOKEN *) SockToken->Token)->Packet.RxData;
+    RxData->DataLength  = MIN (RxData->DataLength, NetBuffer->TotalSize - Placed);
+    RxData->UrgentFlag  = FALSE;
+    CopyBytes           = RxData->DataLength;
+
+    for (Index = 0; Index < RxData->FragmentCount; Index++) {
+
+      Fragment                  = &RxData->FragmentTable[Index];
+      Fragment->FragmentLength  = MIN (Fragment->FragmentLength, CopyBytes);
+
+      NetbufCopy (NetBuffer, Placed, Fragment->FragmentLength, Fragment->FragmentBuffer);
+
+      Placed    += Fragment->FragmentLength;
+      CopyBytes -= Fragment->FragmentLength;
+    }
+
+    SIGNAL_TOKEN (SockToken->Token, EFI_SUCCESS);
+    RemoveEntryList (&(SockToken->TokenList));
+    FreePool (SockToken);
+  }
+
+  Sock->RcvPlaced += Placed;
+  return Placed;
+}
+
 /**
   Process the TCP send data, buffer the tcp txdata, and append
   the buffer to socket send buffer, then try to send it.
@@ -841,6 +907,13 @@ SockDestroy (
   NetbufQueFree (Sock->RcvBuffer.DataQueue);
   NetbufQueFree (Sock->SndBuffer.DataQueue);
 
+  DEBUG (
+    (EFI_D_NET,
+    "SockDestroy: %Ld bytes placed to receive tokens directly, %Ld bytes from receive buffer\n",
+    Sock->RcvPlaced,
+    Sock->RcvQueued)
+    );
+
   //
   // Remove it from parent connection list if needed
   //
@@ -1148,9 +1221,27 @@ SockDataRcvd (
   IN     UINT32    UrgLen
   )
 {
+  UINT32  Placed;
+
   ASSERT ((Sock != NULL) && (Sock->RcvBuffer.DataQueue != NULL) &&
     UrgLen <= NetBuffer->TotalSize);
 
+  //
+  // Normal data arriving on an empty receive buffer goes to the pending
+  // receive tokens directly, only the remainder is buffered.
+  //
+  if ((UrgLen == 0) && ((Sock->RcvBuffer.DataQueue)->BufSize == 0) &&
+      !IsListEmpty (&Sock->RcvTokenList)) {
+
+    Placed = SockPlaceRcvData (Sock, NetBuffer);
+
+    if (Placed == NetBuffer->TotalSize) {
+      return;
+    }
+
+    NetbufTrim (NetBuffer, Placed, NET_BUF_HEAD);
+  }
+
   NET_GET_REF (NetBuffer);
 
   ((TCP_RSV_DATA *) (NetBuffer->ProtoData))->UrgLen = UrgLen;
@@ -60,6 +60,22 @@ SockProcessRcvToken (
   IN OUT SOCK_IO_TOKEN *RcvToken
   );
 
+/**
+  Copy the in-order data of a TCP segment to the pending receive tokens directly,
+  bypassing the socket receive buffer.
+
+  @param[in, out]  Sock       Pointer to the socket.
+  @param[in]       NetBuffer  Pointer to the buffer that contains the received data.
+
+  @return The length of data copied to the receive tokens.
+
+**/
+UINT32
+SockPlaceRcvData (
+  IN OUT SOCKET    *Sock,
+  IN     NET_BUF   *NetBuffer
+  );
+
 /**
   Flush the sndBuffer and rcvBuffer of socket.
 
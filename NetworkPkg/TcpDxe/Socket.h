@@ -472,6 +472,8 @@ struct _TCP_SOCKET {
   SOCK_BUFFER               RcvBuffer;      ///< Receive buffer of received data
   EFI_STATUS                SockError;      ///< The error returned by low layer protocol
   BOOLEAN                   InDestroy;
+  UINT64                    RcvPlaced;      ///< Bytes copied from TCP segments to tokens directly
+  UINT64                    RcvQueued;      ///< Bytes delivered through the receive buffer
 
   //
   // Fields used to manage the connection request
@@ -0,0 +1,259 @@
+/** @file
+  TCP congestion window management.
+
+  Slow start is the same for all the algorithms. In congestion avoidance,
+  NewReno grows the congestion window by about one SMSS per RTT (RFC5681),
+  while CUBIC (RFC8312) grows it along a cubic function of the time since
+  the last congestion event, which recovers the window much faster on the
+  high bandwidth-delay product paths of HTTP boot.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "TcpMain.h"
+
+//
+// CUBIC constants of RFC8312, scaled by 1024: the multiplicative
+// decrease factor beta is 0.7, the additive increase factor of the
+// TCP-friendly region is 3 * (1 - beta) / (1 + beta).
+//
+#define TCP_CUBIC_BETA             717
+#define TCP_CUBIC_ALPHA            542
+#define TCP_CUBIC_SCALE            1024
+
+//
+// Limit of |t - K| in milliseconds to keep the cubic term in 64 bits.
+//
+#define TCP_CUBIC_MAX_TIME         65535
+
+/**
+  Compute the integer cube root.
+
+  @param[in]  Value     The value to compute the cube root of.
+
+  @return The largest integer whose cube is not greater than Value.
+
+**/
+UINT32
+TcpCubeRoot (
+  IN UINT64 Value
+  )
+{
+  UINT64  Root;
+  UINT64  Bit;
+  INTN    Shift;
+
+  Root = 0;
+
+  for (Shift = 63; Shift >= 0; Shift -= 3) {
+    Root = LShiftU64 (Root, 1);
+    Bit  = MultU64x64 (MultU64x32 (Root, 3), Root + 1) + 1;
+
+    if (RShiftU64 (Value, Shift) >= Bit) {
+      Value -= LShiftU64 (Bit, Shift);
+      Root++;
+    }
+  }
+
+  return (UINT32) Root;
+}
+
+/**
+  Compute the window of the cubic function at the given time.
+
+  @param[in]  Tcb       Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Time      The time elapsed since the epoch start, in milliseconds.
+
+  @return W(t) = C * (t - K)^3 + Origin, in bytes.
+
+**/
+UINT32
+TcpCubicWindow (
+  IN TCP_CB *Tcb,
+  IN UINT32 Time
+  )
+{
+  TCP_CUBIC *Cubic;
+  UINT32    Delta;
+  UINT64    Offset;
+
+  Cubic = &Tcb->Cubic;
+  Delta = (Time > Cubic->K) ? Time - Cubic->K : Cubic->K - Time;
+  Delta = MIN (Delta, TCP_CUBIC_MAX_TIME);
+
+  //
+  // C is 0.4 segment per second cubed, that is 4 * SMSS / 10^10
+  // bytes per millisecond cubed.
+  //
+  Offset = MultU64x32 (MultU64x32 (MultU64x32 (Delta, Delta), Delta), 4);
+  Offset = DivU64x32 (MultU64x32 (DivU64x32 (Offset, 1000000), Tcb->SndMss), 10000);
+
+  if (Time > Cubic->K) {
+    return (UINT32) MIN (Cubic->Origin + Offset, TCP_MAX_WIN << TCP_OPTION_MAX_WS);
+  }
+
+  return (Offset >= Cubic->Origin) ? 0 : Cubic->Origin - (UINT32) Offset;
+}
+
+/**
+  Compute the congestion window increment for a new ACK in the
+  congestion avoidance phase of CUBIC.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The increment of the congestion window, in bytes.
+
+**/
+UINT32
+TcpCubicOnAck (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  TCP_CUBIC *Cubic;
+  UINT32    Time;
+  UINT32    Target;
+  UINT32    Increment;
+
+  Cubic = &Tcb->Cubic;
+
+  if (Cubic->EpochStart == 0) {
+    //
+    // The first ACK of the epoch, start the cubic function at the
+    // current window, and plateau at the window of last congestion.
+    //
+    Cubic->EpochStart = (mTcpTick == 0) ? 1 : mTcpTick;
+    Cubic->WEst       = Tcb->CWnd;
+
+    if (Tcb->CWnd < Cubic->WMax) {
+      Cubic->K      = TcpCubeRoot (
+                        DivU64x32 (MultU64x32 (Cubic->WMax - Tcb->CWnd, 2500000000U), Tcb->SndMss)
+                        );
+      Cubic->Origin = Cubic->WMax;
+    } else {
+      Cubic->K      = 0;
+      Cubic->Origin = Tcb->CWnd;
+    }
+  }
+
+  //
+  // Aim at the window of one RTT later, as RFC8312 section 4.1.
+  //
+  Time   = MIN (TCP_SUB_TIME (mTcpTick, Cubic->EpochStart), TCP_CUBIC_MAX_TIME / TCP_TICK) * TCP_TICK +
+           MIN (Tcb->SRtt >> TCP_RTT_SHIFT, TCP_RTO_MAX) * TCP_TICK;
+  Target = TcpCubicWindow (Tcb, Time);
+
+  if (Target > Tcb->CWnd) {
+    Increment = (UINT32) DivU64x32 (MultU64x32 (Target - Tcb->CWnd, Tcb->SndMss), Tcb->CWnd);
+    Increment = MIN (Increment, (UINT32) Tcb->SndMss / 2);
+  } else {
+    Increment = MAX (Tcb->SndMss * Tcb->SndMss / (100 * Tcb->CWnd), 1);
+  }
+
+  //
+  // TCP-friendly region: never grow slower than a standard TCP would.
+  //
+  Cubic->WEst += MAX (
+                   (UINT32) DivU64x32 (
+                              MultU64x32 (MultU64x32 (Tcb->SndMss, Tcb->SndMss), TCP_CUBIC_ALPHA),
+                              Tcb->CWnd
+                              ) / TCP_CUBIC_SCALE,
+                   1
+                   );
+
+  if (Cubic->WEst > Tcb->CWnd) {
+    Increment = MAX (
+                  Increment,
+                  MIN ((UINT32) DivU64x32 (MultU64x32 (Cubic->WEst - Tcb->CWnd, Tcb->SndMss), Tcb->CWnd), Tcb->SndMss)
+                  );
+  }
+
+  return Increment;
+}
+
+/**
+  Initialize the congestion control state of the connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpCcInit (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  ZeroMem (&Tcb->Cubic, sizeof (TCP_CUBIC));
+}
+
+/**
+  Grow the congestion window on an ACK which acknowledges new data,
+  in slow start or congestion avoidance.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpCcOnAck (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  if (Tcb->CWnd < Tcb->Ssthresh) {
+
+    Tcb->CWnd += Tcb->SndMss;
+  } else if (Tcb->CcAlgorithm == TCP_CC_CUBIC) {
+
+    Tcb->CWnd += TcpCubicOnAck (Tcb);
+  } else {
+
+    Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
+  }
+
+  Tcb->CWnd = MIN (Tcb->CWnd, TCP_MAX_WIN << Tcb->SndWndScale);
+}
+
+/**
+  Compute the slow start threshold on a congestion event, either fast
+  retransmission or retransmission timeout.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+UINT32
+TcpCcSsthresh (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  TCP_CUBIC *Cubic;
+  UINT32    FlightSize;
+
+  FlightSize = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
+
+  if (Tcb->CcAlgorithm != TCP_CC_CUBIC) {
+    return MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+  }
+
+  //
+  // Fast convergence: release more bandwidth to new flows if
+  // the window of congestion keeps shrinking.
+  //
+  Cubic             = &Tcb->Cubic;
+  Cubic->EpochStart = 0;
+
+  if (FlightSize < Cubic->WLastMax) {
+    Cubic->WLastMax = FlightSize;
+    Cubic->WMax     = (UINT32) DivU64x32 (
+                                 MultU64x32 (FlightSize, TCP_CUBIC_SCALE + TCP_CUBIC_BETA),
+                                 2 * TCP_CUBIC_SCALE
+                                 );
+  } else {
+    Cubic->WLastMax = FlightSize;
+    Cubic->WMax     = FlightSize;
+  }
+
+  return MAX (
+           (UINT32) DivU64x32 (MultU64x32 (FlightSize, TCP_CUBIC_BETA), TCP_CUBIC_SCALE),
+           (UINT32) (2 * Tcb->SndMss)
+           );
+}
@@ -663,6 +663,125 @@ Tcp6RefreshNeighbor (
   IN UINT32          Timeout
   );
 
+//
+// Functions in TcpSack.c
+//
+
+/**
+  Build the SACK blocks to report the out-of-order data on RcvQue.
+
+  @param[in]   Tcb          Pointer to the TCP_CB of this TCP instance.
+  @param[out]  SackBlock    Pointer to the buffer to receive the blocks.
+  @param[in]   MaxNum       The maximum number of blocks to build.
+
+  @return The number of blocks built.
+
+**/
+UINTN
+TcpSackBuildBlock (
+  IN  TCP_CB          *Tcb,
+  OUT TCP_SACK_BLOCK  *SackBlock,
+  IN  UINTN           MaxNum
+  );
+
+/**
+  Update the scoreboard with the SACK blocks reported by the peer.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack      The acknowledgment number of the incoming segment.
+  @param[in]       Option   Pointer to the options parsed from the incoming segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEQNO  Ack,
+  IN     TCP_OPTION *Option
+  );
+
+/**
+  Estimate the data in flight with the scoreboard, the pipe of RFC6675.
+
+  @param[in]  Tcb       Pointer to the TCP_CB of this TCP instance.
+
+  @return The estimated bytes in flight.
+
+**/
+UINT32
+TcpSackPipe (
+  IN TCP_CB *Tcb
+  );
+
+/**
+  Retransmit the lost segments in SACK based fast recovery, as long
+  as the pipe leaves room in the congestion window.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Force    If TRUE, retransmit the first segment not SACKed
+                            regardless of the pipe, as on entering recovery.
+
+  @retval 0       The lost segments are retransmitted, or there is no room.
+  @retval -1      Failed to retransmit a segment.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB  *Tcb,
+  IN     BOOLEAN Force
+  );
+
+/**
+  Discard the scoreboard after a retransmission timeout.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpSackReset (
+  IN OUT TCP_CB *Tcb
+  );
+
+//
+// Functions in TcpCongestion.c
+//
+
+/**
+  Initialize the congestion control state of the connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpCcInit (
+  IN OUT TCP_CB *Tcb
+  );
+
+/**
+  Grow the congestion window on an ACK which acknowledges new data,
+  in slow start or congestion avoidance.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpCcOnAck (
+  IN OUT TCP_CB *Tcb
+  );
+
+/**
+  Compute the slow start threshold on a congestion event, either fast
+  retransmission or retransmission timeout.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+UINT32
+TcpCcSsthresh (
+  IN OUT TCP_CB *Tcb
+  );
+
 //
 // Functions in TcpDispatcher.c
 //
@@ -53,19 +53,25 @@ TcpFastRecover (
     //
     // Step 1A: Invoking fast retransmission.
     //
-    FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-
-    Tcb->Ssthresh     = MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+    Tcb->Ssthresh     = TcpCcSsthresh (Tcb);
     Tcb->Recover      = Tcb->SndNxt;
 
     Tcb->CongestState = TCP_CONGEST_RECOVER;
     TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RTT_ON);
 
     //
-    // Step 2: Entering fast retransmission
+    // Step 2: Entering fast retransmission. With SACK, the
+    // window isn't inflated by the duplicated ACKs, the
+    // pipe of RFC6675 accounts for the data that left the
+    // network instead.
     //
-    TcpRetransmit (Tcb, Tcb->SndUna);
-    Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK)) {
+      Tcb->CWnd = Tcb->Ssthresh;
+      TcpSackRetransmit (Tcb, TRUE);
+    } else {
+      TcpRetransmit (Tcb, Tcb->SndUna);
+      Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    }
 
     DEBUG (
       (EFI_D_NET,
@@ -81,6 +87,14 @@ TcpFastRecover (
   //
   if (Seg->Ack == Tcb->SndUna) {
 
+    if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK)) {
+      //
+      // The lost segments are retransmitted by TcpInput
+      // after the scoreboard is updated.
+      //
+      return;
+    }
+
     //
     // Step 3: Fast Recovery,
     // If this is a duplicated ACK, increse Cwnd by SMSS.
@@ -121,6 +135,19 @@ TcpFastRecover (
         Tcb)
         );
 
+    } else if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK)) {
+
+      //
+      // Partial ACK with SACK: the lost segments are
+      // retransmitted by TcpInput after SndQue is adjusted.
+      //
+      DEBUG (
+        (EFI_D_NET,
+        "TcpFastRecover: received a partial ACK(%d) for SACK TCB %p\n",
+        Seg->Ack,
+        Tcb)
+        );
+
     } else {
 
       //
@@ -1262,6 +1289,13 @@ TcpInput (
     TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
   }
 
+  //
+  // Update the scoreboard before SndQue is adjusted.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK) && (Option.SackNum != 0)) {
+    TcpSackUpdate (Tcb, Seg->Ack, &Option);
+  }
+
   //
   // Count duplicate acks.
   //
@@ -1286,15 +1320,7 @@ TcpInput (
 
     if (TCP_SEQ_GT (Seg->Ack, Tcb->SndUna)) {
 
-      if (Tcb->CWnd < Tcb->Ssthresh) {
-
-        Tcb->CWnd += Tcb->SndMss;
-      } else {
-
-        Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
-      }
-
-      Tcb->CWnd = MIN (Tcb->CWnd, TCP_MAX_WIN << Tcb->SndWndScale);
+      TcpCcOnAck (Tcb);
     }
 
     if (Tcb->CongestState == TCP_CONGEST_LOSS) {
@@ -1327,6 +1353,10 @@ TcpInput (
     }
   }
 
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK) && (Tcb->CongestState == TCP_CONGEST_RECOVER)) {
+    TcpSackRetransmit (Tcb, FALSE);
+  }
+
   //
   // Update window info
   //
@@ -1549,6 +1579,14 @@ StepSix:
       goto RESET_THEN_DROP;
     }
 
+    if (TCP_SEQ_GT (Seg->Seq, Tcb->RcvNxt)) {
+      //
+      // Remember the out-of-order segment, to report it
+      // in the first SACK block.
+      //
+      Tcb->SackRecent = Seg->Seq;
+    }
+
     if (TcpQueueData (Tcb, Nbuf) == 0) {
       DEBUG (
         (EFI_D_ERROR,
@@ -177,6 +177,8 @@ TcpDataToSend (
   UINT32  Len;
   UINT32  Left;
   UINT32  Limit;
+  UINT32  CWndLimit;
+  UINT32  Pipe;
 
   Sk = Tcb->Sk;
   ASSERT (Sk != NULL);
@@ -186,14 +188,22 @@ TcpDataToSend (
   // and congestion window. The right edge of send
   // window is defined as SND.WL2 + SND.WND. The right
   // edge of congestion window is defined as SND.UNA +
-  // CWND.
+  // CWND. In SACK based fast recovery, it is SND.NXT
+  // plus the room left by the pipe in CWND instead.
   //
-  Win   = 0;
-  Limit = Tcb->SndWl2 + Tcb->SndWnd;
+  Win       = 0;
+  Limit     = Tcb->SndWl2 + Tcb->SndWnd;
+  CWndLimit = Tcb->SndUna + Tcb->CWnd;
 
-  if (TCP_SEQ_GT (Limit, Tcb->SndUna + Tcb->CWnd)) {
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK) && (Tcb->CongestState == TCP_CONGEST_RECOVER)) {
 
-    Limit = Tcb->SndUna + Tcb->CWnd;
+    Pipe      = TcpSackPipe (Tcb);
+    CWndLimit = Tcb->SndNxt + ((Tcb->CWnd > Pipe) ? Tcb->CWnd - Pipe : 0);
+  }
+
+  if (TCP_SEQ_GT (Limit, CWndLimit)) {
+
+    Limit = CWndLimit;
   }
 
   if (TCP_SEQ_GT (Limit, Tcb->SndNxt)) {
@@ -586,8 +596,9 @@ TcpGetSegmentSock (
 
   NET_GET_REF (Nbuf);
 
-  TCPSEG_NETBUF (Nbuf)->Seq = Seq;
-  TCPSEG_NETBUF (Nbuf)->End = Seq + Len;
+  TCPSEG_NETBUF (Nbuf)->Seq       = Seq;
+  TCPSEG_NETBUF (Nbuf)->End       = Seq + Len;
+  TCPSEG_NETBUF (Nbuf)->SackState = 0;
 
   InsertTailList (&(Tcb->SndQue), &(Nbuf->List));
 
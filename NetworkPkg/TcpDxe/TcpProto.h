@@ -72,6 +72,15 @@
 #define TCP_CTRL_TIMER_ON        0x1000 ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON          0x2000 ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW         0x4000 ///< Send the ACK now, don't delay.
+#define TCP_CTRL_NO_SACK         0x8000 ///< Disable SACK option.
+#define TCP_CTRL_RCVD_SACK       0x10000 ///< Received a SACK-permitted option in syn.
+#define TCP_CTRL_SND_SACK        0x20000 ///< SACK is negotiated, send SACK blocks to remote.
+
+//
+// Congestion control algorithms, selected by PcdTcpCongestionControl.
+//
+#define TCP_CC_NEWRENO           0  ///< RFC5681 slow start and congestion avoidance.
+#define TCP_CC_CUBIC             1  ///< RFC8312 CUBIC congestion avoidance.
 
 //
 // Timer related values
@@ -207,6 +216,12 @@
 
 #define TCP_MAX_WIN                   0xFFFFU
 
+//
+// Scoreboard state of the segments on SndQue, see TCP_SEG.SackState.
+//
+#define TCP_SEG_SACKED                0x01 ///< The segment is SACKed by the peer.
+#define TCP_SEG_RETXMIT               0x02 ///< The segment is retransmitted in SACK recovery.
+
 ///
 /// TCP segmentation data.
 ///
@@ -217,8 +232,21 @@ typedef struct _TCP_SEG {
   UINT8     Flag; ///< TCP header flags.
   UINT16    Urg;  ///< Valid if URG flag is set.
   UINT32    Wnd;  ///< TCP window size field.
+  UINT8     SackState; ///< Scoreboard state of the segment on SndQue, such as TCP_SEG_SACKED.
 } TCP_SEG;
 
+///
+/// CUBIC congestion control state, as specified in RFC8312.
+///
+typedef struct _TCP_CUBIC {
+  UINT32    WMax;        ///< CWnd just before the last window reduction.
+  UINT32    WLastMax;    ///< WMax before the last window reduction, for fast convergence.
+  UINT32    Origin;      ///< CWnd the cubic function plateaus at, in bytes.
+  UINT32    K;           ///< Time to reach Origin from the epoch start, in milliseconds.
+  UINT32    EpochStart;  ///< mTcpTick when the current congestion avoidance epoch starts, 0 if not started.
+  UINT32    WEst;        ///< Estimated CWnd of a Reno flow in the same epoch, in bytes.
+} TCP_CUBIC;
+
 ///
 /// Network endpoint, IP plus Port structure.
 ///
@@ -309,6 +337,18 @@ struct _TCP_CONTROL_BLOCK {
   UINT8             LossTimes;    ///< Number of retxmit timeouts in a row.
   TCP_SEQNO         LossRecover;  ///< Recover point for retxmit.
 
+  //
+  // RFC2018 and RFC6675 variables, SACK based loss recovery.
+  //
+  TCP_SEQNO         SackHigh;     ///< Highest sequence number SACKed by the peer.
+  TCP_SEQNO         SackRecent;   ///< Start of the latest out-of-order block received, reported first.
+
+  //
+  // Congestion control algorithm, such as TCP_CC_CUBIC, and its state.
+  //
+  UINT8             CcAlgorithm;
+  TCP_CUBIC         Cubic;
+
   //
   // RFC7323
   // Addressing Window Retraction for TCP Window Scale Option.
@@ -0,0 +1,293 @@
+/** @file
+  TCP selective acknowledgment, as specified in RFC2018, and the
+  conservative SACK based loss recovery of RFC6675.
+
+  The sender keeps a scoreboard in the SackState of the segments on
+  SndQue. A segment is SACKed if the peer reports it in a SACK block,
+  and considered lost if it is below the highest SACKed sequence
+  number but not SACKed itself. In fast recovery, the lost segments
+  are retransmitted as long as the estimated data in flight, the
+  pipe, leaves room in the congestion window.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "TcpMain.h"
+
+/**
+  Build the SACK blocks to report the out-of-order data on RcvQue.
+
+  The first block contains the segment received most recently, as
+  required by RFC2018, the other blocks follow in sequence order.
+
+  @param[in]   Tcb          Pointer to the TCP_CB of this TCP instance.
+  @param[out]  SackBlock    Pointer to the buffer to receive the blocks.
+  @param[in]   MaxNum       The maximum number of blocks to build.
+
+  @return The number of blocks built.
+
+**/
+UINTN
+TcpSackBuildBlock (
+  IN  TCP_CB          *Tcb,
+  OUT TCP_SACK_BLOCK  *SackBlock,
+  IN  UINTN           MaxNum
+  )
+{
+  LIST_ENTRY      *Entry;
+  TCP_SEG         *Seg;
+  TCP_SACK_BLOCK  Block;
+  UINTN           Num;
+  BOOLEAN         Recent;
+
+  ASSERT ((Tcb != NULL) && (SackBlock != NULL) && (MaxNum <= TCP_OPTION_MAX_SACK));
+
+  if (MaxNum == 0) {
+    return 0;
+  }
+
+  //
+  // The segments on RcvQue are sorted and don't overlap, and all
+  // the in-order data has been delivered, so merge the adjacent
+  // segments into blocks. Slot 0 is reserved for the block that
+  // contains the most recent segment.
+  //
+  Num         = 1;
+  Recent      = FALSE;
+  Block.Left  = 0;
+  Block.Right = 0;
+  Entry       = Tcb->RcvQue.ForwardLink;
+
+  while (Entry != &Tcb->RcvQue) {
+    Seg   = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+    Entry = Entry->ForwardLink;
+
+    if (TCP_SEQ_LEQ (Seg->Seq, Tcb->RcvNxt)) {
+      continue;
+    }
+
+    if ((Block.Left != Block.Right) && (Seg->Seq == Block.Right)) {
+      Block.Right = Seg->End;
+    } else {
+      Block.Left  = Seg->Seq;
+      Block.Right = Seg->End;
+    }
+
+    //
+    // Emit the block when the next segment doesn't extend it.
+    //
+    if ((Entry != &Tcb->RcvQue) &&
+        (TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List))->Seq == Block.Right)) {
+      continue;
+    }
+
+    if (!Recent && TCP_SEQ_BETWEEN (Block.Left, Tcb->SackRecent, Block.Right - 1)) {
+      CopyMem (&SackBlock[0], &Block, sizeof (TCP_SACK_BLOCK));
+      Recent = TRUE;
+    } else if (Num < MaxNum) {
+      CopyMem (&SackBlock[Num], &Block, sizeof (TCP_SACK_BLOCK));
+      Num++;
+    }
+
+    if (Recent && (Num == MaxNum)) {
+      break;
+    }
+  }
+
+  if (Recent) {
+    return Num;
+  }
+
+  //
+  // The most recent segment has been delivered, shift the others.
+  //
+  CopyMem (&SackBlock[0], &SackBlock[1], (Num - 1) * sizeof (TCP_SACK_BLOCK));
+  return Num - 1;
+}
+
+/**
+  Update the scoreboard with the SACK blocks reported by the peer.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack      The acknowledgment number of the incoming segment.
+  @param[in]       Option   Pointer to the options parsed from the incoming segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEQNO  Ack,
+  IN     TCP_OPTION *Option
+  )
+{
+  LIST_ENTRY      *Entry;
+  TCP_SEG         *Seg;
+  TCP_SACK_BLOCK  *Block;
+  UINTN           Index;
+
+  ASSERT ((Tcb != NULL) && (Option != NULL));
+
+  if (TCP_SEQ_LT (Tcb->SackHigh, Ack)) {
+    Tcb->SackHigh = Ack;
+  }
+
+  for (Index = 0; Index < Option->SackNum; Index++) {
+    Block = &Option->SackBlock[Index];
+
+    //
+    // Ignore the invalid blocks and the blocks reporting
+    // duplicate segments (RFC2883).
+    //
+    if (TCP_SEQ_GEQ (Block->Left, Block->Right) ||
+        TCP_SEQ_LEQ (Block->Right, Ack) ||
+        TCP_SEQ_GT (Block->Right, Tcb->SndNxt)) {
+      continue;
+    }
+
+    NET_LIST_FOR_EACH (Entry, &Tcb->SndQue) {
+      Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+
+      if (TCP_SEQ_GEQ (Seg->Seq, Block->Right)) {
+        break;
+      }
+
+      if (TCP_SEQ_GEQ (Seg->Seq, Block->Left) && TCP_SEQ_LEQ (Seg->End, Block->Right)) {
+        Seg->SackState |= TCP_SEG_SACKED;
+      }
+    }
+
+    if (TCP_SEQ_GT (Block->Right, Tcb->SackHigh)) {
+      Tcb->SackHigh = Block->Right;
+    }
+  }
+}
+
+/**
+  Estimate the data in flight with the scoreboard, the pipe of RFC6675.
+
+  The data not SACKed above the highest SACKed sequence number is
+  considered in flight, and so is the data retransmitted in recovery
+  but not SACKed. The data not SACKed below it is considered lost.
+
+  @param[in]  Tcb       Pointer to the TCP_CB of this TCP instance.
+
+  @return The estimated bytes in flight.
+
+**/
+UINT32
+TcpSackPipe (
+  IN TCP_CB *Tcb
+  )
+{
+  LIST_ENTRY  *Entry;
+  TCP_SEG     *Seg;
+  TCP_SEQNO   End;
+  UINT32      Pipe;
+
+  Pipe = 0;
+
+  NET_LIST_FOR_EACH (Entry, &Tcb->SndQue) {
+    Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+
+    if (TCP_SEQ_GEQ (Seg->Seq, Tcb->SndNxt)) {
+      break;
+    }
+
+    if ((Seg->SackState & TCP_SEG_SACKED) != 0) {
+      continue;
+    }
+
+    End = TCP_SEQ_LT (Seg->End, Tcb->SndNxt) ? Seg->End : Tcb->SndNxt;
+
+    if (TCP_SEQ_GEQ (Seg->Seq, Tcb->SackHigh)) {
+      Pipe += TCP_SUB_SEQ (End, Seg->Seq);
+    }
+
+    if ((Seg->SackState & TCP_SEG_RETXMIT) != 0) {
+      Pipe += TCP_SUB_SEQ (End, Seg->Seq);
+    }
+  }
+
+  return Pipe;
+}
+
+/**
+  Retransmit the lost segments in SACK based fast recovery, as long
+  as the pipe leaves room in the congestion window.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Force    If TRUE, retransmit the first segment not SACKed
+                            regardless of the pipe, as on entering recovery.
+
+  @retval 0       The lost segments are retransmitted, or there is no room.
+  @retval -1      Failed to retransmit a segment.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB  *Tcb,
+  IN     BOOLEAN Force
+  )
+{
+  LIST_ENTRY  *Entry;
+  TCP_SEG     *Seg;
+  UINT32      Pipe;
+
+  Pipe = TcpSackPipe (Tcb);
+
+  NET_LIST_FOR_EACH (Entry, &Tcb->SndQue) {
+    Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+
+    if (TCP_SEQ_GEQ (Seg->Seq, Tcb->SndNxt) ||
+        (!Force && TCP_SEQ_GEQ (Seg->Seq, Tcb->SackHigh))) {
+      break;
+    }
+
+    if (Seg->SackState != 0) {
+      continue;
+    }
+
+    if (!Force && (Pipe + Tcb->SndMss > Tcb->CWnd)) {
+      break;
+    }
+
+    if (TcpRetransmit (Tcb, Seg->Seq) != 0) {
+      return -1;
+    }
+
+    DEBUG (
+      (EFI_D_NET,
+      "TcpSackRetransmit: retransmit the lost segment (%d) for TCB %p\n",
+      Seg->Seq,
+      Tcb)
+      );
+
+    Seg->SackState |= TCP_SEG_RETXMIT;
+    Pipe          += TCP_SUB_SEQ (Seg->End, Seg->Seq);
+    Force          = FALSE;
+  }
+
+  return 0;
+}
+
+/**
+  Discard the scoreboard after a retransmission timeout, since the
+  peer is allowed to drop the data it has SACKed.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpSackReset (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  LIST_ENTRY  *Entry;
+
+  NET_LIST_FOR_EACH (Entry, &Tcb->SndQue) {
+    TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List))->SackState = 0;
+  }
+
+  Tcb->SackHigh = Tcb->SndUna;
+}
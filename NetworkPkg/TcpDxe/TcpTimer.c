@@ -184,8 +184,6 @@ TcpRexmitTimeout (
   IN OUT TCP_CB *Tcb
   )
 {
-  UINT32  FlightSize;
-
   DEBUG (
     (EFI_D_WARN,
     "TcpRexmitTimeout: transmission timeout for TCB %p\n",
@@ -193,14 +191,16 @@ TcpRexmitTimeout (
     );
 
   //
-  // Set the congestion window. FlightSize is the
-  // amount of data that has been sent but not
-  // yet ACKed.
+  // Set the congestion window, and forget what the
+  // peer has SACKed since it may discard the data.
   //
-  FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-  Tcb->Ssthresh     = MAX ((UINT32) (2 * Tcb->SndMss), FlightSize / 2);
+  Tcb->Ssthresh     = TcpCcSsthresh (Tcb);
 
   Tcb->CWnd         = Tcb->SndMss;
+
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK)) {
+    TcpSackReset (Tcb);
+  }
   Tcb->LossRecover  = Tcb->SndNxt;
 
   Tcb->LossTimes++;
@@ -30,6 +30,10 @@ TlsCleanInstance (
       TlsFree (Instance->TlsConn);
     }
 
+    if (Instance->ServerName != NULL) {
+      FreePool (Instance->ServerName);
+    }
+
     FreePool (Instance);
   }
 }
@@ -86,6 +90,8 @@ TlsCleanService (
   )
 {
   if (Service != NULL) {
+    TlsSessionCacheFlush (Service);
+
     if (Service->TlsCtx != NULL) {
       TlsCtxFree (Service->TlsCtx);
     }
@@ -132,6 +138,7 @@ TlsCreateService (
   TlsService->TlsChildrenNum   = 0;
   InitializeListHead (&TlsService->TlsChildrenList);
   TlsService->ImageHandle      = Image;
+  InitializeListHead (&TlsService->SessionCache);
 
   *Service = TlsService;
 
@@ -56,6 +56,15 @@ struct _TLS_SERVICE {
   // created for the connections.
   //
   VOID                            *TlsCtx;
+
+  //
+  // Sessions established by the TLS children, for resumption.
+  //
+  LIST_ENTRY                      SessionCache;
+  UINTN                           SessionCacheNumber;
+  EFI_EVENT                       SessionCacheTimer;
+  UINTN                           FullHandshakes;
+  UINTN                           ResumedHandshakes;
 };
 
 struct _TLS_INSTANCE {
@@ -77,6 +86,13 @@ struct _TLS_INSTANCE {
   // per established connection.
   //
   VOID                            *TlsConn;
+
+  //
+  // The server name set by EfiTlsVerifyHost, and the ID of the cached session
+  // offered to the server, if any.
+  //
+  CHAR8                           *ServerName;
+  EFI_TLS_SESSION_ID              ResumeSessionId;
 };
 
 
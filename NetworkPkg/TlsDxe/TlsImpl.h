@@ -20,6 +20,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/DebugLib.h>
 #include <Library/NetLib.h>
+#include <Library/PcdLib.h>
 #include <Library/BaseCryptLib.h>
 #include <Library/TlsLib.h>
 
@@ -32,6 +33,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <IndustryStandard/Tls1.h>
 
 #include "TlsDriver.h"
+#include "TlsSessionCache.h"
 
 //
 // Protocol instances
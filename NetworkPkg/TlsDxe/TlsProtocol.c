@@ -185,6 +185,21 @@ TlsSetSessionData (
     }
 
     Status = TlsSetVerifyHost (Instance->TlsConn, TlsVerifyHost->Flags, TlsVerifyHost->HostName);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+
+    //
+    // The server name keys the cached sessions.
+    //
+    if (Instance->ServerName != NULL) {
+      FreePool (Instance->ServerName);
+    }
+
+    Instance->ServerName = AllocateCopyPool (AsciiStrSize (TlsVerifyHost->HostName), TlsVerifyHost->HostName);
+    if (Instance->ServerName == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
 
     break;
   case EfiTlsSessionID:
@@ -193,6 +208,14 @@ TlsSetSessionData (
       goto ON_EXIT;
     }
 
+    //
+    // Resume the cached session of this ID, if any, or just set the ID.
+    //
+    Status = TlsSessionCacheResume (Instance, (EFI_TLS_SESSION_ID *) Data);
+    if (!EFI_ERROR (Status)) {
+      break;
+    }
+
     Status = TlsSetSessionId (
                Instance->TlsConn,
                ((EFI_TLS_SESSION_ID *) Data)->Data,
@@ -556,11 +579,16 @@ TlsBuildResponsePacket (
                  BufferSize
                  );
       if (EFI_ERROR (Status)) {
+        if (Status != EFI_BUFFER_TOO_SMALL) {
+          TlsSessionCacheRemove (Instance);
+        }
+
         goto ON_EXIT;
       }
 
       if (!TlsInHandshake (Instance->TlsConn)) {
         Instance->TlsSessionState = EfiTlsSessionDataTransferring;
+        TlsSessionCacheSave (Instance);
       }
     } else {
       //
@@ -578,6 +606,7 @@ TlsBuildResponsePacket (
       if (EFI_ERROR (Status)) {
         if (Status != EFI_BUFFER_TOO_SMALL) {
           Instance->TlsSessionState = EfiTlsSessionError;
+          TlsSessionCacheRemove (Instance);
         }
 
         goto ON_EXIT;
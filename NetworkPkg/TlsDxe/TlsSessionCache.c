@@ -0,0 +1,327 @@
+/** @file
+  Session cache of TlsDxe driver.
+
+  A full TLS handshake costs the client a certificate chain verification and
+  a key exchange, which are slow without hardware acceleration. The session
+  established by a TLS child is therefore kept in the TLS service for
+  PcdTlsSessionCacheLifetime seconds, keyed by the name of the server and the
+  session ID, and a later child connecting to the same server resumes it with
+  an abbreviated handshake, by session ID or by session ticket.
+
+  The caller opts in by setting EfiTlsSessionID to the ID it got from
+  GetSessionData() after a previous handshake, as the UEFI specification
+  describes for session resumption.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "TlsImpl.h"
+
+/**
+  Release a cached session.
+
+  @param[in]  CacheEntry         The cached session.
+
+**/
+VOID
+TlsSessionCacheFree (
+  IN TLS_SESSION_CACHE_ENTRY      *CacheEntry
+  )
+{
+  ZeroMem (CacheEntry->Session, CacheEntry->SessionSize);
+  FreePool (CacheEntry->Session);
+  FreePool (CacheEntry->ServerName);
+  FreePool (CacheEntry);
+}
+
+/**
+  Find the cached session of a server by the session ID.
+
+  @param[in]  Service            The TLS service.
+  @param[in]  ServerName         The name of the server.
+  @param[in]  SessionId          The session ID.
+
+  @return The cached session, or NULL if not found.
+
+**/
+TLS_SESSION_CACHE_ENTRY *
+TlsSessionCacheFind (
+  IN TLS_SERVICE                  *Service,
+  IN CHAR8                        *ServerName,
+  IN CONST EFI_TLS_SESSION_ID     *SessionId
+  )
+{
+  TLS_SESSION_CACHE_ENTRY         *CacheEntry;
+  LIST_ENTRY                      *Entry;
+
+  NET_LIST_FOR_EACH (Entry, &Service->SessionCache) {
+    CacheEntry = NET_LIST_USER_STRUCT (Entry, TLS_SESSION_CACHE_ENTRY, Link);
+    if ((CacheEntry->SessionId.Length == SessionId->Length) &&
+        (CompareMem (CacheEntry->SessionId.Data, SessionId->Data, SessionId->Length) == 0) &&
+        (AsciiStrCmp (CacheEntry->ServerName, ServerName) == 0)) {
+      return CacheEntry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  The timer notification function to age the cached sessions, and release
+  the expired ones.
+
+  @param[in]  Event              The timer event.
+  @param[in]  Context            The TLS service.
+
+**/
+VOID
+EFIAPI
+TlsSessionCacheTimerTicking (
+  IN EFI_EVENT                    Event,
+  IN VOID                         *Context
+  )
+{
+  TLS_SERVICE                     *Service;
+  TLS_SESSION_CACHE_ENTRY         *CacheEntry;
+  LIST_ENTRY                      *Entry;
+  LIST_ENTRY                      *Next;
+
+  Service = (TLS_SERVICE *) Context;
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &Service->SessionCache) {
+    CacheEntry = NET_LIST_USER_STRUCT (Entry, TLS_SESSION_CACHE_ENTRY, Link);
+    CacheEntry->Age++;
+
+    if (CacheEntry->Age >= PcdGet32 (PcdTlsSessionCacheLifetime)) {
+      RemoveEntryList (&CacheEntry->Link);
+      Service->SessionCacheNumber--;
+      TlsSessionCacheFree (CacheEntry);
+    }
+  }
+
+  if (Service->SessionCacheNumber == 0) {
+    gBS->SetTimer (Service->SessionCacheTimer, TimerCancel, 0);
+  }
+}
+
+/**
+  Resume a cached session of the server the TLS child verifies, for the
+  handshake to be started.
+
+  @param[in, out]  Instance           The TLS child, with the server name set
+                                      by EfiTlsVerifyHost.
+  @param[in]       SessionId          The ID of the session to resume.
+
+  @retval EFI_SUCCESS            The session will be offered to the server.
+  @retval EFI_NOT_FOUND          The session isn't cached, or has expired.
+  @retval Others                 Other error as indicated.
+
+**/
+EFI_STATUS
+TlsSessionCacheResume (
+  IN OUT TLS_INSTANCE             *Instance,
+  IN     CONST EFI_TLS_SESSION_ID *SessionId
+  )
+{
+  TLS_SESSION_CACHE_ENTRY         *CacheEntry;
+  EFI_STATUS                      Status;
+
+  if ((Instance->ServerName == NULL) || (SessionId->Length == 0) ||
+      (SessionId->Length > MAX_TLS_SESSION_ID_LENGTH)) {
+    return EFI_NOT_FOUND;
+  }
+
+  CacheEntry = TlsSessionCacheFind (Instance->Service, Instance->ServerName, SessionId);
+  if (CacheEntry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = TlsSetSession (Instance->TlsConn, CacheEntry->Session, CacheEntry->SessionSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  CopyMem (&Instance->ResumeSessionId, SessionId, sizeof (EFI_TLS_SESSION_ID));
+  return EFI_SUCCESS;
+}
+
+/**
+  Save the session established by the handshake of a TLS child in the cache.
+
+  The session resumed by the handshake, if any, is replaced with the session
+  after the handshake, whose ticket may be renewed by the server.
+
+  @param[in, out]  Instance           The TLS child whose handshake completed.
+
+**/
+VOID
+TlsSessionCacheSave (
+  IN OUT TLS_INSTANCE             *Instance
+  )
+{
+  TLS_SERVICE                     *Service;
+  TLS_SESSION_CACHE_ENTRY         *CacheEntry;
+  TLS_SESSION_CACHE_ENTRY         *Oldest;
+  EFI_STATUS                      Status;
+  BOOLEAN                         Resumed;
+  UINTN                           SessionBufferSize;
+
+  Service = Instance->Service;
+  Resumed = TlsIsSessionReused (Instance->TlsConn);
+  if (Resumed) {
+    Service->ResumedHandshakes++;
+  } else {
+    Service->FullHandshakes++;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "TlsSessionCacheSave: %a handshake with %a, %d full, %d resumed\n",
+    Resumed ? "abbreviated" : "full",
+    (Instance->ServerName != NULL) ? Instance->ServerName : "(unknown)",
+    Service->FullHandshakes,
+    Service->ResumedHandshakes
+    ));
+
+  if (Instance->ResumeSessionId.Length != 0) {
+    TlsSessionCacheRemove (Instance);
+  }
+
+  if ((PcdGet32 (PcdTlsSessionCacheLifetime) == 0) || (Instance->ServerName == NULL)) {
+    return;
+  }
+
+  CacheEntry = AllocateZeroPool (sizeof (TLS_SESSION_CACHE_ENTRY));
+  if (CacheEntry == NULL) {
+    return;
+  }
+
+  CacheEntry->SessionId.Length = MAX_TLS_SESSION_ID_LENGTH;
+  Status = TlsGetSessionId (Instance->TlsConn, CacheEntry->SessionId.Data, &CacheEntry->SessionId.Length);
+  if (EFI_ERROR (Status) || (CacheEntry->SessionId.Length == 0)) {
+    FreePool (CacheEntry);
+    return;
+  }
+
+  SessionBufferSize = 0;
+  Status = TlsGetSession (Instance->TlsConn, NULL, &CacheEntry->SessionSize);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    SessionBufferSize   = CacheEntry->SessionSize;
+    CacheEntry->Session = AllocatePool (SessionBufferSize);
+    if (CacheEntry->Session != NULL) {
+      Status = TlsGetSession (Instance->TlsConn, CacheEntry->Session, &CacheEntry->SessionSize);
+    } else {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  CacheEntry->ServerName = AllocateCopyPool (AsciiStrSize (Instance->ServerName), Instance->ServerName);
+  if (EFI_ERROR (Status) || (CacheEntry->ServerName == NULL)) {
+    if (CacheEntry->Session != NULL) {
+      ZeroMem (CacheEntry->Session, SessionBufferSize);
+      FreePool (CacheEntry->Session);
+    }
+
+    if (CacheEntry->ServerName != NULL) {
+      FreePool (CacheEntry->ServerName);
+    }
+
+    FreePool (CacheEntry);
+    return;
+  }
+
+  if (Service->SessionCacheTimer == NULL) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    TlsSessionCacheTimerTicking,
+                    Service,
+                    &Service->SessionCacheTimer
+                    );
+    if (EFI_ERROR (Status)) {
+      Service->SessionCacheTimer = NULL;
+      TlsSessionCacheFree (CacheEntry);
+      return;
+    }
+  }
+
+  //
+  // Replace the least recently saved session if the cache is full.
+  //
+  if (Service->SessionCacheNumber >= TLS_SESSION_CACHE_MAX) {
+    Oldest = NET_LIST_HEAD (&Service->SessionCache, TLS_SESSION_CACHE_ENTRY, Link);
+    RemoveEntryList (&Oldest->Link);
+    Service->SessionCacheNumber--;
+    TlsSessionCacheFree (Oldest);
+  }
+
+  InsertTailList (&Service->SessionCache, &CacheEntry->Link);
+  Service->SessionCacheNumber++;
+  gBS->SetTimer (Service->SessionCacheTimer, TimerPeriodic, TLS_SESSION_CACHE_TIMER_PERIOD);
+}
+
+/**
+  Remove the session a TLS child offered from the cache, after the handshake
+  failed, so that the next connection to the server does a full handshake.
+
+  @param[in, out]  Instance           The TLS child whose handshake failed.
+
+**/
+VOID
+TlsSessionCacheRemove (
+  IN OUT TLS_INSTANCE             *Instance
+  )
+{
+  TLS_SERVICE                     *Service;
+  TLS_SESSION_CACHE_ENTRY         *CacheEntry;
+
+  Service = Instance->Service;
+
+  if ((Instance->ServerName == NULL) || (Instance->ResumeSessionId.Length == 0)) {
+    return;
+  }
+
+  CacheEntry = TlsSessionCacheFind (Service, Instance->ServerName, &Instance->ResumeSessionId);
+  Instance->ResumeSessionId.Length = 0;
+  if (CacheEntry == NULL) {
+    return;
+  }
+
+  RemoveEntryList (&CacheEntry->Link);
+  Service->SessionCacheNumber--;
+  TlsSessionCacheFree (CacheEntry);
+
+  if ((Service->SessionCacheNumber == 0) && (Service->SessionCacheTimer != NULL)) {
+    gBS->SetTimer (Service->SessionCacheTimer, TimerCancel, 0);
+  }
+}
+
+/**
+  Release all the sessions of the cache.
+
+  @param[in]  Service            The TLS service.
+
+**/
+VOID
+TlsSessionCacheFlush (
+  IN TLS_SERVICE                  *Service
+  )
+{
+  TLS_SESSION_CACHE_ENTRY         *CacheEntry;
+  LIST_ENTRY                      *Entry;
+  LIST_ENTRY                      *Next;
+
+  if (Service->SessionCacheTimer != NULL) {
+    gBS->CloseEvent (Service->SessionCacheTimer);
+    Service->SessionCacheTimer = NULL;
+  }
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &Service->SessionCache) {
+    CacheEntry = NET_LIST_USER_STRUCT (Entry, TLS_SESSION_CACHE_ENTRY, Link);
+    RemoveEntryList (&CacheEntry->Link);
+    TlsSessionCacheFree (CacheEntry);
+  }
+
+  Service->SessionCacheNumber = 0;
+}
@@ -0,0 +1,90 @@
+/** @file
+  The header files of the session cache of TlsDxe driver.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EFI_TLS_SESSION_CACHE_H__
+#define __EFI_TLS_SESSION_CACHE_H__
+
+//
+// Maximum number of sessions kept in the cache.
+//
+#define TLS_SESSION_CACHE_MAX           16
+
+//
+// Period of the timer aging the cached sessions.
+//
+#define TLS_SESSION_CACHE_TIMER_PERIOD  TICKS_PER_SECOND
+
+//
+// A session established by a TLS child, kept for the later connections to
+// the same server.
+//
+typedef struct {
+  LIST_ENTRY                      Link;
+  CHAR8                           *ServerName;
+  EFI_TLS_SESSION_ID              SessionId;
+  UINT8                           *Session;
+  UINTN                           SessionSize;
+  UINT32                          Age;  // In seconds.
+} TLS_SESSION_CACHE_ENTRY;
+
+/**
+  Resume a cached session of the server the TLS child verifies, for the
+  handshake to be started.
+
+  @param[in, out]  Instance           The TLS child, with the server name set
+                                      by EfiTlsVerifyHost.
+  @param[in]       SessionId          The ID of the session to resume.
+
+  @retval EFI_SUCCESS            The session will be offered to the server.
+  @retval EFI_NOT_FOUND          The session isn't cached, or has expired.
+  @retval Others                 Other error as indicated.
+
+**/
+EFI_STATUS
+TlsSessionCacheResume (
+  IN OUT TLS_INSTANCE             *Instance,
+  IN     CONST EFI_TLS_SESSION_ID *SessionId
+  );
+
+/**
+  Save the session established by the handshake of a TLS child in the cache.
+
+  The session resumed by the handshake, if any, is replaced with the session
+  after the handshake, whose ticket may be renewed by the server.
+
+  @param[in, out]  Instance           The TLS child whose handshake completed.
+
+**/
+VOID
+TlsSessionCacheSave (
+  IN OUT TLS_INSTANCE             *Instance
+  );
+
+/**
+  Remove the session a TLS child offered from the cache, after the handshake
+  failed, so that the next connection to the server does a full handshake.
+
+  @param[in, out]  Instance           The TLS child whose handshake failed.
+
+**/
+VOID
+TlsSessionCacheRemove (
+  IN OUT TLS_INSTANCE             *Instance
+  );
+
+/**
+  Release all the sessions of the cache.
+
+  @param[in]  Service            The TLS service.
+
+**/
+VOID
+TlsSessionCacheFlush (
+  IN TLS_SERVICE                  *Service
+  );
+
+#endif
@@ -219,6 +219,12 @@ EfiPxeBcStart (
     Private->BlockSize   = (UINTN) PcdGet64 (PcdTftpBlockSize);
   }
 
+  //
+  // Start with the largest TFTP window, it's adapted to the timeouts of
+  // every download.
+  //
+  Private->TftpWindowSize = (UINTN) PcdGet64 (PcdPxeTftpWindowSize);
+
   //
   // Create event for UdpRead/UdpWrite timeout since they are both blocking API.
   //
@@ -868,9 +874,11 @@ EfiPxeBcMtftp (
   Mode      = Private->PxeBc.Mode;
 
   //
-  // Get PcdPxeTftpWindowSize.
+  // Get the window size adapted to the previous downloads, and count the
+  // timeouts of this one.
   //
-  WindowSize = (UINTN) PcdGet64 (PcdPxeTftpWindowSize);
+  WindowSize            = Private->TftpWindowSize;
+  Private->TftpTimeouts = 0;
 
   if (Mode->UsingIpv6) {
     if (!NetIp6IsValidUnicast (&ServerIp->v6)) {
@@ -1002,6 +1010,15 @@ EfiPxeBcMtftp (
     Mode->IcmpErrorReceived = TRUE;
   }
 
+  //
+  // Only the read requests negotiate a windowsize and count their timeouts.
+  // A write or a file size query says nothing about the download window.
+  //
+  if ((Operation == EFI_PXE_BASE_CODE_TFTP_READ_FILE) ||
+      (Operation == EFI_PXE_BASE_CODE_TFTP_READ_DIRECTORY)) {
+    PxeBcTftpAdaptWindow (Private, Status);
+  }
+
   //
   // Reconfigure the UDP instance with the default configuration.
   //
@@ -179,6 +179,8 @@ struct _PXEBC_PRIVATE_DATA {
   UINT8                                     *BootFileName;
   UINTN                                     BootFileSize;
   UINTN                                     BlockSize;
+  UINTN                                     TftpWindowSize;
+  UINTN                                     TftpTimeouts;
 
   PXEBC_DHCP_PACKET_CACHE                   ProxyOffer;
   PXEBC_DHCP_PACKET_CACHE                   DhcpAck;
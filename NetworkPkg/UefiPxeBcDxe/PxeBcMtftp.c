@@ -96,6 +96,34 @@ PxeBcMtftp6CheckPacket (
 }
 
 
+/**
+  This is a callback function when a packet of Mtftp driver times out.
+
+  The timeouts are counted to adapt the window size of the next download,
+  see PxeBcTftpAdaptWindow().
+
+  @param[in]  This           Pointer to EFI_MTFTP6_PROTOCOL.
+  @param[in]  Token          Pointer to EFI_MTFTP6_TOKEN.
+
+  @retval EFI_SUCCESS    Retransmit the packet and continue.
+
+**/
+EFI_STATUS
+EFIAPI
+PxeBcMtftp6TimeoutCallback (
+  IN EFI_MTFTP6_PROTOCOL              *This,
+  IN EFI_MTFTP6_TOKEN                 *Token
+  )
+{
+  PXEBC_PRIVATE_DATA                  *Private;
+
+  Private = (PXEBC_PRIVATE_DATA *) Token->Context;
+  Private->TftpTimeouts++;
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   This function is to get the size of a file using Tftp.
 
@@ -315,7 +343,7 @@ PxeBcMtftp6ReadFile (
   }
 
   Token.CheckPacket     = PxeBcMtftp6CheckPacket;
-  Token.TimeoutCallback = NULL;
+  Token.TimeoutCallback = PxeBcMtftp6TimeoutCallback;
   Token.PacketNeeded    = NULL;
 
   Status = Mtftp6->ReadFile (Mtftp6, &Token);
@@ -483,7 +511,7 @@ PxeBcMtftp6ReadDirectory (
   }
 
   Token.CheckPacket     = PxeBcMtftp6CheckPacket;
-  Token.TimeoutCallback = NULL;
+  Token.TimeoutCallback = PxeBcMtftp6TimeoutCallback;
   Token.PacketNeeded    = NULL;
 
   Status = Mtftp6->ReadDirectory (Mtftp6, &Token);
@@ -576,6 +604,34 @@ PxeBcMtftp4CheckPacket (
 }
 
 
+/**
+  This is a callback function when a packet of Mtftp driver times out.
+
+  The timeouts are counted to adapt the window size of the next download,
+  see PxeBcTftpAdaptWindow().
+
+  @param[in]  This           Pointer to EFI_MTFTP4_PROTOCOL.
+  @param[in]  Token          Pointer to EFI_MTFTP4_TOKEN.
+
+  @retval EFI_SUCCESS    Retransmit the packet and continue.
+
+**/
+EFI_STATUS
+EFIAPI
+PxeBcMtftp4TimeoutCallback (
+  IN EFI_MTFTP4_PROTOCOL              *This,
+  IN EFI_MTFTP4_TOKEN                 *Token
+  )
+{
+  PXEBC_PRIVATE_DATA                  *Private;
+
+  Private = (PXEBC_PRIVATE_DATA *) Token->Context;
+  Private->TftpTimeouts++;
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   This function is to get size of a file using Tftp.
 
@@ -794,7 +850,7 @@ PxeBcMtftp4ReadFile (
   }
 
   Token.CheckPacket     = PxeBcMtftp4CheckPacket;
-  Token.TimeoutCallback = NULL;
+  Token.TimeoutCallback = PxeBcMtftp4TimeoutCallback;
   Token.PacketNeeded    = NULL;
 
   Status = Mtftp4->ReadFile (Mtftp4, &Token);
@@ -962,7 +1018,7 @@ PxeBcMtftp4ReadDirectory (
   }
 
   Token.CheckPacket     = PxeBcMtftp4CheckPacket;
-  Token.TimeoutCallback = NULL;
+  Token.TimeoutCallback = PxeBcMtftp4TimeoutCallback;
   Token.PacketNeeded    = NULL;
 
   Status = Mtftp4->ReadDirectory (Mtftp4, &Token);
@@ -1185,3 +1241,47 @@ PxeBcTftpReadDirectory (
   }
 }
 
+/**
+  Adapt the TFTP window size of the next download to the last one.
+
+  The window is halved if a packet of the download timed out, and doubled
+  after a download without timeout, up to PcdPxeTftpWindowSize. It must only
+  be called after a TFTP read file or read directory request, as write
+  requests don't negotiate a windowsize.
+
+  @param[in, out]  Private        Pointer to PxeBc private data.
+  @param[in]       Status         The status of the download.
+
+**/
+VOID
+PxeBcTftpAdaptWindow (
+  IN OUT PXEBC_PRIVATE_DATA            *Private,
+  IN     EFI_STATUS                    Status
+  )
+{
+  UINTN                                MaxWindowSize;
+  UINTN                                WindowSize;
+
+  MaxWindowSize = (UINTN) PcdGet64 (PcdPxeTftpWindowSize);
+  if (MaxWindowSize <= 1) {
+    return;
+  }
+
+  WindowSize = Private->TftpWindowSize;
+  if (Private->TftpTimeouts != 0) {
+    WindowSize = MAX (WindowSize / 2, 1);
+  } else if (!EFI_ERROR (Status)) {
+    WindowSize = MIN (WindowSize * 2, MaxWindowSize);
+  }
+
+  if (WindowSize != Private->TftpWindowSize) {
+    DEBUG ((
+      DEBUG_INFO,
+      "PxeBcTftpAdaptWindow: %d timeouts, window size %d -> %d\n",
+      Private->TftpTimeouts,
+      Private->TftpWindowSize,
+      WindowSize
+      ));
+    Private->TftpWindowSize = WindowSize;
+  }
+}
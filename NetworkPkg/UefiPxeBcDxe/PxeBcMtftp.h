@@ -135,4 +135,22 @@ PxeBcTftpReadDirectory (
   IN OUT UINT64                        *BufferSize,
   IN     BOOLEAN                       DontUseBuffer
   );
+
+/**
+  Adapt the TFTP window size of the next download to the last one.
+
+  The window is halved if a packet of the download timed out, and doubled
+  after a download without timeout, up to PcdPxeTftpWindowSize. It must only
+  be called after a TFTP read file or read directory request, as write
+  requests don't negotiate a windowsize.
+
+  @param[in, out]  Private        Pointer to PxeBc private data.
+  @param[in]       Status         The status of the download.
+
+**/
+VOID
+PxeBcTftpAdaptWindow (
+  IN OUT PXEBC_PRIVATE_DATA            *Private,
+  IN     EFI_STATUS                    Status
+  );
 #endif
@@ -0,0 +1,816 @@
+/** @file
+  An emulated legacy virtio-net device, so that the frames between two of
+  them go through VirtioNetDxe and its virtio rings.
+
+  The device processes its transmit queue when it is notified, and places
+  the frames in the receive queue of the peer right away. Frames the peer
+  has no receive buffer for wait in its backlog until the driver returns
+  buffers. Like QEMU, the device sets VRING_USED_F_NO_NOTIFY on the receive
+  queue while it has buffers, so the number of notifications per queue
+  tells the VM exits the driver would cause.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VirtioNetLoopbackTest.h"
+
+EFI_GUID  mLoopbackVirtioVendorGuid = {
+  0x5d8c7b1e, 0x3f2a, 0x4c6d, { 0x9b, 0x0e, 0x71, 0x2a, 0x4f, 0x86, 0xc3, 0x19 }
+};
+
+/**
+  Get the size of the virtio-net request header negotiated by the driver.
+
+  @param[in]  Device    The emulated device.
+
+  @return The size of the header.
+
+**/
+UINTN
+LoopbackVirtioHeaderSize (
+  IN LOOPBACK_VIRTIO    *Device
+  )
+{
+  if ((Device->GuestFeatures & VIRTIO_NET_F_MRG_RXBUF) != 0) {
+    return sizeof (VIRTIO_1_0_NET_REQ);
+  }
+
+  return sizeof (VIRTIO_NET_REQ);
+}
+
+/**
+  Place the frames of the backlog of the device in its receive queue,
+  until the queue runs out of buffers.
+
+  @param[in]  Device    The emulated device.
+
+**/
+VOID
+LoopbackVirtioDeliver (
+  IN LOOPBACK_VIRTIO    *Device
+  )
+{
+  LOOPBACK_VIRTIO_QUEUE  *Queue;
+  VRING                  *Ring;
+  LOOPBACK_VIRTIO_FRAME  *Frame;
+  UINT8                  Packet[sizeof (VIRTIO_1_0_NET_REQ) + LOOPBACK_VIRTIO_FRAME_SIZE];
+  UINT8                  *Header;
+  volatile VRING_DESC    *Desc;
+  BOOLEAN                Merge;
+  UINTN                  HeaderSize;
+  UINTN                  Total;
+  UINTN                  Offset;
+  UINTN                  Length;
+  UINT32                 Written;
+  UINT16                 SavedAvail;
+  UINT16                 UsedIdx;
+  UINT16                 NumBuffers;
+  UINT16                 Head;
+  UINT16                 DescIdx;
+
+  Queue = &Device->Queue[VIRTIO_NET_Q_RX];
+  if (!Queue->Ready || ((Device->DeviceStatus & VSTAT_DRIVER_OK) == 0)) {
+    return;
+  }
+
+  Ring       = &Queue->Ring;
+  Merge      = (BOOLEAN) ((Device->GuestFeatures & VIRTIO_NET_F_MRG_RXBUF) != 0);
+  HeaderSize = LoopbackVirtioHeaderSize (Device);
+  UsedIdx    = *Ring->Used.Idx;
+
+  while (Device->BacklogCount != 0) {
+    MemoryFence ();
+    if (Queue->LastAvail == *Ring->Avail.Idx) {
+      //
+      // Ask to be notified once the driver adds buffers.
+      //
+      *Ring->Used.Flags = 0;
+      break;
+    }
+
+    *Ring->Used.Flags = VRING_USED_F_NO_NOTIFY;
+
+    Frame = &Device->Backlog[Device->BacklogHead];
+    ZeroMem (Packet, HeaderSize);
+    CopyMem (Packet + HeaderSize, Frame->Data, Frame->Length);
+    Total = HeaderSize + Frame->Length;
+
+    //
+    // Without mergeable buffers, the frame must fit one descriptor chain.
+    //
+    Header     = NULL;
+    Offset     = 0;
+    NumBuffers = 0;
+    SavedAvail = Queue->LastAvail;
+    while ((Offset < Total) && (Queue->LastAvail != *Ring->Avail.Idx) && (Merge || (NumBuffers == 0))) {
+      Head    = Ring->Avail.Ring[Queue->LastAvail++ % Ring->QueueSize];
+      Written = 0;
+      for (DescIdx = Head; ; DescIdx = Desc->Next) {
+        Desc   = &Ring->Desc[DescIdx];
+        Length = MIN (Desc->Len, Total - Offset);
+        CopyMem ((VOID *) (UINTN) Desc->Addr, Packet + Offset, Length);
+        if (Header == NULL) {
+          Header = (UINT8 *) (UINTN) Desc->Addr;
+        }
+
+        Offset  += Length;
+        Written += (UINT32) Length;
+        if ((Offset == Total) || ((Desc->Flags & VRING_DESC_F_NEXT) == 0)) {
+          break;
+        }
+      }
+
+      Ring->Used.UsedElem[(UINT16) (UsedIdx + NumBuffers) % Ring->QueueSize].Id  = Head;
+      Ring->Used.UsedElem[(UINT16) (UsedIdx + NumBuffers) % Ring->QueueSize].Len = Written;
+      NumBuffers++;
+    }
+
+    if (Offset < Total) {
+      Queue->LastAvail = SavedAvail;
+      if (Merge) {
+        //
+        // Wait for more buffers.
+        //
+        *Ring->Used.Flags = 0;
+        break;
+      }
+
+      //
+      // Too large for a buffer, drop it like QEMU.
+      //
+      Device->DroppedFrames++;
+    } else {
+      if (Merge) {
+        WriteUnaligned16 ((UINT16 *) (Header + OFFSET_OF (VIRTIO_1_0_NET_REQ, NumBuffers)), NumBuffers);
+      }
+
+      UsedIdx = (UINT16) (UsedIdx + NumBuffers);
+      MemoryFence ();
+      *Ring->Used.Idx = UsedIdx;
+
+      Device->RxFrames++;
+      Device->RxBuffers += NumBuffers;
+    }
+
+    Device->BacklogHead = (Device->BacklogHead + 1) % LOOPBACK_VIRTIO_BACKLOG;
+    Device->BacklogCount--;
+  }
+}
+
+/**
+  Send the frames on the transmit queue of the device to the backlog of
+  the peer, and deliver them.
+
+  @param[in]  Device    The emulated device.
+
+**/
+VOID
+LoopbackVirtioTransmit (
+  IN LOOPBACK_VIRTIO    *Device
+  )
+{
+  LOOPBACK_VIRTIO_QUEUE  *Queue;
+  LOOPBACK_VIRTIO        *Peer;
+  VRING                  *Ring;
+  UINT8                  Packet[sizeof (VIRTIO_1_0_NET_REQ) + LOOPBACK_VIRTIO_FRAME_SIZE];
+  LOOPBACK_VIRTIO_FRAME  *Frame;
+  volatile VRING_DESC    *Desc;
+  UINTN                  HeaderSize;
+  UINTN                  Length;
+  BOOLEAN                Truncated;
+  UINT16                 UsedIdx;
+  UINT16                 Head;
+  UINT16                 DescIdx;
+
+  Queue = &Device->Queue[VIRTIO_NET_Q_TX];
+  if (!Queue->Ready || ((Device->DeviceStatus & VSTAT_DRIVER_OK) == 0)) {
+    return;
+  }
+
+  Ring       = &Queue->Ring;
+  Peer       = Device->Peer;
+  HeaderSize = LoopbackVirtioHeaderSize (Device);
+  UsedIdx    = *Ring->Used.Idx;
+
+  MemoryFence ();
+  while (Queue->LastAvail != *Ring->Avail.Idx) {
+    MemoryFence ();
+    Head = Ring->Avail.Ring[Queue->LastAvail++ % Ring->QueueSize];
+
+    Length    = 0;
+    Truncated = FALSE;
+    for (DescIdx = Head; ; DescIdx = Desc->Next) {
+      Desc = &Ring->Desc[DescIdx];
+      if (Length + Desc->Len > sizeof (Packet)) {
+        Truncated = TRUE;
+      } else {
+        CopyMem (Packet + Length, (VOID *) (UINTN) Desc->Addr, Desc->Len);
+        Length += Desc->Len;
+      }
+
+      if ((Desc->Flags & VRING_DESC_F_NEXT) == 0) {
+        break;
+      }
+    }
+
+    Device->TxFrames++;
+    if (Truncated || (Length <= HeaderSize) ||
+        ((Peer->DeviceStatus & VSTAT_DRIVER_OK) == 0) ||
+        (Peer->BacklogCount == LOOPBACK_VIRTIO_BACKLOG)) {
+      Device->DroppedFrames++;
+    } else {
+      Frame = &Peer->Backlog[(Peer->BacklogHead + Peer->BacklogCount) % LOOPBACK_VIRTIO_BACKLOG];
+      Frame->Length = Length - HeaderSize;
+      CopyMem (Frame->Data, Packet + HeaderSize, Frame->Length);
+      Peer->BacklogCount++;
+    }
+
+    Ring->Used.UsedElem[UsedIdx % Ring->QueueSize].Id  = Head;
+    Ring->Used.UsedElem[UsedIdx % Ring->QueueSize].Len = 0;
+    UsedIdx++;
+    MemoryFence ();
+    *Ring->Used.Idx = UsedIdx;
+  }
+
+  LoopbackVirtioDeliver (Peer);
+}
+
+/**
+  Read the device features.
+
+  @param[in]   This             The virtio device.
+  @param[out]  DeviceFeatures   The features of the device.
+
+  @retval EFI_SUCCESS           The features were read.
+  @retval EFI_INVALID_PARAMETER DeviceFeatures is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioGetDeviceFeatures (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  OUT UINT64                  *DeviceFeatures
+  )
+{
+  if (DeviceFeatures == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *DeviceFeatures = LOOPBACK_VIRTIO_FROM_VIRTIO (This)->DeviceFeatures;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write the features the driver accepted.
+
+  @param[in]  This              The virtio device.
+  @param[in]  Features          The accepted features.
+
+  @retval EFI_SUCCESS           The features were written.
+  @retval EFI_UNSUPPORTED       The device doesn't offer some of the features.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetGuestFeatures (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT64                  Features
+  )
+{
+  LOOPBACK_VIRTIO  *Device;
+
+  Device = LOOPBACK_VIRTIO_FROM_VIRTIO (This);
+  if ((Features & ~Device->DeviceFeatures) != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Device->GuestFeatures = Features;
+  return EFI_SUCCESS;
+}
+
+/**
+  Set the rings of the selected queue.
+
+  @param[in]  This              The virtio device.
+  @param[in]  Ring              The rings of the queue.
+  @param[in]  RingBaseShift     Offset of the device addresses of the rings.
+
+  @retval EFI_SUCCESS           The queue is ready.
+  @retval EFI_UNSUPPORTED       The rings aren't identity mapped.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetQueueAddress (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN VRING                   *Ring,
+  IN UINT64                  RingBaseShift
+  )
+{
+  LOOPBACK_VIRTIO        *Device;
+  LOOPBACK_VIRTIO_QUEUE  *Queue;
+
+  if (RingBaseShift != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Device = LOOPBACK_VIRTIO_FROM_VIRTIO (This);
+  Queue  = &Device->Queue[Device->QueueSel];
+
+  CopyMem (&Queue->Ring, Ring, sizeof (VRING));
+  Queue->LastAvail = 0;
+  Queue->Ready     = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Select the queue the queue operations apply to.
+
+  @param[in]  This              The virtio device.
+  @param[in]  Index             The queue.
+
+  @retval EFI_SUCCESS           The queue is selected.
+  @retval EFI_INVALID_PARAMETER The queue doesn't exist.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetQueueSel (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT16                  Index
+  )
+{
+  if (Index > VIRTIO_NET_Q_TX) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  LOOPBACK_VIRTIO_FROM_VIRTIO (This)->QueueSel = Index;
+  return EFI_SUCCESS;
+}
+
+/**
+  Notify the device of new buffers on a queue.
+
+  @param[in]  This              The virtio device.
+  @param[in]  Index             The queue.
+
+  @retval EFI_SUCCESS           The queue has been processed.
+  @retval EFI_INVALID_PARAMETER The queue doesn't exist.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetQueueNotify (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT16                  Index
+  )
+{
+  LOOPBACK_VIRTIO  *Device;
+
+  if (Index > VIRTIO_NET_Q_TX) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Device = LOOPBACK_VIRTIO_FROM_VIRTIO (This);
+  Device->Notifies[Index]++;
+
+  if (Index == VIRTIO_NET_Q_TX) {
+    LoopbackVirtioTransmit (Device);
+  } else {
+    LoopbackVirtioDeliver (Device);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Set the alignment of the queue, or the page size, which the device
+  doesn't care about.
+
+  @param[in]  This              The virtio device.
+  @param[in]  Value             The alignment or page size.
+
+  @retval EFI_SUCCESS           Always.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetAlignment (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT32                  Value
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the maximum size of the selected queue.
+
+  @param[in]   This             The virtio device.
+  @param[out]  QueueNumMax      The maximum size.
+
+  @retval EFI_SUCCESS           The size was read.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioGetQueueNumMax (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  OUT UINT16                  *QueueNumMax
+  )
+{
+  *QueueNumMax = LOOPBACK_VIRTIO_FROM_VIRTIO (This)->QueueSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Set the size of the selected queue.
+
+  @param[in]  This              The virtio device.
+  @param[in]  QueueSize         The size.
+
+  @retval EFI_SUCCESS           The size is valid.
+  @retval EFI_INVALID_PARAMETER The size is too large.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetQueueNum (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT16                  QueueSize
+  )
+{
+  return (QueueSize > LOOPBACK_VIRTIO_FROM_VIRTIO (This)->QueueSize) ? EFI_INVALID_PARAMETER : EFI_SUCCESS;
+}
+
+/**
+  Read the device status.
+
+  @param[in]   This             The virtio device.
+  @param[out]  DeviceStatus     The device status.
+
+  @retval EFI_SUCCESS           The status was read.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioGetDeviceStatus (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  OUT UINT8                   *DeviceStatus
+  )
+{
+  *DeviceStatus = LOOPBACK_VIRTIO_FROM_VIRTIO (This)->DeviceStatus;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write the device status, zero resets the device.
+
+  @param[in]  This              The virtio device.
+  @param[in]  DeviceStatus      The device status.
+
+  @retval EFI_SUCCESS           The status was written.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioSetDeviceStatus (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT8                   DeviceStatus
+  )
+{
+  LOOPBACK_VIRTIO  *Device;
+
+  Device               = LOOPBACK_VIRTIO_FROM_VIRTIO (This);
+  Device->DeviceStatus = DeviceStatus;
+
+  if (DeviceStatus == 0) {
+    ZeroMem (Device->Queue, sizeof (Device->Queue));
+    Device->GuestFeatures = 0;
+    Device->BacklogCount  = 0;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Write the device configuration, which is read-only.
+
+  @param[in]  This              The virtio device.
+  @param[in]  FieldOffset       The offset of the field.
+  @param[in]  FieldSize         The size of the field.
+  @param[in]  Value             The value to write.
+
+  @retval EFI_UNSUPPORTED       Always.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioWriteDevice (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINTN                   FieldOffset,
+  IN UINTN                   FieldSize,
+  IN UINT64                  Value
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Read the device configuration: the MAC address and the link status.
+
+  @param[in]   This             The virtio device.
+  @param[in]   FieldOffset      The offset of the field.
+  @param[in]   FieldSize        The size of the field.
+  @param[in]   BufferSize       The size of Buffer.
+  @param[out]  Buffer           The value read.
+
+  @retval EFI_SUCCESS           The field was read.
+  @retval EFI_INVALID_PARAMETER The field is outside the configuration.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioReadDevice (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  IN  UINTN                   FieldOffset,
+  IN  UINTN                   FieldSize,
+  IN  UINTN                   BufferSize,
+  OUT VOID                    *Buffer
+  )
+{
+  VIRTIO_NET_CONFIG  Config;
+
+  if ((FieldSize != BufferSize) || (FieldOffset + FieldSize > sizeof (Config))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CopyMem (Config.Mac, &LOOPBACK_VIRTIO_FROM_VIRTIO (This)->Mac, sizeof (Config.Mac));
+  Config.LinkStatus = VIRTIO_NET_S_LINK_UP;
+
+  CopyMem (Buffer, (UINT8 *) &Config + FieldOffset, FieldSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate pages shared with the device, all the memory is.
+
+  @param[in]       This         The virtio device.
+  @param[in]       Pages        The number of pages.
+  @param[in, out]  HostAddress  The allocated pages.
+
+  @retval EFI_SUCCESS           The pages were allocated.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the pages.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioAllocateSharedPages (
+  IN     VIRTIO_DEVICE_PROTOCOL  *This,
+  IN     UINTN                   Pages,
+  IN OUT VOID                    **HostAddress
+  )
+{
+  *HostAddress = AllocatePages (Pages);
+  return (*HostAddress == NULL) ? EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
+}
+
+/**
+  Free pages allocated by LoopbackVirtioAllocateSharedPages().
+
+  @param[in]  This              The virtio device.
+  @param[in]  Pages             The number of pages.
+  @param[in]  HostAddress       The pages.
+
+**/
+VOID
+EFIAPI
+LoopbackVirtioFreeSharedPages (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINTN                   Pages,
+  IN VOID                    *HostAddress
+  )
+{
+  FreePages (HostAddress, Pages);
+}
+
+/**
+  Map a buffer for the device, which uses the host addresses.
+
+  @param[in]       This           The virtio device.
+  @param[in]       Operation      The access of the device.
+  @param[in]       HostAddress    The buffer.
+  @param[in, out]  NumberOfBytes  The size of the buffer.
+  @param[out]      DeviceAddress  The address of the buffer for the device.
+  @param[out]      Mapping        The token to unmap the buffer.
+
+  @retval EFI_SUCCESS           The buffer is mapped.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioMapSharedBuffer (
+  IN     VIRTIO_DEVICE_PROTOCOL  *This,
+  IN     VIRTIO_MAP_OPERATION    Operation,
+  IN     VOID                    *HostAddress,
+  IN OUT UINTN                   *NumberOfBytes,
+  OUT    EFI_PHYSICAL_ADDRESS    *DeviceAddress,
+  OUT    VOID                    **Mapping
+  )
+{
+  *DeviceAddress = (EFI_PHYSICAL_ADDRESS) (UINTN) HostAddress;
+  *Mapping       = HostAddress;
+  return EFI_SUCCESS;
+}
+
+/**
+  Unmap a buffer mapped by LoopbackVirtioMapSharedBuffer().
+
+  @param[in]  This              The virtio device.
+  @param[in]  Mapping           The token of the mapping.
+
+  @retval EFI_SUCCESS           The buffer is unmapped.
+
+**/
+EFI_STATUS
+EFIAPI
+LoopbackVirtioUnmapSharedBuffer (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN VOID                    *Mapping
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Create an emulated virtio-net device, and install the virtio device
+  protocol and Device Path Protocol on a new handle.
+
+  @param[in]   Index      Index of the device, the last byte of its MAC.
+  @param[in]   Features   The virtio-net features offered besides the MAC
+                          address and the link status.
+  @param[in]   QueueSize  The size of the queues of the device.
+  @param[out]  Device     The created device.
+
+  @retval EFI_SUCCESS            The device is created.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
+  @retval Others                 Failed to install the protocols.
+
+**/
+EFI_STATUS
+LoopbackVirtioCreate (
+  IN  UINT8             Index,
+  IN  UINT64            Features,
+  IN  UINT16            QueueSize,
+  OUT LOOPBACK_VIRTIO   **Device
+  )
+{
+  LOOPBACK_VIRTIO              *Instance;
+  LOOPBACK_VIRTIO_DEVICE_PATH  *DevicePath;
+  EFI_STATUS                   Status;
+
+  Instance = AllocateZeroPool (sizeof (LOOPBACK_VIRTIO));
+  if (Instance == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Instance->Backlog = AllocatePool (LOOPBACK_VIRTIO_BACKLOG * sizeof (LOOPBACK_VIRTIO_FRAME));
+  if (Instance->Backlog == NULL) {
+    FreePool (Instance);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Instance->Signature      = LOOPBACK_VIRTIO_SIGNATURE;
+  Instance->DeviceFeatures = VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | Features;
+  Instance->QueueSize      = QueueSize;
+
+  //
+  // Locally administered unicast address 02-00-00-00-00-<Index>
+  //
+  Instance->Mac.Addr[0] = 0x02;
+  Instance->Mac.Addr[5] = Index;
+
+  Instance->VirtIo.Revision            = VIRTIO_SPEC_REVISION (0, 9, 5);
+  Instance->VirtIo.SubSystemDeviceId   = VIRTIO_SUBSYSTEM_NETWORK_CARD;
+  Instance->VirtIo.GetDeviceFeatures   = LoopbackVirtioGetDeviceFeatures;
+  Instance->VirtIo.SetGuestFeatures    = LoopbackVirtioSetGuestFeatures;
+  Instance->VirtIo.SetQueueAddress     = LoopbackVirtioSetQueueAddress;
+  Instance->VirtIo.SetQueueSel         = LoopbackVirtioSetQueueSel;
+  Instance->VirtIo.SetQueueNotify      = LoopbackVirtioSetQueueNotify;
+  Instance->VirtIo.SetQueueAlign       = LoopbackVirtioSetAlignment;
+  Instance->VirtIo.SetPageSize         = LoopbackVirtioSetAlignment;
+  Instance->VirtIo.GetQueueNumMax      = LoopbackVirtioGetQueueNumMax;
+  Instance->VirtIo.SetQueueNum         = LoopbackVirtioSetQueueNum;
+  Instance->VirtIo.GetDeviceStatus     = LoopbackVirtioGetDeviceStatus;
+  Instance->VirtIo.SetDeviceStatus     = LoopbackVirtioSetDeviceStatus;
+  Instance->VirtIo.WriteDevice         = LoopbackVirtioWriteDevice;
+  Instance->VirtIo.ReadDevice          = LoopbackVirtioReadDevice;
+  Instance->VirtIo.AllocateSharedPages = LoopbackVirtioAllocateSharedPages;
+  Instance->VirtIo.FreeSharedPages     = LoopbackVirtioFreeSharedPages;
+  Instance->VirtIo.MapSharedBuffer     = LoopbackVirtioMapSharedBuffer;
+  Instance->VirtIo.UnmapSharedBuffer   = LoopbackVirtioUnmapSharedBuffer;
+
+  //
+  // VirtioNetDxe appends the MAC address node itself.
+  //
+  DevicePath = &Instance->DevicePath;
+  DevicePath->Vendor.Header.Type    = HARDWARE_DEVICE_PATH;
+  DevicePath->Vendor.Header.SubType = HW_VENDOR_DP;
+  SetDevicePathNodeLength (&DevicePath->Vendor.Header, sizeof (VENDOR_DEVICE_PATH));
+  CopyGuid (&DevicePath->Vendor.Guid, &mLoopbackVirtioVendorGuid);
+  DevicePath->Vendor.Guid.Data4[7] = Index;
+  SetDevicePathEndNode (&DevicePath->End);
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Instance->DeviceHandle,
+                  &gVirtioDeviceProtocolGuid,
+                  &Instance->VirtIo,
+                  &gEfiDevicePathProtocolGuid,
+                  &Instance->DevicePath,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Instance->Backlog);
+    FreePool (Instance);
+    return Status;
+  }
+
+  *Device = Instance;
+  return EFI_SUCCESS;
+}
+
+/**
+  Connect VirtioNetDxe to the emulated device, and find the Simple Network
+  child it creates.
+
+  @param[in, out]  Device   The device created by LoopbackVirtioCreate().
+
+  @retval EFI_SUCCESS       The Simple Network child is created.
+  @retval EFI_NOT_FOUND     VirtioNetDxe isn't loaded.
+
+**/
+EFI_STATUS
+LoopbackVirtioConnect (
+  IN OUT LOOPBACK_VIRTIO  *Device
+  )
+{
+  EFI_OPEN_PROTOCOL_INFORMATION_ENTRY  *OpenInfo;
+  UINTN                                Count;
+  UINTN                                Index;
+  EFI_STATUS                           Status;
+
+  gBS->ConnectController (Device->DeviceHandle, NULL, NULL, FALSE);
+
+  Status = gBS->OpenProtocolInformation (Device->DeviceHandle, &gVirtioDeviceProtocolGuid, &OpenInfo, &Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if ((OpenInfo[Index].Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) != 0) {
+      Device->SnpHandle = OpenInfo[Index].ControllerHandle;
+      break;
+    }
+  }
+
+  FreePool (OpenInfo);
+  return (Device->SnpHandle != NULL) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+/**
+  Disconnect VirtioNetDxe, uninstall the protocols of the emulated device
+  and free it.
+
+  @param[in]  Device    The device to destroy.
+
+**/
+VOID
+LoopbackVirtioDestroy (
+  IN LOOPBACK_VIRTIO    *Device
+  )
+{
+  EFI_STATUS  Status;
+
+  gBS->DisconnectController (Device->DeviceHandle, NULL, NULL);
+
+  Status = gBS->UninstallMultipleProtocolInterfaces (
+                  Device->DeviceHandle,
+                  &gVirtioDeviceProtocolGuid,
+                  &Device->VirtIo,
+                  &gEfiDevicePathProtocolGuid,
+                  &Device->DevicePath,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    //
+    // Some driver still holds the device, leak it rather than leaving a
+    // dangling protocol interface.
+    //
+    DEBUG ((DEBUG_ERROR, "LoopbackVirtioDestroy: failed to uninstall the device - %r\n", Status));
+    return;
+  }
+
+  FreePool (Device->Backlog);
+  FreePool (Device);
+}
@@ -0,0 +1,392 @@
+/** @file
+  A shell application to measure the frame throughput of VirtioNetDxe.
+
+  Two emulated virtio-net devices are connected back to back, and
+  VirtioNetDxe, which must be loaded, binds to both of them. Frames of a
+  fixed size are sent through the Simple Network Protocol of the first
+  device and received through that of the second, the way MNP drives them,
+  so the rings, the receive buffers and the queue notifications of the
+  driver are exercised without a VMM. The received frames are checked for
+  their size and order.
+
+  The throughput is reported along with the number of queue notifications,
+  the VM exits of a real device, and the receive buffers each frame took.
+
+  A platform TimerLib is required to measure the time.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VirtioNetLoopbackTest.h"
+
+#define VIRTIO_NET_LOOPBACK_FRAMES      1000000
+#define VIRTIO_NET_LOOPBACK_TX_BUFFERS  LOOPBACK_VIRTIO_QUEUE_SIZE_MAX
+#define VIRTIO_NET_LOOPBACK_ETHER_TYPE  0x88B5   ///< IEEE local experimental.
+#define VIRTIO_NET_LOOPBACK_SEQ_OFFSET  14       ///< The sequence number follows the media header.
+
+SHELL_PARAM_ITEM  mVirtioNetLoopbackParamList[] = {
+  { L"-f", TypeValue },
+  { L"-s", TypeValue },
+  { L"-q", TypeValue },
+  { L"-n", TypeFlag  },
+  { L"-?", TypeFlag  },
+  { NULL,  TypeMax   }
+};
+
+///
+/// The result of a run.
+///
+typedef struct {
+  UINT64    Sent;
+  UINT64    Received;
+  UINT64    Elapsed;        ///< In nanoseconds.
+} VIRTIO_NET_LOOPBACK_RESULT;
+
+/**
+  Get the current time.
+
+  @return The current time in nanoseconds.
+
+**/
+UINT64
+VirtioNetLoopbackGetTime (
+  VOID
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Get the decimal value of a command line option.
+
+  @param[in]  Package   The parsed command line.
+  @param[in]  Name      The name of the option.
+  @param[in]  Default   The value if the option is absent.
+
+  @return The value of the option.
+
+**/
+UINT64
+VirtioNetLoopbackGetValue (
+  IN LIST_ENTRY     *Package,
+  IN CHAR16         *Name,
+  IN UINT64         Default
+  )
+{
+  CONST CHAR16  *Value;
+
+  Value = ShellCommandLineGetValue (Package, Name);
+  if (Value == NULL) {
+    return Default;
+  }
+
+  return StrDecimalToUint64 (Value);
+}
+
+/**
+  Start and initialize a Simple Network instance.
+
+  @param[in]  Snp       The Simple Network instance.
+
+  @retval EFI_SUCCESS   The instance is initialized.
+  @retval Others        Failed to start or initialize the instance.
+
+**/
+EFI_STATUS
+VirtioNetLoopbackInitSnp (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *Snp
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = Snp->Start (Snp);
+  if (EFI_ERROR (Status) && (Status != EFI_ALREADY_STARTED)) {
+    return Status;
+  }
+
+  return Snp->Initialize (Snp, 0, 0);
+}
+
+/**
+  Send frames from one Simple Network instance to the other, and receive
+  them, until all have been received or the frames stop flowing.
+
+  Transmit is called until the driver runs out of transmit buffers, then
+  the completed transmit buffers are recycled, then Receive is called until
+  there is no frame left, as the poll of MNP does.
+
+  @param[in]   Tx         The sending instance.
+  @param[in]   Rx         The receiving instance.
+  @param[in]   FrameSize  The size of the frames, including the media header.
+  @param[in]   Frames     The number of frames to send.
+  @param[out]  Result     The result of the run.
+
+  @retval EFI_SUCCESS           The frames were sent, some may be lost.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the transmit buffers.
+  @retval EFI_DEVICE_ERROR      A frame was received corrupted or out of order.
+  @retval Others                Transmit or Receive failed.
+
+**/
+EFI_STATUS
+VirtioNetLoopbackRun (
+  IN  EFI_SIMPLE_NETWORK_PROTOCOL  *Tx,
+  IN  EFI_SIMPLE_NETWORK_PROTOCOL  *Rx,
+  IN  UINTN                        FrameSize,
+  IN  UINT64                       Frames,
+  OUT VIRTIO_NET_LOOPBACK_RESULT   *Result
+  )
+{
+  UINT8       *TxBuffers;
+  UINT8       **FreeBuffers;
+  UINTN       FreeCount;
+  UINT8       *Buffer;
+  VOID        *Done;
+  UINT8       RxBuffer[LOOPBACK_VIRTIO_FRAME_SIZE];
+  UINTN       RxSize;
+  UINT64      Sequence;
+  UINT64      Expected;
+  UINT64      Start;
+  BOOLEAN     Progress;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  ZeroMem (Result, sizeof (*Result));
+
+  TxBuffers   = AllocatePool (VIRTIO_NET_LOOPBACK_TX_BUFFERS * FrameSize);
+  FreeBuffers = AllocatePool (VIRTIO_NET_LOOPBACK_TX_BUFFERS * sizeof (UINT8 *));
+  if ((TxBuffers == NULL) || (FreeBuffers == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  //
+  // VirtioNetDxe tells the transmitted frames apart by their buffer, so
+  // each frame in flight has its own.
+  //
+  for (Index = 0; Index < VIRTIO_NET_LOOPBACK_TX_BUFFERS; Index++) {
+    Buffer = TxBuffers + Index * FrameSize;
+    SetMem (Buffer, FrameSize, (UINT8) Index);
+    CopyMem (Buffer, &Rx->Mode->CurrentAddress, LOOPBACK_VIRTIO_MAC_SIZE);
+    CopyMem (Buffer + LOOPBACK_VIRTIO_MAC_SIZE, &Tx->Mode->CurrentAddress, LOOPBACK_VIRTIO_MAC_SIZE);
+    Buffer[2 * LOOPBACK_VIRTIO_MAC_SIZE]     = (UINT8) (VIRTIO_NET_LOOPBACK_ETHER_TYPE >> 8);
+    Buffer[2 * LOOPBACK_VIRTIO_MAC_SIZE + 1] = (UINT8) VIRTIO_NET_LOOPBACK_ETHER_TYPE;
+    FreeBuffers[Index] = Buffer;
+  }
+
+  FreeCount = VIRTIO_NET_LOOPBACK_TX_BUFFERS;
+  Expected  = 0;
+  Status    = EFI_SUCCESS;
+  Start     = VirtioNetLoopbackGetTime ();
+
+  while (Expected < Frames) {
+    Progress = FALSE;
+
+    while ((Result->Sent < Frames) && (FreeCount > 0)) {
+      Buffer = FreeBuffers[FreeCount - 1];
+      WriteUnaligned64 ((UINT64 *) (Buffer + VIRTIO_NET_LOOPBACK_SEQ_OFFSET), Result->Sent);
+      Status = Tx->Transmit (Tx, 0, FrameSize, Buffer, NULL, NULL, NULL);
+      if (Status == EFI_NOT_READY) {
+        break;
+      }
+
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+
+      FreeCount--;
+      Result->Sent++;
+      Progress = TRUE;
+    }
+
+    for (;;) {
+      Done   = NULL;
+      Status = Tx->GetStatus (Tx, NULL, &Done);
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+
+      if (Done == NULL) {
+        break;
+      }
+
+      FreeBuffers[FreeCount++] = Done;
+      Progress = TRUE;
+    }
+
+    for (;;) {
+      RxSize = sizeof (RxBuffer);
+      Status = Rx->Receive (Rx, NULL, &RxSize, RxBuffer, NULL, NULL, NULL);
+      if (Status == EFI_NOT_READY) {
+        break;
+      }
+
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+
+      Sequence = ReadUnaligned64 ((UINT64 *) (RxBuffer + VIRTIO_NET_LOOPBACK_SEQ_OFFSET));
+      if ((RxSize != FrameSize) || (Sequence < Expected) || (Sequence >= Result->Sent)) {
+        Status = EFI_DEVICE_ERROR;
+        goto ON_EXIT;
+      }
+
+      Expected = Sequence + 1;
+      Result->Received++;
+      Progress = TRUE;
+    }
+
+    if (!Progress) {
+      //
+      // The last frames were lost.
+      //
+      break;
+    }
+  }
+
+  Result->Elapsed = VirtioNetLoopbackGetTime () - Start;
+  Status          = EFI_SUCCESS;
+
+ON_EXIT:
+  if (TxBuffers != NULL) {
+    FreePool (TxBuffers);
+  }
+
+  if (FreeBuffers != NULL) {
+    FreePool (FreeBuffers);
+  }
+
+  return Status;
+}
+
+/**
+  The entry point of VirtioNetLoopbackTest.
+
+  @param[in]  ImageHandle   The image handle of the application.
+  @param[in]  SystemTable   The EFI system table.
+
+  @retval EFI_SUCCESS       The test is done.
+  @retval Others            The test failed.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioNetLoopbackTestMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  LIST_ENTRY                   *Package;
+  CHAR16                       *ProblemParam;
+  LOOPBACK_VIRTIO              *Device[2];
+  EFI_SIMPLE_NETWORK_PROTOCOL  *Snp[2];
+  VIRTIO_NET_LOOPBACK_RESULT   Result;
+  UINT64                       Frames;
+  UINT64                       FrameSize;
+  UINT64                       QueueSize;
+  UINT64                       Features;
+  UINT64                       Elapsed;
+  UINTN                        Index;
+  EFI_STATUS                   Status;
+
+  Status = ShellCommandLineParse (mVirtioNetLoopbackParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    Print (L"Invalid parameter %s\n", ProblemParam);
+    return Status;
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-?")) {
+    Print (L"VirtioNetLoopbackTest [-f Frames] [-s Size] [-q QueueSize] [-n]\n");
+    Print (L"  -f  Number of frames to send, %d by default.\n", VIRTIO_NET_LOOPBACK_FRAMES);
+    Print (L"  -s  Size of the frames in bytes, %d by default.\n", LOOPBACK_VIRTIO_FRAME_SIZE);
+    Print (L"  -q  Size of the queues of the devices, %d by default.\n", LOOPBACK_VIRTIO_QUEUE_SIZE);
+    Print (L"  -n  Don't offer mergeable receive buffers.\n");
+    ShellCommandLineFreeVarList (Package);
+    return EFI_SUCCESS;
+  }
+
+  Frames    = VirtioNetLoopbackGetValue (Package, L"-f", VIRTIO_NET_LOOPBACK_FRAMES);
+  FrameSize = VirtioNetLoopbackGetValue (Package, L"-s", LOOPBACK_VIRTIO_FRAME_SIZE);
+  QueueSize = VirtioNetLoopbackGetValue (Package, L"-q", LOOPBACK_VIRTIO_QUEUE_SIZE);
+  Features  = ShellCommandLineGetFlag (Package, L"-n") ? 0 : VIRTIO_NET_F_MRG_RXBUF;
+
+  ShellCommandLineFreeVarList (Package);
+
+  if ((Frames == 0) ||
+      (FrameSize < VIRTIO_NET_LOOPBACK_SEQ_OFFSET + sizeof (UINT64)) || (FrameSize > LOOPBACK_VIRTIO_FRAME_SIZE) ||
+      (QueueSize < 2) || (QueueSize > LOOPBACK_VIRTIO_QUEUE_SIZE_MAX)) {
+    Print (L"Invalid parameter\n");
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Device[0] = NULL;
+  Device[1] = NULL;
+
+  for (Index = 0; Index < 2; Index++) {
+    Status = LoopbackVirtioCreate ((UINT8) (Index + 1), Features, (UINT16) QueueSize, &Device[Index]);
+    if (EFI_ERROR (Status)) {
+      Print (L"Failed to create the virtio-net device - %r\n", Status);
+      goto ON_EXIT;
+    }
+  }
+
+  Device[0]->Peer = Device[1];
+  Device[1]->Peer = Device[0];
+
+  for (Index = 0; Index < 2; Index++) {
+    Status = LoopbackVirtioConnect (Device[Index]);
+    if (EFI_ERROR (Status)) {
+      Print (L"VirtioNetDxe is not loaded\n");
+      goto ON_EXIT;
+    }
+
+    Status = gBS->HandleProtocol (Device[Index]->SnpHandle, &gEfiSimpleNetworkProtocolGuid, (VOID **) &Snp[Index]);
+    if (!EFI_ERROR (Status)) {
+      Status = VirtioNetLoopbackInitSnp (Snp[Index]);
+    }
+
+    if (EFI_ERROR (Status)) {
+      Print (L"Failed to initialize the Simple Network Protocol - %r\n", Status);
+      goto ON_EXIT;
+    }
+  }
+
+  Status = VirtioNetLoopbackRun (Snp[0], Snp[1], (UINTN) FrameSize, Frames, &Result);
+  if (EFI_ERROR (Status)) {
+    Print (L"Failed after %Ld frames - %r\n", Result.Received, Status);
+    goto ON_EXIT;
+  }
+
+  Elapsed = MAX (Result.Elapsed, 1);
+  Print (
+    L"%Ld of %Ld frames of %Ld bytes in %Ld us, %Ld frames/s, %Ld Mbit/s\n",
+    Result.Received,
+    Result.Sent,
+    FrameSize,
+    DivU64x32 (Elapsed, 1000),
+    DivU64x64Remainder (MultU64x32 (Result.Received, 1000000000), Elapsed, NULL),
+    DivU64x64Remainder (MultU64x32 (MultU64x64 (Result.Received, FrameSize), 8000), Elapsed, NULL)
+    );
+  Print (
+    L"Mergeable receive buffers %a, queue size %Ld, %Ld frames lost\n",
+    ((Device[1]->GuestFeatures & VIRTIO_NET_F_MRG_RXBUF) != 0) ? "on" : "off",
+    QueueSize,
+    Result.Sent - Result.Received
+    );
+  Print (
+    L"Queue notifications TX %Ld, RX %Ld, %Ld frames per TX notification, %Ld receive buffers\n",
+    Device[0]->Notifies[VIRTIO_NET_Q_TX],
+    Device[1]->Notifies[VIRTIO_NET_Q_RX],
+    DivU64x64Remainder (Result.Sent, MAX (Device[0]->Notifies[VIRTIO_NET_Q_TX], 1), NULL),
+    Device[1]->RxBuffers
+    );
+
+ON_EXIT:
+  for (Index = 0; Index < 2; Index++) {
+    if (Device[Index] != NULL) {
+      LoopbackVirtioDestroy (Device[Index]);
+    }
+  }
+
+  return Status;
+}
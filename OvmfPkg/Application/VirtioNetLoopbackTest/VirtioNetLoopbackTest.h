@@ -0,0 +1,162 @@
+/** @file
+  Internal definitions of VirtioNetLoopbackTest, a shell application which
+  measures the frame throughput of VirtioNetDxe over a pair of emulated
+  virtio-net devices connected back to back.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VIRTIO_NET_LOOPBACK_TEST_H_
+#define _VIRTIO_NET_LOOPBACK_TEST_H_
+
+#include <Uefi.h>
+
+#include <IndustryStandard/VirtioNet.h>
+
+#include <Protocol/DevicePath.h>
+#include <Protocol/SimpleNetwork.h>
+#include <Protocol/VirtioDevice.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/ShellLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#define LOOPBACK_VIRTIO_SIGNATURE  SIGNATURE_32 ('L', 'B', 'V', 'N')
+
+//
+// The largest frame on the wire, including the media header, and the size
+// of the MAC addresses in it.
+//
+#define LOOPBACK_VIRTIO_FRAME_SIZE     1514
+#define LOOPBACK_VIRTIO_MAC_SIZE       6
+
+//
+// The default size of the queues of the emulated device, that of QEMU,
+// and the largest size it may be set to, that of the QEMU rx_queue_size.
+//
+#define LOOPBACK_VIRTIO_QUEUE_SIZE     256
+#define LOOPBACK_VIRTIO_QUEUE_SIZE_MAX 1024
+
+//
+// Number of frames the device holds while the driver has no receive
+// buffer for them, the backlog of the QEMU network backend.
+//
+#define LOOPBACK_VIRTIO_BACKLOG        1024
+
+///
+/// A frame waiting for a receive buffer of the device.
+///
+typedef struct {
+  UINTN     Length;
+  UINT8     Data[LOOPBACK_VIRTIO_FRAME_SIZE];
+} LOOPBACK_VIRTIO_FRAME;
+
+///
+/// A queue of the emulated device, as set up by VirtioNetDxe.
+///
+typedef struct {
+  VRING     Ring;         ///< Copied by SetQueueAddress().
+  BOOLEAN   Ready;
+  UINT16    LastAvail;    ///< Next entry of the available ring to process.
+} LOOPBACK_VIRTIO_QUEUE;
+
+#pragma pack(1)
+typedef struct {
+  VENDOR_DEVICE_PATH          Vendor;
+  EFI_DEVICE_PATH_PROTOCOL    End;
+} LOOPBACK_VIRTIO_DEVICE_PATH;
+#pragma pack()
+
+typedef struct _LOOPBACK_VIRTIO  LOOPBACK_VIRTIO;
+
+///
+/// An emulated legacy virtio-net device, connected to its peer by an
+/// in-memory wire which neither drops nor delays the frames.
+///
+struct _LOOPBACK_VIRTIO {
+  UINT32                        Signature;
+  VIRTIO_DEVICE_PROTOCOL        VirtIo;
+  LOOPBACK_VIRTIO_DEVICE_PATH   DevicePath;
+  EFI_HANDLE                    DeviceHandle;
+  EFI_HANDLE                    SnpHandle;      ///< The Simple Network child of VirtioNetDxe.
+  LOOPBACK_VIRTIO               *Peer;
+  EFI_MAC_ADDRESS               Mac;
+
+  LOOPBACK_VIRTIO_QUEUE         Queue[2];
+  UINT16                        QueueSel;
+  UINT16                        QueueSize;
+  UINT64                        DeviceFeatures;
+  UINT64                        GuestFeatures;
+  UINT8                         DeviceStatus;
+
+  LOOPBACK_VIRTIO_FRAME         *Backlog;
+  UINTN                         BacklogHead;
+  UINTN                         BacklogCount;
+
+  UINT64                        Notifies[2];    ///< SetQueueNotify() calls per queue.
+  UINT64                        TxFrames;       ///< Frames taken from the transmit queue.
+  UINT64                        RxFrames;       ///< Frames placed in the receive queue.
+  UINT64                        RxBuffers;      ///< Receive buffers the frames took.
+  UINT64                        DroppedFrames;  ///< Frames dropped with the backlog full.
+};
+
+#define LOOPBACK_VIRTIO_FROM_VIRTIO(a)  CR (a, LOOPBACK_VIRTIO, VirtIo, LOOPBACK_VIRTIO_SIGNATURE)
+
+/**
+  Create an emulated virtio-net device, and install the virtio device
+  protocol and Device Path Protocol on a new handle.
+
+  @param[in]   Index      Index of the device, the last byte of its MAC.
+  @param[in]   Features   The virtio-net features offered besides the MAC
+                          address and the link status.
+  @param[in]   QueueSize  The size of the queues of the device.
+  @param[out]  Device     The created device.
+
+  @retval EFI_SUCCESS            The device is created.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
+  @retval Others                 Failed to install the protocols.
+
+**/
+EFI_STATUS
+LoopbackVirtioCreate (
+  IN  UINT8             Index,
+  IN  UINT64            Features,
+  IN  UINT16            QueueSize,
+  OUT LOOPBACK_VIRTIO   **Device
+  );
+
+/**
+  Connect VirtioNetDxe to the emulated device, and find the Simple Network
+  child it creates.
+
+  @param[in, out]  Device   The device created by LoopbackVirtioCreate().
+
+  @retval EFI_SUCCESS       The Simple Network child is created.
+  @retval EFI_NOT_FOUND     VirtioNetDxe isn't loaded.
+
+**/
+EFI_STATUS
+LoopbackVirtioConnect (
+  IN OUT LOOPBACK_VIRTIO  *Device
+  );
+
+/**
+  Disconnect VirtioNetDxe, uninstall the protocols of the emulated device
+  and free it.
+
+  @param[in]  Device    The device to destroy.
+
+**/
+VOID
+LoopbackVirtioDestroy (
+  IN LOOPBACK_VIRTIO    *Device
+  );
+
+#endif
@@ -59,7 +59,6 @@ VirtioNetGetStatus (
   EFI_TPL              OldTpl;
   EFI_STATUS           Status;
   UINT16               RxCurUsed;
-  UINT16               TxCurUsed;
   EFI_PHYSICAL_ADDRESS DeviceAddress;
 
   if (This == NULL) {
@@ -79,6 +78,17 @@ VirtioNetGetStatus (
     break;
   }
 
+  //
+  // Callers recycle the transmit buffers by calling us until we return no
+  // buffer. While there are completions left from the previous reading of the
+  // used ring, such calls are served from them, without reading the link
+  // status (a trip to the host) or the used index again.
+  //
+  if (InterruptStatus == NULL && TxBuf != NULL &&
+      Dev->TxLastUsed != Dev->TxCurUsed) {
+    goto ReapTx;
+  }
+
   //
   // update link status
   //
@@ -98,7 +108,7 @@ VirtioNetGetStatus (
   //
   MemoryFence ();
   RxCurUsed = *Dev->RxRing.Used.Idx;
-  TxCurUsed = *Dev->TxRing.Used.Idx;
+  Dev->TxCurUsed = *Dev->TxRing.Used.Idx;
   MemoryFence ();
 
   if (InterruptStatus != NULL) {
@@ -110,14 +120,15 @@ VirtioNetGetStatus (
     if (Dev->RxLastUsed != RxCurUsed) {
       *InterruptStatus |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
     }
-    if (Dev->TxLastUsed != TxCurUsed) {
+    if (Dev->TxLastUsed != Dev->TxCurUsed) {
       ASSERT (Dev->TxCurPending > 0);
       *InterruptStatus |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
     }
   }
 
+ReapTx:
   if (TxBuf != NULL) {
-    if (Dev->TxLastUsed == TxCurUsed) {
+    if (Dev->TxLastUsed == Dev->TxCurUsed) {
       *TxBuf = NULL;
     }
     else {
@@ -14,6 +14,7 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
 #include "VirtioNet.h"
@@ -163,7 +164,7 @@ VirtioNetInitTx (
   VOID                  *TxSharedReqBuffer;
 
   Dev->TxMaxPending = (UINT16) MIN (Dev->TxRing.QueueSize / 2,
-                                 VNET_MAX_PENDING);
+                                 PcdGet16 (PcdVirtioNetMaxPending));
   Dev->TxCurPending = 0;
   Dev->TxFreeStack  = AllocatePool (Dev->TxMaxPending *
                         sizeof *Dev->TxFreeStack);
@@ -212,11 +213,9 @@ VirtioNetInitTx (
 
   //
   // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
+  // VIRTIO_NET_F_MRG_RXBUF. See VirtioNetInitialize().
   //
-  TxSharedReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                    sizeof (Dev->TxSharedReq->V0_9_5) :
-                    sizeof *Dev->TxSharedReq;
+  TxSharedReqSize = Dev->NetReqSize;
 
   for (PktIdx = 0; PktIdx < Dev->TxMaxPending; ++PktIdx) {
     UINT16 DescIdx;
@@ -256,6 +255,7 @@ VirtioNetInitTx (
   //
   MemoryFence ();
   Dev->TxLastUsed = *Dev->TxRing.Used.Idx;
+  Dev->TxCurUsed  = Dev->TxLastUsed;
   ASSERT (Dev->TxLastUsed == 0);
 
   //
@@ -293,7 +293,8 @@ FreeTxFreeStack:
     packet data into,
   - select polling over RX interrupt,
   - fully populate the RX queue with a static pattern of virtio descriptor
-    chains.
+    chains, or of single descriptors if VIRTIO_NET_F_MRG_RXBUF has been
+    negotiated.
 
   @param[in,out] Dev       The VNET_DEV driver instance about to enter the
                            EfiSimpleNetworkInitialized state.
@@ -316,6 +317,7 @@ VirtioNetInitRx (
   UINTN                 VirtioNetReqSize;
   UINTN                 RxBufSize;
   UINT16                RxAlwaysPending;
+  UINT16                DescPerPkt;
   UINTN                 PktIdx;
   UINT16                DescIdx;
   UINTN                 NumBytes;
@@ -324,26 +326,31 @@ VirtioNetInitRx (
 
   //
   // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
+  // VIRTIO_NET_F_MRG_RXBUF. See VirtioNetInitialize().
   //
-  VirtioNetReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                     sizeof (VIRTIO_NET_REQ) :
-                     sizeof (VIRTIO_1_0_NET_REQ);
+  VirtioNetReqSize = Dev->NetReqSize;
 
   //
-  // For each incoming packet we must supply two descriptors:
+  // Without VIRTIO_NET_F_MRG_RXBUF, for each incoming packet we must supply
+  // two descriptors:
   // - the recipient for the virtio-net request header, plus
   // - the recipient for the network data (which consists of Ethernet header
   //   and Ethernet payload).
   //
+  // With VIRTIO_NET_F_MRG_RXBUF, the header and the data go to a single
+  // buffer, hence a single descriptor. A packet larger than the buffer would
+  // be spread over several buffers, see VirtioNetReceive().
+  //
   RxBufSize = VirtioNetReqSize +
               (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
+  DescPerPkt = Dev->MergeRxBuf ? 1 : 2;
 
   //
-  // Limit the number of pending RX packets if the queue is big. The division
-  // by two is due to the above "two descriptors per packet" trait.
+  // Limit the number of pending RX packets if the queue is big.
   //
-  RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / 2, VNET_MAX_PENDING);
+  RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / DescPerPkt,
+                               PcdGet16 (PcdVirtioNetMaxPending));
+  Dev->RxMaxPending = RxAlwaysPending;
 
   //
   // The RxBuf is shared between guest and hypervisor, use
@@ -383,6 +390,7 @@ VirtioNetInitRx (
   //
   MemoryFence ();
   Dev->RxLastUsed = *Dev->RxRing.Used.Idx;
+  Dev->RxCurUsed  = Dev->RxLastUsed;
   ASSERT (Dev->RxLastUsed == 0);
 
   //
@@ -393,8 +401,9 @@ VirtioNetInitRx (
   *Dev->RxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
 
   //
-  // now set up a separate, two-part descriptor chain for each RX packet, and
-  // link each chain into (from) the available ring as well
+  // now set up a separate, two-part descriptor chain (or a single descriptor)
+  // for each RX packet, and link each chain into (from) the available ring as
+  // well
   //
   DescIdx = 0;
   RxBufDeviceAddress = Dev->RxBufDeviceBase;
@@ -408,6 +417,14 @@ VirtioNetInitRx (
     //
     // virtio-0.9.5, 2.4.1.1 Placing Buffers into the Descriptor Table
     //
+    if (Dev->MergeRxBuf) {
+      Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
+      Dev->RxRing.Desc[DescIdx].Len   = (UINT32) RxBufSize;
+      Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
+      RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
+      continue;
+    }
+
     Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
     Dev->RxRing.Desc[DescIdx].Len   = (UINT32) VirtioNetReqSize;
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
@@ -425,6 +442,7 @@ VirtioNetInitRx (
   //
   MemoryFence ();
   *Dev->RxRing.Avail.Idx = RxAlwaysPending;
+  Dev->RxNextAvail       = RxAlwaysPending;
 
   //
   // At this point reception may already be running. In order to make it sure,
@@ -557,7 +575,25 @@ VirtioNetInitialize (
     !!(Features & VIRTIO_NET_F_STATUS));
 
   Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_NET_F_MRG_RXBUF;
+
+  //
+  // With VIRTIO_NET_F_MRG_RXBUF, the NumBuffers field of the virtio-net
+  // request header exists in virtio-0.9.5 too, and receive buffers need no
+  // separate descriptor for the header. The offloads of the receive direction
+  // (VIRTIO_NET_F_GUEST_CSUM, VIRTIO_NET_F_GUEST_TSO4/6) are not negotiated:
+  // SNP can neither pass up frames larger than MaxPacketSize nor tell the
+  // caller that a checksum has been verified or is only partial. Neither is
+  // VIRTIO_NET_F_CSUM: SNP.Transmit() gets no per-packet indication that a
+  // TCP checksum is only partial, and the frame contents can't tell.
+  //
+  Dev->MergeRxBuf = (BOOLEAN) ((Features & VIRTIO_NET_F_MRG_RXBUF) != 0);
+  Dev->NetReqSize = (UINT16) (
+                      (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0) &&
+                       !Dev->MergeRxBuf) ?
+                      sizeof (VIRTIO_NET_REQ) :
+                      sizeof (VIRTIO_1_0_NET_REQ)
+                      );
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
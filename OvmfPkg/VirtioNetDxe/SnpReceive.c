@@ -15,6 +15,79 @@
 
 #include "VirtioNet.h"
 
+/**
+  Locate the packet data in a receive buffer that the host has returned on
+  the used ring.
+
+  Without VIRTIO_NET_F_MRG_RXBUF, each packet occupies one two-part descriptor
+  chain. With VIRTIO_NET_F_MRG_RXBUF, each packet occupies one or more single
+  descriptor buffers, and only the first of them starts with the virtio-net
+  request header, whose NumBuffers field tells the number of buffers.
+
+  @param[in]  Dev         The VNET_DEV driver instance.
+  @param[in]  BufIdx      The index of the buffer within the packet, the
+                          buffer being on the used ring at RxLastUsed + BufIdx.
+  @param[out] Data        The start of the packet data in the buffer.
+  @param[out] NumBuffers  The number of buffers of the packet, only for
+                          BufIdx 0.
+
+  @return  The number of packet data bytes in the buffer.
+*/
+STATIC
+UINT32
+VirtioNetRxBufData (
+  IN  VNET_DEV *Dev,
+  IN  UINT16   BufIdx,
+  OUT UINT8    **Data,
+  OUT UINT16   *NumBuffers OPTIONAL
+  )
+{
+  UINT16 UsedElemIdx;
+  UINT32 DescIdx;
+  UINT32 RxLen;
+
+  UsedElemIdx = (UINT16) (Dev->RxLastUsed + BufIdx) % Dev->RxRing.QueueSize;
+  DescIdx = Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
+  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+
+  if (!Dev->MergeRxBuf) {
+    //
+    // the virtio-net request header must be complete; we skip it
+    //
+    ASSERT (RxLen >= Dev->RxRing.Desc[DescIdx].Len);
+    RxLen -= Dev->RxRing.Desc[DescIdx].Len;
+    //
+    // the host must not have filled in more data than requested
+    //
+    ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx + 1].Len);
+
+    *Data = Dev->RxBuf + (UINTN)(Dev->RxRing.Desc[DescIdx + 1].Addr -
+                                 Dev->RxBufDeviceBase);
+    if (NumBuffers != NULL) {
+      *NumBuffers = 1;
+    }
+    return RxLen;
+  }
+
+  ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx].Len);
+  *Data = Dev->RxBuf + (UINTN)(Dev->RxRing.Desc[DescIdx].Addr -
+                               Dev->RxBufDeviceBase);
+  if (NumBuffers == NULL) {
+    return RxLen;
+  }
+
+  //
+  // a truncated header makes a useless short packet
+  //
+  if (RxLen < Dev->NetReqSize) {
+    *NumBuffers = 1;
+    return 0;
+  }
+  *NumBuffers = ((VIRTIO_1_0_NET_REQ *) *Data)->NumBuffers;
+  *Data += Dev->NetReqSize;
+  return RxLen - Dev->NetReqSize;
+}
+
 /**
   Receives a packet from a network interface.
 
@@ -68,15 +141,14 @@ VirtioNetReceive (
   VNET_DEV   *Dev;
   EFI_TPL    OldTpl;
   EFI_STATUS Status;
-  UINT16     RxCurUsed;
+  UINT16     NumBuffers;
+  UINT16     BufIdx;
   UINT16     UsedElemIdx;
-  UINT32     DescIdx;
   UINT32     RxLen;
+  UINT32     BufLen;
   UINTN      OrigBufferSize;
   UINT8      *RxPtr;
-  UINT16     AvailIdx;
   EFI_STATUS NotifyStatus;
-  UINTN      RxBufOffset;
 
   if (This == NULL || BufferSize == NULL || Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -98,28 +170,48 @@ VirtioNetReceive (
   //
   // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
   //
-  MemoryFence ();
-  RxCurUsed = *Dev->RxRing.Used.Idx;
-  MemoryFence ();
+  // The used index is only read again once we have caught up with its
+  // previous value, so that the packets of a burst are reaped without a
+  // barrier each.
+  //
+  if (Dev->RxLastUsed == Dev->RxCurUsed) {
+    MemoryFence ();
+    Dev->RxCurUsed = *Dev->RxRing.Used.Idx;
+    MemoryFence ();
 
-  if (Dev->RxLastUsed == RxCurUsed) {
-    Status = EFI_NOT_READY;
-    goto Exit;
+    if (Dev->RxLastUsed == Dev->RxCurUsed) {
+      Status = EFI_NOT_READY;
+      goto Exit;
+    }
   }
 
-  UsedElemIdx = Dev->RxLastUsed % Dev->RxRing.QueueSize;
-  DescIdx = Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
-  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+  RxLen = VirtioNetRxBufData (Dev, 0, &RxPtr, &NumBuffers);
+  if (NumBuffers == 0 || NumBuffers > Dev->RxMaxPending) {
+    NumBuffers = 1;
+    RxLen = 0;
+  }
 
   //
-  // the virtio-net request header must be complete; we skip it
-  //
-  ASSERT (RxLen >= Dev->RxRing.Desc[DescIdx].Len);
-  RxLen -= Dev->RxRing.Desc[DescIdx].Len;
-  //
-  // the host must not have filled in more data than requested
+  // The host returns all buffers of a merged packet before it updates the used
+  // index, but we may have read the index earlier.
   //
-  ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx + 1].Len);
+  if ((UINT16) (Dev->RxCurUsed - Dev->RxLastUsed) < NumBuffers) {
+    MemoryFence ();
+    Dev->RxCurUsed = *Dev->RxRing.Used.Idx;
+    MemoryFence ();
+
+    if ((UINT16) (Dev->RxCurUsed - Dev->RxLastUsed) < NumBuffers) {
+      Status = EFI_NOT_READY;
+      goto Exit;
+    }
+  }
+
+  BufLen = RxLen;
+  for (BufIdx = 1; BufIdx < NumBuffers; ++BufIdx) {
+    UINT8 *BufPtr;
+
+    RxLen += VirtioNetRxBufData (Dev, BufIdx, &BufPtr, NULL);
+  }
 
   OrigBufferSize = *BufferSize;
   *BufferSize = RxLen;
@@ -138,11 +230,18 @@ VirtioNetReceive (
     *HeaderSize = Dev->Snm.MediaHeaderSize;
   }
 
-  RxBufOffset = (UINTN)(Dev->RxRing.Desc[DescIdx + 1].Addr -
-                        Dev->RxBufDeviceBase);
-  RxPtr = Dev->RxBuf + RxBufOffset;
-  CopyMem (Buffer, RxPtr, RxLen);
+  CopyMem (Buffer, RxPtr, BufLen);
+  for (BufIdx = 1; BufIdx < NumBuffers; ++BufIdx) {
+    UINT8 *BufPtr;
+    UINT32 Len;
+
+    Len = VirtioNetRxBufData (Dev, BufIdx, &BufPtr, NULL);
+    CopyMem ((UINT8 *) Buffer + BufLen, BufPtr, Len);
+    BufLen += Len;
+  }
+  ASSERT (BufLen == RxLen);
 
+  RxPtr = Buffer;
   if (DestAddr != NULL) {
     CopyMem (DestAddr, RxPtr, SIZE_OF_VNET (Mac));
   }
@@ -161,22 +260,30 @@ VirtioNetReceive (
   Status = EFI_SUCCESS;
 
 RecycleDesc:
-  ++Dev->RxLastUsed;
-
   //
   // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
   //
-  AvailIdx = *Dev->RxRing.Avail.Idx;
-  Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
-    (UINT16) DescIdx;
+  for (BufIdx = 0; BufIdx < NumBuffers; ++BufIdx) {
+    UsedElemIdx = Dev->RxLastUsed++ % Dev->RxRing.QueueSize;
+    Dev->RxRing.Avail.Ring[Dev->RxNextAvail++ % Dev->RxRing.QueueSize] =
+      (UINT16) Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
+  }
 
-  MemoryFence ();
-  *Dev->RxRing.Avail.Idx = AvailIdx;
+  //
+  // Expose the recycled buffers to the host in batches, but not later than
+  // when we have caught up with the used ring, so that the host is never left
+  // without buffers while we have nothing to receive.
+  //
+  if (Dev->RxLastUsed == Dev->RxCurUsed ||
+      (UINT16) (Dev->RxNextAvail - *Dev->RxRing.Avail.Idx) >=
+      VNET_RX_RECYCLE_BATCH) {
+    MemoryFence ();
+    *Dev->RxRing.Avail.Idx = Dev->RxNextAvail;
 
-  MemoryFence ();
-  NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
-  if (!EFI_ERROR (Status)) { // earlier error takes precedence
-    Status = NotifyStatus;
+    NotifyStatus = VirtioNetNotify (Dev, &Dev->RxRing, VIRTIO_NET_Q_RX);
+    if (!EFI_ERROR (Status)) { // earlier error takes precedence
+      Status = NotifyStatus;
+    }
   }
 
 Exit:
@@ -9,6 +9,7 @@
 **/
 
 #include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
 
 #include "VirtioNet.h"
 
@@ -104,6 +105,49 @@ VirtioNetUninitRing (
 }
 
 
+/**
+  Notify the device of new buffers on the available ring of a queue, unless
+  the device has asked not to be notified.
+
+  The host sets VRING_USED_F_NO_NOTIFY while it is going to look at the
+  available ring anyway, which spares the guest a VM exit per packet.
+
+  @param[in] Dev       The VNET_DEV driver instance.
+  @param[in] Ring      The virtio ring whose available index has just been
+                       updated.
+  @param[in] Selector  Identifies the queue of Ring.
+
+  @retval EFI_SUCCESS  The device has been notified, or needs no notification.
+  @return              Status codes from VIRTIO_DEVICE_PROTOCOL.SetQueueNotify().
+*/
+EFI_STATUS
+EFIAPI
+VirtioNetNotify (
+  IN VNET_DEV *Dev,
+  IN VRING    *Ring,
+  IN UINT16   Selector
+  )
+{
+  UINT32 Barrier;
+
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device
+  //
+  // The update of the available index must be visible to the host before we
+  // read the flags, otherwise we could miss a host that has just re-enabled
+  // notifications after finding the ring empty. MemoryFence() doesn't order a
+  // store before a load on every processor, an interlocked operation does.
+  //
+  Barrier = 0;
+  InterlockedCompareExchange32 (&Barrier, 0, 0);
+
+  if ((*Ring->Used.Flags & VRING_USED_F_NO_NOTIFY) != 0) {
+    return EFI_SUCCESS;
+  }
+  return Dev->VirtIo->SetQueueNotify (Dev->VirtIo, Selector);
+}
+
+
 /**
   Map Caller-supplied TxBuf buffer to the device-mapped address
 
@@ -25,9 +25,14 @@
 #define VNET_SIG SIGNATURE_32 ('V', 'N', 'E', 'T')
 
 //
-// maximum number of pending packets, separately for each direction
+// The maximum number of pending packets, separately for each direction, is
+// PcdVirtioNetMaxPending.
 //
-#define VNET_MAX_PENDING 64
+// Receive descriptors recycled by VirtioNetReceive() are exposed to the
+// device at the latest when this many of them have accumulated, or when the
+// guest has caught up with the used ring.
+//
+#define VNET_RX_RECYCLE_BATCH 16
 
 //
 // State diagram:
@@ -76,12 +81,17 @@ typedef struct {
   EFI_EVENT                   ExitBoot;          // VirtioNetSnpPopulate
   EFI_DEVICE_PATH_PROTOCOL    *MacDevicePath;    // VirtioNetDriverBindingStart
   EFI_HANDLE                  MacHandle;         // VirtioNetDriverBindingStart
+  BOOLEAN                     MergeRxBuf;        // VirtioNetInitialize
+  UINT16                      NetReqSize;        // VirtioNetInitialize
 
   VRING                       RxRing;            // VirtioNetInitRing
   VOID                        *RxRingMap;        // VirtioRingMap and
                                                  // VirtioNetInitRing
   UINT8                       *RxBuf;            // VirtioNetInitRx
   UINT16                      RxLastUsed;        // VirtioNetInitRx
+  UINT16                      RxCurUsed;         // VirtioNetInitRx
+  UINT16                      RxNextAvail;       // VirtioNetInitRx
+  UINT16                      RxMaxPending;      // VirtioNetInitRx
   UINTN                       RxBufNrPages;      // VirtioNetInitRx
   EFI_PHYSICAL_ADDRESS        RxBufDeviceBase;   // VirtioNetInitRx
   VOID                        *RxBufMap;         // VirtioNetInitRx
@@ -95,6 +105,7 @@ typedef struct {
   VIRTIO_1_0_NET_REQ          *TxSharedReq;      // VirtioNetInitTx
   VOID                        *TxSharedReqMap;   // VirtioNetInitTx
   UINT16                      TxLastUsed;        // VirtioNetInitTx
+  UINT16                      TxCurUsed;         // VirtioNetInitTx
   ORDERED_COLLECTION          *TxBufCollection;  // VirtioNetInitTx
 } VNET_DEV;
 
@@ -276,6 +287,14 @@ VirtioNetUninitRing (
   IN     VOID     *RingMap
   );
 
+EFI_STATUS
+EFIAPI
+VirtioNetNotify (
+  IN VNET_DEV *Dev,
+  IN VRING    *Ring,
+  IN UINT16   Selector
+  );
+
 //
 // utility functions to map caller-supplied Tx buffer system physical address
 // to a device address and vice versa
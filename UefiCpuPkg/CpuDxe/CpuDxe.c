@@ -21,6 +21,12 @@ UINT64                    mValidMtrrAddressMask;
 UINT64                    mValidMtrrBitsMask;
 UINT64                    mTimerPeriod = 0;
 
+//
+// Results of the MTRR calculations of the previous CpuSetMemoryAttributes()
+// calls. Most of the memory layout doesn't change from one call to the next.
+//
+MTRR_CALCULATION_CACHE    mMtrrCalculationCache;
+
 FIXED_MTRR    mFixedMtrrTable[] = {
   {
     MSR_IA32_MTRR_FIX64K_00000,
@@ -387,6 +393,9 @@ CpuSetMemoryAttributes (
   UINT64                    CacheAttributes;
   UINT64                    MemoryAttributes;
   MTRR_MEMORY_CACHE_TYPE    CurrentCacheType;
+  MTRR_MEMORY_RANGE         Range;
+  UINT8                     Scratch[SIZE_16KB];
+  UINTN                     ScratchSize;
 
   //
   // If this function is called because GCD SetMemorySpaceAttributes () is called
@@ -455,10 +464,17 @@ CpuSetMemoryAttributes (
       //
       // call MTRR library function
       //
-      Status = MtrrSetMemoryAttribute (
-                 BaseAddress,
-                 Length,
-                 CacheType
+      Range.BaseAddress = BaseAddress;
+      Range.Length      = Length;
+      Range.Type        = CacheType;
+      ScratchSize       = sizeof (Scratch);
+      Status = MtrrSetMemoryAttributesInMtrrSettingsWithCache (
+                 NULL,
+                 Scratch,
+                 &ScratchSize,
+                 &Range,
+                 1,
+                 &mMtrrCalculationCache
                  );
 
       if (!RETURN_ERROR (Status)) {
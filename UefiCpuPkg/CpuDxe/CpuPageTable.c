@@ -57,6 +57,7 @@
 #define PAGING_1G_ADDRESS_MASK_64 0x000FFFFFC0000000ull
 
 #define MAX_PF_ENTRY_COUNT        10
+#define MAX_FREE_PAGE_TABLE_COUNT 128
 #define MAX_DEBUG_MESSAGE_LENGTH  0x100
 #define IA32_PF_EC_ID             BIT4
 
@@ -96,6 +97,16 @@ EFI_SMM_BASE2_PROTOCOL            *mSmmBase2 = NULL;
 UINTN                     *mPFEntryCount;
 UINT64                    *(*mLastPFEntryPointer)[MAX_PF_ENTRY_COUNT];
 
+//
+// Page tables of the page table pool released when their entries are
+// coalesced into a large page. The first mReusablePageTableCount ones can be
+// allocated again, the others may still be cached by the processor until the
+// next TLB flush.
+//
+VOID                      *mFreePageTable[MAX_FREE_PAGE_TABLE_COUNT];
+UINTN                     mFreePageTableCount = 0;
+UINTN                     mReusablePageTableCount = 0;
+
 /**
  Check if current execution environment is in SMM mode or not, via
  EFI_SMM_BASE2_PROTOCOL.
@@ -261,28 +272,23 @@ PageAttributeToMask (
 }
 
 /**
-  Return page table entry to match the address.
+  Return page directory pointer table entry to match the address.
 
   @param[in]  PagingContext     The paging context.
   @param[in]  Address           The address to be checked.
-  @param[out] PageAttributes    The page attribute of the page entry.
 
-  @return The page entry.
+  @return The page directory pointer table entry, NULL if the upper levels do
+          not map the address.
 **/
-VOID *
-GetPageTableEntry (
+UINT64 *
+GetPageDirectoryPointerEntry (
   IN  PAGE_TABLE_LIB_PAGING_CONTEXT     *PagingContext,
-  IN  PHYSICAL_ADDRESS                  Address,
-  OUT PAGE_ATTRIBUTE                    *PageAttribute
+  IN  PHYSICAL_ADDRESS                  Address
   )
 {
-  UINTN                 Index1;
-  UINTN                 Index2;
   UINTN                 Index3;
   UINTN                 Index4;
   UINTN                 Index5;
-  UINT64                *L1PageTable;
-  UINT64                *L2PageTable;
   UINT64                *L3PageTable;
   UINT64                *L4PageTable;
   UINT64                *L5PageTable;
@@ -293,8 +299,6 @@ GetPageTableEntry (
   Index5 = ((UINTN)RShiftU64 (Address, 48)) & PAGING_PAE_INDEX_MASK;
   Index4 = ((UINTN)RShiftU64 (Address, 39)) & PAGING_PAE_INDEX_MASK;
   Index3 = ((UINTN)Address >> 30) & PAGING_PAE_INDEX_MASK;
-  Index2 = ((UINTN)Address >> 21) & PAGING_PAE_INDEX_MASK;
-  Index1 = ((UINTN)Address >> 12) & PAGING_PAE_INDEX_MASK;
 
   // Make sure AddressEncMask is contained to smallest supported address field.
   //
@@ -304,7 +308,6 @@ GetPageTableEntry (
     if ((PagingContext->ContextData.X64.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_5_LEVEL) != 0) {
       L5PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.X64.PageTableBase;
       if (L5PageTable[Index5] == 0) {
-        *PageAttribute = PageNone;
         return NULL;
       }
 
@@ -313,7 +316,6 @@ GetPageTableEntry (
       L4PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.X64.PageTableBase;
     }
     if (L4PageTable[Index4] == 0) {
-      *PageAttribute = PageNone;
       return NULL;
     }
 
@@ -322,17 +324,53 @@ GetPageTableEntry (
     ASSERT((PagingContext->ContextData.Ia32.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_PAE) != 0);
     L3PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.Ia32.PageTableBase;
   }
-  if (L3PageTable[Index3] == 0) {
+  return &L3PageTable[Index3];
+}
+
+/**
+  Return page table entry to match the address.
+
+  @param[in]  PagingContext     The paging context.
+  @param[in]  Address           The address to be checked.
+  @param[out] PageAttributes    The page attribute of the page entry.
+
+  @return The page entry.
+**/
+VOID *
+GetPageTableEntry (
+  IN  PAGE_TABLE_LIB_PAGING_CONTEXT     *PagingContext,
+  IN  PHYSICAL_ADDRESS                  Address,
+  OUT PAGE_ATTRIBUTE                    *PageAttribute
+  )
+{
+  UINTN                 Index1;
+  UINTN                 Index2;
+  UINT64                *L1PageTable;
+  UINT64                *L2PageTable;
+  UINT64                *L3PageEntry;
+  UINT64                AddressEncMask;
+
+  ASSERT (PagingContext != NULL);
+
+  Index2 = ((UINTN)Address >> 21) & PAGING_PAE_INDEX_MASK;
+  Index1 = ((UINTN)Address >> 12) & PAGING_PAE_INDEX_MASK;
+
+  // Make sure AddressEncMask is contained to smallest supported address field.
+  //
+  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
+
+  L3PageEntry = GetPageDirectoryPointerEntry (PagingContext, Address);
+  if ((L3PageEntry == NULL) || (*L3PageEntry == 0)) {
     *PageAttribute = PageNone;
     return NULL;
   }
-  if ((L3PageTable[Index3] & IA32_PG_PS) != 0) {
+  if ((*L3PageEntry & IA32_PG_PS) != 0) {
     // 1G
     *PageAttribute = Page1G;
-    return &L3PageTable[Index3];
+    return L3PageEntry;
   }
 
-  L2PageTable = (UINT64 *)(UINTN)(L3PageTable[Index3] & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
+  L2PageTable = (UINT64 *)(UINTN)(*L3PageEntry & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
   if (L2PageTable[Index2] == 0) {
     *PageAttribute = PageNone;
     return NULL;
@@ -590,6 +628,117 @@ SplitPage (
   }
 }
 
+/**
+  Release a page table which is not referenced by the page table entries
+  anymore.
+
+  Only the page tables allocated from the page table pool are kept for reuse,
+  the ones built before this driver are left where they are. The page table
+  cannot be reused before the next TLB flush.
+
+  @param[in]  Buffer            The page table to release.
+**/
+VOID
+FreePageTableMemory (
+  IN  VOID                              *Buffer
+  )
+{
+  PAGE_TABLE_POOL                   *Pool;
+
+  if ((mPageTablePool == NULL) ||
+      (mFreePageTableCount == MAX_FREE_PAGE_TABLE_COUNT)) {
+    return;
+  }
+
+  Pool = mPageTablePool;
+  do {
+    if (((UINTN)Buffer > (UINTN)Pool) &&
+        ((UINTN)Buffer < (UINTN)Pool + Pool->Offset)) {
+      mFreePageTable[mFreePageTableCount++] = Buffer;
+      return;
+    }
+    Pool = Pool->NextPool;
+  } while (Pool != mPageTablePool);
+}
+
+/**
+  This function replaces a page entry referencing a page table with one large
+  page entry, if the page table maps contiguous memory with the same page
+  attributes.
+
+  The accessed and dirty bits of the page table entries are merged.
+
+  @param[in]  PageEntry         The page entry referencing the page table.
+  @param[in]  PageAttribute     The page attribute of the page table entries.
+
+  @retval TRUE    The page entry is coalesced.
+  @retval FALSE   The page entry is not changed.
+**/
+BOOLEAN
+CoalescePageEntry (
+  IN  UINT64                            *PageEntry,
+  IN  PAGE_ATTRIBUTE                    PageAttribute
+  )
+{
+  UINT64   *PageTable;
+  UINT64   AddressEncMask;
+  UINT64   AddressMask;
+  UINT64   LargePageMask;
+  UINT64   PageLength;
+  UINT64   Address;
+  UINT64   Attributes;
+  UINT64   AccessedDirty;
+  UINTN    Index;
+
+  ASSERT (PageAttribute == Page4K || PageAttribute == Page2M);
+
+  // Make sure AddressEncMask is contained to smallest supported address field.
+  //
+  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
+
+  if (PageAttribute == Page4K) {
+    AddressMask   = PAGING_4K_ADDRESS_MASK_64 & ~AddressEncMask;
+    LargePageMask = PAGING_2M_MASK;
+  } else {
+    AddressMask   = PAGING_2M_ADDRESS_MASK_64 & ~AddressEncMask;
+    LargePageMask = PAGING_1G_MASK;
+  }
+  PageLength = PageAttributeToLength (PageAttribute);
+
+  PageTable  = (UINT64 *)(UINTN)(*PageEntry & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
+  Address    = PageTable[0] & AddressMask;
+  Attributes = PageTable[0] & ~AddressMask & ~(UINT64)(IA32_PG_A | IA32_PG_D);
+  if ((Address & LargePageMask) != 0) {
+    return FALSE;
+  }
+
+  if (PageAttribute == Page4K) {
+    //
+    // The PAT bit of a 4K page entry is the PS bit of a 2M page entry.
+    //
+    if ((Attributes & IA32_PG_PAT_4K) != 0) {
+      return FALSE;
+    }
+  } else if ((Attributes & IA32_PG_PS) == 0) {
+    return FALSE;
+  }
+
+  AccessedDirty = 0;
+  for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
+    if (((PageTable[Index] & AddressMask) != Address) ||
+        ((PageTable[Index] & ~AddressMask & ~(UINT64)(IA32_PG_A | IA32_PG_D)) != Attributes)) {
+      return FALSE;
+    }
+    AccessedDirty |= PageTable[Index] & (IA32_PG_A | IA32_PG_D);
+    Address += PageLength;
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "Coalesce - 0x%x\n", PageTable));
+  *PageEntry = (PageTable[0] & AddressMask) | Attributes | AccessedDirty | IA32_PG_PS;
+  FreePageTableMemory (PageTable);
+  return TRUE;
+}
+
 /**
  Check the WP status in CR0 register. This bit is used to lock or unlock write
  access to pages marked as read-only.
@@ -832,6 +981,181 @@ Done:
   return Status;
 }
 
+/**
+  This function coalesces the page tables of the current paging context which
+  map the memory region specified by BaseAddress and Length, or the large pages
+  around it, into large pages wherever their entries map contiguous memory with
+  the same page attributes.
+
+  The caller must flush the TLB if the page table is modified.
+
+  @param[in]  BaseAddress       The physical address that is the start address of a memory region.
+  @param[in]  Length            The size in bytes of the memory region.
+  @param[out] IsModified        Set to TRUE if the page table is modified, unchanged otherwise.
+**/
+VOID
+CoalesceMemoryPageAttributes (
+  IN  PHYSICAL_ADDRESS                  BaseAddress,
+  IN  UINT64                            Length,
+  OUT BOOLEAN                           *IsModified
+  )
+{
+  PAGE_TABLE_LIB_PAGING_CONTEXT     CurrentPagingContext;
+  UINT32                            *Attributes;
+  UINT64                            *PageDirectoryPointerEntry;
+  UINT64                            *PageDirectory;
+  UINT64                            AddressEncMask;
+  PHYSICAL_ADDRESS                  Address;
+  PHYSICAL_ADDRESS                  EndAddress;
+  UINTN                             Index;
+  UINTN                             EndIndex;
+  BOOLEAN                           IsWpEnabled;
+
+  //
+  // SMM loads its own page table, leave the one of DXE as it is.
+  //
+  if (IsInSmm ()) {
+    return;
+  }
+
+  GetCurrentPagingContext (&CurrentPagingContext);
+  GetPagingDetails (&CurrentPagingContext.ContextData, NULL, &Attributes);
+
+  // Make sure AddressEncMask is contained to smallest supported address field.
+  //
+  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
+
+  IsWpEnabled = IsReadOnlyPageWriteProtected ();
+  if (IsWpEnabled) {
+    DisableReadOnlyPageWriteProtect ();
+  }
+
+  EndAddress = BaseAddress + Length;
+  Address    = BaseAddress & ~(UINT64)PAGING_1G_MASK;
+  while (Address < EndAddress) {
+    PageDirectoryPointerEntry = GetPageDirectoryPointerEntry (&CurrentPagingContext, Address);
+    if ((PageDirectoryPointerEntry != NULL) &&
+        (*PageDirectoryPointerEntry != 0) &&
+        ((*PageDirectoryPointerEntry & IA32_PG_PS) == 0)) {
+      //
+      // Coalesce the 4K page tables of the region first, then the 2M pages of
+      // the 1G region.
+      //
+      PageDirectory = (UINT64 *)(UINTN)(*PageDirectoryPointerEntry & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
+      Index    = (UINTN)(MAX (BaseAddress, Address) - Address) >> 21;
+      EndIndex = ((UINTN)(MIN (EndAddress, Address + SIZE_1GB) - Address) + PAGING_2M_MASK) >> 21;
+      for (; Index < EndIndex; Index++) {
+        if ((PageDirectory[Index] != 0) &&
+            ((PageDirectory[Index] & IA32_PG_PS) == 0) &&
+            CoalescePageEntry (&PageDirectory[Index], Page4K)) {
+          *IsModified = TRUE;
+        }
+      }
+
+      if ((CurrentPagingContext.MachineType == IMAGE_FILE_MACHINE_X64) &&
+          ((*Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_PAGE_1G_SUPPORT) != 0) &&
+          CoalescePageEntry (PageDirectoryPointerEntry, Page2M)) {
+        *IsModified = TRUE;
+      }
+    }
+    Address += SIZE_1GB;
+  }
+
+  if (IsWpEnabled) {
+    EnableReadOnlyPageWriteProtect ();
+  }
+}
+
+/**
+  This function assigns the page attributes for the memory regions specified by Ranges, then
+  coalesces the page tables of the regions into large pages where possible and flushes the TLB
+  once for all the regions.
+
+  Caller should make sure the base address and length of every region is at page boundary.
+
+  Caller need guarantee the TPL <= TPL_NOTIFY, if there is split page request.
+
+  @param[in]  PagingContext     The paging context. NULL means get page table from current CPU context.
+                                The page tables are only coalesced in the current CPU context.
+  @param[in]  Ranges            The memory regions and the attributes to set for them.
+  @param[in]  RangeCount        The number of memory regions.
+  @param[in]  AllocatePagesFunc If page split is needed, this function is used to allocate more pages.
+                                NULL mean page split is unsupported.
+
+  @retval RETURN_SUCCESS           The attributes were set for all the memory regions.
+  @retval RETURN_INVALID_PARAMETER Ranges is NULL and RangeCount is not zero.
+  @retval others                   The attributes could not be set for one of the memory regions,
+                                   as returned by AssignMemoryPageAttributes(). The regions before
+                                   it were modified.
+**/
+RETURN_STATUS
+EFIAPI
+AssignMemoryPageAttributesBatch (
+  IN  PAGE_TABLE_LIB_PAGING_CONTEXT       *PagingContext OPTIONAL,
+  IN  CONST PAGE_TABLE_LIB_MEMORY_RANGE   *Ranges,
+  IN  UINTN                               RangeCount,
+  IN  PAGE_TABLE_LIB_ALLOCATE_PAGES       AllocatePagesFunc OPTIONAL
+  )
+{
+  RETURN_STATUS  Status;
+  BOOLEAN        IsModified;
+  BOOLEAN        IsRangeModified;
+  BOOLEAN        IsSplitted;
+  UINTN          Index;
+  UINTN          ModifiedCount;
+
+  if ((Ranges == NULL) && (RangeCount != 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Status     = RETURN_SUCCESS;
+  IsModified = FALSE;
+  for (Index = 0; Index < RangeCount; Index++) {
+    IsRangeModified = FALSE;
+    Status = ConvertMemoryPageAttributes (
+               PagingContext,
+               Ranges[Index].BaseAddress,
+               Ranges[Index].Length,
+               Ranges[Index].Attributes,
+               PageActionAssign,
+               AllocatePagesFunc,
+               &IsSplitted,
+               &IsRangeModified
+               );
+    IsModified |= IsRangeModified;
+    if (RETURN_ERROR (Status)) {
+      break;
+    }
+  }
+  ModifiedCount = Index;
+
+  if ((PagingContext == NULL) && IsModified) {
+    //
+    // Only the current paging context is coalesced, the #PF handler of the
+    // non-stop mode keeps pointers to the entries of the page table it passes.
+    //
+    for (Index = 0; Index < ModifiedCount; Index++) {
+      CoalesceMemoryPageAttributes (Ranges[Index].BaseAddress, Ranges[Index].Length, &IsModified);
+    }
+
+    //
+    // Flush TLB as last step.
+    //
+    // Note: Since APs will always init CR3 register in HLT loop mode or do
+    // TLB flush in MWAIT loop mode, there's no need to flush TLB for them
+    // here.
+    //
+    CpuFlushTlb();
+
+    //
+    // The page tables released by the coalescing are not cached anymore.
+    //
+    mReusablePageTableCount = mFreePageTableCount;
+  }
+
+  return Status;
+}
+
 /**
   This function assigns the page attributes for the memory region specified by BaseAddress and
   Length from their current attributes to the attributes specified by Attributes.
@@ -870,26 +1194,13 @@ AssignMemoryPageAttributes (
   IN  PAGE_TABLE_LIB_ALLOCATE_PAGES     AllocatePagesFunc OPTIONAL
   )
 {
-  RETURN_STATUS  Status;
-  BOOLEAN        IsModified;
-  BOOLEAN        IsSplitted;
+  PAGE_TABLE_LIB_MEMORY_RANGE  Range;
 
 //  DEBUG((DEBUG_INFO, "AssignMemoryPageAttributes: 0x%lx - 0x%lx (0x%lx)\n", BaseAddress, Length, Attributes));
-  Status = ConvertMemoryPageAttributes (PagingContext, BaseAddress, Length, Attributes, PageActionAssign, AllocatePagesFunc, &IsSplitted, &IsModified);
-  if (!EFI_ERROR(Status)) {
-    if ((PagingContext == NULL) && IsModified) {
-      //
-      // Flush TLB as last step.
-      //
-      // Note: Since APs will always init CR3 register in HLT loop mode or do
-      // TLB flush in MWAIT loop mode, there's no need to flush TLB for them
-      // here.
-      //
-      CpuFlushTlb();
-    }
-  }
-
-  return Status;
+  Range.BaseAddress = BaseAddress;
+  Range.Length      = Length;
+  Range.Attributes  = Attributes;
+  return AssignMemoryPageAttributesBatch (PagingContext, &Range, 1, AllocatePagesFunc);
 }
 
 /**
@@ -1166,6 +1477,17 @@ AllocatePageTableMemory (
     return NULL;
   }
 
+  //
+  // Reuse the page tables released by the coalescing first.
+  //
+  if ((Pages == 1) && (mReusablePageTableCount > 0)) {
+    mReusablePageTableCount--;
+    mFreePageTableCount--;
+    Buffer = mFreePageTable[mReusablePageTableCount];
+    mFreePageTable[mReusablePageTableCount] = mFreePageTable[mFreePageTableCount];
+    return Buffer;
+  }
+
   //
   // Renew the pool if necessary.
   //
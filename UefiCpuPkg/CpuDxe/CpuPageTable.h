@@ -57,6 +57,12 @@ typedef struct {
   UINTN           FreePages;
 } PAGE_TABLE_POOL;
 
+typedef struct {
+  PHYSICAL_ADDRESS  BaseAddress;
+  UINT64            Length;
+  UINT64            Attributes;
+} PAGE_TABLE_LIB_MEMORY_RANGE;
+
 
 /**
   Allocates one or more 4KB pages for page table.
@@ -110,6 +116,37 @@ AssignMemoryPageAttributes (
   IN  PAGE_TABLE_LIB_ALLOCATE_PAGES     AllocatePagesFunc OPTIONAL
   );
 
+/**
+  This function assigns the page attributes for the memory regions specified by Ranges, then
+  coalesces the page tables of the regions into large pages where possible and flushes the TLB
+  once for all the regions.
+
+  Caller should make sure the base address and length of every region is at page boundary.
+
+  Caller need guarantee the TPL <= TPL_NOTIFY, if there is split page request.
+
+  @param  PagingContext     The paging context. NULL means get page table from current CPU context.
+                            The page tables are only coalesced in the current CPU context.
+  @param  Ranges            The memory regions and the attributes to set for them.
+  @param  RangeCount        The number of memory regions.
+  @param  AllocatePagesFunc If page split is needed, this function is used to allocate more pages.
+                            NULL mean page split is unsupported.
+
+  @retval RETURN_SUCCESS           The attributes were set for all the memory regions.
+  @retval RETURN_INVALID_PARAMETER Ranges is NULL and RangeCount is not zero.
+  @retval others                   The attributes could not be set for one of the memory regions,
+                                   as returned by AssignMemoryPageAttributes(). The regions before
+                                   it were modified.
+**/
+RETURN_STATUS
+EFIAPI
+AssignMemoryPageAttributesBatch (
+  IN  PAGE_TABLE_LIB_PAGING_CONTEXT       *PagingContext OPTIONAL,
+  IN  CONST PAGE_TABLE_LIB_MEMORY_RANGE   *Ranges,
+  IN  UINTN                               RangeCount,
+  IN  PAGE_TABLE_LIB_ALLOCATE_PAGES       AllocatePagesFunc OPTIONAL
+  );
+
 /**
   Initialize the Page Table lib.
 **/
@@ -0,0 +1,765 @@
+/** @file
+  Host based unit tests of the page table management of CpuDxe. The page table
+  of the emulated processor identity maps the whole address space; random page
+  attributes are assigned to a window of it and the page table is checked
+  against the expected attributes of every page of the window, and against the
+  smallest number of page tables able to map them.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "CpuPageTableUnitTest.h"
+
+#define ROUND_COUNT               200
+#define BATCH_RANGE_COUNT         8
+#define REUSE_ROUND_COUNT         64
+
+#define TEST_WINDOW_BASE          BASE_64GB
+#define TEST_WINDOW_SIZE          SIZE_4GB
+#define TEST_WINDOW_PAGES         (TEST_WINDOW_SIZE / SIZE_4KB)
+
+#define ENTRY_P                   BIT0
+#define ENTRY_RW                  BIT1
+#define ENTRY_PS                  BIT7
+#define ENTRY_NX                  BIT63
+#define ENTRY_ADDRESS_MASK        0x000FFFFFFFFFF000ull
+#define ENTRY_COUNT               512
+
+//
+// Page attributes of a page of the window.
+//
+#define PAGE_RP                   BIT0
+#define PAGE_RO                   BIT1
+#define PAGE_XP                   BIT2
+
+typedef struct {
+  BOOLEAN                   Page1GSupport;
+} PAGING_PARAMETER;
+
+STATIC PAGING_PARAMETER mPagingParameters[] = {
+  { TRUE  },
+  { FALSE },
+};
+
+STATIC UINT64 mTestAttributes[] = {
+  0,
+  0,
+  0,
+  EFI_MEMORY_RO,
+  EFI_MEMORY_XP,
+  EFI_MEMORY_RO | EFI_MEMORY_XP,
+  EFI_MEMORY_RP,
+  EFI_MEMORY_RP | EFI_MEMORY_XP,
+};
+
+EFI_BOOT_SERVICES         mBootServices;
+EFI_BOOT_SERVICES         *gBS = &mBootServices;
+EFI_DXE_SERVICES          *gDS = NULL;
+UINTN                     mNumberOfProcessors = 1;
+
+STATIC PAGING_PARAMETER   *mPaging;
+STATIC UINT64             *mIdentityMap;
+STATIC UINTN              mIdentityMapPages;
+STATIC UINT8              *mExpected;
+
+/**
+  Emulate MpInitLibWhoAmI(), there is only one processor.
+
+  @param[out] ProcessorNumber  The processor number.
+
+  @retval EFI_SUCCESS          The processor number is returned.
+**/
+EFI_STATUS
+EFIAPI
+MpInitLibWhoAmI (
+  OUT UINTN                 *ProcessorNumber
+  )
+{
+  *ProcessorNumber = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Emulate DumpCpuContext(), the exception handlers are not tested.
+
+  @param[in] ExceptionType  Exception type.
+  @param[in] SystemContext  Pointer to EFI_SYSTEM_CONTEXT.
+**/
+VOID
+EFIAPI
+DumpCpuContext (
+  IN EFI_EXCEPTION_TYPE     ExceptionType,
+  IN EFI_SYSTEM_CONTEXT     SystemContext
+  )
+{
+}
+
+/**
+  Emulate SerialPortInitialize(), there is no serial port.
+
+  @retval RETURN_SUCCESS    The serial port is initialized.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortInitialize (
+  VOID
+  )
+{
+  return RETURN_SUCCESS;
+}
+
+/**
+  Emulate LocateProtocol(), SMM is not installed.
+
+  @param[in]  Protocol      Provides the protocol to search for.
+  @param[in]  Registration  Optional registration key.
+  @param[out] Interface     The protocol interface.
+
+  @retval EFI_NOT_FOUND     No protocol instance is found.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestLocateProtocol (
+  IN  EFI_GUID              *Protocol,
+  IN  VOID                  *Registration OPTIONAL,
+  OUT VOID                  **Interface
+  )
+{
+  *Interface = NULL;
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Emulate the CPUID of a processor supporting the execute disable bit, and 1G
+  pages if the paging parameter says so.
+
+  @param[in]  Index         The 32-bit value to load into EAX prior to invoking the CPUID instruction.
+  @param[out] Eax           The pointer to the 32-bit EAX value returned by the CPUID instruction.
+  @param[out] Ebx           The pointer to the 32-bit EBX value returned by the CPUID instruction.
+  @param[out] Ecx           The pointer to the 32-bit ECX value returned by the CPUID instruction.
+  @param[out] Edx           The pointer to the 32-bit EDX value returned by the CPUID instruction.
+
+  @return Index.
+**/
+UINT32
+EFIAPI
+UnitTestCpuPageTableAsmCpuid (
+  IN      UINT32            Index,
+  OUT     UINT32            *Eax,  OPTIONAL
+  OUT     UINT32            *Ebx,  OPTIONAL
+  OUT     UINT32            *Ecx,  OPTIONAL
+  OUT     UINT32            *Edx   OPTIONAL
+  )
+{
+  CPUID_EXTENDED_CPU_SIG_EDX  ExtendedCpuSigEdx;
+
+  if (Eax != NULL) {
+    *Eax = 0;
+  }
+  if (Ebx != NULL) {
+    *Ebx = 0;
+  }
+  if (Ecx != NULL) {
+    *Ecx = 0;
+  }
+  if (Edx != NULL) {
+    *Edx = 0;
+  }
+
+  switch (Index) {
+  case CPUID_EXTENDED_FUNCTION:
+    if (Eax != NULL) {
+      *Eax = CPUID_VIR_PHY_ADDRESS_SIZE;
+    }
+    break;
+  case CPUID_EXTENDED_CPU_SIG:
+    ExtendedCpuSigEdx.Uint32       = 0;
+    ExtendedCpuSigEdx.Bits.NX      = 1;
+    ExtendedCpuSigEdx.Bits.Page1GB = mPaging->Page1GSupport ? 1 : 0;
+    if (Edx != NULL) {
+      *Edx = ExtendedCpuSigEdx.Uint32;
+    }
+    break;
+  }
+
+  return Index;
+}
+
+/**
+  Emulate the MSRs of a processor with the execute disable bit enabled.
+
+  @param[in] MsrIndex       The 32-bit MSR index to read.
+
+  @return The value of the MSR.
+**/
+UINT64
+EFIAPI
+UnitTestCpuPageTableAsmReadMsr64 (
+  IN UINT32                 MsrIndex
+  )
+{
+  MSR_IA32_EFER_REGISTER    Efer;
+
+  if (MsrIndex == MSR_IA32_EFER) {
+    Efer.Uint64   = 0;
+    Efer.Bits.LME = 1;
+    Efer.Bits.LMA = 1;
+    Efer.Bits.NXE = 1;
+    return Efer.Uint64;
+  }
+
+  return 0;
+}
+
+/**
+  Return the page attributes of a page entry.
+
+  @param[in] Entry          The page entry.
+
+  @return The page attributes.
+**/
+STATIC
+UINT8
+GetEntryAttributes (
+  IN UINT64                 Entry
+  )
+{
+  UINT8                     Attributes;
+
+  Attributes = 0;
+  if ((Entry & ENTRY_P) == 0) {
+    Attributes |= PAGE_RP;
+  }
+  if ((Entry & ENTRY_RW) == 0) {
+    Attributes |= PAGE_RO;
+  }
+  if ((Entry & ENTRY_NX) != 0) {
+    Attributes |= PAGE_XP;
+  }
+  return Attributes;
+}
+
+/**
+  Return the page attributes matching memory attributes.
+
+  @param[in] Attributes     The memory attributes.
+
+  @return The page attributes.
+**/
+STATIC
+UINT8
+GetPageAttributes (
+  IN UINT64                 Attributes
+  )
+{
+  return (UINT8)(((Attributes & EFI_MEMORY_RP) != 0 ? PAGE_RP : 0) |
+                 ((Attributes & EFI_MEMORY_RO) != 0 ? PAGE_RO : 0) |
+                 ((Attributes & EFI_MEMORY_XP) != 0 ? PAGE_XP : 0));
+}
+
+/**
+  Check whether the pages of a range of the window have the same expected
+  attributes.
+
+  @param[in] Page           The first page of the range in the window.
+  @param[in] PageCount      The number of pages of the range.
+  @param[in] Attributes     The attributes to compare with.
+
+  @retval TRUE    All the pages of the range have these attributes.
+  @retval FALSE   Some pages do not.
+**/
+STATIC
+BOOLEAN
+IsRangeUniform (
+  IN UINTN                  Page,
+  IN UINTN                  PageCount,
+  IN UINT8                  Attributes
+  )
+{
+  UINTN                     Index;
+
+  for (Index = Page; Index < Page + PageCount; Index++) {
+    if (mExpected[Index] != Attributes) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Return the page directory pointer table mapping the window.
+
+  @return The page directory pointer table.
+**/
+STATIC
+UINT64 *
+GetWindowPageDirectoryPointerTable (
+  VOID
+  )
+{
+  UINT64                    *Pml4;
+
+  Pml4 = (UINT64 *)(UINTN)(AsmReadCr3 () & ENTRY_ADDRESS_MASK);
+  return (UINT64 *)(UINTN)(Pml4[(UINTN)RShiftU64 (TEST_WINDOW_BASE, 39) & (ENTRY_COUNT - 1)] & ENTRY_ADDRESS_MASK);
+}
+
+/**
+  Check the page table mapping the window: every page must be identity mapped
+  with its expected attributes, and no page table must map memory which a
+  large page could map.
+
+  @retval UNIT_TEST_PASSED              The page table is correct and minimal.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The page table is wrong or too large.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckPageTable (
+  VOID
+  )
+{
+  UINT64                    *Pdpt;
+  UINT64                    *Pd;
+  UINT64                    *Pt;
+  UINT64                    Entry;
+  UINT64                    Address;
+  UINTN                     Page;
+  UINTN                     Index1G;
+  UINTN                     Index2M;
+  UINTN                     Index4K;
+  UINTN                     TableCount;
+  UINTN                     ExpectedTableCount;
+
+  Pdpt               = GetWindowPageDirectoryPointerTable ();
+  TableCount         = 0;
+  ExpectedTableCount = 0;
+
+  for (Index1G = 0; Index1G < TEST_WINDOW_SIZE / SIZE_1GB; Index1G++) {
+    Address = TEST_WINDOW_BASE + MultU64x32 (SIZE_1GB, (UINT32)Index1G);
+    Page    = Index1G * (SIZE_1GB / SIZE_4KB);
+    if (!mPaging->Page1GSupport || !IsRangeUniform (Page, SIZE_1GB / SIZE_4KB, mExpected[Page])) {
+      ExpectedTableCount++;
+      for (Index2M = 0; Index2M < ENTRY_COUNT; Index2M++) {
+        if (!IsRangeUniform (Page + Index2M * ENTRY_COUNT, ENTRY_COUNT, mExpected[Page + Index2M * ENTRY_COUNT])) {
+          ExpectedTableCount++;
+        }
+      }
+    }
+
+    Entry = Pdpt[(UINTN)RShiftU64 (Address, 30) & (ENTRY_COUNT - 1)];
+    if ((Entry & ENTRY_PS) != 0) {
+      UT_ASSERT_TRUE (mPaging->Page1GSupport);
+      UT_ASSERT_EQUAL (Entry & ENTRY_ADDRESS_MASK, Address);
+      UT_ASSERT_TRUE (IsRangeUniform (Page, SIZE_1GB / SIZE_4KB, GetEntryAttributes (Entry)));
+      continue;
+    }
+
+    TableCount++;
+    Pd = (UINT64 *)(UINTN)(Entry & ENTRY_ADDRESS_MASK);
+    for (Index2M = 0; Index2M < ENTRY_COUNT; Index2M++, Address += SIZE_2MB, Page += ENTRY_COUNT) {
+      Entry = Pd[Index2M];
+      if ((Entry & ENTRY_PS) != 0) {
+        UT_ASSERT_EQUAL (Entry & ENTRY_ADDRESS_MASK, Address);
+        UT_ASSERT_TRUE (IsRangeUniform (Page, ENTRY_COUNT, GetEntryAttributes (Entry)));
+        continue;
+      }
+
+      TableCount++;
+      Pt = (UINT64 *)(UINTN)(Entry & ENTRY_ADDRESS_MASK);
+      for (Index4K = 0; Index4K < ENTRY_COUNT; Index4K++) {
+        UT_ASSERT_EQUAL (Pt[Index4K] & ENTRY_ADDRESS_MASK, Address + Index4K * SIZE_4KB);
+        UT_ASSERT_EQUAL (GetEntryAttributes (Pt[Index4K]), mExpected[Page + Index4K]);
+      }
+    }
+  }
+
+  UT_ASSERT_EQUAL (TableCount, ExpectedTableCount);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Generate a random range of the window and random attributes for it. The
+  ranges are of all sizes, aligned or not on large pages.
+
+  @param[out] Range         The range.
+**/
+STATIC
+VOID
+GenerateRandomRange (
+  OUT PAGE_TABLE_LIB_MEMORY_RANGE  *Range
+  )
+{
+  UINTN                     Page;
+  UINTN                     PageCount;
+
+  switch (rand () % 4) {
+  case 0:
+    Page      = rand () % TEST_WINDOW_PAGES;
+    PageCount = 1 + rand () % 16;
+    break;
+  case 1:
+    Page      = rand () % TEST_WINDOW_PAGES;
+    PageCount = 1 + rand () % (2 * ENTRY_COUNT);
+    break;
+  case 2:
+    Page      = (rand () % (TEST_WINDOW_SIZE / SIZE_2MB)) * ENTRY_COUNT;
+    PageCount = (1 + rand () % (SIZE_1GB / SIZE_2MB)) * ENTRY_COUNT;
+    break;
+  default:
+    Page      = (rand () % (TEST_WINDOW_SIZE / SIZE_1GB)) * (SIZE_1GB / SIZE_4KB);
+    PageCount = (1 + rand () % (TEST_WINDOW_SIZE / SIZE_1GB)) * (SIZE_1GB / SIZE_4KB);
+    break;
+  }
+  PageCount = MIN (PageCount, TEST_WINDOW_PAGES - Page);
+
+  Range->BaseAddress = TEST_WINDOW_BASE + EFI_PAGES_TO_SIZE (Page);
+  Range->Length      = EFI_PAGES_TO_SIZE (PageCount);
+  Range->Attributes  = mTestAttributes[rand () % ARRAY_SIZE (mTestAttributes)];
+}
+
+/**
+  Update the expected attributes of the pages of a range.
+
+  @param[in] Range          The range and its new attributes.
+**/
+STATIC
+VOID
+UpdateExpectedAttributes (
+  IN PAGE_TABLE_LIB_MEMORY_RANGE  *Range
+  )
+{
+  SetMem (
+    &mExpected[(UINTN)EFI_SIZE_TO_PAGES (Range->BaseAddress - TEST_WINDOW_BASE)],
+    (UINTN)EFI_SIZE_TO_PAGES (Range->Length),
+    GetPageAttributes (Range->Attributes)
+    );
+}
+
+/**
+  Build the identity map of the whole address space, with 1G pages or with 2M
+  pages in the window if 1G pages are not supported, and load it in the
+  emulated processor.
+
+  @param[in] Context        The paging parameter.
+
+  @retval UNIT_TEST_PASSED              The paging is initialized.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The paging could not be initialized.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+InitializePaging (
+  IN UNIT_TEST_CONTEXT      Context
+  )
+{
+  UINT64                    *Pml4;
+  UINT64                    *Pdpt;
+  UINT64                    *Pd;
+  UINTN                     Index4;
+  UINTN                     Index3;
+  UINTN                     Index2;
+  UINT64                    Address;
+  IA32_CR0                  Cr0;
+  IA32_CR4                  Cr4;
+
+  mPaging = (PAGING_PARAMETER *)Context;
+
+  //
+  // One PML4, one page directory pointer table per PML4 entry, and the page
+  // directories of the window.
+  //
+  mIdentityMapPages = 1 + ENTRY_COUNT + TEST_WINDOW_SIZE / SIZE_1GB;
+  mIdentityMap      = AllocateAlignedPages (mIdentityMapPages, SIZE_4KB);
+  mExpected         = AllocateZeroPool (TEST_WINDOW_PAGES);
+  UT_ASSERT_NOT_NULL (mIdentityMap);
+  UT_ASSERT_NOT_NULL (mExpected);
+
+  Pml4 = mIdentityMap;
+  for (Index4 = 0; Index4 < ENTRY_COUNT; Index4++) {
+    Pdpt = Pml4 + ENTRY_COUNT * (1 + Index4);
+    Pml4[Index4] = (UINT64)(UINTN)Pdpt | ENTRY_RW | ENTRY_P;
+    for (Index3 = 0; Index3 < ENTRY_COUNT; Index3++) {
+      Address = LShiftU64 (Index4, 39) | LShiftU64 (Index3, 30);
+      Pdpt[Index3] = Address | ENTRY_PS | ENTRY_RW | ENTRY_P;
+    }
+  }
+
+  if (!mPaging->Page1GSupport) {
+    Pdpt = (UINT64 *)(UINTN)(Pml4[(UINTN)RShiftU64 (TEST_WINDOW_BASE, 39) & (ENTRY_COUNT - 1)] & ENTRY_ADDRESS_MASK);
+    for (Index3 = 0; Index3 < TEST_WINDOW_SIZE / SIZE_1GB; Index3++) {
+      Pd      = Pml4 + ENTRY_COUNT * (1 + ENTRY_COUNT + Index3);
+      Address = TEST_WINDOW_BASE + MultU64x32 (SIZE_1GB, (UINT32)Index3);
+      Pdpt[(UINTN)RShiftU64 (Address, 30) & (ENTRY_COUNT - 1)] = (UINT64)(UINTN)Pd | ENTRY_RW | ENTRY_P;
+      for (Index2 = 0; Index2 < ENTRY_COUNT; Index2++) {
+        Pd[Index2] = (Address + Index2 * SIZE_2MB) | ENTRY_PS | ENTRY_RW | ENTRY_P;
+      }
+    }
+  }
+
+  Cr0.UintN   = 0;
+  Cr0.Bits.PE = 1;
+  Cr0.Bits.WP = 1;
+  Cr0.Bits.PG = 1;
+  Cr4.UintN    = 0;
+  Cr4.Bits.PAE = 1;
+  AsmWriteCr0 (Cr0.UintN);
+  AsmWriteCr3 ((UINTN)Pml4);
+  AsmWriteCr4 (Cr4.UintN);
+
+  gUnitTestHostBaseLib.X86->AsmCpuid     = UnitTestCpuPageTableAsmCpuid;
+  gUnitTestHostBaseLib.X86->AsmReadMsr64 = UnitTestCpuPageTableAsmReadMsr64;
+  mBootServices.LocateProtocol           = UnitTestLocateProtocol;
+
+  srand (0x1234);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the identity map and the expected attributes of the window.
+
+  @param[in] Context        The paging parameter.
+**/
+VOID
+EFIAPI
+CleanupPaging (
+  IN UNIT_TEST_CONTEXT      Context
+  )
+{
+  FreeAlignedPages (mIdentityMap, mIdentityMapPages);
+  FreePool (mExpected);
+  mIdentityMap = NULL;
+  mExpected    = NULL;
+}
+
+/**
+  Assign random attributes to random ranges one at a time, checking the page
+  table after each of them.
+
+  @param[in] Context        The paging parameter.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestRandomAttributes (
+  IN UNIT_TEST_CONTEXT      Context
+  )
+{
+  PAGE_TABLE_LIB_MEMORY_RANGE  Range;
+  UNIT_TEST_STATUS             Status;
+  UINTN                        Round;
+
+  Status = CheckPageTable ();
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  for (Round = 0; Round < ROUND_COUNT; Round++) {
+    GenerateRandomRange (&Range);
+    UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Range.BaseAddress, Range.Length, Range.Attributes, NULL));
+    UpdateExpectedAttributes (&Range);
+
+    Status = CheckPageTable ();
+    if (Status != UNIT_TEST_PASSED) {
+      return Status;
+    }
+  }
+
+  //
+  // Back to the attributes of the whole window, the window is mapped by large
+  // pages again.
+  //
+  Range.BaseAddress = TEST_WINDOW_BASE;
+  Range.Length      = TEST_WINDOW_SIZE;
+  Range.Attributes  = 0;
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Range.BaseAddress, Range.Length, Range.Attributes, NULL));
+  UpdateExpectedAttributes (&Range);
+  return CheckPageTable ();
+}
+
+/**
+  Assign random attributes to batches of random ranges, checking the page
+  table after each batch.
+
+  @param[in] Context        The paging parameter.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestBatchAttributes (
+  IN UNIT_TEST_CONTEXT      Context
+  )
+{
+  PAGE_TABLE_LIB_MEMORY_RANGE  Ranges[BATCH_RANGE_COUNT];
+  UNIT_TEST_STATUS             Status;
+  UINTN                        Round;
+  UINTN                        Index;
+
+  for (Round = 0; Round < ROUND_COUNT / BATCH_RANGE_COUNT; Round++) {
+    for (Index = 0; Index < BATCH_RANGE_COUNT; Index++) {
+      GenerateRandomRange (&Ranges[Index]);
+    }
+    UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributesBatch (NULL, Ranges, BATCH_RANGE_COUNT, NULL));
+    for (Index = 0; Index < BATCH_RANGE_COUNT; Index++) {
+      UpdateExpectedAttributes (&Ranges[Index]);
+    }
+
+    Status = CheckPageTable ();
+    if (Status != UNIT_TEST_PASSED) {
+      return Status;
+    }
+  }
+
+  //
+  // The ranges before an invalid one are assigned, not the ones after it.
+  //
+  GenerateRandomRange (&Ranges[0]);
+  GenerateRandomRange (&Ranges[2]);
+  Ranges[1].BaseAddress = TEST_WINDOW_BASE + 1;
+  Ranges[1].Length      = SIZE_4KB;
+  Ranges[1].Attributes  = 0;
+  UT_ASSERT_STATUS_EQUAL (AssignMemoryPageAttributesBatch (NULL, Ranges, 3, NULL), RETURN_UNSUPPORTED);
+  UpdateExpectedAttributes (&Ranges[0]);
+  Status = CheckPageTable ();
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_STATUS_EQUAL (AssignMemoryPageAttributesBatch (NULL, NULL, 1, NULL), RETURN_INVALID_PARAMETER);
+  UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributesBatch (NULL, NULL, 0, NULL));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Split and coalesce the same large pages again and again: the page tables
+  released by the coalescing are reused by the next split, so that the page
+  table pool does not shrink.
+
+  @param[in] Context        The paging parameter.
+
+  @retval UNIT_TEST_PASSED              The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestPageTableReuse (
+  IN UNIT_TEST_CONTEXT      Context
+  )
+{
+  PAGE_TABLE_LIB_MEMORY_RANGE  Range;
+  UNIT_TEST_STATUS             Status;
+  PAGE_TABLE_POOL              *Pool;
+  UINTN                        FreePages;
+  UINTN                        Round;
+
+  Pool      = NULL;
+  FreePages = 0;
+  for (Round = 0; Round < REUSE_ROUND_COUNT; Round++) {
+    Range.BaseAddress = TEST_WINDOW_BASE + SIZE_1GB + SIZE_2MB + EFI_PAGES_TO_SIZE (Round % ENTRY_COUNT);
+    Range.Length      = SIZE_4KB;
+    Range.Attributes  = EFI_MEMORY_RO | EFI_MEMORY_XP;
+    UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Range.BaseAddress, Range.Length, Range.Attributes, NULL));
+    UpdateExpectedAttributes (&Range);
+    Status = CheckPageTable ();
+    if (Status != UNIT_TEST_PASSED) {
+      return Status;
+    }
+
+    Range.Attributes = 0;
+    UT_ASSERT_NOT_EFI_ERROR (AssignMemoryPageAttributes (NULL, Range.BaseAddress, Range.Length, Range.Attributes, NULL));
+    UpdateExpectedAttributes (&Range);
+    Status = CheckPageTable ();
+    if (Status != UNIT_TEST_PASSED) {
+      return Status;
+    }
+
+    if (Round == 0) {
+      Pool      = mPageTablePool;
+      FreePages = mPageTablePool->FreePages;
+    } else {
+      UT_ASSERT_TRUE (mPageTablePool == Pool);
+      UT_ASSERT_EQUAL (mPageTablePool->FreePages, FreePages);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the page
+  table management of CpuDxe and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PageTableTests;
+  UINTN                       Index;
+  PAGING_PARAMETER            *Paging;
+
+  Framework = NULL;
+
+  //
+  // Setup the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&PageTableTests, Framework, "CpuPageTable Tests", "CpuDxe.CpuPageTable", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CpuPageTable Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mPagingParameters); Index++) {
+    Paging = &mPagingParameters[Index];
+    AddTestCase (PageTableTests, "Test random attributes",           "RandomAttributes", UnitTestRandomAttributes, InitializePaging, CleanupPaging, Paging);
+    AddTestCase (PageTableTests, "Test batches of random attributes", "BatchAttributes",  UnitTestBatchAttributes,  InitializePaging, CleanupPaging, Paging);
+    AddTestCase (PageTableTests, "Test reuse of page tables",        "PageTableReuse",   UnitTestPageTableReuse,   InitializePaging, CleanupPaging, Paging);
+  }
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param Argc  Number of arguments.
+  @param Argv  Array of arguments.
+
+  @return Test application exit code.
+**/
+INT32
+main (
+  INT32 Argc,
+  CHAR8 *Argv[]
+  )
+{
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+  return UnitTestingEntry ();
+}
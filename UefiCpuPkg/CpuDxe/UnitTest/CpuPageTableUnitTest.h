@@ -0,0 +1,30 @@
+/** @file
+  Host based unit tests of the page table management of CpuDxe.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _CPU_PAGE_TABLE_UNIT_TEST_H_
+#define _CPU_PAGE_TABLE_UNIT_TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../CpuDxe.h"
+#include "../CpuPageTable.h"
+#include <Library/UnitTestLib.h>
+#include <Library/UnitTestHostBaseLib.h>
+#include <Register/Intel/Cpuid.h>
+
+#define UNIT_TEST_APP_NAME        "CpuDxe Page Table Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+extern PAGE_TABLE_POOL            *mPageTablePool;
+
+#endif
@@ -0,0 +1,235 @@
+/** @file
+  Task-parallel runtime on the processors of the MP services.
+
+  A root procedure submitted by MpTaskRun() runs as a task on one of the
+  processors, while all the other enabled processors become workers. A task
+  spawns child tasks with MpTaskSpawn() and waits for them with MpTaskJoin();
+  every worker keeps the tasks it spawns in its own deque and idle workers
+  steal from the other deques, so the work spreads over all processors
+  without the caller splitting it. MpTaskParallelFor() splits an index range
+  this way.
+
+  The tasks run on APs, so they must follow the rules of AP procedures of
+  the MP services: no boot services, PEI services or other non-MP-safe calls,
+  and no deep recursion on the small AP stacks. Every spawned task must be
+  joined before the procedure that spawned it returns, and the MP_TASK of a
+  task must stay valid until it is joined.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _MP_TASK_LIB_H_
+#define _MP_TASK_LIB_H_
+
+///
+/// A worker of the runtime, passed to every task.
+///
+typedef struct _MP_TASK_WORKER  MP_TASK_WORKER;
+
+/**
+  The procedure of a task.
+
+  @param[in]  Worker      The worker running the task.
+  @param[in]  Context     The context of the task.
+
+**/
+typedef
+VOID
+(EFIAPI *MP_TASK_PROCEDURE)(
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  );
+
+/**
+  The procedure of a parallel loop, called for sub-ranges of the range.
+
+  @param[in]  Worker      The worker running the sub-range.
+  @param[in]  Start       The first index of the sub-range.
+  @param[in]  End         The index after the last one of the sub-range.
+  @param[in]  Context     The context of the loop.
+
+**/
+typedef
+VOID
+(EFIAPI *MP_TASK_RANGE_PROCEDURE)(
+  IN MP_TASK_WORKER  *Worker,
+  IN UINTN           Start,
+  IN UINTN           End,
+  IN VOID            *Context
+  );
+
+///
+/// A task, and the future of its completion. The storage belongs to the
+/// caller of MpTaskSpawn(), typically on its stack.
+///
+typedef struct {
+  MP_TASK_PROCEDURE  Procedure;
+  VOID               *Context;
+  volatile UINT32    Done;
+} MP_TASK;
+
+///
+/// Counters of a run, summed over the workers.
+///
+typedef struct {
+  UINTN              WorkerCount;
+  UINT64             Spawned;         ///< Tasks pushed to a deque.
+  UINT64             Inlined;         ///< Tasks run at once, their deque being full.
+  UINT64             Stolen;          ///< Tasks run by another worker than the spawning one.
+  UINT64             StealAttempts;   ///< Rounds over the other deques that found no task.
+} MP_TASK_STATISTICS;
+
+/**
+  Run a procedure as the root task on the processors of the MP services,
+  and return when it and all the tasks it spawned are done.
+
+  Without MP services or enabled APs, all the tasks run on the calling
+  processor.
+
+  @param[in]   Procedure    The procedure of the root task.
+  @param[in]   Context      The context of the root task.
+  @param[out]  Statistics   The counters of the run. Optional.
+
+  @retval RETURN_SUCCESS          The root task is done.
+  @retval RETURN_INVALID_PARAMETER Procedure is NULL.
+  @retval RETURN_ALREADY_STARTED  A run is in progress.
+  @retval RETURN_OUT_OF_RESOURCES Failed to allocate the workers.
+  @retval RETURN_UNSUPPORTED      The calling PEIM executes in place from flash.
+
+**/
+RETURN_STATUS
+EFIAPI
+MpTaskRun (
+  IN  MP_TASK_PROCEDURE   Procedure,
+  IN  VOID                *Context,
+  OUT MP_TASK_STATISTICS  *Statistics  OPTIONAL
+  );
+
+/**
+  Spawn a task that may run in parallel with the caller, until joined.
+
+  @param[in]   Worker       The worker running the caller.
+  @param[out]  Task         The task, valid until MpTaskJoin() returns.
+  @param[in]   Procedure    The procedure of the task.
+  @param[in]   Context      The context of the task.
+
+**/
+VOID
+EFIAPI
+MpTaskSpawn (
+  IN  MP_TASK_WORKER     *Worker,
+  OUT MP_TASK            *Task,
+  IN  MP_TASK_PROCEDURE  Procedure,
+  IN  VOID               *Context
+  );
+
+/**
+  Wait for a spawned task to be done, running other tasks meanwhile.
+
+  @param[in]  Worker      The worker running the caller.
+  @param[in]  Task        The task spawned by the caller.
+
+**/
+VOID
+EFIAPI
+MpTaskJoin (
+  IN MP_TASK_WORKER  *Worker,
+  IN MP_TASK         *Task
+  );
+
+/**
+  Check whether a spawned task is done, without waiting.
+
+  @param[in]  Task        The task.
+
+  @retval TRUE            The task is done.
+  @retval FALSE           The task is pending or running.
+
+**/
+BOOLEAN
+EFIAPI
+MpTaskIsDone (
+  IN MP_TASK  *Task
+  );
+
+/**
+  Call a procedure for sub-ranges of an index range in parallel, and
+  return when the whole range is done.
+
+  The range is split in halves until the sub-ranges have at most Grain
+  indexes, and the halves are spawned as tasks.
+
+  @param[in]  Worker      The worker running the caller.
+  @param[in]  Start       The first index of the range.
+  @param[in]  End         The index after the last one of the range.
+  @param[in]  Grain       The largest sub-range, 0 to split the range in
+                          about eight sub-ranges per worker.
+  @param[in]  Procedure   The procedure called for every sub-range.
+  @param[in]  Context     The context of the procedure.
+
+**/
+VOID
+EFIAPI
+MpTaskParallelFor (
+  IN MP_TASK_WORKER           *Worker,
+  IN UINTN                    Start,
+  IN UINTN                    End,
+  IN UINTN                    Grain,
+  IN MP_TASK_RANGE_PROCEDURE  Procedure,
+  IN VOID                     *Context
+  );
+
+/**
+  Run a parallel loop over an index range as the root task of a run, see
+  MpTaskRun() and MpTaskParallelFor().
+
+  @param[in]  Start       The first index of the range.
+  @param[in]  End         The index after the last one of the range.
+  @param[in]  Grain       The largest sub-range, 0 for the default.
+  @param[in]  Procedure   The procedure called for every sub-range.
+  @param[in]  Context     The context of the procedure.
+
+  @retval RETURN_SUCCESS          The whole range is done.
+  @retval Others                  See MpTaskRun().
+
+**/
+RETURN_STATUS
+EFIAPI
+MpTaskRunParallelFor (
+  IN UINTN                    Start,
+  IN UINTN                    End,
+  IN UINTN                    Grain,
+  IN MP_TASK_RANGE_PROCEDURE  Procedure,
+  IN VOID                     *Context
+  );
+
+/**
+  Get the index of a worker, to keep per-worker data.
+
+  @param[in]  Worker      The worker.
+
+  @return The index of the worker, less than the count of workers.
+
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerIndex (
+  IN MP_TASK_WORKER  *Worker
+  );
+
+/**
+  Get the number of workers of the run of a worker.
+
+  @param[in]  Worker      The worker.
+
+  @return The number of workers.
+
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerCount (
+  IN MP_TASK_WORKER  *Worker
+  );
+
+#endif
@@ -103,6 +103,38 @@ typedef struct {
   MTRR_MEMORY_CACHE_TYPE Type;
 } MTRR_MEMORY_RANGE;
 
+//
+// Count of calculations remembered by MTRR_CALCULATION_CACHE, and the biggest
+// count of memory ranges and of variable MTRRs of a remembered calculation.
+//
+#define  MTRR_CALCULATION_CACHE_ENTRY_COUNT  16
+#define  MTRR_CALCULATION_CACHE_RANGE_COUNT  8
+#define  MTRR_CALCULATION_CACHE_MTRR_COUNT   8
+
+//
+// Structure to hold the variable MTRRs calculated for the memory ranges
+// between two power-of-two aligned addresses
+//
+typedef struct {
+  MTRR_MEMORY_CACHE_TYPE DefaultType;
+  UINT64                 A0;
+  UINT32                 RangeCount;
+  UINT32                 MtrrCount;
+  MTRR_MEMORY_RANGE      Ranges[MTRR_CALCULATION_CACHE_RANGE_COUNT];
+  MTRR_MEMORY_RANGE      Mtrrs[MTRR_CALCULATION_CACHE_MTRR_COUNT];
+} MTRR_CALCULATION_CACHE_ENTRY;
+
+//
+// Structure to hold the results of previous MTRR calculations.
+// It is owned by the caller and must be zeroed before the first use.
+//
+typedef struct {
+  UINT32                       NextEntry;
+  UINT32                       Hits;
+  UINT32                       Misses;
+  MTRR_CALCULATION_CACHE_ENTRY Entry[MTRR_CALCULATION_CACHE_ENTRY_COUNT];
+} MTRR_CALCULATION_CACHE;
+
 /**
   Returns the variable MTRR count for the CPU.
 
@@ -361,4 +393,48 @@ MtrrSetMemoryAttributesInMtrrSettings (
   IN     CONST MTRR_MEMORY_RANGE *Ranges,
   IN     UINTN                   RangeCount
   );
+
+/**
+  This function attempts to set the attributes into MTRR setting buffer for multiple memory ranges,
+  reusing the variable MTRRs calculated by previous calls for the parts of the memory layout
+  that did not change.
+
+  A caller setting memory ranges one call after the other, or setting again a memory layout
+  close to a previous one, should keep the same cache across the calls.
+
+  @param[in, out]  MtrrSetting  MTRR setting buffer to be set.
+  @param[in]       Scratch      A temporary scratch buffer that is used to perform the calculation.
+  @param[in, out]  ScratchSize  Pointer to the size in bytes of the scratch buffer.
+                                It may be updated to the actual required size when the calculation
+                                needs more scratch buffer.
+  @param[in]       Ranges       Pointer to an array of MTRR_MEMORY_RANGE.
+                                When range overlap happens, the last one takes higher priority.
+                                When the function returns, either all the attributes are set successfully,
+                                or none of them is set.
+  @param[in]       RangeCount   Count of MTRR_MEMORY_RANGE.
+  @param[in, out]  Cache        The results of the previous MTRR calculations, updated with the results
+                                of this call. NULL means no result is reused.
+
+  @retval RETURN_SUCCESS            The attributes were set for all the memory ranges.
+  @retval RETURN_INVALID_PARAMETER  Length in any range is zero.
+  @retval RETURN_UNSUPPORTED        The processor does not support one or more bytes of the
+                                    memory resource range specified by BaseAddress and Length in any range.
+  @retval RETURN_UNSUPPORTED        The bit mask of attributes is not support for the memory resource
+                                    range specified by BaseAddress and Length in any range.
+  @retval RETURN_OUT_OF_RESOURCES   There are not enough system resources to modify the attributes of
+                                    the memory resource ranges.
+  @retval RETURN_ACCESS_DENIED      The attributes for the memory resource range specified by
+                                    BaseAddress and Length cannot be modified.
+  @retval RETURN_BUFFER_TOO_SMALL   The scratch buffer is too small for MTRR calculation.
+**/
+RETURN_STATUS
+EFIAPI
+MtrrSetMemoryAttributesInMtrrSettingsWithCache (
+  IN OUT MTRR_SETTINGS           *MtrrSetting,
+  IN     VOID                    *Scratch,
+  IN OUT UINTN                   *ScratchSize,
+  IN     CONST MTRR_MEMORY_RANGE *Ranges,
+  IN     UINTN                   RangeCount,
+  IN OUT MTRR_CALCULATION_CACHE  *Cache OPTIONAL
+  );
 #endif // _MTRR_LIB_H_
@@ -130,21 +130,27 @@ MicrocodeDetect (
 
 
   //
-  // Check whether AP has same processor with BSP.
-  // If yes, direct use microcode info saved by BSP.
+  // Check whether AP has same processor with BSP or with any AP that has already
+  // found its microcode. If yes, direct use microcode info saved by that processor,
+  // so the microcode region is only scanned once for each kind of processor.
+  // The APs run in parallel, but MicrocodeEntryAddr is only written once by its owner
+  // and the entry address fits in the natural width, so a processor either sees zero
+  // or the complete entry address.
   //
   if (!IsBspCallIn) {
-    //
-    // Get the CPU data for BSP
-    //
-    CpuData = &(CpuMpData->CpuData[CpuMpData->BspNumber]);
-    if ((CpuData->ProcessorSignature == Eax.Uint32) &&
-        (CpuData->PlatformId == PlatformId) &&
-        (CpuData->MicrocodeEntryAddr != 0)) {
-      MicrocodeEntryPoint = (CPU_MICROCODE_HEADER *)(UINTN) CpuData->MicrocodeEntryAddr;
-      MicrocodeData       = (VOID *) (MicrocodeEntryPoint + 1);
-      LatestRevision      = MicrocodeEntryPoint->UpdateRevision;
-      goto Done;
+    for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+      //
+      // Start from the CPU data for BSP
+      //
+      CpuData = &(CpuMpData->CpuData[(Index + CpuMpData->BspNumber) % CpuMpData->CpuCount]);
+      if ((CpuData->ProcessorSignature == Eax.Uint32) &&
+          (CpuData->PlatformId == PlatformId) &&
+          (CpuData->MicrocodeEntryAddr != 0)) {
+        MicrocodeEntryPoint = (CPU_MICROCODE_HEADER *)(UINTN) CpuData->MicrocodeEntryAddr;
+        MicrocodeData       = (VOID *) (MicrocodeEntryPoint + 1);
+        LatestRevision      = MicrocodeEntryPoint->UpdateRevision;
+        goto Done;
+      }
     }
   }
 
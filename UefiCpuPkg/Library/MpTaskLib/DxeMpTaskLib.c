@@ -0,0 +1,124 @@
+/** @file
+  MP services access of the MP Task Library for DXE drivers.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include "InternalMpTaskLib.h"
+
+/**
+  Get the MP services of the current phase.
+
+  @param[out] MpServices    The MP services.
+
+  @retval EFI_SUCCESS       The MP services are returned.
+  @retval EFI_NOT_FOUND     The MP services are not installed.
+**/
+EFI_STATUS
+MpTaskGetMpServices (
+  OUT MP_SERVICES           *MpServices
+  )
+{
+  return gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&MpServices->Protocol);
+}
+
+/**
+  Get the number of enabled processors, the calling one included.
+
+  @param[in]  MpServices    The MP services.
+
+  @return The number of enabled processors.
+**/
+UINTN
+MpTaskGetEnabledProcessorCount (
+  IN MP_SERVICES            MpServices
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     NumberOfProcessors;
+  UINTN                     NumberOfEnabledProcessors;
+
+  Status = MpServices.Protocol->GetNumberOfProcessors (MpServices.Protocol, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return 1;
+  }
+
+  return NumberOfEnabledProcessors;
+}
+
+/**
+  Run a procedure on all the enabled processors, the calling one included,
+  and return when it has returned on all of them.
+
+  The protocol only starts procedures on the APs, so they are started in
+  non-blocking mode while the BSP runs the procedure, and the BSP then
+  waits for the completion event. This needs the caller to run below
+  TPL_NOTIFY, as the protocol itself does.
+
+  @param[in]  MpServices          The MP services.
+  @param[in]  Procedure           The procedure.
+  @param[in]  ProcedureArgument   The argument of the procedure.
+
+  @retval EFI_SUCCESS       The procedure has run on all enabled processors.
+  @retval Others            The procedure has not run on any processor.
+**/
+EFI_STATUS
+MpTaskStartupAllCPUs (
+  IN MP_SERVICES            MpServices,
+  IN EFI_AP_PROCEDURE       Procedure,
+  IN VOID                   *ProcedureArgument
+  )
+{
+  EFI_STATUS                Status;
+  EFI_EVENT                 Event;
+
+  Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Event);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = MpServices.Protocol->StartupAllAPs (MpServices.Protocol, Procedure, FALSE, Event, 0, ProcedureArgument, NULL);
+  if (Status == EFI_NOT_STARTED) {
+    //
+    // EFI_NOT_STARTED is returned when there is no enabled AP.
+    //
+    gBS->CloseEvent (Event);
+    Procedure (ProcedureArgument);
+    return EFI_SUCCESS;
+  }
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (Event);
+    return Status;
+  }
+
+  Procedure (ProcedureArgument);
+
+  while (gBS->CheckEvent (Event) == EFI_NOT_READY) {
+    CpuPause ();
+  }
+  gBS->CloseEvent (Event);
+  return EFI_SUCCESS;
+}
+
+/**
+  Check if a global variable of the library can be written, as the module
+  doesn't execute in place from flash.
+
+  @param[in]  Address       The address of the global variable.
+
+  @retval TRUE              The global variable is in RAM.
+  @retval FALSE             The global variable is in read-only memory.
+**/
+BOOLEAN
+MpTaskIsWritableGlobal (
+  IN CONST VOID             *Address
+  )
+{
+  //
+  // DXE drivers and UEFI applications are always loaded to RAM.
+  //
+  return TRUE;
+}
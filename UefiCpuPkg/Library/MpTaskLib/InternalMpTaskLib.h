@@ -0,0 +1,136 @@
+/** @file
+  Internal header file of the MP Task Library.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _INTERNAL_MP_TASK_LIB_H_
+#define _INTERNAL_MP_TASK_LIB_H_
+
+#include <PiPei.h>
+#include <Ppi/MpServices2.h>
+#include <Protocol/MpService.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/MpTaskLib.h>
+
+//
+// Number of tasks a worker can keep pending, a power of two. A task spawned
+// on a full deque runs at once on the spawning worker.
+//
+#define MP_TASK_DEQUE_SIZE        256
+
+//
+// Number of tasks a worker waiting in MpTaskJoin() may run nested on its
+// stack. Beyond, it waits without running other tasks, to bound the stack
+// usage on APs.
+//
+#define MP_TASK_MAX_NESTING       8
+
+//
+// Number of sub-ranges per worker MpTaskParallelFor() aims at when no grain
+// is given.
+//
+#define MP_TASK_RANGES_PER_WORKER 8
+
+typedef union {
+  EDKII_PEI_MP_SERVICES2_PPI    *Ppi;
+  EFI_MP_SERVICES_PROTOCOL      *Protocol;
+} MP_SERVICES;
+
+typedef struct _MP_TASK_RUN  MP_TASK_RUN;
+
+struct _MP_TASK_WORKER {
+  MP_TASK_RUN               *Run;
+  UINTN                     Index;
+  //
+  // The deque of the tasks spawned by the worker and not started yet. The
+  // worker pushes and pops at Bottom, thieves take at Top. Both only grow,
+  // the slot of an index is Index % MP_TASK_DEQUE_SIZE.
+  //
+  SPIN_LOCK                 Lock;
+  volatile UINTN            Top;
+  volatile UINTN            Bottom;
+  MP_TASK                   *Tasks[MP_TASK_DEQUE_SIZE];
+  UINTN                     Nesting;
+  UINT32                    Seed;
+  UINT64                    Spawned;
+  UINT64                    Inlined;
+  UINT64                    Stolen;
+  UINT64                    StealAttempts;
+};
+
+struct _MP_TASK_RUN {
+  MP_TASK_PROCEDURE         Procedure;
+  VOID                      *Context;
+  UINTN                     WorkerCount;
+  //
+  // Number of processors that entered the run, giving them their worker.
+  //
+  volatile UINT32           Arrived;
+  volatile BOOLEAN          Finished;
+  MP_TASK_WORKER            *Workers;
+};
+
+/**
+  Get the MP services of the current phase.
+
+  @param[out] MpServices    The MP services.
+
+  @retval EFI_SUCCESS       The MP services are returned.
+  @retval EFI_NOT_FOUND     The MP services are not installed.
+**/
+EFI_STATUS
+MpTaskGetMpServices (
+  OUT MP_SERVICES           *MpServices
+  );
+
+/**
+  Get the number of enabled processors, the calling one included.
+
+  @param[in]  MpServices    The MP services.
+
+  @return The number of enabled processors.
+**/
+UINTN
+MpTaskGetEnabledProcessorCount (
+  IN MP_SERVICES            MpServices
+  );
+
+/**
+  Run a procedure on all the enabled processors, the calling one included,
+  and return when it has returned on all of them.
+
+  @param[in]  MpServices          The MP services.
+  @param[in]  Procedure           The procedure.
+  @param[in]  ProcedureArgument   The argument of the procedure.
+
+  @retval EFI_SUCCESS       The procedure has run on all enabled processors.
+  @retval Others            The procedure has not run on any processor.
+**/
+EFI_STATUS
+MpTaskStartupAllCPUs (
+  IN MP_SERVICES            MpServices,
+  IN EFI_AP_PROCEDURE       Procedure,
+  IN VOID                   *ProcedureArgument
+  );
+
+/**
+  Check if a global variable of the library can be written, as the module
+  doesn't execute in place from flash.
+
+  @param[in]  Address       The address of the global variable.
+
+  @retval TRUE              The global variable is in RAM.
+  @retval FALSE             The global variable is in read-only memory.
+**/
+BOOLEAN
+MpTaskIsWritableGlobal (
+  IN CONST VOID             *Address
+  );
+
+#endif
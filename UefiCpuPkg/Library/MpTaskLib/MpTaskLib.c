@@ -0,0 +1,610 @@
+/** @file
+  Work-stealing task scheduler of the MP Task Library.
+
+  Every enabled processor of a run gets a worker, in the order the
+  processors enter the run; the first one runs the root task and the others
+  steal tasks until the root task is done. A worker pushes the tasks it
+  spawns to the bottom of its deque, and MpTaskJoin() pops the joined task
+  back from the bottom when nobody stole it meanwhile, so most tasks run on
+  the spawning worker at the cost of a push and a pop. Thieves take the
+  oldest task at the top of a deque, which in divide and conquer code is
+  the largest piece of work left.
+
+  The deques are protected by a spin lock each. Only the owner and the
+  occasional thief take it, and thieves skip the deques they see empty
+  without taking their lock.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "InternalMpTaskLib.h"
+
+typedef struct {
+  MP_TASK_RANGE_PROCEDURE   Procedure;
+  VOID                      *Context;
+  UINTN                     Start;
+  UINTN                     End;
+  UINTN                     Grain;
+} MP_TASK_RANGE;
+
+//
+// A PEIM executing in place can't write it, see MpTaskIsWritableGlobal().
+//
+STATIC volatile UINT32      mMpTaskRunning = 0;
+
+/**
+  Get a pseudo random number for the worker, to choose the deques to steal
+  from.
+
+  @param[in, out] Worker    The worker.
+
+  @return A pseudo random number.
+**/
+STATIC
+UINT32
+MpTaskRandom (
+  IN OUT MP_TASK_WORKER     *Worker
+  )
+{
+  UINT32                    Seed;
+
+  //
+  // xorshift32
+  //
+  Seed = Worker->Seed;
+  Seed ^= Seed << 13;
+  Seed ^= Seed >> 17;
+  Seed ^= Seed << 5;
+  Worker->Seed = Seed;
+  return Seed;
+}
+
+/**
+  Run a task and mark it as done.
+
+  @param[in]  Worker        The worker running the task.
+  @param[in]  Task          The task.
+**/
+STATIC
+VOID
+MpTaskExecute (
+  IN MP_TASK_WORKER         *Worker,
+  IN MP_TASK                *Task
+  )
+{
+  Task->Procedure (Worker, Task->Context);
+
+  //
+  // Make the results of the task visible before the completion.
+  //
+  MemoryFence ();
+  Task->Done = TRUE;
+}
+
+/**
+  Take the oldest pending task from the deque of another worker.
+
+  @param[in, out] Worker    The worker looking for a task.
+
+  @return The stolen task, or NULL if no other deque had a pending task.
+**/
+STATIC
+MP_TASK *
+MpTaskSteal (
+  IN OUT MP_TASK_WORKER     *Worker
+  )
+{
+  MP_TASK_RUN               *Run;
+  MP_TASK_WORKER            *Victim;
+  MP_TASK                   *Task;
+  UINTN                     Start;
+  UINTN                     Count;
+
+  Run = Worker->Run;
+  if (Run->WorkerCount == 1) {
+    return NULL;
+  }
+
+  Start = MpTaskRandom (Worker) % Run->WorkerCount;
+  for (Count = 0; Count < Run->WorkerCount; Count++) {
+    Victim = &Run->Workers[(Start + Count) % Run->WorkerCount];
+    if ((Victim == Worker) || (Victim->Top == Victim->Bottom)) {
+      continue;
+    }
+    if (!AcquireSpinLockOrFail (&Victim->Lock)) {
+      continue;
+    }
+
+    Task = NULL;
+    if (Victim->Top != Victim->Bottom) {
+      Task = Victim->Tasks[Victim->Top % MP_TASK_DEQUE_SIZE];
+      Victim->Top++;
+    }
+    ReleaseSpinLock (&Victim->Lock);
+
+    if (Task != NULL) {
+      Worker->Stolen++;
+      return Task;
+    }
+  }
+
+  Worker->StealAttempts++;
+  return NULL;
+}
+
+/**
+  Steal a task and run it on the worker.
+
+  @param[in, out] Worker    The worker.
+
+  @retval TRUE              A task was stolen and has run.
+  @retval FALSE             No other deque had a pending task.
+**/
+STATIC
+BOOLEAN
+MpTaskStealAndExecute (
+  IN OUT MP_TASK_WORKER     *Worker
+  )
+{
+  MP_TASK                   *Task;
+
+  Task = MpTaskSteal (Worker);
+  if (Task == NULL) {
+    return FALSE;
+  }
+
+  Worker->Nesting++;
+  MpTaskExecute (Worker, Task);
+  Worker->Nesting--;
+  return TRUE;
+}
+
+/**
+  The procedure every enabled processor runs during a run.
+
+  @param[in]  Buffer        The MP_TASK_RUN of the run.
+**/
+STATIC
+VOID
+EFIAPI
+MpTaskWorkerEntry (
+  IN VOID                   *Buffer
+  )
+{
+  MP_TASK_RUN               *Run;
+  MP_TASK_WORKER            *Worker;
+  UINTN                     Index;
+
+  Run   = (MP_TASK_RUN *) Buffer;
+  Index = InterlockedIncrement (&Run->Arrived) - 1;
+  if (Index >= Run->WorkerCount) {
+    //
+    // A processor enabled after the run allocated its workers.
+    //
+    return;
+  }
+
+  Worker = &Run->Workers[Index];
+  if (Index == 0) {
+    Run->Procedure (Worker, Run->Context);
+    MemoryFence ();
+    Run->Finished = TRUE;
+    return;
+  }
+
+  while (!Run->Finished) {
+    if (!MpTaskStealAndExecute (Worker)) {
+      CpuPause ();
+    }
+  }
+}
+
+/**
+  Run a procedure as the root task on the processors of the MP services,
+  and return when it and all the tasks it spawned are done.
+
+  Without MP services or enabled APs, all the tasks run on the calling
+  processor.
+
+  @param[in]   Procedure    The procedure of the root task.
+  @param[in]   Context      The context of the root task.
+  @param[out]  Statistics   The counters of the run. Optional.
+
+  @retval RETURN_SUCCESS          The root task is done.
+  @retval RETURN_INVALID_PARAMETER Procedure is NULL.
+  @retval RETURN_ALREADY_STARTED  A run is in progress.
+  @retval RETURN_OUT_OF_RESOURCES Failed to allocate the workers.
+  @retval RETURN_UNSUPPORTED      The calling PEIM executes in place from flash.
+
+**/
+RETURN_STATUS
+EFIAPI
+MpTaskRun (
+  IN  MP_TASK_PROCEDURE   Procedure,
+  IN  VOID                *Context,
+  OUT MP_TASK_STATISTICS  *Statistics  OPTIONAL
+  )
+{
+  EFI_STATUS                Status;
+  MP_SERVICES               MpServices;
+  MP_TASK_RUN               *Run;
+  MP_TASK_WORKER            *Worker;
+  UINTN                     WorkerCount;
+  UINTN                     Pages;
+  UINTN                     Index;
+
+  if (Procedure == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (!MpTaskIsWritableGlobal ((CONST VOID *) &mMpTaskRunning)) {
+    DEBUG ((DEBUG_ERROR, "%a: The module executes in place, the library needs to be shadowed to RAM\n", __FUNCTION__));
+    return RETURN_UNSUPPORTED;
+  }
+
+  if (InterlockedCompareExchange32 (&mMpTaskRunning, FALSE, TRUE) != FALSE) {
+    return RETURN_ALREADY_STARTED;
+  }
+
+  WorkerCount = 1;
+  Status = MpTaskGetMpServices (&MpServices);
+  if (!EFI_ERROR (Status)) {
+    WorkerCount = MAX (MpTaskGetEnabledProcessorCount (MpServices), 1);
+  }
+
+  //
+  // Pages rather than pool, the PEI pool being too small for the deques of
+  // many processors.
+  //
+  Pages = EFI_SIZE_TO_PAGES (sizeof (MP_TASK_RUN) + WorkerCount * sizeof (MP_TASK_WORKER));
+  Run   = AllocatePages (Pages);
+  if (Run == NULL) {
+    mMpTaskRunning = FALSE;
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Run, EFI_PAGES_TO_SIZE (Pages));
+  Run->Procedure   = Procedure;
+  Run->Context     = Context;
+  Run->WorkerCount = WorkerCount;
+  Run->Workers     = (MP_TASK_WORKER *) (Run + 1);
+  for (Index = 0; Index < WorkerCount; Index++) {
+    Worker        = &Run->Workers[Index];
+    Worker->Run   = Run;
+    Worker->Index = Index;
+    Worker->Seed  = (UINT32) (Index * 0x9E3779B1 + 1);
+    InitializeSpinLock (&Worker->Lock);
+  }
+
+  if (WorkerCount > 1) {
+    Status = MpTaskStartupAllCPUs (MpServices, MpTaskWorkerEntry, Run);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "%a: Cannot start the APs - %r, running on the BSP only\n", __FUNCTION__, Status));
+      Run->WorkerCount = 1;
+    }
+  }
+  if (Run->WorkerCount == 1) {
+    MpTaskWorkerEntry (Run);
+  }
+  ASSERT (Run->Finished);
+
+  if (Statistics != NULL) {
+    ZeroMem (Statistics, sizeof (*Statistics));
+    Statistics->WorkerCount = Run->WorkerCount;
+    for (Index = 0; Index < Run->WorkerCount; Index++) {
+      Worker = &Run->Workers[Index];
+      Statistics->Spawned       += Worker->Spawned;
+      Statistics->Inlined       += Worker->Inlined;
+      Statistics->Stolen        += Worker->Stolen;
+      Statistics->StealAttempts += Worker->StealAttempts;
+    }
+  }
+
+  FreePages (Run, Pages);
+  mMpTaskRunning = FALSE;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Spawn a task that may run in parallel with the caller, until joined.
+
+  @param[in]   Worker       The worker running the caller.
+  @param[out]  Task         The task, valid until MpTaskJoin() returns.
+  @param[in]   Procedure    The procedure of the task.
+  @param[in]   Context      The context of the task.
+
+**/
+VOID
+EFIAPI
+MpTaskSpawn (
+  IN  MP_TASK_WORKER     *Worker,
+  OUT MP_TASK            *Task,
+  IN  MP_TASK_PROCEDURE  Procedure,
+  IN  VOID               *Context
+  )
+{
+  BOOLEAN                   Pushed;
+
+  ASSERT (Worker != NULL);
+  ASSERT (Task != NULL);
+  ASSERT (Procedure != NULL);
+
+  Task->Procedure = Procedure;
+  Task->Context   = Context;
+  Task->Done      = FALSE;
+
+  AcquireSpinLock (&Worker->Lock);
+  Pushed = (BOOLEAN) (Worker->Bottom - Worker->Top < MP_TASK_DEQUE_SIZE);
+  if (Pushed) {
+    Worker->Tasks[Worker->Bottom % MP_TASK_DEQUE_SIZE] = Task;
+    Worker->Bottom++;
+  }
+  ReleaseSpinLock (&Worker->Lock);
+
+  if (Pushed) {
+    Worker->Spawned++;
+  } else {
+    Worker->Inlined++;
+    MpTaskExecute (Worker, Task);
+  }
+}
+
+/**
+  Wait for a spawned task to be done, running other tasks meanwhile.
+
+  @param[in]  Worker      The worker running the caller.
+  @param[in]  Task        The task spawned by the caller.
+
+**/
+VOID
+EFIAPI
+MpTaskJoin (
+  IN MP_TASK_WORKER  *Worker,
+  IN MP_TASK         *Task
+  )
+{
+  MP_TASK                   *Popped;
+
+  ASSERT (Worker != NULL);
+  ASSERT (Task != NULL);
+
+  //
+  // While the task is pending in the deque, the tasks below it in the deque
+  // are the ones spawned after it, so the caller has them to join too: run
+  // them from the bottom up to the task. Once the task is stolen, all the
+  // tasks left in the deque are newer than it.
+  //
+  while (!Task->Done) {
+    Popped = NULL;
+    AcquireSpinLock (&Worker->Lock);
+    if (Worker->Bottom != Worker->Top) {
+      Worker->Bottom--;
+      Popped = Worker->Tasks[Worker->Bottom % MP_TASK_DEQUE_SIZE];
+    }
+    ReleaseSpinLock (&Worker->Lock);
+
+    if (Popped != NULL) {
+      MpTaskExecute (Worker, Popped);
+      continue;
+    }
+
+    //
+    // The task runs on a thief. Help the other workers until it is done.
+    //
+    if ((Worker->Nesting >= MP_TASK_MAX_NESTING) || !MpTaskStealAndExecute (Worker)) {
+      CpuPause ();
+    }
+  }
+  MemoryFence ();
+}
+
+/**
+  Check whether a spawned task is done, without waiting.
+
+  @param[in]  Task        The task.
+
+  @retval TRUE            The task is done.
+  @retval FALSE           The task is pending or running.
+
+**/
+BOOLEAN
+EFIAPI
+MpTaskIsDone (
+  IN MP_TASK  *Task
+  )
+{
+  ASSERT (Task != NULL);
+
+  return (BOOLEAN) (Task->Done != FALSE);
+}
+
+/**
+  Run a sub-range of a parallel loop, splitting it in halves until the
+  halves are small enough.
+
+  @param[in]  Worker      The worker.
+  @param[in]  Context     The MP_TASK_RANGE of the sub-range.
+**/
+STATIC
+VOID
+EFIAPI
+MpTaskRangeProcedure (
+  IN MP_TASK_WORKER         *Worker,
+  IN VOID                   *Context
+  )
+{
+  MP_TASK_RANGE             *Range;
+  MP_TASK_RANGE             Lower;
+  MP_TASK_RANGE             Upper;
+  MP_TASK                   Task;
+  UINTN                     Middle;
+
+  Range = (MP_TASK_RANGE *) Context;
+  if (Range->End - Range->Start <= Range->Grain) {
+    Range->Procedure (Worker, Range->Start, Range->End, Range->Context);
+    return;
+  }
+
+  Middle = Range->Start + (Range->End - Range->Start) / 2;
+
+  Upper.Procedure = Range->Procedure;
+  Upper.Context   = Range->Context;
+  Upper.Start     = Middle;
+  Upper.End       = Range->End;
+  Upper.Grain     = Range->Grain;
+
+  Lower.Procedure = Range->Procedure;
+  Lower.Context   = Range->Context;
+  Lower.Start     = Range->Start;
+  Lower.End       = Middle;
+  Lower.Grain     = Range->Grain;
+
+  MpTaskSpawn (Worker, &Task, MpTaskRangeProcedure, &Upper);
+  MpTaskRangeProcedure (Worker, &Lower);
+  MpTaskJoin (Worker, &Task);
+}
+
+/**
+  Call a procedure for sub-ranges of an index range in parallel, and
+  return when the whole range is done.
+
+  The range is split in halves until the sub-ranges have at most Grain
+  indexes, and the halves are spawned as tasks.
+
+  @param[in]  Worker      The worker running the caller.
+  @param[in]  Start       The first index of the range.
+  @param[in]  End         The index after the last one of the range.
+  @param[in]  Grain       The largest sub-range, 0 to split the range in
+                          about eight sub-ranges per worker.
+  @param[in]  Procedure   The procedure called for every sub-range.
+  @param[in]  Context     The context of the procedure.
+
+**/
+VOID
+EFIAPI
+MpTaskParallelFor (
+  IN MP_TASK_WORKER           *Worker,
+  IN UINTN                    Start,
+  IN UINTN                    End,
+  IN UINTN                    Grain,
+  IN MP_TASK_RANGE_PROCEDURE  Procedure,
+  IN VOID                     *Context
+  )
+{
+  MP_TASK_RANGE             Range;
+
+  ASSERT (Worker != NULL);
+  ASSERT (Procedure != NULL);
+
+  if (Start >= End) {
+    return;
+  }
+
+  if (Grain == 0) {
+    Grain = MAX ((End - Start) / (Worker->Run->WorkerCount * MP_TASK_RANGES_PER_WORKER), 1);
+  }
+
+  Range.Procedure = Procedure;
+  Range.Context   = Context;
+  Range.Start     = Start;
+  Range.End       = End;
+  Range.Grain     = Grain;
+  MpTaskRangeProcedure (Worker, &Range);
+}
+
+/**
+  The root task of MpTaskRunParallelFor().
+
+  @param[in]  Worker      The worker.
+  @param[in]  Context     The MP_TASK_RANGE of the whole range.
+**/
+STATIC
+VOID
+EFIAPI
+MpTaskParallelForRoot (
+  IN MP_TASK_WORKER         *Worker,
+  IN VOID                   *Context
+  )
+{
+  MP_TASK_RANGE             *Range;
+
+  Range = (MP_TASK_RANGE *) Context;
+  MpTaskParallelFor (Worker, Range->Start, Range->End, Range->Grain, Range->Procedure, Range->Context);
+}
+
+/**
+  Run a parallel loop over an index range as the root task of a run, see
+  MpTaskRun() and MpTaskParallelFor().
+
+  @param[in]  Start       The first index of the range.
+  @param[in]  End         The index after the last one of the range.
+  @param[in]  Grain       The largest sub-range, 0 for the default.
+  @param[in]  Procedure   The procedure called for every sub-range.
+  @param[in]  Context     The context of the procedure.
+
+  @retval RETURN_SUCCESS          The whole range is done.
+  @retval Others                  See MpTaskRun().
+
+**/
+RETURN_STATUS
+EFIAPI
+MpTaskRunParallelFor (
+  IN UINTN                    Start,
+  IN UINTN                    End,
+  IN UINTN                    Grain,
+  IN MP_TASK_RANGE_PROCEDURE  Procedure,
+  IN VOID                     *Context
+  )
+{
+  MP_TASK_RANGE             Range;
+
+  if (Procedure == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Range.Procedure = Procedure;
+  Range.Context   = Context;
+  Range.Start     = Start;
+  Range.End       = End;
+  Range.Grain     = Grain;
+  return MpTaskRun (MpTaskParallelForRoot, &Range, NULL);
+}
+
+/**
+  Get the index of a worker, to keep per-worker data.
+
+  @param[in]  Worker      The worker.
+
+  @return The index of the worker, less than the count of workers.
+
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerIndex (
+  IN MP_TASK_WORKER  *Worker
+  )
+{
+  ASSERT (Worker != NULL);
+
+  return Worker->Index;
+}
+
+/**
+  Get the number of workers of the run of a worker.
+
+  @param[in]  Worker      The worker.
+
+  @return The number of workers.
+
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerCount (
+  IN MP_TASK_WORKER  *Worker
+  )
+{
+  ASSERT (Worker != NULL);
+
+  return Worker->Run->WorkerCount;
+}
@@ -0,0 +1,98 @@
+/** @file
+  MP services access of the MP Task Library for PEI modules.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/HobLib.h>
+#include <Library/PeiServicesLib.h>
+#include "InternalMpTaskLib.h"
+
+/**
+  Get the MP services of the current phase.
+
+  @param[out] MpServices    The MP services.
+
+  @retval EFI_SUCCESS       The MP services are returned.
+  @retval EFI_NOT_FOUND     The MP services are not installed.
+**/
+EFI_STATUS
+MpTaskGetMpServices (
+  OUT MP_SERVICES           *MpServices
+  )
+{
+  return PeiServicesLocatePpi (&gEdkiiPeiMpServices2PpiGuid, 0, NULL, (VOID **)&MpServices->Ppi);
+}
+
+/**
+  Get the number of enabled processors, the calling one included.
+
+  @param[in]  MpServices    The MP services.
+
+  @return The number of enabled processors.
+**/
+UINTN
+MpTaskGetEnabledProcessorCount (
+  IN MP_SERVICES            MpServices
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     NumberOfProcessors;
+  UINTN                     NumberOfEnabledProcessors;
+
+  Status = MpServices.Ppi->GetNumberOfProcessors (MpServices.Ppi, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return 1;
+  }
+
+  return NumberOfEnabledProcessors;
+}
+
+/**
+  Run a procedure on all the enabled processors, the calling one included,
+  and return when it has returned on all of them.
+
+  @param[in]  MpServices          The MP services.
+  @param[in]  Procedure           The procedure.
+  @param[in]  ProcedureArgument   The argument of the procedure.
+
+  @retval EFI_SUCCESS       The procedure has run on all enabled processors.
+  @retval Others            The procedure has not run on any processor.
+**/
+EFI_STATUS
+MpTaskStartupAllCPUs (
+  IN MP_SERVICES            MpServices,
+  IN EFI_AP_PROCEDURE       Procedure,
+  IN VOID                   *ProcedureArgument
+  )
+{
+  return MpServices.Ppi->StartupAllCPUs (MpServices.Ppi, Procedure, 0, ProcedureArgument);
+}
+
+/**
+  Check if a global variable of the library can be written, as the module
+  doesn't execute in place from flash.
+
+  @param[in]  Address       The address of the global variable.
+
+  @retval TRUE              The global variable is in RAM.
+  @retval FALSE             The global variable is in read-only memory.
+**/
+BOOLEAN
+MpTaskIsWritableGlobal (
+  IN CONST VOID             *Address
+  )
+{
+  EFI_HOB_HANDOFF_INFO_TABLE  *HandOffHob;
+
+  //
+  // The PHIT HOB describes the memory PEIMs are loaded to, the temporary RAM
+  // before memory is discovered and the permanent memory after. A PEIM
+  // executing in place from flash is outside of it.
+  //
+  HandOffHob = (EFI_HOB_HANDOFF_INFO_TABLE *) GetHobList ();
+  return (BOOLEAN) (((UINTN) Address >= HandOffHob->EfiMemoryBottom) &&
+                    ((UINTN) Address < HandOffHob->EfiMemoryTop));
+}
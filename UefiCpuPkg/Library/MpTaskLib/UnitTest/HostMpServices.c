@@ -0,0 +1,137 @@
+/** @file
+  MP services of the MP Task Library emulated with POSIX threads, one
+  thread per AP.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MpTaskLibUnitTest.h"
+
+typedef struct {
+  EFI_AP_PROCEDURE          Procedure;
+  VOID                      *ProcedureArgument;
+} HOST_AP_CONTEXT;
+
+UINTN                       mHostProcessorCount;
+
+/**
+  Get the MP services of the current phase.
+
+  @param[out] MpServices    The MP services.
+
+  @retval EFI_SUCCESS       The MP services are returned.
+  @retval EFI_NOT_FOUND     The MP services are not installed.
+**/
+EFI_STATUS
+MpTaskGetMpServices (
+  OUT MP_SERVICES           *MpServices
+  )
+{
+  if (mHostProcessorCount == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  MpServices->Ppi = NULL;
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the number of enabled processors, the calling one included.
+
+  @param[in]  MpServices    The MP services.
+
+  @return The number of enabled processors.
+**/
+UINTN
+MpTaskGetEnabledProcessorCount (
+  IN MP_SERVICES            MpServices
+  )
+{
+  return mHostProcessorCount;
+}
+
+/**
+  The thread of an emulated AP.
+
+  @param[in]  Context       The HOST_AP_CONTEXT.
+
+  @return NULL.
+**/
+STATIC
+void *
+HostApThread (
+  void                      *Context
+  )
+{
+  HOST_AP_CONTEXT           *ApContext;
+
+  ApContext = (HOST_AP_CONTEXT *) Context;
+  ApContext->Procedure (ApContext->ProcedureArgument);
+  return NULL;
+}
+
+/**
+  Run a procedure on all the enabled processors, the calling one included,
+  and return when it has returned on all of them.
+
+  @param[in]  MpServices          The MP services.
+  @param[in]  Procedure           The procedure.
+  @param[in]  ProcedureArgument   The argument of the procedure.
+
+  @retval EFI_SUCCESS       The procedure has run on all enabled processors.
+  @retval Others            The procedure has not run on any processor.
+**/
+EFI_STATUS
+MpTaskStartupAllCPUs (
+  IN MP_SERVICES            MpServices,
+  IN EFI_AP_PROCEDURE       Procedure,
+  IN VOID                   *ProcedureArgument
+  )
+{
+  HOST_AP_CONTEXT           ApContext;
+  pthread_t                 *Threads;
+  UINTN                     Count;
+  UINTN                     Index;
+
+  Threads = AllocatePool (mHostProcessorCount * sizeof (pthread_t));
+  if (Threads == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ApContext.Procedure         = Procedure;
+  ApContext.ProcedureArgument = ProcedureArgument;
+  for (Count = 0; Count + 1 < mHostProcessorCount; Count++) {
+    if (pthread_create (&Threads[Count], NULL, HostApThread, &ApContext) != 0) {
+      //
+      // Like a disabled AP: the workers run without it.
+      //
+      break;
+    }
+  }
+
+  Procedure (ProcedureArgument);
+
+  for (Index = 0; Index < Count; Index++) {
+    pthread_join (Threads[Index], NULL);
+  }
+  FreePool (Threads);
+  return EFI_SUCCESS;
+}
+
+/**
+  Check if a global variable of the library can be written, as the module
+  doesn't execute in place from flash.
+
+  @param[in]  Address       The address of the global variable.
+
+  @retval TRUE              The global variable is in RAM.
+  @retval FALSE             The global variable is in read-only memory.
+**/
+BOOLEAN
+MpTaskIsWritableGlobal (
+  IN CONST VOID             *Address
+  )
+{
+  return TRUE;
+}
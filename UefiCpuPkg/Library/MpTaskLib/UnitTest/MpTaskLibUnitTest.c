@@ -0,0 +1,620 @@
+/** @file
+  Host based unit tests of the MP Task Library, and a benchmark of the task
+  spawn overhead.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MpTaskLibUnitTest.h"
+
+#define PARALLEL_FOR_COUNT        100000
+#define OVERFLOW_TASK_COUNT       (MP_TASK_DEQUE_SIZE * 4)
+#define STEAL_TASK_COUNT          3
+#define BENCHMARK_TASK_COUNT      1000000
+
+typedef struct {
+  volatile UINT32           *Hits;
+  volatile UINT32           Calls;
+} PARALLEL_FOR_CONTEXT;
+
+typedef struct {
+  UINTN                     N;
+  UINTN                     Result;
+} FIBONACCI_CONTEXT;
+
+typedef struct {
+  volatile UINT32           Started;
+  UINTN                     WorkerIndex[STEAL_TASK_COUNT];
+} STEAL_CONTEXT;
+
+typedef struct {
+  MP_TASK                   *Tasks;
+  volatile UINT32           Runs;
+  BOOLEAN                   AllDone;
+  RETURN_STATUS             NestedStatus;
+} ROOT_CONTEXT;
+
+//
+// Numbers of emulated processors the tests run with, 0 for no MP services.
+//
+STATIC UINTN mProcessorCounts[] = { 0, 1, 2, 4, 8, 16 };
+
+/**
+  Set the number of processors of the emulated MP services.
+
+  @param[in]  Context    The number of processors, a UINTN.
+
+  @retval  UNIT_TEST_PASSED   The prerequisite is met.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SetProcessorCount (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mHostProcessorCount = *(UINTN *) Context;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Get the current time.
+
+  @return The monotonic time in nanoseconds.
+**/
+STATIC
+UINT64
+GetTimeInNanoSeconds (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  clock_gettime (CLOCK_MONOTONIC, &Time);
+  return (UINT64) Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+/**
+  The procedure of the parallel loops, counting the hits of every index.
+**/
+VOID
+EFIAPI
+CountRange (
+  IN MP_TASK_WORKER  *Worker,
+  IN UINTN           Start,
+  IN UINTN           End,
+  IN VOID            *Context
+  )
+{
+  PARALLEL_FOR_CONTEXT      *ForContext;
+  UINTN                     Index;
+
+  ForContext = (PARALLEL_FOR_CONTEXT *) Context;
+  ASSERT (MpTaskGetWorkerIndex (Worker) < MpTaskGetWorkerCount (Worker));
+  InterlockedIncrement (&ForContext->Calls);
+  for (Index = Start; Index < End; Index++) {
+    InterlockedIncrement (&ForContext->Hits[Index]);
+  }
+}
+
+/**
+  Unit test of MpTaskRunParallelFor(): every index of the range is visited
+  exactly once, for various grains.
+
+  @param[in]  Context    The number of processors.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestParallelFor (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINTN        Grains[] = { 0, 1, 7, 1000, PARALLEL_FOR_COUNT };
+  PARALLEL_FOR_CONTEXT      ForContext;
+  RETURN_STATUS             Status;
+  UINTN                     GrainIndex;
+  UINTN                     Index;
+
+  ForContext.Hits = AllocatePool (PARALLEL_FOR_COUNT * sizeof (UINT32));
+  UT_ASSERT_NOT_NULL ((VOID *) ForContext.Hits);
+
+  for (GrainIndex = 0; GrainIndex < ARRAY_SIZE (Grains); GrainIndex++) {
+    ZeroMem ((VOID *) ForContext.Hits, PARALLEL_FOR_COUNT * sizeof (UINT32));
+    ForContext.Calls = 0;
+    Status = MpTaskRunParallelFor (3, PARALLEL_FOR_COUNT, Grains[GrainIndex], CountRange, &ForContext);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    for (Index = 0; Index < PARALLEL_FOR_COUNT; Index++) {
+      UT_ASSERT_EQUAL (ForContext.Hits[Index], (Index < 3) ? 0 : 1);
+    }
+    if (Grains[GrainIndex] != 0) {
+      UT_ASSERT_TRUE (ForContext.Calls >= (PARALLEL_FOR_COUNT - 3 + Grains[GrainIndex] - 1) / Grains[GrainIndex]);
+    }
+  }
+
+  //
+  // Empty range.
+  //
+  ForContext.Calls = 0;
+  Status = MpTaskRunParallelFor (5, 5, 0, CountRange, &ForContext);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (ForContext.Calls, 0);
+
+  FreePool ((VOID *) ForContext.Hits);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Compute a Fibonacci number with a task per recursion.
+**/
+VOID
+EFIAPI
+Fibonacci (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  FIBONACCI_CONTEXT         *FibContext;
+  FIBONACCI_CONTEXT         Left;
+  FIBONACCI_CONTEXT         Right;
+  MP_TASK                   Task;
+
+  FibContext = (FIBONACCI_CONTEXT *) Context;
+  if (FibContext->N < 2) {
+    FibContext->Result = FibContext->N;
+    return;
+  }
+
+  Left.N  = FibContext->N - 1;
+  Right.N = FibContext->N - 2;
+  MpTaskSpawn (Worker, &Task, Fibonacci, &Left);
+  Fibonacci (Worker, &Right);
+  MpTaskJoin (Worker, &Task);
+  FibContext->Result = Left.Result + Right.Result;
+}
+
+/**
+  Unit test of nested MpTaskSpawn() and MpTaskJoin().
+
+  @param[in]  Context    The number of processors.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestSpawnJoin (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FIBONACCI_CONTEXT         FibContext;
+  MP_TASK_STATISTICS        Statistics;
+  RETURN_STATUS             Status;
+
+  FibContext.N = 22;
+  Status = MpTaskRun (Fibonacci, &FibContext, &Statistics);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (FibContext.Result, 17711);
+
+  //
+  // Fib(22) spawns Fib(23) - 1 tasks.
+  //
+  UT_ASSERT_EQUAL (Statistics.Spawned + Statistics.Inlined, 28656);
+  UT_ASSERT_EQUAL (Statistics.WorkerCount, MAX (mHostProcessorCount, 1));
+  UT_ASSERT_TRUE (Statistics.Stolen <= Statistics.Spawned);
+  if (Statistics.WorkerCount == 1) {
+    UT_ASSERT_EQUAL (Statistics.Stolen, 0);
+  }
+
+  UT_LOG_INFO (
+    "%d workers: %ld spawned, %ld inlined, %ld stolen, %ld steal attempts\n",
+    (INT32) Statistics.WorkerCount,
+    Statistics.Spawned,
+    Statistics.Inlined,
+    Statistics.Stolen,
+    Statistics.StealAttempts
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A task counting its runs.
+**/
+VOID
+EFIAPI
+CountRun (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  InterlockedIncrement (&((ROOT_CONTEXT *) Context)->Runs);
+}
+
+/**
+  Spawn more tasks than a deque holds, then join them in the spawning order.
+**/
+VOID
+EFIAPI
+SpawnMany (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  ROOT_CONTEXT              *RootContext;
+  UINTN                     Index;
+
+  RootContext = (ROOT_CONTEXT *) Context;
+  for (Index = 0; Index < OVERFLOW_TASK_COUNT; Index++) {
+    MpTaskSpawn (Worker, &RootContext->Tasks[Index], CountRun, RootContext);
+  }
+  for (Index = 0; Index < OVERFLOW_TASK_COUNT; Index++) {
+    MpTaskJoin (Worker, &RootContext->Tasks[Index]);
+  }
+
+  RootContext->AllDone = TRUE;
+  for (Index = 0; Index < OVERFLOW_TASK_COUNT; Index++) {
+    if (!MpTaskIsDone (&RootContext->Tasks[Index])) {
+      RootContext->AllDone = FALSE;
+    }
+  }
+}
+
+/**
+  Unit test of a full deque, and of joins out of the LIFO order.
+
+  @param[in]  Context    The number of processors.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestDequeOverflow (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ROOT_CONTEXT              RootContext;
+  MP_TASK_STATISTICS        Statistics;
+  RETURN_STATUS             Status;
+
+  RootContext.Tasks = AllocateZeroPool (OVERFLOW_TASK_COUNT * sizeof (MP_TASK));
+  UT_ASSERT_NOT_NULL (RootContext.Tasks);
+  RootContext.Runs = 0;
+
+  Status = MpTaskRun (SpawnMany, &RootContext, &Statistics);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (RootContext.AllDone);
+  UT_ASSERT_EQUAL (RootContext.Runs, OVERFLOW_TASK_COUNT);
+  UT_ASSERT_EQUAL (Statistics.Spawned + Statistics.Inlined, OVERFLOW_TASK_COUNT);
+  UT_ASSERT_TRUE (Statistics.Spawned >= MP_TASK_DEQUE_SIZE);
+
+  FreePool (RootContext.Tasks);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A task that only returns once all the tasks of the test have started,
+  which needs the other workers to steal them.
+**/
+VOID
+EFIAPI
+WaitForAllStarted (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  STEAL_CONTEXT             *StealContext;
+  UINT32                    Started;
+
+  StealContext = (STEAL_CONTEXT *) Context;
+  Started      = InterlockedIncrement (&StealContext->Started);
+  StealContext->WorkerIndex[Started - 1] = MpTaskGetWorkerIndex (Worker);
+  while (StealContext->Started < STEAL_TASK_COUNT) {
+    CpuPause ();
+  }
+}
+
+/**
+  Spawn the tasks of the steal test and join them.
+**/
+VOID
+EFIAPI
+SpawnWaiters (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  MP_TASK                   Tasks[STEAL_TASK_COUNT];
+  UINTN                     Index;
+
+  for (Index = 0; Index < STEAL_TASK_COUNT; Index++) {
+    MpTaskSpawn (Worker, &Tasks[Index], WaitForAllStarted, Context);
+  }
+  for (Index = STEAL_TASK_COUNT; Index > 0; Index--) {
+    MpTaskJoin (Worker, &Tasks[Index - 1]);
+  }
+}
+
+/**
+  Unit test of the stealing: tasks waiting for each other complete only
+  when they run on distinct workers.
+
+  @param[in]  Context    The number of processors.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+  @retval  UNIT_TEST_SKIPPED            Too few processors.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestSteal (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STEAL_CONTEXT             StealContext;
+  MP_TASK_STATISTICS        Statistics;
+  RETURN_STATUS             Status;
+  UINTN                     Index;
+  UINTN                     Other;
+
+  if (mHostProcessorCount < STEAL_TASK_COUNT) {
+    return UNIT_TEST_SKIPPED;
+  }
+
+  StealContext.Started = 0;
+  Status = MpTaskRun (SpawnWaiters, &StealContext, &Statistics);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (StealContext.Started, STEAL_TASK_COUNT);
+  UT_ASSERT_TRUE (Statistics.Stolen >= STEAL_TASK_COUNT - 1);
+  for (Index = 0; Index < STEAL_TASK_COUNT; Index++) {
+    for (Other = Index + 1; Other < STEAL_TASK_COUNT; Other++) {
+      UT_ASSERT_NOT_EQUAL (StealContext.WorkerIndex[Index], StealContext.WorkerIndex[Other]);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Try to start a run from within a run.
+**/
+VOID
+EFIAPI
+RunNested (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  ROOT_CONTEXT              *RootContext;
+
+  RootContext = (ROOT_CONTEXT *) Context;
+  RootContext->NestedStatus = MpTaskRun (CountRun, RootContext, NULL);
+}
+
+/**
+  Unit test of the parameter and state checks of MpTaskRun().
+
+  @param[in]  Context    The number of processors.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestRunChecks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ROOT_CONTEXT              RootContext;
+  RETURN_STATUS             Status;
+
+  UT_ASSERT_STATUS_EQUAL (MpTaskRun (NULL, NULL, NULL), RETURN_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MpTaskRunParallelFor (0, 1, 0, NULL, NULL), RETURN_INVALID_PARAMETER);
+
+  RootContext.Runs         = 0;
+  RootContext.NestedStatus = RETURN_SUCCESS;
+  Status = MpTaskRun (RunNested, &RootContext, NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_STATUS_EQUAL (RootContext.NestedStatus, RETURN_ALREADY_STARTED);
+  UT_ASSERT_EQUAL (RootContext.Runs, 0);
+
+  //
+  // The failed nested run does not prevent the next run.
+  //
+  Status = MpTaskRun (CountRun, &RootContext, NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (RootContext.Runs, 1);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Spawn and join empty tasks one at a time.
+**/
+VOID
+EFIAPI
+SpawnJoinLoop (
+  IN MP_TASK_WORKER  *Worker,
+  IN VOID            *Context
+  )
+{
+  MP_TASK                   Task;
+  UINTN                     Index;
+
+  for (Index = 0; Index < BENCHMARK_TASK_COUNT; Index++) {
+    MpTaskSpawn (Worker, &Task, CountRun, Context);
+    MpTaskJoin (Worker, &Task);
+  }
+}
+
+/**
+  An empty loop body.
+**/
+VOID
+EFIAPI
+EmptyRange (
+  IN MP_TASK_WORKER  *Worker,
+  IN UINTN           Start,
+  IN UINTN           End,
+  IN VOID            *Context
+  )
+{
+}
+
+/**
+  Benchmark of the overhead of the runtime: a run of an empty root task, a
+  spawn and join of an empty task, and a sub-range of a parallel loop split
+  in sub-ranges of one index.
+
+  @param[in]  Context    The number of processors.
+
+  @retval  UNIT_TEST_PASSED             The benchmark has completed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestSpawnOverhead (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ROOT_CONTEXT              RootContext;
+  RETURN_STATUS             Status;
+  UINT64                    Start;
+  UINT64                    RunTime;
+  UINT64                    SpawnTime;
+  UINT64                    ForTime;
+  UINTN                     Index;
+
+  RootContext.Runs = 0;
+  Start = GetTimeInNanoSeconds ();
+  for (Index = 0; Index < 100; Index++) {
+    Status = MpTaskRun (CountRun, &RootContext, NULL);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+  RunTime = (GetTimeInNanoSeconds () - Start) / 100;
+
+  Start  = GetTimeInNanoSeconds ();
+  Status = MpTaskRun (SpawnJoinLoop, &RootContext, NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  SpawnTime = GetTimeInNanoSeconds () - Start - RunTime;
+  UT_ASSERT_EQUAL (RootContext.Runs, 100 + BENCHMARK_TASK_COUNT);
+
+  Start  = GetTimeInNanoSeconds ();
+  Status = MpTaskRunParallelFor (0, BENCHMARK_TASK_COUNT, 1, EmptyRange, NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  ForTime = GetTimeInNanoSeconds () - Start - RunTime;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%d processors: run %ld ns, spawn and join %ld ns, parallel for %ld ns per index\n",
+    (INT32) mHostProcessorCount,
+    RunTime,
+    SpawnTime / BENCHMARK_TASK_COUNT,
+    ForTime / BENCHMARK_TASK_COUNT
+    ));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  MP Task Library and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      MpTaskApiTests;
+  UNIT_TEST_SUITE_HANDLE      MpTaskBenchmarks;
+  UINTN                       Index;
+  UINTN                       *Count;
+
+  Framework = NULL;
+
+  //
+  // Setup the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&MpTaskApiTests, Framework, "MpTaskLib API Tests", "MpTaskLib.MpTaskLib", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MpTaskLib API Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&MpTaskBenchmarks, Framework, "MpTaskLib Benchmarks", "MpTaskLib.Benchmark", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MpTaskLib Benchmarks\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mProcessorCounts); Index++) {
+    Count = &mProcessorCounts[Index];
+    AddTestCase (MpTaskApiTests,   "Test MpTaskRunParallelFor",       "ParallelFor",    UnitTestParallelFor,   SetProcessorCount, NULL, Count);
+    AddTestCase (MpTaskApiTests,   "Test MpTaskSpawn and MpTaskJoin", "SpawnJoin",      UnitTestSpawnJoin,     SetProcessorCount, NULL, Count);
+    AddTestCase (MpTaskApiTests,   "Test full deque",                 "DequeOverflow",  UnitTestDequeOverflow, SetProcessorCount, NULL, Count);
+    AddTestCase (MpTaskApiTests,   "Test task stealing",              "Steal",          UnitTestSteal,         SetProcessorCount, NULL, Count);
+    AddTestCase (MpTaskApiTests,   "Test MpTaskRun checks",           "RunChecks",      UnitTestRunChecks,     SetProcessorCount, NULL, Count);
+    AddTestCase (MpTaskBenchmarks, "Task spawn overhead",             "SpawnOverhead",  UnitTestSpawnOverhead, SetProcessorCount, NULL, Count);
+  }
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param Argc  Number of arguments.
+  @param Argv  Array of arguments.
+
+  @return Test application exit code.
+**/
+INT32
+main (
+  INT32 Argc,
+  CHAR8 *Argv[]
+  )
+{
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+  return UnitTestingEntry ();
+}
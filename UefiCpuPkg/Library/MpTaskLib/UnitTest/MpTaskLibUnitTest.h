@@ -0,0 +1,33 @@
+/** @file
+  Host based unit tests of the MP Task Library.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _MP_TASK_LIB_UNIT_TEST_H_
+#define _MP_TASK_LIB_UNIT_TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../InternalMpTaskLib.h"
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "MpTaskLib Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Number of processors the emulated MP services report, 0 when the MP
+// services are not installed.
+//
+extern UINTN                      mHostProcessorCount;
+
+#endif
@@ -1903,6 +1903,152 @@ MtrrLibMergeVariableMtrr (
   }
 }
 
+/**
+  Find the calculation of the variable MTRRs for the memory ranges in the cache.
+
+  @param Cache        The results of the previous MTRR calculations.
+  @param DefaultType  Default memory type.
+  @param A0           Alignment to use when base address is 0.
+  @param Ranges       Memory ranges.
+  @param RangeCount   Count of memory ranges.
+
+  @return The cache entry holding the calculation, or NULL if the calculation is not in the cache.
+**/
+MTRR_CALCULATION_CACHE_ENTRY *
+MtrrLibFindCalculation (
+  IN MTRR_CALCULATION_CACHE  *Cache,
+  IN MTRR_MEMORY_CACHE_TYPE  DefaultType,
+  IN UINT64                  A0,
+  IN CONST MTRR_MEMORY_RANGE *Ranges,
+  IN UINTN                   RangeCount
+  )
+{
+  UINTN                         EntryIndex;
+  UINTN                         Index;
+  MTRR_CALCULATION_CACHE_ENTRY  *Entry;
+
+  for (EntryIndex = 0; EntryIndex < ARRAY_SIZE (Cache->Entry); EntryIndex++) {
+    Entry = &Cache->Entry[EntryIndex];
+    if ((Entry->RangeCount != RangeCount) || (Entry->DefaultType != DefaultType) || (Entry->A0 != A0)) {
+      continue;
+    }
+    //
+    // Compare the fields one by one because the padding of Ranges is not initialized.
+    //
+    for (Index = 0; Index < RangeCount; Index++) {
+      if ((Entry->Ranges[Index].BaseAddress != Ranges[Index].BaseAddress) ||
+          (Entry->Ranges[Index].Length != Ranges[Index].Length) ||
+          (Entry->Ranges[Index].Type != Ranges[Index].Type)) {
+        break;
+      }
+    }
+    if (Index == RangeCount) {
+      return Entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Calculate MTRR settings to cover the specified memory ranges, reusing the result
+  of a previous calculation for the same memory ranges when it is in the cache.
+
+  @param DefaultType  Default memory type.
+  @param A0           Alignment to use when base address is 0.
+  @param Ranges       Memory range array holding the memory type
+                      settings for all memory address.
+  @param RangeCount   Count of memory ranges.
+  @param Scratch      A temporary scratch buffer that is used to perform the calculation.
+                      This is an optional parameter that may be NULL.
+  @param ScratchSize  Pointer to the size in bytes of the scratch buffer.
+                      It may be updated to the actual required size when the calculation
+                      needs more scratch buffer.
+  @param Mtrrs        Array holding all MTRR settings.
+  @param MtrrCapacity Capacity of the MTRR array.
+  @param MtrrCount    The count of MTRR settings in array.
+  @param Cache        The results of the previous MTRR calculations. It may be NULL.
+
+  @retval RETURN_SUCCESS          Variable MTRRs are allocated successfully.
+  @retval RETURN_OUT_OF_RESOURCES Count of variable MTRRs exceeds capacity.
+  @retval RETURN_BUFFER_TOO_SMALL The scratch buffer is too small for MTRR calculation.
+**/
+RETURN_STATUS
+MtrrLibCalculateMtrrsWithCache (
+  IN MTRR_MEMORY_CACHE_TYPE     DefaultType,
+  IN UINT64                     A0,
+  IN CONST MTRR_MEMORY_RANGE    *Ranges,
+  IN UINTN                      RangeCount,
+  IN VOID                       *Scratch,
+  IN OUT UINTN                  *ScratchSize,
+  IN OUT MTRR_MEMORY_RANGE      *Mtrrs,
+  IN UINT32                     MtrrCapacity,
+  IN OUT UINT32                 *MtrrCount,
+  IN OUT MTRR_CALCULATION_CACHE *Cache OPTIONAL
+  )
+{
+  RETURN_STATUS                 Status;
+  UINT32                        Index;
+  UINT32                        OriginalMtrrCount;
+  MTRR_CALCULATION_CACHE_ENTRY  *Entry;
+
+  if (RangeCount == 1) {
+    //
+    // One range covering the whole power-of-two aligned [Base0, Base1) is
+    // described by one MTRR, or by the default type. It's what
+    // MtrrLibCalculateMtrrs() finds without building the graph.
+    //
+    if (Ranges[0].Type == DefaultType) {
+      return RETURN_SUCCESS;
+    }
+    return MtrrLibAppendVariableMtrr (
+             Mtrrs, MtrrCapacity, MtrrCount,
+             Ranges[0].BaseAddress, Ranges[0].Length, Ranges[0].Type
+             );
+  }
+
+  if (Cache != NULL) {
+    Entry = MtrrLibFindCalculation (Cache, DefaultType, A0, Ranges, RangeCount);
+    if (Entry != NULL) {
+      Cache->Hits++;
+      for (Index = 0; Index < Entry->MtrrCount; Index++) {
+        Status = MtrrLibAppendVariableMtrr (
+                   Mtrrs, MtrrCapacity, MtrrCount,
+                   Entry->Mtrrs[Index].BaseAddress, Entry->Mtrrs[Index].Length, Entry->Mtrrs[Index].Type
+                   );
+        if (RETURN_ERROR (Status)) {
+          return Status;
+        }
+      }
+      return RETURN_SUCCESS;
+    }
+    Cache->Misses++;
+  }
+
+  OriginalMtrrCount = *MtrrCount;
+  Status = MtrrLibCalculateMtrrs (
+             DefaultType, A0, Ranges, RangeCount,
+             Scratch, ScratchSize,
+             Mtrrs, MtrrCapacity, MtrrCount
+             );
+
+  if ((Cache != NULL) && !RETURN_ERROR (Status) &&
+      (RangeCount <= ARRAY_SIZE (Cache->Entry[0].Ranges)) &&
+      (*MtrrCount - OriginalMtrrCount <= ARRAY_SIZE (Cache->Entry[0].Mtrrs))) {
+    //
+    // Replace the oldest calculation in the cache.
+    //
+    Entry = &Cache->Entry[Cache->NextEntry];
+    Cache->NextEntry = (Cache->NextEntry + 1) % ARRAY_SIZE (Cache->Entry);
+    Entry->DefaultType = DefaultType;
+    Entry->A0          = A0;
+    Entry->RangeCount  = (UINT32)RangeCount;
+    Entry->MtrrCount   = *MtrrCount - OriginalMtrrCount;
+    CopyMem (Entry->Ranges, Ranges, RangeCount * sizeof (Ranges[0]));
+    CopyMem (Entry->Mtrrs, &Mtrrs[OriginalMtrrCount], Entry->MtrrCount * sizeof (Mtrrs[0]));
+  }
+  return Status;
+}
+
 /**
   Calculate the variable MTRR settings for all memory ranges.
 
@@ -1916,6 +2062,7 @@ MtrrLibMergeVariableMtrr (
   @param VariableMtrr         Array holding all MTRR settings.
   @param VariableMtrrCapacity Capacity of the MTRR array.
   @param VariableMtrrCount    The count of MTRR settings in array.
+  @param Cache                The results of the previous MTRR calculations. It may be NULL.
 
   @retval RETURN_SUCCESS          Variable MTRRs are allocated successfully.
   @retval RETURN_OUT_OF_RESOURCES Count of variable MTRRs exceeds capacity.
@@ -1924,15 +2071,16 @@ MtrrLibMergeVariableMtrr (
 **/
 RETURN_STATUS
 MtrrLibSetMemoryRanges (
-  IN MTRR_MEMORY_CACHE_TYPE DefaultType,
-  IN UINT64                 A0,
-  IN MTRR_MEMORY_RANGE      *Ranges,
-  IN UINTN                  RangeCount,
-  IN VOID                   *Scratch,
-  IN OUT UINTN              *ScratchSize,
-  OUT MTRR_MEMORY_RANGE     *VariableMtrr,
-  IN UINT32                 VariableMtrrCapacity,
-  OUT UINT32                *VariableMtrrCount
+  IN MTRR_MEMORY_CACHE_TYPE     DefaultType,
+  IN UINT64                     A0,
+  IN MTRR_MEMORY_RANGE          *Ranges,
+  IN UINTN                      RangeCount,
+  IN VOID                       *Scratch,
+  IN OUT UINTN                  *ScratchSize,
+  OUT MTRR_MEMORY_RANGE         *VariableMtrr,
+  IN UINT32                     VariableMtrrCapacity,
+  OUT UINT32                    *VariableMtrrCount,
+  IN OUT MTRR_CALCULATION_CACHE *Cache OPTIONAL
   )
 {
   RETURN_STATUS             Status;
@@ -2030,11 +2178,12 @@ MtrrLibSetMemoryRanges (
     Length = Ranges[End].Length;
     Ranges[End].Length = Base1 - Ranges[End].BaseAddress;
     ActualScratchSize  = *ScratchSize;
-    Status = MtrrLibCalculateMtrrs (
+    Status = MtrrLibCalculateMtrrsWithCache (
                DefaultType, A0,
                &Ranges[Index], End + 1 - Index,
                Scratch, &ActualScratchSize,
-               VariableMtrr, VariableMtrrCapacity, VariableMtrrCount
+               VariableMtrr, VariableMtrrCapacity, VariableMtrrCount,
+               Cache
                );
     if (Status == RETURN_BUFFER_TOO_SMALL) {
       BiggestScratchSize = MAX (BiggestScratchSize, ActualScratchSize);
@@ -2107,7 +2256,9 @@ MtrrLibSetBelow1MBMemoryAttribute (
 }
 
 /**
-  This function attempts to set the attributes into MTRR setting buffer for multiple memory ranges.
+  This function attempts to set the attributes into MTRR setting buffer for multiple memory ranges,
+  reusing the variable MTRRs calculated by previous calls for the parts of the memory layout
+  that did not change.
 
   @param[in, out]  MtrrSetting  MTRR setting buffer to be set.
   @param[in]       Scratch      A temporary scratch buffer that is used to perform the calculation.
@@ -2119,6 +2270,8 @@ MtrrLibSetBelow1MBMemoryAttribute (
                                 When the function returns, either all the attributes are set successfully,
                                 or none of them is set.
   @param[in]       RangeCount   Count of MTRR_MEMORY_RANGE.
+  @param[in, out]  Cache        The results of the previous MTRR calculations, updated with the results
+                                of this call. NULL means no result is reused.
 
   @retval RETURN_SUCCESS            The attributes were set for all the memory ranges.
   @retval RETURN_INVALID_PARAMETER  Length in any range is zero.
@@ -2134,12 +2287,13 @@ MtrrLibSetBelow1MBMemoryAttribute (
 **/
 RETURN_STATUS
 EFIAPI
-MtrrSetMemoryAttributesInMtrrSettings (
+MtrrSetMemoryAttributesInMtrrSettingsWithCache (
   IN OUT MTRR_SETTINGS           *MtrrSetting,
   IN     VOID                    *Scratch,
   IN OUT UINTN                   *ScratchSize,
   IN     CONST MTRR_MEMORY_RANGE *Ranges,
-  IN     UINTN                   RangeCount
+  IN     UINTN                   RangeCount,
+  IN OUT MTRR_CALCULATION_CACHE  *Cache OPTIONAL
   )
 {
   RETURN_STATUS             Status;
@@ -2310,7 +2464,8 @@ MtrrSetMemoryAttributesInMtrrSettings (
       Status = MtrrLibSetMemoryRanges (
                  DefaultType, LShiftU64 (1, (UINTN)HighBitSet64 (MtrrValidBitsMask)), WorkingRanges, WorkingRangeCount,
                  Scratch, ScratchSize,
-                 WorkingVariableMtrr, FirmwareVariableMtrrCount + 1, &WorkingVariableMtrrCount
+                 WorkingVariableMtrr, FirmwareVariableMtrrCount + 1, &WorkingVariableMtrrCount,
+                 Cache
                  );
       if (RETURN_ERROR (Status)) {
         goto Exit;
@@ -2436,6 +2591,45 @@ Exit:
   return Status;
 }
 
+/**
+  This function attempts to set the attributes into MTRR setting buffer for multiple memory ranges.
+
+  @param[in, out]  MtrrSetting  MTRR setting buffer to be set.
+  @param[in]       Scratch      A temporary scratch buffer that is used to perform the calculation.
+  @param[in, out]  ScratchSize  Pointer to the size in bytes of the scratch buffer.
+                                It may be updated to the actual required size when the calculation
+                                needs more scratch buffer.
+  @param[in]       Ranges       Pointer to an array of MTRR_MEMORY_RANGE.
+                                When range overlap happens, the last one takes higher priority.
+                                When the function returns, either all the attributes are set successfully,
+                                or none of them is set.
+  @param[in]       RangeCount   Count of MTRR_MEMORY_RANGE.
+
+  @retval RETURN_SUCCESS            The attributes were set for all the memory ranges.
+  @retval RETURN_INVALID_PARAMETER  Length in any range is zero.
+  @retval RETURN_UNSUPPORTED        The processor does not support one or more bytes of the
+                                    memory resource range specified by BaseAddress and Length in any range.
+  @retval RETURN_UNSUPPORTED        The bit mask of attributes is not support for the memory resource
+                                    range specified by BaseAddress and Length in any range.
+  @retval RETURN_OUT_OF_RESOURCES   There are not enough system resources to modify the attributes of
+                                    the memory resource ranges.
+  @retval RETURN_ACCESS_DENIED      The attributes for the memory resource range specified by
+                                    BaseAddress and Length cannot be modified.
+  @retval RETURN_BUFFER_TOO_SMALL   The scratch buffer is too small for MTRR calculation.
+**/
+RETURN_STATUS
+EFIAPI
+MtrrSetMemoryAttributesInMtrrSettings (
+  IN OUT MTRR_SETTINGS           *MtrrSetting,
+  IN     VOID                    *Scratch,
+  IN OUT UINTN                   *ScratchSize,
+  IN     CONST MTRR_MEMORY_RANGE *Ranges,
+  IN     UINTN                   RangeCount
+  )
+{
+  return MtrrSetMemoryAttributesInMtrrSettingsWithCache (MtrrSetting, Scratch, ScratchSize, Ranges, RangeCount, NULL);
+}
+
 /**
   This function attempts to set the attributes into MTRR setting buffer for a memory range.
 
@@ -990,6 +990,257 @@ UnitTestMtrrSetMemoryAttributeInMtrrSettings (
 }
 
 
+/**
+  Set the memory ranges in the MTRR setting buffer, growing the scratch buffer when it is too small.
+
+  @param MtrrSetting  MTRR setting buffer to be set.
+  @param Ranges       Memory ranges to set.
+  @param RangeCount   Count of memory ranges.
+  @param Cache        The results of the previous MTRR calculations. It may be NULL.
+
+  @return The status returned by MtrrSetMemoryAttributesInMtrrSettingsWithCache().
+**/
+RETURN_STATUS
+SetMemoryAttributesWithCache (
+  IN OUT MTRR_SETTINGS           *MtrrSetting,
+  IN     CONST MTRR_MEMORY_RANGE *Ranges,
+  IN     UINTN                   RangeCount,
+  IN OUT MTRR_CALCULATION_CACHE  *Cache
+  )
+{
+  RETURN_STATUS                  Status;
+  UINT8                          *Scratch;
+  UINTN                          ScratchSize;
+
+  ScratchSize = SCRATCH_BUFFER_SIZE;
+  Scratch     = malloc (ScratchSize);
+  Status      = MtrrSetMemoryAttributesInMtrrSettingsWithCache (MtrrSetting, Scratch, &ScratchSize, Ranges, RangeCount, Cache);
+  if (Status == RETURN_BUFFER_TOO_SMALL) {
+    Scratch = realloc (Scratch, ScratchSize);
+    Status  = MtrrSetMemoryAttributesInMtrrSettingsWithCache (MtrrSetting, Scratch, &ScratchSize, Ranges, RangeCount, Cache);
+  }
+  free (Scratch);
+  return Status;
+}
+
+/**
+  Unit test of MtrrLib service MtrrSetMemoryAttributesInMtrrSettingsWithCache()
+
+  The memory ranges are set one after the other, then all at once, with and
+  without the cache of the MTRR calculations. The MTRR settings must be the same.
+
+  @param[in]  Context    Pointer to MTRR_LIB_SYSTEM_PARAMETER.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestMtrrSetMemoryAttributesInMtrrSettingsWithCache (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
+  RETURN_STATUS                   Status;
+  RETURN_STATUS                   CachedStatus;
+  UINT32                          UcCount;
+  UINT32                          WtCount;
+  UINT32                          WbCount;
+  UINT32                          WpCount;
+  UINT32                          WcCount;
+
+  UINTN                           Index;
+  MTRR_SETTINGS                   LocalMtrrs;
+  MTRR_SETTINGS                   CachedMtrrs;
+  MTRR_CALCULATION_CACHE          *Cache;
+
+  MTRR_MEMORY_RANGE               RawMtrrRange[MTRR_NUMBER_OF_VARIABLE_MTRR];
+  MTRR_MEMORY_RANGE               ExpectedMemoryRanges[MTRR_NUMBER_OF_FIXED_MTRR * sizeof (UINT64) + 2 * MTRR_NUMBER_OF_VARIABLE_MTRR + 1];
+  UINT32                          ExpectedVariableMtrrUsage;
+  UINTN                           ExpectedMemoryRangesCount;
+
+  MTRR_MEMORY_RANGE               ActualMemoryRanges[MTRR_NUMBER_OF_FIXED_MTRR * sizeof (UINT64) + 2 * MTRR_NUMBER_OF_VARIABLE_MTRR + 1];
+  UINT32                          ActualVariableMtrrUsage;
+  UINTN                           ActualMemoryRangesCount;
+
+  SystemParameter = (MTRR_LIB_SYSTEM_PARAMETER *) Context;
+  GenerateRandomMemoryTypeCombination (
+    SystemParameter->VariableMtrrCount - PatchPcdGet32 (PcdCpuNumberOfReservedVariableMtrrs),
+    &UcCount, &WtCount, &WbCount, &WpCount, &WcCount
+    );
+  GenerateValidAndConfigurableMtrrPairs (
+    SystemParameter->PhysicalAddressBits, RawMtrrRange,
+    UcCount, WtCount, WbCount, WpCount, WcCount
+    );
+
+  ExpectedVariableMtrrUsage = UcCount + WtCount + WbCount + WpCount + WcCount;
+  ExpectedMemoryRangesCount = ARRAY_SIZE (ExpectedMemoryRanges);
+  GetEffectiveMemoryRanges (
+    SystemParameter->DefaultCacheType,
+    SystemParameter->PhysicalAddressBits,
+    RawMtrrRange, ExpectedVariableMtrrUsage,
+    ExpectedMemoryRanges, &ExpectedMemoryRangesCount
+    );
+
+  UT_LOG_INFO ("--- Expected Memory Ranges [%d] ---\n", ExpectedMemoryRangesCount);
+  DumpMemoryRanges (ExpectedMemoryRanges, ExpectedMemoryRangesCount);
+
+  Cache = calloc (1, sizeof (*Cache));
+  UT_ASSERT_NOT_NULL (Cache);
+
+  //
+  // Set the memory ranges one after the other.
+  //
+  ZeroMem (&LocalMtrrs, sizeof (LocalMtrrs));
+  LocalMtrrs.MtrrDefType = MtrrGetDefaultMemoryType ();
+  CopyMem (&CachedMtrrs, &LocalMtrrs, sizeof (CachedMtrrs));
+  for (Index = 0; Index < ExpectedMemoryRangesCount; Index++) {
+    Status       = SetMemoryAttributesWithCache (&LocalMtrrs, &ExpectedMemoryRanges[Index], 1, NULL);
+    CachedStatus = SetMemoryAttributesWithCache (&CachedMtrrs, &ExpectedMemoryRanges[Index], 1, Cache);
+    UT_ASSERT_STATUS_EQUAL (CachedStatus, Status);
+    UT_ASSERT_MEM_EQUAL (&CachedMtrrs, &LocalMtrrs, sizeof (LocalMtrrs));
+  }
+
+  //
+  // Set all the memory ranges at once, with the cache filled above.
+  //
+  ZeroMem (&LocalMtrrs, sizeof (LocalMtrrs));
+  LocalMtrrs.MtrrDefType = MtrrGetDefaultMemoryType ();
+  CopyMem (&CachedMtrrs, &LocalMtrrs, sizeof (CachedMtrrs));
+  Status       = SetMemoryAttributesWithCache (&LocalMtrrs, ExpectedMemoryRanges, ExpectedMemoryRangesCount, NULL);
+  CachedStatus = SetMemoryAttributesWithCache (&CachedMtrrs, ExpectedMemoryRanges, ExpectedMemoryRangesCount, Cache);
+  UT_ASSERT_STATUS_EQUAL (Status, RETURN_SUCCESS);
+  UT_ASSERT_STATUS_EQUAL (CachedStatus, RETURN_SUCCESS);
+  UT_ASSERT_MEM_EQUAL (&CachedMtrrs, &LocalMtrrs, sizeof (LocalMtrrs));
+
+  UT_LOG_INFO ("Cache hits = %d, misses = %d\n", Cache->Hits, Cache->Misses);
+  free (Cache);
+
+  ActualMemoryRangesCount = ARRAY_SIZE (ActualMemoryRanges);
+  CollectTestResult (
+    SystemParameter->DefaultCacheType, SystemParameter->PhysicalAddressBits, SystemParameter->VariableMtrrCount,
+    &CachedMtrrs, ActualMemoryRanges, &ActualMemoryRangesCount, &ActualVariableMtrrUsage
+    );
+  UT_LOG_INFO ("--- Actual Memory Ranges [%d] ---\n", ActualMemoryRangesCount);
+  DumpMemoryRanges (ActualMemoryRanges, ActualMemoryRangesCount);
+  VerifyMemoryRanges (ExpectedMemoryRanges, ExpectedMemoryRangesCount, ActualMemoryRanges, ActualMemoryRangesCount);
+  UT_ASSERT_TRUE (ExpectedVariableMtrrUsage >= ActualVariableMtrrUsage);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Performance test of the MTRR calculation.
+
+  Random memory layouts are set range by range and all at once, with and
+  without the cache of the MTRR calculations, and the time of each way is
+  reported. The MTRR settings of the four ways must be the same.
+
+  @param[in]  Context    Pointer to MTRR_LIB_SYSTEM_PARAMETER.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestMtrrCalculationPerformance (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST MTRR_LIB_SYSTEM_PARAMETER *SystemParameter;
+  RETURN_STATUS                   Status;
+  UINT32                          UcCount;
+  UINT32                          WtCount;
+  UINT32                          WbCount;
+  UINT32                          WpCount;
+  UINT32                          WcCount;
+
+  UINTN                           Layout;
+  UINTN                           Way;
+  UINTN                           Index;
+  MTRR_SETTINGS                   Mtrrs[4];
+  MTRR_CALCULATION_CACHE          *Cache[ARRAY_SIZE (Mtrrs)];
+  clock_t                         Ticks[ARRAY_SIZE (Mtrrs)];
+  clock_t                         Start;
+  STATIC CONST CHAR8              *WayName[ARRAY_SIZE (Mtrrs)] = {
+                                    "one by one", "one by one with cache", "at once", "at once with cache"
+                                    };
+
+  MTRR_MEMORY_RANGE               RawMtrrRange[MTRR_NUMBER_OF_VARIABLE_MTRR];
+  MTRR_MEMORY_RANGE               ExpectedMemoryRanges[MTRR_NUMBER_OF_FIXED_MTRR * sizeof (UINT64) + 2 * MTRR_NUMBER_OF_VARIABLE_MTRR + 1];
+  UINTN                           ExpectedMemoryRangesCount;
+
+  SystemParameter = (MTRR_LIB_SYSTEM_PARAMETER *) Context;
+
+  //
+  // Ways 1 and 3 keep their cache across the layouts, as a caller would.
+  //
+  for (Way = 0; Way < ARRAY_SIZE (Mtrrs); Way++) {
+    Cache[Way] = NULL;
+    if ((Way % 2) == 1) {
+      Cache[Way] = calloc (1, sizeof (*Cache[Way]));
+      UT_ASSERT_NOT_NULL (Cache[Way]);
+    }
+    Ticks[Way] = 0;
+  }
+
+  for (Layout = 0; Layout < 32; Layout++) {
+    GenerateRandomMemoryTypeCombination (
+      SystemParameter->VariableMtrrCount - PatchPcdGet32 (PcdCpuNumberOfReservedVariableMtrrs),
+      &UcCount, &WtCount, &WbCount, &WpCount, &WcCount
+      );
+    GenerateValidAndConfigurableMtrrPairs (
+      SystemParameter->PhysicalAddressBits, RawMtrrRange,
+      UcCount, WtCount, WbCount, WpCount, WcCount
+      );
+    ExpectedMemoryRangesCount = ARRAY_SIZE (ExpectedMemoryRanges);
+    GetEffectiveMemoryRanges (
+      SystemParameter->DefaultCacheType,
+      SystemParameter->PhysicalAddressBits,
+      RawMtrrRange, UcCount + WtCount + WbCount + WpCount + WcCount,
+      ExpectedMemoryRanges, &ExpectedMemoryRangesCount
+      );
+
+    for (Way = 0; Way < ARRAY_SIZE (Mtrrs); Way++) {
+      ZeroMem (&Mtrrs[Way], sizeof (Mtrrs[Way]));
+      Mtrrs[Way].MtrrDefType = MtrrGetDefaultMemoryType ();
+
+      Start = clock ();
+      if (Way < 2) {
+        for (Index = 0; Index < ExpectedMemoryRangesCount; Index++) {
+          Status = SetMemoryAttributesWithCache (&Mtrrs[Way], &ExpectedMemoryRanges[Index], 1, Cache[Way]);
+          UT_ASSERT_TRUE (Status == RETURN_SUCCESS || Status == RETURN_OUT_OF_RESOURCES);
+        }
+      } else {
+        Status = SetMemoryAttributesWithCache (&Mtrrs[Way], ExpectedMemoryRanges, ExpectedMemoryRangesCount, Cache[Way]);
+        UT_ASSERT_STATUS_EQUAL (Status, RETURN_SUCCESS);
+      }
+      Ticks[Way] += clock () - Start;
+    }
+
+    UT_ASSERT_MEM_EQUAL (&Mtrrs[1], &Mtrrs[0], sizeof (Mtrrs[0]));
+    UT_ASSERT_MEM_EQUAL (&Mtrrs[3], &Mtrrs[2], sizeof (Mtrrs[2]));
+  }
+
+  for (Way = 0; Way < ARRAY_SIZE (Mtrrs); Way++) {
+    if (Cache[Way] != NULL) {
+      UT_LOG_INFO (
+        "%a: %d us, cache hits = %d, misses = %d\n",
+        WayName[Way], (UINT32) (Ticks[Way] * 1000000 / CLOCKS_PER_SEC), Cache[Way]->Hits, Cache[Way]->Misses
+        );
+      free (Cache[Way]);
+    } else {
+      UT_LOG_INFO ("%a: %d us\n", WayName[Way], (UINT32) (Ticks[Way] * 1000000 / CLOCKS_PER_SEC));
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
   Prep routine for UnitTestGetFirmwareVariableMtrrCount().
 
@@ -1093,7 +1344,9 @@ UnitTestingEntry (
       AddTestCase (MtrrApiTests, "Test InvalidMemoryLayouts",                  "InvalidMemoryLayouts",                  UnitTestInvalidMemoryLayouts,                  InitializeSystem, NULL, &mSystemParameters[SystemIndex]);
       AddTestCase (MtrrApiTests, "Test MtrrSetMemoryAttributeInMtrrSettings",  "MtrrSetMemoryAttributeInMtrrSettings",  UnitTestMtrrSetMemoryAttributeInMtrrSettings,  InitializeSystem, NULL, &mSystemParameters[SystemIndex]);
       AddTestCase (MtrrApiTests, "Test MtrrSetMemoryAttributesInMtrrSettings", "MtrrSetMemoryAttributesInMtrrSettings", UnitTestMtrrSetMemoryAttributesInMtrrSettings, InitializeSystem, NULL, &mSystemParameters[SystemIndex]);
+      AddTestCase (MtrrApiTests, "Test MtrrSetMemoryAttributesInMtrrSettingsWithCache", "MtrrSetMemoryAttributesInMtrrSettingsWithCache", UnitTestMtrrSetMemoryAttributesInMtrrSettingsWithCache, InitializeSystem, NULL, &mSystemParameters[SystemIndex]);
     }
+    AddTestCase (MtrrApiTests, "Test MTRR calculation performance", "MtrrCalculationPerformance", UnitTestMtrrCalculationPerformance, InitializeSystem, NULL, &mSystemParameters[SystemIndex]);
   }
   //
   // Execute the tests.
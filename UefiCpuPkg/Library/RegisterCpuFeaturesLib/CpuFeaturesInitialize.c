@@ -161,7 +161,6 @@ CpuInitDataInitialize (
     InitOrder = &CpuFeaturesData->InitOrder[ProcessorNumber];
     InitOrder->FeaturesSupportedMask = AllocateZeroPool (CpuFeaturesData->BitMaskSize);
     ASSERT (InitOrder->FeaturesSupportedMask != NULL);
-    InitializeListHead (&InitOrder->OrderList);
     Status = GetProcessorInformation (ProcessorNumber, &ProcessorInfoBuffer);
     ASSERT_EFI_ERROR (Status);
     CopyMem (
@@ -560,29 +559,79 @@ DumpRegisterTableOnProcessor (
 }
 
 /**
-  Get the biggest dependence type.
-  PackageDepType > CoreDepType > ThreadDepType > NoneDepType.
+  Calculate the semaphores to add after each CPU feature in the initialization order.
 
-  @param[in]  BeforeDep           Before dependence type.
-  @param[in]  AfterDep            After dependence type.
-  @param[in]  NoneNeibBeforeDep   Before dependence type for not neighborhood features.
-  @param[in]  NoneNeibAfterDep    After dependence type for not neighborhood features.
+  The initialization order is the same on all processors, so the dependences between
+  the features are only analyzed once. Two features I < J with a core or package type
+  dependence require a semaphore of that type after one of the features I .. J - 1.
+  The semaphore is added as late as possible, just before feature J, and only if no
+  semaphore of the same or bigger type has been added after feature I yet. So one
+  semaphore serves all the dependences it crosses, and the features without core or
+  package type dependences between them run without any synchronization.
+
+  @param[in]  Features      The CPU features in initialization order.
+  @param[in]  FeatureCount  The number of CPU features.
+  @param[out] SemaphoreDep  Return the semaphore type to add after each CPU feature.
+                            NoneDepType means no semaphore is needed.
 
-  @retval  Return the biggest dependence type.
 **/
-CPU_FEATURE_DEPENDENCE_TYPE
-BiggestDep (
-  IN CPU_FEATURE_DEPENDENCE_TYPE  BeforeDep,
-  IN CPU_FEATURE_DEPENDENCE_TYPE  AfterDep,
-  IN CPU_FEATURE_DEPENDENCE_TYPE  NoneNeibBeforeDep,
-  IN CPU_FEATURE_DEPENDENCE_TYPE  NoneNeibAfterDep
+VOID
+CalculateFeatureSemaphores (
+  IN  CPU_FEATURES_ENTRY           **Features,
+  IN  UINTN                        FeatureCount,
+  OUT CPU_FEATURE_DEPENDENCE_TYPE  *SemaphoreDep
   )
 {
-  CPU_FEATURE_DEPENDENCE_TYPE Bigger;
+  UINTN                        Index;
+  UINTN                        Former;
+  UINTN                        PackageStart;
+  UINTN                        CoreStart;
+  UINTN                        LastPackageSemaphore;
+  UINTN                        LastSemaphore;
+  CPU_FEATURE_DEPENDENCE_TYPE  BeforeDep;
+  CPU_FEATURE_DEPENDENCE_TYPE  AfterDep;
+
+  //
+  // The semaphore positions are counted from 1, position Index is between
+  // feature Index - 1 and feature Index. 0 means no semaphore.
+  //
+  LastPackageSemaphore = 0;
+  LastSemaphore        = 0;
+  for (Index = 0; Index < FeatureCount; Index++) {
+    SemaphoreDep[Index] = NoneDepType;
+    if (Index == 0) {
+      continue;
+    }
+
+    //
+    // Find the latest former feature which has core or package type dependence with
+    // current feature, in either direction.
+    //
+    PackageStart = 0;
+    CoreStart    = 0;
+    for (Former = 0; Former < Index; Former++) {
+      BeforeDep = DetectFeatureScope (Features[Former], TRUE, Features[Index]->FeatureMask);
+      AfterDep  = DetectFeatureScope (Features[Index], FALSE, Features[Former]->FeatureMask);
+      BeforeDep = MAX (BeforeDep, AfterDep);
+      if (BeforeDep == PackageDepType) {
+        PackageStart = Former + 1;
+      } else if (BeforeDep == CoreDepType) {
+        CoreStart    = Former + 1;
+      }
+    }
 
-  Bigger = MAX (BeforeDep, AfterDep);
-  Bigger = MAX (Bigger, NoneNeibBeforeDep);
-  return MAX(Bigger, NoneNeibAfterDep);
+    //
+    // A package semaphore also synchronizes all threads in the core.
+    //
+    if (LastPackageSemaphore < PackageStart) {
+      SemaphoreDep[Index - 1] = PackageDepType;
+      LastPackageSemaphore    = Index;
+      LastSemaphore           = Index;
+    } else if (LastSemaphore < CoreStart) {
+      SemaphoreDep[Index - 1] = CoreDepType;
+      LastSemaphore           = Index;
+    }
+  }
 }
 
 /**
@@ -599,18 +648,17 @@ AnalysisProcessorFeatures (
   EFI_STATUS                           Status;
   UINTN                                ProcessorNumber;
   CPU_FEATURES_ENTRY                   *CpuFeature;
-  CPU_FEATURES_ENTRY                   *CpuFeatureInOrder;
   CPU_FEATURES_INIT_ORDER              *CpuInitOrder;
   REGISTER_CPU_FEATURE_INFORMATION     *CpuInfo;
   LIST_ENTRY                           *Entry;
   CPU_FEATURES_DATA                    *CpuFeaturesData;
-  LIST_ENTRY                           *NextEntry;
-  CPU_FEATURES_ENTRY                   *NextCpuFeatureInOrder;
-  BOOLEAN                              Success;
-  CPU_FEATURE_DEPENDENCE_TYPE          BeforeDep;
-  CPU_FEATURE_DEPENDENCE_TYPE          AfterDep;
-  CPU_FEATURE_DEPENDENCE_TYPE          NoneNeibBeforeDep;
-  CPU_FEATURE_DEPENDENCE_TYPE          NoneNeibAfterDep;
+  CPU_FEATURES_ENTRY                   **Features;
+  CPU_FEATURE_DEPENDENCE_TYPE          *SemaphoreDep;
+  UINTN                                FeatureCount;
+  UINTN                                Index;
+  CPU_FEATURE_TIMING                   *FeatureTiming;
+  UINTN                                *FeatureEntry;
+  UINT64                               *FeatureTime;
 
   CpuFeaturesData = GetCpuFeaturesData ();
   CpuFeaturesData->CapabilityPcd = AllocatePool (CpuFeaturesData->BitMaskSize);
@@ -664,110 +712,136 @@ AnalysisProcessorFeatures (
   SetCapabilityPcd (CpuFeaturesData->CapabilityPcd, CpuFeaturesData->BitMaskSize);
   SetSettingPcd (CpuFeaturesData->SettingPcd, CpuFeaturesData->BitMaskSize);
 
-  for (ProcessorNumber = 0; ProcessorNumber < NumberOfCpus; ProcessorNumber++) {
-    CpuInitOrder = &CpuFeaturesData->InitOrder[ProcessorNumber];
-    Entry = GetFirstNode (&CpuFeaturesData->FeatureList);
-    while (!IsNull (&CpuFeaturesData->FeatureList, Entry)) {
-      //
-      // Insert each feature into processor's order list
-      //
-      CpuFeature = CPU_FEATURE_ENTRY_FROM_LINK (Entry);
-      if (IsBitMaskMatch (CpuFeature->FeatureMask, CpuFeaturesData->CapabilityPcd, CpuFeaturesData->BitMaskSize)) {
-        CpuFeatureInOrder = AllocateCopyPool (sizeof (CPU_FEATURES_ENTRY), CpuFeature);
-        ASSERT (CpuFeatureInOrder != NULL);
-        InsertTailList (&CpuInitOrder->OrderList, &CpuFeatureInOrder->Link);
+  //
+  // Collect the supported features in initialization order, it is the same order on
+  // all processors.
+  //
+  Features = AllocatePool (MAX (CpuFeaturesData->FeaturesCount, 1) * sizeof (CPU_FEATURES_ENTRY *));
+  ASSERT (Features != NULL);
+  FeatureCount = 0;
+  Entry = GetFirstNode (&CpuFeaturesData->FeatureList);
+  while (!IsNull (&CpuFeaturesData->FeatureList, Entry)) {
+    CpuFeature = CPU_FEATURE_ENTRY_FROM_LINK (Entry);
+    if (IsBitMaskMatch (CpuFeature->FeatureMask, CpuFeaturesData->CapabilityPcd, CpuFeaturesData->BitMaskSize)) {
+      ASSERT (FeatureCount < CpuFeaturesData->FeaturesCount);
+      Features[FeatureCount++] = CpuFeature;
+    }
+    Entry = Entry->ForwardLink;
+  }
+
+  SemaphoreDep = AllocatePool (MAX (FeatureCount, 1) * sizeof (CPU_FEATURE_DEPENDENCE_TYPE));
+  ASSERT (SemaphoreDep != NULL);
+  CalculateFeatureSemaphores (Features, FeatureCount, SemaphoreDep);
+
+  //
+  // Building the register tables below does not touch the hardware, so the features
+  // can only be timed when the processors program them. Remember where each feature
+  // starts in the register tables for SetProcessorRegister().
+  //
+  FeatureTiming = NULL;
+  if (PerformanceMeasurementEnabled ()) {
+    CpuFeaturesData->TimedFeatureName = AllocatePool (MAX (FeatureCount, 1) * sizeof (CHAR8 *));
+    FeatureTiming = AllocatePool (NumberOfCpus * sizeof (CPU_FEATURE_TIMING));
+    FeatureEntry  = AllocatePool (NumberOfCpus * (FeatureCount + 1) * sizeof (UINTN));
+    FeatureTime   = AllocateZeroPool (NumberOfCpus * (FeatureCount + 1) * sizeof (UINT64));
+    if (CpuFeaturesData->TimedFeatureName == NULL || FeatureTiming == NULL ||
+        FeatureEntry == NULL || FeatureTime == NULL) {
+      if (CpuFeaturesData->TimedFeatureName != NULL) {
+        FreePool (CpuFeaturesData->TimedFeatureName);
+        CpuFeaturesData->TimedFeatureName = NULL;
+      }
+      if (FeatureTiming != NULL) {
+        FreePool (FeatureTiming);
+        FeatureTiming = NULL;
+      }
+      if (FeatureEntry != NULL) {
+        FreePool (FeatureEntry);
+      }
+      if (FeatureTime != NULL) {
+        FreePool (FeatureTime);
+      }
+    } else {
+      for (Index = 0; Index < FeatureCount; Index++) {
+        CpuFeaturesData->TimedFeatureName[Index] = Features[Index]->FeatureName;
+      }
+      for (ProcessorNumber = 0; ProcessorNumber < NumberOfCpus; ProcessorNumber++) {
+        FeatureTiming[ProcessorNumber].Count = FeatureCount;
+        FeatureTiming[ProcessorNumber].Entry = &FeatureEntry[ProcessorNumber * (FeatureCount + 1)];
+        FeatureTiming[ProcessorNumber].Time  = &FeatureTime[ProcessorNumber * (FeatureCount + 1)];
       }
-      Entry = Entry->ForwardLink;
     }
-    //
-    // Go through ordered feature list to initialize CPU features
-    //
-    CpuInfo = &CpuFeaturesData->InitOrder[ProcessorNumber].CpuInfo;
-    Entry = GetFirstNode (&CpuInitOrder->OrderList);
-    while (!IsNull (&CpuInitOrder->OrderList, Entry)) {
-      CpuFeatureInOrder = CPU_FEATURE_ENTRY_FROM_LINK (Entry);
-
-      Success = FALSE;
-      if (IsBitMaskMatch (CpuFeatureInOrder->FeatureMask, CpuFeaturesData->SettingPcd, CpuFeaturesData->BitMaskSize)) {
-        Status = CpuFeatureInOrder->InitializeFunc (ProcessorNumber, CpuInfo, CpuFeatureInOrder->ConfigData, TRUE);
+  }
+
+  //
+  // Go through ordered feature list to initialize CPU features on all processors.
+  //
+  for (Index = 0; Index < FeatureCount; Index++) {
+    CpuFeature = Features[Index];
+
+    for (ProcessorNumber = 0; ProcessorNumber < NumberOfCpus; ProcessorNumber++) {
+      if (FeatureTiming != NULL) {
+        FeatureTiming[ProcessorNumber].Entry[Index] = CpuFeaturesData->RegisterTable[ProcessorNumber].TableLength;
+      }
+      CpuInfo = &CpuFeaturesData->InitOrder[ProcessorNumber].CpuInfo;
+      if (IsBitMaskMatch (CpuFeature->FeatureMask, CpuFeaturesData->SettingPcd, CpuFeaturesData->BitMaskSize)) {
+        Status = CpuFeature->InitializeFunc (ProcessorNumber, CpuInfo, CpuFeature->ConfigData, TRUE);
         if (EFI_ERROR (Status)) {
           //
-          // Clean the CpuFeatureInOrder->FeatureMask in setting PCD.
+          // Clean the CpuFeature->FeatureMask in setting PCD.
           //
-          SupportedMaskCleanBit (CpuFeaturesData->SettingPcd, CpuFeatureInOrder->FeatureMask, CpuFeaturesData->BitMaskSize);
-          if (CpuFeatureInOrder->FeatureName != NULL) {
-            DEBUG ((DEBUG_WARN, "Warning :: Failed to enable Feature: Name = %a.\n", CpuFeatureInOrder->FeatureName));
+          SupportedMaskCleanBit (CpuFeaturesData->SettingPcd, CpuFeature->FeatureMask, CpuFeaturesData->BitMaskSize);
+          if (CpuFeature->FeatureName != NULL) {
+            DEBUG ((DEBUG_WARN, "Warning :: Failed to enable Feature: Name = %a.\n", CpuFeature->FeatureName));
           } else {
             DEBUG ((DEBUG_WARN, "Warning :: Failed to enable Feature: Mask = "));
-            DumpCpuFeatureMask (CpuFeatureInOrder->FeatureMask, CpuFeaturesData->BitMaskSize);
+            DumpCpuFeatureMask (CpuFeature->FeatureMask, CpuFeaturesData->BitMaskSize);
           }
-        } else {
-          Success = TRUE;
         }
       } else {
-        Status = CpuFeatureInOrder->InitializeFunc (ProcessorNumber, CpuInfo, CpuFeatureInOrder->ConfigData, FALSE);
+        Status = CpuFeature->InitializeFunc (ProcessorNumber, CpuInfo, CpuFeature->ConfigData, FALSE);
         if (EFI_ERROR (Status)) {
-          if (CpuFeatureInOrder->FeatureName != NULL) {
-            DEBUG ((DEBUG_WARN, "Warning :: Failed to disable Feature: Name = %a.\n", CpuFeatureInOrder->FeatureName));
+          if (CpuFeature->FeatureName != NULL) {
+            DEBUG ((DEBUG_WARN, "Warning :: Failed to disable Feature: Name = %a.\n", CpuFeature->FeatureName));
           } else {
             DEBUG ((DEBUG_WARN, "Warning :: Failed to disable Feature: Mask = "));
-            DumpCpuFeatureMask (CpuFeatureInOrder->FeatureMask, CpuFeaturesData->BitMaskSize);
+            DumpCpuFeatureMask (CpuFeature->FeatureMask, CpuFeaturesData->BitMaskSize);
           }
-        } else {
-          Success = TRUE;
         }
       }
 
-      if (Success) {
-        NextEntry = Entry->ForwardLink;
-        if (!IsNull (&CpuInitOrder->OrderList, NextEntry)) {
-          NextCpuFeatureInOrder = CPU_FEATURE_ENTRY_FROM_LINK (NextEntry);
-
-          //
-          // If feature has dependence with the next feature (ONLY care core/package dependency).
-          // and feature initialize succeed, add sync semaphere here.
-          //
-          BeforeDep = DetectFeatureScope (CpuFeatureInOrder, TRUE, NextCpuFeatureInOrder->FeatureMask);
-          AfterDep  = DetectFeatureScope (NextCpuFeatureInOrder, FALSE, CpuFeatureInOrder->FeatureMask);
-          //
-          // Check whether next feature has After type dependence with not neighborhood CPU
-          // Features in former CPU features.
-          //
-          NoneNeibAfterDep = DetectNoneNeighborhoodFeatureScope(NextCpuFeatureInOrder, FALSE, &CpuInitOrder->OrderList);
-        } else {
-          BeforeDep        = NoneDepType;
-          AfterDep         = NoneDepType;
-          NoneNeibAfterDep = NoneDepType;
-        }
-        //
-        // Check whether current feature has Before type dependence with none neighborhood
-        // CPU features in after Cpu features.
-        //
-        NoneNeibBeforeDep = DetectNoneNeighborhoodFeatureScope(CpuFeatureInOrder, TRUE, &CpuInitOrder->OrderList);
-
-        //
-        // Get the biggest dependence and add semaphore for it.
-        // PackageDepType > CoreDepType > ThreadDepType > NoneDepType.
-        //
-        BeforeDep = BiggestDep(BeforeDep, AfterDep, NoneNeibBeforeDep, NoneNeibAfterDep);
-        if (BeforeDep > ThreadDepType) {
-          CPU_REGISTER_TABLE_WRITE32 (ProcessorNumber, Semaphore, 0, BeforeDep);
-        }
+      //
+      // If the feature has core or package dependence with the following features, add
+      // sync semaphore here. The semaphore is added on all processors even if the feature
+      // fails on some of them, so all threads in one core or package wait for the same
+      // semaphores.
+      //
+      if (SemaphoreDep[Index] > ThreadDepType) {
+        CPU_REGISTER_TABLE_WRITE32 (ProcessorNumber, Semaphore, 0, SemaphoreDep[Index]);
       }
+    }
+  }
 
-      Entry = Entry->ForwardLink;
+  if (FeatureTiming != NULL) {
+    for (ProcessorNumber = 0; ProcessorNumber < NumberOfCpus; ProcessorNumber++) {
+      FeatureTiming[ProcessorNumber].Entry[FeatureCount] = CpuFeaturesData->RegisterTable[ProcessorNumber].TableLength;
     }
+    CpuFeaturesData->FeatureTiming = FeatureTiming;
+  }
 
-    //
-    // Dump PcdCpuFeaturesSetting again because this value maybe updated
-    // again during initialize the features.
-    //
-    DEBUG ((DEBUG_INFO, "Dump final value for PcdCpuFeaturesSetting:\n"));
-    DumpCpuFeatureMask (CpuFeaturesData->SettingPcd, CpuFeaturesData->BitMaskSize);
+  FreePool (SemaphoreDep);
+  FreePool (Features);
 
-    //
-    // Dump the RegisterTable
-    //
+  //
+  // Dump PcdCpuFeaturesSetting again because this value maybe updated
+  // again during initialize the features.
+  //
+  DEBUG ((DEBUG_INFO, "Dump final value for PcdCpuFeaturesSetting:\n"));
+  DumpCpuFeatureMask (CpuFeaturesData->SettingPcd, CpuFeaturesData->BitMaskSize);
+
+  //
+  // Dump the RegisterTable
+  //
+  for (ProcessorNumber = 0; ProcessorNumber < NumberOfCpus; ProcessorNumber++) {
     DumpRegisterTableOnProcessor (ProcessorNumber);
   }
 }
@@ -872,6 +946,8 @@ ReadWriteCr (
   @param[in]  ApLocation            AP location info for this ap.
   @param[in]  CpuStatus             CPU status info for this CPU.
   @param[in]  CpuFlags              Flags data structure used when program the register.
+  @param[in,out] FeatureTiming      Optional feature boundaries in the register table,
+                                    the time each one is reached is recorded.
 
   @note This service could be called by BSP/APs.
 **/
@@ -880,7 +956,8 @@ ProgramProcessorRegister (
   IN CPU_REGISTER_TABLE           *RegisterTable,
   IN EFI_CPU_PHYSICAL_LOCATION    *ApLocation,
   IN CPU_STATUS_INFORMATION       *CpuStatus,
-  IN PROGRAM_CPU_REGISTER_FLAGS   *CpuFlags
+  IN PROGRAM_CPU_REGISTER_FLAGS   *CpuFlags,
+  IN OUT CPU_FEATURE_TIMING       *FeatureTiming OPTIONAL
   )
 {
   CPU_REGISTER_TABLE_ENTRY  *RegisterTableEntry;
@@ -896,14 +973,22 @@ ProgramProcessorRegister (
   UINT8                     *ThreadCountPerCore;
   EFI_STATUS                Status;
   UINT64                    CurrentValue;
+  UINTN                     TimedFeature;
 
   //
   // Traverse Register Table of this logical processor
   //
   RegisterTableEntryHead = (CPU_REGISTER_TABLE_ENTRY *) (UINTN) RegisterTable->RegisterTableEntry;
+  TimedFeature = 0;
 
   for (Index = 0; Index < RegisterTable->TableLength; Index++) {
 
+    if (FeatureTiming != NULL) {
+      while (TimedFeature <= FeatureTiming->Count && FeatureTiming->Entry[TimedFeature] == Index) {
+        FeatureTiming->Time[TimedFeature++] = GetPerformanceCounter ();
+      }
+    }
+
     RegisterTableEntry = &RegisterTableEntryHead[Index];
 
     //
@@ -1106,6 +1191,12 @@ ProgramProcessorRegister (
       break;
     }
   }
+
+  if (FeatureTiming != NULL) {
+    while (TimedFeature <= FeatureTiming->Count) {
+      FeatureTiming->Time[TimedFeature++] = GetPerformanceCounter ();
+    }
+  }
 }
 
 /**
@@ -1149,10 +1240,64 @@ SetProcessorRegister (
     RegisterTable,
     (EFI_CPU_PHYSICAL_LOCATION *)(UINTN)AcpiCpuData->ApLocation + ProcIndex,
     &AcpiCpuData->CpuStatus,
-    &CpuFeaturesData->CpuFlags
+    &CpuFeaturesData->CpuFlags,
+    (CpuFeaturesData->FeatureTiming != NULL) ? &CpuFeaturesData->FeatureTiming[ProcIndex] : NULL
     );
 }
 
+/**
+  Logs the time spent programming each named CPU feature on all processors,
+  and frees the timing data collected by SetProcessorRegister().
+
+  A feature starts when the first processor starts programming it and ends when
+  the last processor finishes it.
+
+  @param[in]  CpuFeaturesData  Cpu Feature Data structure.
+
+  @note This service could be called by BSP only.
+**/
+VOID
+LogCpuFeaturesProgramTime (
+  IN CPU_FEATURES_DATA   *CpuFeaturesData
+  )
+{
+  CPU_FEATURE_TIMING        *FeatureTiming;
+  UINTN                     FeatureCount;
+  UINTN                     Index;
+  UINTN                     ProcessorNumber;
+  UINT64                    StartTime;
+  UINT64                    EndTime;
+
+  FeatureTiming = CpuFeaturesData->FeatureTiming;
+  if (FeatureTiming == NULL) {
+    return;
+  }
+
+  FeatureCount = FeatureTiming[0].Count;
+  for (Index = 0; Index < FeatureCount; Index++) {
+    if (CpuFeaturesData->TimedFeatureName[Index] == NULL) {
+      continue;
+    }
+
+    StartTime = MAX_UINT64;
+    EndTime   = 0;
+    for (ProcessorNumber = 0; ProcessorNumber < CpuFeaturesData->NumberOfCpus; ProcessorNumber++) {
+      StartTime = MIN (StartTime, FeatureTiming[ProcessorNumber].Time[Index]);
+      EndTime   = MAX (EndTime, FeatureTiming[ProcessorNumber].Time[Index + 1]);
+    }
+
+    PERF_START (&gEfiCallerIdGuid, CpuFeaturesData->TimedFeatureName[Index], NULL, StartTime);
+    PERF_END (&gEfiCallerIdGuid, CpuFeaturesData->TimedFeatureName[Index], NULL, EndTime);
+  }
+
+  FreePool (FeatureTiming[0].Entry);
+  FreePool (FeatureTiming[0].Time);
+  FreePool (FeatureTiming);
+  FreePool (CpuFeaturesData->TimedFeatureName);
+  CpuFeaturesData->FeatureTiming    = NULL;
+  CpuFeaturesData->TimedFeatureName = NULL;
+}
+
 /**
   Performs CPU features detection.
 
@@ -1173,6 +1318,7 @@ CpuFeaturesDetect (
 
   CpuInitDataInitialize ();
 
+  PERF_INMODULE_BEGIN ("CpuFeaturesCollect");
   if (CpuFeaturesData->NumberOfCpus > 1) {
     //
     // Wakeup all APs for data collection.
@@ -1184,7 +1330,10 @@ CpuFeaturesDetect (
   // Collect data on BSP
   //
   CollectProcessorData (CpuFeaturesData);
+  PERF_INMODULE_END ("CpuFeaturesCollect");
 
+  PERF_INMODULE_BEGIN ("CpuFeaturesAnalysis");
   AnalysisProcessorFeatures (CpuFeaturesData->NumberOfCpus);
+  PERF_INMODULE_END ("CpuFeaturesAnalysis");
 }
 
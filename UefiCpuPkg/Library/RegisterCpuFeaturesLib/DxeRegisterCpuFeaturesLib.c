@@ -235,6 +235,7 @@ CpuFeaturesInitialize (
   //
   MpEvent = NULL;
 
+  PERF_INMODULE_BEGIN ("CpuFeaturesProgram");
   if (CpuFeaturesData->NumberOfCpus > 1) {
     Status = gBS->CreateEvent (
                     EVT_NOTIFY_WAIT,
@@ -265,6 +266,8 @@ CpuFeaturesInitialize (
     } while (Status == EFI_NOT_READY);
     ASSERT_EFI_ERROR (Status);
   }
+  PERF_INMODULE_END ("CpuFeaturesProgram");
+  LogCpuFeaturesProgramTime (CpuFeaturesData);
 
   //
   // Switch to new BSP if required
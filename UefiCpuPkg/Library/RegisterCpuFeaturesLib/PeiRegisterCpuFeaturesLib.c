@@ -297,7 +297,10 @@ CpuFeaturesInitialize (
   //
   // Start to program register for all CPUs.
   //
+  PERF_INMODULE_BEGIN ("CpuFeaturesProgram");
   StartupAllCPUsWorker (SetProcessorRegister);
+  PERF_INMODULE_END ("CpuFeaturesProgram");
+  LogCpuFeaturesProgramTime (CpuFeaturesData);
 
   //
   // Switch to new BSP if required
@@ -22,6 +22,8 @@
 #include <Library/SynchronizationLib.h>
 #include <Library/IoLib.h>
 #include <Library/LocalApicLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/TimerLib.h>
 
 #include <AcpiCpuData.h>
 
@@ -32,7 +34,6 @@
 typedef struct {
   REGISTER_CPU_FEATURE_INFORMATION     CpuInfo;
   UINT8                                *FeaturesSupportedMask;
-  LIST_ENTRY                           OrderList;
 } CPU_FEATURES_INIT_ORDER;
 
 typedef struct {
@@ -63,6 +64,18 @@ typedef struct {
   volatile UINT32          *PackageSemaphoreCount;  // Semaphore containers used to program Package semaphore.
 } PROGRAM_CPU_REGISTER_FLAGS;
 
+//
+// Timing of the features programmed from the register table of one processor.
+// Entry[Index] is the register table index where feature Index starts and
+// Entry[Count] is the table length after the last feature. Time[Index] is the
+// performance counter when the processor got to Entry[Index].
+//
+typedef struct {
+  UINTN                    Count;
+  UINTN                    *Entry;
+  UINT64                   *Time;
+} CPU_FEATURE_TIMING;
+
 typedef union {
   EFI_MP_SERVICES_PROTOCOL   *Protocol;
   EDKII_PEI_MP_SERVICES2_PPI *Ppi;
@@ -87,6 +100,12 @@ typedef struct {
   PROGRAM_CPU_REGISTER_FLAGS  CpuFlags;
 
   MP_SERVICES              MpService;
+
+  //
+  // Only allocated when performance measurement is enabled.
+  //
+  CHAR8                    **TimedFeatureName;
+  CPU_FEATURE_TIMING       *FeatureTiming;
 } CPU_FEATURES_DATA;
 
 #define CPU_FEATURE_ENTRY_FROM_LINK(a) \
@@ -218,31 +237,28 @@ DetectFeatureScope (
   );
 
 /**
-  Return feature dependence result.
+  Programs registers for the calling processor.
 
-  @param[in]  CpuFeature            Pointer to CPU feature.
-  @param[in]  Before                Check before dependence or after.
-  @param[in]  FeatureList           Pointer to CPU feature list.
+  @param[in,out] Buffer  The pointer to private data buffer.
 
-  @retval     return the dependence result.
 **/
-CPU_FEATURE_DEPENDENCE_TYPE
-DetectNoneNeighborhoodFeatureScope (
-  IN CPU_FEATURES_ENTRY         *CpuFeature,
-  IN BOOLEAN                    Before,
-  IN LIST_ENTRY                 *FeatureList
+VOID
+EFIAPI
+SetProcessorRegister (
+  IN OUT VOID            *Buffer
   );
 
 /**
-  Programs registers for the calling processor.
+  Logs the time spent programming each named CPU feature on all processors,
+  and frees the timing data collected by SetProcessorRegister().
 
-  @param[in,out] Buffer  The pointer to private data buffer.
+  @param[in]  CpuFeaturesData  Cpu Feature Data structure.
 
+  @note This service could be called by BSP only.
 **/
 VOID
-EFIAPI
-SetProcessorRegister (
-  IN OUT VOID            *Buffer
+LogCpuFeaturesProgramTime (
+  IN CPU_FEATURES_DATA   *CpuFeaturesData
   );
 
 /**
@@ -19,99 +19,13 @@ SMM_DISPATCHER_MP_SYNC_DATA                 *mSmmMpSyncData = NULL;
 UINTN                                       mSmmMpSyncDataSize;
 SMM_CPU_SEMAPHORES                          mSmmCpuSemaphores;
 UINTN                                       mSemaphoreSize;
+SMM_CPU_BARRIER                             mSmmCpuBarrier;
 SPIN_LOCK                                   *mPFLock = NULL;
 SMM_CPU_SYNC_MODE                           mCpuSmmSyncMode;
 BOOLEAN                                     mMachineCheckSupported = FALSE;
 
 extern UINTN mSmmShadowStackSize;
 
-/**
-  Performs an atomic compare exchange operation to get semaphore.
-  The compare exchange operation must be performed using
-  MP safe mechanisms.
-
-  @param      Sem        IN:  32-bit unsigned integer
-                         OUT: original integer - 1
-  @return     Original integer - 1
-
-**/
-UINT32
-WaitForSemaphore (
-  IN OUT  volatile UINT32           *Sem
-  )
-{
-  UINT32                            Value;
-
-  for (;;) {
-    Value = *Sem;
-    if (Value != 0 &&
-        InterlockedCompareExchange32 (
-          (UINT32*)Sem,
-          Value,
-          Value - 1
-          ) == Value) {
-      break;
-    }
-    CpuPause ();
-  }
-  return Value - 1;
-}
-
-
-/**
-  Performs an atomic compare exchange operation to release semaphore.
-  The compare exchange operation must be performed using
-  MP safe mechanisms.
-
-  @param      Sem        IN:  32-bit unsigned integer
-                         OUT: original integer + 1
-  @return     Original integer + 1
-
-**/
-UINT32
-ReleaseSemaphore (
-  IN OUT  volatile UINT32           *Sem
-  )
-{
-  UINT32                            Value;
-
-  do {
-    Value = *Sem;
-  } while (Value + 1 != 0 &&
-           InterlockedCompareExchange32 (
-             (UINT32*)Sem,
-             Value,
-             Value + 1
-             ) != Value);
-  return Value + 1;
-}
-
-/**
-  Performs an atomic compare exchange operation to lock semaphore.
-  The compare exchange operation must be performed using
-  MP safe mechanisms.
-
-  @param      Sem        IN:  32-bit unsigned integer
-                         OUT: -1
-  @return     Original integer
-
-**/
-UINT32
-LockdownSemaphore (
-  IN OUT  volatile UINT32           *Sem
-  )
-{
-  UINT32                            Value;
-
-  do {
-    Value = *Sem;
-  } while (InterlockedCompareExchange32 (
-             (UINT32*)Sem,
-             Value, (UINT32)-1
-             ) != Value);
-  return Value;
-}
-
 /**
   Wait all APs to performs an atomic compare exchange operation to release semaphore.
 
@@ -123,12 +37,7 @@ WaitForAllAPs (
   IN      UINTN                     NumberOfAPs
   )
 {
-  UINTN                             BspIndex;
-
-  BspIndex = mSmmMpSyncData->BspIndex;
-  while (NumberOfAPs-- > 0) {
-    WaitForSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
-  }
+  SmmCpuBarrierWaitForArrivals (&mSmmCpuBarrier, NumberOfAPs);
 }
 
 /**
@@ -141,13 +50,10 @@ ReleaseAllAPs (
   VOID
   )
 {
-  UINTN                             Index;
-
-  for (Index = 0; Index < mMaxNumberOfCpus; Index++) {
-    if (IsPresentAp (Index)) {
-      ReleaseSemaphore (mSmmMpSyncData->CpuData[Index].Run);
-    }
-  }
+  SmmCpuBarrierReleaseAll (
+    &mSmmCpuBarrier,
+    gSmmCpuPrivate->SmmCoreEntryContext.CurrentlyExecutingCpu
+    );
 }
 
 /**
@@ -463,9 +369,13 @@ BSPHandler (
   UINTN                             ApCount;
   BOOLEAN                           ClearTopLevelSmiResult;
   UINTN                             PresentCount;
+  UINT64                            SmiTimer;
+  UINT64                            RendezvousTicks;
 
   ASSERT (CpuIndex == mSmmMpSyncData->BspIndex);
   ApCount = 0;
+  SmiTimer = StartSyncTimer ();
+  RendezvousTicks = 0;
 
   //
   // Flag BSP's presence
@@ -515,6 +425,7 @@ BSPHandler (
     // Wait for all APs to get ready for programming MTRRs
     //
     WaitForAllAPs (ApCount);
+    RendezvousTicks = GetSyncTimerElapsed (SmiTimer);
 
     if (SmmCpuFeaturesNeedConfigureMtrrs()) {
       //
@@ -607,6 +518,7 @@ BSPHandler (
         break;
       }
     }
+    RendezvousTicks = GetSyncTimerElapsed (SmiTimer);
   }
 
   //
@@ -665,6 +577,10 @@ BSPHandler (
   //
   WaitForAllAPs (ApCount);
 
+  if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+    SmmProfileRecordSmiLatency (RendezvousTicks, GetSyncTimerElapsed (SmiTimer));
+  }
+
   //
   // Reset the tokens buffer.
   //
@@ -771,14 +687,14 @@ APHandler (
     //
     // Notify BSP of arrival at this point
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SmmCpuBarrierArrive (&mSmmCpuBarrier, CpuIndex);
   }
 
   if (SmmCpuFeaturesNeedConfigureMtrrs()) {
     //
     // Wait for the signal from BSP to backup MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    SmmCpuBarrierWaitForRelease (&mSmmCpuBarrier, CpuIndex);
 
     //
     // Backup OS MTRRs
@@ -788,12 +704,12 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SmmCpuBarrierArrive (&mSmmCpuBarrier, CpuIndex);
 
     //
     // Wait for BSP's signal to program MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    SmmCpuBarrierWaitForRelease (&mSmmCpuBarrier, CpuIndex);
 
     //
     // Replace OS MTRRs with SMI MTRRs
@@ -803,14 +719,14 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SmmCpuBarrierArrive (&mSmmCpuBarrier, CpuIndex);
   }
 
   while (TRUE) {
     //
     // Wait for something to happen
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    SmmCpuBarrierWaitForRelease (&mSmmCpuBarrier, CpuIndex);
 
     //
     // Check if BSP wants to exit SMM
@@ -850,12 +766,12 @@ APHandler (
     //
     // Notify BSP the readiness of this AP to program MTRRs
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SmmCpuBarrierArrive (&mSmmCpuBarrier, CpuIndex);
 
     //
     // Wait for the signal from BSP to program MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    SmmCpuBarrierWaitForRelease (&mSmmCpuBarrier, CpuIndex);
 
     //
     // Restore OS MTRRs
@@ -867,12 +783,12 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to Reset states/semaphore for this processor
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  SmmCpuBarrierArrive (&mSmmCpuBarrier, CpuIndex);
 
   //
   // Wait for the signal from BSP to Reset states/semaphore for this processor
   //
-  WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+  SmmCpuBarrierWaitForRelease (&mSmmCpuBarrier, CpuIndex);
 
   //
   // Reset states/semaphore for this processor
@@ -882,7 +798,7 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to exit SMM
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  SmmCpuBarrierArrive (&mSmmCpuBarrier, CpuIndex);
 
 }
 
@@ -1766,6 +1682,9 @@ InitializeSmmCpuSemaphores (
   UINTN                      Pages;
   UINTN                      *SemaphoreBlock;
   UINTN                      SemaphoreAddr;
+  UINT32                     *Package;
+  UINTN                      CpuIndex;
+  RETURN_STATUS              Status;
 
   SemaphoreSize   = GetSpinLockProperties ();
   ProcessorCount = gSmmCpuPrivate->SmmCoreEntryContext.NumberOfCpus;
@@ -1803,6 +1722,25 @@ InitializeSmmCpuSemaphores (
   mConfigSmmCodeAccessCheckLock = mSmmCpuSemaphores.SemaphoreGlobal.CodeAccessCheckLock;
 
   mSemaphoreSize = SemaphoreSize;
+
+  //
+  // Group the rendezvous of the CPUs per package.
+  //
+  Package = AllocatePool (sizeof (UINT32) * ProcessorCount);
+  ASSERT (Package != NULL);
+  for (CpuIndex = 0; CpuIndex < ProcessorCount; CpuIndex++) {
+    Package[CpuIndex] = gSmmCpuPrivate->ProcessorInfo[CpuIndex].Location.Package;
+  }
+  Status = SmmCpuBarrierInitialize (
+             &mSmmCpuBarrier,
+             ProcessorCount,
+             Package,
+             mSmmCpuSemaphores.SemaphoreCpu.Run,
+             mSmmCpuSemaphores.SemaphoreCpu.Present,
+             SemaphoreSize
+             );
+  ASSERT_RETURN_ERROR (Status);
+  FreePool (Package);
 }
 
 /**
@@ -1853,6 +1791,7 @@ InitializeMpSyncData (
       *(mSmmMpSyncData->CpuData[CpuIndex].Run)     = 0;
       *(mSmmMpSyncData->CpuData[CpuIndex].Present) = FALSE;
     }
+    SmmCpuBarrierReset (&mSmmCpuBarrier);
   }
 }
 
@@ -58,6 +58,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "CpuService.h"
 #include "SmmProfile.h"
+#include "SmmCpuBarrier.h"
 
 //
 // CET definition
@@ -476,6 +477,7 @@ extern UINTN                               mSmmStackSize;
 extern EFI_SMM_CPU_SERVICE_PROTOCOL        mSmmCpuService;
 extern IA32_DESCRIPTOR                     gcSmiInitGdtr;
 extern SMM_CPU_SEMAPHORES                  mSmmCpuSemaphores;
+extern SMM_CPU_BARRIER                     mSmmCpuBarrier;
 extern UINTN                               mSemaphoreSize;
 extern SPIN_LOCK                           *mPFLock;
 extern SPIN_LOCK                           *mConfigSmmCodeAccessCheckLock;
@@ -535,6 +537,20 @@ StartSyncTimer (
   VOID
   );
 
+/**
+  Get the number of ticks elapsed since a SMM AP Sync timer started.
+
+  @param Timer  The start timer from the begin.
+
+  @return The number of ticks elapsed.
+
+**/
+UINT64
+EFIAPI
+GetSyncTimerElapsed (
+  IN      UINT64                    Timer
+  );
+
 /**
   Check if the SMM AP Sync timer is timeout.
 
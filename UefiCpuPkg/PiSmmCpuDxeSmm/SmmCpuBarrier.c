@@ -0,0 +1,452 @@
+/** @file
+  Semaphores and hierarchical barrier of the SMI rendezvous.
+
+  Copyright (c) 2009 - 2020, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "SmmCpuBarrier.h"
+
+/**
+  Performs an atomic compare exchange operation to get semaphore.
+  The compare exchange operation must be performed using
+  MP safe mechanisms.
+
+  @param      Sem        IN:  32-bit unsigned integer
+                         OUT: original integer - 1
+  @return     Original integer - 1
+
+**/
+UINT32
+WaitForSemaphore (
+  IN OUT  volatile UINT32           *Sem
+  )
+{
+  UINT32                            Value;
+
+  for (;;) {
+    Value = *Sem;
+    if (Value != 0 &&
+        InterlockedCompareExchange32 (
+          (UINT32*)Sem,
+          Value,
+          Value - 1
+          ) == Value) {
+      break;
+    }
+    CpuPause ();
+  }
+  return Value - 1;
+}
+
+
+/**
+  Performs an atomic compare exchange operation to release semaphore.
+  The compare exchange operation must be performed using
+  MP safe mechanisms.
+
+  @param      Sem        IN:  32-bit unsigned integer
+                         OUT: original integer + 1
+  @return     Original integer + 1
+
+**/
+UINT32
+ReleaseSemaphore (
+  IN OUT  volatile UINT32           *Sem
+  )
+{
+  UINT32                            Value;
+
+  do {
+    Value = *Sem;
+  } while (Value + 1 != 0 &&
+           InterlockedCompareExchange32 (
+             (UINT32*)Sem,
+             Value,
+             Value + 1
+             ) != Value);
+  return Value + 1;
+}
+
+/**
+  Performs an atomic compare exchange operation to lock semaphore.
+  The compare exchange operation must be performed using
+  MP safe mechanisms.
+
+  @param      Sem        IN:  32-bit unsigned integer
+                         OUT: -1
+  @return     Original integer
+
+**/
+UINT32
+LockdownSemaphore (
+  IN OUT  volatile UINT32           *Sem
+  )
+{
+  UINT32                            Value;
+
+  do {
+    Value = *Sem;
+  } while (InterlockedCompareExchange32 (
+             (UINT32*)Sem,
+             Value, (UINT32)-1
+             ) != Value);
+  return Value;
+}
+
+/**
+  Get the Run semaphore of a CPU.
+
+  @param[in]  Barrier   The barrier.
+  @param[in]  CpuIndex  The index of the CPU.
+
+  @return The Run semaphore of the CPU.
+
+**/
+STATIC
+volatile UINT32 *
+GetRun (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  CpuIndex
+  )
+{
+  return (volatile UINT32 *)(Barrier->Run + Barrier->SemaphoreSize * CpuIndex);
+}
+
+/**
+  Check whether a CPU is in SMM.
+
+  @param[in]  Barrier   The barrier.
+  @param[in]  CpuIndex  The index of the CPU.
+
+  @retval TRUE    The CPU is in SMM.
+  @retval FALSE   The CPU is not in SMM.
+
+**/
+STATIC
+BOOLEAN
+IsPresent (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  CpuIndex
+  )
+{
+  return *(volatile BOOLEAN *)(Barrier->Present + Barrier->SemaphoreSize * CpuIndex);
+}
+
+/**
+  Initialize the barrier of the SMI rendezvous.
+
+  @param[out] Barrier         The barrier.
+  @param[in]  CpuCount        The number of CPUs.
+  @param[in]  Package         The package of every CPU.
+  @param[in]  Run             The Run semaphore of the first CPU.
+  @param[in]  Present         The Present flag of the first CPU.
+  @param[in]  SemaphoreSize   The distance between the semaphores of two CPUs,
+                              the size of a cache line or more.
+
+  @retval RETURN_SUCCESS            The barrier is initialized.
+  @retval RETURN_OUT_OF_RESOURCES   The barrier could not be allocated.
+
+**/
+RETURN_STATUS
+SmmCpuBarrierInitialize (
+  OUT SMM_CPU_BARRIER       *Barrier,
+  IN  UINTN                 CpuCount,
+  IN  CONST UINT32          *Package,
+  IN  volatile UINT32       *Run,
+  IN  volatile BOOLEAN      *Present,
+  IN  UINTN                 SemaphoreSize
+  )
+{
+  UINT32                    *GroupPackage;
+  UINTN                     CpuIndex;
+  UINTN                     GroupIndex;
+  UINTN                     MemberIndex;
+  UINTN                     MaskSize;
+  UINTN                     BlockSize;
+  UINTN                     BlockAddr;
+  SMM_CPU_BARRIER_GROUP     *Group;
+
+  ASSERT (CpuCount > 0);
+  ASSERT (SemaphoreSize >= sizeof (UINT64));
+
+  ZeroMem (Barrier, sizeof (*Barrier));
+  Barrier->CpuCount      = CpuCount;
+  Barrier->Run           = (UINTN)Run;
+  Barrier->Present       = (UINTN)Present;
+  Barrier->SemaphoreSize = SemaphoreSize;
+
+  Barrier->Groups   = AllocateZeroPool (sizeof (SMM_CPU_BARRIER_GROUP) * CpuCount);
+  Barrier->CpuGroup = AllocatePool (sizeof (UINT32) * CpuCount);
+  Barrier->Members  = AllocatePool (sizeof (UINT32) * CpuCount);
+  GroupPackage      = AllocatePool (sizeof (UINT32) * CpuCount);
+  if (Barrier->Groups == NULL || Barrier->CpuGroup == NULL ||
+      Barrier->Members == NULL || GroupPackage == NULL) {
+    goto OutOfResources;
+  }
+
+  //
+  // Make a group of the CPUs of every package.
+  //
+  for (CpuIndex = 0; CpuIndex < CpuCount; CpuIndex++) {
+    for (GroupIndex = 0; GroupIndex < Barrier->GroupCount; GroupIndex++) {
+      if (GroupPackage[GroupIndex] == Package[CpuIndex]) {
+        break;
+      }
+    }
+    if (GroupIndex == Barrier->GroupCount) {
+      GroupPackage[GroupIndex] = Package[CpuIndex];
+      Barrier->GroupCount++;
+    }
+    Barrier->CpuGroup[CpuIndex] = (UINT32)GroupIndex;
+    Barrier->Groups[GroupIndex].MemberCount++;
+  }
+  FreePool (GroupPackage);
+  GroupPackage = NULL;
+
+  MemberIndex = 0;
+  for (GroupIndex = 0; GroupIndex < Barrier->GroupCount; GroupIndex++) {
+    Group              = &Barrier->Groups[GroupIndex];
+    Group->Members     = &Barrier->Members[MemberIndex];
+    MemberIndex       += Group->MemberCount;
+    Group->MemberCount = 0;
+  }
+  for (CpuIndex = 0; CpuIndex < CpuCount; CpuIndex++) {
+    Group = &Barrier->Groups[Barrier->CpuGroup[CpuIndex]];
+    Group->Members[Group->MemberCount++] = (UINT32)CpuIndex;
+  }
+
+  //
+  // Give the arrival counter, the leader and the release bitmap of every
+  // group their own cache lines, so that the CPUs of different packages do
+  // not contend on them.
+  //
+  BlockSize = 0;
+  for (GroupIndex = 0; GroupIndex < Barrier->GroupCount; GroupIndex++) {
+    MaskSize   = ALIGN_VALUE (Barrier->Groups[GroupIndex].MemberCount, 64) / 8;
+    BlockSize += SemaphoreSize * 2 + ALIGN_VALUE (MaskSize, SemaphoreSize);
+  }
+  BlockAddr = (UINTN)AllocatePages (EFI_SIZE_TO_PAGES (BlockSize));
+  if (BlockAddr == 0) {
+    goto OutOfResources;
+  }
+  ZeroMem ((VOID *)BlockAddr, BlockSize);
+
+  for (GroupIndex = 0; GroupIndex < Barrier->GroupCount; GroupIndex++) {
+    Group              = &Barrier->Groups[GroupIndex];
+    MaskSize           = ALIGN_VALUE (Group->MemberCount, 64) / 8;
+    Group->Arrived     = (volatile UINT32 *)BlockAddr;
+    Group->Leader      = (volatile UINT32 *)(BlockAddr + SemaphoreSize);
+    Group->ReleaseMask = (volatile UINT64 *)(BlockAddr + SemaphoreSize * 2);
+    *Group->Leader     = SMM_CPU_BARRIER_NO_LEADER;
+    BlockAddr         += SemaphoreSize * 2 + ALIGN_VALUE (MaskSize, SemaphoreSize);
+  }
+
+  DEBUG ((DEBUG_INFO, "SmmCpuBarrier: %d CPUs in %d groups\n", CpuCount, Barrier->GroupCount));
+  return RETURN_SUCCESS;
+
+OutOfResources:
+  if (Barrier->Groups != NULL) {
+    FreePool (Barrier->Groups);
+  }
+  if (Barrier->CpuGroup != NULL) {
+    FreePool (Barrier->CpuGroup);
+  }
+  if (Barrier->Members != NULL) {
+    FreePool (Barrier->Members);
+  }
+  if (GroupPackage != NULL) {
+    FreePool (GroupPackage);
+  }
+  ZeroMem (Barrier, sizeof (*Barrier));
+  return RETURN_OUT_OF_RESOURCES;
+}
+
+/**
+  Reset the barrier, as if no AP had arrived or been released.
+
+  @param[in]  Barrier   The barrier.
+
+**/
+VOID
+SmmCpuBarrierReset (
+  IN SMM_CPU_BARRIER        *Barrier
+  )
+{
+  UINTN                     GroupIndex;
+  SMM_CPU_BARRIER_GROUP     *Group;
+
+  for (GroupIndex = 0; GroupIndex < Barrier->GroupCount; GroupIndex++) {
+    Group = &Barrier->Groups[GroupIndex];
+    *Group->Arrived = 0;
+    *Group->Leader  = SMM_CPU_BARRIER_NO_LEADER;
+    ZeroMem ((VOID *)Group->ReleaseMask, ALIGN_VALUE (Group->MemberCount, 64) / 8);
+  }
+}
+
+/**
+  Signal the BSP that an AP reached a synchronization point.
+
+  @param[in]  Barrier   The barrier.
+  @param[in]  CpuIndex  The index of the AP.
+
+**/
+VOID
+SmmCpuBarrierArrive (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  CpuIndex
+  )
+{
+  ASSERT (CpuIndex < Barrier->CpuCount);
+  InterlockedIncrement (Barrier->Groups[Barrier->CpuGroup[CpuIndex]].Arrived);
+}
+
+/**
+  Wait until a number of APs reached a synchronization point.
+
+  The arrivals are taken from the counters of the groups as they come, and
+  arrivals beyond NumberOfAPs are left for the next synchronization point,
+  like a semaphore would.
+
+  @param[in]  Barrier       The barrier.
+  @param[in]  NumberOfAPs   The number of arrivals to wait for.
+
+**/
+VOID
+SmmCpuBarrierWaitForArrivals (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  NumberOfAPs
+  )
+{
+  UINTN                     GroupIndex;
+  volatile UINT32           *Arrived;
+  UINT32                    Value;
+  UINT32                    Taken;
+
+  while (NumberOfAPs > 0) {
+    for (GroupIndex = 0;
+         GroupIndex < Barrier->GroupCount && NumberOfAPs > 0;
+         GroupIndex++) {
+      Arrived = Barrier->Groups[GroupIndex].Arrived;
+      Value   = *Arrived;
+      if (Value == 0) {
+        continue;
+      }
+      Taken = (UINT32)MIN (Value, NumberOfAPs);
+      if (InterlockedCompareExchange32 ((UINT32 *)Arrived, Value, Value - Taken) == Value) {
+        NumberOfAPs -= Taken;
+      }
+    }
+    if (NumberOfAPs > 0) {
+      CpuPause ();
+    }
+  }
+}
+
+/**
+  Release all the present APs.
+
+  The BSP releases one AP per group, which releases the other APs of its
+  group in SmmCpuBarrierWaitForRelease().
+
+  @param[in]  Barrier     The barrier.
+  @param[in]  ExcludedCpu The index of the calling CPU, not released.
+
+**/
+VOID
+SmmCpuBarrierReleaseAll (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  ExcludedCpu
+  )
+{
+  UINTN                     GroupIndex;
+  UINTN                     MemberIndex;
+  UINTN                     CpuIndex;
+  UINT32                    Leader;
+  SMM_CPU_BARRIER_GROUP     *Group;
+
+  for (GroupIndex = 0; GroupIndex < Barrier->GroupCount; GroupIndex++) {
+    Group  = &Barrier->Groups[GroupIndex];
+    Leader = SMM_CPU_BARRIER_NO_LEADER;
+
+    //
+    // The leader of the previous release is done with its group, as the
+    // BSP waits for all the APs before releasing them again.
+    //
+    ASSERT (*Group->Leader == SMM_CPU_BARRIER_NO_LEADER);
+
+    for (MemberIndex = 0; MemberIndex < Group->MemberCount; MemberIndex++) {
+      CpuIndex = Group->Members[MemberIndex];
+      if (CpuIndex == ExcludedCpu || !IsPresent (Barrier, CpuIndex)) {
+        continue;
+      }
+      if (Leader == SMM_CPU_BARRIER_NO_LEADER) {
+        Leader = (UINT32)CpuIndex;
+      } else {
+        Group->ReleaseMask[MemberIndex / 64] |= LShiftU64 (1, MemberIndex % 64);
+      }
+    }
+
+    if (Leader != SMM_CPU_BARRIER_NO_LEADER) {
+      //
+      // The release of the leader is an interlocked operation, so the leader
+      // sees the bitmap once released.
+      //
+      *Group->Leader = Leader;
+      ReleaseSemaphore (GetRun (Barrier, Leader));
+    }
+  }
+}
+
+/**
+  Wait until an AP is released, and release the other APs of its group if it
+  leads the release of its group.
+
+  The AP may also be released alone, by SmmStartupThisAp(), and then does
+  not lead its group.
+
+  @param[in]  Barrier   The barrier.
+  @param[in]  CpuIndex  The index of the AP.
+
+**/
+VOID
+SmmCpuBarrierWaitForRelease (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  CpuIndex
+  )
+{
+  SMM_CPU_BARRIER_GROUP     *Group;
+  UINTN                     WordIndex;
+  UINT64                    Mask;
+  UINTN                     MemberIndex;
+
+  ASSERT (CpuIndex < Barrier->CpuCount);
+
+  WaitForSemaphore (GetRun (Barrier, CpuIndex));
+
+  Group = &Barrier->Groups[Barrier->CpuGroup[CpuIndex]];
+  if (*Group->Leader != CpuIndex) {
+    return;
+  }
+
+  //
+  // The BSP cannot release the group again before this AP arrives at the
+  // next synchronization point, so the bitmap can be consumed without
+  // interlocked operations.
+  //
+  *Group->Leader = SMM_CPU_BARRIER_NO_LEADER;
+  for (WordIndex = 0; WordIndex * 64 < Group->MemberCount; WordIndex++) {
+    Mask = Group->ReleaseMask[WordIndex];
+    if (Mask == 0) {
+      continue;
+    }
+    Group->ReleaseMask[WordIndex] = 0;
+    while (Mask != 0) {
+      MemberIndex = WordIndex * 64 + (UINTN)LowBitSet64 (Mask);
+      Mask       &= Mask - 1;
+      ReleaseSemaphore (GetRun (Barrier, Group->Members[MemberIndex]));
+    }
+  }
+}
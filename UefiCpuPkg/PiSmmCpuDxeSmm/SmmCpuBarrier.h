@@ -0,0 +1,206 @@
+/** @file
+  Semaphores and hierarchical barrier of the SMI rendezvous.
+
+  The APs used to signal the BSP through a single semaphore, and the BSP
+  released every AP itself, so the cost of each synchronization point of an
+  SMI grew with the number of CPUs. The CPUs are now split in groups, one per
+  package:
+  - an AP signals its arrival on the counter of its group, so only the CPUs
+    of a package contend on a cache line, and the BSP polls one line per
+    package;
+  - the BSP releases one present AP per group, the leader, and hands it the
+    bitmap of the other present APs of the group, which the leader releases.
+
+  This file does not depend on the rest of the driver so that it can be unit
+  tested on the host.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _SMM_CPU_BARRIER_H_
+#define _SMM_CPU_BARRIER_H_
+
+#include <Base.h>
+#include <Uefi/UefiBaseType.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
+
+//
+// Value of SMM_CPU_BARRIER_GROUP.Leader when no release is handed to the
+// group.
+//
+#define SMM_CPU_BARRIER_NO_LEADER  MAX_UINT32
+
+typedef struct {
+  //
+  // Number of arrivals of the CPUs of the group not consumed by the BSP yet,
+  // alone in its semaphore-sized slot.
+  //
+  volatile UINT32           *Arrived;
+  //
+  // CPU releasing the other CPUs of the group, and the bitmap of these CPUs
+  // indexed like Members, in their own semaphore-sized slots.
+  //
+  volatile UINT32           *Leader;
+  volatile UINT64           *ReleaseMask;
+  UINT32                    *Members;
+  UINTN                     MemberCount;
+} SMM_CPU_BARRIER_GROUP;
+
+typedef struct {
+  UINTN                     CpuCount;
+  UINTN                     GroupCount;
+  SMM_CPU_BARRIER_GROUP     *Groups;
+  //
+  // Group of every CPU, and the CPUs of every group one after the other.
+  //
+  UINT32                    *CpuGroup;
+  UINT32                    *Members;
+  //
+  // The Run semaphore and the Present flag of every CPU, SemaphoreSize bytes
+  // apart.
+  //
+  UINTN                     Run;
+  UINTN                     Present;
+  UINTN                     SemaphoreSize;
+} SMM_CPU_BARRIER;
+
+/**
+  Performs an atomic compare exchange operation to get semaphore.
+  The compare exchange operation must be performed using
+  MP safe mechanisms.
+
+  @param      Sem        IN:  32-bit unsigned integer
+                         OUT: original integer - 1
+  @return     Original integer - 1
+
+**/
+UINT32
+WaitForSemaphore (
+  IN OUT  volatile UINT32           *Sem
+  );
+
+/**
+  Performs an atomic compare exchange operation to release semaphore.
+  The compare exchange operation must be performed using
+  MP safe mechanisms.
+
+  @param      Sem        IN:  32-bit unsigned integer
+                         OUT: original integer + 1
+  @return     Original integer + 1
+
+**/
+UINT32
+ReleaseSemaphore (
+  IN OUT  volatile UINT32           *Sem
+  );
+
+/**
+  Performs an atomic compare exchange operation to lock semaphore.
+  The compare exchange operation must be performed using
+  MP safe mechanisms.
+
+  @param      Sem        IN:  32-bit unsigned integer
+                         OUT: -1
+  @return     Original integer
+
+**/
+UINT32
+LockdownSemaphore (
+  IN OUT  volatile UINT32           *Sem
+  );
+
+/**
+  Initialize the barrier of the SMI rendezvous.
+
+  @param[out] Barrier         The barrier.
+  @param[in]  CpuCount        The number of CPUs.
+  @param[in]  Package         The package of every CPU.
+  @param[in]  Run             The Run semaphore of the first CPU.
+  @param[in]  Present         The Present flag of the first CPU.
+  @param[in]  SemaphoreSize   The distance between the semaphores of two CPUs,
+                              the size of a cache line or more.
+
+  @retval RETURN_SUCCESS            The barrier is initialized.
+  @retval RETURN_OUT_OF_RESOURCES   The barrier could not be allocated.
+
+**/
+RETURN_STATUS
+SmmCpuBarrierInitialize (
+  OUT SMM_CPU_BARRIER       *Barrier,
+  IN  UINTN                 CpuCount,
+  IN  CONST UINT32          *Package,
+  IN  volatile UINT32       *Run,
+  IN  volatile BOOLEAN      *Present,
+  IN  UINTN                 SemaphoreSize
+  );
+
+/**
+  Reset the barrier, as if no AP had arrived or been released.
+
+  @param[in]  Barrier   The barrier.
+
+**/
+VOID
+SmmCpuBarrierReset (
+  IN SMM_CPU_BARRIER        *Barrier
+  );
+
+/**
+  Signal the BSP that an AP reached a synchronization point.
+
+  @param[in]  Barrier   The barrier.
+  @param[in]  CpuIndex  The index of the AP.
+
+**/
+VOID
+SmmCpuBarrierArrive (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  CpuIndex
+  );
+
+/**
+  Wait until a number of APs reached a synchronization point.
+
+  @param[in]  Barrier       The barrier.
+  @param[in]  NumberOfAPs   The number of arrivals to wait for.
+
+**/
+VOID
+SmmCpuBarrierWaitForArrivals (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  NumberOfAPs
+  );
+
+/**
+  Release all the present APs.
+
+  @param[in]  Barrier     The barrier.
+  @param[in]  ExcludedCpu The index of the calling CPU, not released.
+
+**/
+VOID
+SmmCpuBarrierReleaseAll (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  ExcludedCpu
+  );
+
+/**
+  Wait until an AP is released, and release the other APs of its group if it
+  leads the release of its group.
+
+  @param[in]  Barrier   The barrier.
+  @param[in]  CpuIndex  The index of the AP.
+
+**/
+VOID
+SmmCpuBarrierWaitForRelease (
+  IN SMM_CPU_BARRIER        *Barrier,
+  IN UINTN                  CpuIndex
+  );
+
+#endif
@@ -908,6 +908,7 @@ InitSmmProfileInternal (
   mSmmProfileBase->TsegSize       = mCpuHotPlugData.SmrrSize;
   mSmmProfileBase->NumSmis        = 0;
   mSmmProfileBase->NumCpus        = gSmmCpuPrivate->SmmCoreEntryContext.NumberOfCpus;
+  mSmmProfileBase->TicksPerSecond = GetPerformanceCounterProperties (NULL, NULL);
 
   if (mBtsSupported) {
     mMsrDsArea = (MSR_DS_AREA_STRUCT **)AllocateZeroPool (sizeof (MSR_DS_AREA_STRUCT *) * mMaxNumberOfCpus);
@@ -1122,6 +1123,27 @@ SmmProfileRecordSmiNum (
   }
 }
 
+/**
+  Record the SMI latency on the BSP.
+
+  @param  RendezvousTicks  The ticks from the SMI entry to the arrival of the APs.
+  @param  SmiTicks         The ticks from the SMI entry to the SMI exit.
+
+**/
+VOID
+SmmProfileRecordSmiLatency (
+  IN UINT64  RendezvousTicks,
+  IN UINT64  SmiTicks
+  )
+{
+  if (mSmmProfileStart) {
+    mSmmProfileBase->RendezvousTicks    = RendezvousTicks;
+    mSmmProfileBase->MaxRendezvousTicks = MAX (mSmmProfileBase->MaxRendezvousTicks, RendezvousTicks);
+    mSmmProfileBase->SmiTicks           = SmiTicks;
+    mSmmProfileBase->MaxSmiTicks        = MAX (mSmmProfileBase->MaxSmiTicks, SmiTicks);
+  }
+}
+
 /**
   Initialize processor environment for SMM profile.
 
@@ -46,6 +46,19 @@ SmmProfileRecordSmiNum (
   VOID
   );
 
+/**
+  Record the SMI latency on the BSP.
+
+  @param  RendezvousTicks  The ticks from the SMI entry to the arrival of the APs.
+  @param  SmiTicks         The ticks from the SMI entry to the SMI exit.
+
+**/
+VOID
+SmmProfileRecordSmiLatency (
+  IN UINT64  RendezvousTicks,
+  IN UINT64  SmiTicks
+  );
+
 /**
   The Page fault handler to save SMM profile data.
 
@@ -85,6 +85,17 @@ typedef struct {
   UINT64  TsegSize;
   UINT64  NumSmis;
   UINT64  NumCpus;
+  //
+  // SMI latency on the BSP, in performance counter ticks: from the SMI entry
+  // to the arrival of the APs, and from the SMI entry to the release of the
+  // APs for the SMI exit. The values are those of the last SMI and the
+  // maximum since the SMM profile started.
+  //
+  UINT64  TicksPerSecond;
+  UINT64  RendezvousTicks;
+  UINT64  MaxRendezvousTicks;
+  UINT64  SmiTicks;
+  UINT64  MaxSmiTicks;
 } SMM_PROFILE_HEADER;
 
 typedef struct {
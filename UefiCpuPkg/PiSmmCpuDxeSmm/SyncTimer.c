@@ -60,14 +60,16 @@ StartSyncTimer (
 
 
 /**
-  Check if the SMM AP Sync timer is timeout.
+  Get the number of ticks elapsed since a SMM AP Sync timer started.
 
   @param Timer  The start timer from the begin.
 
+  @return The number of ticks elapsed.
+
 **/
-BOOLEAN
+UINT64
 EFIAPI
-IsSyncTimerTimeout (
+GetSyncTimerElapsed (
   IN      UINT64                    Timer
   )
 {
@@ -106,5 +108,20 @@ IsSyncTimerTimeout (
     }
   }
 
-  return (BOOLEAN) (Delta >= mTimeoutTicker);
+  return Delta;
+}
+
+/**
+  Check if the SMM AP Sync timer is timeout.
+
+  @param Timer  The start timer from the begin.
+
+**/
+BOOLEAN
+EFIAPI
+IsSyncTimerTimeout (
+  IN      UINT64                    Timer
+  )
+{
+  return (BOOLEAN) (GetSyncTimerElapsed (Timer) >= mTimeoutTicker);
 }
@@ -0,0 +1,585 @@
+/** @file
+  Host based unit tests of the barrier of the SMI rendezvous. The CPUs are
+  emulated by POSIX threads going through the synchronization points of an
+  SMI the way BSPHandler() and APHandler() do.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "SmmCpuBarrierUnitTest.h"
+
+#define SEMAPHORE_SIZE            64
+#define ROUND_COUNT               20
+
+//
+// CPU topology: the number of CPUs, and the number of CPUs per package, 0
+// for packages of various sizes whose CPUs are interleaved.
+//
+typedef struct {
+  UINTN                     CpuCount;
+  UINTN                     CpusPerPackage;
+} TOPOLOGY;
+
+typedef struct {
+  SMM_CPU_BARRIER           Barrier;
+  UINTN                     CpuCount;
+  UINTN                     BspIndex;
+  UINT32                    *Package;
+  UINT8                     *Run;
+  UINT8                     *Present;
+  //
+  // CPUs entering SMM, the BSP included.
+  //
+  BOOLEAN                   *Entering;
+  volatile BOOLEAN          InsideSmm;
+  //
+  // Number of procedures every AP ran.
+  //
+  volatile UINT32           *Phase;
+} RENDEZVOUS;
+
+typedef struct {
+  RENDEZVOUS                *Rendezvous;
+  UINTN                     CpuIndex;
+  pthread_t                 Thread;
+} AP_CONTEXT;
+
+STATIC TOPOLOGY mTopologies[] = {
+  {  1,  1 },
+  {  2,  1 },
+  {  4,  2 },
+  {  8,  8 },
+  { 16,  1 },
+  { 16,  4 },
+  { 24,  0 },
+  { 64, 16 },
+};
+
+/**
+  Get the package of a CPU in a topology.
+
+  @param[in]  Topology  The topology.
+  @param[in]  CpuIndex  The index of the CPU.
+
+  @return The package of the CPU.
+**/
+STATIC
+UINT32
+GetPackage (
+  IN TOPOLOGY               *Topology,
+  IN UINTN                  CpuIndex
+  )
+{
+  if (Topology->CpusPerPackage == 0) {
+    return (UINT32) ((CpuIndex * CpuIndex) % 5) + 100;
+  }
+  return (UINT32) (CpuIndex / Topology->CpusPerPackage);
+}
+
+/**
+  Get the Run semaphore of a CPU.
+
+  @param[in]  Rendezvous  The rendezvous.
+  @param[in]  CpuIndex    The index of the CPU.
+
+  @return The Run semaphore of the CPU.
+**/
+STATIC
+volatile UINT32 *
+GetRun (
+  IN RENDEZVOUS             *Rendezvous,
+  IN UINTN                  CpuIndex
+  )
+{
+  return (volatile UINT32 *) (Rendezvous->Run + SEMAPHORE_SIZE * CpuIndex);
+}
+
+/**
+  Get the Present flag of a CPU.
+
+  @param[in]  Rendezvous  The rendezvous.
+  @param[in]  CpuIndex    The index of the CPU.
+
+  @return The Present flag of the CPU.
+**/
+STATIC
+volatile BOOLEAN *
+GetPresent (
+  IN RENDEZVOUS             *Rendezvous,
+  IN UINTN                  CpuIndex
+  )
+{
+  return (volatile BOOLEAN *) (Rendezvous->Present + SEMAPHORE_SIZE * CpuIndex);
+}
+
+/**
+  Create the rendezvous of a topology.
+
+  @param[out] Rendezvous  The rendezvous.
+  @param[in]  Topology    The topology.
+
+  @retval RETURN_SUCCESS            The rendezvous is created.
+  @retval RETURN_OUT_OF_RESOURCES   The rendezvous could not be allocated.
+**/
+STATIC
+RETURN_STATUS
+CreateRendezvous (
+  OUT RENDEZVOUS            *Rendezvous,
+  IN  TOPOLOGY              *Topology
+  )
+{
+  UINTN                     CpuIndex;
+
+  ZeroMem (Rendezvous, sizeof (*Rendezvous));
+  Rendezvous->CpuCount = Topology->CpuCount;
+  Rendezvous->BspIndex = Topology->CpuCount / 2;
+  Rendezvous->Package  = AllocatePool (sizeof (UINT32) * Topology->CpuCount);
+  Rendezvous->Run      = AllocateZeroPool (SEMAPHORE_SIZE * Topology->CpuCount);
+  Rendezvous->Present  = AllocateZeroPool (SEMAPHORE_SIZE * Topology->CpuCount);
+  Rendezvous->Entering = AllocateZeroPool (sizeof (BOOLEAN) * Topology->CpuCount);
+  Rendezvous->Phase    = AllocateZeroPool (sizeof (UINT32) * Topology->CpuCount);
+  if (Rendezvous->Package == NULL || Rendezvous->Run == NULL || Rendezvous->Present == NULL ||
+      Rendezvous->Entering == NULL || Rendezvous->Phase == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  for (CpuIndex = 0; CpuIndex < Topology->CpuCount; CpuIndex++) {
+    Rendezvous->Package[CpuIndex]  = GetPackage (Topology, CpuIndex);
+    Rendezvous->Entering[CpuIndex] = TRUE;
+  }
+
+  return SmmCpuBarrierInitialize (
+           &Rendezvous->Barrier,
+           Rendezvous->CpuCount,
+           Rendezvous->Package,
+           (volatile UINT32 *) Rendezvous->Run,
+           (volatile BOOLEAN *) Rendezvous->Present,
+           SEMAPHORE_SIZE
+           );
+}
+
+/**
+  Free the buffers of a rendezvous.
+
+  @param[in]  Rendezvous  The rendezvous.
+**/
+STATIC
+VOID
+FreeRendezvous (
+  IN RENDEZVOUS             *Rendezvous
+  )
+{
+  FreePool (Rendezvous->Package);
+  FreePool (Rendezvous->Run);
+  FreePool (Rendezvous->Present);
+  FreePool (Rendezvous->Entering);
+  FreePool ((VOID *) Rendezvous->Phase);
+}
+
+/**
+  The SMI handler of an AP, as in APHandler() in traditional sync mode.
+
+  @param[in]  Argument  The AP_CONTEXT of the AP.
+
+  @return NULL.
+**/
+STATIC
+VOID *
+ApThread (
+  IN VOID                   *Argument
+  )
+{
+  AP_CONTEXT                *Ap;
+  RENDEZVOUS                *Rendezvous;
+
+  Ap         = (AP_CONTEXT *) Argument;
+  Rendezvous = Ap->Rendezvous;
+
+  *GetPresent (Rendezvous, Ap->CpuIndex) = TRUE;
+  SmmCpuBarrierArrive (&Rendezvous->Barrier, Ap->CpuIndex);
+
+  while (TRUE) {
+    SmmCpuBarrierWaitForRelease (&Rendezvous->Barrier, Ap->CpuIndex);
+    if (!Rendezvous->InsideSmm) {
+      break;
+    }
+    Rendezvous->Phase[Ap->CpuIndex]++;
+    SmmCpuBarrierArrive (&Rendezvous->Barrier, Ap->CpuIndex);
+  }
+
+  SmmCpuBarrierArrive (&Rendezvous->Barrier, Ap->CpuIndex);
+  SmmCpuBarrierWaitForRelease (&Rendezvous->Barrier, Ap->CpuIndex);
+  *GetPresent (Rendezvous, Ap->CpuIndex) = FALSE;
+  SmmCpuBarrierArrive (&Rendezvous->Barrier, Ap->CpuIndex);
+  return NULL;
+}
+
+/**
+  Check that the barrier is back to its initial state.
+
+  @param[in]  Rendezvous  The rendezvous.
+
+  @retval TRUE    The barrier is in its initial state.
+  @retval FALSE   Some semaphore or release is pending.
+**/
+STATIC
+BOOLEAN
+IsBarrierIdle (
+  IN RENDEZVOUS             *Rendezvous
+  )
+{
+  SMM_CPU_BARRIER_GROUP     *Group;
+  UINTN                     Index;
+  UINTN                     WordIndex;
+
+  for (Index = 0; Index < Rendezvous->CpuCount; Index++) {
+    if (*GetRun (Rendezvous, Index) != 0 || *GetPresent (Rendezvous, Index)) {
+      return FALSE;
+    }
+  }
+  for (Index = 0; Index < Rendezvous->Barrier.GroupCount; Index++) {
+    Group = &Rendezvous->Barrier.Groups[Index];
+    if (*Group->Arrived != 0 || *Group->Leader != SMM_CPU_BARRIER_NO_LEADER) {
+      return FALSE;
+    }
+    for (WordIndex = 0; WordIndex * 64 < Group->MemberCount; WordIndex++) {
+      if (Group->ReleaseMask[WordIndex] != 0) {
+        return FALSE;
+      }
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Run the SMIs of a test on the BSP, as BSPHandler() does in traditional sync
+  mode, with the APs marked entering.
+
+  In every round the BSP releases all the APs and waits for them to run their
+  procedure. Then it releases a single AP, as SmmStartupThisAp() does.
+
+  @param[in]  Rendezvous  The rendezvous.
+
+  @retval  UNIT_TEST_PASSED             The SMIs ran as expected.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+RunSmis (
+  IN RENDEZVOUS             *Rendezvous
+  )
+{
+  AP_CONTEXT                *Aps;
+  UINTN                     ApCount;
+  UINTN                     Index;
+  UINTN                     Round;
+  UINTN                     TargetedAp;
+  UINT32                    Expected;
+
+  Aps = AllocateZeroPool (sizeof (AP_CONTEXT) * Rendezvous->CpuCount);
+  UT_ASSERT_NOT_NULL (Aps);
+
+  *GetPresent (Rendezvous, Rendezvous->BspIndex) = TRUE;
+  Rendezvous->InsideSmm = TRUE;
+
+  ApCount    = 0;
+  TargetedAp = Rendezvous->CpuCount;
+  for (Index = 0; Index < Rendezvous->CpuCount; Index++) {
+    if (Index == Rendezvous->BspIndex || !Rendezvous->Entering[Index]) {
+      continue;
+    }
+    Aps[Index].Rendezvous = Rendezvous;
+    Aps[Index].CpuIndex   = Index;
+    UT_ASSERT_EQUAL (pthread_create (&Aps[Index].Thread, NULL, ApThread, &Aps[Index]), 0);
+    ApCount++;
+    if (TargetedAp == Rendezvous->CpuCount) {
+      TargetedAp = Index;
+    }
+  }
+
+  SmmCpuBarrierWaitForArrivals (&Rendezvous->Barrier, ApCount);
+
+  for (Round = 1; Round <= ROUND_COUNT; Round++) {
+    SmmCpuBarrierReleaseAll (&Rendezvous->Barrier, Rendezvous->BspIndex);
+    SmmCpuBarrierWaitForArrivals (&Rendezvous->Barrier, ApCount);
+    for (Index = 0; Index < Rendezvous->CpuCount; Index++) {
+      Expected = (Index == Rendezvous->BspIndex || !Rendezvous->Entering[Index]) ? 0 : (UINT32) Round;
+      UT_ASSERT_EQUAL (Rendezvous->Phase[Index], Expected);
+    }
+  }
+
+  //
+  // Release only the first AP, which leads its group when all the APs are
+  // released: the other APs of its group must not run.
+  //
+  if (ApCount > 0) {
+    ReleaseSemaphore (GetRun (Rendezvous, TargetedAp));
+    SmmCpuBarrierWaitForArrivals (&Rendezvous->Barrier, 1);
+    for (Index = 0; Index < Rendezvous->CpuCount; Index++) {
+      if (Index != Rendezvous->BspIndex && Rendezvous->Entering[Index]) {
+        UT_ASSERT_EQUAL (Rendezvous->Phase[Index], (Index == TargetedAp) ? ROUND_COUNT + 1 : ROUND_COUNT);
+      }
+    }
+  }
+
+  //
+  // Exit SMM.
+  //
+  Rendezvous->InsideSmm = FALSE;
+  SmmCpuBarrierReleaseAll (&Rendezvous->Barrier, Rendezvous->BspIndex);
+  SmmCpuBarrierWaitForArrivals (&Rendezvous->Barrier, ApCount);
+  SmmCpuBarrierReleaseAll (&Rendezvous->Barrier, Rendezvous->BspIndex);
+  *GetPresent (Rendezvous, Rendezvous->BspIndex) = FALSE;
+  SmmCpuBarrierWaitForArrivals (&Rendezvous->Barrier, ApCount);
+
+  for (Index = 0; Index < Rendezvous->CpuCount; Index++) {
+    if (Aps[Index].Rendezvous != NULL) {
+      pthread_join (Aps[Index].Thread, NULL);
+    }
+  }
+  FreePool (Aps);
+
+  UT_ASSERT_TRUE (IsBarrierIdle (Rendezvous));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Unit test of SmmCpuBarrierInitialize(): the CPUs are grouped per package.
+
+  @param[in]  Context    The topology.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestGroups (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TOPOLOGY                  *Topology;
+  RENDEZVOUS                Rendezvous;
+  SMM_CPU_BARRIER_GROUP     *Group;
+  UINTN                     GroupIndex;
+  UINTN                     MemberIndex;
+  UINTN                     CpuIndex;
+  UINTN                     MemberCount;
+
+  Topology = (TOPOLOGY *) Context;
+  UT_ASSERT_NOT_EFI_ERROR (CreateRendezvous (&Rendezvous, Topology));
+
+  MemberCount = 0;
+  for (GroupIndex = 0; GroupIndex < Rendezvous.Barrier.GroupCount; GroupIndex++) {
+    Group = &Rendezvous.Barrier.Groups[GroupIndex];
+    UT_ASSERT_TRUE (Group->MemberCount > 0);
+    for (MemberIndex = 0; MemberIndex < Group->MemberCount; MemberIndex++) {
+      CpuIndex = Group->Members[MemberIndex];
+      UT_ASSERT_EQUAL (Rendezvous.Barrier.CpuGroup[CpuIndex], GroupIndex);
+      UT_ASSERT_EQUAL (Rendezvous.Package[CpuIndex], Rendezvous.Package[Group->Members[0]]);
+    }
+    if (GroupIndex > 0) {
+      UT_ASSERT_NOT_EQUAL (Rendezvous.Package[Group->Members[0]], Rendezvous.Package[Rendezvous.Barrier.Groups[0].Members[0]]);
+    }
+    //
+    // The lines of a group must not be shared with another group.
+    //
+    UT_ASSERT_EQUAL ((UINTN) Group->Arrived % SEMAPHORE_SIZE, 0);
+    UT_ASSERT_EQUAL ((UINTN) Group->Leader - (UINTN) Group->Arrived, SEMAPHORE_SIZE);
+    UT_ASSERT_EQUAL ((UINTN) Group->ReleaseMask - (UINTN) Group->Leader, SEMAPHORE_SIZE);
+    MemberCount += Group->MemberCount;
+  }
+  UT_ASSERT_EQUAL (MemberCount, Topology->CpuCount);
+
+  if (Topology->CpusPerPackage != 0) {
+    UT_ASSERT_EQUAL (Rendezvous.Barrier.GroupCount, (Topology->CpuCount + Topology->CpusPerPackage - 1) / Topology->CpusPerPackage);
+  }
+
+  UT_ASSERT_TRUE (IsBarrierIdle (&Rendezvous));
+  FreeRendezvous (&Rendezvous);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Unit test of the rendezvous of all the CPUs through the barrier.
+
+  @param[in]  Context    The topology.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestRendezvous (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  RENDEZVOUS                Rendezvous;
+  UNIT_TEST_STATUS          Status;
+
+  UT_ASSERT_NOT_EFI_ERROR (CreateRendezvous (&Rendezvous, (TOPOLOGY *) Context));
+  Status = RunSmis (&Rendezvous);
+  FreeRendezvous (&Rendezvous);
+  return Status;
+}
+
+/**
+  Unit test of the rendezvous when some APs do not enter SMM: they must never
+  be released, and the leaders are taken among the present APs.
+
+  @param[in]  Context    The topology.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestPartialRendezvous (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  RENDEZVOUS                Rendezvous;
+  UNIT_TEST_STATUS          Status;
+  UINTN                     Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (CreateRendezvous (&Rendezvous, (TOPOLOGY *) Context));
+  for (Index = 0; Index < Rendezvous.CpuCount; Index += 3) {
+    Rendezvous.Entering[Index] = FALSE;
+  }
+
+  Status = RunSmis (&Rendezvous);
+  FreeRendezvous (&Rendezvous);
+  return Status;
+}
+
+/**
+  Unit test of the semaphores, and of the arrivals beyond the number waited
+  for, left for the next synchronization point.
+
+  @param[in]  Context    The topology.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestSemaphores (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  RENDEZVOUS                Rendezvous;
+  volatile UINT32           Semaphore;
+  UINTN                     Index;
+
+  Semaphore = 0;
+  UT_ASSERT_EQUAL (ReleaseSemaphore (&Semaphore), 1);
+  UT_ASSERT_EQUAL (ReleaseSemaphore (&Semaphore), 2);
+  UT_ASSERT_EQUAL (WaitForSemaphore (&Semaphore), 1);
+  UT_ASSERT_EQUAL (LockdownSemaphore (&Semaphore), 1);
+  UT_ASSERT_EQUAL (ReleaseSemaphore (&Semaphore), 0);
+  UT_ASSERT_EQUAL (Semaphore, MAX_UINT32);
+
+  UT_ASSERT_NOT_EFI_ERROR (CreateRendezvous (&Rendezvous, (TOPOLOGY *) Context));
+  for (Index = 0; Index < Rendezvous.CpuCount; Index++) {
+    SmmCpuBarrierArrive (&Rendezvous.Barrier, Index);
+  }
+  SmmCpuBarrierWaitForArrivals (&Rendezvous.Barrier, Rendezvous.CpuCount - 1);
+  UT_ASSERT_FALSE (IsBarrierIdle (&Rendezvous));
+  SmmCpuBarrierWaitForArrivals (&Rendezvous.Barrier, 1);
+  UT_ASSERT_TRUE (IsBarrierIdle (&Rendezvous));
+
+  for (Index = 0; Index < Rendezvous.CpuCount; Index++) {
+    SmmCpuBarrierArrive (&Rendezvous.Barrier, Index);
+  }
+  SmmCpuBarrierReset (&Rendezvous.Barrier);
+  UT_ASSERT_TRUE (IsBarrierIdle (&Rendezvous));
+
+  FreeRendezvous (&Rendezvous);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the barrier of
+  the SMI rendezvous and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      BarrierTests;
+  UINTN                       Index;
+  TOPOLOGY                    *Topology;
+
+  Framework = NULL;
+
+  //
+  // Setup the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&BarrierTests, Framework, "SmmCpuBarrier Tests", "PiSmmCpuDxeSmm.SmmCpuBarrier", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SmmCpuBarrier Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mTopologies); Index++) {
+    Topology = &mTopologies[Index];
+    AddTestCase (BarrierTests, "Test CPU groups",                 "Groups",            UnitTestGroups,            NULL, NULL, Topology);
+    AddTestCase (BarrierTests, "Test semaphores and arrivals",    "Semaphores",        UnitTestSemaphores,        NULL, NULL, Topology);
+    AddTestCase (BarrierTests, "Test rendezvous of all CPUs",     "Rendezvous",        UnitTestRendezvous,        NULL, NULL, Topology);
+    AddTestCase (BarrierTests, "Test rendezvous of present CPUs", "PartialRendezvous", UnitTestPartialRendezvous, NULL, NULL, Topology);
+  }
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param Argc  Number of arguments.
+  @param Argv  Array of arguments.
+
+  @return Test application exit code.
+**/
+INT32
+main (
+  INT32 Argc,
+  CHAR8 *Argv[]
+  )
+{
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+  return UnitTestingEntry ();
+}
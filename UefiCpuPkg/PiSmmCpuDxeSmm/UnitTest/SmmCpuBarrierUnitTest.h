@@ -0,0 +1,26 @@
+/** @file
+  Host based unit tests of the barrier of the SMI rendezvous.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _SMM_CPU_BARRIER_UNIT_TEST_H_
+#define _SMM_CPU_BARRIER_UNIT_TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+
+#include "../SmmCpuBarrier.h"
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "SmmCpuBarrier Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#endif